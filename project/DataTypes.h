@@ -14,7 +14,8 @@ struct VertexData {
 struct Material {
 	Vector4 color;
 	int32_t enableLighting;
-	float padding[3];
+	float alphaReference; // アルファテストの閾値 (Object3dFeature::kAlphaTest のときだけ使う)
+	float padding[2];
 	Matrix4x4 uvTransform;
 };
 
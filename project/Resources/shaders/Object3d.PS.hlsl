@@ -18,34 +18,34 @@ struct PixelShaderOutput
 PixelShaderOutput main(VertexShaderOutput input)
 {
     PixelShaderOutput output;
-    output.color = gMaterial.color;
-
-    //͕svXR[vœ錾ƃG[ɂȂ邩ˁ[06_01
-    //float32_t4 textureColor = gTexture.Sample(gSampler, input.texcoord);
 
+    // @\Ƃ̃oG[V̓}NŐ؂ւ (ShaderPermutation.h  Object3dFeature)
+#if TEXTURE_TRANSFORM
     // UVW𓯎WnɊgāix, y, 1.0jAAtBϊKp
     float4 transformedUV = mul(float32_t4(input.texcoord, 0.0f, 1.0f), gMaterial.uvTransform);
     // ϊUVWgăeNX`FTvO
     float32_t4 textureColor = gTexture.Sample(gSampler, transformedUV.xy);
-        
-    
-    if (gMaterial.enableLighting != 0)//Lightingꍇ
-    {
-        //float cos = saturate(dot(normalize(input.normal), -gDirectionalLight.direction));
-        //output.color = gMaterial.color * textureColor * gDirectionalLight.color * cos * gDirectionalLight.intensity;
-        //half lambert
-        float NdotL = dot(normalize(input.normal), -gDirectionalLight.direction);
-        float cos = pow(NdotL * 0.5f + 0.5f, 2.0f);
-        
-        output.color = cos * gMaterial.color * textureColor;
-            
-        
-    }
-    else
-    { //LightingȂꍇO܂łƓvZ
-        output.color = gMaterial.color * textureColor;
-    }
-    
-    
+#else
+    float32_t4 textureColor = gTexture.Sample(gSampler, input.texcoord);
+#endif
+
+#if ENABLE_LIGHTING
+#if HALF_LAMBERT
+    //half lambert
+    float NdotL = dot(normalize(input.normal), -gDirectionalLight.direction);
+    float cos = pow(NdotL * 0.5f + 0.5f, 2.0f);
+    output.color = cos * gMaterial.color * textureColor;
+#else
+    float cos = saturate(dot(normalize(input.normal), -gDirectionalLight.direction));
+    output.color = gMaterial.color * textureColor * gDirectionalLight.color * cos * gDirectionalLight.intensity;
+#endif
+#else
+    output.color = gMaterial.color * textureColor;
+#endif
+
+#if ALPHA_TEST
+    clip(output.color.a - gMaterial.alphaReference);
+#endif
+
     return output;
 }
\ No newline at end of file
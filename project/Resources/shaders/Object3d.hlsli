@@ -11,6 +11,7 @@ struct Material
 {
     float32_t4 color;
     int32_t enableLighting;
+    float32_t alphaReference;
     float32_t4x4 uvTransform;
     
 };
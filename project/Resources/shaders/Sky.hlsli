@@ -0,0 +1,12 @@
+#pragma pack_matrix(row_major)
+
+cbuffer SkyTransform : register(b0) {
+	matrix viewProjection; // 平行移動を除いたビュー変換行列 x プロジェクション変換行列
+	float farDepth;        // 最も奥の深度 (逆Zなら0)
+};
+
+// 頂点シェーダーからピクセルシェーダーへのやり取りに使用する構造体
+struct VSOutput {
+	float4 svpos : SV_POSITION; // システム用頂点座標
+	float2 uv : TEXCOORD;       // uv値
+};
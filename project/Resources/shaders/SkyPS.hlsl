@@ -0,0 +1,9 @@
+#include "Sky.hlsli"
+
+Texture2D<float4> tex : register(t0); // 0番スロットに設定されたテクスチャ
+SamplerState smp : register(s0);      // 0番スロットに設定されたサンプラー
+
+float4 main(VSOutput input) : SV_TARGET {
+	// ライティングはせず、テクスチャの色をそのまま出す
+	return float4(tex.Sample(smp, input.uv).rgb, 1.0f);
+}
\ No newline at end of file
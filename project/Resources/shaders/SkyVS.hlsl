@@ -0,0 +1,11 @@
+#include "Sky.hlsli"
+
+VSOutput main(float4 pos : POSITION, float2 uv : TEXCOORD) {
+	VSOutput output; // ピクセルシェーダーに渡す値
+	// カメラの位置を中心に回転だけをかけ、深度は常に最も奥にする (z = farDepth * w)
+	float4 svpos = mul(float4(pos.xyz, 1.0f), viewProjection);
+	output.svpos = float4(svpos.xy, farDepth * svpos.w, svpos.w);
+	output.uv = uv;
+
+	return output;
+}
\ No newline at end of file
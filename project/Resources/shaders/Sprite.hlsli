@@ -1,7 +1,7 @@
 #pragma pack_matrix(row_major)
 
 cbuffer cbuff0 : register(b0) {
-	float4 color; // 色(RGBA)
+	float4 color; // 色(RGBA) (全てのスプライトにかける)
 	matrix mat;   // ３Ｄ変換行列
 };
 
@@ -9,4 +9,5 @@ cbuffer cbuff0 : register(b0) {
 struct VSOutput {
 	float4 svpos : SV_POSITION; // システム用頂点座標
 	float2 uv : TEXCOORD;       // uv値
+	float4 color : COLOR;       // 頂点カラー (スプライトごとの色)
 };
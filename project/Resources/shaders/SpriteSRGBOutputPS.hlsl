@@ -9,7 +9,7 @@ float3 ApplySRGBGamma(float3 linearColor)
 }
 
 float4 main(VSOutput input) : SV_TARGET {
-    float4 output = tex.Sample(smp, input.uv) * color;
+    float4 output = tex.Sample(smp, input.uv) * input.color;
     output.rgb = ApplySRGBGamma(output.rgb);
     return output;
 }
\ No newline at end of file
@@ -1,8 +1,9 @@
 #include "Sprite.hlsli"
 
-VSOutput main(float4 pos : POSITION, float2 uv : TEXCOORD) {
+VSOutput main(float4 pos : POSITION, float2 uv : TEXCOORD, float4 vertexColor : COLOR) {
 	VSOutput output; // ピクセルシェーダーに渡す値
 	output.svpos = mul(pos, mat);
 	output.uv = uv;
+	output.color = vertexColor * color;
 	return output;
 }
\ No newline at end of file
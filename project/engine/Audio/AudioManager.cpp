@@ -0,0 +1,86 @@
+#include "AudioManager.h"
+#include <cassert>
+
+AudioManager* AudioManager::GetInstance() {
+    static AudioManager instance;
+    return &instance;
+}
+
+void AudioManager::Initialize(std::unique_ptr<AudioOutput> output, uint32_t sampleRate, uint32_t maxVoices, uint32_t blockFrames) {
+    VoicePool::Settings settings;
+    settings.sampleRate = sampleRate;
+    settings.maxVoices = maxVoices;
+    voicePool_.Initialize(settings);
+    output_ = std::move(output);
+    auto render = [this](float* samples, uint32_t frameCount) { voicePool_.Render(samples, frameCount); };
+    if (output_ == nullptr || !output_->Start(sampleRate, blockFrames, render)) {
+        // サウンドデバイスが無くても、鳴らす側のコードはそのまま動くようにする
+        output_ = std::make_unique<NullAudioOutput>();
+        output_->Start(sampleRate, blockFrames, render);
+    }
+}
+
+void AudioManager::Finalize() {
+    if (output_ != nullptr) {
+        output_->Stop();
+        output_.reset();
+    }
+    voicePool_.Finalize();
+    waves_.clear();
+    clips_.clear();
+}
+
+void AudioManager::Update() {
+    voicePool_.Update();
+}
+
+const WaveFile* AudioManager::Load(std::string_view filePath) {
+    std::string key(filePath);
+    auto it = waves_.find(key);
+    if (it != waves_.end()) {
+        return it->second.get();
+    }
+    std::unique_ptr<WaveFile> wave = std::make_unique<WaveFile>();
+    std::string error;
+    if (!wave->Open(key, &error)) {
+        assert(false);
+        return nullptr;
+    }
+    const WaveFile* result = wave.get();
+    waves_.emplace(std::move(key), std::move(wave));
+    return result;
+}
+
+SoundClip* AudioManager::LoadClip(std::string_view filePath) {
+    std::string key(filePath);
+    auto it = clips_.find(key);
+    if (it != clips_.end()) {
+        return it->second.get();
+    }
+    // 展開した後はファイルを使わないので、waves_ には残さない
+    WaveFile wave;
+    std::string error;
+    if (!wave.Open(key, &error)) {
+        assert(false);
+        return nullptr;
+    }
+    std::unique_ptr<SoundClip> clip = std::make_unique<SoundClip>();
+    clip->Load(wave);
+    SoundClip* result = clip.get();
+    clips_.emplace(std::move(key), std::move(clip));
+    return result;
+}
+
+AudioMixer::VoiceId AudioManager::Play(const WaveFile* wave, const AudioPlayParams& params) {
+    if (wave == nullptr) {
+        return AudioMixer::kInvalidVoiceId;
+    }
+    return voicePool_.Play(wave, params);
+}
+
+AudioMixer::VoiceId AudioManager::Play(const SoundClip* clip, const AudioPlayParams& params) {
+    if (clip == nullptr) {
+        return AudioMixer::kInvalidVoiceId;
+    }
+    return voicePool_.Play(clip, params);
+}
@@ -0,0 +1,63 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include "AudioMixer.h"
+#include "AudioOutput.h"
+#include "SoundClip.h"
+#include "VoicePool.h"
+#include "WaveFile.h"
+
+// 音声管理クラス
+// WAVファイルをパスごとに1回だけ開き (メモリマップ)、ボイスプールで鳴らして出力へ送る
+// 何度も鳴らす短い効果音は LoadClip で展開しておき、全ての声で同じサンプルを共有する
+// 出力は差し替えられる (Windowsでは XAudio2、それ以外や計測では NullAudioOutput)
+class AudioManager {
+public:
+    // 出力に1回で渡すフレーム数の初期値 (48kHzで約10ms)
+    static const uint32_t kDefaultBlockFrames = 480;
+
+public:
+    // シングルトンインスタンスの取得
+    static AudioManager* GetInstance();
+
+    // 初期化 (出力を開始できなければ NullAudioOutput に切り替える)
+    void Initialize(std::unique_ptr<AudioOutput> output, uint32_t sampleRate = AudioMixer::kDefaultSampleRate,
+        uint32_t maxVoices = AudioMixer::kDefaultMaxVoices, uint32_t blockFrames = kDefaultBlockFrames);
+
+    // 終了処理 (出力を止め、全てのファイルを閉じる)
+    void Finalize();
+
+    // 終わった声の回収 (毎フレーム呼ぶ)
+    void Update();
+
+    // WAVファイルの取得 (未読み込みなら開く。開けなければ nullptr)
+    const WaveFile* Load(std::string_view filePath);
+
+    // 効果音の取得 (未読み込みなら全体を展開する。読めなければ nullptr)
+    // 返した SoundClip の maxInstances を設定すると同時に鳴らす数を制限できる
+    SoundClip* LoadClip(std::string_view filePath);
+
+    // 再生
+    AudioMixer::VoiceId Play(const WaveFile* wave, const AudioPlayParams& params = {});
+    AudioMixer::VoiceId Play(const SoundClip* clip, const AudioPlayParams& params = {});
+
+    VoicePool& GetVoicePool() { return voicePool_; }
+    const AudioOutput* GetOutput() const { return output_.get(); }
+
+private:
+    AudioManager() = default;
+    ~AudioManager() = default;
+    AudioManager(const AudioManager&) = delete;
+    const AudioManager& operator=(const AudioManager&) = delete;
+
+private:
+    VoicePool voicePool_;
+    std::unique_ptr<AudioOutput> output_;
+    // パス → 開いたファイル
+    std::unordered_map<std::string, std::unique_ptr<WaveFile>> waves_;
+    // パス → 展開した効果音
+    std::unordered_map<std::string, std::unique_ptr<SoundClip>> clips_;
+};
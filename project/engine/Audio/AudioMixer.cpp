@@ -0,0 +1,277 @@
+#include "AudioMixer.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define AUDIO_MIXER_USE_SSE 1
+#endif
+
+namespace {
+
+// Mix で一度に処理するフレーム数 (音量の変化もこの長さで区切る)
+const uint32_t kMixBlockFrames = 512;
+
+const float kPi = 3.14159265358979f;
+
+// 32.32の固定小数点の1
+const uint64_t kFixedOne = 1ull << 32;
+
+// out += src * gain (gain は1フレームごとに step ずつ変わる。LRの交互)
+void Accumulate(float* out, const float* src, uint32_t frameCount, float left, float right, float stepLeft, float stepRight) {
+    uint32_t frame = 0;
+#ifdef AUDIO_MIXER_USE_SSE
+    __m128 gain = _mm_setr_ps(left, right, left + stepLeft, right + stepRight);
+    __m128 gainStep = _mm_setr_ps(stepLeft * 2.0f, stepRight * 2.0f, stepLeft * 2.0f, stepRight * 2.0f);
+    for (; frame + 2 <= frameCount; frame += 2) {
+        __m128 sum = _mm_add_ps(_mm_loadu_ps(out + frame * 2), _mm_mul_ps(_mm_loadu_ps(src + frame * 2), gain));
+        _mm_storeu_ps(out + frame * 2, sum);
+        gain = _mm_add_ps(gain, gainStep);
+    }
+#endif
+    for (; frame < frameCount; ++frame) {
+        out[frame * 2 + 0] += src[frame * 2 + 0] * (left + stepLeft * float(frame));
+        out[frame * 2 + 1] += src[frame * 2 + 1] * (right + stepRight * float(frame));
+    }
+}
+
+// samples *= volume して -1～1 に収める
+void ApplyMasterVolume(float* samples, size_t sampleCount, float volume) {
+    size_t i = 0;
+#ifdef AUDIO_MIXER_USE_SSE
+    __m128 scale = _mm_set1_ps(volume);
+    __m128 minimum = _mm_set1_ps(-1.0f);
+    __m128 maximum = _mm_set1_ps(1.0f);
+    for (; i + 4 <= sampleCount; i += 4) {
+        __m128 value = _mm_mul_ps(_mm_loadu_ps(samples + i), scale);
+        _mm_storeu_ps(samples + i, _mm_min_ps(_mm_max_ps(value, minimum), maximum));
+    }
+#endif
+    for (; i < sampleCount; ++i) {
+        samples[i] = std::clamp(samples[i] * volume, -1.0f, 1.0f);
+    }
+}
+
+} // namespace
+
+void AudioMixer::Initialize(uint32_t sampleRate, uint32_t maxVoices) {
+    assert(sampleRate > 0 && maxVoices > 0 && maxVoices <= 0xFFFF);
+    sampleRate_ = sampleRate;
+    voices_.clear();
+    voices_.resize(maxVoices);
+    for (Voice& voice : voices_) {
+        voice.buffer.resize((AudioStream::kChunkFrames + 1) * 2);
+    }
+    scratch_.resize(kMixBlockFrames * 2);
+    finishedVoices_.clear();
+    finishedVoices_.reserve(maxVoices);
+    masterVolume_ = 1.0f;
+}
+
+void AudioMixer::Finalize() {
+    voices_.clear();
+    scratch_.clear();
+    finishedVoices_.clear();
+}
+
+AudioMixer::VoiceId AudioMixer::Play(const AudioSource* source, const AudioPlayParams& params) {
+    for (uint32_t index = 0; index < voices_.size(); ++index) {
+        const Voice& voice = voices_[index];
+        if (voice.active) {
+            continue;
+        }
+        // 世代が0にならないようにする (識別子の0は無効)
+        uint16_t generation = voice.generation == 0xFFFF ? 1 : voice.generation + 1;
+        VoiceId voiceId = (VoiceId(generation) << 16) | index;
+        PlayAt(voiceId, source, params, false);
+        return voiceId;
+    }
+    return kInvalidVoiceId;
+}
+
+void AudioMixer::PlayAt(VoiceId voiceId, const AudioSource* source, const AudioPlayParams& params, bool fadeIn) {
+    assert(source != nullptr && source->GetSampleRate() > 0);
+    uint32_t index = voiceId & 0xFFFF;
+    assert(voiceId != kInvalidVoiceId && index < voices_.size());
+    Voice& voice = voices_[index];
+    voice.generation = uint16_t(voiceId >> 16);
+    voice.active = true;
+    voice.stream.Open(source, params.loop);
+    voice.bufferFrames = 0;
+    voice.position = 0;
+    voice.sourceRate = source->GetSampleRate();
+    voice.volume = std::max(params.volume, 0.0f);
+    voice.pan = std::clamp(params.pan, -1.0f, 1.0f);
+    voice.pitch = std::clamp(params.pitch, kMinPitch, kMaxPitch);
+    UpdateStep(voice);
+    if (fadeIn) {
+        voice.gainLeft = 0.0f;
+        voice.gainRight = 0.0f;
+    } else {
+        // 鳴り始めは最初から目標の音量にする (立ち上がりを鈍らせない)
+        ComputeGains(voice, voice.gainLeft, voice.gainRight);
+    }
+}
+
+void AudioMixer::Stop(VoiceId voiceId) {
+    Voice* voice = FindVoice(voiceId);
+    if (voice != nullptr) {
+        voice->active = false;
+        voice->stream.Close();
+    }
+}
+
+void AudioMixer::StopAll() {
+    for (Voice& voice : voices_) {
+        voice.active = false;
+        voice.stream.Close();
+    }
+}
+
+void AudioMixer::SetVolume(VoiceId voiceId, float volume) {
+    Voice* voice = FindVoice(voiceId);
+    if (voice != nullptr) {
+        voice->volume = std::max(volume, 0.0f);
+    }
+}
+
+void AudioMixer::SetPan(VoiceId voiceId, float pan) {
+    Voice* voice = FindVoice(voiceId);
+    if (voice != nullptr) {
+        voice->pan = std::clamp(pan, -1.0f, 1.0f);
+    }
+}
+
+void AudioMixer::SetPitch(VoiceId voiceId, float pitch) {
+    Voice* voice = FindVoice(voiceId);
+    if (voice != nullptr) {
+        voice->pitch = std::clamp(pitch, kMinPitch, kMaxPitch);
+        UpdateStep(*voice);
+    }
+}
+
+bool AudioMixer::IsPlaying(VoiceId voiceId) const {
+    return FindVoice(voiceId) != nullptr;
+}
+
+void AudioMixer::SetMasterVolume(float volume) {
+    masterVolume_ = std::max(volume, 0.0f);
+}
+
+uint32_t AudioMixer::GetActiveVoiceCount() const {
+    uint32_t count = 0;
+    for (const Voice& voice : voices_) {
+        count += voice.active ? 1 : 0;
+    }
+    return count;
+}
+
+void AudioMixer::Mix(float* output, uint32_t frameCount) {
+    std::memset(output, 0, sizeof(float) * 2 * frameCount);
+    finishedVoices_.clear();
+    for (uint32_t blockStart = 0; blockStart < frameCount; blockStart += kMixBlockFrames) {
+        uint32_t blockFrames = std::min(kMixBlockFrames, frameCount - blockStart);
+        float* out = output + size_t(blockStart) * 2;
+        for (Voice& voice : voices_) {
+            if (!voice.active) {
+                continue;
+            }
+            // 前のブロックの終わりの音量から、今の設定の音量までブロックの中で変える
+            float targetLeft = 0.0f;
+            float targetRight = 0.0f;
+            ComputeGains(voice, targetLeft, targetRight);
+            float stepLeft = (targetLeft - voice.gainLeft) / float(blockFrames);
+            float stepRight = (targetRight - voice.gainRight) / float(blockFrames);
+
+            uint32_t produced = Resample(voice, blockFrames);
+            Accumulate(out, scratch_.data(), produced, voice.gainLeft, voice.gainRight, stepLeft, stepRight);
+            voice.gainLeft = targetLeft;
+            voice.gainRight = targetRight;
+            if (produced < blockFrames) {
+                voice.active = false;
+                voice.stream.Close();
+                finishedVoices_.push_back((VoiceId(voice.generation) << 16) | uint32_t(&voice - voices_.data()));
+            }
+        }
+    }
+    ApplyMasterVolume(output, size_t(frameCount) * 2, masterVolume_);
+}
+
+AudioMixer::Voice* AudioMixer::FindVoice(VoiceId voiceId) {
+    uint32_t index = voiceId & 0xFFFF;
+    if (voiceId == kInvalidVoiceId || index >= voices_.size()) {
+        return nullptr;
+    }
+    Voice& voice = voices_[index];
+    return voice.active && voice.generation == (voiceId >> 16) ? &voice : nullptr;
+}
+
+const AudioMixer::Voice* AudioMixer::FindVoice(VoiceId voiceId) const {
+    return const_cast<AudioMixer*>(this)->FindVoice(voiceId);
+}
+
+void AudioMixer::UpdateStep(Voice& voice) const {
+    double step = double(voice.sourceRate) / double(sampleRate_) * double(voice.pitch) * double(kFixedOne);
+    voice.step = std::max<uint64_t>(uint64_t(step + 0.5), 1);
+}
+
+void AudioMixer::ComputeGains(const Voice& voice, float& left, float& right) {
+    // 等パワーのパン (中央では左右とも 1/√2)
+    float angle = (voice.pan + 1.0f) * (kPi * 0.25f);
+    left = std::cos(angle) * voice.volume;
+    right = std::sin(angle) * voice.volume;
+}
+
+uint32_t AudioMixer::Resample(Voice& voice, uint32_t frameCount) {
+    float* out = scratch_.data();
+    uint32_t produced = 0;
+    while (produced < frameCount) {
+        uint32_t index = uint32_t(voice.position >> 32);
+        if (index + 1 >= voice.bufferFrames) {
+            if (!Refill(voice)) {
+                break;
+            }
+            continue;
+        }
+        // 補間で index + 1 を読むので、バッファの最後のフレームの手前まで進められる
+        uint64_t limit = uint64_t(voice.bufferFrames - 1) << 32;
+        uint64_t available = (limit - voice.position + voice.step - 1) / voice.step;
+        uint32_t count = uint32_t(std::min<uint64_t>(available, frameCount - produced));
+        const float* source = voice.buffer.data();
+        float* destination = out + size_t(produced) * 2;
+        if (voice.step == kFixedOne && (voice.position & (kFixedOne - 1)) == 0) {
+            // 同じサンプルレートでピッチを変えないときは補間しない
+            std::memcpy(destination, source + size_t(index) * 2, sizeof(float) * 2 * count);
+        } else {
+            uint64_t position = voice.position;
+            for (uint32_t i = 0; i < count; ++i) {
+                const float* frame = source + (position >> 32) * 2;
+                float fraction = float(uint32_t(position)) * (1.0f / 4294967296.0f);
+                destination[i * 2 + 0] = frame[0] + (frame[2] - frame[0]) * fraction;
+                destination[i * 2 + 1] = frame[1] + (frame[3] - frame[1]) * fraction;
+                position += voice.step;
+            }
+        }
+        voice.position += voice.step * count;
+        produced += count;
+    }
+    return produced;
+}
+
+bool AudioMixer::Refill(Voice& voice) {
+    uint32_t keep = 0;
+    if (voice.bufferFrames > 0) {
+        // 最後のフレームを先頭に移し、再生位置もそれに合わせる
+        float* buffer = voice.buffer.data();
+        uint32_t last = voice.bufferFrames - 1;
+        buffer[0] = buffer[last * 2 + 0];
+        buffer[1] = buffer[last * 2 + 1];
+        voice.position -= uint64_t(last) << 32;
+        keep = 1;
+    }
+    uint32_t read = voice.stream.Read(voice.buffer.data() + keep * 2, AudioStream::kChunkFrames);
+    voice.bufferFrames = keep + read;
+    return read > 0;
+}
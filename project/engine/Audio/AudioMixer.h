@@ -0,0 +1,114 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "AudioSource.h"
+#include "AudioStream.h"
+
+// 再生の設定
+struct AudioPlayParams {
+    float volume = 1.0f; // 0以上 (1で元の大きさ)
+    float pan = 0.0f;    // -1 (左) ～ 1 (右)
+    float pitch = 1.0f;  // 再生速度 (2で1オクターブ上)
+    bool loop = false;
+    // 声が足りないときの優先度と、聴く位置からの距離 (VoicePool が声を奪う相手を選ぶのに使う。ミキサーは見ない)
+    uint8_t priority = 128;
+    float distance = 0.0f;
+};
+
+// ソフトウェアミキサー
+// 再生中の声 (ボイス) ごとに WAV を逐次読み込み、ピッチと出力のサンプルレートに合わせて線形補間で変換し、
+// 音量とパンをかけてステレオの float に足し合わせる (足し合わせはSSEで2フレームずつ)
+// 音量とパンの変化はブロックの中で直線的に変え、ノイズが出ないようにする
+// 出力先には依存しない (AudioOutput のスレッドから Mix を呼ぶ)
+// スレッドセーフではない。ゲームのスレッドから鳴らすときは VoicePool を通す (コマンドはキューで出力のスレッドへ送る)
+class AudioMixer {
+public:
+    // 声の識別子 (下位16bitが番号、上位16bitが世代。終わった声の識別子は無効になる)
+    using VoiceId = uint32_t;
+    static const VoiceId kInvalidVoiceId = 0;
+
+    // 出力のサンプルレートの初期値
+    static const uint32_t kDefaultSampleRate = 48000;
+    // 同時に鳴らせる声の数の初期値
+    static const uint32_t kDefaultMaxVoices = 64;
+    // ピッチの範囲
+    static constexpr float kMinPitch = 1.0f / 16.0f;
+    static constexpr float kMaxPitch = 16.0f;
+
+public:
+    // 初期化
+    void Initialize(uint32_t sampleRate = kDefaultSampleRate, uint32_t maxVoices = kDefaultMaxVoices);
+
+    // 終了処理 (全ての声を止める)
+    void Finalize();
+
+    // 再生 (空いている声が無ければ kInvalidVoiceId。source は再生が終わるまで生きていること)
+    VoiceId Play(const AudioSource* source, const AudioPlayParams& params = {});
+
+    // 番号と世代を指定して再生 (鳴っている声は置き換える。番号は VoicePool が決める)
+    // fadeIn なら最初のブロックで0から音量を上げる (奪った声の続きで鳴らしてもノイズが出ないようにする)
+    void PlayAt(VoiceId voice, const AudioSource* source, const AudioPlayParams& params, bool fadeIn);
+
+    // 停止
+    void Stop(VoiceId voice);
+    void StopAll();
+
+    // 再生中の声の設定を変える (次のブロックから、ブロックの長さをかけて変わる)
+    void SetVolume(VoiceId voice, float volume);
+    void SetPan(VoiceId voice, float pan);
+    void SetPitch(VoiceId voice, float pitch);
+
+    // 再生中か
+    bool IsPlaying(VoiceId voice) const;
+
+    // 全体の音量
+    void SetMasterVolume(float volume);
+
+    // frameCount フレームをステレオの float (LRの交互) で output に書く (-1～1 に収める)
+    void Mix(float* output, uint32_t frameCount);
+
+    // 直前の Mix で終わりまで鳴った声
+    const std::vector<VoiceId>& GetFinishedVoices() const { return finishedVoices_; }
+
+    uint32_t GetSampleRate() const { return sampleRate_; }
+    uint32_t GetMaxVoices() const { return static_cast<uint32_t>(voices_.size()); }
+    // 再生中の声の数
+    uint32_t GetActiveVoiceCount() const;
+
+private:
+    // 声
+    struct Voice {
+        uint16_t generation = 0;
+        bool active = false;
+        AudioStream stream;
+        // 読み込んだフレーム (ステレオ)。補間のために前のチャンクの最後のフレームを先頭に残す
+        std::vector<float> buffer;
+        uint32_t bufferFrames = 0;
+        uint64_t position = 0; // buffer の中の再生位置 (32.32の固定小数点)
+        uint64_t step = 0;     // 出力1フレームで進む量 (32.32の固定小数点)
+        uint32_t sourceRate = 0;
+        float volume = 1.0f;
+        float pan = 0.0f;
+        float pitch = 1.0f;
+        // 前のブロックの終わりの左右の音量 (次のブロックはここから変える)
+        float gainLeft = 0.0f;
+        float gainRight = 0.0f;
+    };
+
+    Voice* FindVoice(VoiceId voice);
+    const Voice* FindVoice(VoiceId voice) const;
+    void UpdateStep(Voice& voice) const;
+    static void ComputeGains(const Voice& voice, float& left, float& right);
+
+    // 補間したフレームを scratch_ に書き、書いたフレーム数を返す (ストリームが終わると frameCount より少ない)
+    uint32_t Resample(Voice& voice, uint32_t frameCount);
+    // ストリームから次のチャンクを読む (読めなければ false)
+    bool Refill(Voice& voice);
+
+private:
+    uint32_t sampleRate_ = kDefaultSampleRate;
+    std::vector<Voice> voices_;
+    std::vector<float> scratch_;
+    std::vector<VoiceId> finishedVoices_;
+    float masterVolume_ = 1.0f;
+};
@@ -0,0 +1,47 @@
+#include "AudioOutput.h"
+#include <chrono>
+#include <cmath>
+
+NullAudioOutput::~NullAudioOutput() {
+    Stop();
+}
+
+bool NullAudioOutput::Start(uint32_t sampleRate, uint32_t blockFrames, RenderCallback render) {
+    Stop();
+    sampleRate_ = sampleRate;
+    blockFrames_ = blockFrames;
+    render_ = std::move(render);
+    buffer_.assign(size_t(blockFrames) * 2, 0.0f);
+    renderedFrames_ = 0;
+    peak_ = 0.0f;
+    running_ = true;
+    thread_ = std::thread([this] { Run(); });
+    return true;
+}
+
+void NullAudioOutput::Stop() {
+    running_ = false;
+    if (thread_.joinable()) {
+        thread_.join();
+    }
+}
+
+void NullAudioOutput::Run() {
+    using Clock = std::chrono::steady_clock;
+    Clock::time_point start = Clock::now();
+    uint64_t frames = 0;
+    float peak = 0.0f;
+    while (running_) {
+        render_(buffer_.data(), blockFrames_);
+        for (float sample : buffer_) {
+            peak = std::fabs(sample) > peak ? std::fabs(sample) : peak;
+        }
+        frames += blockFrames_;
+        renderedFrames_.store(frames, std::memory_order_relaxed);
+        peak_.store(peak, std::memory_order_relaxed);
+        if (realtime_) {
+            // 作った分の再生時間が経つまで待つ
+            std::this_thread::sleep_until(start + std::chrono::microseconds(frames * 1000000 / sampleRate_));
+        }
+    }
+}
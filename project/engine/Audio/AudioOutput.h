@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// 音声の出力先
+// ミキサーが作った音をデバイスへ送る部分を差し替えられるようにする (ミキサーはどの出力でも同じに動く)
+// 出力は自分のスレッドから render を呼んで、ステレオの float を受け取る
+class AudioOutput {
+public:
+    // 出力する音を作る関数 (frameCount フレームをステレオの float で output に書く。出力のスレッドから呼ばれる)
+    using RenderCallback = std::function<void(float* output, uint32_t frameCount)>;
+
+public:
+    virtual ~AudioOutput() = default;
+
+    // 出力の開始 (blockFrames は1回の render で作るフレーム数。デバイスが使えなければ false)
+    virtual bool Start(uint32_t sampleRate, uint32_t blockFrames, RenderCallback render) = 0;
+
+    // 出力の停止 (戻った後は render は呼ばれない)
+    virtual void Stop() = 0;
+
+    // 出力の名前 (表示用)
+    virtual const char* GetName() const = 0;
+};
+
+// 何も鳴らさない出力 (サウンドデバイスの無い環境や、ミキサーの計測用)
+// realtime なら実際の再生と同じ間隔で render を呼び、そうでなければ休まず呼ぶ
+class NullAudioOutput : public AudioOutput {
+public:
+    explicit NullAudioOutput(bool realtime = true) : realtime_(realtime) {}
+    ~NullAudioOutput() override;
+
+    bool Start(uint32_t sampleRate, uint32_t blockFrames, RenderCallback render) override;
+    void Stop() override;
+    const char* GetName() const override { return "null"; }
+
+    // これまでに作ったフレーム数
+    uint64_t GetRenderedFrames() const { return renderedFrames_.load(std::memory_order_relaxed); }
+    // これまでに作った音の絶対値の最大
+    float GetPeak() const { return peak_.load(std::memory_order_relaxed); }
+
+private:
+    void Run();
+
+private:
+    bool realtime_ = true;
+    uint32_t sampleRate_ = 0;
+    uint32_t blockFrames_ = 0;
+    RenderCallback render_;
+    std::vector<float> buffer_;
+    std::thread thread_;
+    std::atomic<bool> running_ = false;
+    std::atomic<uint64_t> renderedFrames_ = 0;
+    std::atomic<float> peak_ = 0.0f;
+};
+
+#if defined(_WIN32)
+// XAudio2 への出力 (ソースボイスに float のバッファを順に送る)
+std::unique_ptr<AudioOutput> CreateXAudio2Output();
+#endif
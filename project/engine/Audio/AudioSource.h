@@ -0,0 +1,19 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 再生できる音 (WAVファイルやデコード済みのクリップ)
+// ミキサーは再生位置から決まった数のフレームずつステレオの float で受け取る
+class AudioSource {
+public:
+    virtual ~AudioSource() = default;
+
+    // フレームをステレオの float (-1～1、LRの交互) に変換する (範囲外のフレームは書かない)
+    virtual void DecodeStereo(uint64_t firstFrame, uint32_t frameCount, float* stereo) const = 0;
+
+    // フレーム数
+    virtual uint64_t GetFrameCount() const = 0;
+
+    // サンプルレート
+    virtual uint32_t GetSampleRate() const = 0;
+};
@@ -0,0 +1,43 @@
+#include "AudioStream.h"
+
+void AudioStream::Open(const AudioSource* source, bool loop) {
+    source_ = source;
+    cursor_ = 0;
+    loop_ = loop;
+}
+
+void AudioStream::Close() {
+    source_ = nullptr;
+    cursor_ = 0;
+    loop_ = false;
+}
+
+uint32_t AudioStream::Read(float* stereo, uint32_t frameCount) {
+    if (source_ == nullptr || source_->GetFrameCount() == 0) {
+        return 0;
+    }
+    uint64_t totalFrames = source_->GetFrameCount();
+    uint32_t written = 0;
+    while (written < frameCount) {
+        if (cursor_ >= totalFrames) {
+            if (!loop_) {
+                break;
+            }
+            cursor_ = 0;
+        }
+        uint64_t remaining = totalFrames - cursor_;
+        uint32_t count = remaining < frameCount - written ? uint32_t(remaining) : frameCount - written;
+        source_->DecodeStereo(cursor_, count, stereo + size_t(written) * 2);
+        cursor_ += count;
+        written += count;
+    }
+    return written;
+}
+
+void AudioStream::Seek(uint64_t frame) {
+    if (source_ == nullptr) {
+        return;
+    }
+    uint64_t totalFrames = source_->GetFrameCount();
+    cursor_ = loop_ && totalFrames > 0 ? frame % totalFrames : frame;
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <cstdint>
+#include "AudioSource.h"
+
+// 音の逐次読み込み
+// 再生位置から決まった数のフレームずつステレオの float に変換して渡す (WAVファイル全体を展開しない)
+// AudioSource (WaveFile / SoundClip) は共有してよく、再生ごとに AudioStream を1つ持つ
+class AudioStream {
+public:
+    // 1回に読むフレーム数 (ミキサーの声ごとのバッファの大きさ)
+    static const uint32_t kChunkFrames = 1024;
+
+public:
+    // 読み込みの開始 (source は読み終わるまで生きていること)
+    void Open(const AudioSource* source, bool loop);
+
+    // 閉じる
+    void Close();
+
+    // 最大 frameCount フレームをステレオの float (LRの交互) で書き、書いたフレーム数を返す
+    // ループするときは先頭に戻って続きを書く。終わりまで読んだら 0
+    uint32_t Read(float* stereo, uint32_t frameCount);
+
+    // 再生位置を変える
+    void Seek(uint64_t frame);
+
+    bool IsOpen() const { return source_ != nullptr; }
+    bool IsEnd() const { return source_ == nullptr || (!loop_ && cursor_ >= source_->GetFrameCount()); }
+    uint64_t GetCursor() const { return cursor_; }
+    const AudioSource* GetSource() const { return source_; }
+
+private:
+    const AudioSource* source_ = nullptr;
+    uint64_t cursor_ = 0;
+    bool loop_ = false;
+};
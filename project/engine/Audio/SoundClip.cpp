@@ -0,0 +1,24 @@
+#include "SoundClip.h"
+#include <cstring>
+
+void SoundClip::Load(const AudioSource& source) {
+    uint64_t frameCount = source.GetFrameCount();
+    samples_.assign(size_t(frameCount) * 2, 0.0f);
+    sampleRate_ = source.GetSampleRate();
+    // 一度に変換する量を区切る (DecodeStereo のフレーム数は32bit)
+    const uint32_t kDecodeFrames = 1u << 20;
+    for (uint64_t frame = 0; frame < frameCount; frame += kDecodeFrames) {
+        uint64_t remaining = frameCount - frame;
+        uint32_t count = remaining < kDecodeFrames ? uint32_t(remaining) : kDecodeFrames;
+        source.DecodeStereo(frame, count, samples_.data() + frame * 2);
+    }
+}
+
+void SoundClip::DecodeStereo(uint64_t firstFrame, uint32_t frameCount, float* stereo) const {
+    uint64_t totalFrames = GetFrameCount();
+    if (firstFrame >= totalFrames) {
+        return;
+    }
+    uint64_t count = totalFrames - firstFrame < frameCount ? totalFrames - firstFrame : frameCount;
+    std::memcpy(stereo, samples_.data() + firstFrame * 2, sizeof(float) * 2 * count);
+}
@@ -0,0 +1,29 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "AudioSource.h"
+
+// デコード済みの短い音 (効果音)
+// 全体をステレオの float に展開して持ち、同じクリップを鳴らす全ての声で共有する (再生ごとに変換しない)
+// 長い音 (BGM) は WaveFile のまま逐次読み込みで鳴らす
+class SoundClip : public AudioSource {
+public:
+    // 元の音を全て展開する
+    void Load(const AudioSource& source);
+
+    void DecodeStereo(uint64_t firstFrame, uint32_t frameCount, float* stereo) const override;
+    uint64_t GetFrameCount() const override { return samples_.size() / 2; }
+    uint32_t GetSampleRate() const override { return sampleRate_; }
+
+    // 展開したバイト数
+    size_t GetMemorySize() const { return samples_.size() * sizeof(float); }
+
+public:
+    // 同時に鳴らせる数 (0なら制限しない。超えたら同じクリップの最も古い声を止めて鳴らす)
+    uint32_t maxInstances = 0;
+
+private:
+    std::vector<float> samples_; // ステレオ (LRの交互)
+    uint32_t sampleRate_ = 0;
+};
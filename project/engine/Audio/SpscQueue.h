@@ -0,0 +1,64 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <vector>
+
+// 1つのスレッドが入れ、別の1つのスレッドが取り出す固定長のキュー (ロックしない・確保しない)
+// 出力のスレッドがロックやメモリ確保で待たされないよう、ゲームのスレッドとの間のやり取りに使う
+template <typename T>
+class SpscQueue {
+public:
+    // 初期化 (容量は2のべきに切り上げる。使い始める前に呼ぶ)
+    void Initialize(uint32_t capacity) {
+        uint32_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        items_.assign(size, T{});
+        mask_ = size - 1;
+        head_.store(0, std::memory_order_relaxed);
+        tail_.store(0, std::memory_order_relaxed);
+        cachedHead_ = 0;
+        cachedTail_ = 0;
+    }
+
+    // 入れる (入れる側のスレッドだけが呼ぶ。満杯なら false)
+    bool Push(const T& item) {
+        uint64_t tail = tail_.load(std::memory_order_relaxed);
+        if (tail - cachedHead_ > mask_) {
+            cachedHead_ = head_.load(std::memory_order_acquire);
+            if (tail - cachedHead_ > mask_) {
+                return false;
+            }
+        }
+        items_[tail & mask_] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 取り出す (取り出す側のスレッドだけが呼ぶ。空なら false)
+    bool Pop(T& item) {
+        uint64_t head = head_.load(std::memory_order_relaxed);
+        if (head == cachedTail_) {
+            cachedTail_ = tail_.load(std::memory_order_acquire);
+            if (head == cachedTail_) {
+                return false;
+            }
+        }
+        item = items_[head & mask_];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    uint32_t GetCapacity() const { return mask_ + 1; }
+
+private:
+    std::vector<T> items_;
+    uint32_t mask_ = 0;
+    // 取り出す側が書く位置と、入れる側の位置の控え (偽共有を避けてキャッシュラインを分ける)
+    alignas(64) std::atomic<uint64_t> head_ = 0;
+    uint64_t cachedTail_ = 0;
+    // 入れる側が書く位置と、取り出す側の位置の控え
+    alignas(64) std::atomic<uint64_t> tail_ = 0;
+    uint64_t cachedHead_ = 0;
+};
@@ -0,0 +1,354 @@
+#include "VoicePool.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cmath>
+
+void VoicePool::Initialize(const Settings& settings) {
+    assert(settings.maxVoices > 0 && settings.maxVoices <= 0xFFFF && settings.commandCapacity > 0);
+    settings_ = settings;
+    mixer_.Initialize(settings.sampleRate, settings.maxVoices);
+    slots_.assign(settings.maxVoices, Slot{});
+    activeCount_ = 0;
+    playOrder_ = 0;
+    stats_ = {};
+    commands_.Initialize(settings.commandCapacity);
+    // 普段はコマンドの数と声の数の分あれば足りるが、Update を呼ばずに奪い続けると溢れるので、
+    // 溢れた分は pendingFinished_ に残して後で返す
+    finishedVoices_.Initialize(settings.commandCapacity + settings.maxVoices);
+    pendingFinished_.assign(settings.maxVoices, VoiceId(AudioMixer::kInvalidVoiceId));
+    pendingFinishedCount_ = 0;
+    ResetLatency();
+}
+
+void VoicePool::Finalize() {
+    mixer_.Finalize();
+    slots_.clear();
+    activeCount_ = 0;
+}
+
+VoicePool::VoiceId VoicePool::Play(const SoundClip* clip, const AudioPlayParams& params) {
+    assert(clip != nullptr);
+    return PlayWithLimit(clip, params, clip->maxInstances);
+}
+
+VoicePool::VoiceId VoicePool::Play(const AudioSource* source, const AudioPlayParams& params) {
+    return PlayWithLimit(source, params, 0);
+}
+
+VoicePool::VoiceId VoicePool::PlayWithLimit(const AudioSource* source, const AudioPlayParams& params, uint32_t maxInstances) {
+    assert(source != nullptr);
+    if (params.distance > settings_.maxDistance) {
+        ++stats_.culledCount;
+        return AudioMixer::kInvalidVoiceId;
+    }
+    float attenuation = Attenuate(params.distance);
+    float audibility = params.volume * attenuation;
+    int64_t now = NowNanoseconds();
+
+    // 空いている声・同じ音の声・最も弱い声を1回で探す
+    uint32_t freeIndex = UINT32_MAX;
+    uint32_t oldestSameIndex = UINT32_MAX;
+    uint32_t sameCount = 0;
+    uint32_t weakestIndex = UINT32_MAX;
+    float weakestPriority = 0.0f;
+    for (uint32_t index = 0; index < slots_.size(); ++index) {
+        const Slot& slot = slots_[index];
+        if (!slot.active) {
+            freeIndex = freeIndex == UINT32_MAX ? index : freeIndex;
+            continue;
+        }
+        if (slot.source == source) {
+            ++sameCount;
+            if (oldestSameIndex == UINT32_MAX || slot.order < slots_[oldestSameIndex].order) {
+                oldestSameIndex = index;
+            }
+        }
+        // 優先度 (鳴らしてからの時間で下がったもの) が低い → 小さく聞こえる → 古い の順に弱い
+        float priority = GetStealPriority(slot, now);
+        if (weakestIndex == UINT32_MAX) {
+            weakestIndex = index;
+            weakestPriority = priority;
+            continue;
+        }
+        const Slot& weakest = slots_[weakestIndex];
+        if (priority != weakestPriority ? priority < weakestPriority
+            : slot.audibility != weakest.audibility ? slot.audibility < weakest.audibility
+                                                    : slot.order < weakest.order) {
+            weakestIndex = index;
+            weakestPriority = priority;
+        }
+    }
+
+    uint32_t index = UINT32_MAX;
+    if (maxInstances > 0 && sameCount >= maxInstances) {
+        // 同時に鳴らせる数を超えたら、同じ音の最も古い声を鳴らし直す
+        index = oldestSameIndex;
+    } else if (freeIndex != UINT32_MAX) {
+        index = freeIndex;
+    } else {
+        // 新しい音の方が強ければ最も弱い声を奪う
+        if (!IsStronger(params.priority, audibility, slots_[weakestIndex], now)) {
+            ++stats_.rejectCount;
+            return AudioMixer::kInvalidVoiceId;
+        }
+        index = weakestIndex;
+    }
+
+    Slot& slot = slots_[index];
+    bool steal = slot.active;
+    uint16_t generation = slot.generation == 0xFFFF ? 1 : slot.generation + 1;
+    VoiceId voice = (VoiceId(generation) << 16) | index;
+
+    Command command;
+    command.type = CommandType::kPlay;
+    command.voice = voice;
+    command.source = source;
+    command.params = params;
+    command.params.volume = params.volume * attenuation;
+    command.fadeIn = steal;
+    if (!Send(command)) {
+        return AudioMixer::kInvalidVoiceId;
+    }
+
+    if (!steal) {
+        ++activeCount_;
+    }
+    slot.generation = generation;
+    slot.active = true;
+    slot.source = source;
+    slot.priority = params.priority;
+    slot.attenuation = attenuation;
+    slot.audibility = audibility;
+    slot.order = playOrder_++;
+    slot.startTime = now;
+    ++stats_.playCount;
+    stats_.stealCount += steal ? 1 : 0;
+    return voice;
+}
+
+void VoicePool::Stop(VoiceId voice) {
+    Slot* slot = FindSlot(voice);
+    if (slot == nullptr) {
+        return;
+    }
+    Command command;
+    command.type = CommandType::kStop;
+    command.voice = voice;
+    if (Send(command)) {
+        slot->active = false;
+        --activeCount_;
+    }
+}
+
+void VoicePool::StopAll() {
+    Command command;
+    command.type = CommandType::kStopAll;
+    if (Send(command)) {
+        for (Slot& slot : slots_) {
+            slot.active = false;
+        }
+        activeCount_ = 0;
+    }
+}
+
+void VoicePool::SetVolume(VoiceId voice, float volume) {
+    Slot* slot = FindSlot(voice);
+    if (slot == nullptr) {
+        return;
+    }
+    Command command;
+    command.type = CommandType::kVolume;
+    command.voice = voice;
+    command.value = volume * slot->attenuation;
+    if (Send(command)) {
+        slot->audibility = command.value;
+    }
+}
+
+void VoicePool::SetPan(VoiceId voice, float pan) {
+    if (FindSlot(voice) == nullptr) {
+        return;
+    }
+    Command command;
+    command.type = CommandType::kPan;
+    command.voice = voice;
+    command.value = pan;
+    Send(command);
+}
+
+void VoicePool::SetPitch(VoiceId voice, float pitch) {
+    if (FindSlot(voice) == nullptr) {
+        return;
+    }
+    Command command;
+    command.type = CommandType::kPitch;
+    command.voice = voice;
+    command.value = pitch;
+    Send(command);
+}
+
+void VoicePool::SetMasterVolume(float volume) {
+    Command command;
+    command.type = CommandType::kMasterVolume;
+    command.value = volume;
+    Send(command);
+}
+
+bool VoicePool::IsPlaying(VoiceId voice) const {
+    return FindSlot(voice) != nullptr;
+}
+
+void VoicePool::Update() {
+    VoiceId voice;
+    while (finishedVoices_.Pop(voice)) {
+        // 奪われたり止めたりした後の知らせは世代が合わないので無視される
+        Slot* slot = FindSlot(voice);
+        if (slot != nullptr) {
+            slot->active = false;
+            --activeCount_;
+        }
+    }
+}
+
+float VoicePool::GetStealPriority(const Slot& slot, int64_t now) const {
+    if (slot.priority == kMaxPriority || settings_.priorityHalfLifeSeconds <= 0.0f) {
+        return float(slot.priority);
+    }
+    // 鳴らしてから priorityHalfLifeSeconds で半分になり、そこで止まる
+    float age = float(double(now - slot.startTime) * 1e-9) / settings_.priorityHalfLifeSeconds;
+    return float(slot.priority) * (1.0f - 0.5f * std::min(age, 1.0f));
+}
+
+bool VoicePool::IsStronger(uint8_t priority, float audibility, const Slot& slot, int64_t now) const {
+    float slotPriority = GetStealPriority(slot, now);
+    return float(priority) != slotPriority ? float(priority) > slotPriority : audibility >= slot.audibility;
+}
+
+float VoicePool::Attenuate(float distance) const {
+    return distance <= settings_.referenceDistance ? 1.0f : settings_.referenceDistance / distance;
+}
+
+void VoicePool::Render(float* output, uint32_t frameCount) {
+    int64_t now = NowNanoseconds();
+    Command command;
+    while (commands_.Pop(command)) {
+        Apply(command, now);
+    }
+    mixer_.Mix(output, frameCount);
+
+    // 前に返せなかった声から返す (返せないまま捨てると、ゲームのスレッドでは鳴っているままになる)
+    for (uint32_t index = 0; pendingFinishedCount_ > 0 && index < pendingFinished_.size(); ++index) {
+        VoiceId& pending = pendingFinished_[index];
+        if (pending == AudioMixer::kInvalidVoiceId) {
+            continue;
+        }
+        if (!finishedVoices_.Push(pending)) {
+            break;
+        }
+        pending = AudioMixer::kInvalidVoiceId;
+        --pendingFinishedCount_;
+    }
+    for (VoiceId voice : mixer_.GetFinishedVoices()) {
+        if (!finishedVoices_.Push(voice)) {
+            // 同じ声の古い世代の知らせは Update で無視されるので、最新の世代だけ残せばよい
+            VoiceId& pending = pendingFinished_[voice & 0xFFFF];
+            pendingFinishedCount_ += pending == AudioMixer::kInvalidVoiceId ? 1 : 0;
+            pending = voice;
+        }
+    }
+}
+
+void VoicePool::Apply(const Command& command, int64_t now) {
+    switch (command.type) {
+    case CommandType::kPlay:
+        mixer_.PlayAt(command.voice, command.source, command.params, command.fadeIn);
+        RecordLatency(now - command.timestamp);
+        break;
+    case CommandType::kStop:
+        mixer_.Stop(command.voice);
+        break;
+    case CommandType::kStopAll:
+        mixer_.StopAll();
+        break;
+    case CommandType::kVolume:
+        mixer_.SetVolume(command.voice, command.value);
+        break;
+    case CommandType::kPan:
+        mixer_.SetPan(command.voice, command.value);
+        break;
+    case CommandType::kPitch:
+        mixer_.SetPitch(command.voice, command.value);
+        break;
+    case CommandType::kMasterVolume:
+        mixer_.SetMasterVolume(command.value);
+        break;
+    }
+}
+
+VoicePool::Slot* VoicePool::FindSlot(VoiceId voice) {
+    uint32_t index = voice & 0xFFFF;
+    if (voice == AudioMixer::kInvalidVoiceId || index >= slots_.size()) {
+        return nullptr;
+    }
+    Slot& slot = slots_[index];
+    return slot.active && slot.generation == (voice >> 16) ? &slot : nullptr;
+}
+
+const VoicePool::Slot* VoicePool::FindSlot(VoiceId voice) const {
+    return const_cast<VoicePool*>(this)->FindSlot(voice);
+}
+
+bool VoicePool::Send(const Command& command) {
+    Command timed = command;
+    timed.timestamp = NowNanoseconds();
+    if (!commands_.Push(timed)) {
+        ++stats_.droppedCount;
+        return false;
+    }
+    return true;
+}
+
+void VoicePool::RecordLatency(int64_t nanoseconds) {
+    nanoseconds = std::max<int64_t>(nanoseconds, 0);
+    uint64_t bucket = uint64_t(nanoseconds) / (kLatencyBucketMicroseconds * 1000ull);
+    latencyBuckets_[std::min<uint64_t>(bucket, kLatencyBucketCount)].fetch_add(1, std::memory_order_relaxed);
+    if (nanoseconds > maxLatencyNanoseconds_.load(std::memory_order_relaxed)) {
+        maxLatencyNanoseconds_.store(nanoseconds, std::memory_order_relaxed);
+    }
+}
+
+uint64_t VoicePool::GetLatencyCount() const {
+    uint64_t count = 0;
+    for (const std::atomic<uint32_t>& bucket : latencyBuckets_) {
+        count += bucket.load(std::memory_order_relaxed);
+    }
+    return count;
+}
+
+double VoicePool::GetLatencyPercentile(double percentile) const {
+    uint64_t total = GetLatencyCount();
+    if (total == 0) {
+        return 0.0;
+    }
+    uint64_t target = std::max<uint64_t>(uint64_t(std::ceil(double(total) * std::clamp(percentile, 0.0, 1.0))), 1);
+    uint64_t count = 0;
+    for (uint32_t bucket = 0; bucket <= kLatencyBucketCount; ++bucket) {
+        count += latencyBuckets_[bucket].load(std::memory_order_relaxed);
+        if (count >= target) {
+            return bucket < kLatencyBucketCount ? double(bucket + 1) * kLatencyBucketMicroseconds : GetMaxLatency();
+        }
+    }
+    return GetMaxLatency();
+}
+
+void VoicePool::ResetLatency() {
+    for (std::atomic<uint32_t>& bucket : latencyBuckets_) {
+        bucket.store(0, std::memory_order_relaxed);
+    }
+    maxLatencyNanoseconds_.store(0, std::memory_order_relaxed);
+}
+
+int64_t VoicePool::NowNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
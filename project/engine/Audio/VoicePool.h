@@ -0,0 +1,171 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include "AudioMixer.h"
+#include "AudioSource.h"
+#include "SoundClip.h"
+#include "SpscQueue.h"
+
+// 声の割り当てと、ゲームのスレッドから出力のスレッドへの受け渡し
+// 声の数は初期化で決めて確保しておき、鳴らすたびに確保しない
+// ゲームのスレッドが声を選び (空きが無ければ優先度と距離で弱い声を奪う)、コマンドをキューで出力のスレッドへ送る
+// 奪うときの優先度は鳴らしてからの時間で下がる (長い音が声を占め続けて、後から来た優先度の高い音が鳴らなくなるのを防ぐ)
+// 出力のスレッドは Render の先頭でコマンドを反映してから混ぜ、終わった声をキューで返す (どちらもロックしない)
+// Play などはゲームのスレッド (1つ) から、Render は出力のスレッドから呼ぶ
+class VoicePool {
+public:
+    using VoiceId = AudioMixer::VoiceId;
+
+    // 設定
+    struct Settings {
+        uint32_t sampleRate = AudioMixer::kDefaultSampleRate;
+        uint32_t maxVoices = AudioMixer::kDefaultMaxVoices;
+        uint32_t commandCapacity = 4096; // 1フレームに送れるコマンドの数 (超えた分は捨てる)
+        float referenceDistance = 1.0f;  // これより近い音は減衰しない (遠いほど距離に反比例して小さくする)
+        float maxDistance = 100.0f;      // これより遠い音は鳴らさない
+        // 奪うときの優先度が、鳴らしてからこの秒数で半分まで下がる (それ以上は下がらない。kMaxPriority は下がらない)
+        float priorityHalfLifeSeconds = 1.0f;
+    };
+
+    // ゲームのスレッドから見た数
+    struct Stats {
+        uint64_t playCount = 0;    // 鳴らした数 (奪って鳴らした数を含む)
+        uint64_t stealCount = 0;   // 他の声を奪って鳴らした数
+        uint64_t rejectCount = 0;  // 奪える声が無いので鳴らさなかった数
+        uint64_t culledCount = 0;  // 遠すぎるので鳴らさなかった数
+        uint64_t droppedCount = 0; // キューが満杯で送れなかったコマンドの数
+    };
+
+    // 奪われない優先度 (BGMなど)
+    static const uint8_t kMaxPriority = 255;
+
+    // レイテンシの記録の細かさと範囲
+    static const uint32_t kLatencyBucketMicroseconds = 50;
+    static const uint32_t kLatencyBucketCount = 1024;
+
+public:
+    VoicePool() = default;
+    VoicePool(const VoicePool&) = delete;
+    VoicePool& operator=(const VoicePool&) = delete;
+
+    // 初期化 (出力を始める前に呼ぶ)
+    void Initialize(const Settings& settings);
+
+    // 終了処理 (出力を止めてから呼ぶ)
+    void Finalize();
+
+    // --- ゲームのスレッド ---
+
+    // 再生 (鳴らさなかったときは kInvalidVoiceId)
+    // SoundClip は maxInstances を超えたら同じクリップの最も古い声を止めて鳴らす
+    VoiceId Play(const SoundClip* clip, const AudioPlayParams& params = {});
+    VoiceId Play(const AudioSource* source, const AudioPlayParams& params = {});
+
+    // 停止
+    void Stop(VoiceId voice);
+    void StopAll();
+
+    // 再生中の声の設定を変える
+    void SetVolume(VoiceId voice, float volume);
+    void SetPan(VoiceId voice, float pan);
+    void SetPitch(VoiceId voice, float pitch);
+    void SetMasterVolume(float volume);
+
+    // 再生中か (終わったことは Update で知る)
+    bool IsPlaying(VoiceId voice) const;
+    uint32_t GetActiveVoiceCount() const { return activeCount_; }
+
+    // 終わった声を回収する (毎フレーム呼ぶ)
+    void Update();
+
+    const Stats& GetStats() const { return stats_; }
+    const Settings& GetSettings() const { return settings_; }
+
+    // 距離による音量の倍率
+    float Attenuate(float distance) const;
+
+    // --- 出力のスレッド ---
+
+    // コマンドを反映し、frameCount フレームをステレオの float で output に書く
+    void Render(float* output, uint32_t frameCount);
+
+    // --- レイテンシ (Play から、それを反映したブロックを作り始めるまで。どのスレッドから読んでもよい) ---
+
+    // 記録した数
+    uint64_t GetLatencyCount() const;
+    // percentile (0～1) の位置のレイテンシ (マイクロ秒。記録の細かさ単位で切り上げ)
+    double GetLatencyPercentile(double percentile) const;
+    // 最大のレイテンシ (マイクロ秒)
+    double GetMaxLatency() const { return double(maxLatencyNanoseconds_.load(std::memory_order_relaxed)) / 1000.0; }
+    void ResetLatency();
+
+private:
+    // コマンドの種類
+    enum class CommandType : uint8_t {
+        kPlay,
+        kStop,
+        kStopAll,
+        kVolume,
+        kPan,
+        kPitch,
+        kMasterVolume,
+    };
+
+    // ゲームのスレッドから出力のスレッドへのコマンド
+    struct Command {
+        CommandType type = CommandType::kPlay;
+        bool fadeIn = false;
+        VoiceId voice = AudioMixer::kInvalidVoiceId;
+        const AudioSource* source = nullptr;
+        AudioPlayParams params;
+        float value = 0.0f;
+        int64_t timestamp = 0; // 送った時刻 (ナノ秒)
+    };
+
+    // ゲームのスレッドから見た声
+    struct Slot {
+        uint16_t generation = 0;
+        bool active = false;
+        const AudioSource* source = nullptr;
+        uint8_t priority = 0;
+        float attenuation = 1.0f; // 距離による倍率
+        float audibility = 0.0f;  // 聞こえる大きさ (音量 x 距離による倍率)
+        uint64_t order = 0;       // 鳴らした順番
+        int64_t startTime = 0;    // 鳴らした時刻 (ナノ秒)
+    };
+
+    VoiceId PlayWithLimit(const AudioSource* source, const AudioPlayParams& params, uint32_t maxInstances);
+    // 奪うときの優先度 (鳴らしてからの時間で下がる)
+    float GetStealPriority(const Slot& slot, int64_t now) const;
+    // 新しく鳴らす音 (priority, audibility) が、鳴っている声より強いか (同じなら新しい方を鳴らす)
+    bool IsStronger(uint8_t priority, float audibility, const Slot& slot, int64_t now) const;
+    Slot* FindSlot(VoiceId voice);
+    const Slot* FindSlot(VoiceId voice) const;
+    bool Send(const Command& command);
+    void Apply(const Command& command, int64_t now);
+    void RecordLatency(int64_t nanoseconds);
+    static int64_t NowNanoseconds();
+
+private:
+    Settings settings_;
+
+    // ゲームのスレッドだけが触る
+    std::vector<Slot> slots_;
+    uint32_t activeCount_ = 0;
+    uint64_t playOrder_ = 0;
+    Stats stats_;
+
+    // 出力のスレッドだけが触る
+    AudioMixer mixer_;
+    // キューが満杯で返せなかった終わった声 (声ごとに最新の世代だけ。次の Render で返し直す)
+    std::vector<VoiceId> pendingFinished_;
+    uint32_t pendingFinishedCount_ = 0;
+
+    // スレッドの間
+    SpscQueue<Command> commands_;
+    SpscQueue<VoiceId> finishedVoices_;
+    std::array<std::atomic<uint32_t>, kLatencyBucketCount + 1> latencyBuckets_{}; // 最後は範囲を超えた分
+    std::atomic<int64_t> maxLatencyNanoseconds_ = 0;
+};
@@ -0,0 +1,232 @@
+#include "WaveFile.h"
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#if defined(_WIN32)
+#include <Windows.h>
+#elif defined(__linux__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// fmt チャンクの形式タグ
+const uint16_t kFormatPcm = 0x0001;
+const uint16_t kFormatFloat = 0x0003;
+const uint16_t kFormatExtensible = 0xFFFE;
+
+uint16_t ReadU16(const uint8_t* bytes) {
+    return uint16_t(bytes[0] | (bytes[1] << 8));
+}
+
+uint32_t ReadU32(const uint8_t* bytes) {
+    return uint32_t(bytes[0]) | (uint32_t(bytes[1]) << 8) | (uint32_t(bytes[2]) << 16) | (uint32_t(bytes[3]) << 24);
+}
+
+bool SetError(std::string* error, const char* message) {
+    if (error != nullptr) {
+        *error = message;
+    }
+    return false;
+}
+
+// 1サンプルを -1～1 にする
+float DecodeSample(const uint8_t* sample, const WaveFormat& format) {
+    if (format.sampleType == WaveSampleType::kFloat) {
+        float value;
+        std::memcpy(&value, sample, sizeof(value));
+        return value;
+    }
+    switch (format.bitsPerSample) {
+    case 8:
+        return (float(sample[0]) - 128.0f) * (1.0f / 128.0f);
+    case 16:
+        return float(int16_t(ReadU16(sample))) * (1.0f / 32768.0f);
+    case 24:
+        // 上位24bitに詰めて算術シフトで符号を広げる
+        return float(int32_t((uint32_t(sample[0]) << 8) | (uint32_t(sample[1]) << 16) | (uint32_t(sample[2]) << 24)) >> 8) *
+               (1.0f / 8388608.0f);
+    default:
+        return float(int32_t(ReadU32(sample))) * (1.0f / 2147483648.0f);
+    }
+}
+
+} // namespace
+
+WaveFile::~WaveFile() {
+    Close();
+}
+
+bool WaveFile::Open(const std::string& filePath, std::string* error) {
+    Close();
+    filePath_ = filePath;
+#if defined(_WIN32)
+    HANDLE file = CreateFileW(std::filesystem::path(filePath).c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_RANDOM_ACCESS, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return SetError(error, "cannot open file");
+    }
+    LARGE_INTEGER fileSize{};
+    GetFileSizeEx(file, &fileSize);
+    HANDLE mapping = fileSize.QuadPart > 0 ? CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+    const void* view = mapping != nullptr ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+    fileHandle_ = file;
+    mappingHandle_ = mapping;
+    if (view == nullptr) {
+        Close();
+        return SetError(error, "cannot map file");
+    }
+    mappedView_ = view;
+    mappedSize_ = static_cast<size_t>(fileSize.QuadPart);
+#elif defined(__linux__) || defined(__APPLE__)
+    int file = open(filePath.c_str(), O_RDONLY | O_CLOEXEC);
+    if (file < 0) {
+        return SetError(error, "cannot open file");
+    }
+    struct stat status{};
+    void* view = MAP_FAILED;
+    if (fstat(file, &status) == 0 && status.st_size > 0) {
+        view = mmap(nullptr, static_cast<size_t>(status.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+    }
+    // マップした後はファイルを閉じてよい
+    close(file);
+    if (view == MAP_FAILED) {
+        return SetError(error, "cannot map file");
+    }
+    mappedView_ = view;
+    mappedSize_ = static_cast<size_t>(status.st_size);
+#else
+    std::ifstream file(std::filesystem::path(filePath), std::ios::binary);
+    if (!file) {
+        return SetError(error, "cannot open file");
+    }
+    fileBytes_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    mappedView_ = fileBytes_.data();
+    mappedSize_ = fileBytes_.size();
+#endif
+    if (!Parse(static_cast<const uint8_t*>(mappedView_), mappedSize_, error)) {
+        Close();
+        return false;
+    }
+    return true;
+}
+
+bool WaveFile::OpenMemory(const void* data, size_t size, std::string* error) {
+    Close();
+    return Parse(static_cast<const uint8_t*>(data), size, error);
+}
+
+void WaveFile::Close() {
+#if defined(_WIN32)
+    if (mappedView_ != nullptr && fileBytes_.empty()) {
+        UnmapViewOfFile(mappedView_);
+    }
+    if (mappingHandle_ != nullptr) {
+        CloseHandle(mappingHandle_);
+    }
+    if (fileHandle_ != nullptr) {
+        CloseHandle(fileHandle_);
+    }
+    fileHandle_ = nullptr;
+    mappingHandle_ = nullptr;
+#elif defined(__linux__) || defined(__APPLE__)
+    if (mappedView_ != nullptr && fileBytes_.empty()) {
+        munmap(const_cast<void*>(mappedView_), mappedSize_);
+    }
+#endif
+    mappedView_ = nullptr;
+    mappedSize_ = 0;
+    fileBytes_.clear();
+    filePath_.clear();
+    data_ = nullptr;
+    frameCount_ = 0;
+    format_ = {};
+}
+
+bool WaveFile::Parse(const uint8_t* bytes, size_t size, std::string* error) {
+    if (size < 12 || std::memcmp(bytes, "RIFF", 4) != 0 || std::memcmp(bytes + 8, "WAVE", 4) != 0) {
+        return SetError(error, "not a RIFF/WAVE file");
+    }
+    // RIFF のサイズが実際より大きいファイルもあるので、ファイルの終わりで打ち切る
+    size_t riffEnd = size_t(ReadU32(bytes + 4)) + 8;
+    size_t end = riffEnd < size ? riffEnd : size;
+
+    bool hasFormat = false;
+    const uint8_t* data = nullptr;
+    size_t dataSize = 0;
+    size_t offset = 12;
+    while (offset + 8 <= end) {
+        const uint8_t* chunk = bytes + offset;
+        size_t chunkSize = ReadU32(chunk + 4);
+        const uint8_t* body = chunk + 8;
+        size_t available = end - offset - 8;
+        if (std::memcmp(chunk, "fmt ", 4) == 0) {
+            if (chunkSize < 16 || chunkSize > available) {
+                return SetError(error, "broken fmt chunk");
+            }
+            uint16_t formatTag = ReadU16(body);
+            format_.channelCount = ReadU16(body + 2);
+            format_.sampleRate = ReadU32(body + 4);
+            format_.blockAlign = ReadU16(body + 12);
+            format_.bitsPerSample = ReadU16(body + 14);
+            // WAVE_FORMAT_EXTENSIBLE はサブフォーマットのGUIDの先頭2バイトが形式タグ
+            if (formatTag == kFormatExtensible && chunkSize >= 40) {
+                formatTag = ReadU16(body + 24);
+            }
+            if (formatTag == kFormatPcm) {
+                format_.sampleType = WaveSampleType::kInteger;
+            } else if (formatTag == kFormatFloat) {
+                format_.sampleType = WaveSampleType::kFloat;
+            } else {
+                return SetError(error, "unsupported format (compressed)");
+            }
+            hasFormat = true;
+        } else if (std::memcmp(chunk, "data", 4) == 0) {
+            data = body;
+            // 書き込み途中で切れたファイルは、ある分だけ使う
+            dataSize = chunkSize < available ? chunkSize : available;
+        }
+        // チャンクは2バイト境界に揃えてある
+        offset += 8 + chunkSize + (chunkSize & 1);
+    }
+
+    if (!hasFormat || data == nullptr) {
+        return SetError(error, "fmt or data chunk not found");
+    }
+    bool integerBits = format_.bitsPerSample == 8 || format_.bitsPerSample == 16 || format_.bitsPerSample == 24 ||
+                       format_.bitsPerSample == 32;
+    bool supported = format_.sampleType == WaveSampleType::kFloat ? format_.bitsPerSample == 32 : integerBits;
+    if (!supported || format_.channelCount == 0 || format_.sampleRate == 0 ||
+        format_.blockAlign < format_.channelCount * (format_.bitsPerSample / 8)) {
+        return SetError(error, "unsupported sample format");
+    }
+    data_ = data;
+    frameCount_ = dataSize / format_.blockAlign;
+    return true;
+}
+
+void WaveFile::DecodeStereo(uint64_t firstFrame, uint32_t frameCount, float* stereo) const {
+    if (firstFrame >= frameCount_) {
+        return;
+    }
+    uint64_t count = frameCount_ - firstFrame < frameCount ? frameCount_ - firstFrame : frameCount;
+    const uint8_t* frame = data_ + firstFrame * format_.blockAlign;
+    uint32_t rightOffset = format_.channelCount > 1 ? format_.bitsPerSample / 8 : 0;
+
+    // よく使う形式は変換を直接書く
+    if (format_.sampleType == WaveSampleType::kInteger && format_.bitsPerSample == 16 && format_.channelCount == 2 &&
+        format_.blockAlign == 4) {
+        for (uint64_t i = 0; i < count; ++i, frame += 4) {
+            stereo[i * 2 + 0] = float(int16_t(ReadU16(frame))) * (1.0f / 32768.0f);
+            stereo[i * 2 + 1] = float(int16_t(ReadU16(frame + 2))) * (1.0f / 32768.0f);
+        }
+        return;
+    }
+    for (uint64_t i = 0; i < count; ++i, frame += format_.blockAlign) {
+        stereo[i * 2 + 0] = DecodeSample(frame, format_);
+        stereo[i * 2 + 1] = DecodeSample(frame + rightOffset, format_);
+    }
+}
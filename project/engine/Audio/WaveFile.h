@@ -0,0 +1,74 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "AudioSource.h"
+
+// WAVのサンプルの形式
+enum class WaveSampleType : uint8_t {
+    kInteger, // 整数PCM (8bitは符号なし、それ以外は符号付き)
+    kFloat,   // 32bit浮動小数点
+};
+
+// WAVの fmt チャンクの内容
+struct WaveFormat {
+    WaveSampleType sampleType = WaveSampleType::kInteger;
+    uint16_t channelCount = 0;
+    uint32_t sampleRate = 0;
+    uint16_t bitsPerSample = 0;
+    uint16_t blockAlign = 0; // 1フレーム (全チャンネルの1サンプル) のバイト数
+};
+
+// WAVファイル (RIFF)
+// ファイルはメモリマップしたまま、data チャンクを必要な分だけ読んで float に変換する (全体を展開したコピーは作らない)
+// fmt と data 以外のチャンク (bext, LIST など) は読み飛ばす
+// 対応する形式: 8/16/24/32bit 整数PCM、32bit float (WAVE_FORMAT_EXTENSIBLE を含む)、1チャンネル以上
+class WaveFile : public AudioSource {
+public:
+    WaveFile() = default;
+    ~WaveFile() override;
+    WaveFile(const WaveFile&) = delete;
+    WaveFile& operator=(const WaveFile&) = delete;
+
+    // ファイルを開く (失敗したら error に理由を入れて false)
+    bool Open(const std::string& filePath, std::string* error = nullptr);
+
+    // メモリ上のWAVを使う (data は閉じるまで生きていること)
+    bool OpenMemory(const void* data, size_t size, std::string* error = nullptr);
+
+    // 閉じる
+    void Close();
+
+    // フレームをステレオの float (-1～1、LRの交互) に変換する
+    // モノラルは両方に同じ値を入れ、3チャンネル以上は最初の2チャンネルを使う。範囲外のフレームは書かない
+    void DecodeStereo(uint64_t firstFrame, uint32_t frameCount, float* stereo) const override;
+
+    uint64_t GetFrameCount() const override { return frameCount_; }
+    uint32_t GetSampleRate() const override { return format_.sampleRate; }
+
+    bool IsOpen() const { return data_ != nullptr; }
+    const WaveFormat& GetFormat() const { return format_; }
+    // 長さ (秒)
+    double GetDuration() const { return format_.sampleRate > 0 ? double(frameCount_) / format_.sampleRate : 0.0; }
+    const std::string& GetFilePath() const { return filePath_; }
+
+private:
+    bool Parse(const uint8_t* bytes, size_t size, std::string* error);
+
+private:
+    std::string filePath_;
+    WaveFormat format_;
+    const uint8_t* data_ = nullptr; // data チャンクの先頭
+    uint64_t frameCount_ = 0;
+
+    // メモリマップ
+    const void* mappedView_ = nullptr;
+    size_t mappedSize_ = 0;
+#if defined(_WIN32)
+    void* fileHandle_ = nullptr;
+    void* mappingHandle_ = nullptr;
+#endif
+    // メモリマップできない環境では読み込んだ内容をここに置く
+    std::vector<uint8_t> fileBytes_;
+};
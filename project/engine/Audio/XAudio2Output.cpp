@@ -0,0 +1,125 @@
+#include "AudioOutput.h"
+#if defined(_WIN32)
+#include <Windows.h>
+#include <wrl.h>
+#include <xaudio2.h>
+
+namespace {
+
+// ソースボイスに積んでおくバッファの数 (遅延は blockFrames * kBufferCount フレーム)
+const uint32_t kBufferCount = 3;
+
+class XAudio2Output : public AudioOutput, private IXAudio2VoiceCallback {
+public:
+    ~XAudio2Output() override { Stop(); }
+
+    bool Start(uint32_t sampleRate, uint32_t blockFrames, RenderCallback render) override {
+        Stop();
+        HRESULT hr = XAudio2Create(&xAudio2_, 0, XAUDIO2_DEFAULT_PROCESSOR);
+        if (SUCCEEDED(hr)) {
+            hr = xAudio2_->CreateMasteringVoice(&masteringVoice_);
+        }
+        if (SUCCEEDED(hr)) {
+            WAVEFORMATEX format{};
+            format.wFormatTag = WAVE_FORMAT_IEEE_FLOAT;
+            format.nChannels = 2;
+            format.nSamplesPerSec = sampleRate;
+            format.wBitsPerSample = 32;
+            format.nBlockAlign = format.nChannels * format.wBitsPerSample / 8;
+            format.nAvgBytesPerSec = format.nSamplesPerSec * format.nBlockAlign;
+            hr = xAudio2_->CreateSourceVoice(&sourceVoice_, &format, 0, XAUDIO2_DEFAULT_FREQ_RATIO, this);
+        }
+        if (FAILED(hr)) {
+            Stop();
+            return false;
+        }
+
+        blockFrames_ = blockFrames;
+        render_ = std::move(render);
+        for (std::vector<float>& buffer : buffers_) {
+            buffer.assign(size_t(blockFrames) * 2, 0.0f);
+        }
+        nextBuffer_ = 0;
+        bufferEndEvent_ = CreateEventW(nullptr, FALSE, FALSE, nullptr);
+        running_ = true;
+        thread_ = std::thread([this] { Run(); });
+        sourceVoice_->Start(0);
+        return true;
+    }
+
+    void Stop() override {
+        running_ = false;
+        if (bufferEndEvent_ != nullptr) {
+            SetEvent(bufferEndEvent_);
+        }
+        if (thread_.joinable()) {
+            thread_.join();
+        }
+        if (sourceVoice_ != nullptr) {
+            sourceVoice_->Stop(0);
+            sourceVoice_->DestroyVoice();
+            sourceVoice_ = nullptr;
+        }
+        if (masteringVoice_ != nullptr) {
+            masteringVoice_->DestroyVoice();
+            masteringVoice_ = nullptr;
+        }
+        xAudio2_.Reset();
+        if (bufferEndEvent_ != nullptr) {
+            CloseHandle(bufferEndEvent_);
+            bufferEndEvent_ = nullptr;
+        }
+    }
+
+    const char* GetName() const override { return "XAudio2"; }
+
+private:
+    // 再生し終わったバッファから順に次の音を作って積む
+    void Run() {
+        SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_HIGHEST);
+        while (running_) {
+            XAUDIO2_VOICE_STATE state{};
+            sourceVoice_->GetState(&state, XAUDIO2_VOICE_NOSAMPLESPLAYED);
+            for (uint32_t queued = state.BuffersQueued; queued < kBufferCount; ++queued) {
+                std::vector<float>& buffer = buffers_[nextBuffer_];
+                render_(buffer.data(), blockFrames_);
+                XAUDIO2_BUFFER submit{};
+                submit.AudioBytes = static_cast<UINT32>(sizeof(float) * buffer.size());
+                submit.pAudioData = reinterpret_cast<const BYTE*>(buffer.data());
+                sourceVoice_->SubmitSourceBuffer(&submit);
+                nextBuffer_ = (nextBuffer_ + 1) % kBufferCount;
+            }
+            WaitForSingleObject(bufferEndEvent_, 100);
+        }
+    }
+
+    // IXAudio2VoiceCallback (XAudio2 のスレッドから呼ばれる。ここでは待っているスレッドを起こすだけにする)
+    void STDMETHODCALLTYPE OnBufferEnd(void*) override { SetEvent(bufferEndEvent_); }
+    void STDMETHODCALLTYPE OnVoiceProcessingPassStart(UINT32) override {}
+    void STDMETHODCALLTYPE OnVoiceProcessingPassEnd() override {}
+    void STDMETHODCALLTYPE OnStreamEnd() override {}
+    void STDMETHODCALLTYPE OnBufferStart(void*) override {}
+    void STDMETHODCALLTYPE OnLoopEnd(void*) override {}
+    void STDMETHODCALLTYPE OnVoiceError(void*, HRESULT) override {}
+
+private:
+    Microsoft::WRL::ComPtr<IXAudio2> xAudio2_;
+    IXAudio2MasteringVoice* masteringVoice_ = nullptr;
+    IXAudio2SourceVoice* sourceVoice_ = nullptr;
+    HANDLE bufferEndEvent_ = nullptr;
+
+    uint32_t blockFrames_ = 0;
+    RenderCallback render_;
+    std::vector<float> buffers_[kBufferCount];
+    uint32_t nextBuffer_ = 0;
+    std::thread thread_;
+    std::atomic<bool> running_ = false;
+};
+
+} // namespace
+
+std::unique_ptr<AudioOutput> CreateXAudio2Output() {
+    return std::make_unique<XAudio2Output>();
+}
+
+#endif
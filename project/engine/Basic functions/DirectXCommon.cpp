@@ -1,26 +1,26 @@
 #include "DirectXCommon.h"
 #include "WinApp.h"
 #include "D3D12Util.h" 
+#include "MathUtil.h"
+#include "Logger.h"
+#include "CpuProfiler.h"
+#include "GpuProfiler.h"
+#include "UploadRing.h"
 #include <cassert>
-#include <format>
-#include <string>
-#include <fstream>
-#include <vector>
 
 #pragma comment(lib, "d3d12.lib")
 #pragma comment(lib, "dxgi.lib")
 #pragma comment(lib, "dxguid.lib")
 
-// main.cppで定義されている関数のプロトタイプ宣言
-std::string ConvertString(const std::wstring& str);
-void Log(std::ostream& os, const std::string& message);
-
 DirectXCommon* DirectXCommon::GetInstance() {
     static DirectXCommon instance;
     return &instance;
 }
 
-void DirectXCommon::Initialize(WinApp* winApp) {
+void DirectXCommon::Initialize(WinApp* winApp, const PresentSettings& presentSettings) {
+    assert(presentSettings.backBufferCount >= 2 && presentSettings.backBufferCount <= kMaxBackBufferCount);
+    presentSettings_ = presentSettings;
+    backBufferCount_ = presentSettings.backBufferCount;
 #ifdef _DEBUG
     Microsoft::WRL::ComPtr<ID3D12Debug1> debugController = nullptr;
     if (SUCCEEDED(D3D12GetDebugInterface(IID_PPV_ARGS(&debugController)))) {
@@ -54,8 +54,16 @@ void DirectXCommon::Initialize(WinApp* winApp) {
     CreateSwapChain(winApp);
     CreateRenderTarget();
     CreateDepthBuffer(winApp);
+    CreateSrvDescriptorHeap();
     CreateFence();
 
+    // GPUの区間の計測 (結果はフェンスが進んだ後のフレームで読む)
+    GpuProfiler::GetInstance()->Initialize(device_.Get(), commandQueue_.Get());
+
+    framePacer_.Initialize(&frameClock_, presentSettings_.targetFrameRate);
+    LogInfo(LogCategory::kGraphics, "Present: {}, {} buffers, max latency {}, fps limit {}", GetPresentModeName(presentSettings_.mode),
+        backBufferCount_, presentSettings_.maxFrameLatency, presentSettings_.targetFrameRate);
+
     // ビューポートとシザー矩形の設定
     viewport_.Width = static_cast<float>(winApp->kClientWidth);
     viewport_.Height = static_cast<float>(winApp->kClientHeight);
@@ -72,18 +80,37 @@ void DirectXCommon::Initialize(WinApp* winApp) {
 
 void DirectXCommon::Finalize() {
     // GPUの処理完了を待つ
-    commandQueue_->Signal(fence_.Get(), ++fenceValue_);
-    if (fence_->GetCompletedValue() < fenceValue_) {
-        fence_->SetEventOnCompletion(fenceValue_, fenceEvent_);
-        WaitForSingleObject(fenceEvent_, INFINITE);
-    }
+    WaitForGPU();
+    GpuProfiler::GetInstance()->Finalize();
     CloseHandle(fenceEvent_);
+    if (frameLatencyWaitableObject_ != nullptr) {
+        CloseHandle(frameLatencyWaitableObject_);
+        frameLatencyWaitableObject_ = nullptr;
+    }
+
+    // セッションのフレームの間隔
+    FrameTimeStats stats = framePacer_.GetStats();
+    LogInfo(LogCategory::kGraphics, "Frame time ({}): {} frames, avg {:.2f}ms, p50 {:.2f}ms, p99 {:.2f}ms, min {:.2f}ms, max {:.2f}ms",
+        GetPresentModeName(presentSettings_.mode), stats.frameCount, stats.averageMilliseconds, stats.p50Milliseconds,
+        stats.p99Milliseconds, stats.minMilliseconds, stats.maxMilliseconds);
 }
 
+void DirectXCommon::WaitForNextFrame() {
+    PROFILE_SCOPE("WaitForNextFrame");
+    if (frameLatencyWaitableObject_ != nullptr) {
+        // 表示の待ち行列が maxFrameLatency より短くなるまで待つ (入力を読むのをできるだけ遅らせる)
+        WaitForSingleObjectEx(frameLatencyWaitableObject_, 1000, TRUE);
+    }
+    framePacer_.BeginFrame();
+}
 
 void DirectXCommon::PreDraw() {
+    PROFILE_SCOPE("PreDraw");
     UINT backBufferIndex = swapChain_->GetCurrentBackBufferIndex();
 
+    // GPUが終えたフレームの計測結果を読み、このフレームの計測を始める
+    GpuProfiler::GetInstance()->BeginFrame(commandList_.Get(), fence_->GetCompletedValue());
+
     // TransitionBarrierの設定
     D3D12_RESOURCE_BARRIER barrier{};
     barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
@@ -99,18 +126,26 @@ void DirectXCommon::PreDraw() {
     D3D12_CPU_DESCRIPTOR_HANDLE dsvHandle = dsvDescriptorHeap_->GetCPUDescriptorHandleForHeapStart();
     commandList_->OMSetRenderTargets(1, &rtvHandles_[backBufferIndex], false, &dsvHandle);
 
-    // 指定した色で画面全体をクリアする
-    float clearColor[] = { 0.1f, 0.25f, 0.5f, 1.0f };
-    commandList_->ClearRenderTargetView(rtvHandles_[backBufferIndex], clearColor, 0, nullptr);
+    {
+        GPU_PROFILE_SCOPE(commandList_.Get(), "Clear");
+        // 指定した色で画面全体をクリアする
+        float clearColor[] = { 0.1f, 0.25f, 0.5f, 1.0f };
+        commandList_->ClearRenderTargetView(rtvHandles_[backBufferIndex], clearColor, 0, nullptr);
 
-    // 深度バッファをクリア
-    commandList_->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
+        // 深度バッファを最も奥の深度でクリア (逆Zなら0)
+        commandList_->ClearDepthStencilView(dsvHandle, D3D12_CLEAR_FLAG_DEPTH, kFarDepth, 0, 0, nullptr);
+    }
 
     commandList_->RSSetViewports(1, &viewport_);
     commandList_->RSSetScissorRects(1, &scissorRect_);
+
+    // 描画用のディスクリプタヒープを設定
+    ID3D12DescriptorHeap* descriptorHeaps[] = { srvDescriptorHeap_.Get() };
+    commandList_->SetDescriptorHeaps(1, descriptorHeaps);
 }
 
 void DirectXCommon::PostDraw() {
+    PROFILE_SCOPE("PostDraw");
     HRESULT hr;
     UINT backBufferIndex = swapChain_->GetCurrentBackBufferIndex();
 
@@ -123,33 +158,64 @@ void DirectXCommon::PostDraw() {
     barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_PRESENT;
     commandList_->ResourceBarrier(1, &barrier);
 
+    // GPUの計測のクエリを読み戻し用のバッファに解決する (このフレームの後に Signal するフェンスの値で読めるようになる)
+    GpuProfiler::GetInstance()->EndFrame(commandList_.Get(), fenceValue_ + 1);
+
     // コマンドリストをクローズ
     hr = commandList_->Close();
     assert(SUCCEEDED(hr));
 
     // GPUにコマンドリストの実行を行わせる
-    ID3D12CommandList* commandLists[] = { commandList_.Get() };
-    commandQueue_->ExecuteCommandLists(1, commandLists);
+    {
+        PROFILE_SCOPE("ExecuteCommandLists");
+        ID3D12CommandList* commandLists[] = { commandList_.Get() };
+        commandQueue_->ExecuteCommandLists(1, commandLists);
+    }
 
     // 画面に表示
-    swapChain_->Present(1, 0);
+    {
+        PROFILE_SCOPE("Present");
+        if (presentSettings_.mode == PresentMode::kTearing) {
+            swapChain_->Present(0, DXGI_PRESENT_ALLOW_TEARING);
+        } else {
+            swapChain_->Present(1, 0);
+        }
+    }
 
-    // Fenceの値を更新
+    // Fenceの値を更新し、このバックバッファのフレームの値として覚えておく
     fenceValue_++;
     commandQueue_->Signal(fence_.Get(), fenceValue_);
+    frameFenceValues_[backBufferIndex] = fenceValue_;
 
     // 次のフレームの準備
-    if (fence_->GetCompletedValue() < fenceValue_) {
-        fence_->SetEventOnCompletion(fenceValue_, fenceEvent_);
+    // 次のバックバッファ (とそのコマンドアロケータ) を前に使ったフレームが終わるまで待つ
+    // UploadRing などは kFrameLatency フレーム前の領域を再利用するので、バックバッファが多くてもそれ以上は先行させない
+    UINT nextBackBufferIndex = swapChain_->GetCurrentBackBufferIndex();
+    UINT64 waitValue = frameFenceValues_[nextBackBufferIndex];
+    const UINT64 kMaxFramesInFlight = UploadRing::kFrameLatency - 1;
+    if (fenceValue_ > kMaxFramesInFlight && waitValue < fenceValue_ - kMaxFramesInFlight) {
+        waitValue = fenceValue_ - kMaxFramesInFlight;
+    }
+    if (fence_->GetCompletedValue() < waitValue) {
+        PROFILE_SCOPE("WaitForGPU");
+        fence_->SetEventOnCompletion(waitValue, fenceEvent_);
         WaitForSingleObject(fenceEvent_, INFINITE);
     }
 
-    hr = commandAllocator_->Reset();
+    hr = commandAllocators_[nextBackBufferIndex]->Reset();
     assert(SUCCEEDED(hr));
-    hr = commandList_->Reset(commandAllocator_.Get(), nullptr);
+    hr = commandList_->Reset(commandAllocators_[nextBackBufferIndex].Get(), nullptr);
     assert(SUCCEEDED(hr));
 }
 
+void DirectXCommon::WaitForGPU() {
+    commandQueue_->Signal(fence_.Get(), ++fenceValue_);
+    if (fence_->GetCompletedValue() < fenceValue_) {
+        fence_->SetEventOnCompletion(fenceValue_, fenceEvent_);
+        WaitForSingleObject(fenceEvent_, INFINITE);
+    }
+}
+
 void DirectXCommon::CreateDevice() {
     HRESULT hr = CreateDXGIFactory(IID_PPV_ARGS(&dxgiFactory_));
     assert(SUCCEEDED(hr));
@@ -160,21 +226,23 @@ void DirectXCommon::CreateDevice() {
         hr = useAdapter->GetDesc3(&adapterDesc);
         assert(SUCCEEDED(hr));
         if (!(adapterDesc.Flags & DXGI_ADAPTER_FLAG_SOFTWARE)) {
-            // ログは省略 (本来はmainのlogStreamに書き込む)
+            LogInfo(LogCategory::kGraphics, "Use Adapter: {}", adapterDesc.Description);
             break;
         }
     }
     assert(useAdapter != nullptr);
 
     D3D_FEATURE_LEVEL featureLevels[] = { D3D_FEATURE_LEVEL_12_2, D3D_FEATURE_LEVEL_12_1, D3D_FEATURE_LEVEL_12_0 };
+    const char* featureLevelStrings[] = { "12.2", "12.1", "12.0" };
     for (size_t i = 0; i < _countof(featureLevels); ++i) {
         hr = D3D12CreateDevice(useAdapter.Get(), featureLevels[i], IID_PPV_ARGS(&device_));
         if (SUCCEEDED(hr)) {
-            // ログは省略 (本来はmainのlogStreamに書き込む)
+            LogInfo(LogCategory::kGraphics, "FeatureLevel: {}", featureLevelStrings[i]);
             break;
         }
     }
     assert(device_ != nullptr);
+    LogInfo(LogCategory::kGraphics, "Complete create D3D12Device");
 }
 
 void DirectXCommon::CreateCommandQueue() {
@@ -182,10 +250,14 @@ void DirectXCommon::CreateCommandQueue() {
     HRESULT hr = device_->CreateCommandQueue(&commandQueueDesc, IID_PPV_ARGS(&commandQueue_));
     assert(SUCCEEDED(hr));
 
-    hr = device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocator_));
-    assert(SUCCEEDED(hr));
+    // バックバッファごとに用意し、GPUがそのフレームを終えてからリセットする
+    for (UINT i = 0; i < backBufferCount_; ++i) {
+        hr = device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(&commandAllocators_[i]));
+        assert(SUCCEEDED(hr));
+    }
 
-    hr = device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocator_.Get(), nullptr, IID_PPV_ARGS(&commandList_));
+    // 最初のフレームはバックバッファの0番に描く
+    hr = device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, commandAllocators_[0].Get(), nullptr, IID_PPV_ARGS(&commandList_));
     assert(SUCCEEDED(hr));
 }
 
@@ -196,15 +268,37 @@ void DirectXCommon::CreateSwapChain(WinApp* winApp) {
     swapChainDesc.Format = DXGI_FORMAT_R8G8B8A8_UNORM;
     swapChainDesc.SampleDesc.Count = 1;
     swapChainDesc.BufferUsage = DXGI_USAGE_RENDER_TARGET_OUTPUT;
-    swapChainDesc.BufferCount = kBackBufferCount_;
+    swapChainDesc.BufferCount = backBufferCount_;
     swapChainDesc.SwapEffect = DXGI_SWAP_EFFECT_FLIP_DISCARD;
 
+    // 垂直同期を待たない表示はディスプレイとドライバーが対応しているときだけ
+    if (presentSettings_.mode == PresentMode::kTearing) {
+        BOOL allowTearing = FALSE;
+        HRESULT hr = dxgiFactory_->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allowTearing, sizeof(allowTearing));
+        if (FAILED(hr) || !allowTearing) {
+            LogWarning(LogCategory::kGraphics, "Tearing is not supported, falling back to vsync");
+            presentSettings_.mode = PresentMode::kVsync;
+        }
+    }
+    if (presentSettings_.mode == PresentMode::kTearing) {
+        swapChainDesc.Flags |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
+    } else if (presentSettings_.mode == PresentMode::kLowLatency) {
+        swapChainDesc.Flags |= DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+    }
+
     HRESULT hr = dxgiFactory_->CreateSwapChainForHwnd(commandQueue_.Get(), winApp->GetHwnd(), &swapChainDesc, nullptr, nullptr, reinterpret_cast<IDXGISwapChain1**>(swapChain_.GetAddressOf()));
     assert(SUCCEEDED(hr));
+
+    if (presentSettings_.mode == PresentMode::kLowLatency) {
+        hr = swapChain_->SetMaximumFrameLatency(presentSettings_.maxFrameLatency);
+        assert(SUCCEEDED(hr));
+        frameLatencyWaitableObject_ = swapChain_->GetFrameLatencyWaitableObject();
+        assert(frameLatencyWaitableObject_ != nullptr);
+    }
 }
 
 void DirectXCommon::CreateRenderTarget() {
-    rtvDescriptorHeap_ = CreateDescriptorHeap(device_.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, kBackBufferCount_, false);
+    rtvDescriptorHeap_ = CreateDescriptorHeap(device_.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV, backBufferCount_, false);
 
     rtvDesc_.Format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
     rtvDesc_.ViewDimension = D3D12_RTV_DIMENSION_TEXTURE2D;
@@ -212,7 +306,7 @@ void DirectXCommon::CreateRenderTarget() {
     D3D12_CPU_DESCRIPTOR_HANDLE rtvStartHandle = rtvDescriptorHeap_->GetCPUDescriptorHandleForHeapStart();
     UINT descriptorSize = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
 
-    for (UINT i = 0; i < kBackBufferCount_; ++i) {
+    for (UINT i = 0; i < backBufferCount_; ++i) {
         HRESULT hr = swapChain_->GetBuffer(i, IID_PPV_ARGS(&backBuffers_[i]));
         assert(SUCCEEDED(hr));
 
@@ -227,12 +321,17 @@ void DirectXCommon::CreateDepthBuffer(WinApp* winApp) {
     dsvDescriptorHeap_ = CreateDescriptorHeap(device_.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 1, false);
 
     D3D12_DEPTH_STENCIL_VIEW_DESC dsvDesc{};
-    dsvDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+    dsvDesc.Format = kDepthFormat;
     dsvDesc.ViewDimension = D3D12_DSV_DIMENSION_TEXTURE2D;
 
     device_->CreateDepthStencilView(depthStencilResource_.Get(), &dsvDesc, dsvDescriptorHeap_->GetCPUDescriptorHandleForHeapStart());
 }
 
+void DirectXCommon::CreateSrvDescriptorHeap() {
+    srvDescriptorHeap_ = CreateDescriptorHeap(device_.Get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, kMaxSRVCount, true);
+    srvDescriptorSize_ = device_->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
+
 void DirectXCommon::CreateFence() {
     HRESULT hr = device_->CreateFence(fenceValue_, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&fence_));
     assert(SUCCEEDED(hr));
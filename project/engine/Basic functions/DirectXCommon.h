@@ -2,6 +2,8 @@
 #include <d3d12.h>
 #include <dxgi1_6.h>
 #include <wrl.h>
+#include <cstdint>
+#include "FramePacer.h"
 
 // 前方宣言
 class WinApp;
@@ -13,17 +15,25 @@ public:
     static DirectXCommon* GetInstance();
 
     // 初期化
-    void Initialize(WinApp* winApp);
+    void Initialize(WinApp* winApp, const PresentSettings& presentSettings = PresentSettings());
 
     // 終了処理
     void Finalize();
 
+    // フレームの始まり (入力を読む前に呼ぶ)
+    // kLowLatency なら表示の待ち行列が空くまで待ち、上限のフレームレートがあればそれに合わせて待つ
+    void WaitForNextFrame();
+
     // 描画前処理
     void PreDraw();
 
     // 描画後処理
+    // 次のバックバッファを前に使ったフレームが終わるまでだけ待つ (GPUは前のフレームを実行したまま次のフレームを記録する)
     void PostDraw();
 
+    // GPUが全てのコマンドを終えるまで待つ (リソースをまとめて解放する前に呼ぶ)
+    void WaitForGPU();
+
     // ゲッター
     ID3D12Device* GetDevice() const { return device_.Get(); }
     ID3D12GraphicsCommandList* GetCommandList() const { return commandList_.Get(); }
@@ -31,7 +41,16 @@ public:
     IDXGISwapChain4* GetSwapChain() const { return swapChain_.Get(); }
     ID3D12DescriptorHeap* GetRtvDescriptorHeap() const { return rtvDescriptorHeap_.Get(); }
     D3D12_RENDER_TARGET_VIEW_DESC GetRtvDesc() const { return rtvDesc_; }
-    UINT GetBackBufferCount() const { return kBackBufferCount_; }
+    UINT GetBackBufferCount() const { return backBufferCount_; }
+    ID3D12DescriptorHeap* GetSrvDescriptorHeap() const { return srvDescriptorHeap_.Get(); }
+    uint32_t GetSrvDescriptorSize() const { return srvDescriptorSize_; }
+    // 実際に使っている画面への出し方 (tearing に対応していなければ vsync になっている)
+    const PresentSettings& GetPresentSettings() const { return presentSettings_; }
+    FramePacer& GetFramePacer() { return framePacer_; }
+
+public:
+    // SRVディスクリプタの最大数 (0番はImGui用に予約)
+    static const uint32_t kMaxSRVCount = 512;
 
 
 private:
@@ -45,28 +64,40 @@ private:
     void CreateSwapChain(WinApp* winApp);
     void CreateRenderTarget();
     void CreateDepthBuffer(WinApp* winApp);
+    void CreateSrvDescriptorHeap();
     void CreateFence();
 
 private:
     Microsoft::WRL::ComPtr<IDXGIFactory7> dxgiFactory_;
     Microsoft::WRL::ComPtr<ID3D12Device> device_;
     Microsoft::WRL::ComPtr<ID3D12CommandQueue> commandQueue_;
-    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandAllocator_;
     Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> commandList_;
     Microsoft::WRL::ComPtr<IDXGISwapChain4> swapChain_;
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> rtvDescriptorHeap_;
     Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> dsvDescriptorHeap_;
     Microsoft::WRL::ComPtr<ID3D12Resource> depthStencilResource_;
+    Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> srvDescriptorHeap_;
+    uint32_t srvDescriptorSize_ = 0;
 
-    static const UINT kBackBufferCount_ = 2;
-    Microsoft::WRL::ComPtr<ID3D12Resource> backBuffers_[kBackBufferCount_];
-    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandles_[kBackBufferCount_];
+    static const UINT kMaxBackBufferCount = 4;
+    UINT backBufferCount_ = 2;
+    Microsoft::WRL::ComPtr<ID3D12Resource> backBuffers_[kMaxBackBufferCount];
+    D3D12_CPU_DESCRIPTOR_HANDLE rtvHandles_[kMaxBackBufferCount];
     D3D12_RENDER_TARGET_VIEW_DESC rtvDesc_{};
+    // バックバッファごとのコマンドアロケータと、そこに記録したフレームの後に Signal したフェンスの値
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> commandAllocators_[kMaxBackBufferCount];
+    UINT64 frameFenceValues_[kMaxBackBufferCount] = {};
 
     Microsoft::WRL::ComPtr<ID3D12Fence> fence_;
     UINT64 fenceValue_ = 0;
     HANDLE fenceEvent_ = nullptr;
 
+    // 画面への出し方とフレームの間隔
+    PresentSettings presentSettings_;
+    HANDLE frameLatencyWaitableObject_ = nullptr;
+    SystemFrameClock frameClock_;
+    FramePacer framePacer_;
+
     D3D12_VIEWPORT viewport_{};
     D3D12_RECT scissorRect_{};
 };
\ No newline at end of file
@@ -0,0 +1,188 @@
+#include "FramePacer.h"
+#include <cassert>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+#if defined(_WIN32)
+#include <Windows.h>
+#pragma comment(lib, "winmm.lib")
+#endif
+
+namespace {
+
+// 残りがこれより短ければ眠らずに回して待つ (眠ると OS の刻みの分だけ寝過ごすことがある)
+const int64_t kSpinNanoseconds = 2000000;
+
+// "--key=value" の value を符号なしの整数として読む
+bool ParseUnsigned(const std::string& value, uint32_t minimum, uint32_t maximum, uint32_t* out) {
+    char* end = nullptr;
+    unsigned long number = std::strtoul(value.c_str(), &end, 10);
+    if (value.empty() || *end != '\0' || number < minimum || number > maximum) {
+        return false;
+    }
+    *out = static_cast<uint32_t>(number);
+    return true;
+}
+
+} // namespace
+
+bool ParsePresentSettings(const std::string& commandLine, PresentSettings* settings, std::string* error) {
+    size_t position = 0;
+    while (position < commandLine.size()) {
+        size_t end = commandLine.find(' ', position);
+        if (end == std::string::npos) {
+            end = commandLine.size();
+        }
+        std::string token = commandLine.substr(position, end - position);
+        position = end + 1;
+        size_t equal = token.find('=');
+        if (token.compare(0, 2, "--") != 0 || equal == std::string::npos) {
+            continue;
+        }
+        std::string key = token.substr(2, equal - 2);
+        std::string value = token.substr(equal + 1);
+        bool valid = true;
+        if (key == "present") {
+            if (value == "vsync") {
+                settings->mode = PresentMode::kVsync;
+            } else if (value == "tearing") {
+                settings->mode = PresentMode::kTearing;
+            } else if (value == "lowlatency") {
+                settings->mode = PresentMode::kLowLatency;
+            } else {
+                valid = false;
+            }
+        } else if (key == "buffers") {
+            valid = ParseUnsigned(value, 2, 4, &settings->backBufferCount);
+        } else if (key == "latency") {
+            valid = ParseUnsigned(value, 1, 3, &settings->maxFrameLatency);
+        } else if (key == "fps") {
+            uint32_t frameRate = 0;
+            valid = ParseUnsigned(value, 0, 1000, &frameRate);
+            settings->targetFrameRate = frameRate;
+        }
+        if (!valid) {
+            if (error != nullptr) {
+                *error = "invalid value: " + token;
+            }
+            return false;
+        }
+    }
+    return true;
+}
+
+const char* GetPresentModeName(PresentMode mode) {
+    switch (mode) {
+    case PresentMode::kVsync:
+        return "vsync";
+    case PresentMode::kTearing:
+        return "tearing";
+    case PresentMode::kLowLatency:
+        return "lowlatency";
+    }
+    return "unknown";
+}
+
+SystemFrameClock::SystemFrameClock() {
+#if defined(_WIN32)
+    // Sleep の刻みを 1ms にする (既定の 15.6ms だと待ちの精度が足りない)
+    timeBeginPeriod(1);
+#endif
+}
+
+SystemFrameClock::~SystemFrameClock() {
+#if defined(_WIN32)
+    timeEndPeriod(1);
+#endif
+}
+
+int64_t SystemFrameClock::Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void SystemFrameClock::SleepUntil(int64_t time) {
+    int64_t remaining = time - Now();
+    if (remaining > kSpinNanoseconds) {
+        std::this_thread::sleep_for(std::chrono::nanoseconds(remaining - kSpinNanoseconds));
+    }
+    while (Now() < time) {
+        std::this_thread::yield();
+    }
+}
+
+void FramePacer::Initialize(FrameClock* clock, double targetFrameRate) {
+    assert(clock != nullptr);
+    clock_ = clock;
+    SetTargetFrameRate(targetFrameRate);
+    lastFrameStart_ = 0;
+    ResetStats();
+}
+
+void FramePacer::SetTargetFrameRate(double targetFrameRate) {
+    targetFrameRate_ = targetFrameRate > 0.0 ? targetFrameRate : 0.0;
+    interval_ = targetFrameRate_ > 0.0 ? static_cast<int64_t>(1e9 / targetFrameRate_) : 0;
+    nextFrameTime_ = 0;
+}
+
+void FramePacer::BeginFrame() {
+    int64_t now = clock_->Now();
+    if (interval_ > 0) {
+        if (nextFrameTime_ == 0 || now - nextFrameTime_ > interval_) {
+            // 最初のフレームか、1フレーム分以上遅れた (予定を付け直す)
+            nextFrameTime_ = now;
+        } else if (now < nextFrameTime_) {
+            clock_->SleepUntil(nextFrameTime_);
+            now = clock_->Now();
+        }
+        nextFrameTime_ += interval_;
+    }
+
+    if (lastFrameStart_ != 0) {
+        int64_t frameTime = now - lastFrameStart_;
+        lastFrameMilliseconds_ = double(frameTime) / 1e6;
+        int64_t bucket = frameTime / kBucketNanoseconds;
+        ++buckets_[bucket < kBucketCount ? static_cast<size_t>(bucket) : kBucketCount - 1];
+        minNanoseconds_ = frameCount_ == 0 || frameTime < minNanoseconds_ ? frameTime : minNanoseconds_;
+        maxNanoseconds_ = frameCount_ == 0 || frameTime > maxNanoseconds_ ? frameTime : maxNanoseconds_;
+        totalNanoseconds_ += frameTime;
+        ++frameCount_;
+    }
+    lastFrameStart_ = now;
+}
+
+FrameTimeStats FramePacer::GetStats() const {
+    FrameTimeStats stats;
+    stats.frameCount = frameCount_;
+    if (frameCount_ == 0) {
+        return stats;
+    }
+    stats.averageMilliseconds = double(totalNanoseconds_) / double(frameCount_) / 1e6;
+    stats.minMilliseconds = double(minNanoseconds_) / 1e6;
+    stats.maxMilliseconds = double(maxNanoseconds_) / 1e6;
+    // 箱の真ん中の値を使う (最小と最大の間に収める)
+    auto percentile = [this](double fraction) {
+        uint64_t target = static_cast<uint64_t>(fraction * double(frameCount_ - 1)) + 1;
+        uint64_t count = 0;
+        for (uint32_t i = 0; i < kBucketCount; ++i) {
+            count += buckets_[i];
+            if (count >= target) {
+                int64_t middle = i * kBucketNanoseconds + kBucketNanoseconds / 2;
+                middle = middle < minNanoseconds_ ? minNanoseconds_ : middle > maxNanoseconds_ ? maxNanoseconds_ : middle;
+                return double(middle) / 1e6;
+            }
+        }
+        return double(maxNanoseconds_) / 1e6;
+    };
+    stats.p50Milliseconds = percentile(0.50);
+    stats.p99Milliseconds = percentile(0.99);
+    return stats;
+}
+
+void FramePacer::ResetStats() {
+    buckets_.assign(kBucketCount, 0);
+    frameCount_ = 0;
+    totalNanoseconds_ = 0;
+    minNanoseconds_ = 0;
+    maxNanoseconds_ = 0;
+    lastFrameMilliseconds_ = 0.0;
+}
@@ -0,0 +1,100 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 画面への出し方
+enum class PresentMode : uint8_t {
+    kVsync,      // 垂直同期を待つ (DXGI の待ち行列は既定の深さ)
+    kTearing,    // 垂直同期を待たない (計測用。対応していない環境では kVsync になる)
+    kLowLatency, // 垂直同期を待ち、待機可能なスワップチェーンで待ち行列を maxFrameLatency フレームに抑える
+};
+
+// 画面への出し方の設定
+struct PresentSettings {
+    PresentMode mode = PresentMode::kLowLatency;
+    uint32_t backBufferCount = 2; // 2～4
+    uint32_t maxFrameLatency = 1; // kLowLatency で GPU に出しておくフレームの上限 (1～3)
+    double targetFrameRate = 0.0; // 1秒あたりのフレームの上限 (0 なら制限しない。kTearing で使う)
+};
+
+// "--present=vsync|tearing|lowlatency --buffers=3 --latency=1 --fps=240" の形の引数を settings に反映する
+// 知らない引数は無視し、値が正しくなければ false を返して error に理由を入れる
+bool ParsePresentSettings(const std::string& commandLine, PresentSettings* settings, std::string* error);
+
+const char* GetPresentModeName(PresentMode mode);
+
+// フレームの時間の集計
+struct FrameTimeStats {
+    uint64_t frameCount = 0;
+    double averageMilliseconds = 0.0;
+    double minMilliseconds = 0.0;
+    double maxMilliseconds = 0.0;
+    double p50Milliseconds = 0.0;
+    double p99Milliseconds = 0.0;
+};
+
+// フレームの間隔を測る時計 (計測ではシミュレーションの時計に差し替える)
+class FrameClock {
+public:
+    virtual ~FrameClock() = default;
+
+    // 今の時刻 (ナノ秒)
+    virtual int64_t Now() = 0;
+
+    // time (ナノ秒) まで待つ
+    virtual void SleepUntil(int64_t time) = 0;
+};
+
+// steady_clock の時計 (残りが短くなったら回して待ち、寝過ごさないようにする)
+class SystemFrameClock : public FrameClock {
+public:
+    SystemFrameClock();
+    ~SystemFrameClock() override;
+
+    int64_t Now() override;
+    void SleepUntil(int64_t time) override;
+};
+
+// フレームの間隔の制御と集計
+// 上限のフレームレートがあれば、フレームの始まりを一定の間隔に揃えるまで待つ (待ち時間は前の予定の時刻から数えるので、ずれが溜まらない)
+// 1フレーム分以上遅れたときは予定を今に付け直し、遅れを取り戻そうとして短いフレームが続かないようにする
+// フレームの間隔はセッションの間の分布 (10µs 刻み) に溜め、中央値と99%の値を出す
+class FramePacer {
+public:
+    // clock は FramePacer より長く生きていること
+    void Initialize(FrameClock* clock, double targetFrameRate = 0.0);
+
+    // 上限のフレームレート (0 なら制限しない)
+    void SetTargetFrameRate(double targetFrameRate);
+    double GetTargetFrameRate() const { return targetFrameRate_; }
+
+    // フレームの始まり (上限があれば待つ)。前のフレームの始まりからの間隔を集計に足す
+    void BeginFrame();
+
+    // これまでのフレームの間隔
+    FrameTimeStats GetStats() const;
+    // 前のフレームの間隔
+    double GetLastFrameMilliseconds() const { return lastFrameMilliseconds_; }
+
+    void ResetStats();
+
+private:
+    // 分布の刻み (ナノ秒) と、刻みで数える上限 (超えたものは最後の箱に入れる)
+    static const int64_t kBucketNanoseconds = 10000;
+    static const uint32_t kBucketCount = 10000;
+
+private:
+    FrameClock* clock_ = nullptr;
+    double targetFrameRate_ = 0.0;
+    int64_t interval_ = 0;     // 0 なら制限しない
+    int64_t nextFrameTime_ = 0; // 次のフレームを始める予定の時刻
+    int64_t lastFrameStart_ = 0;
+    double lastFrameMilliseconds_ = 0.0;
+
+    std::vector<uint32_t> buckets_;
+    uint64_t frameCount_ = 0;
+    int64_t totalNanoseconds_ = 0;
+    int64_t minNanoseconds_ = 0;
+    int64_t maxNanoseconds_ = 0;
+};
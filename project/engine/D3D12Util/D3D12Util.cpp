@@ -1,8 +1,44 @@
 #include "D3D12Util.h"
+#include "MathUtil.h"
+#include "TextureCooker.h"
+#include "TextureDecoder.h"
 #include <cassert>
+#include <cstdio>
+#include <cstring>
 
-// 外部で定義された関数のプロトタイプ宣言 (ConvertStringはまだmain.cppにあるため)
-std::wstring ConvertString(const std::string& str);
+namespace {
+
+// TGA 以外の形式は WIC で読み、sRGB の RGBA8 にそろえる (DecodeTexture に渡すデコーダー)
+bool DecodeWicImage(const std::vector<uint8_t>& fileData, uint32_t& width, uint32_t& height, std::vector<uint8_t>& pixels,
+    std::string* error)
+{
+    DirectX::ScratchImage image{};
+    HRESULT hr = DirectX::LoadFromWICMemory(fileData.data(), fileData.size(), DirectX::WIC_FLAGS_FORCE_SRGB, nullptr, image);
+    if (SUCCEEDED(hr) && image.GetMetadata().format != DXGI_FORMAT_R8G8B8A8_UNORM_SRGB) {
+        DirectX::ScratchImage converted{};
+        hr = DirectX::Convert(image.GetImages(), image.GetImageCount(), image.GetMetadata(), DXGI_FORMAT_R8G8B8A8_UNORM_SRGB,
+            DirectX::TEX_FILTER_DEFAULT, DirectX::TEX_THRESHOLD_DEFAULT, converted);
+        image = std::move(converted);
+    }
+    if (FAILED(hr)) {
+        if (error != nullptr) {
+            char text[32];
+            std::snprintf(text, sizeof(text), "WIC hr=0x%08lx", static_cast<unsigned long>(hr));
+            *error = text;
+        }
+        return false;
+    }
+    const DirectX::Image* source = image.GetImage(0, 0, 0);
+    width = static_cast<uint32_t>(source->width);
+    height = static_cast<uint32_t>(source->height);
+    pixels.resize(size_t(width) * height * 4);
+    for (uint32_t y = 0; y < height; ++y) {
+        std::memcpy(pixels.data() + size_t(y) * width * 4, source->pixels + y * source->rowPitch, size_t(width) * 4);
+    }
+    return true;
+}
+
+} // namespace
 
 Microsoft::WRL::ComPtr<ID3D12Resource> CreateBufferResource(ID3D12Device* device, size_t sizeInBytes)
 {
@@ -59,48 +95,52 @@ Microsoft::WRL::ComPtr<ID3D12Resource> CreateDepthStencilTextureResource(ID3D12D
     resourceDesc.Height = height;
     resourceDesc.MipLevels = 1;
     resourceDesc.DepthOrArraySize = 1;
-    resourceDesc.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+    resourceDesc.Format = kDepthFormat;
     resourceDesc.SampleDesc.Count = 1;
     resourceDesc.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
     resourceDesc.Flags = D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
     D3D12_HEAP_PROPERTIES heapProperties{};
     heapProperties.Type = D3D12_HEAP_TYPE_DEFAULT;
     D3D12_CLEAR_VALUE depthClearValue{};
-    depthClearValue.DepthStencil.Depth = 1.0f;
-    depthClearValue.Format = DXGI_FORMAT_D24_UNORM_S8_UINT;
+    depthClearValue.DepthStencil.Depth = kFarDepth;
+    depthClearValue.Format = kDepthFormat;
     Microsoft::WRL::ComPtr<ID3D12Resource> resource = nullptr;
     HRESULT hr = device->CreateCommittedResource(&heapProperties, D3D12_HEAP_FLAG_NONE, &resourceDesc, D3D12_RESOURCE_STATE_DEPTH_WRITE, &depthClearValue, IID_PPV_ARGS(&resource));
     assert(SUCCEEDED(hr));
     return resource.Get();
 }
 
-Microsoft::WRL::ComPtr<ID3D12Resource> UploadTextureData(ID3D12Resource* texture, const DirectX::ScratchImage& mipImages, ID3D12Device* device, ID3D12GraphicsCommandList* commandList)
+bool LoadTexture(const std::string& filePath, DirectX::ScratchImage& image, std::string* error)
 {
-    std::vector<D3D12_SUBRESOURCE_DATA> subresources;
-    DirectX::PrepareUpload(device, mipImages.GetImages(), mipImages.GetImageCount(), mipImages.GetMetadata(), subresources);
-    uint64_t intermediateSize = GetRequiredIntermediateSize(texture, 0, static_cast<UINT>(subresources.size()));
-    Microsoft::WRL::ComPtr<ID3D12Resource> intermediate = CreateBufferResource(device, intermediateSize);
-    UpdateSubresources(commandList, texture, intermediate.Get(), 0, 0, static_cast<UINT>(subresources.size()), subresources.data());
-    D3D12_RESOURCE_BARRIER barrier = {};
-    barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
-    barrier.Transition.pResource = texture;
-    barrier.Transition.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST;
-    barrier.Transition.StateAfter = D3D12_RESOURCE_STATE_GENERIC_READ;
-    barrier.Transition.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES;
-    commandList->ResourceBarrier(1, &barrier);
-    return intermediate;
-}
+    image.Release();
+    // クック済みのDDSがあればミップ生成せずにそのまま使う
+    std::filesystem::path cookedPath = FindCookedTexture(filePath);
+    if (!cookedPath.empty() && SUCCEEDED(DirectX::LoadFromDDSFile(cookedPath.c_str(), DirectX::DDS_FLAGS_NONE, nullptr, image))) {
+        return true;
+    }
 
-DirectX::ScratchImage LoadTexture(const std::string& filePath)
-{
-    DirectX::ScratchImage image{};
-    std::wstring filePathW = ConvertString(filePath);
-    HRESULT hr = DirectX::LoadFromWICFile(filePathW.c_str(), DirectX::WIC_FLAGS_FORCE_SRGB, nullptr, image);
-    assert(SUCCEEDED(hr));
-    DirectX::ScratchImage mipImages{};
-    hr = DirectX::GenerateMipMaps(image.GetImages(), image.GetImageCount(), image.GetMetadata(), DirectX::TEX_FILTER_SRGB, 0, mipImages);
-    assert(SUCCEEDED(hr));
-    return mipImages;
+    // デコードとミップ生成は TextureStreamBench と同じ関数で行う
+    DecodedTexture texture;
+    if (!DecodeTexture(filePath, &DecodeWicImage, texture, error)) {
+        return false;
+    }
+    const MipLevel& top = texture.mipLevels.front();
+    HRESULT hr = image.Initialize2D(DXGI_FORMAT_R8G8B8A8_UNORM_SRGB, top.width, top.height, 1, texture.mipLevels.size());
+    if (FAILED(hr)) {
+        if (error != nullptr) {
+            *error = "cannot allocate " + filePath;
+        }
+        return false;
+    }
+    for (size_t mip = 0; mip < texture.mipLevels.size(); ++mip) {
+        const DirectX::Image* destination = image.GetImage(mip, 0, 0);
+        const MipLevel& level = texture.mipLevels[mip];
+        for (uint32_t y = 0; y < level.height; ++y) {
+            std::memcpy(destination->pixels + y * destination->rowPitch, level.pixels.data() + size_t(y) * level.width * 4,
+                size_t(level.width) * 4);
+        }
+    }
+    return true;
 }
 
 D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandle(ID3D12DescriptorHeap* descriptorHeap, uint32_t descriptorSize, uint32_t index)
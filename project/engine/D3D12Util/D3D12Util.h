@@ -14,15 +14,15 @@ Microsoft::WRL::ComPtr<ID3D12DescriptorHeap> CreateDescriptorHeap(ID3D12Device*
 // Textureリソース作成
 Microsoft::WRL::ComPtr<ID3D12Resource> CreateTextureResource(ID3D12Device* device, const DirectX::TexMetadata& metadata);
 
-// 深度ステンシルTextureリソース作成
-Microsoft::WRL::ComPtr<ID3D12Resource> CreateDepthStencilTextureResource(ID3D12Device* device, int32_t width, int32_t height);
+// 深度バッファのフォーマット (逆Zで奥まで精度が出るよう浮動小数点にする)
+const DXGI_FORMAT kDepthFormat = DXGI_FORMAT_D32_FLOAT;
 
-// Textureデータをアップロード
-[[nodiscard]]
-Microsoft::WRL::ComPtr<ID3D12Resource> UploadTextureData(ID3D12Resource* texture, const DirectX::ScratchImage& mipImages, ID3D12Device* device, ID3D12GraphicsCommandList* commandList);
+// 深度ステンシルTextureリソース作成 (kDepthFormat。kFarDepth でクリアする)
+Microsoft::WRL::ComPtr<ID3D12Resource> CreateDepthStencilTextureResource(ID3D12Device* device, int32_t width, int32_t height);
 
-// Texture読み込み
-DirectX::ScratchImage LoadTexture(const std::string& filePath);
+// Texture読み込み (クック済みのDDSがあればそちらを使う。無ければ DecodeTexture でデコードし、ミップ生成は呼んだスレッドだけで行う)
+// 読めなかったら false を返し、error に理由を書く (image は空のまま)
+bool LoadTexture(const std::string& filePath, DirectX::ScratchImage& image, std::string* error = nullptr);
 
 // ディスクリプタハンドルの取得
 D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandle(ID3D12DescriptorHeap* descriptorHeap, uint32_t descriptorSize, uint32_t index);
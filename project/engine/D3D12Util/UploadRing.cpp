@@ -0,0 +1,71 @@
+#include "UploadRing.h"
+#include <cassert>
+#include "D3D12Util.h"
+
+namespace {
+
+const uint64_t kMaxAlignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+
+uint64_t AlignUp(uint64_t value, uint64_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+} // namespace
+
+void UploadRing::Initialize(ID3D12Device* device, uint64_t sizeInBytes) {
+    size_ = AlignUp(sizeInBytes, kMaxAlignment);
+    resource_ = CreateBufferResource(device, size_);
+    // アップロードヒープは最後までマップしたままでよい
+    HRESULT hr = resource_->Map(0, nullptr, reinterpret_cast<void**>(&mappedData_));
+    assert(SUCCEEDED(hr));
+    gpuAddress_ = resource_->GetGPUVirtualAddress();
+    head_ = 0;
+    tail_ = 0;
+    frameCount_ = 0;
+    for (uint64_t& frameStart : frameStarts_) {
+        frameStart = 0;
+    }
+}
+
+void UploadRing::Finalize() {
+    if (resource_ != nullptr) {
+        resource_->Unmap(0, nullptr);
+    }
+    resource_.Reset();
+    mappedData_ = nullptr;
+}
+
+void UploadRing::BeginFrame() {
+    // 今のフレームの場所には kFrameLatency フレーム前の始まりが入っている。それより前は使い終わっている
+    uint32_t slot = static_cast<uint32_t>(frameCount_ % kFrameLatency);
+    frameStarts_[slot] = head_;
+    tail_ = frameStarts_[(slot + 1) % kFrameLatency];
+    ++frameCount_;
+}
+
+bool UploadRing::Allocate(uint64_t sizeInBytes, uint64_t alignment, Allocation& allocation) {
+    assert(alignment != 0 && alignment <= kMaxAlignment && (alignment & (alignment - 1)) == 0);
+    uint64_t offset = AlignUp(head_, alignment);
+    // 終わりをまたぐなら先頭に折り返す
+    if (offset % size_ + sizeInBytes > size_) {
+        offset = (offset / size_ + 1) * size_;
+    }
+    if (offset + sizeInBytes - tail_ > size_) {
+        return false;
+    }
+    head_ = offset + sizeInBytes;
+    allocation.offset = offset % size_;
+    allocation.cpuAddress = mappedData_ + allocation.offset;
+    allocation.gpuAddress = gpuAddress_ + allocation.offset;
+    return true;
+}
+
+uint64_t UploadRing::GetFreeSize() const {
+    uint64_t free = size_ - (head_ - tail_);
+    // 空きが終わりで折り返しているなら、終わりまでと先頭からの大きい方
+    uint64_t toEnd = size_ - head_ % size_;
+    if (free <= toEnd) {
+        return free;
+    }
+    return toEnd > free - toEnd ? toEnd : free - toEnd;
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl.h>
+#include <cstdint>
+
+// 毎フレーム書き換えるデータ用のリングバッファ (アップロードヒープ)
+// 作成時に一度だけマップし、フレームごとに先頭から順に切り出す
+// kFrameLatency フレーム前までに切り出した領域はGPUが使い終わっているとみなして再利用する
+class UploadRing {
+public:
+    // GPUが読んでいる可能性のあるフレーム数 (今のフレームを含む)
+    static const uint32_t kFrameLatency = 3;
+
+    // 切り出した領域
+    struct Allocation {
+        void* cpuAddress = nullptr;
+        D3D12_GPU_VIRTUAL_ADDRESS gpuAddress = 0;
+        uint64_t offset = 0; // バッファの先頭からのバイト数
+    };
+
+public:
+    // 初期化 (sizeInBytes は 256 の倍数に切り上げる)
+    void Initialize(ID3D12Device* device, uint64_t sizeInBytes);
+
+    // 終了処理
+    void Finalize();
+
+    // フレームの先頭で呼ぶ (kFrameLatency フレーム前の領域を解放する)
+    void BeginFrame();
+
+    // 領域を切り出す (alignment は 256 以下の2のべき。空きが足りなければ false)
+    // 書き込み結合メモリなので、書くだけにして読み返さないこと
+    bool Allocate(uint64_t sizeInBytes, uint64_t alignment, Allocation& allocation);
+
+    // このフレームで使える残りのバイト数 (折り返しで詰められない分は含まない)
+    uint64_t GetFreeSize() const;
+
+    ID3D12Resource* GetResource() const { return resource_.Get(); }
+    uint64_t GetSize() const { return size_; }
+
+private:
+    Microsoft::WRL::ComPtr<ID3D12Resource> resource_;
+    uint8_t* mappedData_ = nullptr;
+    D3D12_GPU_VIRTUAL_ADDRESS gpuAddress_ = 0;
+    uint64_t size_ = 0;
+
+    // 先頭からの通算のバイト数 (実際の位置は size_ で割った余り)
+    uint64_t head_ = 0;                       // 次に切り出す位置
+    uint64_t tail_ = 0;                       // GPUが使っているかもしれない最も古い位置
+    uint64_t frameStarts_[kFrameLatency] = {}; // フレームごとの切り出し始めの位置
+    uint64_t frameCount_ = 0;
+};
@@ -0,0 +1,126 @@
+#include "DebugDraw.h"
+#include <cassert>
+#include <cstring>
+#include "MathUtil.h"
+#include "PipelinePresets.h"
+
+namespace {
+
+const uint64_t kLineBytes = sizeof(DebugVertex) * 2;
+
+// パイプラインを要求して定数バッファの番号を引く
+template <class Pipeline>
+void RequestPipeline(Pipeline& pipeline, const PipelineDesc& desc, const char* constantsName) {
+    PipelineLibrary* pipelineLibrary = PipelineLibrary::GetInstance();
+    pipeline.handle = pipelineLibrary->Request(desc);
+    pipeline.constantsRootIndex = pipelineLibrary->GetRootParameterIndex(pipeline.handle, constantsName);
+    assert(pipeline.handle == PipelineLibrary::kInvalidHandle || pipeline.constantsRootIndex != UINT32_MAX);
+}
+
+} // namespace
+
+DebugDraw* DebugDraw::GetInstance() {
+    static DebugDraw instance;
+    return &instance;
+}
+
+void DebugDraw::Initialize(ID3D12Device* device, uint32_t maxLinesPerFrame) {
+    // GPUが読んでいるフレームの分も含めて確保する (定数バッファの分を少し足す)
+    uint64_t frameSize = kLineBytes * maxLinesPerFrame + D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT * 4;
+    ring_.Initialize(device, frameSize * UploadRing::kFrameLatency);
+
+    // 深度テストありの線分は深度を書かない (半透明の線分どうしで隠し合わないように)
+    RequestPipeline(depthTestedPipeline_, MakePrimitivePipelineDesc(DepthMode::kReadOnly), "ViewProjection");
+    RequestPipeline(overlayPipeline_, MakePrimitivePipelineDesc(DepthMode::kNone), "ViewProjection");
+    for (int srgbOutput = 0; srgbOutput < 2; ++srgbOutput) {
+        RequestPipeline(screenPipelines_[srgbOutput], MakeShapePipelineDesc(srgbOutput != 0, TopologyType::kLine), "cbuff0");
+    }
+}
+
+void DebugDraw::Finalize() {
+    ring_.Finalize();
+}
+
+void DebugDraw::BeginFrame() {
+    ring_.BeginFrame();
+}
+
+void DebugDraw::Render(ID3D12GraphicsCommandList* commandList, const Matrix4x4& view, const Matrix4x4& projection, float screenWidth,
+    float screenHeight, bool srgbOutput) {
+    stats_ = {};
+    list_.Collect();
+
+    bool has3D = list_.GetVertexCount(DebugDrawCategory::kDepthTested) > 0 || list_.GetVertexCount(DebugDrawCategory::kOverlay) > 0;
+    if (has3D) {
+        UploadRing::Allocation constants;
+        if (ring_.Allocate(sizeof(ViewProjection), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, constants)) {
+            ViewProjection viewProjection;
+            viewProjection.view = view;
+            viewProjection.projection = projection;
+            Matrix4x4 cameraMatrix = Inverse(view);
+            viewProjection.cameraPos = { cameraMatrix.m[3][0], cameraMatrix.m[3][1], cameraMatrix.m[3][2] };
+            std::memcpy(constants.cpuAddress, &viewProjection, sizeof(viewProjection));
+            DrawCategory(commandList, DebugDrawCategory::kDepthTested, depthTestedPipeline_, constants);
+            DrawCategory(commandList, DebugDrawCategory::kOverlay, overlayPipeline_, constants);
+        } else {
+            stats_.droppedCount +=
+                (list_.GetVertexCount(DebugDrawCategory::kDepthTested) + list_.GetVertexCount(DebugDrawCategory::kOverlay)) / 2;
+        }
+    }
+
+    if (list_.GetVertexCount(DebugDrawCategory::kScreen) > 0) {
+        UploadRing::Allocation constants;
+        if (ring_.Allocate(sizeof(ShapeConstants), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, constants)) {
+            ShapeConstants shapeConstants;
+            shapeConstants.mat = MakeOrthographicMatrix(0.0f, 0.0f, screenWidth, screenHeight, 0.0f, 1.0f);
+            std::memcpy(constants.cpuAddress, &shapeConstants, sizeof(shapeConstants));
+            DrawCategory(commandList, DebugDrawCategory::kScreen, screenPipelines_[srgbOutput ? 1 : 0], constants);
+        } else {
+            stats_.droppedCount += list_.GetVertexCount(DebugDrawCategory::kScreen) / 2;
+        }
+    }
+
+    list_.EndFrame();
+}
+
+void DebugDraw::DrawCategory(ID3D12GraphicsCommandList* commandList, DebugDrawCategory category, const Pipeline& pipeline,
+    const UploadRing::Allocation& constants) {
+    uint32_t lineCount = list_.GetVertexCount(category) / 2;
+    if (lineCount == 0) {
+        return;
+    }
+    PipelineLibrary* pipelineLibrary = PipelineLibrary::GetInstance();
+    ID3D12PipelineState* pipelineState = pipelineLibrary->GetPipelineState(pipeline.handle);
+    if (pipelineState == nullptr) {
+        return;
+    }
+
+    // 入りきらなければ空いている分だけ描く
+    uint32_t maxLines = lineCount;
+    UploadRing::Allocation vertexAllocation;
+    if (!ring_.Allocate(kLineBytes * maxLines, sizeof(float), vertexAllocation)) {
+        uint64_t freeSize = ring_.GetFreeSize();
+        maxLines = static_cast<uint32_t>(freeSize > sizeof(float) ? (freeSize - sizeof(float)) / kLineBytes : 0);
+        if (maxLines == 0 || !ring_.Allocate(kLineBytes * maxLines, sizeof(float), vertexAllocation)) {
+            stats_.droppedCount += lineCount;
+            return;
+        }
+    }
+    uint32_t vertexCount = list_.Write(category, static_cast<DebugVertex*>(vertexAllocation.cpuAddress), maxLines * 2);
+
+    D3D12_VERTEX_BUFFER_VIEW vertexBufferView{};
+    vertexBufferView.BufferLocation = vertexAllocation.gpuAddress;
+    vertexBufferView.SizeInBytes = static_cast<UINT>(sizeof(DebugVertex) * vertexCount);
+    vertexBufferView.StrideInBytes = sizeof(DebugVertex);
+
+    commandList->SetGraphicsRootSignature(pipelineLibrary->GetRootSignature(pipeline.handle));
+    commandList->SetPipelineState(pipelineState);
+    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_LINELIST);
+    commandList->IASetVertexBuffers(0, 1, &vertexBufferView);
+    commandList->SetGraphicsRootConstantBufferView(pipeline.constantsRootIndex, constants.gpuAddress);
+    commandList->DrawInstanced(vertexCount, 1, 0, 0);
+
+    stats_.lineCount += vertexCount / 2;
+    stats_.droppedCount += lineCount - vertexCount / 2;
+    ++stats_.drawCount;
+}
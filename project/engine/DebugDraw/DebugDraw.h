@@ -0,0 +1,83 @@
+#pragma once
+#include <d3d12.h>
+#include <cstdint>
+#include "DebugDrawList.h"
+#include "MathTypes.h"
+#include "PipelineLibrary.h"
+#include "UploadRing.h"
+
+// デバッグ表示の線分の描画クラス (Primitive / Shape のシェーダー)
+// GetList() に足した線分を Render で種類ごとに1回ずつ描く (3Dは深度テストありと常に手前の2回、2Dは1回)
+// 線分はどのスレッドからでも足せる。Render は足しているスレッドがいないときに呼ぶこと
+class DebugDraw {
+public:
+    // 1フレームに描ける線分数の初期値
+    static const uint32_t kDefaultMaxLines = 200000;
+
+    // 直前の Render の結果
+    struct Stats {
+        uint32_t lineCount = 0;    // 描いた線分の数
+        uint32_t droppedCount = 0; // リングに入りきらずに描かなかった数
+        uint32_t drawCount = 0;    // 描画コマンドの数
+    };
+
+public:
+    // シングルトンインスタンスの取得
+    static DebugDraw* GetInstance();
+
+    // 初期化
+    void Initialize(ID3D12Device* device, uint32_t maxLinesPerFrame = kDefaultMaxLines);
+
+    // 終了処理
+    void Finalize();
+
+    // フレームの先頭で呼ぶ (GPUが使い終わったリングの領域を再利用する)
+    void BeginFrame();
+
+    // 線分を足す先
+    DebugDrawList& GetList() { return list_; }
+
+    // 溜めた線分を描き、このフレームの線分を捨てる (レンダーターゲットと深度バッファを設定した後に呼ぶ)
+    // 2Dの座標は左上が原点のピクセル。srgbOutput はsRGBでないレンダーターゲットにガンマをかけて書く
+    void Render(ID3D12GraphicsCommandList* commandList, const Matrix4x4& view, const Matrix4x4& projection, float screenWidth,
+        float screenHeight, bool srgbOutput = false);
+
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    DebugDraw() = default;
+    ~DebugDraw() = default;
+    DebugDraw(const DebugDraw&) = delete;
+    const DebugDraw& operator=(const DebugDraw&) = delete;
+
+    // Primitive.hlsli の ViewProjection
+    struct ViewProjection {
+        Matrix4x4 view;
+        Matrix4x4 projection;
+        Vector3 cameraPos;
+    };
+
+    // Shape.hlsli の cbuff0
+    struct ShapeConstants {
+        Matrix4x4 mat;
+    };
+
+    // パイプライン1つ分 (ルートパラメータはリフレクションで決まるので名前で引いておく)
+    struct Pipeline {
+        PipelineLibrary::Handle handle = PipelineLibrary::kInvalidHandle;
+        uint32_t constantsRootIndex = 0;
+    };
+
+    // 1種類分の頂点をリングに書いて描く
+    void DrawCategory(ID3D12GraphicsCommandList* commandList, DebugDrawCategory category, const Pipeline& pipeline,
+        const UploadRing::Allocation& constants);
+
+private:
+    DebugDrawList list_;
+    UploadRing ring_;
+
+    Pipeline depthTestedPipeline_;
+    Pipeline overlayPipeline_;
+    Pipeline screenPipelines_[2]; // [srgbOutput]
+    Stats stats_;
+};
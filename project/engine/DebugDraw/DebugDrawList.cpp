@@ -0,0 +1,282 @@
+#include "DebugDrawList.h"
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include "MathUtil.h"
+
+namespace {
+
+// リストの番号 (0 はキャッシュが空の印)
+std::atomic<uint64_t> gNextListId{ 1 };
+
+uint32_t ToByte(float value) {
+    value = value < 0.0f ? 0.0f : (value > 1.0f ? 1.0f : value);
+    return static_cast<uint32_t>(value * 255.0f + 0.5f);
+}
+
+// 行ベクトルの位置を変換して w で割る
+Vector3 TransformCoord(const Vector3& v, const Matrix4x4& matrix) {
+    const float(*m)[4] = matrix.m;
+    float x = v.x * m[0][0] + v.y * m[1][0] + v.z * m[2][0] + m[3][0];
+    float y = v.x * m[0][1] + v.y * m[1][1] + v.z * m[2][1] + m[3][1];
+    float z = v.x * m[0][2] + v.y * m[1][2] + v.z * m[2][2] + m[3][2];
+    float w = v.x * m[0][3] + v.y * m[1][3] + v.z * m[2][3] + m[3][3];
+    float inverseW = w != 0.0f ? 1.0f / w : 0.0f;
+    return { x * inverseW, y * inverseW, z * inverseW };
+}
+
+// 箱の8頂点 (ビットで x, y, z の最小・最大を選ぶ) の12辺
+const uint8_t kBoxEdges[12][2] = {
+    { 0, 1 }, { 2, 3 }, { 4, 5 }, { 6, 7 }, // x方向
+    { 0, 2 }, { 1, 3 }, { 4, 6 }, { 5, 7 }, // y方向
+    { 0, 4 }, { 1, 5 }, { 2, 6 }, { 3, 7 }, // z方向
+};
+
+void WriteBox(DebugVertex* out, const Vector3 (&corners)[8], uint32_t color) {
+    for (const uint8_t(&edge)[2] : kBoxEdges) {
+        *out++ = { corners[edge[0]], color };
+        *out++ = { corners[edge[1]], color };
+    }
+}
+
+} // namespace
+
+DebugDrawList::DebugDrawList() : id_(gNextListId.fetch_add(1, std::memory_order_relaxed)) {}
+
+DebugDrawList::~DebugDrawList() {
+    ThreadBuffer* buffer = threadBuffers_.load(std::memory_order_acquire);
+    while (buffer != nullptr) {
+        ThreadBuffer* next = buffer->next;
+        delete buffer;
+        buffer = next;
+    }
+}
+
+DebugDrawList::ThreadBuffer* DebugDrawList::GetThreadBuffer() {
+    // 直前に使ったリストの置き場を覚えておく (ほとんどはここで返る。EndFrame で返した置き場は使わない)
+    thread_local uint64_t cachedListId = 0;
+    thread_local uint64_t cachedFrame = 0;
+    thread_local ThreadBuffer* cachedBuffer = nullptr;
+    if (cachedListId == id_ && cachedFrame == frame_) {
+        return cachedBuffer;
+    }
+
+    // リストは先頭に足すだけで、リストが無くなるまで外さないので、ロックなしでたどれる
+    // このフレームに借りた置き場があればそれを使い、無ければ空いている置き場を借りる
+    std::thread::id self = std::this_thread::get_id();
+    ThreadBuffer* buffer = nullptr;
+    for (ThreadBuffer* it = threadBuffers_.load(std::memory_order_acquire); it != nullptr; it = it->next) {
+        if (it->owner.load(std::memory_order_relaxed) == self) {
+            buffer = it;
+            break;
+        }
+    }
+    for (ThreadBuffer* it = threadBuffers_.load(std::memory_order_acquire); it != nullptr && buffer == nullptr; it = it->next) {
+        std::thread::id none;
+        if (it->owner.load(std::memory_order_relaxed) == none &&
+            it->owner.compare_exchange_strong(none, self, std::memory_order_acquire, std::memory_order_relaxed)) {
+            buffer = it;
+        }
+    }
+    if (buffer == nullptr) {
+        buffer = new ThreadBuffer();
+        buffer->owner.store(self, std::memory_order_relaxed);
+        ThreadBuffer* head = threadBuffers_.load(std::memory_order_relaxed);
+        do {
+            buffer->next = head;
+        } while (!threadBuffers_.compare_exchange_weak(head, buffer, std::memory_order_release, std::memory_order_relaxed));
+    }
+    cachedListId = id_;
+    cachedFrame = frame_;
+    cachedBuffer = buffer;
+    return buffer;
+}
+
+DebugVertex* DebugDrawList::Append(DebugDrawCategory category, uint32_t frames, uint32_t lineCount) {
+    ThreadBuffer* buffer = GetThreadBuffer();
+    uint32_t index = static_cast<uint32_t>(category);
+    std::vector<DebugVertex>& vertices = frames <= 1 ? buffer->vertices[index] : buffer->persistents[index];
+    size_t start = vertices.size();
+    vertices.resize(start + size_t(lineCount) * 2);
+    if (frames > 1) {
+        buffer->frames[index].insert(buffer->frames[index].end(), lineCount, frames);
+    }
+    return vertices.data() + start;
+}
+
+void DebugDrawList::Line(const Vector3& start, const Vector3& end, const Vector4& color, const DebugDrawOptions& options) {
+    DebugVertex* out = Append(GetCategory(options), options.frames, 1);
+    uint32_t packedColor = PackColor(color);
+    out[0] = { start, packedColor };
+    out[1] = { end, packedColor };
+}
+
+void DebugDrawList::Aabb(const Vector3& min, const Vector3& max, const Vector4& color, const DebugDrawOptions& options) {
+    Vector3 corners[8];
+    for (uint32_t i = 0; i < 8; ++i) {
+        corners[i] = { (i & 1) ? max.x : min.x, (i & 2) ? max.y : min.y, (i & 4) ? max.z : min.z };
+    }
+    WriteBox(Append(GetCategory(options), options.frames, 12), corners, PackColor(color));
+}
+
+void DebugDrawList::Sphere(const Vector3& center, float radius, const Vector4& color, uint32_t segments, const DebugDrawOptions& options) {
+    assert(segments >= 3);
+    DebugVertex* out = Append(GetCategory(options), options.frames, segments * 3);
+    uint32_t packedColor = PackColor(color);
+    // 1区間分の回転を繰り返して円周上の点を求める (点ごとに sin/cos を呼ばない)
+    float stepCos = std::cos(6.2831853f / float(segments));
+    float stepSin = std::sin(6.2831853f / float(segments));
+    for (uint32_t axis = 0; axis < 3; ++axis) {
+        float c = radius;
+        float s = 0.0f;
+        Vector3 previous{};
+        for (uint32_t i = 0; i <= segments; ++i) {
+            // 最後の点は最初の点に戻す (誤差で閉じなくならないように)
+            float pc = i == segments ? radius : c;
+            float ps = i == segments ? 0.0f : s;
+            Vector3 point = axis == 0 ? Vector3{ center.x, center.y + pc, center.z + ps }
+                          : axis == 1 ? Vector3{ center.x + ps, center.y, center.z + pc }
+                                      : Vector3{ center.x + pc, center.y + ps, center.z };
+            if (i > 0) {
+                *out++ = { previous, packedColor };
+                *out++ = { point, packedColor };
+            }
+            previous = point;
+            float nextC = c * stepCos - s * stepSin;
+            s = s * stepCos + c * stepSin;
+            c = nextC;
+        }
+    }
+}
+
+void DebugDrawList::Frustum(const Matrix4x4& viewProjection, const Vector4& color, const DebugDrawOptions& options) {
+    Matrix4x4 inverse = Inverse(viewProjection);
+    Vector3 corners[8];
+    for (uint32_t i = 0; i < 8; ++i) {
+        Vector3 ndc = { (i & 1) ? 1.0f : -1.0f, (i & 2) ? 1.0f : -1.0f, (i & 4) ? 1.0f : 0.0f };
+        corners[i] = TransformCoord(ndc, inverse);
+    }
+    WriteBox(Append(GetCategory(options), options.frames, 12), corners, PackColor(color));
+}
+
+void DebugDrawList::Grid(const Vector3& center, float size, uint32_t divisions, const Vector4& color, const DebugDrawOptions& options) {
+    assert(divisions > 0);
+    DebugVertex* out = Append(GetCategory(options), options.frames, (divisions + 1) * 2);
+    uint32_t packedColor = PackColor(color);
+    float half = size * 0.5f;
+    float step = size / float(divisions);
+    for (uint32_t i = 0; i <= divisions; ++i) {
+        float offset = -half + step * float(i);
+        *out++ = { { center.x + offset, center.y, center.z - half }, packedColor };
+        *out++ = { { center.x + offset, center.y, center.z + half }, packedColor };
+        *out++ = { { center.x - half, center.y, center.z + offset }, packedColor };
+        *out++ = { { center.x + half, center.y, center.z + offset }, packedColor };
+    }
+}
+
+void DebugDrawList::Line2D(const Vector2& start, const Vector2& end, const Vector4& color, const DebugDrawOptions& options) {
+    DebugVertex* out = Append(DebugDrawCategory::kScreen, options.frames, 1);
+    uint32_t packedColor = PackColor(color);
+    out[0] = { { start.x, start.y, 0.0f }, packedColor };
+    out[1] = { { end.x, end.y, 0.0f }, packedColor };
+}
+
+void DebugDrawList::Rect2D(const Vector2& min, const Vector2& max, const Vector4& color, const DebugDrawOptions& options) {
+    DebugVertex* out = Append(DebugDrawCategory::kScreen, options.frames, 4);
+    uint32_t packedColor = PackColor(color);
+    Vector3 corners[4] = { { min.x, min.y, 0.0f }, { max.x, min.y, 0.0f }, { max.x, max.y, 0.0f }, { min.x, max.y, 0.0f } };
+    for (uint32_t i = 0; i < 4; ++i) {
+        *out++ = { corners[i], packedColor };
+        *out++ = { corners[(i + 1) % 4], packedColor };
+    }
+}
+
+void DebugDrawList::Collect() {
+    // 残す線分だけ自分の置き場に移す (このフレームだけの線分は Write でスレッドの置き場から直接書く)
+    for (ThreadBuffer* buffer = threadBuffers_.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next) {
+        for (uint32_t index = 0; index < kCategoryCount; ++index) {
+            std::vector<DebugVertex>& vertices = buffer->persistents[index];
+            if (vertices.empty()) {
+                continue;
+            }
+            PersistentStore& store = persistents_[index];
+            store.vertices.insert(store.vertices.end(), vertices.begin(), vertices.end());
+            for (uint32_t frames : buffer->frames[index]) {
+                store.expireFrames.push_back(frame_ + frames);
+            }
+            vertices.clear();
+            buffer->frames[index].clear();
+        }
+    }
+}
+
+uint32_t DebugDrawList::GetVertexCount(DebugDrawCategory category) const {
+    uint32_t index = static_cast<uint32_t>(category);
+    size_t count = persistents_[index].vertices.size();
+    for (ThreadBuffer* buffer = threadBuffers_.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next) {
+        count += buffer->vertices[index].size();
+    }
+    return static_cast<uint32_t>(count);
+}
+
+uint32_t DebugDrawList::Write(DebugDrawCategory category, DebugVertex* destination, uint32_t maxVertices) const {
+    uint32_t index = static_cast<uint32_t>(category);
+    // 線分の途中で切れないように偶数にする
+    maxVertices &= ~1u;
+    uint32_t written = 0;
+    auto copy = [&](const std::vector<DebugVertex>& vertices) {
+        uint32_t count = static_cast<uint32_t>(vertices.size());
+        if (count > maxVertices - written) {
+            count = maxVertices - written;
+        }
+        if (count == 0) {
+            return;
+        }
+        std::memcpy(destination + written, vertices.data(), sizeof(DebugVertex) * count);
+        written += count;
+    };
+    copy(persistents_[index].vertices);
+    for (ThreadBuffer* buffer = threadBuffers_.load(std::memory_order_acquire); buffer != nullptr && written < maxVertices;
+         buffer = buffer->next) {
+        copy(buffer->vertices[index]);
+    }
+    return written;
+}
+
+void DebugDrawList::EndFrame() {
+    // 置き場を返してもらう (残す線分が Collect されずに残っていても、次に借りたスレッドが後ろに足すだけ)
+    for (ThreadBuffer* buffer = threadBuffers_.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next) {
+        for (std::vector<DebugVertex>& vertices : buffer->vertices) {
+            vertices.clear();
+        }
+        buffer->owner.store(std::thread::id(), std::memory_order_relaxed);
+    }
+    ++frame_;
+
+    // 期限の来た線分を詰める
+    for (PersistentStore& store : persistents_) {
+        size_t kept = 0;
+        for (size_t line = 0; line < store.expireFrames.size(); ++line) {
+            if (store.expireFrames[line] > frame_) {
+                store.expireFrames[kept] = store.expireFrames[line];
+                store.vertices[kept * 2] = store.vertices[line * 2];
+                store.vertices[kept * 2 + 1] = store.vertices[line * 2 + 1];
+                ++kept;
+            }
+        }
+        store.expireFrames.resize(kept);
+        store.vertices.resize(kept * 2);
+    }
+}
+
+uint32_t DebugDrawList::PackColor(const Vector4& color) {
+    return ToByte(color.x) | (ToByte(color.y) << 8) | (ToByte(color.z) << 16) | (ToByte(color.w) << 24);
+}
+
+uint32_t DebugDrawList::GetThreadBufferCount() const {
+    uint32_t count = 0;
+    for (ThreadBuffer* buffer = threadBuffers_.load(std::memory_order_acquire); buffer != nullptr; buffer = buffer->next) {
+        ++count;
+    }
+    return count;
+}
@@ -0,0 +1,111 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "MathTypes.h"
+
+// デバッグ表示の線分の頂点 (色は R8G8B8A8_UNORM)
+struct DebugVertex {
+    Vector3 position;
+    uint32_t color;
+};
+
+// 線分の描き方の種類 (種類ごとに1回の描画になる)
+enum class DebugDrawCategory : uint8_t {
+    kDepthTested, // 3D・深度テストあり
+    kOverlay,     // 3D・常に手前
+    kScreen,      // 2D (左上が原点のピクセル)
+    kCount,
+};
+
+// 線分を足すときの指定
+struct DebugDrawOptions {
+    bool depthTest = true; // 3Dのときだけ使う
+    uint32_t frames = 0;   // 0 と 1 はこのフレームだけ。2 以上はそのフレーム数の間出し続ける
+};
+
+// デバッグ表示の線分を溜めるリスト
+// 線分はどのスレッドからでもロックなしで足せる (スレッドごとの置き場に書き、まとめるときに集める)
+// 置き場はフレームごとに足したスレッドへ貸し、EndFrame で返してもらう (フレームごとにスレッドを立て直しても増え続けない)
+// フレームの流れ:
+//   1. 各スレッドが Line などで足す
+//   2. 足し終わった後にメインスレッドで Collect する (足しているスレッドがいないこと。ジョブの待ち合わせの後に呼ぶ)
+//   3. GetVertexCount と Write で種類ごとに頂点を書き出す
+//   4. EndFrame でこのフレームの線分を捨て、期限の来た残す線分を消す
+// GPUに依存しない
+class DebugDrawList {
+public:
+    static const uint32_t kCategoryCount = static_cast<uint32_t>(DebugDrawCategory::kCount);
+
+public:
+    DebugDrawList();
+    ~DebugDrawList();
+    DebugDrawList(const DebugDrawList&) = delete;
+    const DebugDrawList& operator=(const DebugDrawList&) = delete;
+
+    // 3D (options.depthTest で深度テストの有無を選ぶ)
+    void Line(const Vector3& start, const Vector3& end, const Vector4& color, const DebugDrawOptions& options = {});
+    void Aabb(const Vector3& min, const Vector3& max, const Vector4& color, const DebugDrawOptions& options = {});
+    // 3軸それぞれの周りの円で表す
+    void Sphere(const Vector3& center, float radius, const Vector4& color, uint32_t segments = 16, const DebugDrawOptions& options = {});
+    // viewProjection の逆行列で錐台の8頂点を求める (深度は 0～1)
+    void Frustum(const Matrix4x4& viewProjection, const Vector4& color, const DebugDrawOptions& options = {});
+    // XZ平面の格子 (center を中心に一辺 size を divisions 分割する)
+    void Grid(const Vector3& center, float size, uint32_t divisions, const Vector4& color, const DebugDrawOptions& options = {});
+
+    // 2D (options.depthTest は使わない)
+    void Line2D(const Vector2& start, const Vector2& end, const Vector4& color, const DebugDrawOptions& options = {});
+    void Rect2D(const Vector2& min, const Vector2& max, const Vector4& color, const DebugDrawOptions& options = {});
+
+    // 各スレッドが足した線分を集める (メインスレッドで、足しているスレッドがいないときに呼ぶ)
+    void Collect();
+
+    // Collect の後に呼ぶ。種類ごとの頂点数 (線分数の2倍)
+    uint32_t GetVertexCount(DebugDrawCategory category) const;
+
+    // Collect の後に呼ぶ。種類ごとの頂点を destination に書き、書いた数を返す (maxVertices を超える分は書かない)
+    uint32_t Write(DebugDrawCategory category, DebugVertex* destination, uint32_t maxVertices) const;
+
+    // このフレームの線分を捨てる (残す線分は期限が来たものだけ消す)
+    void EndFrame();
+
+    // 色を頂点の形式にする
+    static uint32_t PackColor(const Vector4& color);
+
+    // スレッドごとの置き場の数 (1フレームに同時に足したスレッドの数の最大)
+    uint32_t GetThreadBufferCount() const;
+
+private:
+    // 1スレッド分の置き場 (借りているスレッドだけが書く)
+    struct ThreadBuffer {
+        std::atomic<std::thread::id> owner{ std::thread::id() }; // 借りているスレッド (空なら誰も借りていない)
+        ThreadBuffer* next = nullptr;
+        std::vector<DebugVertex> vertices[kCategoryCount];   // このフレームだけの線分
+        std::vector<DebugVertex> persistents[kCategoryCount]; // 残す線分
+        std::vector<uint32_t> frames[kCategoryCount];         // 残す線分ごとのフレーム数
+    };
+
+    // Collect で集めた残す線分
+    struct PersistentStore {
+        std::vector<DebugVertex> vertices;
+        std::vector<uint64_t> expireFrames; // 線分ごと。この番号のフレームになったら消す
+    };
+
+    // 呼び出したスレッドの置き場 (このフレームに借りていなければ空いているものを借り、それも無ければ作ってリストに足す)
+    ThreadBuffer* GetThreadBuffer();
+
+    // 線分 lineCount 本分の頂点の書き込み先を確保する
+    DebugVertex* Append(DebugDrawCategory category, uint32_t frames, uint32_t lineCount);
+
+    static DebugDrawCategory GetCategory(const DebugDrawOptions& options) {
+        return options.depthTest ? DebugDrawCategory::kDepthTested : DebugDrawCategory::kOverlay;
+    }
+
+private:
+    // スレッドごとのキャッシュがどのリストのものかを見分ける番号 (使い回さない。フレームの番号と合わせて見る)
+    uint64_t id_ = 0;
+    std::atomic<ThreadBuffer*> threadBuffers_{ nullptr };
+    PersistentStore persistents_[kCategoryCount];
+    uint64_t frame_ = 0;
+};
@@ -0,0 +1,34 @@
+#include "ComponentType.h"
+#include <atomic>
+#include <cassert>
+#include <mutex>
+
+namespace {
+
+std::mutex registryMutex;
+ComponentInfo registeredInfos[kMaxComponentTypes];
+std::atomic<uint32_t> registeredCount = 0;
+
+} // namespace
+
+namespace ComponentRegistry {
+
+ComponentId Register(const ComponentInfo& info) {
+    std::lock_guard<std::mutex> lock(registryMutex);
+    uint32_t id = registeredCount.load(std::memory_order_relaxed);
+    assert(id < kMaxComponentTypes && "too many component types");
+    registeredInfos[id] = info;
+    registeredCount.store(id + 1, std::memory_order_release);
+    return id;
+}
+
+const ComponentInfo& GetInfo(ComponentId id) {
+    assert(id < registeredCount.load(std::memory_order_acquire));
+    return registeredInfos[id];
+}
+
+uint32_t GetCount() {
+    return registeredCount.load(std::memory_order_acquire);
+}
+
+} // namespace ComponentRegistry
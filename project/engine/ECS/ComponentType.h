@@ -0,0 +1,82 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+// コンポーネントの種類の番号 (型ごとに最初に使ったときに振る)
+using ComponentId = uint32_t;
+
+// 使えるコンポーネントの種類の数 (ComponentMask のビット数)
+const uint32_t kMaxComponentTypes = 64;
+
+// コンポーネントの種類の集合
+struct ComponentMask {
+    uint64_t bits = 0;
+
+    void Set(ComponentId id) { bits |= uint64_t(1) << id; }
+    void Reset(ComponentId id) { bits &= ~(uint64_t(1) << id); }
+    bool Test(ComponentId id) const { return (bits >> id) & 1; }
+    // other の種類を全て含むか
+    bool Contains(const ComponentMask& other) const { return (bits & other.bits) == other.bits; }
+    // other の種類を1つでも含むか
+    bool Intersects(const ComponentMask& other) const { return (bits & other.bits) != 0; }
+    bool operator==(const ComponentMask& other) const { return bits == other.bits; }
+    bool operator!=(const ComponentMask& other) const { return bits != other.bits; }
+};
+
+// コンポーネントの型の情報 (チャンクの中で型を消して動かすため)
+// 関数が nullptr の型はメモリのコピーで動かせて、破棄しなくてよい (trivially copyable)
+struct ComponentInfo {
+    uint32_t size = 0;
+    uint32_t alignment = 0;
+    void (*construct)(void* destination) = nullptr;                // 既定の値で作る
+    void (*moveConstruct)(void* destination, void* source) = nullptr; // source から移して source を破棄する
+    void (*destroy)(void* target) = nullptr;
+};
+
+namespace ComponentRegistry {
+
+// 型を登録して番号を返す (同じ型で二度呼ばないこと。GetComponentId から使う)
+ComponentId Register(const ComponentInfo& info);
+// 登録した型の情報
+const ComponentInfo& GetInfo(ComponentId id);
+// 登録した型の数
+uint32_t GetCount();
+
+template <typename T>
+ComponentInfo MakeInfo() {
+    static_assert(std::is_default_constructible_v<T>, "components must be default constructible");
+    static_assert(std::is_nothrow_move_constructible_v<T>, "components must be nothrow move constructible");
+    ComponentInfo info;
+    info.size = static_cast<uint32_t>(sizeof(T));
+    info.alignment = static_cast<uint32_t>(alignof(T));
+    info.construct = [](void* destination) { new (destination) T(); };
+    if constexpr (!std::is_trivially_copyable_v<T>) {
+        info.moveConstruct = [](void* destination, void* source) {
+            T* from = static_cast<T*>(source);
+            new (destination) T(std::move(*from));
+            from->~T();
+        };
+        info.destroy = [](void* target) { static_cast<T*>(target)->~T(); };
+    }
+    return info;
+}
+
+} // namespace ComponentRegistry
+
+// 型の番号 (初めて呼んだときに登録する。どのスレッドから呼んでもよい)
+template <typename T>
+ComponentId GetComponentId() {
+    static const ComponentId id = ComponentRegistry::Register(ComponentRegistry::MakeInfo<T>());
+    return id;
+}
+
+// 型の並びの集合
+template <typename... Ts>
+ComponentMask MakeComponentMask() {
+    ComponentMask mask;
+    (mask.Set(GetComponentId<Ts>()), ...);
+    return mask;
+}
@@ -0,0 +1,288 @@
+#include "EntityWorld.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// チャンクの先頭の位置の揃え (SIMD で読めるように)
+const size_t kChunkAlignment = 64;
+
+uint32_t AlignUp(uint32_t value, uint32_t alignment) {
+    return (value + alignment - 1) & ~(alignment - 1);
+}
+
+// 種類の配列を順に置いたときに、capacity 個が入るか (入るなら各配列の位置を offsets に書く)
+bool LayoutChunk(const std::vector<ComponentId>& components, uint32_t capacity, uint32_t* offsets) {
+    uint32_t offset = static_cast<uint32_t>(sizeof(Entity)) * capacity;
+    for (ComponentId id : components) {
+        const ComponentInfo& info = ComponentRegistry::GetInfo(id);
+        offset = AlignUp(offset, std::max<uint32_t>(info.alignment, 16));
+        offsets[id] = offset;
+        offset += info.size * capacity;
+    }
+    return offset <= EntityWorld::kChunkSize;
+}
+
+// 1つ分を移す (動かし方の無い型はメモリのコピー)
+void MoveComponent(const ComponentInfo& info, void* destination, void* source) {
+    if (info.moveConstruct != nullptr) {
+        info.moveConstruct(destination, source);
+    } else {
+        std::memcpy(destination, source, info.size);
+    }
+}
+
+} // namespace
+
+EntityWorld::EntityWorld() {
+    // 番号 0 はコンポーネントの無いアーキタイプ
+    GetOrCreateArchetype(ComponentMask());
+}
+
+EntityWorld::~EntityWorld() {
+    Clear();
+    for (std::byte* memory : freeChunks_) {
+        ::operator delete(memory, std::align_val_t(kChunkAlignment));
+    }
+}
+
+Entity EntityWorld::Create() {
+    return AllocateEntity(AllocateRow(0));
+}
+
+void EntityWorld::Destroy(Entity entity) {
+    assert(IsAlive(entity));
+    assert(iterationDepth_ == 0 && "structural changes are not allowed during ForEach");
+    EntityRecord& record = records_[entity.index];
+    RemoveRow(Location{ record.archetype, record.chunk, record.row }, true);
+    record.archetype = UINT32_MAX;
+    ++record.generation;
+    freeIndices_.push_back(entity.index);
+    --entityCount_;
+}
+
+bool EntityWorld::IsAlive(Entity entity) const {
+    return entity.index < records_.size() && records_[entity.index].generation == entity.generation &&
+        records_[entity.index].archetype != UINT32_MAX;
+}
+
+void EntityWorld::Clear() {
+    assert(iterationDepth_ == 0);
+    for (std::unique_ptr<Archetype>& archetype : archetypes_) {
+        for (Chunk& chunk : archetype->chunks) {
+            for (ComponentId id : archetype->components) {
+                const ComponentInfo& info = ComponentRegistry::GetInfo(id);
+                if (info.destroy != nullptr) {
+                    for (uint32_t row = 0; row < chunk.count; ++row) {
+                        info.destroy(chunk.data + archetype->offsets[id] + size_t(info.size) * row);
+                    }
+                }
+            }
+            const Entity* entities = reinterpret_cast<const Entity*>(chunk.data);
+            for (uint32_t row = 0; row < chunk.count; ++row) {
+                EntityRecord& record = records_[entities[row].index];
+                record.archetype = UINT32_MAX;
+                ++record.generation;
+                freeIndices_.push_back(entities[row].index);
+            }
+            freeChunks_.push_back(chunk.data);
+        }
+        archetype->chunks.clear();
+        archetype->entityCount = 0;
+    }
+    entityCount_ = 0;
+}
+
+EntityWorld::Stats EntityWorld::GetStats() const {
+    Stats stats;
+    stats.entityCount = entityCount_;
+    stats.archetypeCount = static_cast<uint32_t>(archetypes_.size());
+    for (const std::unique_ptr<Archetype>& archetype : archetypes_) {
+        stats.chunkCount += static_cast<uint32_t>(archetype->chunks.size());
+    }
+    stats.freeChunkCount = static_cast<uint32_t>(freeChunks_.size());
+    return stats;
+}
+
+uint32_t EntityWorld::GetOrCreateArchetype(const ComponentMask& mask) {
+    auto found = archetypeLookup_.find(mask.bits);
+    if (found != archetypeLookup_.end()) {
+        return found->second;
+    }
+    std::unique_ptr<Archetype> archetype = std::make_unique<Archetype>();
+    archetype->mask = mask;
+    for (ComponentId id = 0; id < kMaxComponentTypes; ++id) {
+        if (mask.Test(id)) {
+            archetype->components.push_back(id);
+        }
+        archetype->offsets[id] = UINT32_MAX;
+        archetype->addTargets[id] = UINT32_MAX;
+        archetype->removeTargets[id] = UINT32_MAX;
+    }
+    archetype->componentCount = static_cast<uint32_t>(archetype->components.size());
+    // 揃えの隙間を見込まずに見積もってから、入るまで減らす
+    uint32_t rowSize = static_cast<uint32_t>(sizeof(Entity));
+    for (ComponentId id : archetype->components) {
+        assert(ComponentRegistry::GetInfo(id).alignment <= kChunkAlignment && "over-aligned component");
+        rowSize += ComponentRegistry::GetInfo(id).size;
+    }
+    uint32_t capacity = kChunkSize / rowSize;
+    while (capacity > 0 && !LayoutChunk(archetype->components, capacity, archetype->offsets)) {
+        --capacity;
+    }
+    assert(capacity > 0 && "components are too large for a chunk");
+    archetype->capacity = capacity;
+
+    uint32_t index = static_cast<uint32_t>(archetypes_.size());
+    archetypes_.push_back(std::move(archetype));
+    archetypeLookup_.emplace(mask.bits, index);
+    return index;
+}
+
+uint32_t EntityWorld::GetAddTarget(uint32_t archetypeIndex, ComponentId id) {
+    uint32_t target = archetypes_[archetypeIndex]->addTargets[id];
+    if (target == UINT32_MAX) {
+        ComponentMask mask = archetypes_[archetypeIndex]->mask;
+        mask.Set(id);
+        target = GetOrCreateArchetype(mask);
+        archetypes_[archetypeIndex]->addTargets[id] = target;
+        archetypes_[target]->removeTargets[id] = archetypeIndex;
+    }
+    return target;
+}
+
+uint32_t EntityWorld::GetRemoveTarget(uint32_t archetypeIndex, ComponentId id) {
+    uint32_t target = archetypes_[archetypeIndex]->removeTargets[id];
+    if (target == UINT32_MAX) {
+        ComponentMask mask = archetypes_[archetypeIndex]->mask;
+        mask.Reset(id);
+        target = GetOrCreateArchetype(mask);
+        archetypes_[archetypeIndex]->removeTargets[id] = target;
+        archetypes_[target]->addTargets[id] = archetypeIndex;
+    }
+    return target;
+}
+
+const std::vector<uint32_t>& EntityWorld::GetMatchingArchetypes(const EntityQuery& query) {
+    QueryCache* cache = nullptr;
+    for (std::unique_ptr<QueryCache>& candidate : queryCaches_) {
+        if (candidate->all == query.all && candidate->none == query.none) {
+            cache = candidate.get();
+            break;
+        }
+    }
+    if (cache == nullptr) {
+        queryCaches_.push_back(std::make_unique<QueryCache>());
+        cache = queryCaches_.back().get();
+        cache->all = query.all;
+        cache->none = query.none;
+    }
+    uint32_t archetypeCount = static_cast<uint32_t>(archetypes_.size());
+    for (; cache->checkedCount < archetypeCount; ++cache->checkedCount) {
+        const ComponentMask& mask = archetypes_[cache->checkedCount]->mask;
+        if (mask.Contains(cache->all) && !mask.Intersects(cache->none)) {
+            cache->archetypes.push_back(cache->checkedCount);
+        }
+    }
+    return cache->archetypes;
+}
+
+EntityWorld::Location EntityWorld::AllocateRow(uint32_t archetypeIndex) {
+    assert(iterationDepth_ == 0 && "structural changes are not allowed during ForEach");
+    Archetype& archetype = *archetypes_[archetypeIndex];
+    if (archetype.chunks.empty() || archetype.chunks.back().count == archetype.capacity) {
+        Chunk chunk;
+        chunk.data = AllocateChunkMemory();
+        archetype.chunks.push_back(chunk);
+    }
+    Location location;
+    location.archetype = archetypeIndex;
+    location.chunk = static_cast<uint32_t>(archetype.chunks.size()) - 1;
+    location.row = archetype.chunks.back().count++;
+    ++archetype.entityCount;
+    return location;
+}
+
+void EntityWorld::RemoveRow(const Location& location, bool destroyComponents) {
+    Archetype& archetype = *archetypes_[location.archetype];
+    Chunk& chunk = archetype.chunks[location.chunk];
+    Chunk& lastChunk = archetype.chunks.back();
+    uint32_t lastRow = lastChunk.count - 1;
+    bool isLast = &chunk == &lastChunk && location.row == lastRow;
+    for (ComponentId id : archetype.components) {
+        const ComponentInfo& info = ComponentRegistry::GetInfo(id);
+        std::byte* target = chunk.data + archetype.offsets[id] + size_t(info.size) * location.row;
+        if (destroyComponents && info.destroy != nullptr) {
+            info.destroy(target);
+        }
+        if (!isLast) {
+            MoveComponent(info, target, lastChunk.data + archetype.offsets[id] + size_t(info.size) * lastRow);
+        }
+    }
+    if (!isLast) {
+        // 最後のエンティティを空いた場所へ
+        Entity* entities = reinterpret_cast<Entity*>(chunk.data);
+        Entity moved = reinterpret_cast<Entity*>(lastChunk.data)[lastRow];
+        entities[location.row] = moved;
+        records_[moved.index].chunk = location.chunk;
+        records_[moved.index].row = location.row;
+    }
+    --lastChunk.count;
+    --archetype.entityCount;
+    if (lastChunk.count == 0) {
+        freeChunks_.push_back(lastChunk.data);
+        archetype.chunks.pop_back();
+    }
+}
+
+Entity EntityWorld::AllocateEntity(const Location& location) {
+    uint32_t index = 0;
+    if (!freeIndices_.empty()) {
+        index = freeIndices_.back();
+        freeIndices_.pop_back();
+    } else {
+        index = static_cast<uint32_t>(records_.size());
+        records_.emplace_back();
+    }
+    EntityRecord& record = records_[index];
+    record.archetype = location.archetype;
+    record.chunk = location.chunk;
+    record.row = location.row;
+    Entity entity{ index, record.generation };
+    reinterpret_cast<Entity*>(archetypes_[location.archetype]->chunks[location.chunk].data)[location.row] = entity;
+    ++entityCount_;
+    return entity;
+}
+
+EntityWorld::Location EntityWorld::MoveEntity(Entity entity, uint32_t targetArchetype) {
+    EntityRecord& record = records_[entity.index];
+    Location source{ record.archetype, record.chunk, record.row };
+    Location target = AllocateRow(targetArchetype);
+    const Archetype& from = *archetypes_[source.archetype];
+    const Archetype& to = *archetypes_[targetArchetype];
+    for (ComponentId id : from.components) {
+        void* sourcePointer = GetPointer(from, source, id);
+        const ComponentInfo& info = ComponentRegistry::GetInfo(id);
+        if (to.mask.Test(id)) {
+            MoveComponent(info, GetPointer(to, target, id), sourcePointer);
+        } else if (info.destroy != nullptr) {
+            info.destroy(sourcePointer);
+        }
+    }
+    reinterpret_cast<Entity*>(to.chunks[target.chunk].data)[target.row] = entity;
+    // 移した後の場所を詰める (ここで他のエンティティが動いても、移ったエンティティの場所は変わらない)
+    RemoveRow(source, false);
+    record.archetype = target.archetype;
+    record.chunk = target.chunk;
+    record.row = target.row;
+    return target;
+}
+
+std::byte* EntityWorld::AllocateChunkMemory() {
+    if (!freeChunks_.empty()) {
+        std::byte* memory = freeChunks_.back();
+        freeChunks_.pop_back();
+        return memory;
+    }
+    return static_cast<std::byte*>(::operator new(kChunkSize, std::align_val_t(kChunkAlignment)));
+}
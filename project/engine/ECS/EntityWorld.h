@@ -0,0 +1,315 @@
+#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "ComponentType.h"
+#include "JobSystem.h"
+
+// エンティティ (番号と世代。破棄した後に同じ番号が使い回されても、古いハンドルは世代で見分ける)
+struct Entity {
+    uint32_t index = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return index != UINT32_MAX; }
+    bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+    bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+// ForEach で探す条件 (型の並びに加えて、持っているべき種類と持っていてはいけない種類)
+class EntityQuery {
+public:
+    template <typename T>
+    EntityQuery& With() {
+        all.Set(GetComponentId<std::remove_cv_t<T>>());
+        return *this;
+    }
+    template <typename T>
+    EntityQuery& Without() {
+        none.Set(GetComponentId<std::remove_cv_t<T>>());
+        return *this;
+    }
+
+public:
+    ComponentMask all;
+    ComponentMask none;
+};
+
+// アーキタイプ (コンポーネントの種類の組み合わせ) ごとにエンティティをまとめる ECS
+// 同じ組み合わせのエンティティは 16KB のチャンクに詰めて置き、チャンクの中は種類ごとの配列 (SoA) にする
+// ForEach はチャンクの配列を先頭から順に読むだけなので、ポインタをたどらずキャッシュに乗る
+// コンポーネントを足す・外すとエンティティは別のアーキタイプのチャンクへ移る (移った先は種類ごとに覚えておく)
+// 空いた場所には同じアーキタイプの最後のエンティティを移して詰める (チャンクに隙間を作らない)
+// ParallelForEach はチャンクを単位に JobSystem で並列に処理する (JobSystem を初期化しておくこと)
+// 作成・破棄・足す・外すは ForEach の中 (と他のスレッド) から呼ばないこと。取得と書き換えはどこからでもよい
+class EntityWorld {
+public:
+    // チャンク1つの大きさ
+    static const uint32_t kChunkSize = 16 * 1024;
+
+    struct Stats {
+        uint32_t entityCount = 0;
+        uint32_t archetypeCount = 0;
+        uint32_t chunkCount = 0;     // 使っているチャンク
+        uint32_t freeChunkCount = 0; // 空いて再利用を待っているチャンク
+    };
+
+public:
+    EntityWorld();
+    ~EntityWorld();
+    EntityWorld(const EntityWorld&) = delete;
+    EntityWorld& operator=(const EntityWorld&) = delete;
+
+    // コンポーネントの無いエンティティを作る
+    Entity Create();
+    // コンポーネントを持たせて作る (型は重複しないこと)
+    template <typename... Ts>
+    Entity Create(Ts&&... components) {
+        static_assert(sizeof...(Ts) > 0);
+        ComponentMask mask = MakeComponentMask<std::decay_t<Ts>...>();
+        uint32_t archetypeIndex = GetOrCreateArchetype(mask);
+        Location location = AllocateRow(archetypeIndex);
+        Entity entity = AllocateEntity(location);
+        const Archetype& archetype = *archetypes_[archetypeIndex];
+        assert(archetype.componentCount == sizeof...(Ts) && "duplicate component types");
+        ((new (GetPointer(archetype, location, GetComponentId<std::decay_t<Ts>>())) std::decay_t<Ts>(std::forward<Ts>(components))), ...);
+        return entity;
+    }
+
+    // 破棄する (コンポーネントも破棄する)
+    void Destroy(Entity entity);
+    // 破棄していないか
+    bool IsAlive(Entity entity) const;
+    // 全て破棄する
+    void Clear();
+
+    // コンポーネントを足す (もう持っていれば上書きする)
+    template <typename T>
+    T& Add(Entity entity, T component = T()) {
+        assert(IsAlive(entity));
+        ComponentId id = GetComponentId<T>();
+        if (T* existing = Get<T>(entity)) {
+            *existing = std::move(component);
+            return *existing;
+        }
+        Location location = MoveEntity(entity, GetAddTarget(records_[entity.index].archetype, id));
+        return *new (GetPointer(*archetypes_[location.archetype], location, id)) T(std::move(component));
+    }
+
+    // コンポーネントを外す (持っていなければ何もしない)
+    template <typename T>
+    void Remove(Entity entity) {
+        assert(IsAlive(entity));
+        ComponentId id = GetComponentId<T>();
+        uint32_t archetypeIndex = records_[entity.index].archetype;
+        if (archetypes_[archetypeIndex]->mask.Test(id)) {
+            MoveEntity(entity, GetRemoveTarget(archetypeIndex, id));
+        }
+    }
+
+    // コンポーネント (持っていなければ nullptr。足す・外す・破棄で場所が変わるので持ち続けないこと)
+    template <typename T>
+    T* Get(Entity entity) {
+        if (!IsAlive(entity)) {
+            return nullptr;
+        }
+        const EntityRecord& record = records_[entity.index];
+        const Archetype& archetype = *archetypes_[record.archetype];
+        ComponentId id = GetComponentId<T>();
+        if (!archetype.mask.Test(id)) {
+            return nullptr;
+        }
+        return static_cast<T*>(GetPointer(archetype, Location{ record.archetype, record.chunk, record.row }, id));
+    }
+    template <typename T>
+    const T* Get(Entity entity) const {
+        return const_cast<EntityWorld*>(this)->Get<T>(entity);
+    }
+    template <typename T>
+    bool Has(Entity entity) const {
+        return IsAlive(entity) && archetypes_[records_[entity.index].archetype]->mask.Test(GetComponentId<T>());
+    }
+
+    // Ts を全て持つエンティティのチャンクごとに function(count, entities, Ts* arrays...) を呼ぶ
+    // 配列は count 個で、同じ番号が同じエンティティ (読むだけの型は const を付けてよい)
+    template <typename... Ts, typename Function>
+    void ForEachChunk(const EntityQuery& query, Function&& function) {
+        ++iterationDepth_;
+        for (uint32_t archetypeIndex : GetMatchingArchetypes(MakeQuery<Ts...>(query))) {
+            Archetype& archetype = *archetypes_[archetypeIndex];
+            for (Chunk& chunk : archetype.chunks) {
+                CallChunk<Ts...>(archetype, chunk, function);
+            }
+        }
+        --iterationDepth_;
+    }
+    template <typename... Ts, typename Function>
+    void ForEachChunk(Function&& function) {
+        ForEachChunk<Ts...>(EntityQuery(), std::forward<Function>(function));
+    }
+
+    // Ts を全て持つエンティティごとに function(Ts&...) か function(Entity, Ts&...) を呼ぶ
+    template <typename... Ts, typename Function>
+    void ForEach(const EntityQuery& query, Function&& function) {
+        ForEachChunk<Ts...>(query, [&function](uint32_t count, const Entity* entities, Ts*... arrays) {
+            CallRows<Ts...>(function, count, entities, arrays...);
+        });
+    }
+    template <typename... Ts, typename Function>
+    void ForEach(Function&& function) {
+        ForEach<Ts...>(EntityQuery(), std::forward<Function>(function));
+    }
+
+    // ForEachChunk をチャンクごとに並列に呼ぶ (function は複数のスレッドから同時に呼ばれる。全て終わってから戻る)
+    template <typename... Ts, typename Function>
+    void ParallelForEachChunk(const EntityQuery& query, const Function& function) {
+        ++iterationDepth_;
+        std::vector<std::pair<Archetype*, Chunk*>> chunks;
+        for (uint32_t archetypeIndex : GetMatchingArchetypes(MakeQuery<Ts...>(query))) {
+            Archetype& archetype = *archetypes_[archetypeIndex];
+            for (Chunk& chunk : archetype.chunks) {
+                chunks.emplace_back(&archetype, &chunk);
+            }
+        }
+        JobSystem::GetInstance()->ParallelFor(0, static_cast<uint32_t>(chunks.size()), [&chunks, &function](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+                CallChunk<Ts...>(*chunks[i].first, *chunks[i].second, function);
+            }
+        });
+        --iterationDepth_;
+    }
+    template <typename... Ts, typename Function>
+    void ParallelForEachChunk(const Function& function) {
+        ParallelForEachChunk<Ts...>(EntityQuery(), function);
+    }
+
+    // ForEach をチャンクごとに並列に呼ぶ
+    template <typename... Ts, typename Function>
+    void ParallelForEach(const EntityQuery& query, const Function& function) {
+        ParallelForEachChunk<Ts...>(query, [&function](uint32_t count, const Entity* entities, Ts*... arrays) {
+            CallRows<Ts...>(function, count, entities, arrays...);
+        });
+    }
+    template <typename... Ts, typename Function>
+    void ParallelForEach(const Function& function) {
+        ParallelForEach<Ts...>(EntityQuery(), function);
+    }
+
+    // 条件に合うエンティティの数
+    template <typename... Ts>
+    uint32_t Count(const EntityQuery& query = EntityQuery()) {
+        uint32_t count = 0;
+        for (uint32_t archetypeIndex : GetMatchingArchetypes(MakeQuery<Ts...>(query))) {
+            count += archetypes_[archetypeIndex]->entityCount;
+        }
+        return count;
+    }
+
+    uint32_t GetEntityCount() const { return entityCount_; }
+    Stats GetStats() const;
+
+private:
+    // チャンク (先頭にエンティティの配列、その後に種類ごとの配列)
+    struct Chunk {
+        std::byte* data = nullptr;
+        uint32_t count = 0;
+    };
+
+    // 種類の組み合わせ1つ分
+    struct Archetype {
+        ComponentMask mask;
+        uint32_t componentCount = 0;
+        std::vector<ComponentId> components;
+        uint32_t offsets[kMaxComponentTypes];     // チャンクの中の種類ごとの配列の位置 (持っていなければ UINT32_MAX)
+        uint32_t capacity = 0;                    // チャンク1つに入るエンティティの数
+        std::vector<Chunk> chunks;                // 最後のチャンク以外は満杯
+        uint32_t entityCount = 0;
+        uint32_t addTargets[kMaxComponentTypes];    // 種類を足したときの移り先 (まだ調べていなければ UINT32_MAX)
+        uint32_t removeTargets[kMaxComponentTypes]; // 種類を外したときの移り先
+    };
+
+    // エンティティの置き場所
+    struct Location {
+        uint32_t archetype = 0;
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+    };
+
+    // 番号ごとの置き場所 (破棄した番号は archetype が UINT32_MAX)
+    struct EntityRecord {
+        uint32_t archetype = UINT32_MAX;
+        uint32_t chunk = 0;
+        uint32_t row = 0;
+        uint32_t generation = 0;
+    };
+
+    // 探す条件ごとに、合うアーキタイプを覚えておく (後から増えたアーキタイプだけ調べ足す)
+    struct QueryCache {
+        ComponentMask all;
+        ComponentMask none;
+        std::vector<uint32_t> archetypes;
+        uint32_t checkedCount = 0;
+    };
+
+    template <typename... Ts>
+    static EntityQuery MakeQuery(const EntityQuery& query) {
+        EntityQuery result = query;
+        (result.With<Ts>(), ...);
+        return result;
+    }
+
+    static void* GetPointer(const Archetype& archetype, const Location& location, ComponentId id) {
+        assert(archetype.offsets[id] != UINT32_MAX);
+        const Chunk& chunk = archetype.chunks[location.chunk];
+        return chunk.data + archetype.offsets[id] + size_t(ComponentRegistry::GetInfo(id).size) * location.row;
+    }
+
+    template <typename... Ts, typename Function>
+    static void CallChunk(const Archetype& archetype, const Chunk& chunk, Function& function) {
+        function(chunk.count, reinterpret_cast<const Entity*>(chunk.data),
+            reinterpret_cast<Ts*>(chunk.data + archetype.offsets[GetComponentId<std::remove_cv_t<Ts>>()])...);
+    }
+
+    template <typename... Ts, typename Function>
+    static void CallRows(Function& function, uint32_t count, const Entity* entities, Ts*... arrays) {
+        for (uint32_t i = 0; i < count; ++i) {
+            if constexpr (std::is_invocable_v<Function&, Entity, Ts&...>) {
+                function(entities[i], arrays[i]...);
+            } else {
+                function(arrays[i]...);
+            }
+        }
+    }
+
+    uint32_t GetOrCreateArchetype(const ComponentMask& mask);
+    uint32_t GetAddTarget(uint32_t archetypeIndex, ComponentId id);
+    uint32_t GetRemoveTarget(uint32_t archetypeIndex, ComponentId id);
+    const std::vector<uint32_t>& GetMatchingArchetypes(const EntityQuery& query);
+
+    // アーキタイプの最後に場所を取る (コンポーネントは作らない)
+    Location AllocateRow(uint32_t archetypeIndex);
+    // 場所を空けて最後のエンティティで詰める (destroyComponents が false ならコンポーネントはもう移したか破棄した)
+    void RemoveRow(const Location& location, bool destroyComponents);
+    // 番号を割り当てて location に書く
+    Entity AllocateEntity(const Location& location);
+    // 別のアーキタイプへ移す (共通の種類は移し、移り先に無い種類は破棄し、移り先にだけある種類は作らずに空けておく)
+    Location MoveEntity(Entity entity, uint32_t targetArchetype);
+
+    std::byte* AllocateChunkMemory();
+
+private:
+    std::vector<std::unique_ptr<Archetype>> archetypes_;
+    std::unordered_map<uint64_t, uint32_t> archetypeLookup_; // ComponentMask::bits からアーキタイプの番号
+    std::vector<std::unique_ptr<QueryCache>> queryCaches_;
+
+    std::vector<EntityRecord> records_;
+    std::vector<uint32_t> freeIndices_;
+    uint32_t entityCount_ = 0;
+
+    std::vector<std::byte*> freeChunks_;
+    uint32_t iterationDepth_ = 0; // ForEach の入れ子の深さ (0 でなければ作成や破棄をしてはいけない)
+};
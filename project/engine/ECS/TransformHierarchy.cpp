@@ -0,0 +1,382 @@
+#include "TransformHierarchy.h"
+#include <algorithm>
+#include <cassert>
+#include "JobSystem.h"
+#include "MathUtil.h"
+
+namespace {
+
+// これより少なければ並列にしない
+const uint32_t kParallelNodeCount = 4096;
+// 範囲をこれより小さくは分けない
+const uint32_t kMinRangeSize = 256;
+
+// Update の途中で使う印 (marks_)
+const uint8_t kMarkDirty = 1;   // 変わったノード
+const uint8_t kMarkVisited = 2; // 祖先をたどった (結果は kMarkCovered)
+const uint8_t kMarkCovered = 4; // 変わった祖先がある
+
+} // namespace
+
+TransformNode TransformHierarchy::Create(const Transform& local, TransformNode parent) {
+    uint32_t parentId = UINT32_MAX;
+    uint32_t parentIndex = UINT32_MAX;
+    if (parent.IsValid()) {
+        parentIndex = GetIndex(parent);
+        parentId = parent.id;
+    }
+    uint32_t id = 0;
+    if (!freeIds_.empty()) {
+        id = freeIds_.back();
+        freeIds_.pop_back();
+    } else {
+        id = static_cast<uint32_t>(links_.size());
+        links_.emplace_back();
+    }
+    uint32_t index = static_cast<uint32_t>(order_.size());
+    Links& links = links_[id];
+    uint32_t generation = links.generation;
+    links = Links();
+    links.generation = generation;
+    links.index = index;
+
+    // 親の部分木が配列の最後にあれば、後ろに足すだけで行きがけ順のまま (ツリーを深さ優先で作るとき)
+    if (!structureChanged_ && (parentIndex == UINT32_MAX || parentIndex + subtreeSizes_[parentIndex] == index)) {
+        for (uint32_t ancestor = parentIndex; ancestor != UINT32_MAX; ancestor = parents_[ancestor]) {
+            ++subtreeSizes_[ancestor];
+        }
+    } else {
+        structureChanged_ = true;
+    }
+    order_.push_back(id);
+    parents_.push_back(parentIndex);
+    subtreeSizes_.push_back(1);
+    locals_.push_back(local);
+    localMatrices_.push_back(MakeIdentity4x4());
+    worlds_.push_back(MakeIdentity4x4());
+    localDirty_.push_back(1);
+    removed_.push_back(0);
+    marks_.push_back(0);
+
+    Link(id, parentId);
+    MarkDirty(id);
+    return TransformNode{ id, generation };
+}
+
+void TransformHierarchy::Destroy(TransformNode node) {
+    assert(IsAlive(node));
+    Unlink(node.id);
+    // 子孫を集めて破棄する (配列からは次の Update で詰める)
+    std::vector<uint32_t> stack;
+    stack.push_back(node.id);
+    while (!stack.empty()) {
+        uint32_t id = stack.back();
+        stack.pop_back();
+        Links& links = links_[id];
+        for (uint32_t child = links.firstChild; child != UINT32_MAX; child = links_[child].nextSibling) {
+            stack.push_back(child);
+        }
+        removed_[links.index] = 1;
+        ++removedCount_;
+        uint32_t generation = links.generation + 1;
+        links = Links();
+        links.generation = generation;
+        freeIds_.push_back(id);
+    }
+    structureChanged_ = true;
+}
+
+bool TransformHierarchy::IsAlive(TransformNode node) const {
+    return node.id < links_.size() && links_[node.id].generation == node.generation && links_[node.id].index != UINT32_MAX;
+}
+
+void TransformHierarchy::Clear() {
+    freeIds_.clear();
+    for (uint32_t id = static_cast<uint32_t>(links_.size()); id-- > 0;) {
+        Links& links = links_[id];
+        uint32_t generation = links.index != UINT32_MAX ? links.generation + 1 : links.generation;
+        links = Links();
+        links.generation = generation;
+        freeIds_.push_back(id);
+    }
+    firstRoot_ = UINT32_MAX;
+    lastRoot_ = UINT32_MAX;
+    order_.clear();
+    parents_.clear();
+    subtreeSizes_.clear();
+    locals_.clear();
+    localMatrices_.clear();
+    worlds_.clear();
+    localDirty_.clear();
+    removed_.clear();
+    marks_.clear();
+    removedCount_ = 0;
+    structureChanged_ = false;
+    dirtyIds_.clear();
+}
+
+void TransformHierarchy::SetParent(TransformNode node, TransformNode parent) {
+    uint32_t index = GetIndex(node);
+    uint32_t parentId = UINT32_MAX;
+    uint32_t parentIndex = UINT32_MAX;
+    if (parent.IsValid()) {
+        parentIndex = GetIndex(parent);
+        parentId = parent.id;
+        // 自分の子孫を親にすると輪になる
+        for (uint32_t ancestor = parentId; ancestor != UINT32_MAX; ancestor = links_[ancestor].parent) {
+            assert(ancestor != node.id && "cannot parent a node to its own descendant");
+            if (ancestor == node.id) {
+                return;
+            }
+        }
+    }
+    if (links_[node.id].parent == parentId) {
+        return;
+    }
+    Unlink(node.id);
+    Link(node.id, parentId);
+    parents_[index] = parentIndex;
+    structureChanged_ = true;
+    MarkDirty(node.id);
+}
+
+TransformNode TransformHierarchy::GetParent(TransformNode node) const {
+    assert(IsAlive(node));
+    uint32_t parent = links_[node.id].parent;
+    return parent != UINT32_MAX ? TransformNode{ parent, links_[parent].generation } : TransformNode();
+}
+
+void TransformHierarchy::SetLocal(TransformNode node, const Transform& local) {
+    uint32_t index = GetIndex(node);
+    locals_[index] = local;
+    localDirty_[index] = 1;
+    MarkDirty(node.id);
+}
+
+const Transform& TransformHierarchy::GetLocal(TransformNode node) const {
+    return locals_[GetIndex(node)];
+}
+
+const Matrix4x4& TransformHierarchy::GetWorldMatrix(TransformNode node) const {
+    return worlds_[GetIndex(node)];
+}
+
+Vector3 TransformHierarchy::GetWorldPosition(TransformNode node) const {
+    const Matrix4x4& world = GetWorldMatrix(node);
+    return { world.m[3][0], world.m[3][1], world.m[3][2] };
+}
+
+void TransformHierarchy::Update() {
+    stats_ = {};
+    if (structureChanged_) {
+        Rebuild();
+        stats_.rebuilt = true;
+    }
+    stats_.nodeCount = static_cast<uint32_t>(order_.size());
+    if (dirtyIds_.empty()) {
+        return;
+    }
+
+    // 変わったノードに印を付け、変わった祖先を持たないものだけ部分木を範囲にする
+    // (部分木は連続しているので、範囲は位置と部分木の大きさで決まる。並べ替えはしない)
+    // 祖先が変わっていなければ親のワールド行列はもう正しいので、範囲どうしはどの順に計算してもよい
+    dirtyIndices_.clear();
+    for (uint32_t id : dirtyIds_) {
+        Links& links = links_[id];
+        if (links.dirty && links.index != UINT32_MAX) {
+            marks_[links.index] |= kMarkDirty;
+            dirtyIndices_.push_back(links.index);
+        }
+        links.dirty = false;
+    }
+    dirtyIds_.clear();
+    ranges_.clear();
+    uint32_t total = 0;
+    for (uint32_t index : dirtyIndices_) {
+        if (HasDirtyAncestor(index)) {
+            continue;
+        }
+        uint32_t end = index + subtreeSizes_[index];
+        ranges_.push_back(Range{ index, end });
+        total += end - index;
+    }
+    for (uint32_t index : dirtyIndices_) {
+        marks_[index] = 0;
+    }
+    for (uint32_t index : visitedIndices_) {
+        marks_[index] = 0;
+    }
+    visitedIndices_.clear();
+    stats_.dirtyRootCount = static_cast<uint32_t>(ranges_.size());
+    stats_.recomputedCount = total;
+
+    JobSystem* jobSystem = JobSystem::GetInstance();
+    uint32_t workerCount = jobSystem->GetWorkerCount();
+    if (workerCount <= 1 || total < kParallelNodeCount) {
+        for (const Range& range : ranges_) {
+            ComputeRange(range.begin, range.end);
+        }
+        return;
+    }
+
+    // 大きな部分木は根だけ先に計算し、子の部分木に分ける (子どうしは独立)
+    uint32_t splitSize = std::max(kMinRangeSize, total / (workerCount * 8));
+    std::vector<Range> work;
+    work.swap(ranges_);
+    while (!work.empty()) {
+        Range range = work.back();
+        work.pop_back();
+        if (range.end - range.begin <= splitSize) {
+            ranges_.push_back(range);
+            continue;
+        }
+        ComputeRange(range.begin, range.begin + 1);
+        uint32_t firstChild = range.begin + 1;
+        if (firstChild < range.end && firstChild + subtreeSizes_[firstChild] == range.end) {
+            // 子が1つだけなら分けられない (鎖のような深い階層はそのまま前から計算する)
+            ranges_.push_back(Range{ firstChild, range.end });
+            continue;
+        }
+        for (uint32_t child = firstChild; child < range.end; child += subtreeSizes_[child]) {
+            work.push_back(Range{ child, child + subtreeSizes_[child] });
+        }
+    }
+    jobSystem->ParallelFor(0, static_cast<uint32_t>(ranges_.size()), 1, [this](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            ComputeRange(ranges_[i].begin, ranges_[i].end);
+        }
+    });
+}
+
+uint32_t TransformHierarchy::GetIndex(TransformNode node) const {
+    assert(IsAlive(node));
+    return links_[node.id].index;
+}
+
+void TransformHierarchy::Link(uint32_t id, uint32_t parent) {
+    Links& links = links_[id];
+    links.parent = parent;
+    links.nextSibling = UINT32_MAX;
+    uint32_t& first = parent != UINT32_MAX ? links_[parent].firstChild : firstRoot_;
+    uint32_t& last = parent != UINT32_MAX ? links_[parent].lastChild : lastRoot_;
+    links.previousSibling = last;
+    if (last != UINT32_MAX) {
+        links_[last].nextSibling = id;
+    } else {
+        first = id;
+    }
+    last = id;
+}
+
+void TransformHierarchy::Unlink(uint32_t id) {
+    Links& links = links_[id];
+    uint32_t& first = links.parent != UINT32_MAX ? links_[links.parent].firstChild : firstRoot_;
+    uint32_t& last = links.parent != UINT32_MAX ? links_[links.parent].lastChild : lastRoot_;
+    if (links.previousSibling != UINT32_MAX) {
+        links_[links.previousSibling].nextSibling = links.nextSibling;
+    } else {
+        first = links.nextSibling;
+    }
+    if (links.nextSibling != UINT32_MAX) {
+        links_[links.nextSibling].previousSibling = links.previousSibling;
+    } else {
+        last = links.previousSibling;
+    }
+    links.parent = UINT32_MAX;
+    links.previousSibling = UINT32_MAX;
+    links.nextSibling = UINT32_MAX;
+}
+
+void TransformHierarchy::MarkDirty(uint32_t id) {
+    if (!links_[id].dirty) {
+        links_[id].dirty = true;
+        dirtyIds_.push_back(id);
+    }
+}
+
+bool TransformHierarchy::HasDirtyAncestor(uint32_t index) {
+    // 親から上にたどり、変わったノードか、前にたどった結果があるところで止める (深い階層で同じ道を何度もたどらない)
+    size_t first = visitedIndices_.size();
+    bool covered = false;
+    for (uint32_t ancestor = parents_[index]; ancestor != UINT32_MAX; ancestor = parents_[ancestor]) {
+        uint8_t mark = marks_[ancestor];
+        if (mark & kMarkDirty) {
+            covered = true;
+            break;
+        }
+        if (mark & kMarkVisited) {
+            covered = (mark & kMarkCovered) != 0;
+            break;
+        }
+        visitedIndices_.push_back(ancestor);
+    }
+    uint8_t mark = covered ? uint8_t(kMarkVisited | kMarkCovered) : kMarkVisited;
+    for (size_t i = first; i < visitedIndices_.size(); ++i) {
+        marks_[visitedIndices_[i]] = mark;
+    }
+    return covered;
+}
+
+void TransformHierarchy::Rebuild() {
+    uint32_t count = static_cast<uint32_t>(order_.size()) - removedCount_;
+    std::vector<uint32_t> order(count);
+    std::vector<uint32_t> parents(count);
+    std::vector<uint32_t> subtreeSizes(count, 1);
+    std::vector<Transform> locals(count);
+    std::vector<Matrix4x4> localMatrices(count);
+    std::vector<Matrix4x4> worlds(count);
+    std::vector<uint8_t> localDirty(count);
+
+    // 根から深さ優先で並べる (子は兄弟の順に並ぶように、逆順に積む)
+    std::vector<uint32_t> stack;
+    for (uint32_t root = lastRoot_; root != UINT32_MAX; root = links_[root].previousSibling) {
+        stack.push_back(root);
+    }
+    uint32_t next = 0;
+    while (!stack.empty()) {
+        uint32_t id = stack.back();
+        stack.pop_back();
+        Links& links = links_[id];
+        uint32_t oldIndex = links.index;
+        order[next] = id;
+        parents[next] = links.parent != UINT32_MAX ? links_[links.parent].index : UINT32_MAX;
+        locals[next] = locals_[oldIndex];
+        localMatrices[next] = localMatrices_[oldIndex];
+        worlds[next] = worlds_[oldIndex];
+        localDirty[next] = localDirty_[oldIndex];
+        links.index = next++;
+        for (uint32_t child = links.lastChild; child != UINT32_MAX; child = links_[child].previousSibling) {
+            stack.push_back(child);
+        }
+    }
+    assert(next == count);
+    // 後ろから子の大きさを親に足す
+    for (uint32_t i = count; i-- > 0;) {
+        if (parents[i] != UINT32_MAX) {
+            subtreeSizes[parents[i]] += subtreeSizes[i];
+        }
+    }
+
+    order_.swap(order);
+    parents_.swap(parents);
+    subtreeSizes_.swap(subtreeSizes);
+    locals_.swap(locals);
+    localMatrices_.swap(localMatrices);
+    worlds_.swap(worlds);
+    localDirty_.swap(localDirty);
+    removed_.assign(count, 0);
+    marks_.assign(count, 0);
+    removedCount_ = 0;
+    structureChanged_ = false;
+}
+
+void TransformHierarchy::ComputeRange(uint32_t begin, uint32_t end) {
+    for (uint32_t i = begin; i < end; ++i) {
+        if (localDirty_[i]) {
+            localMatrices_[i] = MakeAffineMatrix(locals_[i].scale, locals_[i].rotate, locals_[i].translate);
+            localDirty_[i] = 0;
+        }
+        uint32_t parent = parents_[i];
+        worlds_[i] = parent != UINT32_MAX ? Multiply(localMatrices_[i], worlds_[parent]) : localMatrices_[i];
+    }
+}
@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "MathTypes.h"
+
+// 階層のノード (番号と世代。破棄した後に同じ番号が使い回されても、古いハンドルは世代で見分ける)
+struct TransformNode {
+    uint32_t id = UINT32_MAX;
+    uint32_t generation = 0;
+
+    bool IsValid() const { return id != UINT32_MAX; }
+    bool operator==(const TransformNode& other) const { return id == other.id && generation == other.generation; }
+    bool operator!=(const TransformNode& other) const { return !(*this == other); }
+};
+
+// 親子関係のある Transform の階層
+// ノードは行きがけ順 (親が子より前、部分木が連続する) の配列に並べ、Update で配列を前から1回たどってワールド行列を計算する
+// SetLocal したノードの部分木だけを計算し直す (部分木は連続しているので、範囲を前から計算するだけ)
+// 変わった祖先を持つノードは祖先の範囲に含まれるので飛ばし、変わっていない部分木には触れない
+// 別々の根 (と大きな部分木の子) の範囲は独立なので、JobSystem で並列に計算する
+// 作成・破棄・親の付け替えはリンクをつなぎ替えるだけで、配列の並べ直しは次の Update でまとめて行う
+// ワールド行列は Update の後に読む。どの関数も Update の途中 (と他のスレッド) から呼ばないこと
+class TransformHierarchy {
+public:
+    // 直前の Update の結果
+    struct Stats {
+        uint32_t nodeCount = 0;
+        uint32_t dirtyRootCount = 0;    // 計算し直した部分木の数
+        uint32_t recomputedCount = 0;   // ワールド行列を計算したノードの数
+        bool rebuilt = false;           // 配列を並べ直したか
+    };
+
+public:
+    // 作る (parent が無効なら根。ローカルの Transform は親の座標で表す)
+    TransformNode Create(const Transform& local, TransformNode parent = TransformNode());
+    // 子孫ごと破棄する
+    void Destroy(TransformNode node);
+    bool IsAlive(TransformNode node) const;
+    // 全て破棄する
+    void Clear();
+
+    // 親を付け替える (parent が無効なら根にする。ローカルの Transform はそのまま。自分の子孫は親にできない)
+    void SetParent(TransformNode node, TransformNode parent);
+    TransformNode GetParent(TransformNode node) const;
+
+    // ローカルの Transform (変えると次の Update で部分木を計算し直す)
+    void SetLocal(TransformNode node, const Transform& local);
+    const Transform& GetLocal(TransformNode node) const;
+
+    // ワールド行列を計算し直す
+    void Update();
+
+    // ワールド行列 (直前の Update のもの)
+    const Matrix4x4& GetWorldMatrix(TransformNode node) const;
+    Vector3 GetWorldPosition(TransformNode node) const;
+
+    uint32_t GetNodeCount() const { return static_cast<uint32_t>(order_.size()) - removedCount_; }
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    // ノードごとのリンク (番号で引く。配列を並べ直しても変わらない)
+    struct Links {
+        uint32_t parent = UINT32_MAX;
+        uint32_t firstChild = UINT32_MAX;
+        uint32_t lastChild = UINT32_MAX;
+        uint32_t previousSibling = UINT32_MAX;
+        uint32_t nextSibling = UINT32_MAX;
+        uint32_t index = UINT32_MAX; // 配列の位置 (破棄したら UINT32_MAX)
+        uint32_t generation = 0;
+        bool dirty = false;          // dirtyIds_ に入っている
+    };
+
+    // 計算し直す範囲 [begin, end)
+    struct Range {
+        uint32_t begin = 0;
+        uint32_t end = 0;
+    };
+
+    uint32_t GetIndex(TransformNode node) const;
+    void Link(uint32_t id, uint32_t parent);
+    void Unlink(uint32_t id);
+    void MarkDirty(uint32_t id);
+    // 変わった祖先があるか (あればその範囲に含まれる)
+    bool HasDirtyAncestor(uint32_t index);
+    // 行きがけ順に並べ直す (破棄したノードも詰める)
+    void Rebuild();
+    // 範囲を前から計算する (範囲の親はもう計算してある)
+    void ComputeRange(uint32_t begin, uint32_t end);
+
+private:
+    std::vector<Links> links_;
+    std::vector<uint32_t> freeIds_;
+    uint32_t firstRoot_ = UINT32_MAX;
+    uint32_t lastRoot_ = UINT32_MAX;
+
+    // 配列の位置ごと (行きがけ順。並べ直すまでは新しいノードが後ろに足してあり、破棄したノードは removed_ が立っている)
+    std::vector<uint32_t> order_;         // ノードの番号
+    std::vector<uint32_t> parents_;       // 親の配列の位置 (根は UINT32_MAX)
+    std::vector<uint32_t> subtreeSizes_;  // 自分を含む子孫の数
+    std::vector<Transform> locals_;
+    std::vector<Matrix4x4> localMatrices_;
+    std::vector<Matrix4x4> worlds_;
+    std::vector<uint8_t> localDirty_;     // localMatrices_ を作り直す
+    std::vector<uint8_t> removed_;
+    std::vector<uint8_t> marks_;          // Update の途中で使う印 (Update の外では全て 0)
+    uint32_t removedCount_ = 0;
+    bool structureChanged_ = false;
+
+    std::vector<uint32_t> dirtyIds_;
+    // Update の作業用 (毎回確保しないように持っておく)
+    std::vector<uint32_t> dirtyIndices_;
+    std::vector<uint32_t> visitedIndices_;
+    std::vector<Range> ranges_;
+    Stats stats_;
+};
@@ -0,0 +1,47 @@
+#include "TransformSystem.h"
+#include <cmath>
+#include "MathUtil.h"
+
+void UpdateTransforms(EntityWorld& world, TransformHierarchy* hierarchy) {
+    world.ParallelForEachChunk<const Transform, LocalToWorld>(EntityQuery().Without<TransformNode>(),
+        [](uint32_t count, const Entity*, const Transform* transforms, LocalToWorld* localToWorlds) {
+            for (uint32_t i = 0; i < count; ++i) {
+                localToWorlds[i].matrix = MakeAffineMatrix(transforms[i].scale, transforms[i].rotate, transforms[i].translate);
+            }
+        });
+    if (hierarchy != nullptr) {
+        hierarchy->Update();
+        world.ParallelForEachChunk<const TransformNode, LocalToWorld>(
+            [hierarchy](uint32_t count, const Entity*, const TransformNode* nodes, LocalToWorld* localToWorlds) {
+                for (uint32_t i = 0; i < count; ++i) {
+                    localToWorlds[i].matrix = hierarchy->GetWorldMatrix(nodes[i]);
+                }
+            });
+    }
+    world.ParallelForEachChunk<const LocalToWorld, const LocalBounds, WorldBounds>(
+        [](uint32_t count, const Entity*, const LocalToWorld* localToWorlds, const LocalBounds* localBounds, WorldBounds* worldBounds) {
+            for (uint32_t i = 0; i < count; ++i) {
+                worldBounds[i] = TransformBounds(localBounds[i], localToWorlds[i].matrix);
+            }
+        });
+}
+
+WorldBounds TransformBounds(const LocalBounds& bounds, const Matrix4x4& matrix) {
+    // 中心を変換し、半分の大きさは行列の絶対値で変換する (8つの角を変換するのと同じ結果)
+    float center[3] = { (bounds.min.x + bounds.max.x) * 0.5f, (bounds.min.y + bounds.max.y) * 0.5f, (bounds.min.z + bounds.max.z) * 0.5f };
+    float extent[3] = { (bounds.max.x - bounds.min.x) * 0.5f, (bounds.max.y - bounds.min.y) * 0.5f, (bounds.max.z - bounds.min.z) * 0.5f };
+    float worldCenter[3];
+    float worldExtent[3];
+    for (int column = 0; column < 3; ++column) {
+        worldCenter[column] = matrix.m[3][column];
+        worldExtent[column] = 0.0f;
+        for (int row = 0; row < 3; ++row) {
+            worldCenter[column] += center[row] * matrix.m[row][column];
+            worldExtent[column] += extent[row] * std::fabs(matrix.m[row][column]);
+        }
+    }
+    WorldBounds result;
+    result.min = { worldCenter[0] - worldExtent[0], worldCenter[1] - worldExtent[1], worldCenter[2] - worldExtent[2] };
+    result.max = { worldCenter[0] + worldExtent[0], worldCenter[1] + worldExtent[1], worldCenter[2] + worldExtent[2] };
+    return result;
+}
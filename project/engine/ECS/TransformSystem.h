@@ -0,0 +1,29 @@
+#pragma once
+#include "EntityWorld.h"
+#include "MathTypes.h"
+#include "TransformHierarchy.h"
+
+// ワールド行列 (UpdateTransforms が Transform から作る)
+struct LocalToWorld {
+    Matrix4x4 matrix;
+};
+
+// メッシュの座標での AABB
+struct LocalBounds {
+    Vector3 min;
+    Vector3 max;
+};
+
+// ワールドの AABB (UpdateTransforms が LocalBounds と LocalToWorld から作る)
+struct WorldBounds {
+    Vector3 min;
+    Vector3 max;
+};
+
+// Transform を持つエンティティの LocalToWorld と、LocalBounds を持つエンティティの WorldBounds を更新する (チャンクごとに並列)
+// hierarchy を渡すと hierarchy を Update し、TransformNode を持つエンティティの LocalToWorld に階層のワールド行列を写す
+// (TransformNode を持つエンティティは Transform を持っていても階層のほうを使う)
+void UpdateTransforms(EntityWorld& world, TransformHierarchy* hierarchy = nullptr);
+
+// AABB を行列で変換して、変換後の全体を囲む AABB を返す
+WorldBounds TransformBounds(const LocalBounds& bounds, const Matrix4x4& matrix);
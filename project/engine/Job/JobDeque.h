@@ -0,0 +1,92 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
+// ワーカーごとのジョブの両端キュー (Chase-Lev。固定長・ロックしない)
+// 持ち主のワーカーは下から入れて下から取り出し (後に入れたものから。キャッシュに残っているうちに続きを処理する)
+// 他のワーカーは上から盗む (古いもの = 大きな仕事から)。取り合いになるのは残り1つのときだけ
+template <typename T>
+class JobDeque {
+public:
+    // 初期化 (容量は2のべきに切り上げる。使い始める前に呼ぶ)
+    void Initialize(uint32_t capacity) {
+        uint32_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        items_ = std::make_unique<std::atomic<T*>[]>(size);
+        mask_ = size - 1;
+        top_.store(0, std::memory_order_relaxed);
+        bottom_.store(0, std::memory_order_relaxed);
+    }
+
+    // 入れる (持ち主だけが呼ぶ。満杯なら false)
+    bool Push(T* item) {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed);
+        int64_t top = top_.load(std::memory_order_acquire);
+        if (bottom - top > static_cast<int64_t>(mask_)) {
+            return false;
+        }
+        // 中身は盗んだ側が acquire で読むので release で書く
+        items_[bottom & mask_].store(item, std::memory_order_release);
+        bottom_.store(bottom + 1, std::memory_order_release);
+        return true;
+    }
+
+    // 後に入れたものを取り出す (持ち主だけが呼ぶ。空なら nullptr)
+    T* Pop() {
+        int64_t bottom = bottom_.load(std::memory_order_relaxed) - 1;
+        bottom_.store(bottom, std::memory_order_relaxed);
+        // 下げた bottom を盗む側に見せてから top を読む (最後の1つを両方が取らないように)
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t top = top_.load(std::memory_order_relaxed);
+        if (top > bottom) {
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+            return nullptr;
+        }
+        T* item = items_[bottom & mask_].load(std::memory_order_acquire);
+        if (top == bottom) {
+            // 最後の1つは盗む側と top の CAS で取り合う
+            if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+                item = nullptr;
+            }
+            bottom_.store(bottom + 1, std::memory_order_relaxed);
+        }
+        return item;
+    }
+
+    // 最も古いものを盗む (どのスレッドから呼んでもよい。空か取り合いに負けたら nullptr)
+    T* Steal() {
+        int64_t top = top_.load(std::memory_order_acquire);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        int64_t bottom = bottom_.load(std::memory_order_acquire);
+        if (top >= bottom) {
+            return nullptr;
+        }
+        T* item = items_[top & mask_].load(std::memory_order_acquire);
+        if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed)) {
+            return nullptr;
+        }
+        return item;
+    }
+
+    // 空に見えるか (他のスレッドからは目安)
+    bool IsEmpty() const {
+        return bottom_.load(std::memory_order_relaxed) <= top_.load(std::memory_order_relaxed);
+    }
+
+    // 入っている数 (他のスレッドからは目安)
+    int64_t GetSize() const {
+        int64_t size = bottom_.load(std::memory_order_relaxed) - top_.load(std::memory_order_relaxed);
+        return size > 0 ? size : 0;
+    }
+
+private:
+    std::unique_ptr<std::atomic<T*>[]> items_;
+    uint64_t mask_ = 0;
+    // 盗む側が進める
+    alignas(64) std::atomic<int64_t> top_ = 0;
+    // 持ち主が進める
+    alignas(64) std::atomic<int64_t> bottom_ = 0;
+};
@@ -0,0 +1,355 @@
+#include "JobSystem.h"
+#include <cassert>
+
+namespace {
+
+// ワーカーごとのキューとプールの大きさ
+const uint32_t kDequeCapacity = 4096;
+const uint32_t kJobPoolSize = 4096;
+// 仕事が見つからないとき、眠る前に探し直す回数
+const uint32_t kSpinCount = 64;
+
+// 呼んだスレッドのワーカーの番号 (ワーカーでなければ -1)
+thread_local int32_t currentWorkerIndex = -1;
+
+uint32_t NextRandom(uint32_t& state) {
+    // xorshift32
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+} // namespace
+
+JobSystem* JobSystem::GetInstance() {
+    static JobSystem instance;
+    return &instance;
+}
+
+void JobSystem::Initialize(uint32_t workerThreadCount) {
+    assert(workers_.empty());
+    if (workerThreadCount == 0) {
+        uint32_t hardwareThreads = std::thread::hardware_concurrency();
+        workerThreadCount = hardwareThreads > 1 ? hardwareThreads - 1 : 0;
+    }
+    exitRequested_.store(false, std::memory_order_relaxed);
+    wakeCount_ = 0;
+    for (uint32_t i = 0; i <= workerThreadCount; ++i) {
+        std::unique_ptr<Worker> worker = std::make_unique<Worker>();
+        worker->deque.Initialize(kDequeCapacity);
+        worker->pool = std::make_unique<Job[]>(kJobPoolSize);
+        worker->random = 0x9E3779B9u * (i + 1);
+        workers_.push_back(std::move(worker));
+    }
+    // 呼んだスレッドはワーカー 0 (Wait の間にジョブを処理する)
+    currentWorkerIndex = 0;
+    for (uint32_t i = 1; i <= workerThreadCount; ++i) {
+        workers_[i]->thread = std::thread(&JobSystem::WorkerMain, this, static_cast<int32_t>(i));
+    }
+}
+
+void JobSystem::Finalize() {
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        exitRequested_.store(true, std::memory_order_relaxed);
+    }
+    sleepCondition_.notify_all();
+    for (std::unique_ptr<Worker>& worker : workers_) {
+        if (worker->thread.joinable()) {
+            worker->thread.join();
+        }
+    }
+    assert(injectQueue_.empty());
+    workers_.clear();
+    currentWorkerIndex = -1;
+}
+
+int32_t JobSystem::GetWorkerIndex() {
+    return currentWorkerIndex;
+}
+
+void JobSystem::Wait(JobCounter* counter) {
+    int32_t workerIndex = currentWorkerIndex;
+    if (workerIndex >= 0) {
+        // 待っている間は他のジョブを処理する (残りが他のワーカーで動いているだけなら譲る)
+        uint32_t idleCount = 0;
+        while (!counter->IsDone()) {
+            if (RunOne(workerIndex)) {
+                idleCount = 0;
+            } else if (++idleCount > kSpinCount) {
+                std::this_thread::yield();
+            }
+        }
+        return;
+    }
+    // ワーカーでないスレッドは、どれかの数え上げが 0 になるたびに起こしてもらう
+    externalWaiterCount_.fetch_add(1, std::memory_order_seq_cst);
+    while (true) {
+        uint32_t epoch = finishEpoch_.load(std::memory_order_seq_cst);
+        if (counter->IsDone()) {
+            break;
+        }
+        if (counter->value_.load(std::memory_order_seq_cst) == 0) {
+            // 0 にしたスレッドが起こした後も、途中で減らした他のスレッドがまだ触れていることがある
+            // そのスレッドは起こしてくれないので、眠らずに離れるのを待つ (すぐ終わる)
+            std::this_thread::yield();
+            continue;
+        }
+        finishEpoch_.wait(epoch, std::memory_order_seq_cst);
+    }
+    externalWaiterCount_.fetch_sub(1, std::memory_order_relaxed);
+}
+
+JobSystem::Stats JobSystem::GetStats() const {
+    Stats stats;
+    for (const std::unique_ptr<Worker>& worker : workers_) {
+        stats.executedCount += worker->executedCount.load(std::memory_order_relaxed);
+        stats.stolenCount += worker->stolenCount.load(std::memory_order_relaxed);
+        stats.heapJobCount += worker->heapJobCount.load(std::memory_order_relaxed);
+        stats.inlineCount += worker->inlineCount.load(std::memory_order_relaxed);
+        stats.sleepCount += worker->sleepCount.load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+void JobSystem::ResetStats() {
+    for (std::unique_ptr<Worker>& worker : workers_) {
+        worker->executedCount.store(0, std::memory_order_relaxed);
+        worker->stolenCount.store(0, std::memory_order_relaxed);
+        worker->heapJobCount.store(0, std::memory_order_relaxed);
+        worker->inlineCount.store(0, std::memory_order_relaxed);
+        worker->sleepCount.store(0, std::memory_order_relaxed);
+    }
+}
+
+Job* JobSystem::AllocateJob() {
+    int32_t workerIndex = currentWorkerIndex;
+    if (workerIndex >= 0) {
+        // プールは持ち主だけが取り出し、終わったジョブはどのワーカーからでも返せる
+        Worker& worker = *workers_[workerIndex];
+        Job* job = &worker.pool[worker.poolIndex++ & (kJobPoolSize - 1)];
+        if (!job->inUse.load(std::memory_order_acquire)) {
+            job->inUse.store(true, std::memory_order_relaxed);
+            job->pooled = true;
+            return job;
+        }
+        // プールを一周してもまだ終わっていない (ジョブを溜めすぎている)
+        worker.heapJobCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    Job* job = new Job;
+    job->pooled = false;
+    return job;
+}
+
+void JobSystem::FreeJob(Job* job) {
+    if (job->pooled) {
+        job->inUse.store(false, std::memory_order_release);
+    } else {
+        delete job;
+    }
+}
+
+void JobSystem::Submit(Job* job) {
+    int32_t workerIndex = currentWorkerIndex;
+    if (workerIndex >= 0) {
+        Worker& worker = *workers_[workerIndex];
+        if (!worker.deque.Push(job)) {
+            // キューが満杯ならその場で処理する
+            worker.inlineCount.fetch_add(1, std::memory_order_relaxed);
+            Execute(job);
+            return;
+        }
+    } else {
+        std::lock_guard<std::mutex> lock(injectMutex_);
+        injectQueue_.push_back(job);
+        injectCount_.fetch_add(1, std::memory_order_relaxed);
+    }
+    WakeWorkers(1);
+}
+
+void JobSystem::AddContinuation(JobCounter* counter, Job* job) {
+    Job* head = counter->continuations_.load(std::memory_order_relaxed);
+    do {
+        job->next = head;
+    } while (!counter->continuations_.compare_exchange_weak(head, job, std::memory_order_seq_cst, std::memory_order_relaxed));
+    // 入れる前に 0 になっていたら、0 にしたスレッドは取り出していないかもしれないので自分で取り出す
+    // (0 にしたスレッドと両方が取り出しても、それぞれ別のジョブを得るだけ)
+    if (counter->value_.load(std::memory_order_seq_cst) == 0) {
+        Job* list = counter->continuations_.exchange(nullptr, std::memory_order_acq_rel);
+        while (list != nullptr) {
+            Job* next = list->next;
+            Submit(list);
+            list = next;
+        }
+    }
+}
+
+void JobSystem::Execute(Job* job) {
+    job->function(*job);
+    JobCounter* counter = job->counter;
+    FreeJob(job);
+    if (counter != nullptr) {
+        Finish(counter);
+    }
+    int32_t workerIndex = currentWorkerIndex;
+    if (workerIndex >= 0) {
+        workers_[workerIndex]->executedCount.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void JobSystem::Finish(JobCounter* counter) {
+    // busy_ を下ろすまでは counter を破棄させない (Wait は value_ と busy_ の両方が 0 になるのを待つ)
+    counter->busy_.fetch_add(1, std::memory_order_relaxed);
+    bool finished = counter->value_.fetch_sub(1, std::memory_order_seq_cst) == 1;
+    if (finished) {
+        Job* list = counter->continuations_.exchange(nullptr, std::memory_order_acq_rel);
+        while (list != nullptr) {
+            Job* next = list->next;
+            Submit(list);
+            list = next;
+        }
+    }
+    counter->busy_.fetch_sub(1, std::memory_order_seq_cst);
+    // ここから先は counter に触れない
+    if (finished && externalWaiterCount_.load(std::memory_order_seq_cst) > 0) {
+        finishEpoch_.fetch_add(1, std::memory_order_seq_cst);
+        finishEpoch_.notify_all();
+    }
+}
+
+bool JobSystem::RunOne(int32_t workerIndex) {
+    Job* job = FindJob(workerIndex);
+    if (job == nullptr) {
+        return false;
+    }
+    Execute(job);
+    return true;
+}
+
+Job* JobSystem::FindJob(int32_t workerIndex) {
+    Worker& self = *workers_[workerIndex];
+    if (Job* job = self.deque.Pop()) {
+        return job;
+    }
+    if (injectCount_.load(std::memory_order_relaxed) > 0) {
+        std::lock_guard<std::mutex> lock(injectMutex_);
+        if (!injectQueue_.empty()) {
+            Job* job = injectQueue_.front();
+            injectQueue_.pop_front();
+            injectCount_.fetch_sub(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    // 他のワーカーから盗む (始める位置をばらして、同じワーカーに集まらないようにする)
+    uint32_t workerCount = static_cast<uint32_t>(workers_.size());
+    uint32_t start = NextRandom(self.random) % workerCount;
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        uint32_t victim = (start + i) % workerCount;
+        if (victim == static_cast<uint32_t>(workerIndex)) {
+            continue;
+        }
+        if (Job* job = workers_[victim]->deque.Steal()) {
+            self.stolenCount.fetch_add(1, std::memory_order_relaxed);
+            return job;
+        }
+    }
+    return nullptr;
+}
+
+bool JobSystem::HasWork() const {
+    if (injectCount_.load(std::memory_order_relaxed) > 0) {
+        return true;
+    }
+    for (const std::unique_ptr<Worker>& worker : workers_) {
+        if (!worker->deque.IsEmpty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void JobSystem::WakeWorkers(uint32_t count) {
+    // 入れたジョブを眠ろうとしているワーカーに見せてから、眠っている数を読む (WorkerMain と対になる)
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    uint32_t sleeping = sleepingCount_.load(std::memory_order_relaxed);
+    if (sleeping == 0) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex_);
+        uint32_t target = count < sleeping ? count : sleeping;
+        if (wakeCount_ < target) {
+            wakeCount_ = target;
+        }
+    }
+    if (count == 1) {
+        sleepCondition_.notify_one();
+    } else {
+        sleepCondition_.notify_all();
+    }
+}
+
+void JobSystem::WorkerMain(int32_t workerIndex) {
+    currentWorkerIndex = workerIndex;
+    Worker& self = *workers_[workerIndex];
+    while (!exitRequested_.load(std::memory_order_relaxed)) {
+        if (RunOne(workerIndex)) {
+            continue;
+        }
+        // すぐに次が来ることが多いので、少し探し直してから眠る
+        bool found = false;
+        for (uint32_t i = 0; i < kSpinCount && !found; ++i) {
+            std::this_thread::yield();
+            found = RunOne(workerIndex);
+        }
+        if (found) {
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleepMutex_);
+        sleepingCount_.fetch_add(1, std::memory_order_relaxed);
+        // 眠っている数を増やしてからジョブを探す (WakeWorkers と対になる)
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (HasWork() || exitRequested_.load(std::memory_order_relaxed)) {
+            sleepingCount_.fetch_sub(1, std::memory_order_relaxed);
+            continue;
+        }
+        self.sleepCount.fetch_add(1, std::memory_order_relaxed);
+        sleepCondition_.wait(lock, [this] { return wakeCount_ > 0 || exitRequested_.load(std::memory_order_relaxed); });
+        if (wakeCount_ > 0) {
+            --wakeCount_;
+        }
+        sleepingCount_.fetch_sub(1, std::memory_order_relaxed);
+    }
+}
+
+void JobSystem::RunRange(const ParallelForTask* task, uint32_t begin, uint32_t end) {
+    int32_t workerIndex = currentWorkerIndex;
+    if (workerIndex < 0) {
+        // ワーカーでないスレッドからは、範囲ごとワーカーに渡して分けてもらう
+        Run([this, task, begin, end] { RunRange(task, begin, end); }, task->counter);
+        return;
+    }
+    // 分けた後も両方が grain 以上になるときだけ分け、1回に渡す数を grain 以上に保つ
+    Worker& self = *workers_[workerIndex];
+    while (end - begin >= task->grain * 2) {
+        if (self.deque.IsEmpty()) {
+            // 自分のキューが空 = 前に分けた分は盗まれた。後ろ半分を盗める形で出しておく
+            uint32_t middle = begin + (end - begin) / 2;
+            Run([this, task, middle, end] { RunRange(task, middle, end); }, task->counter);
+            end = middle;
+        } else {
+            task->invoke(task->body, begin, begin + task->grain);
+            begin += task->grain;
+        }
+    }
+    task->invoke(task->body, begin, end);
+}
+
+uint32_t JobSystem::CalcGrain(uint32_t count) const {
+    // ワーカーあたり32個ほどに分けられる大きさ (これより細かくは分けない)
+    uint32_t pieces = static_cast<uint32_t>(workers_.size()) * 32;
+    uint32_t grain = count / (pieces > 0 ? pieces : 1);
+    return grain > 0 ? grain : 1;
+}
@@ -0,0 +1,213 @@
+#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "JobDeque.h"
+
+class JobCounter;
+
+// 1つのジョブ (関数とその引数をその場に持つ。確保はワーカーごとのプールから)
+struct Job {
+    // 引数を置ける大きさ (ラムダのキャプチャがこれを超えるとコンパイルエラー)
+    static const size_t kStorageSize = 48;
+
+    void (*function)(Job& job) = nullptr;
+    JobCounter* counter = nullptr; // 終わったら1つ減らす
+    Job* next = nullptr;           // 継続のリスト (JobCounter::continuations_)
+    std::atomic<bool> inUse = false;
+    bool pooled = false; // false なら new で確保した (終わったら delete する)
+    alignas(std::max_align_t) std::byte storage[kStorageSize];
+};
+
+// ジョブの数え上げ (0 になったら終わり)
+// Run に渡すと渡したジョブの数だけ増え、それぞれが終わると減る。Wait で 0 になるまで待ち、RunAfter で 0 になったら動くジョブを登録する
+// 0 になった後にまた Run に渡して使い回してよい (ただし誰かが Wait している間に増やさないこと)
+class JobCounter {
+public:
+    JobCounter() = default;
+    JobCounter(const JobCounter&) = delete;
+    JobCounter& operator=(const JobCounter&) = delete;
+
+    // 終わっていないジョブの数
+    int64_t GetValue() const { return value_.load(std::memory_order_acquire); }
+    // 全て終わり、減らしたスレッドもこの数え上げに触れ終えたか (true なら破棄してよい)
+    // ワーカーでないスレッドの Wait は「finishEpoch_ を読む → ここを読む」、Finish は「ここに書く → 待っている数を読む」なので、
+    // どちらも seq_cst にしないと、互いに古い値を読んで起こし損ねることがある
+    bool IsDone() const { return value_.load(std::memory_order_seq_cst) == 0 && busy_.load(std::memory_order_seq_cst) == 0; }
+
+private:
+    friend class JobSystem;
+
+    std::atomic<int64_t> value_ = 0;
+    std::atomic<uint32_t> busy_ = 0; // 減らしている途中のスレッドの数
+    std::atomic<Job*> continuations_ = nullptr;
+};
+
+// ワークスティーリングのジョブシステム
+// ワーカーごとに Chase-Lev の両端キューを持ち、自分のキューが空になったら他のワーカーから盗む。初期化したスレッド (メインスレッド) もワーカー 0 になる
+// ワーカー以外のスレッドから Run したジョブは共有のキューに入れる
+// 待ち方は2つ: Wait はワーカーなら他のジョブを処理しながら待ち (ワーカーを止めない)、RunAfter は数え上げが 0 になったときに続きのジョブを入れる (継続)
+// ParallelFor は範囲を半分ずつに分けながら処理し、自分のキューが空のとき (盗まれて手が空いている他のワーカーがいるとき) だけ分ける (lazy binary splitting)
+// 分ける細かさが負荷に合わせて決まるので、粒度の指定は下限だけでよい
+class JobSystem {
+public:
+    // 統計 (ワーカーごとの数の合計)
+    struct Stats {
+        uint64_t executedCount = 0; // 処理したジョブ
+        uint64_t stolenCount = 0;   // 他のワーカーから盗んだジョブ
+        uint64_t heapJobCount = 0;  // プールが空かず new したジョブ
+        uint64_t inlineCount = 0;   // キューが満杯でその場で処理したジョブ
+        uint64_t sleepCount = 0;    // 仕事が無く眠った回数
+    };
+
+public:
+    // シングルトンインスタンスの取得
+    static JobSystem* GetInstance();
+
+    // 初期化 (呼んだスレッドがワーカー 0 になる。workerThreadCount はそれ以外のワーカーの数で、0 ならコア数 - 1)
+    void Initialize(uint32_t workerThreadCount = 0);
+
+    // 終了処理 (全てのジョブを Wait してから呼ぶ)
+    void Finalize();
+
+    // ワーカーの数 (初期化したスレッドを含む)
+    uint32_t GetWorkerCount() const { return static_cast<uint32_t>(workers_.size()); }
+    // 呼んだスレッドのワーカーの番号 (ワーカーでなければ -1)
+    static int32_t GetWorkerIndex();
+
+    // ジョブを入れる (function は引数なしで呼べるもの。counter があれば1つ増やし、終わったら減らす)
+    template <typename Function>
+    void Run(Function&& function, JobCounter* counter = nullptr) {
+        if (counter != nullptr) {
+            counter->value_.fetch_add(1, std::memory_order_relaxed);
+        }
+        Submit(MakeJob(std::forward<Function>(function), counter));
+    }
+
+    // dependency が 0 になってからジョブを入れる (もう 0 ならすぐ入れる。counter は今増やす)
+    template <typename Function>
+    void RunAfter(JobCounter* dependency, Function&& function, JobCounter* counter = nullptr) {
+        if (counter != nullptr) {
+            counter->value_.fetch_add(1, std::memory_order_relaxed);
+        }
+        AddContinuation(dependency, MakeJob(std::forward<Function>(function), counter));
+    }
+
+    // counter が 0 になるまで待つ (ワーカーなら他のジョブを処理しながら。戻った後は counter を破棄してよい)
+    // 待つ間に処理したジョブが終わるまでは戻れないので、ジョブの中では自分が入れた子だけを待つ (他の依存は RunAfter でつなぐ)
+    void Wait(JobCounter* counter);
+
+    // [begin, end) を分けて body(rangeBegin, rangeEnd) を並列に呼び、全て終わるまで待つ
+    // minGrain は1回の body に渡す数の下限 (0 なら数とワーカーの数から決める)
+    template <typename Body>
+    void ParallelFor(uint32_t begin, uint32_t end, uint32_t minGrain, const Body& body) {
+        if (begin >= end) {
+            return;
+        }
+        ParallelForTask task;
+        task.invoke = [](const void* context, uint32_t rangeBegin, uint32_t rangeEnd) {
+            (*static_cast<const Body*>(context))(rangeBegin, rangeEnd);
+        };
+        task.body = &body;
+        task.grain = minGrain != 0 ? minGrain : CalcGrain(end - begin);
+        JobCounter counter;
+        task.counter = &counter;
+        RunRange(&task, begin, end);
+        Wait(&counter);
+    }
+    template <typename Body>
+    void ParallelFor(uint32_t begin, uint32_t end, const Body& body) {
+        ParallelFor(begin, end, 0, body);
+    }
+
+    Stats GetStats() const;
+    void ResetStats();
+
+private:
+    JobSystem() = default;
+    ~JobSystem() = default;
+    JobSystem(const JobSystem&) = delete;
+    const JobSystem& operator=(const JobSystem&) = delete;
+
+    // ワーカー1つ分 (他のワーカーのものと同じキャッシュラインに載らないようにする)
+    struct alignas(64) Worker {
+        JobDeque<Job> deque;
+        std::unique_ptr<Job[]> pool;
+        uint32_t poolIndex = 0;
+        uint32_t random = 0;
+        std::thread thread;
+        std::atomic<uint64_t> executedCount = 0;
+        std::atomic<uint64_t> stolenCount = 0;
+        std::atomic<uint64_t> heapJobCount = 0;
+        std::atomic<uint64_t> inlineCount = 0;
+        std::atomic<uint64_t> sleepCount = 0;
+    };
+
+    // ParallelFor の本体 (型を消して範囲のジョブから呼ぶ)
+    struct ParallelForTask {
+        void (*invoke)(const void* body, uint32_t rangeBegin, uint32_t rangeEnd) = nullptr;
+        const void* body = nullptr;
+        uint32_t grain = 1;
+        JobCounter* counter = nullptr;
+    };
+
+    template <typename Function>
+    Job* MakeJob(Function&& function, JobCounter* counter) {
+        using Stored = std::decay_t<Function>;
+        static_assert(sizeof(Stored) <= Job::kStorageSize, "job captures are too large (capture by pointer instead)");
+        static_assert(alignof(Stored) <= alignof(std::max_align_t), "job captures are over-aligned");
+        Job* job = AllocateJob();
+        new (job->storage) Stored(std::forward<Function>(function));
+        job->function = [](Job& target) {
+            Stored* stored = std::launder(reinterpret_cast<Stored*>(target.storage));
+            (*stored)();
+            stored->~Stored();
+        };
+        job->counter = counter;
+        job->next = nullptr;
+        return job;
+    }
+
+    Job* AllocateJob();
+    void FreeJob(Job* job);
+    void Submit(Job* job);
+    void AddContinuation(JobCounter* counter, Job* job);
+    void Execute(Job* job);
+    void Finish(JobCounter* counter);
+    // 1つ探して処理する (無ければ false)
+    bool RunOne(int32_t workerIndex);
+    Job* FindJob(int32_t workerIndex);
+    bool HasWork() const;
+    void WakeWorkers(uint32_t count);
+    void WorkerMain(int32_t workerIndex);
+    void RunRange(const ParallelForTask* task, uint32_t begin, uint32_t end);
+    uint32_t CalcGrain(uint32_t count) const;
+
+private:
+    std::vector<std::unique_ptr<Worker>> workers_;
+
+    // ワーカー以外のスレッドから入れたジョブ
+    mutable std::mutex injectMutex_;
+    std::deque<Job*> injectQueue_;
+    std::atomic<uint32_t> injectCount_ = 0;
+
+    // 仕事の無いワーカーを眠らせる
+    std::mutex sleepMutex_;
+    std::condition_variable sleepCondition_;
+    std::atomic<uint32_t> sleepingCount_ = 0;
+    uint32_t wakeCount_ = 0; // 起こす数 (sleepMutex_ で保護)
+    std::atomic<bool> exitRequested_ = false;
+
+    // ワーカー以外のスレッドの Wait を起こす
+    std::atomic<uint32_t> externalWaiterCount_ = 0;
+    std::atomic<uint32_t> finishEpoch_ = 0;
+};
@@ -0,0 +1,200 @@
+#include "LogFormat.h"
+#include <cstdarg>
+#include <cstdio>
+
+namespace {
+
+// {} の中の指定 (":" の後ろ。[<>][0][幅][.精度][型])
+struct FormatSpec {
+    char align = 0;      // '<' 左寄せ / '>' 右寄せ / 0 なら型で決める (文字列は左、数値は右)
+    bool zeroPad = false;
+    int width = 0;
+    int precision = -1;
+    char type = 0;       // 'x' 'X' 'f' 'e' 'g' 'd' など
+};
+
+// "{" の次から "}" までを読む (閉じていなければ false)
+bool ParseSpec(const char*& cursor, FormatSpec& spec) {
+    const char* p = cursor;
+    if (*p == ':') {
+        ++p;
+        if (*p == '<' || *p == '>') {
+            spec.align = *p++;
+        }
+        if (*p == '0') {
+            spec.zeroPad = true;
+            ++p;
+        }
+        while (*p >= '0' && *p <= '9') {
+            spec.width = spec.width * 10 + (*p++ - '0');
+        }
+        if (*p == '.') {
+            ++p;
+            spec.precision = 0;
+            while (*p >= '0' && *p <= '9') {
+                spec.precision = spec.precision * 10 + (*p++ - '0');
+            }
+        }
+        if (*p != '}' && *p != '\0') {
+            spec.type = *p++;
+        }
+    }
+    if (*p != '}') {
+        return false;
+    }
+    cursor = p + 1;
+    return true;
+}
+
+void AppendPrintf(std::string& out, const char* format, ...) {
+    char buffer[128];
+    va_list arguments;
+    va_start(arguments, format);
+    int length = std::vsnprintf(buffer, sizeof(buffer), format, arguments);
+    va_end(arguments);
+    if (length > 0) {
+        out.append(buffer, size_t(length) < sizeof(buffer) ? size_t(length) : sizeof(buffer) - 1);
+    }
+}
+
+// 幅に足りない分を埋める (文字列と bool は左寄せ、数値は右寄せが既定)
+void AppendPadded(std::string& out, std::string_view text, const FormatSpec& spec, bool leftByDefault) {
+    size_t padding = size_t(spec.width) > text.size() ? size_t(spec.width) - text.size() : 0;
+    bool left = spec.align == '<' || (spec.align == 0 && leftByDefault);
+    if (!left) {
+        out.append(padding, ' ');
+    }
+    out.append(text);
+    if (left) {
+        out.append(padding, ' ');
+    }
+}
+
+// wchar_t (Windowsでは UTF-16、Linuxでは UTF-32) を UTF-8 にする
+void AppendWide(std::string& out, const LogWideText& text) {
+    for (uint32_t i = 0; i < text.size; ++i) {
+        wchar_t unit;
+        std::memcpy(&unit, text.data + size_t(i) * sizeof(wchar_t), sizeof(unit));
+        uint32_t code = static_cast<uint32_t>(unit);
+        if constexpr (sizeof(wchar_t) == 2) {
+            code &= 0xFFFF;
+            if (code >= 0xD800 && code < 0xDC00 && i + 1 < text.size) {
+                wchar_t low;
+                std::memcpy(&low, text.data + size_t(i + 1) * sizeof(wchar_t), sizeof(low));
+                uint32_t lowCode = static_cast<uint32_t>(low) & 0xFFFF;
+                if (lowCode >= 0xDC00 && lowCode < 0xE000) {
+                    code = 0x10000 + ((code - 0xD800) << 10) + (lowCode - 0xDC00);
+                    ++i;
+                }
+            }
+        }
+        if (code < 0x80) {
+            out.push_back(char(code));
+        } else if (code < 0x800) {
+            out.push_back(char(0xC0 | (code >> 6)));
+            out.push_back(char(0x80 | (code & 0x3F)));
+        } else if (code < 0x10000) {
+            out.push_back(char(0xE0 | (code >> 12)));
+            out.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(char(0x80 | (code & 0x3F)));
+        } else {
+            out.push_back(char(0xF0 | (code >> 18)));
+            out.push_back(char(0x80 | ((code >> 12) & 0x3F)));
+            out.push_back(char(0x80 | ((code >> 6) & 0x3F)));
+            out.push_back(char(0x80 | (code & 0x3F)));
+        }
+    }
+}
+
+void AppendValue(std::string& out, const LogValue& value, const FormatSpec& spec) {
+    bool hex = spec.type == 'x' || spec.type == 'X';
+    // 数値は printf の書式を組み立てる ("%0*llx" など)
+    char format[16];
+    int length = 0;
+    format[length++] = '%';
+    if (spec.align == '<') {
+        format[length++] = '-';
+    } else if (spec.zeroPad) {
+        format[length++] = '0';
+    }
+    format[length++] = '*';
+
+    switch (value.type) {
+    case LogValue::Type::kBool:
+        AppendPadded(out, value.boolean ? "true" : "false", spec, true);
+        break;
+    case LogValue::Type::kChar:
+        AppendPadded(out, std::string_view(&value.character, 1), spec, true);
+        break;
+    case LogValue::Type::kSigned:
+    case LogValue::Type::kUnsigned:
+        format[length++] = 'l';
+        format[length++] = 'l';
+        format[length++] = hex ? spec.type : value.type == LogValue::Type::kSigned ? 'd' : 'u';
+        format[length] = '\0';
+        if (value.type == LogValue::Type::kSigned && !hex) {
+            AppendPrintf(out, format, spec.width, static_cast<long long>(value.signedInteger));
+        } else {
+            AppendPrintf(out, format, spec.width, static_cast<unsigned long long>(value.unsignedInteger));
+        }
+        break;
+    case LogValue::Type::kFloat:
+        format[length++] = '.';
+        format[length++] = '*';
+        format[length++] = spec.type == 'f' || spec.type == 'e' || spec.type == 'g' ? spec.type : spec.precision >= 0 ? 'f' : 'g';
+        format[length] = '\0';
+        AppendPrintf(out, format, spec.width, spec.precision >= 0 ? spec.precision : 6, value.floatingPoint);
+        break;
+    case LogValue::Type::kPointer:
+        AppendPrintf(out, "0x%0*llx", int(sizeof(void*) * 2), static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(value.pointer)));
+        break;
+    case LogValue::Type::kText:
+        AppendPadded(out, std::string_view(value.text.data, value.text.size), spec, true);
+        break;
+    case LogValue::Type::kWideText:
+        if (spec.width > 0) {
+            std::string text;
+            AppendWide(text, value.wideText);
+            AppendPadded(out, text, spec, true);
+        } else {
+            AppendWide(out, value.wideText);
+        }
+        break;
+    case LogValue::Type::kNone:
+        break;
+    }
+}
+
+} // namespace
+
+void FormatLog(std::string& out, const char* format, const LogValue* values, size_t valueCount) {
+    size_t index = 0;
+    const char* cursor = format;
+    while (*cursor != '\0') {
+        char c = *cursor;
+        if (c == '{' && cursor[1] == '{') {
+            out.push_back('{');
+            cursor += 2;
+            continue;
+        }
+        if (c == '}' && cursor[1] == '}') {
+            out.push_back('}');
+            cursor += 2;
+            continue;
+        }
+        if (c != '{') {
+            out.push_back(c);
+            ++cursor;
+            continue;
+        }
+        // 閉じていない・引数が足りない {} はそのまま出す (書式の間違いに気付けるように)
+        const char* open = cursor++;
+        FormatSpec spec;
+        if (!ParseSpec(cursor, spec) || index >= valueCount) {
+            cursor = open + 1;
+            out.push_back('{');
+            continue;
+        }
+        AppendValue(out, values[index++], spec);
+    }
+}
@@ -0,0 +1,217 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+
+// ログの引数の保存と整形
+// 呼んだスレッドでは引数をバイト列のまま保存するだけにし、文字列にするのは書き出しのスレッドで行う
+// 書式は std::format と同じ "{}" で、"{:08x}" "{:.2f}" "{:>8}" のような幅・精度・型の一部だけを扱う ("{{" "}}" は括弧そのもの)
+// 引数は数値・bool・列挙型・ポインタ・文字列 (char / wchar_t) を使える。書式の文字列はリテラルにすること (アドレスだけを保存する)
+
+// 保存した文字列 (書き出しのスレッドでだけ使う)
+struct LogText {
+    const char* data = nullptr;
+    uint32_t size = 0;
+};
+
+// 保存したワイド文字列 (並びが揃っていないことがあるので1文字ずつ memcpy で読む)
+struct LogWideText {
+    const std::byte* data = nullptr;
+    uint32_t size = 0;
+};
+
+// 整形に渡す1つの値
+struct LogValue {
+    enum class Type : uint8_t {
+        kNone,
+        kBool,
+        kChar,
+        kSigned,
+        kUnsigned,
+        kFloat,
+        kPointer,
+        kText,
+        kWideText,
+    };
+
+    Type type = Type::kNone;
+    union {
+        bool boolean;
+        char character;
+        int64_t signedInteger;
+        uint64_t unsignedInteger;
+        double floatingPoint;
+        const void* pointer;
+        LogText text;
+        LogWideText wideText;
+    };
+
+    LogValue() : signedInteger(0) {}
+};
+
+// format の {} に values を順に埋めて out の後ろに足す
+void FormatLog(std::string& out, const char* format, const LogValue* values, size_t valueCount);
+
+namespace LogDetail {
+
+// 書き出しのスレッドで引数を読み直して整形する関数 (引数の型の組み合わせごとに作られる)
+using DecodeFunction = void (*)(std::string& out, const char* format, const std::byte* arguments);
+
+// 保存するときの型 (配列は要素の const ポインタ、それ以外は参照と const を外した型)
+template <typename T>
+using ArgType = std::conditional_t<std::is_array_v<T>, const std::remove_extent_t<T>*, std::decay_t<T>>;
+
+template <typename T>
+inline constexpr bool kIsNarrowText = std::is_same_v<T, const char*> || std::is_same_v<T, char*> ||
+    std::is_same_v<T, std::string> || std::is_same_v<T, std::string_view>;
+
+template <typename T>
+inline constexpr bool kIsWideText = std::is_same_v<T, const wchar_t*> || std::is_same_v<T, wchar_t*> ||
+    std::is_same_v<T, std::wstring> || std::is_same_v<T, std::wstring_view>;
+
+template <typename T>
+std::string_view ToView(const T& text) {
+    if constexpr (std::is_pointer_v<T>) {
+        return text != nullptr ? std::string_view(text) : std::string_view("(null)");
+    } else {
+        return std::string_view(text);
+    }
+}
+
+template <typename T>
+std::wstring_view ToWideView(const T& text) {
+    if constexpr (std::is_pointer_v<T>) {
+        return text != nullptr ? std::wstring_view(text) : std::wstring_view(L"(null)");
+    } else {
+        return std::wstring_view(text);
+    }
+}
+
+// 型ごとの保存のしかた (長さ → 書く → 読む)。対応していない型はコンパイルエラーになる
+template <typename T, typename Enable = void>
+struct ArgCodec;
+
+// 数値・bool
+template <typename T>
+struct ArgCodec<T, std::enable_if_t<std::is_arithmetic_v<T>>> {
+    using Decoded = T;
+    static size_t Size(const T&) { return sizeof(T); }
+    static std::byte* Write(std::byte* out, const T& value) {
+        std::memcpy(out, &value, sizeof(T));
+        return out + sizeof(T);
+    }
+    static const std::byte* Read(const std::byte* in, Decoded& value) {
+        std::memcpy(&value, in, sizeof(T));
+        return in + sizeof(T);
+    }
+};
+
+// 列挙型 (元の整数として書く)
+template <typename T>
+struct ArgCodec<T, std::enable_if_t<std::is_enum_v<T>>> : ArgCodec<std::underlying_type_t<T>> {
+    using Base = ArgCodec<std::underlying_type_t<T>>;
+    static size_t Size(const T&) { return sizeof(T); }
+    static std::byte* Write(std::byte* out, const T& value) { return Base::Write(out, static_cast<std::underlying_type_t<T>>(value)); }
+};
+
+// 文字列以外のポインタ (アドレスを書く)
+template <typename T>
+struct ArgCodec<T, std::enable_if_t<std::is_pointer_v<T> && !kIsNarrowText<T> && !kIsWideText<T>>> {
+    using Decoded = const void*;
+    static size_t Size(const T&) { return sizeof(const void*); }
+    static std::byte* Write(std::byte* out, const T& value) {
+        const void* pointer = value;
+        std::memcpy(out, &pointer, sizeof(pointer));
+        return out + sizeof(pointer);
+    }
+    static const std::byte* Read(const std::byte* in, Decoded& value) {
+        std::memcpy(&value, in, sizeof(value));
+        return in + sizeof(value);
+    }
+};
+
+// 文字列 (長さと中身をコピーする)
+template <typename T>
+struct ArgCodec<T, std::enable_if_t<kIsNarrowText<T>>> {
+    using Decoded = LogText;
+    static size_t Size(const T& value) { return sizeof(uint32_t) + ToView(value).size(); }
+    static std::byte* Write(std::byte* out, const T& value) {
+        std::string_view view = ToView(value);
+        uint32_t size = static_cast<uint32_t>(view.size());
+        std::memcpy(out, &size, sizeof(size));
+        std::memcpy(out + sizeof(size), view.data(), size);
+        return out + sizeof(size) + size;
+    }
+    static const std::byte* Read(const std::byte* in, Decoded& value) {
+        std::memcpy(&value.size, in, sizeof(value.size));
+        value.data = reinterpret_cast<const char*>(in + sizeof(value.size));
+        return in + sizeof(value.size) + value.size;
+    }
+};
+
+// ワイド文字列 (UTF-8 への変換は書き出しのスレッドで行う)
+template <typename T>
+struct ArgCodec<T, std::enable_if_t<kIsWideText<T>>> {
+    using Decoded = LogWideText;
+    static size_t Size(const T& value) { return sizeof(uint32_t) + ToWideView(value).size() * sizeof(wchar_t); }
+    static std::byte* Write(std::byte* out, const T& value) {
+        std::wstring_view view = ToWideView(value);
+        uint32_t size = static_cast<uint32_t>(view.size());
+        std::memcpy(out, &size, sizeof(size));
+        std::memcpy(out + sizeof(size), view.data(), size * sizeof(wchar_t));
+        return out + sizeof(size) + size * sizeof(wchar_t);
+    }
+    static const std::byte* Read(const std::byte* in, Decoded& value) {
+        std::memcpy(&value.size, in, sizeof(value.size));
+        value.data = in + sizeof(value.size);
+        return in + sizeof(value.size) + value.size * sizeof(wchar_t);
+    }
+};
+
+template <typename T>
+LogValue MakeValue(const T& decoded) {
+    LogValue value;
+    if constexpr (std::is_same_v<T, bool>) {
+        value.type = LogValue::Type::kBool;
+        value.boolean = decoded;
+    } else if constexpr (std::is_same_v<T, char>) {
+        value.type = LogValue::Type::kChar;
+        value.character = decoded;
+    } else if constexpr (std::is_floating_point_v<T>) {
+        value.type = LogValue::Type::kFloat;
+        value.floatingPoint = static_cast<double>(decoded);
+    } else if constexpr (std::is_integral_v<T> && std::is_signed_v<T>) {
+        value.type = LogValue::Type::kSigned;
+        value.signedInteger = static_cast<int64_t>(decoded);
+    } else if constexpr (std::is_integral_v<T>) {
+        value.type = LogValue::Type::kUnsigned;
+        value.unsignedInteger = static_cast<uint64_t>(decoded);
+    } else if constexpr (std::is_same_v<T, const void*>) {
+        value.type = LogValue::Type::kPointer;
+        value.pointer = decoded;
+    } else if constexpr (std::is_same_v<T, LogText>) {
+        value.type = LogValue::Type::kText;
+        value.text = decoded;
+    } else {
+        static_assert(std::is_same_v<T, LogWideText>);
+        value.type = LogValue::Type::kWideText;
+        value.wideText = decoded;
+    }
+    return value;
+}
+
+template <typename... Args>
+void Decode(std::string& out, const char* format, const std::byte* arguments) {
+    std::tuple<typename ArgCodec<Args>::Decoded...> decoded;
+    std::apply([&](auto&... values) { ((arguments = ArgCodec<Args>::Read(arguments, values)), ...); }, decoded);
+    std::apply([&](const auto&... values) {
+        const LogValue list[] = { MakeValue(values)..., LogValue() };
+        FormatLog(out, format, list, sizeof...(Args));
+    }, decoded);
+}
+
+} // namespace LogDetail
@@ -0,0 +1,350 @@
+#include "Logger.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#if defined(_WIN32)
+#include <Windows.h>
+#endif
+
+// スレッドごとのリングバッファ (そのスレッドが書き、書き出しのスレッドが読む)
+// 1件は [ヘッダー][引数のバイト列] を8バイトに揃えたもので、終わりに入りきらないときは先頭に戻る
+struct LogDetail::ThreadBuffer {
+    std::unique_ptr<std::byte[]> data;
+    uint64_t mask = 0;
+    uint32_t threadIndex = 0;
+
+    // 書き出しのスレッドが進める
+    alignas(64) std::atomic<uint64_t> head = 0;
+    uint64_t drainedTail = 0;
+
+    // 書くスレッドが進める
+    alignas(64) std::atomic<uint64_t> tail = 0;
+    uint64_t cachedHead = 0;
+    uint64_t recordStart = 0;
+    uint64_t recordSize = 0;
+    std::atomic<uint64_t> dropped = 0;
+    std::atomic<bool> retired = false; // スレッドが終わった (読み終えたら捨てる)
+};
+
+namespace {
+
+// 1件のヘッダー (decode が nullptr なら先頭に戻るための詰め物)
+struct RecordHeader {
+    uint32_t size;
+    LogLevel level;
+    LogCategory category;
+    int64_t timestamp;
+    LogDetail::DecodeFunction decode;
+    const char* format;
+};
+
+const uint64_t kRecordAlignment = 8;
+
+// スレッドが持つバッファ (スレッドが終わると retired にする)
+struct ThreadSlot {
+    std::shared_ptr<LogDetail::ThreadBuffer> buffer;
+    uint64_t generation = 0;
+
+    ~ThreadSlot() {
+        if (buffer != nullptr) {
+            buffer->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadSlot threadSlot;
+
+const char* const kLevelNames[] = { "TRACE", "DEBUG", "INFO ", "WARN ", "ERROR", "OFF  " };
+const char* const kCategoryNames[] = { "General ", "Graphics", "Pipeline", "Texture ", "Audio   " };
+static_assert(sizeof(kCategoryNames) / sizeof(kCategoryNames[0]) == size_t(LogCategory::kCount));
+
+int64_t NowNanoseconds() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// logs/20250929_144104.log のような名前
+std::string MakeFilePath(const std::string& directory) {
+    std::time_t now = std::time(nullptr);
+    std::tm local{};
+#if defined(_WIN32)
+    localtime_s(&local, &now);
+#else
+    localtime_r(&now, &local);
+#endif
+    char name[32];
+    std::strftime(name, sizeof(name), "%Y%m%d_%H%M%S.log", &local);
+    return (std::filesystem::path(directory) / name).generic_string();
+}
+
+} // namespace
+
+Logger* Logger::GetInstance() {
+    static Logger instance;
+    return &instance;
+}
+
+Logger::Logger() {
+    for (std::atomic<uint8_t>& level : levels_) {
+        level.store(uint8_t(LogLevel::kOff), std::memory_order_relaxed);
+    }
+}
+
+void Logger::Initialize(const LogSettings& settings) {
+    assert(!writer_.joinable());
+    settings_ = settings;
+    startTime_ = NowNanoseconds();
+    writtenCount_ = 0;
+    droppedCount_ = 0;
+    writtenBytes_ = 0;
+
+    if (!settings_.directory.empty()) {
+        std::error_code ec;
+        std::filesystem::create_directories(settings_.directory, ec);
+        filePath_ = MakeFilePath(settings_.directory);
+#if defined(_WIN32)
+        if (fopen_s(&file_, filePath_.c_str(), "wb") != 0) {
+            file_ = nullptr;
+        }
+#else
+        file_ = std::fopen(filePath_.c_str(), "wb");
+#endif
+    }
+
+    exitRequested_ = false;
+    flushRequested_ = 0;
+    flushCompleted_ = 0;
+    nextThreadIndex_ = 0;
+    generation_.fetch_add(1, std::memory_order_release);
+    writer_ = std::thread(&Logger::WriterMain, this);
+    SetLevel(settings_.level);
+}
+
+void Logger::Finalize() {
+    if (!writer_.joinable()) {
+        return;
+    }
+    SetLevel(LogLevel::kOff);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        exitRequested_ = true;
+    }
+    wakeCondition_.notify_one();
+    writer_.join();
+
+    if (file_ != nullptr) {
+        std::fclose(file_);
+        file_ = nullptr;
+    }
+    buffers_.clear();
+    // 残っているスレッドのバッファは次に書いたときに作り直させる
+    generation_.fetch_add(1, std::memory_order_release);
+}
+
+void Logger::SetLevel(LogLevel level) {
+    for (std::atomic<uint8_t>& categoryLevel : levels_) {
+        categoryLevel.store(uint8_t(level), std::memory_order_relaxed);
+    }
+}
+
+void Logger::SetLevel(LogCategory category, LogLevel level) {
+    levels_[size_t(category)].store(uint8_t(level), std::memory_order_relaxed);
+}
+
+void Logger::Flush() {
+    if (!writer_.joinable()) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    uint64_t ticket = ++flushRequested_;
+    wakeCondition_.notify_one();
+    flushCondition_.wait(lock, [&] { return flushCompleted_ >= ticket || exitRequested_; });
+}
+
+Logger::Stats Logger::GetStats() const {
+    Stats stats;
+    stats.writtenCount = writtenCount_.load(std::memory_order_relaxed);
+    stats.droppedCount = droppedCount_.load(std::memory_order_relaxed);
+    stats.writtenBytes = writtenBytes_.load(std::memory_order_relaxed);
+    return stats;
+}
+
+LogDetail::ThreadBuffer* Logger::GetThreadBuffer() {
+    uint64_t generation = generation_.load(std::memory_order_acquire);
+    if (threadSlot.generation == generation) {
+        return threadSlot.buffer.get();
+    }
+    // このスレッドで初めて書く (または Initialize し直した)
+    if (threadSlot.buffer != nullptr) {
+        threadSlot.buffer->retired.store(true, std::memory_order_release);
+    }
+    uint64_t capacity = 1024;
+    while (capacity < settings_.threadBufferSize) {
+        capacity <<= 1;
+    }
+    std::shared_ptr<LogDetail::ThreadBuffer> buffer = std::make_shared<LogDetail::ThreadBuffer>();
+    buffer->data = std::make_unique<std::byte[]>(capacity);
+    buffer->mask = capacity - 1;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffer->threadIndex = nextThreadIndex_++;
+        buffers_.push_back(buffer);
+    }
+    threadSlot.buffer = std::move(buffer);
+    threadSlot.generation = generation;
+    return threadSlot.buffer.get();
+}
+
+std::byte* Logger::Reserve(size_t argumentSize, LogDetail::ThreadBuffer** out) {
+    LogDetail::ThreadBuffer* buffer = GetThreadBuffer();
+    uint64_t capacity = buffer->mask + 1;
+    uint64_t size = (sizeof(RecordHeader) + argumentSize + kRecordAlignment - 1) & ~(kRecordAlignment - 1);
+    if (size > capacity / 2) {
+        buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+        return nullptr;
+    }
+
+    // 終わりに入りきらなければ、残りを飛ばして先頭から書く
+    uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+    uint64_t remaining = capacity - (tail & buffer->mask);
+    uint64_t skip = remaining < size ? remaining : 0;
+    if (tail + skip + size - buffer->cachedHead > capacity) {
+        buffer->cachedHead = buffer->head.load(std::memory_order_acquire);
+        if (tail + skip + size - buffer->cachedHead > capacity) {
+            buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return nullptr;
+        }
+    }
+    if (skip >= sizeof(RecordHeader)) {
+        RecordHeader padding{};
+        padding.size = static_cast<uint32_t>(skip);
+        std::memcpy(buffer->data.get() + (tail & buffer->mask), &padding, sizeof(padding));
+    }
+    buffer->recordStart = tail + skip;
+    buffer->recordSize = size;
+    *out = buffer;
+    return buffer->data.get() + (buffer->recordStart & buffer->mask) + sizeof(RecordHeader);
+}
+
+void Logger::Commit(LogDetail::ThreadBuffer* buffer, LogLevel level, LogCategory category, const char* format,
+    LogDetail::DecodeFunction decode) {
+    RecordHeader header;
+    header.size = static_cast<uint32_t>(buffer->recordSize);
+    header.level = level;
+    header.category = category;
+    header.timestamp = NowNanoseconds() - startTime_;
+    header.decode = decode;
+    header.format = format;
+    std::memcpy(buffer->data.get() + (buffer->recordStart & buffer->mask), &header, sizeof(header));
+    buffer->tail.store(buffer->recordStart + buffer->recordSize, std::memory_order_release);
+    if (level >= settings_.flushLevel) {
+        Flush();
+    }
+}
+
+void Logger::WriterMain() {
+    std::vector<std::shared_ptr<LogDetail::ThreadBuffer>> buffers;
+    std::string text;
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (true) {
+        wakeCondition_.wait_for(lock, std::chrono::milliseconds(settings_.flushIntervalMilliseconds),
+            [&] { return exitRequested_ || flushRequested_ != flushCompleted_; });
+        bool exit = exitRequested_;
+        uint64_t request = flushRequested_;
+        buffers = buffers_;
+        lock.unlock();
+
+        text.clear();
+        Drain(buffers, text);
+        Output(text);
+
+        lock.lock();
+        // 終わったスレッドのバッファは読み終えたら捨てる
+        buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(), [](const std::shared_ptr<LogDetail::ThreadBuffer>& buffer) {
+            return buffer->retired.load(std::memory_order_acquire) &&
+                buffer->head.load(std::memory_order_relaxed) == buffer->tail.load(std::memory_order_acquire);
+        }), buffers_.end());
+        flushCompleted_ = request;
+        flushCondition_.notify_all();
+        if (exit) {
+            break;
+        }
+    }
+}
+
+void Logger::Drain(const std::vector<std::shared_ptr<LogDetail::ThreadBuffer>>& buffers, std::string& text) {
+    // 全てのバッファから読めるだけ集めて、時刻順に並べる
+    struct Entry {
+        int64_t timestamp;
+        uint32_t threadIndex;
+        const std::byte* record;
+    };
+    std::vector<Entry> entries;
+    uint64_t dropped = 0;
+    for (const std::shared_ptr<LogDetail::ThreadBuffer>& buffer : buffers) {
+        uint64_t capacity = buffer->mask + 1;
+        uint64_t head = buffer->head.load(std::memory_order_relaxed);
+        uint64_t tail = buffer->tail.load(std::memory_order_acquire);
+        while (head != tail) {
+            uint64_t offset = head & buffer->mask;
+            if (capacity - offset < sizeof(RecordHeader)) {
+                head += capacity - offset;
+                continue;
+            }
+            RecordHeader header;
+            std::memcpy(&header, buffer->data.get() + offset, sizeof(header));
+            if (header.decode != nullptr) {
+                entries.push_back({ header.timestamp, buffer->threadIndex, buffer->data.get() + offset });
+            }
+            head += header.size;
+        }
+        buffer->drainedTail = tail;
+        dropped += buffer->dropped.exchange(0, std::memory_order_relaxed);
+    }
+    std::stable_sort(entries.begin(), entries.end(), [](const Entry& a, const Entry& b) { return a.timestamp < b.timestamp; });
+
+    // [   12.345678] INFO  Pipeline T0  メッセージ
+    for (const Entry& entry : entries) {
+        RecordHeader header;
+        std::memcpy(&header, entry.record, sizeof(header));
+        char prefix[64];
+        int length = std::snprintf(prefix, sizeof(prefix), "[%12.6f] %s %s T%-2u ", double(header.timestamp) / 1e9,
+            kLevelNames[size_t(header.level)], kCategoryNames[size_t(header.category)], entry.threadIndex);
+        text.append(prefix, size_t(length));
+        header.decode(text, header.format, entry.record + sizeof(RecordHeader));
+        text.push_back('\n');
+    }
+    if (dropped > 0) {
+        char line[96];
+        int length = std::snprintf(line, sizeof(line), "[%12.6f] WARN  General  --  %llu log messages dropped (buffer full)\n",
+            double(NowNanoseconds() - startTime_) / 1e9, static_cast<unsigned long long>(dropped));
+        text.append(line, size_t(length));
+    }
+
+    // 読み終えた場所を返す (ここから先はスレッドが上書きしてよい)
+    for (const std::shared_ptr<LogDetail::ThreadBuffer>& buffer : buffers) {
+        buffer->head.store(buffer->drainedTail, std::memory_order_release);
+    }
+    writtenCount_.fetch_add(entries.size(), std::memory_order_relaxed);
+    droppedCount_.fetch_add(dropped, std::memory_order_relaxed);
+}
+
+void Logger::Output(const std::string& text) {
+    if (text.empty()) {
+        return;
+    }
+    if (file_ != nullptr) {
+        std::fwrite(text.data(), 1, text.size(), file_);
+        std::fflush(file_);
+    }
+    if (settings_.writeToConsole) {
+        std::fwrite(text.data(), 1, text.size(), stdout);
+    }
+#if defined(_WIN32)
+    if (settings_.writeToDebugger) {
+        OutputDebugStringA(text.c_str());
+    }
+#endif
+    writtenBytes_.fetch_add(text.size(), std::memory_order_relaxed);
+}
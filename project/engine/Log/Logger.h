@@ -0,0 +1,172 @@
+#pragma once
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "LogFormat.h"
+
+// ログの重要度 (設定した重要度より低いものは書かない)
+enum class LogLevel : uint8_t {
+    kTrace,
+    kDebug,
+    kInfo,
+    kWarning,
+    kError,
+    kOff,
+};
+
+// ログの分類 (分類ごとに重要度を設定できる)
+enum class LogCategory : uint8_t {
+    kGeneral,
+    kGraphics,
+    kPipeline,
+    kTexture,
+    kAudio,
+    kCount,
+};
+
+// ロガーの設定
+struct LogSettings {
+    std::string directory = "logs";            // ファイルを作るディレクトリ (日時の名前で作る。空ならファイルに書かない)
+    uint32_t threadBufferSize = 256 * 1024;     // スレッドごとのリングバッファのバイト数 (2のべきに切り上げる)
+    uint32_t flushIntervalMilliseconds = 10;    // 書き出しのスレッドが起きる間隔
+    LogLevel level = LogLevel::kDebug;          // 全ての分類の最初の重要度
+    LogLevel flushLevel = LogLevel::kError;     // これ以上の重要度は書き出し終わるまで待つ (直後に落ちても残るように)
+    bool writeToDebugger = true;                // デバッガーの出力ウィンドウにも出す (Windowsのみ)
+    bool writeToConsole = false;                // 標準出力にも出す
+};
+
+namespace LogDetail {
+struct ThreadBuffer;
+}
+
+// ログ
+// 呼んだスレッドはスレッドごとのリングバッファに引数をバイト列で書くだけで、ロックもファイルへの書き込みも待たない
+// 書き出しのスレッドが定期的に全てのバッファを集め、時刻順に並べて文字列にし、ファイル (logs/日時.log) とデバッガーへ出す
+// バッファが一杯のときは書かずに捨て、捨てた数を後でログに残す
+// Initialize / Finalize はメインスレッドから、他のスレッドがログを書いていないときに呼ぶ
+class Logger {
+public:
+    struct Stats {
+        uint64_t writtenCount = 0; // 書き出した数
+        uint64_t droppedCount = 0; // バッファが一杯で捨てた数
+        uint64_t writtenBytes = 0; // 書き出した文字列のバイト数
+    };
+
+public:
+    // シングルトンインスタンスの取得
+    static Logger* GetInstance();
+
+    // 初期化 (ファイルを作り、書き出しのスレッドを始める)
+    void Initialize(const LogSettings& settings);
+
+    // 終了処理 (残っているログを全て書き出してから止める)
+    void Finalize();
+
+    // 重要度の設定 (どのスレッドから呼んでもよい)
+    void SetLevel(LogLevel level);
+    void SetLevel(LogCategory category, LogLevel level);
+    LogLevel GetLevel(LogCategory category) const { return LogLevel(levels_[size_t(category)].load(std::memory_order_relaxed)); }
+    bool IsEnabled(LogLevel level, LogCategory category) const {
+        return uint8_t(level) >= levels_[size_t(category)].load(std::memory_order_relaxed);
+    }
+
+    // 書く (format は "{}" の書式のリテラル。文字列にするのは書き出しのスレッド)
+    template <typename... Args>
+    void Write(LogLevel level, LogCategory category, const char* format, const Args&... args);
+
+    // ここまでに書いたログを全て書き出すまで待つ
+    void Flush();
+
+    const std::string& GetFilePath() const { return filePath_; }
+    Stats GetStats() const;
+
+private:
+    Logger();
+    ~Logger() = default;
+    Logger(const Logger&) = delete;
+    const Logger& operator=(const Logger&) = delete;
+
+    // 呼んだスレッドのバッファに引数の分の場所を取る (一杯なら nullptr)
+    std::byte* Reserve(size_t argumentSize, LogDetail::ThreadBuffer** buffer);
+    // 取った場所を書き出しのスレッドに渡す
+    void Commit(LogDetail::ThreadBuffer* buffer, LogLevel level, LogCategory category, const char* format,
+        LogDetail::DecodeFunction decode);
+    LogDetail::ThreadBuffer* GetThreadBuffer();
+
+    void WriterMain();
+    void Drain(const std::vector<std::shared_ptr<LogDetail::ThreadBuffer>>& buffers, std::string& text);
+    void Output(const std::string& text);
+
+private:
+    LogSettings settings_;
+    std::array<std::atomic<uint8_t>, size_t(LogCategory::kCount)> levels_ = {};
+    // Initialize のたびに変わる (前の Initialize で作ったスレッドのバッファを使わないように)
+    std::atomic<uint64_t> generation_ = 0;
+    int64_t startTime_ = 0;
+
+    // スレッドのバッファと、書き出しのスレッドとのやり取り (mutex_ で保護)
+    std::mutex mutex_;
+    std::condition_variable wakeCondition_;
+    std::condition_variable flushCondition_;
+    std::vector<std::shared_ptr<LogDetail::ThreadBuffer>> buffers_;
+    uint32_t nextThreadIndex_ = 0;
+    uint64_t flushRequested_ = 0;
+    uint64_t flushCompleted_ = 0;
+    bool exitRequested_ = false;
+    std::thread writer_;
+
+    // 書き出しのスレッドだけが触る
+    std::FILE* file_ = nullptr;
+    std::string filePath_;
+    std::atomic<uint64_t> writtenCount_ = 0;
+    std::atomic<uint64_t> droppedCount_ = 0;
+    std::atomic<uint64_t> writtenBytes_ = 0;
+};
+
+template <typename... Args>
+void Logger::Write(LogLevel level, LogCategory category, const char* format, const Args&... args) {
+    if (!IsEnabled(level, category)) {
+        return;
+    }
+    size_t argumentSize = (size_t(0) + ... + LogDetail::ArgCodec<LogDetail::ArgType<Args>>::Size(args));
+    LogDetail::ThreadBuffer* buffer = nullptr;
+    std::byte* arguments = Reserve(argumentSize, &buffer);
+    if (arguments == nullptr) {
+        return;
+    }
+    ((arguments = LogDetail::ArgCodec<LogDetail::ArgType<Args>>::Write(arguments, args)), ...);
+    Commit(buffer, level, category, format, &LogDetail::Decode<LogDetail::ArgType<Args>...>);
+}
+
+// 重要度ごとの短い書き方
+template <typename... Args>
+void LogTrace(LogCategory category, const char* format, const Args&... args) {
+    Logger::GetInstance()->Write(LogLevel::kTrace, category, format, args...);
+}
+
+template <typename... Args>
+void LogDebug(LogCategory category, const char* format, const Args&... args) {
+    Logger::GetInstance()->Write(LogLevel::kDebug, category, format, args...);
+}
+
+template <typename... Args>
+void LogInfo(LogCategory category, const char* format, const Args&... args) {
+    Logger::GetInstance()->Write(LogLevel::kInfo, category, format, args...);
+}
+
+template <typename... Args>
+void LogWarning(LogCategory category, const char* format, const Args&... args) {
+    Logger::GetInstance()->Write(LogLevel::kWarning, category, format, args...);
+}
+
+template <typename... Args>
+void LogError(LogCategory category, const char* format, const Args&... args) {
+    Logger::GetInstance()->Write(LogLevel::kError, category, format, args...);
+}
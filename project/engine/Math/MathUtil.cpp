@@ -125,9 +125,14 @@ Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip
 	float f = 1.0f / std::tan(fovY / 2.0f);
 	result.m[0][0] = f / aspectRatio;
 	result.m[1][1] = f;
-	result.m[2][2] = farClip / (farClip - nearClip);
 	result.m[2][3] = 1.0f;
-	result.m[3][2] = -(nearClip * farClip) / (farClip - nearClip);
+	if (kReversedZ) {
+		result.m[2][2] = nearClip / (nearClip - farClip);
+		result.m[3][2] = (nearClip * farClip) / (farClip - nearClip);
+	} else {
+		result.m[2][2] = farClip / (farClip - nearClip);
+		result.m[3][2] = -(nearClip * farClip) / (farClip - nearClip);
+	}
 	return result;
 }
 
@@ -2,6 +2,12 @@
 #include "MathTypes.h"
 #include <cmath>
 
+// 深度の向き (true なら手前が1、奥が0の逆Z。浮動小数点の深度バッファで奥まで精度が出る)
+// 射影行列・深度バッファのクリア値・パイプラインの深度の比較がこれに合わせる
+constexpr bool kReversedZ = true;
+// 最も奥の深度 (深度バッファのクリア値)
+constexpr float kFarDepth = kReversedZ ? 0.0f : 1.0f;
+
 Matrix4x4 MakeIdentity4x4();
 Matrix4x4 Matrix4x4MakeScaleMatrix(const Vector3& s);
 Matrix4x4 MakeRotateXMatrix(float radian);
@@ -11,6 +17,7 @@ Matrix4x4 MakeTranslateMatrix(const Vector3& tlanslate);
 Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2);
 Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& rotate, const Vector3& translate);
 Matrix4x4 Inverse(Matrix4x4 m);
+// kReversedZ なら nearClip が深度1、farClip が深度0になる
 Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip);
 Matrix4x4 MakeOrthographicMatrix(float left, float top, float right, float bottom, float nearClip, float farClip);
 Vector3 Normalize(const Vector3& v);
\ No newline at end of file
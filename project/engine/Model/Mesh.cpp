@@ -0,0 +1,43 @@
+#include "Mesh.h"
+#include <cassert>
+#include <cstring>
+#include "D3D12Util.h"
+#include "Model.h"
+
+Mesh* Mesh::Create(const std::string& directoryPath, const std::string& filename, ID3D12Device* device) {
+    Mesh* mesh = new Mesh();
+    mesh->Initialize(directoryPath, filename, device);
+    return mesh;
+}
+
+void Mesh::Initialize(const std::string& directoryPath, const std::string& filename, ID3D12Device* device) {
+    ModelData modelData = LoadOjFile(directoryPath, filename);
+    assert(!modelData.vertices.empty());
+    textureFilePath_ = modelData.material.textureFilePath;
+
+    // 頂点は書き換えないので、書き込んだらアンマップする
+    size_t vertexBytes = sizeof(VertexData) * modelData.vertices.size();
+    vertexResource_ = CreateBufferResource(device, vertexBytes);
+    VertexData* vertexData = nullptr;
+    vertexResource_->Map(0, nullptr, reinterpret_cast<void**>(&vertexData));
+    std::memcpy(vertexData, modelData.vertices.data(), vertexBytes);
+    vertexResource_->Unmap(0, nullptr);
+    vertexBufferView_.BufferLocation = vertexResource_->GetGPUVirtualAddress();
+    vertexBufferView_.SizeInBytes = static_cast<UINT>(vertexBytes);
+    vertexBufferView_.StrideInBytes = sizeof(VertexData);
+    vertexCount_ = static_cast<uint32_t>(modelData.vertices.size());
+
+    const Vector4& first = modelData.vertices[0].position;
+    bounds_.min = { first.x, first.y, first.z };
+    bounds_.max = bounds_.min;
+    // Windows.h の min/max マクロと重なるので std::min/max は使わない
+    for (const VertexData& vertex : modelData.vertices) {
+        const float position[3] = { vertex.position.x, vertex.position.y, vertex.position.z };
+        float* minimum[3] = { &bounds_.min.x, &bounds_.min.y, &bounds_.min.z };
+        float* maximum[3] = { &bounds_.max.x, &bounds_.max.y, &bounds_.max.z };
+        for (int axis = 0; axis < 3; ++axis) {
+            *minimum[axis] = position[axis] < *minimum[axis] ? position[axis] : *minimum[axis];
+            *maximum[axis] = position[axis] > *maximum[axis] ? position[axis] : *maximum[axis];
+        }
+    }
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl.h>
+#include <cstdint>
+#include <string>
+#include "DataTypes.h"
+#include "TransformSystem.h"
+
+// OBJファイルの頂点バッファ (同じメッシュを描く全てのエンティティで共有する)
+// 描き方 (ワールド行列・マテリアル・テクスチャ) はエンティティのコンポーネントに持たせ、MeshRenderSystem がまとめて描く
+class Mesh {
+public:
+    // 作成 (OBJファイルを読み込む)
+    static Mesh* Create(const std::string& directoryPath, const std::string& filename, ID3D12Device* device);
+
+    const D3D12_VERTEX_BUFFER_VIEW& GetVertexBufferView() const { return vertexBufferView_; }
+    uint32_t GetVertexCount() const { return vertexCount_; }
+    // 頂点を囲む AABB (エンティティの LocalBounds に使う)
+    const LocalBounds& GetBounds() const { return bounds_; }
+    // OBJのマテリアルのテクスチャ (directoryPath を含むパス)
+    const std::string& GetTextureFilePath() const { return textureFilePath_; }
+
+private:
+    Mesh() = default;
+    Mesh(const Mesh&) = delete;
+    const Mesh& operator=(const Mesh&) = delete;
+
+    void Initialize(const std::string& directoryPath, const std::string& filename, ID3D12Device* device);
+
+private:
+    Microsoft::WRL::ComPtr<ID3D12Resource> vertexResource_;
+    D3D12_VERTEX_BUFFER_VIEW vertexBufferView_{};
+    uint32_t vertexCount_ = 0;
+    LocalBounds bounds_{};
+    std::string textureFilePath_;
+};
@@ -0,0 +1,135 @@
+#include "MeshRenderer.h"
+#include <cassert>
+#include <cstring>
+#include "MathUtil.h"
+#include "Mesh.h"
+#include "PipelinePresets.h"
+#include "TransformSystem.h"
+
+namespace {
+
+// 1つのエンティティの定数 (行列とマテリアルを、それぞれ定数バッファの揃えに合わせて並べる)
+const uint64_t kConstantAlignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT;
+const uint64_t kTransformStride = (sizeof(TransformationMatrix) + kConstantAlignment - 1) / kConstantAlignment * kConstantAlignment;
+const uint64_t kMaterialStride = (sizeof(Material) + kConstantAlignment - 1) / kConstantAlignment * kConstantAlignment;
+const uint64_t kDrawConstantsSize = kTransformStride + kMaterialStride;
+
+} // namespace
+
+Material MakeDefaultMaterial() {
+    Material material{};
+    material.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+    material.enableLighting = true;
+    material.alphaReference = 0.5f;
+    material.uvTransform = MakeIdentity4x4();
+    return material;
+}
+
+MeshRenderSystem* MeshRenderSystem::GetInstance() {
+    static MeshRenderSystem instance;
+    return &instance;
+}
+
+void MeshRenderSystem::Initialize(ID3D12Device* device, uint32_t maxDrawsPerFrame) {
+    ring_.Initialize(device, kDrawConstantsSize * maxDrawsPerFrame * UploadRing::kFrameLatency);
+    // 既定の機能のパイプラインは先に要求しておく (他の機能がコンパイル中の間の代わりにする)
+    GetPipelineIndex(Object3dFeature::kDefault);
+}
+
+void MeshRenderSystem::Finalize() {
+    ring_.Finalize();
+    pipelines_.clear();
+}
+
+void MeshRenderSystem::BeginFrame() {
+    ring_.BeginFrame();
+}
+
+void MeshRenderSystem::Render(ID3D12GraphicsCommandList* commandList, EntityWorld& world, const Matrix4x4& viewProjectionMatrix,
+    const DirectionalLight& directionalLight) {
+    stats_ = {};
+    PipelineLibrary* pipelineLibrary = PipelineLibrary::GetInstance();
+    uint32_t currentPipeline = UINT32_MAX;
+    const Mesh* currentMesh = nullptr;
+    D3D12_GPU_DESCRIPTOR_HANDLE currentTexture{};
+    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+
+    world.ForEachChunk<const LocalToWorld, const MeshRenderer, const Material>(
+        [&](uint32_t count, const Entity*, const LocalToWorld* localToWorlds, const MeshRenderer* renderers, const Material* materials) {
+            // チャンクの分をまとめて切り出す (入りきらなければこのチャンクは描かない)
+            UploadRing::Allocation allocation;
+            if (!ring_.Allocate(kDrawConstantsSize * count, kConstantAlignment, allocation)) {
+                stats_.droppedCount += count;
+                return;
+            }
+            uint8_t* cpuAddress = static_cast<uint8_t*>(allocation.cpuAddress);
+            for (uint32_t i = 0; i < count; ++i) {
+                const MeshRenderer& renderer = renderers[i];
+                uint64_t offset = kDrawConstantsSize * i;
+                if (renderer.mesh == nullptr) {
+                    continue;
+                }
+                uint32_t pipelineIndex = GetPipelineIndex(renderer.shaderFeatures);
+                const Pipeline& pipeline = pipelines_[pipelineIndex];
+                ID3D12PipelineState* pipelineState = pipelineLibrary->GetPipelineState(pipeline.handle);
+                if (pipelineState == nullptr) {
+                    continue;
+                }
+
+                TransformationMatrix transform;
+                transform.World = localToWorlds[i].matrix;
+                transform.WVP = Multiply(localToWorlds[i].matrix, viewProjectionMatrix);
+                std::memcpy(cpuAddress + offset, &transform, sizeof(transform));
+                std::memcpy(cpuAddress + offset + kTransformStride, &materials[i], sizeof(Material));
+
+                if (currentPipeline != pipelineIndex) {
+                    commandList->SetGraphicsRootSignature(pipelineLibrary->GetRootSignature(pipeline.handle));
+                    commandList->SetPipelineState(pipelineState);
+                    // どのパーミュテーションも光源を参照していなければルートシグネチャに入らない
+                    if (pipeline.lightRootIndex != UINT32_MAX) {
+                        commandList->SetGraphicsRoot32BitConstants(
+                            pipeline.lightRootIndex, sizeof(DirectionalLight) / sizeof(uint32_t), &directionalLight, 0);
+                    }
+                    // ルートシグネチャを設定し直すとテクスチャの設定も消える
+                    currentPipeline = pipelineIndex;
+                    currentTexture = {};
+                    ++stats_.pipelineCount;
+                }
+                if (currentMesh != renderer.mesh) {
+                    commandList->IASetVertexBuffers(0, 1, &renderer.mesh->GetVertexBufferView());
+                    currentMesh = renderer.mesh;
+                }
+                D3D12_GPU_DESCRIPTOR_HANDLE texture = renderer.texture.GetGPUHandle();
+                if (currentTexture.ptr != texture.ptr) {
+                    commandList->SetGraphicsRootDescriptorTable(pipeline.textureRootIndex, texture);
+                    currentTexture = texture;
+                }
+                commandList->SetGraphicsRootConstantBufferView(pipeline.transformRootIndex, allocation.gpuAddress + offset);
+                commandList->SetGraphicsRootConstantBufferView(pipeline.materialRootIndex, allocation.gpuAddress + offset + kTransformStride);
+                commandList->DrawInstanced(renderer.mesh->GetVertexCount(), 1, 0, 0);
+                ++stats_.drawCount;
+            }
+        });
+}
+
+uint32_t MeshRenderSystem::GetPipelineIndex(uint32_t shaderFeatures) {
+    for (uint32_t i = 0; i < pipelines_.size(); ++i) {
+        if (pipelines_[i].shaderFeatures == shaderFeatures) {
+            return i;
+        }
+    }
+    // マテリアルの機能に合ったバリエーションを選ぶ (シェーダー内で分岐しない)
+    PipelineLibrary* pipelineLibrary = PipelineLibrary::GetInstance();
+    Pipeline pipeline;
+    pipeline.shaderFeatures = shaderFeatures;
+    PipelineLibrary::Handle fallback = pipelineLibrary->Request(MakeObject3dPipelineDesc());
+    pipeline.handle = pipelineLibrary->Request(MakeObject3dPipelineDesc(shaderFeatures), fallback);
+    pipeline.materialRootIndex = pipelineLibrary->GetRootParameterIndex(pipeline.handle, "gMaterial");
+    pipeline.transformRootIndex = pipelineLibrary->GetRootParameterIndex(pipeline.handle, "gTransformationMatrix");
+    pipeline.lightRootIndex = pipelineLibrary->GetRootParameterIndex(pipeline.handle, "gDirectionalLight");
+    pipeline.textureRootIndex = pipelineLibrary->GetRootParameterIndex(pipeline.handle, "gTexture");
+    assert(pipeline.handle == PipelineLibrary::kInvalidHandle ||
+           (pipeline.materialRootIndex != UINT32_MAX && pipeline.transformRootIndex != UINT32_MAX && pipeline.textureRootIndex != UINT32_MAX));
+    pipelines_.push_back(pipeline);
+    return static_cast<uint32_t>(pipelines_.size()) - 1;
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <d3d12.h>
+#include <cstdint>
+#include <vector>
+#include "DataTypes.h"
+#include "EntityWorld.h"
+#include "PipelineLibrary.h"
+#include "ShaderPermutation.h"
+#include "TextureManager.h"
+#include "UploadRing.h"
+
+class Mesh;
+
+// メッシュを描くエンティティのコンポーネント (LocalToWorld と Material と一緒に持たせる)
+struct MeshRenderer {
+    const Mesh* mesh = nullptr;
+    TextureHandle texture;
+    // マテリアルの機能 (Object3dFeature の組み合わせ。これでピクセルシェーダーのバリエーションを選ぶ)
+    uint32_t shaderFeatures = Object3dFeature::kDefault;
+};
+
+// 既定のマテリアル (白・ライティングあり)
+Material MakeDefaultMaterial();
+
+// MeshRenderer を持つエンティティを描く (Object3d のシェーダー)
+// チャンクごとに定数 (行列とマテリアル) をリングへまとめて書き、パイプライン・頂点バッファ・テクスチャは変わったときだけ設定し直す
+class MeshRenderSystem {
+public:
+    // 1フレームに描けるエンティティの数の初期値
+    static const uint32_t kDefaultMaxDraws = 4096;
+
+    // 直前の Render の結果
+    struct Stats {
+        uint32_t drawCount = 0;      // 描いたエンティティの数
+        uint32_t droppedCount = 0;   // リングに入りきらずに描かなかった数
+        uint32_t pipelineCount = 0;  // パイプラインを設定した回数
+    };
+
+public:
+    // シングルトンインスタンスの取得
+    static MeshRenderSystem* GetInstance();
+
+    // 初期化
+    void Initialize(ID3D12Device* device, uint32_t maxDrawsPerFrame = kDefaultMaxDraws);
+
+    // 終了処理
+    void Finalize();
+
+    // フレームの先頭で呼ぶ (GPUが使い終わったリングの領域を再利用する)
+    void BeginFrame();
+
+    // LocalToWorld・MeshRenderer・Material を持つエンティティを描く (レンダーターゲットと深度バッファを設定した後に呼ぶ)
+    void Render(ID3D12GraphicsCommandList* commandList, EntityWorld& world, const Matrix4x4& viewProjectionMatrix,
+        const DirectionalLight& directionalLight);
+
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    MeshRenderSystem() = default;
+    ~MeshRenderSystem() = default;
+    MeshRenderSystem(const MeshRenderSystem&) = delete;
+    const MeshRenderSystem& operator=(const MeshRenderSystem&) = delete;
+
+    // マテリアルの機能ごとのパイプライン (ルートパラメータはシェーダーから作られるので、名前で引いておく)
+    struct Pipeline {
+        uint32_t shaderFeatures = 0;
+        PipelineLibrary::Handle handle = PipelineLibrary::kInvalidHandle;
+        uint32_t materialRootIndex = 0;
+        uint32_t transformRootIndex = 0;
+        uint32_t lightRootIndex = 0;
+        uint32_t textureRootIndex = 0;
+    };
+
+    // 機能に合うパイプラインの番号 (無ければ要求して足す。足すと pipelines_ の中身が動くので番号で持つ)
+    uint32_t GetPipelineIndex(uint32_t shaderFeatures);
+
+private:
+    UploadRing ring_;
+    std::vector<Pipeline> pipelines_;
+    Stats stats_;
+};
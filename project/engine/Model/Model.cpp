@@ -3,69 +3,7 @@
 #include <fstream>
 #include <sstream>
 
-// (LoadMaterialTemplateFile と LoadOjFile の実装は変更なし)
-MaterialData LoadMaterialTemplateFile(const std::string& directoryPath, const std::string& filename);
-ModelData LoadOjFile(const std::string& directoryPath, const std::string& filename);
-
-Model* Model::Create(
-	const std::string& directoryPath, const std::string& filename, ID3D12Device* device) {
-	Model* model = new Model();
-	model->Initialize(directoryPath, filename, device);
-	return model;
-}
-
-void Model::Initialize(
-	const std::string& directoryPath, const std::string& filename, ID3D12Device* device) {
-
-	ModelData modelData = LoadOjFile(directoryPath, filename);
-	vertices_ = modelData.vertices;
-
-	vertexResource_ = CreateBufferResource(device, sizeof(VertexData) * vertices_.size());
-	vertexBufferView_.BufferLocation = vertexResource_->GetGPUVirtualAddress();
-	vertexBufferView_.SizeInBytes = UINT(sizeof(VertexData) * vertices_.size());
-	vertexBufferView_.StrideInBytes = sizeof(VertexData);
-
-	VertexData* vertexData = nullptr;
-	vertexResource_->Map(0, nullptr, reinterpret_cast<void**>(&vertexData));
-	std::memcpy(vertexData, vertices_.data(), sizeof(VertexData) * vertices_.size());
-
-	materialResource_ = CreateBufferResource(device, sizeof(Material));
-	materialResource_->Map(0, nullptr, reinterpret_cast<void**>(&materialData));
-	materialData->color = { 1.0f, 1.0f, 1.0f, 1.0f };
-	materialData->enableLighting = true;
-	materialData->uvTransform = MakeIdentity4x4();
-
-	wvpResource_ = CreateBufferResource(device, sizeof(TransformationMatrix));
-	wvpResource_->Map(0, nullptr, reinterpret_cast<void**>(&wvpData_));
-	wvpData_->WVP = MakeIdentity4x4();
-	wvpData_->World = MakeIdentity4x4();
-}
-
-void Model::Update() {
-	// 何もしない
-}
-
-void Model::Draw(
-	ID3D12GraphicsCommandList* commandList,
-	const Matrix4x4& viewProjectionMatrix,
-	D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandle) {
-
-	Matrix4x4 worldMatrix = MakeAffineMatrix(transform.scale, transform.rotate, transform.translate);
-	wvpData_->WVP = Multiply(worldMatrix, viewProjectionMatrix);
-	wvpData_->World = worldMatrix;
-
-	commandList->IASetVertexBuffers(0, 1, &vertexBufferView_);
-	commandList->SetGraphicsRootConstantBufferView(0, materialResource_->GetGPUVirtualAddress());
-	commandList->SetGraphicsRootConstantBufferView(1, wvpResource_->GetGPUVirtualAddress());
-	commandList->SetGraphicsRootDescriptorTable(2, textureSrvHandle);
-
-	// 修正: ライト設定処理をここから削除
-
-	commandList->DrawInstanced(UINT(vertices_.size()), 1, 0, 0);
-}
-
-
-// === このファイル内でのみ使用するヘルパー関数 ===
+// === ヘルパー関数 ===
 MaterialData LoadMaterialTemplateFile(const std::string& directoryPath, const std::string& filename)
 {
 	MaterialData materialData;
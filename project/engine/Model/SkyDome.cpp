@@ -0,0 +1,81 @@
+#include "SkyDome.h"
+#include <cassert>
+#include <cstring>
+#include "D3D12Util.h"
+#include "Model.h"
+#include "PipelinePresets.h"
+
+namespace {
+
+// 1フレームに Draw を呼べる回数 (画面分割などで同じフレームに何度か描くとき用)
+const uint32_t kMaxDrawsPerFrame = 4;
+
+} // namespace
+
+SkyDome* SkyDome::Create(const std::string& directoryPath, const std::string& filename, ID3D12Device* device) {
+    SkyDome* skyDome = new SkyDome();
+    skyDome->Initialize(directoryPath, filename, device);
+    return skyDome;
+}
+
+void SkyDome::Initialize(const std::string& directoryPath, const std::string& filename, ID3D12Device* device) {
+    ModelData modelData = LoadOjFile(directoryPath, filename);
+    assert(!modelData.vertices.empty());
+    textureFilePath_ = modelData.material.textureFilePath;
+
+    // 頂点は書き換えないので、書き込んだらアンマップする
+    size_t vertexBytes = sizeof(VertexData) * modelData.vertices.size();
+    vertexResource_ = CreateBufferResource(device, vertexBytes);
+    VertexData* vertexData = nullptr;
+    vertexResource_->Map(0, nullptr, reinterpret_cast<void**>(&vertexData));
+    std::memcpy(vertexData, modelData.vertices.data(), vertexBytes);
+    vertexResource_->Unmap(0, nullptr);
+    vertexBufferView_.BufferLocation = vertexResource_->GetGPUVirtualAddress();
+    vertexBufferView_.SizeInBytes = static_cast<UINT>(vertexBytes);
+    vertexBufferView_.StrideInBytes = sizeof(VertexData);
+    vertexCount_ = static_cast<uint32_t>(modelData.vertices.size());
+
+    uint64_t constantsSize = (sizeof(SkyTransform) + D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT) * kMaxDrawsPerFrame;
+    ring_.Initialize(device, constantsSize * UploadRing::kFrameLatency);
+
+    PipelineLibrary* pipelineLibrary = PipelineLibrary::GetInstance();
+    pipelineHandle_ = pipelineLibrary->Request(MakeSkyPipelineDesc());
+    transformRootIndex_ = pipelineLibrary->GetRootParameterIndex(pipelineHandle_, "SkyTransform");
+    textureRootIndex_ = pipelineLibrary->GetRootParameterIndex(pipelineHandle_, "tex");
+    assert(pipelineHandle_ == PipelineLibrary::kInvalidHandle || (transformRootIndex_ != UINT32_MAX && textureRootIndex_ != UINT32_MAX));
+}
+
+void SkyDome::Update() {
+    ring_.BeginFrame();
+}
+
+void SkyDome::Draw(ID3D12GraphicsCommandList* commandList, const Matrix4x4& view, const Matrix4x4& projection,
+    D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandle) {
+    PipelineLibrary* pipelineLibrary = PipelineLibrary::GetInstance();
+    ID3D12PipelineState* pipelineState = pipelineLibrary->GetPipelineState(pipelineHandle_);
+    if (pipelineState == nullptr) {
+        return;
+    }
+    UploadRing::Allocation allocation;
+    if (!ring_.Allocate(sizeof(SkyTransform), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, allocation)) {
+        return;
+    }
+
+    // カメラの回転だけを残す (天球がカメラと一緒に動き、どこまで行っても近づかない)
+    Matrix4x4 rotationOnly = view;
+    rotationOnly.m[3][0] = 0.0f;
+    rotationOnly.m[3][1] = 0.0f;
+    rotationOnly.m[3][2] = 0.0f;
+    SkyTransform transform;
+    transform.viewProjection = Multiply(rotationOnly, projection);
+    transform.farDepth = kFarDepth;
+    std::memcpy(allocation.cpuAddress, &transform, sizeof(transform));
+
+    commandList->SetGraphicsRootSignature(pipelineLibrary->GetRootSignature(pipelineHandle_));
+    commandList->SetPipelineState(pipelineState);
+    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    commandList->IASetVertexBuffers(0, 1, &vertexBufferView_);
+    commandList->SetGraphicsRootConstantBufferView(transformRootIndex_, allocation.gpuAddress);
+    commandList->SetGraphicsRootDescriptorTable(textureRootIndex_, textureSrvHandle);
+    commandList->DrawInstanced(vertexCount_, 1, 0, 0);
+}
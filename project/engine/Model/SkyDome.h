@@ -0,0 +1,55 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl.h>
+#include <cstdint>
+#include <string>
+#include "DataTypes.h"
+#include "MathUtil.h"
+#include "PipelineLibrary.h"
+#include "UploadRing.h"
+
+// 天球 (Sky のシェーダー)
+// ビュー行列の平行移動を外して常にカメラを中心に置き、深度は最も奥 (kFarDepth) に固定して書き込まない
+// 不透明なものを全て描いた後に描けば、何かが描かれた画素は深度テストで弾かれるので、空が見える画素だけを塗る
+// 深度を奥に固定するので、天球の大きさはファークリップより大きくてもよい
+class SkyDome {
+public:
+    // 作成 (OBJファイルを読み込む)
+    static SkyDome* Create(const std::string& directoryPath, const std::string& filename, ID3D12Device* device);
+
+    // フレームの先頭で呼ぶ (定数バッファの領域を再利用する)
+    void Update();
+
+    // 描画 (不透明なものを全て描いた後、半透明なものより前に呼ぶ)
+    void Draw(ID3D12GraphicsCommandList* commandList, const Matrix4x4& view, const Matrix4x4& projection,
+        D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandle);
+
+    // OBJのマテリアルのテクスチャ (directoryPath を含むパス)
+    const std::string& GetTextureFilePath() const { return textureFilePath_; }
+
+private:
+    SkyDome() = default;
+    SkyDome(const SkyDome&) = delete;
+    const SkyDome& operator=(const SkyDome&) = delete;
+
+    void Initialize(const std::string& directoryPath, const std::string& filename, ID3D12Device* device);
+
+    // Sky.hlsli の SkyTransform
+    struct SkyTransform {
+        Matrix4x4 viewProjection;
+        float farDepth;
+    };
+
+private:
+    Microsoft::WRL::ComPtr<ID3D12Resource> vertexResource_;
+    D3D12_VERTEX_BUFFER_VIEW vertexBufferView_{};
+    uint32_t vertexCount_ = 0;
+    std::string textureFilePath_;
+
+    // 定数バッファ (描画ごと)
+    UploadRing ring_;
+
+    PipelineLibrary::Handle pipelineHandle_ = PipelineLibrary::kInvalidHandle;
+    uint32_t transformRootIndex_ = 0;
+    uint32_t textureRootIndex_ = 0;
+};
@@ -1,31 +1,20 @@
 #pragma once
 #include <d3d12.h>
-#include <dxcapi.h>
 #include <wrl.h>
-#include <string>
-#include <fstream>
+#include "PipelineLibrary.h"
 
 // グラフィックスパイプライン管理クラス
+// Object3dのパイプラインをPipelineLibraryから取得する (PipelineLibraryを先に初期化しておくこと)
+// ホットリロードで差し替えられるので、PSOは毎回PipelineLibraryから取る
 class GraphicsPipeline {
 public:
-    // 初期化
+    // 初期化 (コンパイルが終わるまで待つ)
     void Initialize(ID3D12Device* device);
 
     // ゲッター
-    ID3D12RootSignature* GetRootSignature() const { return rootSignature_.Get(); }
-    ID3D12PipelineState* GetPipelineState() const { return pipelineState_.Get(); }
+    ID3D12RootSignature* GetRootSignature() const { return PipelineLibrary::GetInstance()->GetRootSignature(handle_); }
+    ID3D12PipelineState* GetPipelineState() const { return PipelineLibrary::GetInstance()->GetPipelineState(handle_); }
 
 private:
-    // シェーダーのコンパイル
-    Microsoft::WRL::ComPtr<IDxcBlob> CompileShader(
-        const std::wstring& filePath,
-        const wchar_t* profile,
-        IDxcUtils* dxcUtils,
-        IDxcCompiler3* dxcCompiler,
-        IDxcIncludeHandler* includeHandler);
-
-private:
-    Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature_;
-    Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState_;
-    std::ofstream logStream_; // ログ出力用
-};
\ No newline at end of file
+    PipelineLibrary::Handle handle_ = PipelineLibrary::kInvalidHandle;
+};
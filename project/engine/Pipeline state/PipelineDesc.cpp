@@ -0,0 +1,264 @@
+#include "PipelineDesc.h"
+#include <cassert>
+
+namespace {
+
+const uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+const uint64_t kFnvPrime = 1099511628211ull;
+
+// FNV-1a (項目ごとに長さを含めて、区切りが曖昧にならないようにする)
+class Hasher {
+public:
+    void Bytes(const void* data, size_t size) {
+        const unsigned char* bytes = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < size; ++i) {
+            hash_ ^= bytes[i];
+            hash_ *= kFnvPrime;
+        }
+    }
+    void U32(uint32_t value) { Bytes(&value, sizeof(value)); }
+    void String(const std::string& text) {
+        U32(static_cast<uint32_t>(text.size()));
+        Bytes(text.data(), text.size());
+    }
+    // wchar_tの大きさはWindowsとLinuxで違うので、1文字16bitとしてハッシュする
+    void WideString(const std::wstring& text) {
+        U32(static_cast<uint32_t>(text.size()));
+        for (wchar_t c : text) {
+            uint16_t code = static_cast<uint16_t>(c);
+            Bytes(&code, sizeof(code));
+        }
+    }
+    uint64_t Get() const { return hash_; }
+
+private:
+    uint64_t hash_ = kFnvOffsetBasis;
+};
+
+void HashRootSignature(Hasher& hasher, const PipelineDesc& desc) {
+    hasher.U32(static_cast<uint32_t>(desc.rootParameters.size()));
+    for (const RootParameter& parameter : desc.rootParameters) {
+        hasher.U32(static_cast<uint32_t>(parameter.type));
+        hasher.U32(static_cast<uint32_t>(parameter.visibility));
+        hasher.U32(parameter.shaderRegister);
+        hasher.U32(parameter.constantCount);
+    }
+    hasher.U32(desc.linearWrapSampler ? 1 : 0);
+}
+
+void HashCompatibility(Hasher& hasher, const PipelineDesc& desc) {
+    HashRootSignature(hasher, desc);
+    hasher.U32(static_cast<uint32_t>(desc.inputLayout.size()));
+    for (const InputElement& element : desc.inputLayout) {
+        hasher.String(element.semanticName);
+        hasher.U32(element.semanticIndex);
+        hasher.U32(element.format);
+    }
+    hasher.U32(static_cast<uint32_t>(desc.topologyType));
+    hasher.U32(static_cast<uint32_t>(desc.rtvFormats.size()));
+    for (uint32_t format : desc.rtvFormats) {
+        hasher.U32(format);
+    }
+    hasher.U32(desc.dsvFormat);
+}
+
+void HashShaders(Hasher& hasher, const PipelineDesc& desc) {
+    hasher.WideString(desc.vertexShader);
+    hasher.WideString(desc.pixelShader);
+    hasher.WideString(desc.vertexProfile);
+    hasher.WideString(desc.pixelProfile);
+}
+
+void HashDefines(Hasher& hasher, const PipelineDesc& desc) {
+    hasher.U32(static_cast<uint32_t>(desc.vertexDefines.size()));
+    for (const std::wstring& define : desc.vertexDefines) {
+        hasher.WideString(define);
+    }
+    hasher.U32(static_cast<uint32_t>(desc.pixelDefines.size()));
+    for (const std::wstring& define : desc.pixelDefines) {
+        hasher.WideString(define);
+    }
+}
+
+void HashState(Hasher& hasher, const PipelineDesc& desc) {
+    hasher.U32(static_cast<uint32_t>(desc.blendMode));
+    hasher.U32(static_cast<uint32_t>(desc.cullMode));
+    hasher.U32(desc.wireframe ? 1 : 0);
+    hasher.U32(static_cast<uint32_t>(desc.depthMode));
+    hasher.U32(desc.reversedZ ? 1 : 0);
+}
+
+// マクロ定義以外の項目が同じか (ハッシュに含める項目と同じものを比べる。ルートパラメータの名前は比べない)
+bool IsSameExceptDefines(const PipelineDesc& a, const PipelineDesc& b) {
+    if (a.vertexShader != b.vertexShader || a.pixelShader != b.pixelShader ||
+        a.vertexProfile != b.vertexProfile || a.pixelProfile != b.pixelProfile) {
+        return false;
+    }
+    if (a.rootParameters.size() != b.rootParameters.size() || a.linearWrapSampler != b.linearWrapSampler) {
+        return false;
+    }
+    for (size_t i = 0; i < a.rootParameters.size(); ++i) {
+        const RootParameter& pa = a.rootParameters[i];
+        const RootParameter& pb = b.rootParameters[i];
+        if (pa.type != pb.type || pa.visibility != pb.visibility || pa.shaderRegister != pb.shaderRegister ||
+            pa.constantCount != pb.constantCount) {
+            return false;
+        }
+    }
+    if (a.inputLayout.size() != b.inputLayout.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.inputLayout.size(); ++i) {
+        const InputElement& ea = a.inputLayout[i];
+        const InputElement& eb = b.inputLayout[i];
+        if (ea.semanticName != eb.semanticName || ea.semanticIndex != eb.semanticIndex || ea.format != eb.format) {
+            return false;
+        }
+    }
+    return a.topologyType == b.topologyType && a.rtvFormats == b.rtvFormats && a.dsvFormat == b.dsvFormat &&
+        a.blendMode == b.blendMode && a.cullMode == b.cullMode && a.wireframe == b.wireframe &&
+        a.depthMode == b.depthMode && a.reversedZ == b.reversedZ;
+}
+
+} // namespace
+
+uint64_t HashPipelineDesc(const PipelineDesc& desc) {
+    Hasher hasher;
+    HashShaders(hasher, desc);
+    HashDefines(hasher, desc);
+    HashCompatibility(hasher, desc);
+    HashState(hasher, desc);
+    return hasher.Get();
+}
+
+uint64_t HashRootSignature(const PipelineDesc& desc) {
+    Hasher hasher;
+    HashRootSignature(hasher, desc);
+    return hasher.Get();
+}
+
+uint64_t HashPipelineCompatibility(const PipelineDesc& desc) {
+    Hasher hasher;
+    HashCompatibility(hasher, desc);
+    return hasher.Get();
+}
+
+uint64_t HashPipelinePermutation(const PipelineDesc& desc) {
+    Hasher hasher;
+    HashShaders(hasher, desc);
+    HashCompatibility(hasher, desc);
+    HashState(hasher, desc);
+    return hasher.Get();
+}
+
+bool IsSamePipelineDesc(const PipelineDesc& a, const PipelineDesc& b) {
+    return a.vertexDefines == b.vertexDefines && a.pixelDefines == b.pixelDefines && IsSameExceptDefines(a, b);
+}
+
+bool IsPipelinePermutationOf(const PipelineDesc& a, const PipelineDesc& b) {
+    return IsSameExceptDefines(a, b);
+}
+
+uint32_t PipelineRegistry::Register(const PipelineDesc& desc, bool* added) {
+    uint64_t key = HashPipelineDesc(desc);
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::vector<uint32_t>& sameKeyIds = ids_[key];
+    for (uint32_t id : sameKeyIds) {
+        if (IsSamePipelineDesc(entries_[id].desc, desc)) {
+            if (added) {
+                *added = false;
+            }
+            return id;
+        }
+    }
+
+    uint32_t id = static_cast<uint32_t>(entries_.size());
+    Entry& entry = entries_.emplace_back();
+    entry.desc = desc;
+    entry.key = key;
+    entry.compatibilityKey = HashPipelineCompatibility(desc);
+    entry.permutationKey = HashPipelinePermutation(desc);
+    sameKeyIds.push_back(id);
+    permutationIds_[entry.permutationKey].push_back(id);
+    if (added) {
+        *added = true;
+    }
+    return id;
+}
+
+void PipelineRegistry::SetFallback(uint32_t id, uint32_t fallbackId) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    assert(id < entries_.size());
+    assert(fallbackId == kInvalidId || entries_[fallbackId].compatibilityKey == entries_[id].compatibilityKey);
+    entries_[id].fallbackId = fallbackId;
+}
+
+void PipelineRegistry::SetStatus(uint32_t id, PipelineStatus status) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    assert(id < entries_.size());
+    entries_[id].status.store(status, std::memory_order_release);
+}
+
+PipelineStatus PipelineRegistry::GetStatus(uint32_t id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    assert(id < entries_.size());
+    return entries_[id].status.load(std::memory_order_acquire);
+}
+
+uint32_t PipelineRegistry::Resolve(uint32_t id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (id >= entries_.size()) {
+        return kInvalidId;
+    }
+    const Entry& entry = entries_[id];
+    if (entry.status.load(std::memory_order_acquire) == PipelineStatus::kReady) {
+        return id;
+    }
+    if (entry.fallbackId != kInvalidId &&
+        entries_[entry.fallbackId].status.load(std::memory_order_acquire) == PipelineStatus::kReady) {
+        return entry.fallbackId;
+    }
+    auto it = permutationIds_.find(entry.permutationKey);
+    for (uint32_t candidate : it->second) {
+        if (entries_[candidate].status.load(std::memory_order_acquire) == PipelineStatus::kReady &&
+            IsPipelinePermutationOf(entries_[candidate].desc, entry.desc)) {
+            return candidate;
+        }
+    }
+    return kInvalidId;
+}
+
+const PipelineDesc& PipelineRegistry::GetDesc(uint32_t id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    assert(id < entries_.size());
+    return entries_[id].desc;
+}
+
+uint64_t PipelineRegistry::GetKey(uint32_t id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    assert(id < entries_.size());
+    return entries_[id].key;
+}
+
+size_t PipelineRegistry::GetCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+size_t PipelineRegistry::GetPendingCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t count = 0;
+    for (const Entry& entry : entries_) {
+        if (entry.status.load(std::memory_order_acquire) == PipelineStatus::kPending) {
+            ++count;
+        }
+    }
+    return count;
+}
+
+void PipelineRegistry::Clear() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    entries_.clear();
+    ids_.clear();
+    permutationIds_.clear();
+}
@@ -0,0 +1,178 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// パイプラインの記述とレジストリ
+// D3D12に依存しないので、キーの計算とレジストリの動作は単体で確認できる
+// (フォーマットやトポロジーはDXGI_FORMATなどの値をそのまま入れる)
+
+// ブレンドモード
+enum class BlendMode : uint8_t {
+    kNone,     // ブレンドしない
+    kAlpha,    // アルファブレンド
+    kAdd,      // 加算
+    kSubtract, // 減算
+    kMultiply, // 乗算
+};
+
+// カリング
+enum class CullMode : uint8_t {
+    kNone,
+    kFront,
+    kBack,
+};
+
+// 深度テスト
+enum class DepthMode : uint8_t {
+    kNone,      // テストしない
+    kReadWrite, // テストして書き込む
+    kReadOnly,  // テストのみ
+};
+
+// トポロジーの種類
+enum class TopologyType : uint8_t {
+    kTriangle,
+    kLine,
+    kPoint,
+};
+
+// ルートパラメータの種類
+enum class RootParameterType : uint8_t {
+    kCBV,       // ルートCBV
+    kSRVTable,  // SRV1つのディスクリプタテーブル
+    kConstants, // ルート定数 (constantCount 個の32bit値を直接置く)
+};
+
+// シェーダーの可視性
+enum class ShaderVisibility : uint8_t {
+    kAll,
+    kVertex,
+    kPixel,
+};
+
+// 頂点要素
+struct InputElement {
+    std::string semanticName;
+    uint32_t semanticIndex = 0;
+    uint32_t format = 0; // DXGI_FORMAT
+};
+
+// ルートパラメータ
+struct RootParameter {
+    RootParameterType type = RootParameterType::kCBV;
+    ShaderVisibility visibility = ShaderVisibility::kAll;
+    uint32_t shaderRegister = 0;
+    uint32_t constantCount = 0; // kConstants のときの32bit値の数
+    std::string name;           // シェーダー内の名前 (リフレクションで作ったとき。ルートシグネチャのキーには含めない)
+};
+
+// パイプラインの記述
+struct PipelineDesc {
+    // シェーダー (ピクセルシェーダーは省略可)
+    std::wstring vertexShader;
+    std::wstring pixelShader;
+    std::wstring vertexProfile = L"vs_6_0";
+    std::wstring pixelProfile = L"ps_6_0";
+    // シェーダーのマクロ定義 (パーミュテーション。NAME または NAME=VALUE)
+    std::vector<std::wstring> vertexDefines;
+    std::vector<std::wstring> pixelDefines;
+    // ルートシグネチャ
+    std::vector<RootParameter> rootParameters;
+    bool linearWrapSampler = true; // s0にリニア・ラップのスタティックサンプラーを置く
+    // true なら PipelineLibrary::Request がシェーダーのリフレクションで上の2つを埋める (キーは埋めた後の値で決まる)
+    bool reflectRootSignature = false;
+    // 入力レイアウト
+    std::vector<InputElement> inputLayout;
+    // ステート
+    BlendMode blendMode = BlendMode::kNone;
+    CullMode cullMode = CullMode::kBack;
+    bool wireframe = false;
+    DepthMode depthMode = DepthMode::kReadWrite;
+    bool reversedZ = false; // 深度の比較を逆にする (手前ほど深度が大きい逆Zの射影行列と組み合わせる)
+    TopologyType topologyType = TopologyType::kTriangle;
+    // 出力先
+    std::vector<uint32_t> rtvFormats; // DXGI_FORMAT
+    uint32_t dsvFormat = 0;           // DXGI_FORMAT (深度なしなら0)
+};
+
+// パイプラインのキー (記述の全ての項目のハッシュ)
+uint64_t HashPipelineDesc(const PipelineDesc& desc);
+
+// ルートシグネチャのキー
+uint64_t HashRootSignature(const PipelineDesc& desc);
+
+// 互換キー (ルートシグネチャ・入力レイアウト・トポロジー・出力先が同じなら同じ値)
+// 互換なパイプライン同士は、同じ描画コマンドのまま差し替えられる
+uint64_t HashPipelineCompatibility(const PipelineDesc& desc);
+
+// パーミュテーションのキー (マクロ定義以外の全ての項目のハッシュ。同じシェーダーの別のパーミュテーションなら同じ値)
+uint64_t HashPipelinePermutation(const PipelineDesc& desc);
+
+// 記述が同じか (HashPipelineDesc に含める項目を全て比べる。ハッシュが一致したときの確認に使う)
+bool IsSamePipelineDesc(const PipelineDesc& a, const PipelineDesc& b);
+
+// マクロ定義だけが違う (同じシェーダー・同じステートの別のパーミュテーション) か
+bool IsPipelinePermutationOf(const PipelineDesc& a, const PipelineDesc& b);
+
+// パイプラインの状態
+enum class PipelineStatus : uint8_t {
+    kPending,   // コンパイル待ち・コンパイル中
+    kReady,     // 使用可能
+    kFailed,    // コンパイル失敗
+};
+
+// パイプラインのレジストリ (記述 → ID の対応と、状態の管理)
+// Register と Resolve はメインスレッドから、SetStatus はワーカースレッドからも呼べる
+class PipelineRegistry {
+public:
+    static const uint32_t kInvalidId = UINT32_MAX;
+
+    // 登録 (同じ内容の記述なら同じIDを返す。新しく登録した場合は added が true になる)
+    uint32_t Register(const PipelineDesc& desc, bool* added = nullptr);
+
+    // 明示的なフォールバックの指定 (互換なパイプラインであること)
+    void SetFallback(uint32_t id, uint32_t fallbackId);
+
+    // 状態の設定と取得
+    void SetStatus(uint32_t id, PipelineStatus status);
+    PipelineStatus GetStatus(uint32_t id) const;
+
+    // 描画に使うIDを決める
+    // 使用可能ならそのもの、そうでなければ指定されたフォールバック、それも無ければ使用可能な別のパーミュテーション
+    // (マクロ定義だけが違うもの。シェーダーやステートが違うものは互換でも自動では使わない)
+    // どれも無ければ kInvalidId
+    uint32_t Resolve(uint32_t id) const;
+
+    // 記述とキー (登録後は変わらない)
+    const PipelineDesc& GetDesc(uint32_t id) const;
+    uint64_t GetKey(uint32_t id) const;
+
+    // 登録数と、コンパイル待ちの数
+    size_t GetCount() const;
+    size_t GetPendingCount() const;
+
+    void Clear();
+
+private:
+    struct Entry {
+        PipelineDesc desc;
+        uint64_t key = 0;
+        uint64_t compatibilityKey = 0;
+        uint64_t permutationKey = 0;
+        uint32_t fallbackId = kInvalidId;
+        std::atomic<PipelineStatus> status = PipelineStatus::kPending;
+    };
+
+    mutable std::mutex mutex_;
+    // 要素のアドレスが変わらないようにdequeに置く
+    std::deque<Entry> entries_;
+    // キー → ID (ハッシュが衝突しても別のパイプラインになるように、記述を比べて探す)
+    std::unordered_map<uint64_t, std::vector<uint32_t>> ids_;
+    // パーミュテーションのキー → ID
+    std::unordered_map<uint64_t, std::vector<uint32_t>> permutationIds_;
+};
@@ -0,0 +1,728 @@
+#include "PipelineLibrary.h"
+#include <algorithm>
+#include <cassert>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include "CpuProfiler.h"
+#include "Logger.h"
+#include "ShaderCompiler.h"
+#include "ShaderPermutation.h"
+#include "ShaderReflection.h"
+
+namespace {
+
+D3D12_BLEND_DESC MakeBlendDesc(BlendMode mode) {
+    D3D12_BLEND_DESC blendDesc{};
+    D3D12_RENDER_TARGET_BLEND_DESC& target = blendDesc.RenderTarget[0];
+    target.RenderTargetWriteMask = D3D12_COLOR_WRITE_ENABLE_ALL;
+    if (mode == BlendMode::kNone) {
+        return blendDesc;
+    }
+    target.BlendEnable = TRUE;
+    target.SrcBlendAlpha = D3D12_BLEND_ONE;
+    target.DestBlendAlpha = D3D12_BLEND_ZERO;
+    target.BlendOpAlpha = D3D12_BLEND_OP_ADD;
+    switch (mode) {
+    case BlendMode::kAlpha:
+        target.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+        target.DestBlend = D3D12_BLEND_INV_SRC_ALPHA;
+        target.BlendOp = D3D12_BLEND_OP_ADD;
+        break;
+    case BlendMode::kAdd:
+        target.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+        target.DestBlend = D3D12_BLEND_ONE;
+        target.BlendOp = D3D12_BLEND_OP_ADD;
+        break;
+    case BlendMode::kSubtract:
+        target.SrcBlend = D3D12_BLEND_SRC_ALPHA;
+        target.DestBlend = D3D12_BLEND_ONE;
+        target.BlendOp = D3D12_BLEND_OP_REV_SUBTRACT;
+        break;
+    case BlendMode::kMultiply:
+        target.SrcBlend = D3D12_BLEND_ZERO;
+        target.DestBlend = D3D12_BLEND_SRC_COLOR;
+        target.BlendOp = D3D12_BLEND_OP_ADD;
+        break;
+    default:
+        break;
+    }
+    return blendDesc;
+}
+
+D3D12_SHADER_VISIBILITY ToD3D12(ShaderVisibility visibility) {
+    switch (visibility) {
+    case ShaderVisibility::kVertex: return D3D12_SHADER_VISIBILITY_VERTEX;
+    case ShaderVisibility::kPixel: return D3D12_SHADER_VISIBILITY_PIXEL;
+    default: return D3D12_SHADER_VISIBILITY_ALL;
+    }
+}
+
+D3D12_CULL_MODE ToD3D12(CullMode mode) {
+    switch (mode) {
+    case CullMode::kFront: return D3D12_CULL_MODE_FRONT;
+    case CullMode::kBack: return D3D12_CULL_MODE_BACK;
+    default: return D3D12_CULL_MODE_NONE;
+    }
+}
+
+D3D12_PRIMITIVE_TOPOLOGY_TYPE ToD3D12(TopologyType type) {
+    switch (type) {
+    case TopologyType::kLine: return D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE;
+    case TopologyType::kPoint: return D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT;
+    default: return D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    }
+}
+
+// ビルドグラフのエントリポイントと比べられる形にする
+std::wstring NormalizeShaderPath(const std::wstring& filePath) {
+    return std::filesystem::path(filePath).lexically_normal().generic_wstring();
+}
+
+// コンパイル済みシェーダーのキー (パス・プロファイル・エントリポイント・マクロ定義)
+std::wstring MakeShaderKey(const ShaderEntryPoint& entryPoint) {
+    std::wstring key = entryPoint.filePath + L"|" + entryPoint.profile + L"|" + entryPoint.entryPoint;
+    for (const std::wstring& define : entryPoint.defines) {
+        key += L"|" + define;
+    }
+    return key;
+}
+
+} // namespace
+
+PipelineLibrary* PipelineLibrary::GetInstance() {
+    static PipelineLibrary instance;
+    return &instance;
+}
+
+void PipelineLibrary::Initialize(ID3D12Device* device) {
+    assert(device != nullptr);
+    device_ = device;
+
+    OpenLibrary();
+
+    HRESULT hr = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&dxcUtils_));
+    assert(SUCCEEDED(hr));
+
+    // ワーカースレッドの起動 (メインスレッドとレンダリング分を残す)
+    uint32_t hardwareThreads = std::thread::hardware_concurrency();
+    uint32_t workerCount = std::clamp(hardwareThreads > 2 ? hardwareThreads - 2 : 1u, 1u, 4u);
+    exitRequested_ = false;
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        workers_.emplace_back(&PipelineLibrary::WorkerMain, this);
+    }
+}
+
+void PipelineLibrary::Finalize() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        exitRequested_ = true;
+        jobs_.clear();
+    }
+    requestCondition_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+
+    Save();
+
+    shaderWatcher_.Finalize();
+    hotReloadEnabled_ = false;
+    pendingSwaps_.clear();
+    retiredPipelines_.clear();
+    appliedGenerations_.clear();
+
+    pipelineStates_.clear();
+    pipelineRootSignatures_.clear();
+    shaderEntryPoints_.clear();
+    shaders_.clear();
+    shaderReflections_.clear();
+    dxcUtils_.Reset();
+    rootSignatures_.clear();
+    registry_.Clear();
+    libraryEntries_.clear();
+    librarySuperseded_ = false;
+    library_.Reset();
+    libraryData_.clear();
+    device_.Reset();
+}
+
+PipelineLibrary::Handle PipelineLibrary::Request(const PipelineDesc& desc, Handle fallback) {
+    // リフレクションで埋めた記述で登録する (同じシェーダーなら同じルートパラメータになるので、同じハンドルが返る)
+    PipelineDesc reflectedDesc;
+    const PipelineDesc* registeredDesc = &desc;
+    if (desc.reflectRootSignature) {
+        reflectedDesc = desc;
+        std::string error;
+        if (!ReflectRootSignature(reflectedDesc, &error)) {
+            LogError(LogCategory::kPipeline, "Failed to reflect root signature, vs:{}, ps:{}\n{}", desc.vertexShader, desc.pixelShader,
+                error);
+            return kInvalidHandle;
+        }
+        registeredDesc = &reflectedDesc;
+    }
+    // 作れないルートシグネチャのパイプラインは登録しない
+    ID3D12RootSignature* rootSignature = CreateRootSignature(*registeredDesc);
+    if (rootSignature == nullptr) {
+        return kInvalidHandle;
+    }
+
+    bool added = false;
+    Handle handle = registry_.Register(*registeredDesc, &added);
+    if (added) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pipelineStates_.emplace_back();
+            pipelineRootSignatures_.push_back(rootSignature);
+            jobs_.push_back({ Job::Type::kPipeline, handle });
+        }
+        requestCondition_.notify_one();
+    }
+    if (fallback != kInvalidHandle) {
+        registry_.SetFallback(handle, fallback);
+    }
+    return handle;
+}
+
+void PipelineLibrary::PrecompileShaders(const std::vector<ShaderEntryPoint>& entryPoints) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const ShaderEntryPoint& entryPoint : entryPoints) {
+            jobs_.push_back({ Job::Type::kShader, static_cast<uint32_t>(shaderEntryPoints_.size()) });
+            shaderEntryPoints_.push_back(entryPoint);
+        }
+    }
+    requestCondition_.notify_all();
+}
+
+void PipelineLibrary::EnableHotReload(const ShaderBuildGraph& graph) {
+    shaderGraph_ = graph;
+    shaderWatcher_.Initialize(&shaderGraph_);
+    hotReloadEnabled_ = true;
+}
+
+void PipelineLibrary::Update() {
+    ++frameCount_;
+    if (hotReloadEnabled_) {
+        std::vector<size_t> changedEntryPoints = shaderWatcher_.Poll();
+        if (!changedEntryPoints.empty()) {
+            ReloadShaders(changedEntryPoints);
+        }
+    }
+
+    // 作り直しが終わったPSOをここ(フレームの境目)で差し替える
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (PipelineSwap& swap : pendingSwaps_) {
+            uint64_t& appliedGeneration = appliedGenerations_[swap.handle];
+            if (swap.generation < appliedGeneration) {
+                continue;
+            }
+            appliedGeneration = swap.generation;
+            retiredPipelines_.push_back({ std::move(pipelineStates_[swap.handle]), frameCount_ + kRetireFrameCount });
+            pipelineStates_[swap.handle] = std::move(swap.pipelineState);
+            // 最初の作成で失敗していたものも、直れば使えるようになる
+            registry_.SetStatus(swap.handle, PipelineStatus::kReady);
+        }
+        pendingSwaps_.clear();
+    }
+
+    while (!retiredPipelines_.empty() && retiredPipelines_.front().releaseFrame <= frameCount_) {
+        retiredPipelines_.pop_front();
+    }
+}
+
+ID3D12PipelineState* PipelineLibrary::GetPipelineState(Handle handle) const {
+    Handle resolved = registry_.Resolve(handle);
+    if (resolved == kInvalidHandle) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    return pipelineStates_[resolved].Get();
+}
+
+ID3D12RootSignature* PipelineLibrary::GetRootSignature(Handle handle) const {
+    if (handle == kInvalidHandle) {
+        return nullptr;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    assert(handle < pipelineRootSignatures_.size());
+    return pipelineRootSignatures_[handle];
+}
+
+uint32_t PipelineLibrary::GetRootParameterIndex(Handle handle, const std::string& name) const {
+    if (handle == kInvalidHandle) {
+        return UINT32_MAX;
+    }
+    std::lock_guard<std::mutex> lock(mutex_);
+    return FindRootParameter(registry_.GetDesc(handle).rootParameters, name);
+}
+
+void PipelineLibrary::Wait(Handle handle) {
+    if (handle == kInvalidHandle) {
+        return;
+    }
+    std::unique_lock<std::mutex> lock(mutex_);
+    builtCondition_.wait(lock, [&] { return exitRequested_ || registry_.GetStatus(handle) != PipelineStatus::kPending; });
+}
+
+void PipelineLibrary::WaitAll() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    builtCondition_.wait(lock, [&] { return exitRequested_ || registry_.GetPendingCount() == 0; });
+}
+
+void PipelineLibrary::Save() {
+    std::lock_guard<std::mutex> lock(libraryMutex_);
+    if (library_ == nullptr || !libraryDirty_) {
+        return;
+    }
+    if (librarySuperseded_ && !RebuildLibrary()) {
+        return;
+    }
+    std::vector<char> data(library_->GetSerializedSize());
+    HRESULT hr = library_->Serialize(data.data(), data.size());
+    if (FAILED(hr)) {
+        LogError(LogCategory::kPipeline, "Failed to serialize pipeline library");
+        return;
+    }
+
+    // 一時ファイルに書いてから置き換える
+    std::error_code ec;
+    std::filesystem::path path(kLibraryPath);
+    std::filesystem::create_directories(path.parent_path(), ec);
+    std::filesystem::path temporaryPath = path;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        file.write(data.data(), static_cast<std::streamsize>(data.size()));
+        if (!file) {
+            LogError(LogCategory::kPipeline, "Failed to write pipeline library");
+            return;
+        }
+    }
+    std::filesystem::rename(temporaryPath, path, ec);
+    libraryDirty_ = false;
+    LogInfo(LogCategory::kPipeline, "Saved pipeline library ({} bytes)", data.size());
+}
+
+void PipelineLibrary::OpenLibrary() {
+    Microsoft::WRL::ComPtr<ID3D12Device1> device1;
+    if (FAILED(device_.As(&device1))) {
+        LogWarning(LogCategory::kPipeline, "ID3D12PipelineLibrary is not supported");
+        return;
+    }
+
+    std::ifstream file(kLibraryPath, std::ios::binary);
+    if (file.is_open()) {
+        libraryData_.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    }
+    HRESULT hr = E_FAIL;
+    if (!libraryData_.empty()) {
+        hr = device1->CreatePipelineLibrary(libraryData_.data(), libraryData_.size(), IID_PPV_ARGS(&library_));
+        if (FAILED(hr)) {
+            // ドライバーやGPUが変わった、またはファイルが壊れている
+            LogWarning(LogCategory::kPipeline, "Discarded pipeline library (hr=0x{:08x})", static_cast<uint32_t>(hr));
+            libraryData_.clear();
+        }
+    }
+    if (FAILED(hr)) {
+        hr = device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&library_));
+        if (FAILED(hr)) {
+            LogWarning(LogCategory::kPipeline, "Failed to create pipeline library");
+            library_.Reset();
+        }
+    }
+}
+
+bool PipelineLibrary::RebuildLibrary() {
+    // 古い名前のPSOは外せないので、空のライブラリに今の名前のものだけを入れ直す
+    // (この起動で要求しなかったパイプラインも落ちるが、次に要求したときに作ってまた入る)
+    Microsoft::WRL::ComPtr<ID3D12Device1> device1;
+    Microsoft::WRL::ComPtr<ID3D12PipelineLibrary> library;
+    if (FAILED(device_.As(&device1)) || FAILED(device1->CreatePipelineLibrary(nullptr, 0, IID_PPV_ARGS(&library)))) {
+        LogError(LogCategory::kPipeline, "Failed to rebuild pipeline library");
+        return false;
+    }
+    for (const auto& [key, entry] : libraryEntries_) {
+        if (FAILED(library->StorePipeline(entry.name.c_str(), entry.pipelineState.Get()))) {
+            LogWarning(LogCategory::kPipeline, "Failed to store pipeline {:016x} in rebuilt library", key);
+        }
+    }
+    // 読み込んだデータは古いライブラリを外してから捨てる
+    library_ = library;
+    libraryData_.clear();
+    librarySuperseded_ = false;
+    LogInfo(LogCategory::kPipeline, "Rebuilt pipeline library ({} pipelines)", libraryEntries_.size());
+    return true;
+}
+
+ID3D12RootSignature* PipelineLibrary::CreateRootSignature(const PipelineDesc& desc) {
+    uint64_t key = HashRootSignature(desc);
+    auto it = rootSignatures_.find(key);
+    if (it != rootSignatures_.end()) {
+        return it->second.Get();
+    }
+
+    D3D12_ROOT_SIGNATURE_DESC descriptionRootSignature{};
+    descriptionRootSignature.Flags = D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT;
+
+    D3D12_STATIC_SAMPLER_DESC staticSamplers[1] = {};
+    staticSamplers[0].Filter = D3D12_FILTER_MIN_MAG_MIP_LINEAR;
+    staticSamplers[0].AddressU = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+    staticSamplers[0].AddressV = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+    staticSamplers[0].AddressW = D3D12_TEXTURE_ADDRESS_MODE_WRAP;
+    staticSamplers[0].ComparisonFunc = D3D12_COMPARISON_FUNC_NEVER;
+    staticSamplers[0].MaxLOD = D3D12_FLOAT32_MAX;
+    staticSamplers[0].ShaderRegister = 0;
+    staticSamplers[0].ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL;
+    if (desc.linearWrapSampler) {
+        descriptionRootSignature.pStaticSamplers = staticSamplers;
+        descriptionRootSignature.NumStaticSamplers = _countof(staticSamplers);
+    }
+
+    std::vector<D3D12_ROOT_PARAMETER> rootParameters(desc.rootParameters.size());
+    std::vector<D3D12_DESCRIPTOR_RANGE> descriptorRanges(desc.rootParameters.size());
+    for (size_t i = 0; i < desc.rootParameters.size(); ++i) {
+        const RootParameter& parameter = desc.rootParameters[i];
+        rootParameters[i].ShaderVisibility = ToD3D12(parameter.visibility);
+        if (parameter.type == RootParameterType::kCBV) {
+            rootParameters[i].ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV;
+            rootParameters[i].Descriptor.ShaderRegister = parameter.shaderRegister;
+        } else if (parameter.type == RootParameterType::kConstants) {
+            rootParameters[i].ParameterType = D3D12_ROOT_PARAMETER_TYPE_32BIT_CONSTANTS;
+            rootParameters[i].Constants.ShaderRegister = parameter.shaderRegister;
+            rootParameters[i].Constants.Num32BitValues = parameter.constantCount;
+        } else {
+            descriptorRanges[i].BaseShaderRegister = parameter.shaderRegister;
+            descriptorRanges[i].NumDescriptors = 1;
+            descriptorRanges[i].RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV;
+            descriptorRanges[i].OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND;
+            rootParameters[i].ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE;
+            rootParameters[i].DescriptorTable.pDescriptorRanges = &descriptorRanges[i];
+            rootParameters[i].DescriptorTable.NumDescriptorRanges = 1;
+        }
+    }
+    descriptionRootSignature.pParameters = rootParameters.data();
+    descriptionRootSignature.NumParameters = static_cast<UINT>(rootParameters.size());
+
+    Microsoft::WRL::ComPtr<ID3DBlob> signatureBlob;
+    Microsoft::WRL::ComPtr<ID3DBlob> errorBlob;
+    HRESULT hr = D3D12SerializeRootSignature(&descriptionRootSignature, D3D_ROOT_SIGNATURE_VERSION_1, &signatureBlob, &errorBlob);
+    if (FAILED(hr)) {
+        LogError(LogCategory::kPipeline, "Failed to serialize root signature\n{}",
+            errorBlob != nullptr ? reinterpret_cast<char*>(errorBlob->GetBufferPointer()) : "");
+        return nullptr;
+    }
+    Microsoft::WRL::ComPtr<ID3D12RootSignature> rootSignature;
+    hr = device_->CreateRootSignature(0, signatureBlob->GetBufferPointer(), signatureBlob->GetBufferSize(), IID_PPV_ARGS(&rootSignature));
+    if (FAILED(hr)) {
+        LogError(LogCategory::kPipeline, "Failed to create root signature (hr=0x{:08x})", static_cast<uint32_t>(hr));
+        return nullptr;
+    }
+    rootSignatures_.emplace(key, rootSignature);
+    return rootSignature.Get();
+}
+
+bool PipelineLibrary::ReflectRootSignature(PipelineDesc& desc, std::string* error) {
+    PROFILE_SCOPE("ReflectRootSignature");
+    // まだリフレクションしていないシェーダーを (パーミュテーションは全ての組み合わせを) 先頭に積み、ワーカーに並列でコンパイルさせる
+    // コンパイル結果はPSOの作成と共有するので、ここで待った分だけ後のパイプラインの作成が早くなる
+    std::vector<ShaderEntryPoint> entryPoints = { { desc.vertexShader, desc.vertexProfile, L"main", desc.vertexDefines } };
+    if (!desc.pixelShader.empty()) {
+        entryPoints.push_back({ desc.pixelShader, desc.pixelProfile, L"main", desc.pixelDefines });
+    }
+    bool queued = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const ShaderEntryPoint& entryPoint : ExpandShaderPermutations(entryPoints)) {
+            if (shaderReflections_.count(MakeShaderKey(entryPoint)) == 0) {
+                jobs_.push_front({ Job::Type::kShader, static_cast<uint32_t>(shaderEntryPoints_.size()) });
+                shaderEntryPoints_.push_back(entryPoint);
+                queued = true;
+            }
+        }
+    }
+    if (queued) {
+        requestCondition_.notify_all();
+    }
+    return ReflectRootParameters(desc,
+        [this](const std::wstring& filePath, const std::wstring& profile, const std::vector<std::wstring>& defines,
+            ShaderReflection& reflection, std::string* message) {
+            return ReflectCompiledShader({ filePath, profile, L"main", defines }, reflection, message);
+        },
+        error);
+}
+
+bool PipelineLibrary::ReflectCompiledShader(const ShaderEntryPoint& entryPoint, ShaderReflection& reflection, std::string* error) {
+    std::wstring key = MakeShaderKey(entryPoint);
+    auto it = shaderReflections_.find(key);
+    if (it != shaderReflections_.end()) {
+        reflection = it->second;
+        return true;
+    }
+
+    // ReflectRootSignature で積んだものをワーカーがコンパイルし終えるのを待つ (メインスレッドではコンパイルしない)
+    ShaderCompileResult result;
+    bool succeeded = false;
+    {
+        std::unique_lock<std::mutex> lock(shaderMutex_);
+        ShaderNode& node = shaders_[key];
+        shaderCondition_.wait(lock, [&node] { return node.state == ShaderNode::State::kDone; });
+        result = node.result;
+        succeeded = node.succeeded;
+    }
+    std::string filePath = std::filesystem::path(entryPoint.filePath).generic_string();
+    if (!succeeded) {
+        if (error) {
+            *error = filePath + ": " + result.errors;
+        }
+        return false;
+    }
+    if (!ReflectShader(dxcUtils_.Get(), result.blob.Get(), reflection, error)) {
+        if (error) {
+            *error = filePath + ": " + *error;
+        }
+        return false;
+    }
+    shaderReflections_.emplace(key, reflection);
+    return true;
+}
+
+void PipelineLibrary::WorkerMain() {
+    CpuProfiler::GetInstance()->SetThreadName("PipelineWorker");
+    // DXCのインスタンスはスレッドごとに持つ
+    ShaderCompiler compiler;
+    while (true) {
+        Job job{};
+        ShaderEntryPoint shaderEntryPoint;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            requestCondition_.wait(lock, [this] { return exitRequested_ || !jobs_.empty(); });
+            if (exitRequested_) {
+                return;
+            }
+            job = jobs_.front();
+            jobs_.pop_front();
+            if (job.type == Job::Type::kShader) {
+                shaderEntryPoint = shaderEntryPoints_[job.index];
+            }
+        }
+
+        if (job.type == Job::Type::kShader) {
+            ShaderCompileResult result;
+            AcquireShader(shaderEntryPoint, compiler, result);
+            continue;
+        }
+
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
+        bool succeeded = BuildPipeline(job.index, compiler, pipelineState);
+        if (job.type == Job::Type::kReload) {
+            // 差し替えはメインスレッドのUpdateで行う (失敗したら今のPSOを使い続ける)
+            if (succeeded) {
+                std::lock_guard<std::mutex> lock(mutex_);
+                pendingSwaps_.push_back({ job.index, job.generation, std::move(pipelineState) });
+            } else {
+                LogWarning(LogCategory::kPipeline, "Reload failed, keeping previous pipeline {}", job.index);
+            }
+            continue;
+        }
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pipelineStates_[job.index] = std::move(pipelineState);
+            registry_.SetStatus(job.index, succeeded ? PipelineStatus::kReady : PipelineStatus::kFailed);
+        }
+        builtCondition_.notify_all();
+    }
+}
+
+void PipelineLibrary::ReloadShaders(const std::vector<size_t>& entryPoints) {
+    std::vector<std::wstring> filePaths;
+    for (size_t index : entryPoints) {
+        const ShaderEntryPoint& entryPoint = shaderGraph_.GetEntryPoints()[index];
+        filePaths.push_back(entryPoint.filePath);
+        LogInfo(LogCategory::kPipeline, "Shader changed: {} ({})", entryPoint.filePath, entryPoint.profile);
+    }
+
+    // コンパイル結果を捨てる (コンパイル中のものは終わってからもう一度コンパイルさせる)
+    {
+        std::lock_guard<std::mutex> lock(shaderMutex_);
+        for (auto& [key, node] : shaders_) {
+            std::wstring filePath = NormalizeShaderPath(key.substr(0, key.find(L'|')));
+            if (std::find(filePaths.begin(), filePaths.end(), filePath) == filePaths.end()) {
+                continue;
+            }
+            if (node.state == ShaderNode::State::kDone) {
+                node.state = ShaderNode::State::kIdle;
+                node.result = {};
+            } else if (node.state == ShaderNode::State::kCompiling) {
+                node.invalidated = true;
+            }
+        }
+    }
+    // リフレクションも取り直す (作り直すパイプラインのルートシグネチャは変わらない。この後に要求したものは新しいシェーダーで決まる)
+    for (auto it = shaderReflections_.begin(); it != shaderReflections_.end();) {
+        std::wstring filePath = NormalizeShaderPath(it->first.substr(0, it->first.find(L'|')));
+        if (std::find(filePaths.begin(), filePaths.end(), filePath) != filePaths.end()) {
+            it = shaderReflections_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+
+    // そのシェーダーを使うパイプラインだけを作り直す
+    ++reloadGeneration_;
+    size_t reloadCount = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (Handle handle = 0; handle < registry_.GetCount(); ++handle) {
+            // 最初の作成がまだなら、そちらで新しいシェーダーが使われる
+            if (registry_.GetStatus(handle) == PipelineStatus::kPending) {
+                continue;
+            }
+            const PipelineDesc& desc = registry_.GetDesc(handle);
+            std::wstring vertexShader = NormalizeShaderPath(desc.vertexShader);
+            std::wstring pixelShader = NormalizeShaderPath(desc.pixelShader);
+            bool affected = std::any_of(filePaths.begin(), filePaths.end(),
+                [&](const std::wstring& filePath) { return filePath == vertexShader || filePath == pixelShader; });
+            if (affected) {
+                jobs_.push_back({ Job::Type::kReload, handle, reloadGeneration_ });
+                ++reloadCount;
+            }
+        }
+    }
+    requestCondition_.notify_all();
+    LogInfo(LogCategory::kPipeline, "Reloading {} pipelines", reloadCount);
+}
+
+bool PipelineLibrary::AcquireShader(const ShaderEntryPoint& entryPoint, ShaderCompiler& compiler, ShaderCompileResult& result) {
+    std::unique_lock<std::mutex> lock(shaderMutex_);
+    ShaderNode& node = shaders_[MakeShaderKey(entryPoint)];
+    while (true) {
+        // 他のワーカーがコンパイル中なら終わるのを待つ
+        shaderCondition_.wait(lock, [&node] { return node.state != ShaderNode::State::kCompiling; });
+        if (node.state == ShaderNode::State::kDone) {
+            // ホットリロードで書き換えられることがあるので、コピーして返す
+            result = node.result;
+            return node.succeeded;
+        }
+
+        node.state = ShaderNode::State::kCompiling;
+        node.invalidated = false;
+        lock.unlock();
+        ShaderCompileResult compiled;
+        PROFILE_SCOPE("CompileShader");
+        bool succeeded = compiler.Compile(entryPoint.filePath, entryPoint.profile, entryPoint.entryPoint, compiled,
+            kShaderDebugBuild, entryPoint.defines);
+        if (succeeded) {
+            LogInfo(LogCategory::kPipeline, "Shader {}: {:.2f}ms{}", GetShaderEntryPointName(entryPoint), compiled.milliseconds,
+                compiled.cacheHit ? " (cache)" : "");
+        } else {
+            LogError(LogCategory::kPipeline, "Failed to compile {}\n{}", GetShaderEntryPointName(entryPoint), compiled.errors);
+        }
+
+        lock.lock();
+        node.result = std::move(compiled);
+        node.succeeded = succeeded;
+        // コンパイル中にファイルが変更されていたらもう一度
+        node.state = node.invalidated ? ShaderNode::State::kIdle : ShaderNode::State::kDone;
+        shaderCondition_.notify_all();
+    }
+}
+
+bool PipelineLibrary::BuildPipeline(Handle handle, ShaderCompiler& compiler, Microsoft::WRL::ComPtr<ID3D12PipelineState>& pipelineState) {
+    PROFILE_SCOPE("BuildPipeline");
+    const PipelineDesc& desc = registry_.GetDesc(handle);
+
+    // シェーダーのコンパイル (他のパイプラインと共有する)
+    ShaderCompileResult vertexShader;
+    if (!AcquireShader({ desc.vertexShader, desc.vertexProfile, L"main", desc.vertexDefines }, compiler, vertexShader)) {
+        return false;
+    }
+    ShaderCompileResult pixelShader;
+    if (!desc.pixelShader.empty() &&
+        !AcquireShader({ desc.pixelShader, desc.pixelProfile, L"main", desc.pixelDefines }, compiler, pixelShader)) {
+        return false;
+    }
+
+    std::vector<D3D12_INPUT_ELEMENT_DESC> inputElementDescs(desc.inputLayout.size());
+    for (size_t i = 0; i < desc.inputLayout.size(); ++i) {
+        inputElementDescs[i].SemanticName = desc.inputLayout[i].semanticName.c_str();
+        inputElementDescs[i].SemanticIndex = desc.inputLayout[i].semanticIndex;
+        inputElementDescs[i].Format = static_cast<DXGI_FORMAT>(desc.inputLayout[i].format);
+        inputElementDescs[i].AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT;
+    }
+
+    D3D12_RASTERIZER_DESC rasterizerDesc{};
+    rasterizerDesc.CullMode = ToD3D12(desc.cullMode);
+    rasterizerDesc.FillMode = desc.wireframe ? D3D12_FILL_MODE_WIREFRAME : D3D12_FILL_MODE_SOLID;
+    rasterizerDesc.FrontCounterClockwise = FALSE;
+    rasterizerDesc.DepthClipEnable = TRUE;
+
+    D3D12_DEPTH_STENCIL_DESC depthStencilDesc{};
+    depthStencilDesc.DepthEnable = desc.depthMode != DepthMode::kNone;
+    depthStencilDesc.DepthWriteMask = desc.depthMode == DepthMode::kReadWrite ? D3D12_DEPTH_WRITE_MASK_ALL : D3D12_DEPTH_WRITE_MASK_ZERO;
+    depthStencilDesc.DepthFunc = desc.reversedZ ? D3D12_COMPARISON_FUNC_GREATER_EQUAL : D3D12_COMPARISON_FUNC_LESS_EQUAL;
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC graphicsPipelineStateDesc{};
+    graphicsPipelineStateDesc.pRootSignature = GetRootSignature(handle);
+    graphicsPipelineStateDesc.InputLayout = { inputElementDescs.data(), static_cast<UINT>(inputElementDescs.size()) };
+    graphicsPipelineStateDesc.VS = { vertexShader.blob->GetBufferPointer(), vertexShader.blob->GetBufferSize() };
+    if (pixelShader.blob != nullptr) {
+        graphicsPipelineStateDesc.PS = { pixelShader.blob->GetBufferPointer(), pixelShader.blob->GetBufferSize() };
+    }
+    graphicsPipelineStateDesc.BlendState = MakeBlendDesc(desc.blendMode);
+    graphicsPipelineStateDesc.RasterizerState = rasterizerDesc;
+    graphicsPipelineStateDesc.DepthStencilState = depthStencilDesc;
+    graphicsPipelineStateDesc.DSVFormat = static_cast<DXGI_FORMAT>(desc.dsvFormat);
+    graphicsPipelineStateDesc.NumRenderTargets = static_cast<UINT>(std::min<size_t>(desc.rtvFormats.size(), 8));
+    for (UINT i = 0; i < graphicsPipelineStateDesc.NumRenderTargets; ++i) {
+        graphicsPipelineStateDesc.RTVFormats[i] = static_cast<DXGI_FORMAT>(desc.rtvFormats[i]);
+    }
+    graphicsPipelineStateDesc.PrimitiveTopologyType = ToD3D12(desc.topologyType);
+    graphicsPipelineStateDesc.SampleDesc.Count = 1;
+    graphicsPipelineStateDesc.SampleMask = D3D12_DEFAULT_SAMPLE_MASK;
+
+    // ライブラリ内の名前 (シェーダーの中身が変わったら別の名前になるように、キャッシュのキーも混ぜる)
+    uint64_t name = registry_.GetKey(handle);
+    name = (name ^ vertexShader.cacheKey) * 1099511628211ull;
+    name = (name ^ pixelShader.cacheKey) * 1099511628211ull;
+    wchar_t nameText[17] = {};
+    std::swprintf(nameText, _countof(nameText), L"%016llx", static_cast<unsigned long long>(name));
+
+    // ライブラリにあればそれを使う
+    HRESULT hr = E_FAIL;
+    {
+        std::lock_guard<std::mutex> lock(libraryMutex_);
+        if (library_ != nullptr) {
+            hr = library_->LoadGraphicsPipeline(nameText, &graphicsPipelineStateDesc, IID_PPV_ARGS(&pipelineState));
+        }
+    }
+    bool loaded = SUCCEEDED(hr);
+    if (!loaded) {
+        hr = device_->CreateGraphicsPipelineState(&graphicsPipelineStateDesc, IID_PPV_ARGS(&pipelineState));
+        if (FAILED(hr)) {
+            LogError(LogCategory::kPipeline, "Failed to create pipeline state, vs:{}, ps:{}", desc.vertexShader, desc.pixelShader);
+            return false;
+        }
+    }
+    {
+        // キーの名前が変わった (シェーダーを作り直した) ら、前の名前のものは保存するときに除く
+        std::lock_guard<std::mutex> lock(libraryMutex_);
+        if (library_ != nullptr) {
+            LibraryEntry& entry = libraryEntries_[registry_.GetKey(handle)];
+            if (!entry.name.empty() && entry.name != nameText) {
+                librarySuperseded_ = true;
+            }
+            entry.name = nameText;
+            entry.pipelineState = pipelineState;
+            if (!loaded && SUCCEEDED(library_->StorePipeline(nameText, pipelineState.Get()))) {
+                libraryDirty_ = true;
+            }
+        }
+    }
+
+    LogInfo(LogCategory::kPipeline, "Pipeline {} ({}), vs:{}, ps:{}", nameText, loaded ? "library" : "created", desc.vertexShader,
+        desc.pixelShader);
+    return true;
+}
@@ -0,0 +1,194 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "PipelineDesc.h"
+#include "ShaderBuild.h"
+#include "ShaderCompiler.h"
+#include "ShaderReflection.h"
+#include "ShaderWatcher.h"
+
+// パイプラインステートの管理クラス
+// 記述のハッシュをキーにPSOを登録し、シェーダーのコンパイルとPSOの作成はワーカースレッドで行う
+// シェーダーはエントリポイントごとに1度だけコンパイルし、複数のパイプラインで共有する
+// ルートシグネチャをリフレクションで決める記述は、Requestの中でワーカーにシェーダーを先にコンパイルさせ、それを待って決める
+// 作成したPSOはID3D12PipelineLibraryに入れてディスクに保存し、次回の起動ではそこから読む
+// コンパイルが終わるまでは互換なパイプライン(フォールバック)を返す
+// ホットリロードを有効にすると、変更されたシェーダーを使うパイプラインだけを作り直し、フレームの境目で差し替える
+class PipelineLibrary {
+public:
+    // パイプラインハンドル (Requestの戻り値)
+    using Handle = uint32_t;
+    static const Handle kInvalidHandle = PipelineRegistry::kInvalidId;
+
+public:
+    // シングルトンインスタンスの取得
+    static PipelineLibrary* GetInstance();
+
+    // 初期化
+    void Initialize(ID3D12Device* device);
+
+    // 終了処理 (コンパイル中のものを待ち、パイプラインライブラリを保存する)
+    void Finalize();
+
+    // パイプラインの要求 (同じ記述なら同じハンドルを返す)
+    // PSOの作成は待たずに戻る。reflectRootSignature の記述は、まだリフレクションしていないシェーダーのコンパイルだけを待つ
+    // リフレクションかルートシグネチャの作成に失敗したら、ログに出して kInvalidHandle を返す (PSOが nullptr になり、描画は飛ばされる)
+    // fallback を指定すると、コンパイルが終わるまでそのパイプラインを使う
+    Handle Request(const PipelineDesc& desc, Handle fallback = kInvalidHandle);
+
+    // 描画に使うPSO (コンパイル中はフォールバック、それも無ければ nullptr。nullptr なら描画を飛ばすこと)
+    ID3D12PipelineState* GetPipelineState(Handle handle) const;
+
+    // ルートシグネチャ (Requestの時点で作られている。kInvalidHandle なら nullptr)
+    ID3D12RootSignature* GetRootSignature(Handle handle) const;
+
+    // ルートパラメータの番号 (リフレクションで作った記述のとき、シェーダー内の名前で引く。無いか kInvalidHandle なら UINT32_MAX)
+    uint32_t GetRootParameterIndex(Handle handle, const std::string& name) const;
+
+    // シェーダーを先にコンパイルしておく (ワーカースレッドで並列に行い、1つごとにかかった時間をログに出す)
+    void PrecompileShaders(const std::vector<ShaderEntryPoint>& entryPoints);
+
+    // シェーダーのホットリロードを有効にする (graph のエントリポイントとインクルードを監視する)
+    void EnableHotReload(const ShaderBuildGraph& graph);
+
+    // 毎フレームの更新 (フレームの先頭、コマンドを積む前に呼ぶ。ブロックしない)
+    // 変更されたシェーダーのパイプラインを作り直しに出し、作り直しが終わったPSOを差し替える
+    void Update();
+
+    // コンパイルが終わって使えるか
+    bool IsReady(Handle handle) const { return handle != kInvalidHandle && registry_.GetStatus(handle) == PipelineStatus::kReady; }
+
+    // コンパイルが終わるまで待つ (kInvalidHandle ならすぐに戻る)
+    void Wait(Handle handle);
+    void WaitAll();
+
+    // パイプラインライブラリをディスクに保存する (新しいPSOが無ければ何もしない)
+    void Save();
+
+    // ゲッター
+    size_t GetPendingCount() const { return registry_.GetPendingCount(); }
+    const PipelineRegistry& GetRegistry() const { return registry_; }
+
+private:
+    PipelineLibrary() = default;
+    ~PipelineLibrary() = default;
+    PipelineLibrary(const PipelineLibrary&) = delete;
+    const PipelineLibrary& operator=(const PipelineLibrary&) = delete;
+
+    void OpenLibrary();
+    // 作り直しで使わなくなった名前のPSOを除いたライブラリを作り直す (libraryMutex_ を持って呼ぶ)
+    bool RebuildLibrary();
+    ID3D12RootSignature* CreateRootSignature(const PipelineDesc& desc);
+    // desc のシェーダーをリフレクションしてルートパラメータを埋める (コンパイルはワーカーに出して待つ)
+    bool ReflectRootSignature(PipelineDesc& desc, std::string* error);
+    // ワーカーがコンパイルしたシェーダーを待ってリフレクションする (結果は shaderReflections_ に残す)
+    bool ReflectCompiledShader(const ShaderEntryPoint& entryPoint, ShaderReflection& reflection, std::string* error);
+    void WorkerMain();
+    bool AcquireShader(const ShaderEntryPoint& entryPoint, ShaderCompiler& compiler, ShaderCompileResult& result);
+    bool BuildPipeline(Handle handle, ShaderCompiler& compiler, Microsoft::WRL::ComPtr<ID3D12PipelineState>& pipelineState);
+    void ReloadShaders(const std::vector<size_t>& entryPoints);
+
+private:
+    // ワーカーの仕事
+    struct Job {
+        enum class Type {
+            kShader,   // シェーダーのコンパイル (index は shaderEntryPoints_ の番号)
+            kPipeline, // パイプラインの作成 (index はハンドル)
+            kReload,   // パイプラインの作り直し (index はハンドル。終わったら差し替え待ちに入れる)
+        };
+        Type type;
+        uint32_t index;
+        uint64_t generation = 0; // 作り直しの世代 (kReloadのみ。古い結果で新しいものを上書きしないようにする)
+    };
+
+    // コンパイル済みシェーダー
+    struct ShaderNode {
+        enum class State {
+            kIdle,      // 未着手
+            kCompiling, // どれかのワーカーがコンパイル中
+            kDone,      // 完了 (succeeded が結果)
+        };
+        State state = State::kIdle;
+        bool succeeded = false;
+        bool invalidated = false; // コンパイル中にファイルが変更された (終わったらもう一度コンパイルする)
+        ShaderCompileResult result;
+    };
+
+    // 作り直したパイプライン
+    struct PipelineSwap {
+        Handle handle;
+        uint64_t generation;
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
+    };
+
+    // ライブラリに入れたPSO (キーごとに最新の名前のものだけ)
+    struct LibraryEntry {
+        std::wstring name;
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
+    };
+
+    // 差し替えで外したPSO (GPUが使い終わるまで持っておく)
+    struct RetiredPipeline {
+        Microsoft::WRL::ComPtr<ID3D12PipelineState> pipelineState;
+        uint64_t releaseFrame;
+    };
+
+    // パイプラインライブラリの保存先 (ドライバーが変わると読めないので、その場合は作り直す)
+    static constexpr const char* kLibraryPath = "Resources/cooked/PipelineLibrary.bin";
+    // 外したPSOを解放するまでのフレーム数 (記録中・実行中のコマンドリストが使っているかもしれない)
+    static constexpr uint64_t kRetireFrameCount = 3;
+
+    Microsoft::WRL::ComPtr<ID3D12Device> device_;
+    Microsoft::WRL::ComPtr<ID3D12PipelineLibrary> library_;
+    std::vector<char> libraryData_; // ライブラリが生きている間は保持しておく必要がある
+    std::mutex libraryMutex_;        // library_ から librarySuperseded_ までを保護する
+    bool libraryDirty_ = false;
+    // ライブラリには名前を消す手段が無いので、作り直しで名前が変わったら (librarySuperseded_)、
+    // 保存するときに libraryEntries_ だけを入れたライブラリを作り直す (ホットリロードのたびにファイルが大きくならないようにする)
+    std::unordered_map<uint64_t, LibraryEntry> libraryEntries_;
+    bool librarySuperseded_ = false;
+
+    PipelineRegistry registry_;
+
+    // ルートシグネチャ (キー → ルートシグネチャ。メインスレッドのみ)
+    std::unordered_map<uint64_t, Microsoft::WRL::ComPtr<ID3D12RootSignature>> rootSignatures_;
+
+    // リフレクション (メインスレッドのみ。コンパイルはしないのでDXCはユーティリティだけを持つ)
+    Microsoft::WRL::ComPtr<IDxcUtils> dxcUtils_;
+    std::unordered_map<std::wstring, ShaderReflection> shaderReflections_; // シェーダーのキー → リフレクション
+
+    // ワーカースレッドと共有するデータ (mutex_で保護)
+    mutable std::mutex mutex_;
+    std::condition_variable requestCondition_;
+    std::condition_variable builtCondition_;
+    std::deque<Job> jobs_;
+    std::vector<ShaderEntryPoint> shaderEntryPoints_;
+    // PSOとルートシグネチャ (要素のアドレスが変わらないようにdequeに置く)
+    std::deque<Microsoft::WRL::ComPtr<ID3D12PipelineState>> pipelineStates_;
+    std::deque<ID3D12RootSignature*> pipelineRootSignatures_;
+    std::vector<PipelineSwap> pendingSwaps_;
+    bool exitRequested_ = false;
+    std::vector<std::thread> workers_;
+
+    // ホットリロード (メインスレッドのみ)
+    bool hotReloadEnabled_ = false;
+    ShaderBuildGraph shaderGraph_;
+    ShaderWatcher shaderWatcher_;
+    std::deque<RetiredPipeline> retiredPipelines_;
+    std::unordered_map<Handle, uint64_t> appliedGenerations_;
+    uint64_t reloadGeneration_ = 0;
+    uint64_t frameCount_ = 0;
+
+    // シェーダー (パス・プロファイル・エントリポイント → ノード。shaderMutex_で保護)
+    std::mutex shaderMutex_;
+    std::condition_variable shaderCondition_;
+    std::unordered_map<std::wstring, ShaderNode> shaders_;
+};
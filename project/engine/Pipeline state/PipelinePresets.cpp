@@ -0,0 +1,138 @@
+#include "PipelinePresets.h"
+#include <dxgiformat.h>
+#include "MathUtil.h"
+
+namespace {
+
+const wchar_t* const kShaderDirectory = L"Resources/shaders/";
+
+std::wstring ShaderPath(const wchar_t* fileName) {
+    return std::wstring(kShaderDirectory) + fileName;
+}
+
+// バックバッファと深度バッファに書くパイプラインの共通部分
+PipelineDesc MakeBaseDesc(const wchar_t* vertexShader, const wchar_t* pixelShader) {
+    PipelineDesc desc;
+    desc.vertexShader = ShaderPath(vertexShader);
+    desc.pixelShader = ShaderPath(pixelShader);
+    desc.rtvFormats = { DXGI_FORMAT_R8G8B8A8_UNORM_SRGB };
+    desc.dsvFormat = DXGI_FORMAT_D32_FLOAT;
+    desc.reversedZ = kReversedZ;
+    // ルートパラメータとサンプラーはシェーダーのリフレクションから決める (Request のときにワーカーがコンパイルしたもので行う)
+    desc.reflectRootSignature = true;
+    return desc;
+}
+
+} // namespace
+
+PipelineDesc MakeObject3dPipelineDesc(uint32_t features) {
+    PipelineDesc desc = MakeBaseDesc(L"Object3d.VS.hlsl", GetObject3dPermutationSet().fileName.c_str());
+    desc.pixelDefines = MakeShaderPermutationDefines(GetObject3dPermutationSet(), features);
+    desc.inputLayout = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT },
+        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT },
+    };
+    return desc;
+}
+
+PipelineDesc MakeObjPipelineDesc() {
+    PipelineDesc desc = MakeBaseDesc(L"ObjVS.hlsl", L"ObjPS.hlsl");
+    desc.inputLayout = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT },
+        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT },
+    };
+    desc.blendMode = BlendMode::kAlpha;
+    return desc;
+}
+
+PipelineDesc MakeTerrainPipelineDesc() {
+    PipelineDesc desc = MakeBaseDesc(L"TerrainVS.hlsl", L"TerrainPS.hlsl");
+    desc.inputLayout = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT },
+        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT },
+    };
+    return desc;
+}
+
+PipelineDesc MakeSpritePipelineDesc(bool srgbOutput) {
+    PipelineDesc desc = MakeBaseDesc(L"SpriteVS.hlsl", srgbOutput ? L"SpriteSRGBOutputPS.hlsl" : L"SpritePS.hlsl");
+    desc.inputLayout = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT },
+        { "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM },
+    };
+    desc.blendMode = BlendMode::kAlpha;
+    desc.cullMode = CullMode::kNone;
+    desc.depthMode = DepthMode::kNone;
+    if (srgbOutput) {
+        desc.rtvFormats = { DXGI_FORMAT_R8G8B8A8_UNORM };
+    }
+    return desc;
+}
+
+PipelineDesc MakePrimitivePipelineDesc(DepthMode depthMode) {
+    PipelineDesc desc = MakeBaseDesc(L"PrimitiveVS.hlsl", L"PrimitivePS.hlsl");
+    desc.inputLayout = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT },
+        { "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM },
+    };
+    desc.blendMode = BlendMode::kAlpha;
+    desc.cullMode = CullMode::kNone;
+    desc.depthMode = depthMode;
+    desc.topologyType = TopologyType::kLine;
+    return desc;
+}
+
+PipelineDesc MakeShapePipelineDesc(bool srgbOutput, TopologyType topologyType) {
+    PipelineDesc desc = MakeBaseDesc(L"ShapeVS.hlsl", srgbOutput ? L"ShapeSRGBOutputPS.hlsl" : L"ShapePS.hlsl");
+    desc.inputLayout = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32_FLOAT },
+        { "COLOR", 0, DXGI_FORMAT_R8G8B8A8_UNORM },
+    };
+    desc.blendMode = BlendMode::kAlpha;
+    desc.cullMode = CullMode::kNone;
+    desc.depthMode = DepthMode::kNone;
+    desc.topologyType = topologyType;
+    if (srgbOutput) {
+        desc.rtvFormats = { DXGI_FORMAT_R8G8B8A8_UNORM };
+    }
+    return desc;
+}
+
+PipelineDesc MakeSkyPipelineDesc() {
+    PipelineDesc desc = MakeBaseDesc(L"SkyVS.hlsl", L"SkyPS.hlsl");
+    desc.inputLayout = {
+        { "POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT },
+        { "TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT },
+        { "NORMAL", 0, DXGI_FORMAT_R32G32B32_FLOAT },
+    };
+    // 内側から見るので裏面も描く。奥の深度に置くので、何かが描かれた画素は深度テストで弾かれる
+    desc.cullMode = CullMode::kNone;
+    desc.depthMode = DepthMode::kReadOnly;
+    return desc;
+}
+
+void RequestPresetPipelines(PipelineLibrary* pipelineLibrary) {
+    // Object3dは全ての組み合わせを用意しておく (コンパイル中は互換なので既定のものを代わりに使う)
+    PipelineLibrary::Handle object3d = pipelineLibrary->Request(MakeObject3dPipelineDesc());
+    for (uint32_t features : EnumerateShaderPermutations(GetObject3dPermutationSet())) {
+        if (features != Object3dFeature::kDefault) {
+            pipelineLibrary->Request(MakeObject3dPipelineDesc(features), object3d);
+        }
+    }
+    pipelineLibrary->Request(MakeObjPipelineDesc());
+    pipelineLibrary->Request(MakeTerrainPipelineDesc());
+    pipelineLibrary->Request(MakeSkyPipelineDesc());
+    pipelineLibrary->Request(MakeSpritePipelineDesc(false));
+    pipelineLibrary->Request(MakeSpritePipelineDesc(true));
+    pipelineLibrary->Request(MakePrimitivePipelineDesc());
+    pipelineLibrary->Request(MakePrimitivePipelineDesc(DepthMode::kReadOnly));
+    pipelineLibrary->Request(MakePrimitivePipelineDesc(DepthMode::kNone));
+    pipelineLibrary->Request(MakeShapePipelineDesc(false));
+    pipelineLibrary->Request(MakeShapePipelineDesc(true));
+    pipelineLibrary->Request(MakeShapePipelineDesc(false, TopologyType::kLine));
+    pipelineLibrary->Request(MakeShapePipelineDesc(true, TopologyType::kLine));
+}
@@ -0,0 +1,36 @@
+#pragma once
+#include "PipelineDesc.h"
+#include "PipelineLibrary.h"
+#include "ShaderPermutation.h"
+
+// Resources/shaders のシェーダーを使うパイプラインの記述
+// 同じ記述を要求すれば PipelineLibrary から同じハンドルが返るので、使う側はこれを Request すればよい
+// ルートパラメータは Request のときにシェーダーのリフレクションで作るので、番号は PipelineLibrary::GetRootParameterIndex で名前から引くこと
+// (32バイト以下の定数バッファはルート定数になる)
+
+// Object3d (GraphicsPipelineと同じ構成)
+// features はピクセルシェーダーの機能 (Object3dFeature の組み合わせ)。組み合わせごとに別のパイプラインになる
+// ルートシグネチャは全ての組み合わせで同じなので、互いにフォールバックにできる
+PipelineDesc MakeObject3dPipelineDesc(uint32_t features = Object3dFeature::kDefault);
+
+// Obj (ライトグループ付きのモデル)
+PipelineDesc MakeObjPipelineDesc();
+
+// 地形
+PipelineDesc MakeTerrainPipelineDesc();
+
+// 空 (不透明なものを全て描いた後に、深度を書かずに最も奥に描く)
+PipelineDesc MakeSkyPipelineDesc();
+
+// スプライト (srgbOutput はsRGBでないレンダーターゲットにガンマをかけて書く)
+PipelineDesc MakeSpritePipelineDesc(bool srgbOutput = false);
+
+// 3Dの線分 (頂点カラーは R8G8B8A8_UNORM)
+// 常に手前に出すときは DepthMode::kNone にする
+PipelineDesc MakePrimitivePipelineDesc(DepthMode depthMode = DepthMode::kReadWrite);
+
+// 2Dの図形 (頂点カラーは R8G8B8A8_UNORM)
+PipelineDesc MakeShapePipelineDesc(bool srgbOutput = false, TopologyType topologyType = TopologyType::kTriangle);
+
+// 全てのプリセットをバックグラウンドでコンパイルしておく
+void RequestPresetPipelines(PipelineLibrary* pipelineLibrary);
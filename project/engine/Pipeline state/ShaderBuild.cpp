@@ -0,0 +1,130 @@
+#include "ShaderBuild.h"
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include "ShaderCache.h"
+
+namespace {
+
+bool EndsWith(const std::string& text, const std::string& suffix) {
+    return text.size() >= suffix.size() && text.compare(text.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+std::string ToLowerPath(const std::filesystem::path& path) {
+    std::string text = path.lexically_normal().generic_string();
+    for (char& c : text) {
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    return text;
+}
+
+} // namespace
+
+std::wstring GetShaderProfileFromFileName(const std::filesystem::path& filePath) {
+    std::string stem = filePath.stem().string();
+    for (char& c : stem) {
+        c = static_cast<char>(toupper(static_cast<unsigned char>(c)));
+    }
+    struct Rule {
+        const char* suffix;
+        const wchar_t* profile;
+    };
+    static const Rule kRules[] = {
+        { "VS", L"vs_6_0" },
+        { "PS", L"ps_6_0" },
+        { "GS", L"gs_6_0" },
+        { "HS", L"hs_6_0" },
+        { "DS", L"ds_6_0" },
+        { "CS", L"cs_6_0" },
+    };
+    for (const Rule& rule : kRules) {
+        if (EndsWith(stem, rule.suffix)) {
+            return rule.profile;
+        }
+    }
+    return {};
+}
+
+std::wstring GetShaderEntryPointName(const ShaderEntryPoint& entryPoint) {
+    std::wstring name = entryPoint.filePath + L" (" + entryPoint.profile + L")";
+    if (!entryPoint.defines.empty()) {
+        name += L" [";
+        for (size_t i = 0; i < entryPoint.defines.size(); ++i) {
+            name += (i == 0 ? L"" : L" ") + entryPoint.defines[i];
+        }
+        name += L"]";
+    }
+    return name;
+}
+
+void ShaderBuildGraph::Scan(const std::filesystem::path& directory) {
+    entryPoints_.clear();
+    dependencies_.clear();
+
+    std::vector<std::filesystem::path> files;
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(directory, ec)) {
+        if (entry.is_regular_file(ec) && entry.path().extension() == ".hlsl") {
+            files.push_back(entry.path().lexically_normal());
+        }
+    }
+    // 実行ごとに順番が変わらないようにする
+    std::sort(files.begin(), files.end());
+
+    for (const std::filesystem::path& file : files) {
+        std::wstring profile = GetShaderProfileFromFileName(file);
+        if (profile.empty()) {
+            continue;
+        }
+        ShaderEntryPoint entryPoint;
+        entryPoint.filePath = file.generic_wstring();
+        entryPoint.profile = profile;
+        entryPoints_.push_back(entryPoint);
+        dependencies_.emplace_back();
+        UpdateDependencies(entryPoints_.size() - 1);
+    }
+}
+
+void ShaderBuildGraph::UpdateDependencies(size_t index) {
+    HashShaderSource(entryPoints_[index].filePath, &dependencies_[index]);
+}
+
+std::vector<size_t> ShaderBuildGraph::FindDependents(const std::filesystem::path& filePath) const {
+    // 消されたファイルでも比べられるように、パスの文字列で比べる (Windowsに合わせて大文字小文字は無視する)
+    std::string target = ToLowerPath(filePath);
+    std::vector<size_t> dependents;
+    for (size_t i = 0; i < dependencies_.size(); ++i) {
+        for (const std::filesystem::path& dependency : dependencies_[i]) {
+            if (ToLowerPath(dependency) == target) {
+                dependents.push_back(i);
+                break;
+            }
+        }
+    }
+    return dependents;
+}
+
+void RunShaderBuild(size_t itemCount, uint32_t threadCount,
+    const std::function<std::function<void(size_t index)>()>& createWorker) {
+    if (threadCount == 0) {
+        threadCount = std::max(std::thread::hardware_concurrency(), 1u);
+    }
+    threadCount = static_cast<uint32_t>(std::min<size_t>(threadCount, std::max<size_t>(itemCount, 1)));
+
+    // 次に処理する番号を取り合う
+    std::atomic<size_t> nextIndex = 0;
+    auto threadMain = [&] {
+        std::function<void(size_t)> worker = createWorker();
+        for (size_t index = nextIndex++; index < itemCount; index = nextIndex++) {
+            worker(index);
+        }
+    };
+    std::vector<std::thread> threads;
+    for (uint32_t i = 1; i < threadCount; ++i) {
+        threads.emplace_back(threadMain);
+    }
+    threadMain();
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+}
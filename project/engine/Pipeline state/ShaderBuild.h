@@ -0,0 +1,51 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <string>
+#include <vector>
+
+// シェーダーのビルドグラフ
+// ディレクトリ内の .hlsl をエントリポイントとして集め、それぞれがインクルードしているファイルを記録する
+// DXCやWindowsに依存しないので、オフラインのビルドツールからも使える
+
+// エントリポイント
+struct ShaderEntryPoint {
+    std::wstring filePath;
+    std::wstring profile;
+    std::wstring entryPoint = L"main";
+    std::vector<std::wstring> defines; // マクロ定義 (パーミュテーション。NAME または NAME=VALUE)
+};
+
+// ログや表に出すときの名前 (パス (プロファイル) [マクロ...])
+std::wstring GetShaderEntryPointName(const ShaderEntryPoint& entryPoint);
+
+// ファイル名からプロファイルを決める (XxxVS.hlsl / Xxx.VS.hlsl → vs_6_0 など。分からなければ空)
+std::wstring GetShaderProfileFromFileName(const std::filesystem::path& filePath);
+
+class ShaderBuildGraph {
+public:
+    // ディレクトリ内の .hlsl を集める (既に集めたものは捨てる)
+    void Scan(const std::filesystem::path& directory);
+
+    // エントリポイント
+    const std::vector<ShaderEntryPoint>& GetEntryPoints() const { return entryPoints_; }
+
+    // エントリポイントが依存するファイル (自身とインクルードしているファイル)
+    const std::vector<std::filesystem::path>& GetDependencies(size_t index) const { return dependencies_[index]; }
+
+    // 依存関係を調べ直す (インクルードが増減したときなど)
+    void UpdateDependencies(size_t index);
+
+    // ファイルに依存しているエントリポイントの番号
+    std::vector<size_t> FindDependents(const std::filesystem::path& filePath) const;
+
+private:
+    std::vector<ShaderEntryPoint> entryPoints_;
+    std::vector<std::vector<std::filesystem::path>> dependencies_;
+};
+
+// itemCount 個の処理を threadCount 個のスレッドで行う (threadCount が0ならハードウェアスレッド数)
+// createWorker はスレッドごとに1回呼ばれ、そのスレッドで使う処理を返す (DXCのインスタンスをスレッドごとに持つため)
+void RunShaderBuild(size_t itemCount, uint32_t threadCount,
+    const std::function<std::function<void(size_t index)>()>& createWorker);
@@ -0,0 +1,216 @@
+#include "ShaderCache.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <set>
+
+namespace {
+
+const uint64_t kFnvOffsetBasis = 14695981039346656037ull;
+const uint64_t kFnvPrime = 1099511628211ull;
+
+void HashBytes(uint64_t& hash, const void* data, size_t size) {
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= kFnvPrime;
+    }
+}
+
+// wchar_tの大きさはWindowsとLinuxで違うので、1文字16bitとしてハッシュする
+void HashWideString(uint64_t& hash, const std::wstring& text) {
+    for (wchar_t c : text) {
+        uint16_t code = static_cast<uint16_t>(c);
+        HashBytes(hash, &code, sizeof(code));
+    }
+    // 区切り ("ab"+"c" と "a"+"bc" を区別する)
+    uint16_t separator = 0;
+    HashBytes(hash, &separator, sizeof(separator));
+}
+
+bool ReadFile(const std::filesystem::path& path, std::string& text) {
+    std::ifstream file(path, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    return true;
+}
+
+std::string ToLower(std::string text) {
+    for (char& c : text) {
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    return text;
+}
+
+// #include "..." / #include <...> の名前を取り出す
+std::vector<std::string> FindIncludes(const std::string& source) {
+    std::vector<std::string> includes;
+    size_t lineStart = 0;
+    while (lineStart < source.size()) {
+        size_t lineEnd = source.find('\n', lineStart);
+        if (lineEnd == std::string::npos) {
+            lineEnd = source.size();
+        }
+        size_t i = source.find_first_not_of(" \t", lineStart);
+        if (i < lineEnd && source[i] == '#') {
+            i = source.find_first_not_of(" \t", i + 1);
+            if (i < lineEnd && source.compare(i, 7, "include") == 0) {
+                i = source.find_first_not_of(" \t", i + 7);
+                if (i < lineEnd && (source[i] == '"' || source[i] == '<')) {
+                    char close = source[i] == '"' ? '"' : '>';
+                    size_t end = source.find(close, i + 1);
+                    if (end < lineEnd) {
+                        includes.push_back(source.substr(i + 1, end - i - 1));
+                    }
+                }
+            }
+        }
+        lineStart = lineEnd + 1;
+    }
+    return includes;
+}
+
+// ソースとインクルードを深さ優先でハッシュに加える (同じファイルは1度だけ)
+void HashSourceRecursive(uint64_t& hash, const std::filesystem::path& path, const std::string& source,
+    const std::filesystem::path& rootDirectory, std::set<std::string>& visited,
+    std::vector<std::filesystem::path>* dependencies) {
+    HashBytes(hash, source.data(), source.size());
+    for (const std::string& name : FindIncludes(source)) {
+        std::filesystem::path includePath = ResolveShaderInclude(name, path.parent_path(), rootDirectory);
+        if (includePath.empty()) {
+            // 見つからなければ名前だけ含める (コンパイル時にエラーになる)
+            HashBytes(hash, name.data(), name.size());
+            continue;
+        }
+        if (!visited.insert(ToLower(includePath.generic_string())).second) {
+            continue;
+        }
+        std::string includeSource;
+        if (!ReadFile(includePath, includeSource)) {
+            continue;
+        }
+        if (dependencies) {
+            dependencies->push_back(includePath);
+        }
+        HashSourceRecursive(hash, includePath, includeSource, rootDirectory, visited, dependencies);
+    }
+}
+
+} // namespace
+
+std::filesystem::path ResolveShaderInclude(const std::string& name, const std::filesystem::path& includerDirectory,
+    const std::filesystem::path& rootDirectory) {
+    std::error_code ec;
+    for (const std::filesystem::path& directory : { includerDirectory, rootDirectory }) {
+        std::filesystem::path candidate = (directory / name).lexically_normal();
+        if (std::filesystem::is_regular_file(candidate, ec)) {
+            return candidate;
+        }
+        std::filesystem::path parent = candidate.parent_path();
+        std::string lowerName = ToLower(candidate.filename().string());
+        for (const auto& entry : std::filesystem::directory_iterator(parent.empty() ? "." : parent, ec)) {
+            if (entry.is_regular_file(ec) && ToLower(entry.path().filename().string()) == lowerName) {
+                return entry.path().lexically_normal();
+            }
+        }
+    }
+    return {};
+}
+
+std::vector<std::wstring> MakeShaderCompileOptions(const std::wstring& profile, const std::wstring& entryPoint, bool debug,
+    const std::vector<std::wstring>& defines) {
+    std::vector<std::wstring> options = { L"-E", entryPoint, L"-T", profile };
+    for (const std::wstring& define : defines) {
+        options.insert(options.end(), { L"-D", define });
+    }
+    if (debug) {
+        options.insert(options.end(), { L"-Zi", L"-Qembed_debug", L"-Od" });
+    } else {
+        options.push_back(L"-O3");
+    }
+    options.push_back(L"-Zpr");
+    return options;
+}
+
+uint64_t HashShaderSource(const std::filesystem::path& sourcePath, std::vector<std::filesystem::path>* dependencies) {
+    std::string source;
+    if (!ReadFile(sourcePath, source)) {
+        return 0;
+    }
+    std::filesystem::path normalPath = sourcePath.lexically_normal();
+    std::set<std::string> visited = { ToLower(normalPath.generic_string()) };
+    if (dependencies) {
+        dependencies->clear();
+        dependencies->push_back(normalPath);
+    }
+    uint64_t hash = kFnvOffsetBasis;
+    HashSourceRecursive(hash, normalPath, source, normalPath.parent_path(), visited, dependencies);
+    return hash;
+}
+
+uint64_t MakeShaderCacheKey(uint64_t sourceHash, const std::wstring& profile, const std::wstring& entryPoint,
+    const std::vector<std::wstring>& arguments, const std::string& compilerVersion) {
+    uint64_t hash = kFnvOffsetBasis;
+    uint32_t version = kShaderCacheVersion;
+    HashBytes(hash, &version, sizeof(version));
+    HashBytes(hash, &sourceHash, sizeof(sourceHash));
+    HashWideString(hash, profile);
+    HashWideString(hash, entryPoint);
+    for (const std::wstring& argument : arguments) {
+        HashWideString(hash, argument);
+    }
+    HashBytes(hash, compilerVersion.data(), compilerVersion.size());
+    return hash;
+}
+
+std::filesystem::path GetShaderCachePath(const std::filesystem::path& sourcePath, const std::wstring& profile, uint64_t key) {
+    char keyText[17] = {};
+    std::snprintf(keyText, sizeof(keyText), "%016llx", static_cast<unsigned long long>(key));
+    std::string profileText;
+    for (wchar_t c : profile) {
+        profileText += static_cast<char>(c);
+    }
+    return std::filesystem::path(kShaderCacheDirectory) / (sourcePath.filename().string() + "_" + profileText + "_" + keyText + ".dxil");
+}
+
+bool LoadShaderCache(const std::filesystem::path& cachePath, std::vector<uint8_t>& blob) {
+    std::ifstream file(cachePath, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+    blob.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+    // DXILコンテナは"DXBC"で始まる (書き込み途中で落ちたファイルなどを弾く)
+    if (blob.size() < 4 || std::memcmp(blob.data(), "DXBC", 4) != 0) {
+        blob.clear();
+        return false;
+    }
+    return true;
+}
+
+bool SaveShaderCache(const std::filesystem::path& cachePath, const void* data, size_t size) {
+    std::error_code ec;
+    std::filesystem::path directory = cachePath.parent_path();
+    std::filesystem::create_directories(directory, ec);
+
+    // 一時ファイルに書いてから置き換える
+    std::filesystem::path temporaryPath = cachePath;
+    temporaryPath += ".tmp";
+    {
+        std::ofstream file(temporaryPath, std::ios::binary | std::ios::trunc);
+        if (!file.is_open()) {
+            return false;
+        }
+        file.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+        if (!file) {
+            return false;
+        }
+    }
+    std::filesystem::rename(temporaryPath, cachePath, ec);
+    if (ec) {
+        std::filesystem::remove(temporaryPath, ec);
+        return false;
+    }
+    return true;
+}
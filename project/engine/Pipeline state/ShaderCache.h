@@ -0,0 +1,52 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+// コンパイル済みシェーダー(DXIL)のディスクキャッシュ
+// キーは「ソースとインクルードするファイル全ての内容 + プロファイル + エントリポイント + コンパイル引数 + コンパイラの版」のハッシュ
+// hlsliを書き換えた場合や、Debug/Releaseで引数が変わった場合、DXCを更新した場合も別のキーになる
+// DXCやWindowsに依存しないので、単体で動かして確認できる
+
+// キャッシュの出力先
+inline constexpr const char* kShaderCacheDirectory = "Resources/cooked/shaders";
+// キャッシュの形式や処理内容を変えたら上げる (全てのキャッシュが無効になる)
+inline constexpr uint32_t kShaderCacheVersion = 1;
+
+// Debugビルドか (コンパイル引数が変わる)
+#ifdef _DEBUG
+inline constexpr bool kShaderDebugBuild = true;
+#else
+inline constexpr bool kShaderDebugBuild = false;
+#endif
+
+// コンパイル引数 (ソースのパスは含まない。Debugでは最適化なし・デバッグ情報付き、それ以外は-O3)
+// defines はマクロ定義 (NAME または NAME=VALUE)。パーミュテーションごとに別のキーになる
+std::vector<std::wstring> MakeShaderCompileOptions(const std::wstring& profile, const std::wstring& entryPoint,
+    bool debug = kShaderDebugBuild, const std::vector<std::wstring>& defines = {});
+
+// インクルードファイルを探す (インクルード元のディレクトリ → ルートのソースのディレクトリ。見つからなければ空)
+// Windowsと同じ結果になるように、見つからなければ大文字小文字を無視して探す
+std::filesystem::path ResolveShaderInclude(const std::string& name, const std::filesystem::path& includerDirectory,
+    const std::filesystem::path& rootDirectory);
+
+// ソースと、そこからインクルードされるファイル全ての内容のハッシュ (FNV-1a)
+// dependencies を渡すと、ハッシュに含めたファイルの一覧が入る (見つからないインクルードは含まない)
+// ソースが読めなければ0を返す
+uint64_t HashShaderSource(const std::filesystem::path& sourcePath, std::vector<std::filesystem::path>* dependencies = nullptr);
+
+// キャッシュのキー (arguments にはソースのパスを含めない。パスの書き方でキーが変わらないように)
+// compilerVersion は dxcompiler と dxil の版 (同じ引数でも版が違えば出力が変わる)
+uint64_t MakeShaderCacheKey(uint64_t sourceHash, const std::wstring& profile, const std::wstring& entryPoint,
+    const std::vector<std::wstring>& arguments, const std::string& compilerVersion);
+
+// キャッシュファイルのパス (<出力先>/<ソース名>_<プロファイル>_<キー>.dxil)
+std::filesystem::path GetShaderCachePath(const std::filesystem::path& sourcePath, const std::wstring& profile, uint64_t key);
+
+// キャッシュの読み込み (無いか壊れていればfalse)
+bool LoadShaderCache(const std::filesystem::path& cachePath, std::vector<uint8_t>& blob);
+
+// キャッシュの保存
+// Debug/Releaseを切り替えても再コンパイルしないように、キーの違う古いキャッシュは消さない
+bool SaveShaderCache(const std::filesystem::path& cachePath, const void* data, size_t size);
@@ -0,0 +1,126 @@
+#include "ShaderCompiler.h"
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+// IDxcVersionInfo の版 ("1.7.4007 (commit)")。取れなければ "unknown"
+std::string GetVersionText(IUnknown* component) {
+    Microsoft::WRL::ComPtr<IDxcVersionInfo> versionInfo;
+    if (component == nullptr || FAILED(component->QueryInterface(IID_PPV_ARGS(&versionInfo)))) {
+        return "unknown";
+    }
+    UINT32 major = 0;
+    UINT32 minor = 0;
+    versionInfo->GetVersion(&major, &minor);
+    char text[64] = {};
+    std::snprintf(text, sizeof(text), "%u.%u", major, minor);
+    std::string version = text;
+    Microsoft::WRL::ComPtr<IDxcVersionInfo2> versionInfo2;
+    if (SUCCEEDED(versionInfo.As(&versionInfo2))) {
+        UINT32 commitCount = 0;
+        char* commitHash = nullptr;
+        if (SUCCEEDED(versionInfo2->GetCommitInfo(&commitCount, &commitHash))) {
+            std::snprintf(text, sizeof(text), ".%u (%s)", commitCount, commitHash != nullptr ? commitHash : "");
+            version += text;
+            CoTaskMemFree(commitHash);
+        }
+    }
+    return version;
+}
+
+} // namespace
+
+std::string GetDxcCompilerVersion(IDxcCompiler3* dxcCompiler) {
+    // 署名するバリデーター (dxil.dll) の版も出力に影響する
+    Microsoft::WRL::ComPtr<IDxcValidator> validator;
+    DxcCreateInstance(CLSID_DxcValidator, IID_PPV_ARGS(&validator));
+    return "dxcompiler " + GetVersionText(dxcCompiler) + " dxil " + GetVersionText(validator.Get());
+}
+
+bool CompileShaderCached(const std::wstring& filePath, const std::wstring& profile, const std::wstring& entryPoint,
+    IDxcUtils* dxcUtils, IDxcCompiler3* dxcCompiler, IDxcIncludeHandler* includeHandler, const std::string& compilerVersion,
+    ShaderCompileResult& result, bool debug, const std::vector<std::wstring>& defines) {
+    result = {};
+    auto start = std::chrono::steady_clock::now();
+    std::vector<std::wstring> options = MakeShaderCompileOptions(profile, entryPoint, debug, defines);
+
+    // キャッシュがあればDXCを通さない
+    uint64_t sourceHash = HashShaderSource(filePath);
+    if (sourceHash == 0) {
+        result.errors = "Failed to read shader source";
+        return false;
+    }
+    result.cacheKey = MakeShaderCacheKey(sourceHash, profile, entryPoint, options, compilerVersion);
+    std::filesystem::path cachePath = GetShaderCachePath(filePath, profile, result.cacheKey);
+    std::vector<uint8_t> cachedBlob;
+    if (LoadShaderCache(cachePath, cachedBlob)) {
+        Microsoft::WRL::ComPtr<IDxcBlobEncoding> blob = nullptr;
+        HRESULT hr = dxcUtils->CreateBlob(cachedBlob.data(), static_cast<UINT32>(cachedBlob.size()), DXC_CP_ACP, &blob);
+        if (SUCCEEDED(hr)) {
+            result.blob = blob;
+            result.cacheHit = true;
+            result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            return true;
+        }
+    }
+
+    Microsoft::WRL::ComPtr<IDxcBlobEncoding> shaderSource = nullptr;
+    HRESULT hr = dxcUtils->LoadFile(filePath.c_str(), nullptr, &shaderSource);
+    if (FAILED(hr)) {
+        result.errors = "Failed to load shader source";
+        return false;
+    }
+    DxcBuffer shaderSourceBuffer;
+    shaderSourceBuffer.Ptr = shaderSource->GetBufferPointer();
+    shaderSourceBuffer.Size = shaderSource->GetBufferSize();
+    shaderSourceBuffer.Encoding = DXC_CP_UTF8;
+
+    std::vector<LPCWSTR> arguments = { filePath.c_str() };
+    for (const std::wstring& option : options) {
+        arguments.push_back(option.c_str());
+    }
+
+    Microsoft::WRL::ComPtr<IDxcResult> shaderResult = nullptr;
+    hr = dxcCompiler->Compile(&shaderSourceBuffer, arguments.data(), static_cast<UINT32>(arguments.size()), includeHandler, IID_PPV_ARGS(&shaderResult));
+    if (FAILED(hr)) {
+        result.errors = "DXC Compile failed";
+        return false;
+    }
+
+    Microsoft::WRL::ComPtr<IDxcBlobUtf8> shaderError = nullptr;
+    shaderResult->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(&shaderError), nullptr);
+    if (shaderError != nullptr && shaderError->GetStringLength() != 0) {
+        result.errors = shaderError->GetStringPointer();
+    }
+    HRESULT status = S_OK;
+    shaderResult->GetStatus(&status);
+    if (FAILED(status)) {
+        return false;
+    }
+
+    hr = shaderResult->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(&result.blob), nullptr);
+    if (FAILED(hr) || result.blob == nullptr) {
+        return false;
+    }
+    SaveShaderCache(cachePath, result.blob->GetBufferPointer(), result.blob->GetBufferSize());
+    result.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    return true;
+}
+
+ShaderCompiler::ShaderCompiler() {
+    HRESULT hr = DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(&dxcUtils_));
+    assert(SUCCEEDED(hr));
+    hr = DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(&dxcCompiler_));
+    assert(SUCCEEDED(hr));
+    hr = dxcUtils_->CreateDefaultIncludeHandler(&includeHandler_);
+    assert(SUCCEEDED(hr));
+    compilerVersion_ = GetDxcCompilerVersion(dxcCompiler_.Get());
+}
+
+bool ShaderCompiler::Compile(const std::wstring& filePath, const std::wstring& profile, const std::wstring& entryPoint,
+    ShaderCompileResult& result, bool debug, const std::vector<std::wstring>& defines) {
+    return CompileShaderCached(filePath, profile, entryPoint, dxcUtils_.Get(), dxcCompiler_.Get(), includeHandler_.Get(),
+        compilerVersion_, result, debug, defines);
+}
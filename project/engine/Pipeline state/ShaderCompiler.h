@@ -0,0 +1,47 @@
+#pragma once
+#include <dxcapi.h>
+#include <wrl.h>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ShaderCache.h"
+
+// DXCによるシェーダーコンパイル (ディスクキャッシュ付き)
+// DXCのインスタンスはスレッド間で共有できないので、スレッドごとにShaderCompilerを1つ作る
+
+// コンパイル結果
+struct ShaderCompileResult {
+    Microsoft::WRL::ComPtr<IDxcBlob> blob;
+    uint64_t cacheKey = 0;        // ディスクキャッシュのキー (バイトコードが変われば変わる)
+    bool cacheHit = false;        // キャッシュから読んだ
+    std::string errors;           // エラー・警告メッセージ
+    double milliseconds = 0.0;    // かかった時間
+};
+
+// DXCの版 ("dxcompiler 1.7.4007 (commit) dxil 1.7"。キャッシュのキーに含める)
+std::string GetDxcCompilerVersion(IDxcCompiler3* dxcCompiler);
+
+// キャッシュを使ってコンパイルする (キャッシュに無ければコンパイルして保存する)
+// compilerVersion は GetDxcCompilerVersion の値、debug はコンパイル引数の選択 (オフラインのビルドでは両方の構成分を作る)、defines はマクロ定義
+bool CompileShaderCached(const std::wstring& filePath, const std::wstring& profile, const std::wstring& entryPoint,
+    IDxcUtils* dxcUtils, IDxcCompiler3* dxcCompiler, IDxcIncludeHandler* includeHandler, const std::string& compilerVersion,
+    ShaderCompileResult& result, bool debug = kShaderDebugBuild, const std::vector<std::wstring>& defines = {});
+
+// DXCのインスタンスを持つコンパイラ
+class ShaderCompiler {
+public:
+    ShaderCompiler();
+
+    // コンパイル (失敗したら false を返し、result.errors にメッセージが入る)
+    bool Compile(const std::wstring& filePath, const std::wstring& profile, const std::wstring& entryPoint,
+        ShaderCompileResult& result, bool debug = kShaderDebugBuild, const std::vector<std::wstring>& defines = {});
+
+    // リフレクションなどに使う
+    IDxcUtils* GetUtils() const { return dxcUtils_.Get(); }
+
+private:
+    Microsoft::WRL::ComPtr<IDxcUtils> dxcUtils_;
+    Microsoft::WRL::ComPtr<IDxcCompiler3> dxcCompiler_;
+    Microsoft::WRL::ComPtr<IDxcIncludeHandler> includeHandler_;
+    std::string compilerVersion_;
+};
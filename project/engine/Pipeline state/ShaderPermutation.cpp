@@ -0,0 +1,106 @@
+#include "ShaderPermutation.h"
+#include <cassert>
+#include <cwctype>
+#include <filesystem>
+
+namespace {
+
+// ファイル名の比較 (Windowsに合わせて大文字小文字は無視する)
+bool EqualsFileName(const std::wstring& a, const std::wstring& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); ++i) {
+        if (towlower(a[i]) != towlower(b[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+const ShaderPermutationSet& GetObject3dPermutationSet() {
+    return GetShaderPermutationSets()[0];
+}
+
+const std::vector<ShaderPermutationSet>& GetShaderPermutationSets() {
+    static const std::vector<ShaderPermutationSet> kSets = {
+        {
+            L"Object3d.PS.hlsl",
+            {
+                { Object3dFeature::kLighting, L"ENABLE_LIGHTING" },
+                { Object3dFeature::kHalfLambert, L"HALF_LAMBERT", Object3dFeature::kLighting },
+                { Object3dFeature::kTextureTransform, L"TEXTURE_TRANSFORM" },
+                { Object3dFeature::kAlphaTest, L"ALPHA_TEST" },
+            },
+        },
+    };
+    return kSets;
+}
+
+const ShaderPermutationSet* FindShaderPermutationSet(const std::wstring& filePath) {
+    std::wstring fileName = std::filesystem::path(filePath).filename().wstring();
+    for (const ShaderPermutationSet& set : GetShaderPermutationSets()) {
+        if (EqualsFileName(set.fileName, fileName)) {
+            return &set;
+        }
+    }
+    return nullptr;
+}
+
+bool IsValidShaderPermutation(const ShaderPermutationSet& set, uint32_t key) {
+    uint32_t knownBits = 0;
+    for (const ShaderFeature& feature : set.features) {
+        knownBits |= feature.bit;
+        if ((key & feature.bit) != 0 && (key & feature.requiredBits) != feature.requiredBits) {
+            return false;
+        }
+    }
+    return (key & ~knownBits) == 0;
+}
+
+std::vector<uint32_t> EnumerateShaderPermutations(const ShaderPermutationSet& set) {
+    uint32_t knownBits = 0;
+    for (const ShaderFeature& feature : set.features) {
+        knownBits |= feature.bit;
+    }
+    // knownBits の部分集合を小さい順に回る
+    std::vector<uint32_t> keys;
+    uint32_t key = 0;
+    do {
+        if (IsValidShaderPermutation(set, key)) {
+            keys.push_back(key);
+        }
+        key = (key - knownBits) & knownBits;
+    } while (key != 0);
+    return keys;
+}
+
+std::vector<std::wstring> MakeShaderPermutationDefines(const ShaderPermutationSet& set, uint32_t key) {
+    assert(IsValidShaderPermutation(set, key));
+    std::vector<std::wstring> defines;
+    for (const ShaderFeature& feature : set.features) {
+        if ((key & feature.bit) != 0) {
+            defines.push_back(std::wstring(feature.define) + L"=1");
+        }
+    }
+    return defines;
+}
+
+std::vector<ShaderEntryPoint> ExpandShaderPermutations(const std::vector<ShaderEntryPoint>& entryPoints) {
+    std::vector<ShaderEntryPoint> expanded;
+    for (const ShaderEntryPoint& entryPoint : entryPoints) {
+        const ShaderPermutationSet* set = FindShaderPermutationSet(entryPoint.filePath);
+        if (set == nullptr) {
+            expanded.push_back(entryPoint);
+            continue;
+        }
+        for (uint32_t key : EnumerateShaderPermutations(*set)) {
+            ShaderEntryPoint permutation = entryPoint;
+            permutation.defines = MakeShaderPermutationDefines(*set, key);
+            expanded.push_back(permutation);
+        }
+    }
+    return expanded;
+}
@@ -0,0 +1,54 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "ShaderBuild.h"
+
+// シェーダーのパーミュテーション
+// 機能ごとに1ビットを割り当て、立っているビットのマクロを定義してコンパイルする
+// 実行時の分岐の代わりに、マテリアルのビットマスク(キー)で専用のバリエーションを選ぶ
+// DXCやWindowsに依存しないので、オフラインのビルドツールからも使える
+
+// 機能 (1ビットにマクロ1つ)
+struct ShaderFeature {
+    uint32_t bit;
+    const wchar_t* define;
+    uint32_t requiredBits = 0; // このビットを立てるのに必要なビット (満たさない組み合わせはコンパイルしない)
+};
+
+// パーミュテーションを持つシェーダー
+struct ShaderPermutationSet {
+    std::wstring fileName; // シェーダーのファイル名 (ディレクトリは含まない)
+    std::vector<ShaderFeature> features;
+};
+
+// Object3d のピクセルシェーダーの機能
+namespace Object3dFeature {
+inline constexpr uint32_t kLighting = 1u << 0;         // 平行光源で陰影をつける
+inline constexpr uint32_t kHalfLambert = 1u << 1;      // ハーフランバート (kLightingが必要。無ければランバート)
+inline constexpr uint32_t kTextureTransform = 1u << 2; // uvTransformをかける
+inline constexpr uint32_t kAlphaTest = 1u << 3;        // alphaReference未満のピクセルを捨てる
+// 今までの見た目 (ハーフランバート・UV変換あり)
+inline constexpr uint32_t kDefault = kLighting | kHalfLambert | kTextureTransform;
+} // namespace Object3dFeature
+
+// Object3d.PS.hlsl のパーミュテーション
+const ShaderPermutationSet& GetObject3dPermutationSet();
+
+// 登録されている全てのパーミュテーション
+const std::vector<ShaderPermutationSet>& GetShaderPermutationSets();
+
+// シェーダーのパーミュテーション (ファイル名で探す。持たないシェーダーなら nullptr)
+const ShaderPermutationSet* FindShaderPermutationSet(const std::wstring& filePath);
+
+// 使える組み合わせか (知らないビットや、必要なビットが無いものはfalse)
+bool IsValidShaderPermutation(const ShaderPermutationSet& set, uint32_t key);
+
+// 使える組み合わせを全て列挙する (キーの小さい順)
+std::vector<uint32_t> EnumerateShaderPermutations(const ShaderPermutationSet& set);
+
+// キーに対応するマクロ定義 (NAME=1。ビットの順)
+std::vector<std::wstring> MakeShaderPermutationDefines(const ShaderPermutationSet& set, uint32_t key);
+
+// パーミュテーションを持つエントリポイントを、全ての組み合わせに展開する (持たないものはそのまま)
+std::vector<ShaderEntryPoint> ExpandShaderPermutations(const std::vector<ShaderEntryPoint>& entryPoints);
@@ -0,0 +1,682 @@
+#include "ShaderReflection.h"
+#include <algorithm>
+#include <sstream>
+#include "ShaderPermutation.h"
+#if defined(_WIN32)
+#include <d3d12shader.h>
+#include <filesystem>
+#endif
+
+namespace {
+
+const uint32_t kRegisterSize = 16;
+
+uint32_t AlignRegister(uint32_t offset) {
+    return (offset + kRegisterSize - 1) / kRegisterSize * kRegisterSize;
+}
+
+// 配列の大きさ (要素はそれぞれレジスタの先頭から置き、最後の要素の後ろの詰め物は含まない)
+uint32_t GetArraySize(uint32_t elementSize, uint32_t elementCount) {
+    return elementCount > 1 ? AlignRegister(elementSize) * (elementCount - 1) + elementSize : elementSize;
+}
+
+#if defined(_WIN32)
+// 型の大きさ (配列は最後の要素の後ろの詰め物を含まない。行列はレジスタ1つに1行 (列優先なら1列))
+uint32_t GetTypeSize(ID3D12ShaderReflectionType* type) {
+    D3D12_SHADER_TYPE_DESC desc{};
+    type->GetDesc(&desc);
+    // -enable-16bit-types は使わないので、half や min16float も4バイト
+    uint32_t scalarSize = desc.Type == D3D_SVT_DOUBLE ? 8 : 4;
+    uint32_t size = 0;
+    switch (desc.Class) {
+    case D3D_SVC_STRUCT:
+        for (UINT i = 0; i < desc.Members; ++i) {
+            ID3D12ShaderReflectionType* member = type->GetMemberTypeByIndex(i);
+            D3D12_SHADER_TYPE_DESC memberDesc{};
+            member->GetDesc(&memberDesc);
+            uint32_t end = memberDesc.Offset + GetTypeSize(member);
+            size = end > size ? end : size;
+        }
+        break;
+    case D3D_SVC_MATRIX_ROWS:
+        size = (desc.Rows - 1) * kRegisterSize + desc.Columns * scalarSize;
+        break;
+    case D3D_SVC_MATRIX_COLUMNS:
+        size = (desc.Columns - 1) * kRegisterSize + desc.Rows * scalarSize;
+        break;
+    default:
+        size = desc.Rows * desc.Columns * scalarSize;
+        break;
+    }
+    return GetArraySize(size, desc.Elements);
+}
+
+// 構造体のレイアウト (メンバーの構造体も reflection.structs に加える)
+ShaderStructLayout MakeStructLayout(ID3D12ShaderReflectionType* type, ShaderReflection& reflection) {
+    D3D12_SHADER_TYPE_DESC desc{};
+    type->GetDesc(&desc);
+    ShaderStructLayout layout;
+    layout.name = desc.Name != nullptr ? desc.Name : "";
+    layout.size = GetTypeSize(type);
+    for (UINT i = 0; i < desc.Members; ++i) {
+        ID3D12ShaderReflectionType* member = type->GetMemberTypeByIndex(i);
+        D3D12_SHADER_TYPE_DESC memberDesc{};
+        member->GetDesc(&memberDesc);
+        layout.fields.push_back({ type->GetMemberTypeName(i), memberDesc.Offset, GetTypeSize(member) });
+        if (memberDesc.Class == D3D_SVC_STRUCT) {
+            MakeStructLayout(member, reflection);
+        }
+    }
+    if (!layout.name.empty() && reflection.FindStruct(layout.name) == nullptr) {
+        reflection.structs.push_back(layout);
+    }
+    return layout;
+}
+
+// 定数バッファのレイアウト
+// ConstantBuffer<T> name は、name という名前の T 型の変数1つだけを持つ定数バッファになるので、T のレイアウトを返す
+ShaderStructLayout MakeConstantBufferLayout(ID3D12ShaderReflectionConstantBuffer* constantBuffer, const std::string& name,
+    ShaderReflection& reflection) {
+    D3D12_SHADER_BUFFER_DESC bufferDesc{};
+    constantBuffer->GetDesc(&bufferDesc);
+    ShaderStructLayout layout;
+    if (bufferDesc.Variables == 1) {
+        ID3D12ShaderReflectionVariable* variable = constantBuffer->GetVariableByIndex(0);
+        D3D12_SHADER_VARIABLE_DESC variableDesc{};
+        variable->GetDesc(&variableDesc);
+        D3D12_SHADER_TYPE_DESC typeDesc{};
+        variable->GetType()->GetDesc(&typeDesc);
+        if (name == variableDesc.Name && typeDesc.Class == D3D_SVC_STRUCT && typeDesc.Elements == 0) {
+            layout = MakeStructLayout(variable->GetType(), reflection);
+            layout.size = AlignRegister(bufferDesc.Size);
+            return layout;
+        }
+    }
+    // cbuffer ブロックはメンバーを直接並べる
+    layout.name = name;
+    for (UINT i = 0; i < bufferDesc.Variables; ++i) {
+        ID3D12ShaderReflectionVariable* variable = constantBuffer->GetVariableByIndex(i);
+        D3D12_SHADER_VARIABLE_DESC variableDesc{};
+        variable->GetDesc(&variableDesc);
+        layout.fields.push_back({ variableDesc.Name, variableDesc.StartOffset, GetTypeSize(variable->GetType()) });
+        D3D12_SHADER_TYPE_DESC typeDesc{};
+        variable->GetType()->GetDesc(&typeDesc);
+        if (typeDesc.Class == D3D_SVC_STRUCT) {
+            MakeStructLayout(variable->GetType(), reflection);
+        }
+    }
+    layout.size = AlignRegister(bufferDesc.Size);
+    return layout;
+}
+#endif
+
+// 逆アセンブルの定数バッファの中の構造体 (struct の行から } の行まで)
+struct DisassemblyStruct {
+    std::string typeName;
+    std::vector<ShaderConstantField> fields;
+    std::vector<std::string> fieldTypes; // fields と同じ並び (構造体のメンバーは構造体の名前)
+    std::vector<bool> fieldIsStruct;
+    std::vector<uint32_t> fieldElements; // 配列の要素数 (配列でなければ 0)
+};
+
+// 逆アセンブルの定数バッファ
+struct DisassemblyBuffer {
+    std::string name;
+    uint32_t size = 0;
+    DisassemblyStruct contents; // 定数バッファそのもの (メンバーが変数)
+};
+
+// コメント行の ';' と前後の空白を除く (コメントでなければ false)
+bool TrimCommentLine(const std::string& line, std::string& text) {
+    size_t begin = line.find_first_not_of(" \t");
+    if (begin == std::string::npos || line[begin] != ';') {
+        return false;
+    }
+    begin = line.find_first_not_of(" \t", begin + 1);
+    size_t end = line.find_last_not_of(" \t\r");
+    text = begin == std::string::npos || end < begin ? std::string() : line.substr(begin, end - begin + 1);
+    return true;
+}
+
+// "; Offset:   16 Size:    96" を読む (無ければ false)
+bool ParseOffset(const std::string& text, std::string& declaration, uint32_t& offset, uint32_t* size) {
+    size_t position = text.find("; Offset:");
+    if (position == std::string::npos || position == 0) {
+        return false;
+    }
+    declaration = text.substr(0, text.find_last_not_of(" \t", position - 1) + 1);
+    std::istringstream stream(text.substr(position + 9));
+    stream >> offset;
+    std::string sizeLabel;
+    uint32_t sizeValue = 0;
+    if (size && stream >> sizeLabel >> sizeValue && sizeLabel == "Size:") {
+        *size = sizeValue;
+    }
+    return !stream.bad();
+}
+
+// 名前と配列の要素数 ("lights[4]" → "lights", 4。多次元は掛け合わせる。配列でなければ 0)
+std::string ParseArrayName(const std::string& text, uint32_t& elementCount) {
+    size_t bracket = text.find('[');
+    elementCount = 0;
+    if (bracket == std::string::npos) {
+        return text;
+    }
+    elementCount = 1;
+    for (size_t position = bracket; position != std::string::npos; position = text.find('[', position + 1)) {
+        elementCount *= static_cast<uint32_t>(std::stoul(text.substr(position + 1)));
+    }
+    return text.substr(0, bracket);
+}
+
+// 構造体の名前 ("struct.Material", "hostlayout.struct.Material" → "Material")
+std::string StripStructPrefix(const std::string& typeName) {
+    size_t dot = typeName.rfind('.');
+    return dot == std::string::npos ? typeName : typeName.substr(dot + 1);
+}
+
+// スカラー・ベクトル・行列の大きさ (行列はレジスタ1つに1行 (列優先なら1列))
+// -enable-16bit-types は使わないので、half や min16float も4バイト
+bool GetNumericTypeSize(const std::string& typeName, bool rowMajor, uint32_t& size) {
+    static const std::pair<const char*, uint32_t> kScalars[] = {
+        { "min16float", 4 }, { "min10float", 4 }, { "min16uint", 4 }, { "min16int", 4 }, { "min12int", 4 },
+        { "uint64_t", 8 }, { "int64_t", 8 }, { "double", 8 }, { "float", 4 }, { "dword", 4 }, { "half", 4 },
+        { "bool", 4 }, { "uint", 4 }, { "int", 4 },
+    };
+    for (const auto& [name, scalarSize] : kScalars) {
+        std::string prefix = name;
+        if (typeName.compare(0, prefix.size(), prefix) != 0) {
+            continue;
+        }
+        std::string dimensions = typeName.substr(prefix.size());
+        uint32_t rows = 1;
+        uint32_t columns = 1;
+        if (dimensions.size() == 1 && dimensions[0] >= '1' && dimensions[0] <= '4') {
+            columns = dimensions[0] - '0';
+        } else if (dimensions.size() == 3 && dimensions[1] == 'x' && dimensions[0] >= '1' && dimensions[0] <= '4' &&
+                   dimensions[2] >= '1' && dimensions[2] <= '4') {
+            rows = dimensions[0] - '0';
+            columns = dimensions[2] - '0';
+            size = rowMajor ? (rows - 1) * kRegisterSize + columns * scalarSize : (columns - 1) * kRegisterSize + rows * scalarSize;
+            return true;
+        } else if (!dimensions.empty()) {
+            return false;
+        }
+        size = columns * scalarSize;
+        return true;
+    }
+    return false;
+}
+
+// 閉じた構造体の大きさを決めて、メンバーのオフセットを構造体の先頭からにする
+// (逆アセンブルのオフセットは定数バッファの先頭からなので、最初のメンバーが構造体の位置と同じになる)
+uint32_t FinishStruct(DisassemblyStruct& disassemblyStruct, uint32_t structOffset) {
+    if (!disassemblyStruct.fields.empty() && disassemblyStruct.fields.front().offset == structOffset) {
+        for (ShaderConstantField& field : disassemblyStruct.fields) {
+            field.offset -= structOffset;
+        }
+    }
+    uint32_t size = 0;
+    for (const ShaderConstantField& field : disassemblyStruct.fields) {
+        size = std::max(size, field.offset + field.size);
+    }
+    return size;
+}
+
+// 構造体のレイアウトを reflection.structs に加える (同じ名前は1つ)
+ShaderStructLayout AddStructLayout(const DisassemblyStruct& disassemblyStruct, uint32_t size, ShaderReflection& reflection) {
+    ShaderStructLayout layout;
+    layout.name = StripStructPrefix(disassemblyStruct.typeName);
+    layout.size = size;
+    layout.fields = disassemblyStruct.fields;
+    if (!layout.name.empty() && reflection.FindStruct(layout.name) == nullptr) {
+        reflection.structs.push_back(layout);
+    }
+    return layout;
+}
+
+// Buffer Definitions を読む (定数バッファのレイアウト。構造体は reflection.structs に入る)
+bool ParseBufferDefinitions(const std::vector<std::string>& lines, std::vector<DisassemblyBuffer>& buffers,
+    ShaderReflection& reflection, std::string& message) {
+    DisassemblyBuffer* buffer = nullptr;
+    std::vector<DisassemblyStruct> stack;
+    std::vector<ShaderStructLayout> layouts; // 閉じた構造体 (名前で引く)
+    for (const std::string& text : lines) {
+        if (text.rfind("cbuffer ", 0) == 0 || text.rfind("tbuffer ", 0) == 0 || text.rfind("Resource bind info for ", 0) == 0) {
+            // 定数バッファ以外 (構造化バッファなど) のレイアウトは使わないが、同じ形なので読み飛ばすために同じように読む
+            buffers.push_back({});
+            buffer = &buffers.back();
+            buffer->name = text.rfind("cbuffer ", 0) == 0 ? text.substr(8) : std::string();
+            stack.clear();
+            continue;
+        }
+        if (buffer == nullptr || text.empty() || text == "{" || text == "}") {
+            continue;
+        }
+        if (text.rfind("struct ", 0) == 0 && text.find("; Offset:") == std::string::npos) {
+            stack.push_back({});
+            stack.back().typeName = text.substr(7);
+            continue;
+        }
+        std::string declaration;
+        uint32_t offset = 0;
+        uint32_t size = 0;
+        if (!ParseOffset(text, declaration, offset, &size) || stack.empty() || declaration.empty() || declaration.back() != ';') {
+            continue;
+        }
+        declaration.pop_back();
+
+        if (declaration.rfind("} ", 0) == 0) {
+            // 構造体の終わり (外側が無ければ定数バッファそのもの)
+            DisassemblyStruct closed = std::move(stack.back());
+            stack.pop_back();
+            uint32_t elements = 0;
+            std::string name = ParseArrayName(declaration.substr(2), elements);
+            if (stack.empty()) {
+                buffer->contents = std::move(closed);
+                buffer->size = size;
+                continue;
+            }
+            uint32_t structSize = FinishStruct(closed, offset);
+            AddStructLayout(closed, structSize, reflection);
+            DisassemblyStruct& parent = stack.back();
+            parent.fields.push_back({ name, offset, GetArraySize(structSize, elements) });
+            parent.fieldTypes.push_back(StripStructPrefix(closed.typeName));
+            parent.fieldIsStruct.push_back(true);
+            parent.fieldElements.push_back(elements);
+            continue;
+        }
+
+        // スカラー・ベクトル・行列のメンバー ("row_major float4x4 WVP" など)
+        std::istringstream stream(declaration);
+        std::vector<std::string> tokens;
+        for (std::string token; stream >> token;) {
+            tokens.push_back(token);
+        }
+        if (tokens.size() < 2) {
+            message = "unexpected line in buffer definitions: " + text;
+            return false;
+        }
+        bool rowMajor = std::find(tokens.begin(), tokens.end(), "row_major") != tokens.end();
+        const std::string& typeName = tokens[tokens.size() - 2];
+        uint32_t elements = 0;
+        std::string name = ParseArrayName(tokens.back(), elements);
+        uint32_t fieldSize = 0;
+        if (!GetNumericTypeSize(typeName, rowMajor, fieldSize)) {
+            message = "unsupported type " + typeName + " in " + buffer->name;
+            return false;
+        }
+        DisassemblyStruct& parent = stack.back();
+        parent.fields.push_back({ name, offset, GetArraySize(fieldSize, elements) });
+        parent.fieldTypes.push_back(typeName);
+        parent.fieldIsStruct.push_back(false);
+        parent.fieldElements.push_back(elements);
+    }
+    return true;
+}
+
+// Resource Bindings の1行 ("gMaterial  cbuffer  NA  NA  CB0  cb0  1")
+bool ParseResourceBinding(const std::string& text, const std::vector<DisassemblyBuffer>& buffers, ShaderReflection& reflection,
+    std::string& message) {
+    std::istringstream stream(text);
+    std::string name, type, format, dimension, id, bind, count;
+    if (!(stream >> name >> type >> format >> dimension >> id >> bind >> count)) {
+        message = "unexpected line in resource bindings: " + text;
+        return false;
+    }
+    if (count != "1") {
+        message = "arrays of resources are not supported: " + name;
+        return false;
+    }
+    ShaderBinding binding;
+    binding.name = name;
+    // "cb0", "t1,space2"
+    size_t digit = bind.find_first_of("0123456789");
+    size_t space = bind.find(",space");
+    if (digit == std::string::npos) {
+        message = "unexpected register " + bind + ": " + name;
+        return false;
+    }
+    binding.shaderRegister = static_cast<uint32_t>(std::stoul(bind.substr(digit)));
+    binding.space = space != std::string::npos ? static_cast<uint32_t>(std::stoul(bind.substr(space + 6))) : 0;
+    if (type == "cbuffer") {
+        binding.type = ShaderBinding::Type::kConstantBuffer;
+        auto buffer = std::find_if(buffers.begin(), buffers.end(), [&](const DisassemblyBuffer& other) { return other.name == name; });
+        if (buffer == buffers.end()) {
+            message = "missing buffer definition: " + name;
+            return false;
+        }
+        // ConstantBuffer<T> name は、name という名前の T 型の変数1つだけを持つ定数バッファになるので、T のレイアウトを返す
+        const DisassemblyStruct& contents = buffer->contents;
+        if (contents.fields.size() == 1 && contents.fieldIsStruct[0] && contents.fieldElements[0] == 0 &&
+            contents.fields[0].name == name) {
+            const ShaderStructLayout* layout = reflection.FindStruct(contents.fieldTypes[0]);
+            if (layout != nullptr) {
+                binding.layout = *layout;
+            }
+        } else {
+            // cbuffer ブロックはメンバーを直接並べる
+            binding.layout.name = name;
+            binding.layout.fields = contents.fields;
+        }
+        binding.layout.size = AlignRegister(buffer->size);
+    } else if (type == "texture" || type == "tbuffer") {
+        binding.type = ShaderBinding::Type::kTexture;
+    } else if (type == "sampler") {
+        binding.type = ShaderBinding::Type::kSampler;
+    } else {
+        message = "unordered access views are not supported: " + name;
+        return false;
+    }
+    reflection.bindings.push_back(binding);
+    return true;
+}
+
+// ルートパラメータを作るときの1つ分
+struct RootBinding {
+    ShaderBinding::Type type;
+    std::string name;
+    uint32_t shaderRegister;
+    uint32_t size;
+    ShaderVisibility visibility;
+    uint32_t stage; // 最初に見つかったステージ (0:頂点 1:ピクセル)
+};
+
+} // namespace
+
+const ShaderStructLayout* ShaderReflection::FindStruct(const std::string& name) const {
+    for (const ShaderStructLayout& layout : structs) {
+        if (layout.name == name) {
+            return &layout;
+        }
+    }
+    return nullptr;
+}
+
+const ShaderBinding* ShaderReflection::FindBinding(const std::string& name) const {
+    for (const ShaderBinding& binding : bindings) {
+        if (binding.name == name) {
+            return &binding;
+        }
+    }
+    return nullptr;
+}
+
+#if defined(_WIN32)
+bool ReflectShader(IDxcUtils* dxcUtils, IDxcBlob* shader, ShaderReflection& reflection, std::string* error) {
+    reflection = {};
+    std::string message;
+    DxcBuffer buffer{};
+    buffer.Ptr = shader->GetBufferPointer();
+    buffer.Size = shader->GetBufferSize();
+    buffer.Encoding = DXC_CP_ACP;
+    Microsoft::WRL::ComPtr<ID3D12ShaderReflection> reflector;
+    HRESULT hr = dxcUtils->CreateReflection(&buffer, IID_PPV_ARGS(&reflector));
+    if (FAILED(hr)) {
+        message = "CreateReflection failed (reflection stripped from the shader?)";
+    } else {
+        D3D12_SHADER_DESC shaderDesc{};
+        reflector->GetDesc(&shaderDesc);
+        for (UINT i = 0; i < shaderDesc.BoundResources && message.empty(); ++i) {
+            D3D12_SHADER_INPUT_BIND_DESC bindDesc{};
+            reflector->GetResourceBindingDesc(i, &bindDesc);
+            ShaderBinding binding;
+            binding.name = bindDesc.Name;
+            binding.shaderRegister = bindDesc.BindPoint;
+            binding.space = bindDesc.Space;
+            if (bindDesc.BindCount != 1) {
+                message = "arrays of resources are not supported: " + binding.name;
+                break;
+            }
+            switch (bindDesc.Type) {
+            case D3D_SIT_CBUFFER:
+                binding.type = ShaderBinding::Type::kConstantBuffer;
+                binding.layout = MakeConstantBufferLayout(reflector->GetConstantBufferByName(bindDesc.Name), binding.name, reflection);
+                break;
+            case D3D_SIT_TBUFFER:
+            case D3D_SIT_TEXTURE:
+            case D3D_SIT_STRUCTURED:
+            case D3D_SIT_BYTEADDRESS:
+                binding.type = ShaderBinding::Type::kTexture;
+                break;
+            case D3D_SIT_SAMPLER:
+                binding.type = ShaderBinding::Type::kSampler;
+                break;
+            default:
+                message = "unordered access views are not supported: " + binding.name;
+                continue;
+            }
+            reflection.bindings.push_back(binding);
+        }
+    }
+    if (error) {
+        *error = message;
+    }
+    return message.empty();
+}
+
+bool ReflectShader(ShaderCompiler& compiler, const std::wstring& filePath, const std::wstring& profile,
+    const std::vector<std::wstring>& defines, ShaderReflection& reflection, std::string* error) {
+    ShaderCompileResult result;
+    if (!compiler.Compile(filePath, profile, L"main", result, kShaderDebugBuild, defines)) {
+        reflection = {};
+        if (error) {
+            *error = std::filesystem::path(filePath).generic_string() + ": " + result.errors;
+        }
+        return false;
+    }
+    if (!ReflectShader(compiler.GetUtils(), result.blob.Get(), reflection, error)) {
+        if (error) {
+            *error = std::filesystem::path(filePath).generic_string() + ": " + *error;
+        }
+        return false;
+    }
+    return true;
+}
+#endif
+
+bool ReflectShaderDisassembly(const std::string& disassembly, ShaderReflection& reflection, std::string* error) {
+    reflection = {};
+    std::string message;
+
+    // 先頭のコメントを節ごとに分ける (コメントでない行からはコードなので読まない)
+    enum class Section { kNone, kBuffers, kBindings };
+    Section section = Section::kNone;
+    std::vector<std::string> bufferLines;
+    std::vector<std::string> bindingLines;
+    bool foundComment = false;
+    std::istringstream stream(disassembly);
+    for (std::string line; std::getline(stream, line);) {
+        std::string text;
+        if (!TrimCommentLine(line, text)) {
+            if (foundComment && line.find_first_not_of(" \t\r") != std::string::npos) {
+                break;
+            }
+            continue;
+        }
+        foundComment = true;
+        if (text == "Buffer Definitions:") {
+            section = Section::kBuffers;
+        } else if (text == "Resource Bindings:") {
+            section = Section::kBindings;
+        } else if (!text.empty() && text.back() == ':') {
+            section = Section::kNone; // 他の節 (Input signature: など)
+        } else if (section == Section::kBuffers) {
+            bufferLines.push_back(text);
+        } else if (section == Section::kBindings && !text.empty() && text.rfind("Name ", 0) != 0 && text[0] != '-') {
+            bindingLines.push_back(text);
+        }
+    }
+
+    std::vector<DisassemblyBuffer> buffers;
+    if (!foundComment) {
+        message = "not a dxc disassembly";
+    } else if (ParseBufferDefinitions(bufferLines, buffers, reflection, message)) {
+        for (const std::string& text : bindingLines) {
+            if (!ParseResourceBinding(text, buffers, reflection, message)) {
+                break;
+            }
+        }
+    }
+    if (!message.empty()) {
+        reflection = {};
+    }
+    if (error) {
+        *error = message;
+    }
+    return message.empty();
+}
+
+bool MergeShaderReflection(ShaderReflection& merged, const ShaderReflection& other, std::string* error) {
+    std::string message;
+    for (const ShaderBinding& binding : other.bindings) {
+        auto same = std::find_if(merged.bindings.begin(), merged.bindings.end(), [&](const ShaderBinding& existing) {
+            return existing.type == binding.type && existing.shaderRegister == binding.shaderRegister && existing.space == binding.space;
+        });
+        if (same == merged.bindings.end()) {
+            merged.bindings.push_back(binding);
+        } else if (same->name != binding.name || same->layout.size != binding.layout.size) {
+            message = "permutations bind different resources to one register: " + same->name + " and " + binding.name;
+            break;
+        }
+    }
+    for (const ShaderStructLayout& layout : other.structs) {
+        if (merged.FindStruct(layout.name) == nullptr) {
+            merged.structs.push_back(layout);
+        }
+    }
+    if (error) {
+        *error = message;
+    }
+    return message.empty();
+}
+
+bool ReflectShaderPermutations(const std::wstring& filePath, const std::vector<std::wstring>& defines,
+    const ShaderReflectFunction& reflect, ShaderReflection& reflection, std::string* error) {
+    const ShaderPermutationSet* set = FindShaderPermutationSet(filePath);
+    if (set == nullptr) {
+        return reflect(defines, reflection, error);
+    }
+    reflection = {};
+    for (uint32_t key : EnumerateShaderPermutations(*set)) {
+        ShaderReflection permutation;
+        if (!reflect(MakeShaderPermutationDefines(*set, key), permutation, error) ||
+            !MergeShaderReflection(reflection, permutation, error)) {
+            reflection = {};
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MakeRootParameters(const ShaderReflection& vertex, const ShaderReflection* pixel, std::vector<RootParameter>& rootParameters,
+    bool* useSampler, std::string* error) {
+    rootParameters.clear();
+    std::string message;
+    bool sampler = false;
+
+    // 使われているバインドを集める (両方のステージで同じものは1つにまとめる)
+    std::vector<RootBinding> bindings;
+    auto collect = [&](const ShaderReflection& reflection, ShaderVisibility visibility, uint32_t stage) {
+        for (const ShaderBinding& binding : reflection.bindings) {
+            if (binding.space != 0) {
+                message = "register space is not supported: " + binding.name;
+                continue;
+            }
+            if (binding.type == ShaderBinding::Type::kSampler) {
+                // サンプラーはs0のスタティックサンプラーのみ
+                if (binding.shaderRegister != 0) {
+                    message = "only the static sampler s0 is supported: " + binding.name;
+                }
+                sampler = true;
+                continue;
+            }
+            auto same = std::find_if(bindings.begin(), bindings.end(), [&](const RootBinding& other) {
+                return other.type == binding.type && other.shaderRegister == binding.shaderRegister && other.name == binding.name;
+            });
+            if (same != bindings.end()) {
+                same->visibility = ShaderVisibility::kAll;
+                continue;
+            }
+            bindings.push_back({ binding.type, binding.name, binding.shaderRegister, binding.layout.size, visibility, stage });
+        }
+    };
+    collect(vertex, ShaderVisibility::kVertex, 0);
+    if (pixel) {
+        collect(*pixel, ShaderVisibility::kPixel, 1);
+    }
+
+    // 定数バッファ → テクスチャ、それぞれステージ順・レジスタ順 (ステージの中の順番は宣言順によらない)
+    std::stable_sort(bindings.begin(), bindings.end(), [](const RootBinding& a, const RootBinding& b) {
+        bool aTexture = a.type == ShaderBinding::Type::kTexture;
+        bool bTexture = b.type == ShaderBinding::Type::kTexture;
+        if (aTexture != bTexture) {
+            return bTexture;
+        }
+        if (a.stage != b.stage) {
+            return a.stage < b.stage;
+        }
+        return a.shaderRegister < b.shaderRegister;
+    });
+
+    // 小さい定数バッファはルート定数にする (ルートシグネチャの上限を超えない範囲で)
+    uint32_t dwords = 0;
+    for (const RootBinding& binding : bindings) {
+        dwords += binding.type == ShaderBinding::Type::kTexture ? 1 : 2;
+    }
+    for (const RootBinding& binding : bindings) {
+        RootParameter parameter;
+        parameter.visibility = binding.visibility;
+        parameter.shaderRegister = binding.shaderRegister;
+        parameter.name = binding.name;
+        if (binding.type == ShaderBinding::Type::kTexture) {
+            parameter.type = RootParameterType::kSRVTable;
+        } else if (binding.size <= kMaxRootConstantBytes && dwords - 2 + binding.size / 4 <= kMaxRootSignatureDwords) {
+            parameter.type = RootParameterType::kConstants;
+            parameter.constantCount = binding.size / 4;
+            dwords = dwords - 2 + parameter.constantCount;
+        } else {
+            parameter.type = RootParameterType::kCBV;
+        }
+        rootParameters.push_back(parameter);
+    }
+    if (dwords > kMaxRootSignatureDwords) {
+        message = "root signature exceeds 64 DWORDs";
+    }
+    if (useSampler) {
+        *useSampler = sampler;
+    }
+    if (error) {
+        *error = message;
+    }
+    return message.empty();
+}
+
+bool ReflectRootParameters(PipelineDesc& desc, const ShaderStageReflectFunction& reflect, std::string* error) {
+    auto reflectStage = [&](const std::wstring& filePath, const std::wstring& profile, const std::vector<std::wstring>& defines,
+                            ShaderReflection& reflection) {
+        return ReflectShaderPermutations(filePath, defines,
+            [&](const std::vector<std::wstring>& permutation, ShaderReflection& result, std::string* message) {
+                return reflect(filePath, profile, permutation, result, message);
+            },
+            reflection, error);
+    };
+    ShaderReflection vertex;
+    ShaderReflection pixel;
+    if (!reflectStage(desc.vertexShader, desc.vertexProfile, desc.vertexDefines, vertex)) {
+        return false;
+    }
+    if (!desc.pixelShader.empty() && !reflectStage(desc.pixelShader, desc.pixelProfile, desc.pixelDefines, pixel)) {
+        return false;
+    }
+    return MakeRootParameters(vertex, desc.pixelShader.empty() ? nullptr : &pixel, desc.rootParameters, &desc.linearWrapSampler, error);
+}
+
+uint32_t FindRootParameter(const std::vector<RootParameter>& rootParameters, const std::string& name) {
+    for (size_t i = 0; i < rootParameters.size(); ++i) {
+        if (rootParameters[i].name == name) {
+            return static_cast<uint32_t>(i);
+        }
+    }
+    return UINT32_MAX;
+}
@@ -0,0 +1,104 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "PipelineDesc.h"
+#if defined(_WIN32)
+#include "ShaderCompiler.h"
+#endif
+
+// シェーダーのリフレクション (リソースのバインドと定数バッファのレイアウト)
+// DXCでコンパイルしたDXILから IDxcUtils::CreateReflection で取る (オフセットはコンパイラが決めたものそのまま)
+// dxcompiler を使わない環境 (Linuxのビルドステップ) では、dxc コマンドの逆アセンブルの先頭にある同じ情報を読む
+// ルートパラメータを決める MakeRootParameters はDXCやWindowsに依存しない
+
+// 定数バッファのメンバー
+struct ShaderConstantField {
+    std::string name;
+    uint32_t offset = 0; // バイト
+    uint32_t size = 0;   // バイト (配列は最後の要素の後ろの詰め物を含まない)
+};
+
+// 構造体・定数バッファのレイアウト
+struct ShaderStructLayout {
+    std::string name;
+    uint32_t size = 0; // 最後のメンバーの終わり (定数バッファとして使うときは16バイト単位に切り上げる)
+    std::vector<ShaderConstantField> fields;
+};
+
+// リソースのバインド
+struct ShaderBinding {
+    enum class Type {
+        kConstantBuffer,
+        kTexture,
+        kSampler,
+    };
+    Type type = Type::kConstantBuffer;
+    std::string name;            // 変数名 (cbuffer ブロックはブロックの名前)
+    uint32_t shaderRegister = 0;
+    uint32_t space = 0;
+    ShaderStructLayout layout;   // 定数バッファのレイアウト (size は16バイト単位)
+};
+
+// シェーダー1つ分のリフレクション
+// bindings はDXILに残ったもの (参照されていないものはコンパイラが取り除く)、structs は定数バッファに使われている構造体
+struct ShaderReflection {
+    std::vector<ShaderBinding> bindings;
+    std::vector<ShaderStructLayout> structs;
+
+    const ShaderStructLayout* FindStruct(const std::string& name) const;
+    const ShaderBinding* FindBinding(const std::string& name) const;
+};
+
+// これ以下の大きさの定数バッファはルート定数にする (描画ごとに変わる小さなデータをCBVなしで渡す)
+inline constexpr uint32_t kMaxRootConstantBytes = 32;
+// ルートシグネチャの大きさの上限 (DWORD)
+inline constexpr uint32_t kMaxRootSignatureDwords = 64;
+
+#if defined(_WIN32)
+// コンパイル済みのシェーダー (DXIL) からリフレクションする (失敗したら false を返し、error に理由が入る)
+bool ReflectShader(IDxcUtils* dxcUtils, IDxcBlob* shader, ShaderReflection& reflection, std::string* error = nullptr);
+
+// シェーダーをコンパイルして (キャッシュがあればそれを使う) リフレクションする
+// 描画に使うものと同じ引数でコンパイルするので、バインドはパイプラインのシェーダーと一致する
+bool ReflectShader(ShaderCompiler& compiler, const std::wstring& filePath, const std::wstring& profile,
+    const std::vector<std::wstring>& defines, ShaderReflection& reflection, std::string* error = nullptr);
+#endif
+
+// dxc コマンドの逆アセンブル (-Fc の出力) からリフレクションする (失敗したら false を返し、error に理由が入る)
+// 先頭のコメントの Buffer Definitions (定数バッファのオフセット) と Resource Bindings (バインド) を読む
+// メンバーの大きさは型の名前から求める (オフセットはコンパイラが出したもの)
+bool ReflectShaderDisassembly(const std::string& disassembly, ShaderReflection& reflection, std::string* error = nullptr);
+
+// 同じシェーダーの別のパーミュテーションのリフレクションを merged に合わせる (どちらかにあるバインドを全て持つ)
+// 同じレジスタに別のもの (名前や種類が違うもの) があれば false
+bool MergeShaderReflection(ShaderReflection& merged, const ShaderReflection& other, std::string* error = nullptr);
+
+// マクロ定義を1組受け取ってリフレクションする関数
+using ShaderReflectFunction =
+    std::function<bool(const std::vector<std::wstring>& defines, ShaderReflection& reflection, std::string* error)>;
+
+// パーミュテーションを持つシェーダー (ファイル名で決まる) は、全ての組み合わせを合わせたリフレクションにする (defines によらず同じ結果)
+// 持たないシェーダーは defines のものをそのまま返す
+// コンパイラは参照されないバインドを取り除くので、組み合わせごとに作るとルートシグネチャが食い違い、互いにフォールバックにできない
+bool ReflectShaderPermutations(const std::wstring& filePath, const std::vector<std::wstring>& defines,
+    const ShaderReflectFunction& reflect, ShaderReflection& reflection, std::string* error = nullptr);
+
+// 頂点シェーダーとピクセルシェーダー(省略可)のリフレクションからルートパラメータを作る
+// 並びは 定数バッファ(頂点→ピクセルの順、それぞれレジスタ順) → テクスチャ。両方で同じものは kAll にまとめる
+// useSampler にはサンプラー(s0)を使うかが入る。扱えないバインドがあれば false
+bool MakeRootParameters(const ShaderReflection& vertex, const ShaderReflection* pixel, std::vector<RootParameter>& rootParameters,
+    bool* useSampler, std::string* error = nullptr);
+
+// シェーダーを1つ (ファイル・プロファイル・マクロ定義) リフレクションする関数
+using ShaderStageReflectFunction = std::function<bool(const std::wstring& filePath, const std::wstring& profile,
+    const std::vector<std::wstring>& defines, ShaderReflection& reflection, std::string* error)>;
+
+// desc のシェーダーからルートパラメータとサンプラーの有無を決める (手で並べる代わりに使う)
+// パーミュテーションを持つシェーダーは全ての組み合わせで同じルートパラメータになる
+// シェーダーのコンパイルは reflect に任せる (PipelineLibrary はワーカーでコンパイルしたものを渡す)
+bool ReflectRootParameters(PipelineDesc& desc, const ShaderStageReflectFunction& reflect, std::string* error = nullptr);
+
+// ルートパラメータの番号 (名前で探す。見つからなければ UINT32_MAX)
+uint32_t FindRootParameter(const std::vector<RootParameter>& rootParameters, const std::string& name);
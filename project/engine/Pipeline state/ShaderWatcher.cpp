@@ -0,0 +1,201 @@
+#include "ShaderWatcher.h"
+#include <algorithm>
+#include <set>
+#if defined(_WIN32)
+#include <Windows.h>
+#elif defined(__linux__)
+#include <sys/inotify.h>
+#include <unistd.h>
+#endif
+
+ShaderWatcher::~ShaderWatcher() {
+    Finalize();
+}
+
+void ShaderWatcher::Initialize(ShaderBuildGraph* graph, std::chrono::milliseconds debounce, bool polling) {
+    Finalize();
+    graph_ = graph;
+    debounce_ = debounce;
+    polling_ = polling;
+#if defined(__linux__)
+    if (!polling_) {
+        inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    }
+#endif
+
+    // 依存ファイルがあるディレクトリを全て監視する
+    std::set<std::string> directories;
+    for (size_t i = 0; i < graph_->GetEntryPoints().size(); ++i) {
+        for (const std::filesystem::path& dependency : graph_->GetDependencies(i)) {
+            std::filesystem::path directory = dependency.parent_path();
+            if (directories.insert(directory.generic_string()).second) {
+                WatchDirectory(directory);
+            }
+        }
+    }
+}
+
+void ShaderWatcher::Finalize() {
+    for (WatchedDirectory& directory : directories_) {
+#if defined(_WIN32)
+        if (directory.notification != nullptr) {
+            FindCloseChangeNotification(directory.notification);
+        }
+#elif defined(__linux__)
+        if (directory.descriptor >= 0) {
+            inotify_rm_watch(inotify_, directory.descriptor);
+        }
+#endif
+    }
+    directories_.clear();
+#if defined(__linux__)
+    if (inotify_ >= 0) {
+        close(inotify_);
+        inotify_ = -1;
+    }
+#endif
+    pendingChanges_.clear();
+    graph_ = nullptr;
+    polling_ = false;
+}
+
+bool ShaderWatcher::IsPolling() const {
+#if defined(_WIN32)
+    return polling_ || std::any_of(directories_.begin(), directories_.end(),
+        [](const WatchedDirectory& directory) { return directory.notification == nullptr; });
+#elif defined(__linux__)
+    return polling_ || inotify_ < 0;
+#else
+    return true;
+#endif
+}
+
+std::vector<size_t> ShaderWatcher::Poll(Clock::time_point now) {
+    CollectEvents(now);
+
+    // 変更が落ち着いたファイルを取り出す
+    std::vector<std::filesystem::path> settledFiles;
+    for (auto it = pendingChanges_.begin(); it != pendingChanges_.end();) {
+        if (now - it->second >= debounce_) {
+            settledFiles.push_back(it->first);
+            it = pendingChanges_.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    if (settledFiles.empty() || graph_ == nullptr) {
+        return {};
+    }
+
+    std::vector<size_t> entryPoints;
+    for (const std::filesystem::path& file : settledFiles) {
+        std::vector<size_t> dependents = graph_->FindDependents(file);
+        entryPoints.insert(entryPoints.end(), dependents.begin(), dependents.end());
+    }
+    std::sort(entryPoints.begin(), entryPoints.end());
+    entryPoints.erase(std::unique(entryPoints.begin(), entryPoints.end()), entryPoints.end());
+
+    // インクルードが増減しているかもしれないので調べ直す (新しいディレクトリが増えたら監視に加える)
+    for (size_t index : entryPoints) {
+        graph_->UpdateDependencies(index);
+        for (const std::filesystem::path& dependency : graph_->GetDependencies(index)) {
+            std::filesystem::path directory = dependency.parent_path();
+            bool watched = std::any_of(directories_.begin(), directories_.end(),
+                [&](const WatchedDirectory& watchedDirectory) { return watchedDirectory.path == directory; });
+            if (!watched) {
+                WatchDirectory(directory);
+            }
+        }
+    }
+    return entryPoints;
+}
+
+void ShaderWatcher::NotifyChanged(const std::filesystem::path& filePath, Clock::time_point now) {
+    // 続けて変更されたら待ち時間を延ばす
+    pendingChanges_[filePath.lexically_normal().generic_string()] = now;
+}
+
+void ShaderWatcher::WatchDirectory(const std::filesystem::path& directory) {
+    WatchedDirectory& watched = directories_.emplace_back();
+    watched.path = directory;
+#if defined(_WIN32)
+    if (!polling_) {
+        HANDLE notification = FindFirstChangeNotificationW(directory.c_str(), FALSE,
+            FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+        watched.notification = notification == INVALID_HANDLE_VALUE ? nullptr : notification;
+    }
+#elif defined(__linux__)
+    if (inotify_ >= 0) {
+        // エディタによっては一時ファイルに書いてから置き換えるので、移動と作成も見る
+        // 更新日時だけを変えた場合 (touch) は IN_ATTRIB か、ファイルシステムによっては IN_MODIFY になる
+        // (IN_MODIFY は書き込みのたびに来るが、落ち着くまで待つので1回にまとまる)
+        watched.descriptor = inotify_add_watch(inotify_, directory.c_str(),
+            IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ATTRIB | IN_MODIFY);
+    }
+#endif
+    ScanWriteTimes(watched, Clock::now(), false);
+}
+
+void ShaderWatcher::CollectEvents(Clock::time_point now) {
+#if defined(_WIN32)
+    for (WatchedDirectory& directory : directories_) {
+        if (directory.notification == nullptr) {
+            ScanWriteTimes(directory, now, true);
+            continue;
+        }
+        // 通知ではどのファイルかは分からないので、更新日時を比べる
+        if (WaitForSingleObject(directory.notification, 0) == WAIT_OBJECT_0) {
+            ScanWriteTimes(directory, now, true);
+            FindNextChangeNotification(directory.notification);
+        }
+    }
+#elif defined(__linux__)
+    if (inotify_ < 0) {
+        for (WatchedDirectory& directory : directories_) {
+            ScanWriteTimes(directory, now, true);
+        }
+        return;
+    }
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        ssize_t length = read(inotify_, buffer, sizeof(buffer));
+        if (length <= 0) {
+            break;
+        }
+        for (ssize_t offset = 0; offset < length;) {
+            const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+            offset += sizeof(inotify_event) + event->len;
+            if (event->len == 0) {
+                continue;
+            }
+            for (const WatchedDirectory& directory : directories_) {
+                if (directory.descriptor == event->wd) {
+                    NotifyChanged(directory.path / event->name, now);
+                    break;
+                }
+            }
+        }
+    }
+#else
+    for (WatchedDirectory& directory : directories_) {
+        ScanWriteTimes(directory, now, true);
+    }
+#endif
+}
+
+void ShaderWatcher::ScanWriteTimes(WatchedDirectory& directory, Clock::time_point now, bool notify) {
+    std::error_code ec;
+    for (const auto& entry : std::filesystem::directory_iterator(directory.path, ec)) {
+        if (!entry.is_regular_file(ec)) {
+            continue;
+        }
+        std::filesystem::file_time_type writeTime = entry.last_write_time(ec);
+        std::string name = entry.path().filename().string();
+        auto it = directory.writeTimes.find(name);
+        bool changed = it == directory.writeTimes.end() || it->second != writeTime;
+        directory.writeTimes[name] = writeTime;
+        if (notify && changed) {
+            NotifyChanged(entry.path(), now);
+        }
+    }
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ShaderBuild.h"
+
+// シェーダーファイルの変更監視 (ホットリロード用)
+// ビルドグラフの依存ファイルがあるディレクトリを監視し、変更が落ち着いたら影響するエントリポイントを返す
+// エディタは保存時に何度も書き込むことがあるので、最後の変更から debounce だけ経ってから扱う
+// Windowsは FindFirstChangeNotification、Linuxは inotify、それ以外 (または通知が使えないとき) は更新日時のポーリングで変更を拾う
+class ShaderWatcher {
+public:
+    using Clock = std::chrono::steady_clock;
+    static constexpr std::chrono::milliseconds kDefaultDebounce{ 200 };
+
+public:
+    ShaderWatcher() = default;
+    ~ShaderWatcher();
+    ShaderWatcher(const ShaderWatcher&) = delete;
+    ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+    // 監視の開始 (graph は監視中ずっと生きていること)
+    // polling が true なら OS の通知を使わず、更新日時のポーリングだけで変更を拾う
+    void Initialize(ShaderBuildGraph* graph, std::chrono::milliseconds debounce = kDefaultDebounce, bool polling = false);
+
+    // 監視の終了
+    void Finalize();
+
+    // 変更を集め、変更が落ち着いたファイルに依存するエントリポイントの番号を返す (ブロックしない)
+    // 返したエントリポイントの依存関係は調べ直してある
+    std::vector<size_t> Poll() { return Poll(Clock::now()); }
+    std::vector<size_t> Poll(Clock::time_point now);
+
+    // ファイルの変更を知らせる (監視の仕組みから呼ばれる。テストから直接呼んでもよい)
+    void NotifyChanged(const std::filesystem::path& filePath, Clock::time_point now);
+
+    // 変更が落ち着くのを待っているファイルの数
+    size_t GetPendingCount() const { return pendingChanges_.size(); }
+
+    // 更新日時のポーリングで監視しているか (指定した場合と、OS の通知が使えなかった場合)
+    bool IsPolling() const;
+
+private:
+    // 監視しているディレクトリ
+    struct WatchedDirectory {
+        std::filesystem::path path;
+#if defined(_WIN32)
+        void* notification = nullptr; // FindFirstChangeNotificationのハンドル
+#elif defined(__linux__)
+        int descriptor = -1;          // inotifyのウォッチ
+#endif
+        // ファイル名 → 更新日時 (変更の通知だけではどのファイルか分からない環境用)
+        std::unordered_map<std::string, std::filesystem::file_time_type> writeTimes;
+    };
+
+    void WatchDirectory(const std::filesystem::path& directory);
+    void CollectEvents(Clock::time_point now);
+    void ScanWriteTimes(WatchedDirectory& directory, Clock::time_point now, bool notify);
+
+private:
+    ShaderBuildGraph* graph_ = nullptr;
+    std::chrono::milliseconds debounce_ = kDefaultDebounce;
+    bool polling_ = false;
+    std::vector<WatchedDirectory> directories_;
+#if defined(__linux__)
+    int inotify_ = -1;
+#endif
+    // 変更されたファイル → 最後に変更された時刻
+    std::unordered_map<std::string, Clock::time_point> pendingChanges_;
+};
@@ -0,0 +1,435 @@
+#include "CpuProfiler.h"
+#include <algorithm>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <unordered_map>
+
+// スレッドごとの区間のリングバッファ (そのスレッドが書き、メインスレッドが EndFrame で読む)
+struct ProfileDetail::ThreadBuffer {
+    std::vector<ProfileEvent> events;
+    uint64_t mask = 0;
+    uint32_t threadIndex = 0;
+    std::atomic<const char*> name = nullptr;
+
+    // メインスレッドが進める
+    alignas(64) std::atomic<uint64_t> head = 0;
+
+    // 書くスレッドが進める
+    alignas(64) std::atomic<uint64_t> tail = 0;
+    uint64_t cachedHead = 0;
+    std::atomic<uint64_t> dropped = 0;
+    std::atomic<bool> retired = false; // スレッドが終わった (読み終えたら外す)
+};
+
+namespace {
+
+// スレッドが持つバッファ (スレッドが終わると retired にする)
+struct ThreadSlot {
+    std::shared_ptr<ProfileDetail::ThreadBuffer> buffer;
+    uint64_t generation = 0;
+
+    ~ThreadSlot() {
+        if (buffer != nullptr) {
+            buffer->retired.store(true, std::memory_order_release);
+        }
+    }
+};
+
+thread_local ThreadSlot threadSlot;
+// 呼んだスレッドで開いている区間の数
+thread_local uint32_t threadDepth = 0;
+
+// 親・スレッド・名前からノードを引く
+struct NodeKey {
+    int32_t parent;
+    uint32_t threadIndex;
+    const char* name;
+
+    bool operator==(const NodeKey& other) const {
+        return parent == other.parent && threadIndex == other.threadIndex && name == other.name;
+    }
+};
+
+struct NodeKeyHash {
+    size_t operator()(const NodeKey& key) const {
+        size_t hash = std::hash<const void*>()(key.name);
+        hash ^= (size_t(uint32_t(key.parent)) * 0x9E3779B97F4A7C15ull) + (size_t(key.threadIndex) << 7);
+        return hash;
+    }
+};
+
+std::unordered_map<NodeKey, int32_t, NodeKeyHash> nodeLookup;
+
+double ToMilliseconds(int64_t nanoseconds) {
+    return double(nanoseconds) / 1e6;
+}
+
+// JSON の文字列に入れられるようにする
+void AppendJsonString(std::string& out, const char* text) {
+    out.push_back('"');
+    for (const char* p = text; *p != '\0'; ++p) {
+        char c = *p;
+        if (c == '"' || c == '\\') {
+            out.push_back('\\');
+            out.push_back(c);
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char escaped[8];
+            std::snprintf(escaped, sizeof(escaped), "\\u%04x", static_cast<unsigned>(c));
+            out.append(escaped);
+        } else {
+            out.push_back(c);
+        }
+    }
+    out.push_back('"');
+}
+
+} // namespace
+
+CpuProfiler* CpuProfiler::GetInstance() {
+    static CpuProfiler instance;
+    return &instance;
+}
+
+void CpuProfiler::Initialize(const ProfileSettings& settings) {
+    assert(settings.threadEventCapacity > 0 && settings.aggregateFrames > 0);
+    settings_ = settings;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffers_.clear();
+        threadCount_ = 0;
+    }
+    generation_.fetch_add(1, std::memory_order_release);
+    nodes_.clear();
+    nodeLookup.clear();
+    threadNames_.clear();
+    tracks_.clear();
+    frameStats_ = {};
+    windowFrameCount_ = 0;
+    droppedCount_ = 0;
+    captureRemaining_ = 0;
+    captureReady_ = false;
+    captureFrames_.clear();
+    captureThreads_.clear();
+    captureTracks_.clear();
+    frameStart_ = Now();
+    SetEnabled(true);
+}
+
+void CpuProfiler::Finalize() {
+    SetEnabled(false);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffers_.clear();
+        threadCount_ = 0;
+    }
+    // 残っているスレッドのバッファは次に書いたときに作り直させる
+    generation_.fetch_add(1, std::memory_order_release);
+    nodes_.clear();
+    nodeLookup.clear();
+    tracks_.clear();
+    captureFrames_.clear();
+    captureThreads_.clear();
+    captureTracks_.clear();
+}
+
+void CpuProfiler::SetEnabled(bool enabled) {
+    enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+void CpuProfiler::SetThreadName(const char* name) {
+    GetThreadBuffer()->name.store(name, std::memory_order_relaxed);
+}
+
+uint32_t CpuProfiler::RegisterTrack(const char* name) {
+    uint32_t trackIndex = 0;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        trackIndex = threadCount_++;
+    }
+    tracks_.push_back({ trackIndex, name });
+    return trackIndex;
+}
+
+void CpuProfiler::SubmitTrackEvents(uint32_t trackIndex, std::vector<ProfileEvent>& events) {
+    if (captureRemaining_ > 0) {
+        if (captureThreads_.size() <= trackIndex) {
+            captureThreads_.resize(trackIndex + 1);
+        }
+        captureThreads_[trackIndex].insert(captureThreads_[trackIndex].end(), events.begin(), events.end());
+    }
+    Accumulate(trackIndex, events);
+}
+
+int64_t CpuProfiler::Now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+int64_t CpuProfiler::BeginScope() {
+    ++threadDepth;
+    return Now();
+}
+
+void CpuProfiler::EndScope(const char* name, int64_t start) {
+    int64_t end = Now();
+    --threadDepth;
+    ProfileDetail::ThreadBuffer* buffer = GetThreadBuffer();
+    uint64_t tail = buffer->tail.load(std::memory_order_relaxed);
+    if (tail - buffer->cachedHead > buffer->mask) {
+        buffer->cachedHead = buffer->head.load(std::memory_order_acquire);
+        if (tail - buffer->cachedHead > buffer->mask) {
+            buffer->dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+    }
+    ProfileEvent& event = buffer->events[tail & buffer->mask];
+    event.name = name;
+    event.start = start;
+    event.end = end;
+    event.depth = threadDepth;
+    buffer->tail.store(tail + 1, std::memory_order_release);
+}
+
+ProfileDetail::ThreadBuffer* CpuProfiler::GetThreadBuffer() {
+    uint64_t generation = generation_.load(std::memory_order_acquire);
+    if (threadSlot.generation == generation && threadSlot.buffer != nullptr) {
+        return threadSlot.buffer.get();
+    }
+    // このスレッドで初めて記録する (または Initialize し直した)
+    if (threadSlot.buffer != nullptr) {
+        threadSlot.buffer->retired.store(true, std::memory_order_release);
+    }
+    uint64_t capacity = 1;
+    while (capacity < settings_.threadEventCapacity) {
+        capacity <<= 1;
+    }
+    std::shared_ptr<ProfileDetail::ThreadBuffer> buffer = std::make_shared<ProfileDetail::ThreadBuffer>();
+    buffer->events.resize(capacity);
+    buffer->mask = capacity - 1;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffer->threadIndex = threadCount_++;
+        buffers_.push_back(buffer);
+    }
+    threadSlot.buffer = std::move(buffer);
+    threadSlot.generation = generation;
+    return threadSlot.buffer.get();
+}
+
+void CpuProfiler::BeginFrame() {
+    frameStart_ = Now();
+}
+
+void CpuProfiler::EndFrame() {
+    int64_t frameEnd = Now();
+    std::vector<std::shared_ptr<ProfileDetail::ThreadBuffer>> buffers;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffers = buffers_;
+    }
+
+    // 全てのスレッドのバッファから読めるだけ読み、スレッドごとの木に積み上げる
+    bool capturing = captureRemaining_ > 0;
+    for (const std::shared_ptr<ProfileDetail::ThreadBuffer>& buffer : buffers) {
+        uint32_t threadIndex = buffer->threadIndex;
+        if (threadNames_.size() <= threadIndex) {
+            threadNames_.resize(threadIndex + 1);
+        }
+        const char* name = buffer->name.load(std::memory_order_relaxed);
+        threadNames_[threadIndex] = name != nullptr ? name : "Thread " + std::to_string(threadIndex);
+
+        uint64_t head = buffer->head.load(std::memory_order_relaxed);
+        uint64_t tail = buffer->tail.load(std::memory_order_acquire);
+        scratch_.clear();
+        for (; head != tail; ++head) {
+            scratch_.push_back(buffer->events[head & buffer->mask]);
+        }
+        buffer->head.store(tail, std::memory_order_release);
+        droppedCount_ += buffer->dropped.exchange(0, std::memory_order_relaxed);
+        if (capturing) {
+            if (captureThreads_.size() <= threadIndex) {
+                captureThreads_.resize(threadIndex + 1);
+            }
+            captureThreads_[threadIndex].insert(captureThreads_[threadIndex].end(), scratch_.begin(), scratch_.end());
+        }
+        Accumulate(threadIndex, scratch_);
+    }
+
+    for (const std::pair<uint32_t, std::string>& track : tracks_) {
+        if (threadNames_.size() <= track.first) {
+            threadNames_.resize(track.first + 1);
+        }
+        threadNames_[track.first] = track.second;
+    }
+
+    // 終わったスレッドのバッファは読み終えたら外す (集計したノードとスレッドの名前は残す)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        buffers_.erase(std::remove_if(buffers_.begin(), buffers_.end(), [](const std::shared_ptr<ProfileDetail::ThreadBuffer>& buffer) {
+            return buffer->retired.load(std::memory_order_acquire) &&
+                buffer->head.load(std::memory_order_relaxed) == buffer->tail.load(std::memory_order_acquire);
+        }), buffers_.end());
+    }
+
+    // フレームごとの値を集計期間に足す
+    for (ProfileNode& node : nodes_) {
+        node.lastMilliseconds = node.frameMilliseconds;
+        node.lastCalls = node.frameCalls;
+        if (node.frameCalls > 0) {
+            node.windowMin = node.windowFrames == 0 ? node.frameMilliseconds : std::min(node.windowMin, node.frameMilliseconds);
+            node.windowMax = node.windowFrames == 0 ? node.frameMilliseconds : std::max(node.windowMax, node.frameMilliseconds);
+            node.windowSum += node.frameMilliseconds;
+            node.windowCalls += node.frameCalls;
+            ++node.windowFrames;
+        }
+        node.frameMilliseconds = 0.0;
+        node.frameCalls = 0;
+    }
+    double frameMilliseconds = ToMilliseconds(frameEnd - frameStart_);
+    frameStats_.lastMilliseconds = frameMilliseconds;
+    windowFrameMin_ = windowFrameCount_ == 0 ? frameMilliseconds : std::min(windowFrameMin_, frameMilliseconds);
+    windowFrameMax_ = windowFrameCount_ == 0 ? frameMilliseconds : std::max(windowFrameMax_, frameMilliseconds);
+    windowFrameSum_ = (windowFrameCount_ == 0 ? 0.0 : windowFrameSum_) + frameMilliseconds;
+    ++windowFrameCount_;
+    ++frameStats_.frameIndex;
+    if (windowFrameCount_ >= settings_.aggregateFrames) {
+        PublishWindow();
+    }
+
+    if (capturing) {
+        ProfileEvent frame;
+        frame.name = "Frame";
+        frame.start = frameStart_;
+        frame.end = frameEnd;
+        captureFrames_.push_back(frame);
+        if (--captureRemaining_ == 0) {
+            captureReady_ = true;
+        }
+    }
+    // 次のフレームは BeginFrame を呼ばなくてもここから測る
+    frameStart_ = frameEnd;
+}
+
+void CpuProfiler::Accumulate(uint32_t threadIndex, std::vector<ProfileEvent>& events) {
+    // 区間は終わった順に入っているので、始まった順 (同時なら外側が先) に並べ直して入れ子をたどる
+    std::sort(events.begin(), events.end(), [](const ProfileEvent& a, const ProfileEvent& b) {
+        return a.start != b.start ? a.start < b.start : a.depth < b.depth;
+    });
+    int32_t stack[64];
+    uint32_t stackSize = 0;
+    for (const ProfileEvent& event : events) {
+        // 前のフレームから続いていた外側の区間はもう読んだので、深さは詰める
+        stackSize = std::min(stackSize, std::min(event.depth, 63u));
+        int32_t parent = stackSize > 0 ? stack[stackSize - 1] : -1;
+        int32_t index = FindNode(parent, threadIndex, event.name);
+        ProfileNode& node = nodes_[index];
+        node.frameMilliseconds += ToMilliseconds(event.end - event.start);
+        ++node.frameCalls;
+        stack[stackSize++] = index;
+    }
+}
+
+int32_t CpuProfiler::FindNode(int32_t parent, uint32_t threadIndex, const char* name) {
+    NodeKey key{ parent, threadIndex, name };
+    auto it = nodeLookup.find(key);
+    if (it != nodeLookup.end()) {
+        return it->second;
+    }
+    ProfileNode node;
+    node.name = name;
+    node.parent = parent;
+    node.threadIndex = threadIndex;
+    node.depth = parent >= 0 ? nodes_[parent].depth + 1 : 0;
+    int32_t index = static_cast<int32_t>(nodes_.size());
+    nodes_.push_back(node);
+    nodeLookup.emplace(key, index);
+    return index;
+}
+
+void CpuProfiler::PublishWindow() {
+    for (ProfileNode& node : nodes_) {
+        node.minMilliseconds = node.windowFrames > 0 ? node.windowMin : 0.0;
+        node.maxMilliseconds = node.windowFrames > 0 ? node.windowMax : 0.0;
+        node.averageMilliseconds = node.windowFrames > 0 ? node.windowSum / node.windowFrames : 0.0;
+        node.callsPerFrame = node.windowFrames > 0 ? double(node.windowCalls) / node.windowFrames : 0.0;
+        node.windowSum = 0.0;
+        node.windowCalls = 0;
+        node.windowFrames = 0;
+    }
+    frameStats_.minMilliseconds = windowFrameMin_;
+    frameStats_.maxMilliseconds = windowFrameMax_;
+    frameStats_.averageMilliseconds = windowFrameSum_ / windowFrameCount_;
+    windowFrameCount_ = 0;
+}
+
+void CpuProfiler::RequestCapture(uint32_t frameCount) {
+    captureFrames_.clear();
+    captureThreads_.clear();
+    captureTracks_.clear();
+    captureReady_ = false;
+    captureRemaining_ = frameCount;
+}
+
+void CpuProfiler::AddCaptureTrack(const std::string& name, const std::vector<ProfileEvent>& events) {
+    for (ProfileTrack& track : captureTracks_) {
+        if (track.name == name) {
+            track.events.insert(track.events.end(), events.begin(), events.end());
+            return;
+        }
+    }
+    captureTracks_.push_back({ name, events });
+}
+
+bool CpuProfiler::WriteChromeTrace(const std::string& filePath, std::string* error) {
+    // 系列の並び (tid): フレーム、スレッドの番号の順、足した系列
+    std::vector<ProfileTrack> tracks;
+    tracks.push_back({ "Frames", captureFrames_ });
+    for (size_t threadIndex = 0; threadIndex < captureThreads_.size(); ++threadIndex) {
+        tracks.push_back({ threadIndex < threadNames_.size() ? threadNames_[threadIndex] : "Thread " + std::to_string(threadIndex),
+            captureThreads_[threadIndex] });
+    }
+    tracks.insert(tracks.end(), captureTracks_.begin(), captureTracks_.end());
+
+    // 時刻は最初の区間からのマイクロ秒
+    int64_t origin = INT64_MAX;
+    for (const ProfileTrack& track : tracks) {
+        for (const ProfileEvent& event : track.events) {
+            origin = std::min(origin, event.start);
+        }
+    }
+    std::string json = "{\"traceEvents\":[\n";
+    char number[128];
+    for (size_t trackIndex = 0; trackIndex < tracks.size(); ++trackIndex) {
+        const ProfileTrack& track = tracks[trackIndex];
+        std::snprintf(number, sizeof(number), "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"name\":",
+            trackIndex == 0 ? "" : ",\n", trackIndex);
+        json += number;
+        AppendJsonString(json, track.name.c_str());
+        std::snprintf(number, sizeof(number), "}},\n{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%zu,\"args\":{\"sort_index\":%zu}}",
+            trackIndex, trackIndex);
+        json += number;
+        for (const ProfileEvent& event : track.events) {
+            json += ",\n{\"name\":";
+            AppendJsonString(json, event.name);
+            std::snprintf(number, sizeof(number), ",\"ph\":\"X\",\"pid\":1,\"tid\":%zu,\"ts\":%.3f,\"dur\":%.3f}", trackIndex,
+                double(event.start - origin) / 1000.0, double(event.end - event.start) / 1000.0);
+            json += number;
+        }
+    }
+    json += "\n],\"displayTimeUnit\":\"ms\"}\n";
+
+    std::ofstream file(filePath, std::ios::binary | std::ios::trunc);
+    file.write(json.data(), static_cast<std::streamsize>(json.size()));
+    if (!file) {
+        if (error != nullptr) {
+            *error = "failed to write " + filePath;
+        }
+        return false;
+    }
+    captureFrames_.clear();
+    captureThreads_.clear();
+    captureTracks_.clear();
+    captureReady_ = false;
+    return true;
+}
@@ -0,0 +1,200 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// PROFILE_ENABLED を 0 にすると PROFILE_SCOPE はコードから消える (既定では有効で、実行中に SetEnabled で切り替えられる)
+#if !defined(PROFILE_ENABLED)
+#define PROFILE_ENABLED 1
+#endif
+
+// 1つの計測区間 (名前はリテラル。アドレスで区別する)
+struct ProfileEvent {
+    const char* name = nullptr;
+    int64_t start = 0; // ナノ秒 (CpuProfiler::Now の時間)
+    int64_t end = 0;
+    uint32_t depth = 0; // 同じスレッドで外側にある区間の数
+};
+
+// 集計した区間 (スレッドごとの木。親子は入れ子の関係)
+struct ProfileNode {
+    const char* name = nullptr;
+    int32_t parent = -1;      // 親のノード (-1 ならスレッドの根)
+    uint32_t threadIndex = 0;
+    uint32_t depth = 0;
+    // 直前のフレーム
+    double lastMilliseconds = 0.0;
+    uint32_t lastCalls = 0;
+    // 直前の集計期間 (走ったフレームでの1フレームあたりの合計時間)
+    double minMilliseconds = 0.0;
+    double averageMilliseconds = 0.0;
+    double maxMilliseconds = 0.0;
+    double callsPerFrame = 0.0;
+
+    // 集計中の値
+    double frameMilliseconds = 0.0;
+    uint32_t frameCalls = 0;
+    double windowMin = 0.0;
+    double windowMax = 0.0;
+    double windowSum = 0.0;
+    uint64_t windowCalls = 0;
+    uint32_t windowFrames = 0;
+};
+
+// フレーム全体の時間
+struct ProfileFrameStats {
+    uint64_t frameIndex = 0;
+    double lastMilliseconds = 0.0;
+    double minMilliseconds = 0.0;
+    double averageMilliseconds = 0.0;
+    double maxMilliseconds = 0.0;
+};
+
+// Chrome のトレースに足す別の系列 (GPU など)
+struct ProfileTrack {
+    std::string name;
+    std::vector<ProfileEvent> events;
+};
+
+// プロファイラーの設定
+struct ProfileSettings {
+    uint32_t threadEventCapacity = 16384; // スレッドごとに1フレームで記録できる区間の数 (超えた分は捨てる)
+    uint32_t aggregateFrames = 60;        // min/avg/max を出すフレーム数
+};
+
+namespace ProfileDetail {
+struct ThreadBuffer;
+}
+
+// CPU の階層的なフレームプロファイラー
+// PROFILE_SCOPE("名前") を置いたブロックの時間を、スレッドごとのバッファ (ロックしない) に区間として記録する
+// メインスレッドの EndFrame で全てのスレッドの区間を集め、スレッドごとの入れ子の木に積み上げて、決まったフレーム数ごとに min/avg/max を出す
+// 要求したフレーム数の区間をそのまま取っておき、Chrome のトレース (chrome://tracing や Perfetto で開く JSON) に書き出せる
+// 無効のときの PROFILE_SCOPE は1回の読み込みと分岐だけ。BeginFrame / EndFrame / 集計結果の参照はメインスレッドから呼ぶ
+class CpuProfiler {
+public:
+    // シングルトンインスタンスの取得
+    static CpuProfiler* GetInstance();
+
+    // 初期化
+    void Initialize(const ProfileSettings& settings);
+
+    // 終了処理
+    void Finalize();
+
+    // 記録の有効・無効 (どのスレッドから呼んでもよい)
+    static bool IsEnabled() { return enabled_.load(std::memory_order_relaxed); }
+    void SetEnabled(bool enabled);
+
+    // 呼んだスレッドの名前 (集計とトレースの表示用)
+    void SetThreadName(const char* name);
+
+    // スレッド以外の系列 (GPU など) を登録する。戻り値は系列の番号 (スレッドと同じく集計とトレースに出る)
+    uint32_t RegisterTrack(const char* name);
+    // 登録した系列の区間を今のフレームの集計とトレースに足す (メインスレッドから EndFrame の前に)
+    void SubmitTrackEvents(uint32_t trackIndex, std::vector<ProfileEvent>& events);
+
+    // フレームの始まりと終わり (メインスレッド)
+    void BeginFrame();
+    void EndFrame();
+
+    // 区間の記録 (ProfileScope から使う)
+    static int64_t BeginScope();
+    void EndScope(const char* name, int64_t start);
+
+    // 集計結果 (メインスレッド)
+    const std::vector<ProfileNode>& GetNodes() const { return nodes_; }
+    const std::vector<std::string>& GetThreadNames() const { return threadNames_; }
+    const ProfileFrameStats& GetFrameStats() const { return frameStats_; }
+    uint64_t GetDroppedCount() const { return droppedCount_; }
+
+    // 次の frameCount フレームの区間を取っておく
+    void RequestCapture(uint32_t frameCount);
+    bool IsCapturing() const { return captureRemaining_ > 0; }
+    bool IsCaptureReady() const { return captureReady_; }
+    // 取っておいたフレームに別の系列の区間を足す (時刻はプロファイラーの時間に合わせておくこと)
+    void AddCaptureTrack(const std::string& name, const std::vector<ProfileEvent>& events);
+    // 取っておいた区間を Chrome のトレースの JSON で書き出す (書いたら取っておいたものは捨てる)
+    bool WriteChromeTrace(const std::string& filePath, std::string* error);
+
+    // プロファイラーの時間 (ナノ秒)
+    static int64_t Now();
+
+private:
+    CpuProfiler() = default;
+    ~CpuProfiler() = default;
+    CpuProfiler(const CpuProfiler&) = delete;
+    const CpuProfiler& operator=(const CpuProfiler&) = delete;
+
+    ProfileDetail::ThreadBuffer* GetThreadBuffer();
+    void Accumulate(uint32_t threadIndex, std::vector<ProfileEvent>& events);
+    int32_t FindNode(int32_t parent, uint32_t threadIndex, const char* name);
+    void PublishWindow();
+
+private:
+    static inline std::atomic<bool> enabled_ = false;
+
+    ProfileSettings settings_;
+    // Initialize のたびに変わる (前の Initialize で作ったスレッドのバッファを使わないように)
+    std::atomic<uint64_t> generation_ = 0;
+
+    // スレッドのバッファ (登録は mutex_ で保護)
+    std::mutex mutex_;
+    std::vector<std::shared_ptr<ProfileDetail::ThreadBuffer>> buffers_;
+    uint32_t threadCount_ = 0; // 登録したスレッドの数 (スレッドの番号に使う)
+
+    // メインスレッドだけが触る
+    std::vector<std::string> threadNames_;
+    std::vector<std::pair<uint32_t, std::string>> tracks_; // RegisterTrack した系列の番号と名前
+    std::vector<ProfileNode> nodes_;
+    std::vector<ProfileEvent> scratch_;
+    ProfileFrameStats frameStats_;
+    int64_t frameStart_ = 0;
+    double windowFrameMin_ = 0.0;
+    double windowFrameMax_ = 0.0;
+    double windowFrameSum_ = 0.0;
+    uint32_t windowFrameCount_ = 0;
+    uint64_t droppedCount_ = 0;
+
+    // トレース用に取っておく区間
+    uint32_t captureRemaining_ = 0;
+    bool captureReady_ = false;
+    std::vector<ProfileEvent> captureFrames_;
+    std::vector<std::vector<ProfileEvent>> captureThreads_; // スレッドの番号の順
+    std::vector<ProfileTrack> captureTracks_;               // AddCaptureTrack で足した系列
+};
+
+// ブロックの時間を測る (PROFILE_SCOPE から使う)
+class ProfileScope {
+public:
+    explicit ProfileScope(const char* name) {
+        if (CpuProfiler::IsEnabled()) {
+            name_ = name;
+            start_ = CpuProfiler::BeginScope();
+        }
+    }
+    ~ProfileScope() {
+        if (name_ != nullptr) {
+            CpuProfiler::GetInstance()->EndScope(name_, start_);
+        }
+    }
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+    const char* name_ = nullptr;
+    int64_t start_ = 0;
+};
+
+#if PROFILE_ENABLED
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+// ここからブロックの終わりまでを name (リテラル) の区間として記録する
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#else
+#define PROFILE_SCOPE(name) ((void)0)
+#endif
@@ -0,0 +1,125 @@
+#include "GpuProfiler.h"
+#include <cassert>
+#include "Logger.h"
+
+namespace {
+
+// GPU と CPU の時刻の対応を取り直す間隔
+const int64_t kCalibrationInterval = 1000000000;
+
+} // namespace
+
+GpuProfiler* GpuProfiler::GetInstance() {
+    static GpuProfiler instance;
+    return &instance;
+}
+
+void GpuProfiler::Initialize(ID3D12Device* device, ID3D12CommandQueue* commandQueue, uint32_t frameCount, uint32_t maxScopesPerFrame) {
+    assert(device != nullptr && commandQueue != nullptr);
+    commandQueue_ = commandQueue;
+    queryRing_.Initialize(frameCount, maxScopesPerFrame);
+
+    D3D12_QUERY_HEAP_DESC queryHeapDesc{};
+    queryHeapDesc.Type = D3D12_QUERY_HEAP_TYPE_TIMESTAMP;
+    queryHeapDesc.Count = queryRing_.GetQueryCount();
+    HRESULT hr = device->CreateQueryHeap(&queryHeapDesc, IID_PPV_ARGS(&queryHeap_));
+    assert(SUCCEEDED(hr));
+
+    // 全ての枠の分をまとめた読み戻し用のバッファ (枠ごとに使う範囲が分かれている)
+    D3D12_HEAP_PROPERTIES readbackHeapProperties{};
+    readbackHeapProperties.Type = D3D12_HEAP_TYPE_READBACK;
+    D3D12_RESOURCE_DESC bufferDesc{};
+    bufferDesc.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER;
+    bufferDesc.Width = sizeof(uint64_t) * queryRing_.GetQueryCount();
+    bufferDesc.Height = 1;
+    bufferDesc.DepthOrArraySize = 1;
+    bufferDesc.MipLevels = 1;
+    bufferDesc.SampleDesc.Count = 1;
+    bufferDesc.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR;
+    hr = device->CreateCommittedResource(&readbackHeapProperties, D3D12_HEAP_FLAG_NONE, &bufferDesc, D3D12_RESOURCE_STATE_COPY_DEST,
+        nullptr, IID_PPV_ARGS(&readbackBuffer_));
+    assert(SUCCEEDED(hr));
+
+    Calibrate();
+    trackIndex_ = CpuProfiler::GetInstance()->RegisterTrack("GPU");
+    LogInfo(LogCategory::kGraphics, "GPU timestamp frequency: {}Hz", calibration_.gpuFrequency);
+}
+
+void GpuProfiler::Finalize() {
+    readbackBuffer_.Reset();
+    queryHeap_.Reset();
+    commandQueue_ = nullptr;
+}
+
+void GpuProfiler::Calibrate() {
+    UINT64 frequency = 0;
+    HRESULT hr = commandQueue_->GetTimestampFrequency(&frequency);
+    assert(SUCCEEDED(hr));
+    UINT64 gpuTimestamp = 0;
+    UINT64 cpuTimestamp = 0;
+    hr = commandQueue_->GetClockCalibration(&gpuTimestamp, &cpuTimestamp);
+    assert(SUCCEEDED(hr));
+    // CPU 側は QueryPerformanceCounter の値 (CpuProfiler::Now の steady_clock と同じ時計) なのでナノ秒に直す
+    LARGE_INTEGER performanceFrequency;
+    QueryPerformanceFrequency(&performanceFrequency);
+    uint64_t counterFrequency = static_cast<uint64_t>(performanceFrequency.QuadPart);
+    calibration_.gpuTicks = gpuTimestamp;
+    calibration_.gpuFrequency = frequency;
+    calibration_.cpuNanoseconds = static_cast<int64_t>((cpuTimestamp / counterFrequency) * 1000000000 +
+        (cpuTimestamp % counterFrequency) * 1000000000 / counterFrequency);
+    calibratedTime_ = CpuProfiler::Now();
+}
+
+void GpuProfiler::BeginFrame(ID3D12GraphicsCommandList* commandList, uint64_t completedFenceValue) {
+    // GPU が終えたフレームのタイムスタンプを読む
+    events_.clear();
+    GpuQueryRange range;
+    while (queryRing_.GetCompletedFrame(completedFenceValue, &range)) {
+        D3D12_RANGE readRange{ sizeof(uint64_t) * range.firstQuery, sizeof(uint64_t) * (range.firstQuery + range.queryCount) };
+        void* mapped = nullptr;
+        HRESULT hr = readbackBuffer_->Map(0, &readRange, &mapped);
+        assert(SUCCEEDED(hr));
+        queryRing_.ReleaseFrame(static_cast<const uint64_t*>(mapped) + range.firstQuery, calibration_, events_);
+        D3D12_RANGE writtenRange{ 0, 0 };
+        readbackBuffer_->Unmap(0, &writtenRange);
+    }
+    if (!events_.empty()) {
+        CpuProfiler::GetInstance()->SubmitTrackEvents(trackIndex_, events_);
+    }
+    if (CpuProfiler::Now() - calibratedTime_ > kCalibrationInterval) {
+        Calibrate();
+    }
+
+    if (CpuProfiler::IsEnabled() && queryRing_.BeginFrame()) {
+        frameScope_ = BeginScope(commandList, "GPU Frame");
+    }
+}
+
+void GpuProfiler::EndFrame(ID3D12GraphicsCommandList* commandList, uint64_t fenceValue) {
+    if (!queryRing_.IsRecording()) {
+        return;
+    }
+    EndScope(commandList, frameScope_);
+    frameScope_ = -1;
+    GpuQueryRange range;
+    if (queryRing_.EndFrame(fenceValue, &range) && range.queryCount > 0) {
+        commandList->ResolveQueryData(queryHeap_.Get(), D3D12_QUERY_TYPE_TIMESTAMP, range.firstQuery, range.queryCount,
+            readbackBuffer_.Get(), sizeof(uint64_t) * range.firstQuery);
+    }
+}
+
+int32_t GpuProfiler::BeginScope(ID3D12GraphicsCommandList* commandList, const char* name) {
+    uint32_t query = 0;
+    int32_t scope = queryRing_.BeginScope(name, &query);
+    if (scope >= 0) {
+        commandList->EndQuery(queryHeap_.Get(), D3D12_QUERY_TYPE_TIMESTAMP, query);
+    }
+    return scope;
+}
+
+void GpuProfiler::EndScope(ID3D12GraphicsCommandList* commandList, int32_t scope) {
+    uint32_t query = 0;
+    if (queryRing_.EndScope(scope, &query)) {
+        commandList->EndQuery(queryHeap_.Get(), D3D12_QUERY_TYPE_TIMESTAMP, query);
+    }
+}
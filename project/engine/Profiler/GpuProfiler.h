@@ -0,0 +1,80 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl.h>
+#include <cstdint>
+#include <vector>
+#include "CpuProfiler.h"
+#include "GpuQueryRing.h"
+
+// GPU の区間の計測 (タイムスタンプクエリ)
+// GPU_PROFILE_SCOPE(commandList, "名前") を置いたコマンドの前後にタイムスタンプを書かせ、フレームの終わりに読み戻し用のバッファへ解決する
+// GPU がそのフレームを終えた (フェンスが進んだ) 後のフレームで読み、CPU の時刻に直して CpuProfiler の "GPU" の系列に渡す
+// なので GPU の区間は数フレーム遅れて集計とトレースに入る。クエリの割り当てと変換は GpuQueryRing が行う
+// CpuProfiler が無効の間は記録しない。全てメインスレッド (コマンドリストを作るスレッド) から呼ぶ
+class GpuProfiler {
+public:
+    // シングルトンインスタンスの取得
+    static GpuProfiler* GetInstance();
+
+    // 初期化 (frameCount: 同時に GPU に出ているフレームの上限、maxScopesPerFrame: 1フレームの区間の上限)
+    void Initialize(ID3D12Device* device, ID3D12CommandQueue* commandQueue, uint32_t frameCount = 3, uint32_t maxScopesPerFrame = 128);
+
+    // 終了処理
+    void Finalize();
+
+    // フレームの始まり (コマンドリストに積み始める前)。GPU が終えたフレームの結果を CpuProfiler に渡し、"GPU Frame" の区間を始める
+    void BeginFrame(ID3D12GraphicsCommandList* commandList, uint64_t completedFenceValue);
+    // フレームの終わり (Close の前)。"GPU Frame" の区間を終え、クエリを解決する (fenceValue はこのフレームの後に Signal する値)
+    void EndFrame(ID3D12GraphicsCommandList* commandList, uint64_t fenceValue);
+
+    // 区間の記録 (GpuProfileScope から使う)
+    int32_t BeginScope(ID3D12GraphicsCommandList* commandList, const char* name);
+    void EndScope(ID3D12GraphicsCommandList* commandList, int32_t scope);
+
+    const GpuQueryRing& GetQueryRing() const { return queryRing_; }
+
+private:
+    GpuProfiler() = default;
+    ~GpuProfiler() = default;
+    GpuProfiler(const GpuProfiler&) = delete;
+    const GpuProfiler& operator=(const GpuProfiler&) = delete;
+
+    // GPU と CPU の時刻の対応を取り直す (GPU のクロックは少しずつずれる)
+    void Calibrate();
+
+private:
+    ID3D12CommandQueue* commandQueue_ = nullptr;
+    Microsoft::WRL::ComPtr<ID3D12QueryHeap> queryHeap_;
+    Microsoft::WRL::ComPtr<ID3D12Resource> readbackBuffer_;
+    GpuQueryRing queryRing_;
+    GpuClockCalibration calibration_;
+    int64_t calibratedTime_ = 0;
+    uint32_t trackIndex_ = 0;
+    int32_t frameScope_ = -1;
+    std::vector<ProfileEvent> events_;
+};
+
+// コマンドの区間を測る (GPU_PROFILE_SCOPE から使う)
+class GpuProfileScope {
+public:
+    GpuProfileScope(ID3D12GraphicsCommandList* commandList, const char* name)
+        : commandList_(commandList), scope_(GpuProfiler::GetInstance()->BeginScope(commandList, name)) {}
+    ~GpuProfileScope() {
+        if (scope_ >= 0) {
+            GpuProfiler::GetInstance()->EndScope(commandList_, scope_);
+        }
+    }
+    GpuProfileScope(const GpuProfileScope&) = delete;
+    GpuProfileScope& operator=(const GpuProfileScope&) = delete;
+
+private:
+    ID3D12GraphicsCommandList* commandList_;
+    int32_t scope_;
+};
+
+#if PROFILE_ENABLED
+// ここからブロックの終わりまでに commandList に積んだコマンドを name (リテラル) の区間として記録する
+#define GPU_PROFILE_SCOPE(commandList, name) GpuProfileScope PROFILE_CONCAT(gpuProfileScope, __LINE__)(commandList, name)
+#else
+#define GPU_PROFILE_SCOPE(commandList, name) ((void)0)
+#endif
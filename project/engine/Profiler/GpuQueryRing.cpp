@@ -0,0 +1,120 @@
+#include "GpuQueryRing.h"
+#include <cassert>
+
+void GpuQueryRing::Initialize(uint32_t frameCount, uint32_t maxScopesPerFrame) {
+    assert(frameCount > 0 && maxScopesPerFrame > 0);
+    frameCount_ = frameCount;
+    queriesPerFrame_ = maxScopesPerFrame * 2;
+    frames_.assign(frameCount, Frame());
+    for (Frame& frame : frames_) {
+        frame.scopes.reserve(maxScopesPerFrame);
+    }
+    writeFrame_ = 0;
+    readFrame_ = 0;
+    recording_ = false;
+    depth_ = 0;
+    skippedFrameCount_ = 0;
+    droppedScopeCount_ = 0;
+    invalidScopeCount_ = 0;
+}
+
+bool GpuQueryRing::BeginFrame() {
+    assert(!recording_);
+    Frame& frame = frames_[writeFrame_];
+    if (frame.state != Frame::State::kFree) {
+        // 読み戻しが追いついていない (GPU が frameCount フレーム以上遅れている)
+        ++skippedFrameCount_;
+        return false;
+    }
+    frame.state = Frame::State::kRecording;
+    frame.scopes.clear();
+    recording_ = true;
+    depth_ = 0;
+    return true;
+}
+
+int32_t GpuQueryRing::BeginScope(const char* name, uint32_t* query) {
+    if (!recording_) {
+        return -1;
+    }
+    Frame& frame = frames_[writeFrame_];
+    if (frame.scopes.size() * 2 >= queriesPerFrame_) {
+        ++droppedScopeCount_;
+        return -1;
+    }
+    int32_t scope = static_cast<int32_t>(frame.scopes.size());
+    frame.scopes.push_back({ name, depth_, false });
+    ++depth_;
+    *query = writeFrame_ * queriesPerFrame_ + uint32_t(scope) * 2;
+    return scope;
+}
+
+bool GpuQueryRing::EndScope(int32_t scope, uint32_t* query) {
+    if (!recording_ || scope < 0) {
+        return false;
+    }
+    Frame& frame = frames_[writeFrame_];
+    assert(size_t(scope) < frame.scopes.size() && !frame.scopes[scope].ended);
+    frame.scopes[scope].ended = true;
+    --depth_;
+    *query = writeFrame_ * queriesPerFrame_ + uint32_t(scope) * 2 + 1;
+    return true;
+}
+
+bool GpuQueryRing::EndFrame(uint64_t fenceValue, GpuQueryRange* range) {
+    if (!recording_) {
+        return false;
+    }
+    Frame& frame = frames_[writeFrame_];
+    assert(depth_ == 0);
+    frame.state = Frame::State::kSubmitted;
+    frame.fenceValue = fenceValue;
+    range->firstQuery = writeFrame_ * queriesPerFrame_;
+    range->queryCount = static_cast<uint32_t>(frame.scopes.size()) * 2;
+    recording_ = false;
+    writeFrame_ = (writeFrame_ + 1) % frameCount_;
+    return true;
+}
+
+bool GpuQueryRing::GetCompletedFrame(uint64_t completedFenceValue, GpuQueryRange* range) const {
+    const Frame& frame = frames_[readFrame_];
+    if (frame.state != Frame::State::kSubmitted || frame.fenceValue > completedFenceValue) {
+        return false;
+    }
+    range->firstQuery = readFrame_ * queriesPerFrame_;
+    range->queryCount = static_cast<uint32_t>(frame.scopes.size()) * 2;
+    return true;
+}
+
+void GpuQueryRing::ReleaseFrame(const uint64_t* timestamps, const GpuClockCalibration& calibration, std::vector<ProfileEvent>& out) {
+    Frame& frame = frames_[readFrame_];
+    assert(frame.state == Frame::State::kSubmitted);
+    for (size_t i = 0; i < frame.scopes.size(); ++i) {
+        const Scope& scope = frame.scopes[i];
+        uint64_t begin = timestamps[i * 2];
+        uint64_t end = timestamps[i * 2 + 1];
+        // 終わっていない区間と、GPU が時刻を書けなかった区間 (電源状態が変わったときなど) は捨てる
+        if (!scope.ended || begin == 0 || end < begin) {
+            ++invalidScopeCount_;
+            continue;
+        }
+        ProfileEvent event;
+        event.name = scope.name;
+        event.start = ToCpuNanoseconds(begin, calibration);
+        event.end = ToCpuNanoseconds(end, calibration);
+        event.depth = scope.depth;
+        out.push_back(event);
+    }
+    frame.state = Frame::State::kFree;
+    frame.scopes.clear();
+    readFrame_ = (readFrame_ + 1) % frameCount_;
+}
+
+int64_t GpuQueryRing::ToCpuNanoseconds(uint64_t ticks, const GpuClockCalibration& calibration) {
+    // 対応を取った時刻からの差だけを変換する (ティックの値そのものに 1e9 を掛けると溢れる)
+    int64_t delta = static_cast<int64_t>(ticks - calibration.gpuTicks);
+    int64_t seconds = delta / static_cast<int64_t>(calibration.gpuFrequency);
+    int64_t remainder = delta % static_cast<int64_t>(calibration.gpuFrequency);
+    return calibration.cpuNanoseconds + seconds * 1000000000 +
+        static_cast<int64_t>(double(remainder) * 1e9 / double(calibration.gpuFrequency));
+}
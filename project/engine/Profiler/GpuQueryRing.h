@@ -0,0 +1,88 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "CpuProfiler.h"
+
+// GPU の時刻と CPU の時刻の対応 (同じ瞬間の2つの値)
+struct GpuClockCalibration {
+    uint64_t gpuTicks = 0;
+    int64_t cpuNanoseconds = 0; // CpuProfiler::Now の時間
+    uint64_t gpuFrequency = 1;  // GPU の1秒あたりのティック
+};
+
+// 1フレームのクエリが使う範囲 (ResolveQueryData と読み戻しに使う)
+struct GpuQueryRange {
+    uint32_t firstQuery = 0;
+    uint32_t queryCount = 0;
+};
+
+// GPU のタイムスタンプクエリの割り当てと、結果を区間にする処理 (D3D12 に依存しない)
+// クエリのヒープを frameCount 個の枠に分け、フレームごとに1つの枠へ区間の始まりと終わりのクエリを割り当てる
+// 枠は GPU がそのフレームを終える (フェンスが進む) まで使えないので、空いていないフレームは記録しない
+// 終わったフレームは古い順に取り出し、読み戻したタイムスタンプを CPU の時刻の区間に直す
+// 全てメインスレッド (コマンドリストを作るスレッド) から呼ぶ
+class GpuQueryRing {
+public:
+    // frameCount: 同時に GPU に出ているフレームの上限、maxScopesPerFrame: 1フレームの区間の上限
+    void Initialize(uint32_t frameCount, uint32_t maxScopesPerFrame);
+
+    // ヒープに要るクエリの数
+    uint32_t GetQueryCount() const { return frameCount_ * queriesPerFrame_; }
+
+    // フレームの記録を始める (枠が空いていなければ false で、このフレームの区間は記録しない)
+    bool BeginFrame();
+
+    // 区間の始まり (戻り値は EndScope に渡す番号。記録しないときは -1)。query に EndQuery するクエリの番号を入れる
+    int32_t BeginScope(const char* name, uint32_t* query);
+    // 区間の終わり。query に EndQuery するクエリの番号を入れる (記録しないときは false)
+    bool EndScope(int32_t scope, uint32_t* query);
+
+    // フレームの記録を終える (fenceValue はこのフレームのコマンドの後に Signal する値)。range に解決するクエリを入れる
+    bool EndFrame(uint64_t fenceValue, GpuQueryRange* range);
+
+    // GPU が終えたフレームのうち最も古いもの (無ければ false)
+    bool GetCompletedFrame(uint64_t completedFenceValue, GpuQueryRange* range) const;
+    // GetCompletedFrame のフレームのタイムスタンプ (range.firstQuery からの並び) を区間にして out に足し、枠を空ける
+    void ReleaseFrame(const uint64_t* timestamps, const GpuClockCalibration& calibration, std::vector<ProfileEvent>& out);
+
+    bool IsRecording() const { return recording_; }
+    // 枠が空かず記録しなかったフレームの数
+    uint64_t GetSkippedFrameCount() const { return skippedFrameCount_; }
+    // 区間の上限を超えて記録しなかった区間の数
+    uint64_t GetDroppedScopeCount() const { return droppedScopeCount_; }
+    // 終わりが始まりより前など、使えないタイムスタンプで捨てた区間の数
+    uint64_t GetInvalidScopeCount() const { return invalidScopeCount_; }
+
+    // ティックを CPU の時刻 (ナノ秒) に直す
+    static int64_t ToCpuNanoseconds(uint64_t ticks, const GpuClockCalibration& calibration);
+
+private:
+    struct Scope {
+        const char* name = nullptr;
+        uint32_t depth = 0;
+        bool ended = false;
+    };
+
+    struct Frame {
+        enum class State : uint8_t {
+            kFree,
+            kRecording,
+            kSubmitted,
+        };
+        State state = State::kFree;
+        uint64_t fenceValue = 0;
+        std::vector<Scope> scopes; // 区間 i のクエリは 2i (始まり) と 2i + 1 (終わり)
+    };
+
+private:
+    uint32_t frameCount_ = 0;
+    uint32_t queriesPerFrame_ = 0;
+    std::vector<Frame> frames_;
+    uint32_t writeFrame_ = 0; // 次に記録する枠
+    uint32_t readFrame_ = 0;  // 次に取り出す枠
+    bool recording_ = false;
+    uint32_t depth_ = 0;
+    uint64_t skippedFrameCount_ = 0;
+    uint64_t droppedScopeCount_ = 0;
+    uint64_t invalidScopeCount_ = 0;
+};
@@ -0,0 +1,144 @@
+#include "ProfilerPanel.h"
+#include <chrono>
+#include <ctime>
+#include <filesystem>
+#include "CpuProfiler.h"
+#include "Logger.h"
+#include "externals/imgui/imgui.h"
+
+ProfilerPanel::ProfilerPanel(const std::string& traceDirectory) : traceDirectory_(traceDirectory) {
+}
+
+void ProfilerPanel::Draw(CpuProfiler* profiler) {
+    // 取り終えたトレースを書き出す (GPU などの系列は EndFrame までに足されている)
+    if (profiler->IsCaptureReady()) {
+        std::time_t now = std::chrono::system_clock::to_time_t(std::chrono::system_clock::now());
+        std::tm local{};
+#if defined(_WIN32)
+        localtime_s(&local, &now);
+#else
+        localtime_r(&now, &local);
+#endif
+        char fileName[64];
+        std::strftime(fileName, sizeof(fileName), "trace_%Y%m%d_%H%M%S.json", &local);
+        std::error_code errorCode;
+        std::filesystem::create_directories(traceDirectory_, errorCode);
+        std::string filePath = traceDirectory_ + "/" + fileName;
+        std::string error;
+        if (profiler->WriteChromeTrace(filePath, &error)) {
+            lastTracePath_ = filePath;
+            LogInfo(LogCategory::kGeneral, "Wrote trace: {}", filePath);
+        } else {
+            LogError(LogCategory::kGeneral, "Failed to write trace: {}", error);
+        }
+    }
+
+    if (!ImGui::Begin("Profiler")) {
+        ImGui::End();
+        return;
+    }
+
+    bool enabled = CpuProfiler::IsEnabled();
+    if (ImGui::Checkbox("Enabled", &enabled)) {
+        profiler->SetEnabled(enabled);
+    }
+    const ProfileFrameStats& frame = profiler->GetFrameStats();
+    ImGui::SameLine();
+    ImGui::Text("Frame %llu: %.2fms (min %.2f / avg %.2f / max %.2f)", static_cast<unsigned long long>(frame.frameIndex),
+        frame.lastMilliseconds, frame.minMilliseconds, frame.averageMilliseconds, frame.maxMilliseconds);
+    if (profiler->GetDroppedCount() > 0) {
+        ImGui::TextColored(ImVec4(1.0f, 0.5f, 0.3f, 1.0f), "Dropped %llu scopes (buffer full)",
+            static_cast<unsigned long long>(profiler->GetDroppedCount()));
+    }
+
+    // トレースの書き出し
+    ImGui::SetNextItemWidth(120.0f);
+    ImGui::SliderInt("Frames", &captureFrames_, 1, 120);
+    ImGui::SameLine();
+    if (profiler->IsCapturing()) {
+        ImGui::TextUnformatted("Capturing...");
+    } else if (ImGui::Button("Capture trace")) {
+        profiler->RequestCapture(static_cast<uint32_t>(captureFrames_));
+    }
+    if (!lastTracePath_.empty()) {
+        ImGui::TextDisabled("%s (chrome://tracing)", lastTracePath_.c_str());
+    }
+
+    // 親子の関係を作り直す
+    const std::vector<ProfileNode>& nodes = profiler->GetNodes();
+    const std::vector<std::string>& threadNames = profiler->GetThreadNames();
+    children_.resize(nodes.size());
+    roots_.resize(threadNames.size());
+    for (std::vector<int32_t>& list : children_) {
+        list.clear();
+    }
+    for (std::vector<int32_t>& list : roots_) {
+        list.clear();
+    }
+    for (int32_t index = 0; index < static_cast<int32_t>(nodes.size()); ++index) {
+        const ProfileNode& node = nodes[index];
+        if (node.parent >= 0) {
+            children_[node.parent].push_back(index);
+        } else if (node.threadIndex < roots_.size()) {
+            roots_[node.threadIndex].push_back(index);
+        }
+    }
+
+    const ImGuiTableFlags tableFlags = ImGuiTableFlags_BordersV | ImGuiTableFlags_RowBg | ImGuiTableFlags_Resizable | ImGuiTableFlags_ScrollY;
+    if (ImGui::BeginTable("Scopes", 6, tableFlags)) {
+        ImGui::TableSetupScrollFreeze(0, 1);
+        ImGui::TableSetupColumn("Scope", ImGuiTableColumnFlags_NoHide);
+        ImGui::TableSetupColumn("Last ms", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+        ImGui::TableSetupColumn("Avg ms", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+        ImGui::TableSetupColumn("Min ms", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+        ImGui::TableSetupColumn("Max ms", ImGuiTableColumnFlags_WidthFixed, 60.0f);
+        ImGui::TableSetupColumn("Calls", ImGuiTableColumnFlags_WidthFixed, 50.0f);
+        ImGui::TableHeadersRow();
+        for (size_t threadIndex = 0; threadIndex < roots_.size(); ++threadIndex) {
+            if (roots_[threadIndex].empty()) {
+                continue;
+            }
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::PushID(static_cast<int>(threadIndex));
+            bool open = ImGui::TreeNodeEx(threadNames[threadIndex].c_str(), ImGuiTreeNodeFlags_SpanFullWidth | ImGuiTreeNodeFlags_DefaultOpen);
+            if (open) {
+                for (int32_t root : roots_[threadIndex]) {
+                    DrawNode(profiler, root);
+                }
+                ImGui::TreePop();
+            }
+            ImGui::PopID();
+        }
+        ImGui::EndTable();
+    }
+    ImGui::End();
+}
+
+void ProfilerPanel::DrawNode(const CpuProfiler* profiler, int32_t index) {
+    const ProfileNode& node = profiler->GetNodes()[index];
+    ImGui::TableNextRow();
+    ImGui::TableNextColumn();
+    ImGuiTreeNodeFlags flags = ImGuiTreeNodeFlags_SpanFullWidth | ImGuiTreeNodeFlags_DefaultOpen;
+    if (children_[index].empty()) {
+        flags |= ImGuiTreeNodeFlags_Leaf | ImGuiTreeNodeFlags_NoTreePushOnOpen;
+    }
+    // 同じ名前が別の親の下にもあるので、ノードの番号で区別する
+    bool open = ImGui::TreeNodeEx(reinterpret_cast<void*>(static_cast<intptr_t>(index)), flags, "%s", node.name);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", node.lastMilliseconds);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", node.averageMilliseconds);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", node.minMilliseconds);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.3f", node.maxMilliseconds);
+    ImGui::TableNextColumn();
+    ImGui::Text("%.1f", node.callsPerFrame);
+    if (open && !children_[index].empty()) {
+        for (int32_t child : children_[index]) {
+            DrawNode(profiler, child);
+        }
+        ImGui::TreePop();
+    }
+}
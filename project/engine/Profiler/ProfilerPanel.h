@@ -0,0 +1,31 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class CpuProfiler;
+
+// CpuProfiler の集計結果を出す ImGui のウィンドウ
+// スレッドごとに区間の木を表にし (直前のフレーム・集計期間の min/avg/max・1フレームの回数)、ボタンで数フレームを Chrome のトレースに書き出す
+// ImGui::NewFrame と ImGui::Render の間で、メインスレッドから毎フレーム呼ぶ
+class ProfilerPanel {
+public:
+    // traceDirectory: トレースを書くディレクトリ
+    explicit ProfilerPanel(const std::string& traceDirectory = "logs");
+
+    void Draw(CpuProfiler* profiler);
+
+    // 最後に書いたトレースのパス (まだなら空)
+    const std::string& GetLastTracePath() const { return lastTracePath_; }
+
+private:
+    void DrawNode(const CpuProfiler* profiler, int32_t index);
+
+private:
+    std::string traceDirectory_;
+    std::string lastTracePath_;
+    int captureFrames_ = 10;
+    // ノードの子 (毎フレーム作り直す。-1 の親はスレッドごとの根)
+    std::vector<std::vector<int32_t>> children_;
+    std::vector<std::vector<int32_t>> roots_;
+};
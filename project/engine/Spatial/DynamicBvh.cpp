@@ -0,0 +1,1035 @@
+#include "DynamicBvh.h"
+#include <algorithm>
+#include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <queue>
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define DYNAMIC_BVH_USE_SSE 1
+#endif
+
+namespace {
+
+// 4つの float (SSE が無ければ1つずつ計算する)
+#ifdef DYNAMIC_BVH_USE_SSE
+using Float4 = __m128;
+inline Float4 Load4(const float* values) { return _mm_load_ps(values); }
+inline Float4 Splat4(float value) { return _mm_set1_ps(value); }
+inline Float4 Add4(Float4 a, Float4 b) { return _mm_add_ps(a, b); }
+inline Float4 Sub4(Float4 a, Float4 b) { return _mm_sub_ps(a, b); }
+inline Float4 Mul4(Float4 a, Float4 b) { return _mm_mul_ps(a, b); }
+inline Float4 Min4(Float4 a, Float4 b) { return _mm_min_ps(a, b); }
+inline Float4 Max4(Float4 a, Float4 b) { return _mm_max_ps(a, b); }
+// a <= b の成り立つ要素のビット
+inline uint32_t LessEqual4(Float4 a, Float4 b) { return static_cast<uint32_t>(_mm_movemask_ps(_mm_cmple_ps(a, b))); }
+inline void Store4(float* out, Float4 value) { _mm_storeu_ps(out, value); }
+#else
+struct Float4 {
+    float v[4];
+};
+inline Float4 Load4(const float* values) { return { { values[0], values[1], values[2], values[3] } }; }
+inline Float4 Splat4(float value) { return { { value, value, value, value } }; }
+inline Float4 Add4(Float4 a, Float4 b) { return { { a.v[0] + b.v[0], a.v[1] + b.v[1], a.v[2] + b.v[2], a.v[3] + b.v[3] } }; }
+inline Float4 Sub4(Float4 a, Float4 b) { return { { a.v[0] - b.v[0], a.v[1] - b.v[1], a.v[2] - b.v[2], a.v[3] - b.v[3] } }; }
+inline Float4 Mul4(Float4 a, Float4 b) { return { { a.v[0] * b.v[0], a.v[1] * b.v[1], a.v[2] * b.v[2], a.v[3] * b.v[3] } }; }
+inline Float4 Min4(Float4 a, Float4 b) {
+    return { { a.v[0] < b.v[0] ? a.v[0] : b.v[0], a.v[1] < b.v[1] ? a.v[1] : b.v[1], a.v[2] < b.v[2] ? a.v[2] : b.v[2],
+        a.v[3] < b.v[3] ? a.v[3] : b.v[3] } };
+}
+inline Float4 Max4(Float4 a, Float4 b) {
+    return { { a.v[0] > b.v[0] ? a.v[0] : b.v[0], a.v[1] > b.v[1] ? a.v[1] : b.v[1], a.v[2] > b.v[2] ? a.v[2] : b.v[2],
+        a.v[3] > b.v[3] ? a.v[3] : b.v[3] } };
+}
+inline uint32_t LessEqual4(Float4 a, Float4 b) {
+    return (a.v[0] <= b.v[0] ? 1u : 0u) | (a.v[1] <= b.v[1] ? 2u : 0u) | (a.v[2] <= b.v[2] ? 4u : 0u) | (a.v[3] <= b.v[3] ? 8u : 0u);
+}
+inline void Store4(float* out, Float4 value) {
+    for (int i = 0; i < 4; ++i) {
+        out[i] = value.v[i];
+    }
+}
+#endif
+
+// SAH で分けるときの区間の数
+const uint32_t kSahBinCount = 16;
+
+Aabb Union(const Aabb& a, const Aabb& b) {
+    Aabb result;
+    result.min = { a.min.x < b.min.x ? a.min.x : b.min.x, a.min.y < b.min.y ? a.min.y : b.min.y, a.min.z < b.min.z ? a.min.z : b.min.z };
+    result.max = { a.max.x > b.max.x ? a.max.x : b.max.x, a.max.y > b.max.y ? a.max.y : b.max.y, a.max.z > b.max.z ? a.max.z : b.max.z };
+    return result;
+}
+
+bool Contains(const Aabb& outer, const Aabb& inner) {
+    return outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.min.z <= inner.min.z && inner.max.x <= outer.max.x &&
+        inner.max.y <= outer.max.y && inner.max.z <= outer.max.z;
+}
+
+// 表面積の半分 (比べるだけなので2倍しない)
+float Area(const Aabb& bounds) {
+    float x = bounds.max.x - bounds.min.x;
+    float y = bounds.max.y - bounds.min.y;
+    float z = bounds.max.z - bounds.min.z;
+    return x * y + y * z + z * x;
+}
+
+const Aabb kEmptyBounds = { { FLT_MAX, FLT_MAX, FLT_MAX }, { -FLT_MAX, -FLT_MAX, -FLT_MAX } };
+
+float Axis(const Vector3& v, uint32_t axis) {
+    return axis == 0 ? v.x : (axis == 1 ? v.y : v.z);
+}
+
+// 方向の逆数 (0 のときは大きな値にして、0 * 無限大で NaN にならないようにする)
+float SafeInverse(float value) {
+    if (std::fabs(value) < 1.0e-20f) {
+        return value < 0.0f ? -1.0e30f : 1.0e30f;
+    }
+    return 1.0f / value;
+}
+
+} // namespace
+
+Frustum MakeFrustum(const Matrix4x4& viewProjection) {
+    // クリップ座標の列 j は (m[0][j], m[1][j], m[2][j], m[3][j])
+    auto column = [&viewProjection](int j) {
+        return Vector4{ viewProjection.m[0][j], viewProjection.m[1][j], viewProjection.m[2][j], viewProjection.m[3][j] };
+    };
+    auto add = [](const Vector4& a, const Vector4& b) { return Vector4{ a.x + b.x, a.y + b.y, a.z + b.z, a.w + b.w }; };
+    auto subtract = [](const Vector4& a, const Vector4& b) { return Vector4{ a.x - b.x, a.y - b.y, a.z - b.z, a.w - b.w }; };
+    Vector4 x = column(0);
+    Vector4 y = column(1);
+    Vector4 z = column(2);
+    Vector4 w = column(3);
+    Frustum frustum;
+    frustum.planes[0] = add(w, x);      // 左
+    frustum.planes[1] = subtract(w, x); // 右
+    frustum.planes[2] = add(w, y);      // 下
+    frustum.planes[3] = subtract(w, y); // 上
+    frustum.planes[4] = z;              // 近
+    frustum.planes[5] = subtract(w, z); // 遠
+    return frustum;
+}
+
+DynamicBvh::DynamicBvh(float margin) : margin_(margin) {}
+
+uint32_t DynamicBvh::CreateProxy(const Aabb& bounds, uint32_t userData, bool isStatic) {
+    uint32_t id = 0;
+    if (!freeProxies_.empty()) {
+        id = freeProxies_.back();
+        freeProxies_.pop_back();
+    } else {
+        id = static_cast<uint32_t>(proxies_.size());
+        proxies_.emplace_back();
+    }
+    Proxy& proxy = proxies_[id];
+    proxy.bounds = bounds;
+    proxy.userData = userData;
+    proxy.isStatic = isStatic;
+    proxy.alive = true;
+    proxy.leaf = UINT32_MAX;
+    if (isStatic) {
+        ++staticCount_;
+        staticDirty_ = true;
+    } else {
+        // 木には Update でまとめて入れる
+        uint32_t leaf = AllocateNode();
+        TreeNode& node = nodes_[leaf];
+        node.bounds = { { bounds.min.x - margin_, bounds.min.y - margin_, bounds.min.z - margin_ },
+            { bounds.max.x + margin_, bounds.max.y + margin_, bounds.max.z + margin_ } };
+        node.proxy = id;
+        proxies_[id].leaf = leaf;
+        proxies_[id].pending = true;
+        pendingProxies_.push_back(id);
+        dynamicDirty_ = true;
+    }
+    return id;
+}
+
+void DynamicBvh::DestroyProxy(uint32_t id) {
+    assert(id < proxies_.size() && proxies_[id].alive);
+    Proxy& proxy = proxies_[id];
+    if (proxy.isStatic) {
+        --staticCount_;
+        staticDirty_ = true;
+    } else {
+        if (!proxy.pending) {
+            RemoveLeaf(proxy.leaf);
+            --dynamicLeafCount_;
+        }
+        FreeNode(proxy.leaf);
+        dynamicDirty_ = true;
+    }
+    proxy = Proxy();
+    freeProxies_.push_back(id);
+}
+
+void DynamicBvh::MoveProxy(uint32_t id, const Aabb& bounds) {
+    assert(id < proxies_.size() && proxies_[id].alive);
+    Proxy& proxy = proxies_[id];
+    proxy.bounds = bounds;
+    if (proxy.isStatic) {
+        staticDirty_ = true;
+        return;
+    }
+    // 問い合わせ用の節点には余白の無い AABB を写すので、木が変わらなくても葉を書き換える
+    dynamicDirty_ = true;
+    if (proxy.pending) {
+        nodes_[proxy.leaf].bounds = { { bounds.min.x - margin_, bounds.min.y - margin_, bounds.min.z - margin_ },
+            { bounds.max.x + margin_, bounds.max.y + margin_, bounds.max.z + margin_ } };
+        return;
+    }
+    if (Contains(nodes_[proxy.leaf].bounds, bounds)) {
+        movedProxies_.push_back(id);
+        return;
+    }
+    RemoveLeaf(proxy.leaf);
+    nodes_[proxy.leaf].bounds = { { bounds.min.x - margin_, bounds.min.y - margin_, bounds.min.z - margin_ },
+        { bounds.max.x + margin_, bounds.max.y + margin_, bounds.max.z + margin_ } };
+    InsertLeaf(proxy.leaf);
+    ++reinsertCount_;
+}
+
+void DynamicBvh::Clear() {
+    proxies_.clear();
+    freeProxies_.clear();
+    staticCount_ = 0;
+    nodes_.clear();
+    freeNodes_.clear();
+    root_ = UINT32_MAX;
+    dynamicLeafCount_ = 0;
+    pendingProxies_.clear();
+    staticNodes_.clear();
+    staticRoot_ = UINT32_MAX;
+    staticWide_.clear();
+    dynamicWide_.clear();
+    freeDynamicWide_.clear();
+    staticWideRoot_ = UINT32_MAX;
+    dynamicWideRoot_ = UINT32_MAX;
+    movedProxies_.clear();
+    staticDirty_ = false;
+    dynamicDirty_ = false;
+    reinsertCount_ = 0;
+    rotationCount_ = 0;
+    stats_ = {};
+}
+
+uint32_t DynamicBvh::GetUserData(uint32_t proxy) const {
+    assert(proxy < proxies_.size() && proxies_[proxy].alive);
+    return proxies_[proxy].userData;
+}
+
+const Aabb& DynamicBvh::GetBounds(uint32_t proxy) const {
+    assert(proxy < proxies_.size() && proxies_[proxy].alive);
+    return proxies_[proxy].bounds;
+}
+
+void DynamicBvh::Update() {
+    stats_.staticRebuilt = false;
+    stats_.dynamicRebuilt = false;
+    if (staticDirty_) {
+        BuildStatic();
+        staticWide_.clear();
+        std::vector<uint32_t> freeWideNodes;
+        staticWideRoot_ = Collapse(staticNodes_, staticRoot_, staticWide_, freeWideNodes);
+        staticDirty_ = false;
+        stats_.staticRebuilt = true;
+    }
+    if (dynamicDirty_) {
+        InsertPending();
+        if (root_ == UINT32_MAX) {
+            dynamicWide_.clear();
+            freeDynamicWide_.clear();
+        }
+        dynamicWideRoot_ = Collapse(nodes_, root_, dynamicWide_, freeDynamicWide_);
+        // 余白の中で動いた葉は AABB だけ書き換える (写しを作り直した節点では写したときの値で上書きされている)
+        for (uint32_t id : movedProxies_) {
+            const Proxy& proxy = proxies_[id];
+            if (!proxy.alive || proxy.isStatic || proxy.wideNode == UINT32_MAX) {
+                continue;
+            }
+            WideNode& wide = dynamicWide_[proxy.wideNode];
+            wide.minX[proxy.wideSlot] = proxy.bounds.min.x;
+            wide.minY[proxy.wideSlot] = proxy.bounds.min.y;
+            wide.minZ[proxy.wideSlot] = proxy.bounds.min.z;
+            wide.maxX[proxy.wideSlot] = proxy.bounds.max.x;
+            wide.maxY[proxy.wideSlot] = proxy.bounds.max.y;
+            wide.maxZ[proxy.wideSlot] = proxy.bounds.max.z;
+        }
+        movedProxies_.clear();
+        dynamicDirty_ = false;
+    }
+    stats_.proxyCount = GetProxyCount();
+    stats_.staticProxyCount = staticCount_;
+    stats_.staticNodeCount = static_cast<uint32_t>(staticWide_.size());
+    stats_.dynamicNodeCount = static_cast<uint32_t>(dynamicWide_.size() - freeDynamicWide_.size());
+    stats_.reinsertCount = reinsertCount_;
+    stats_.rotationCount = rotationCount_;
+    reinsertCount_ = 0;
+    rotationCount_ = 0;
+}
+
+void DynamicBvh::QueryOverlap(const Aabb& bounds, std::vector<uint32_t>& results) const {
+    assert(!staticDirty_ && !dynamicDirty_ && "call Update before querying");
+    Float4 queryMinX = Splat4(bounds.min.x);
+    Float4 queryMinY = Splat4(bounds.min.y);
+    Float4 queryMinZ = Splat4(bounds.min.z);
+    Float4 queryMaxX = Splat4(bounds.max.x);
+    Float4 queryMaxY = Splat4(bounds.max.y);
+    Float4 queryMaxZ = Splat4(bounds.max.z);
+    std::vector<uint32_t> stack;
+    for (const WideTree& tree : { WideTree{ &staticWide_, staticWideRoot_ }, WideTree{ &dynamicWide_, dynamicWideRoot_ } }) {
+        if (tree.root == UINT32_MAX) {
+            continue;
+        }
+        stack.push_back(tree.root);
+        while (!stack.empty()) {
+            const WideNode& node = (*tree.nodes)[stack.back()];
+            stack.pop_back();
+            uint32_t mask = LessEqual4(Load4(node.minX), queryMaxX) & LessEqual4(queryMinX, Load4(node.maxX)) &
+                LessEqual4(Load4(node.minY), queryMaxY) & LessEqual4(queryMinY, Load4(node.maxY)) & LessEqual4(Load4(node.minZ), queryMaxZ) &
+                LessEqual4(queryMinZ, Load4(node.maxZ));
+            mask &= (1u << node.childCount) - 1;
+            for (uint32_t i = 0; i < node.childCount; ++i) {
+                if ((mask & (1u << i)) == 0) {
+                    continue;
+                }
+                uint32_t child = node.children[i];
+                if (child & kLeafFlag) {
+                    results.push_back(child & ~kLeafFlag);
+                } else {
+                    stack.push_back(child);
+                }
+            }
+        }
+    }
+}
+
+void DynamicBvh::QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& results) const {
+    assert(!staticDirty_ && !dynamicDirty_ && "call Update before querying");
+    // 節点ごとに、まだ調べる必要のある平面のビットを持つ (全体が内側にある平面は子孫では調べない)
+    struct Entry {
+        uint32_t node;
+        uint32_t planeMask;
+    };
+    std::vector<Entry> stack;
+    for (const WideTree& tree : { WideTree{ &staticWide_, staticWideRoot_ }, WideTree{ &dynamicWide_, dynamicWideRoot_ } }) {
+        if (tree.root == UINT32_MAX) {
+            continue;
+        }
+        stack.push_back(Entry{ tree.root, 0x3F });
+        while (!stack.empty()) {
+            Entry entry = stack.back();
+            stack.pop_back();
+            const WideNode& node = (*tree.nodes)[entry.node];
+            uint32_t visible = (1u << node.childCount) - 1;
+            uint32_t childPlaneMasks[4] = { entry.planeMask, entry.planeMask, entry.planeMask, entry.planeMask };
+            Float4 zero = Splat4(0.0f);
+            for (uint32_t p = 0; p < 6 && visible != 0; ++p) {
+                if ((entry.planeMask & (1u << p)) == 0) {
+                    continue;
+                }
+                const Vector4& plane = frustum.planes[p];
+                // 平面の法線の向きに一番遠い角 (これが外側なら全体が外側) と一番手前の角 (これが内側なら全体が内側)
+                Float4 farX = Load4(plane.x > 0.0f ? node.maxX : node.minX);
+                Float4 farY = Load4(plane.y > 0.0f ? node.maxY : node.minY);
+                Float4 farZ = Load4(plane.z > 0.0f ? node.maxZ : node.minZ);
+                Float4 nearX = Load4(plane.x > 0.0f ? node.minX : node.maxX);
+                Float4 nearY = Load4(plane.y > 0.0f ? node.minY : node.maxY);
+                Float4 nearZ = Load4(plane.z > 0.0f ? node.minZ : node.maxZ);
+                Float4 a = Splat4(plane.x);
+                Float4 b = Splat4(plane.y);
+                Float4 c = Splat4(plane.z);
+                Float4 d = Splat4(plane.w);
+                Float4 farDistance = Add4(Add4(Add4(Mul4(a, farX), Mul4(b, farY)), Mul4(c, farZ)), d);
+                Float4 nearDistance = Add4(Add4(Add4(Mul4(a, nearX), Mul4(b, nearY)), Mul4(c, nearZ)), d);
+                visible &= LessEqual4(zero, farDistance);
+                uint32_t inside = LessEqual4(zero, nearDistance);
+                for (uint32_t i = 0; i < 4; ++i) {
+                    if (inside & (1u << i)) {
+                        childPlaneMasks[i] &= ~(1u << p);
+                    }
+                }
+            }
+            for (uint32_t i = 0; i < node.childCount; ++i) {
+                if ((visible & (1u << i)) == 0) {
+                    continue;
+                }
+                uint32_t child = node.children[i];
+                if (child & kLeafFlag) {
+                    results.push_back(child & ~kLeafFlag);
+                } else {
+                    stack.push_back(Entry{ child, childPlaneMasks[i] });
+                }
+            }
+        }
+    }
+}
+
+bool DynamicBvh::RayCast(const Ray& ray, float maxDistance, BvhRayHit* hit) const {
+    return RayCast(ray, maxDistance, hit, nullptr, nullptr);
+}
+
+bool DynamicBvh::RayCast(const Ray& ray, float maxDistance, BvhRayHit* hit, RayTestFunction test, const void* context) const {
+    assert(!staticDirty_ && !dynamicDirty_ && "call Update before querying");
+    Float4 originX = Splat4(ray.origin.x);
+    Float4 originY = Splat4(ray.origin.y);
+    Float4 originZ = Splat4(ray.origin.z);
+    Float4 inverseX = Splat4(SafeInverse(ray.direction.x));
+    Float4 inverseY = Splat4(SafeInverse(ray.direction.y));
+    Float4 inverseZ = Splat4(SafeInverse(ray.direction.z));
+    Float4 zero = Splat4(0.0f);
+    float closest = maxDistance;
+    uint32_t closestProxy = UINT32_MAX;
+
+    // 近い子から調べるように、遠い子から積む
+    struct Entry {
+        uint32_t node;
+        float distance;
+    };
+    std::vector<Entry> stack;
+    for (const WideTree& tree : { WideTree{ &staticWide_, staticWideRoot_ }, WideTree{ &dynamicWide_, dynamicWideRoot_ } }) {
+        if (tree.root == UINT32_MAX) {
+            continue;
+        }
+        stack.push_back(Entry{ tree.root, 0.0f });
+        while (!stack.empty()) {
+            Entry entry = stack.back();
+            stack.pop_back();
+            if (entry.distance > closest) {
+                continue;
+            }
+            const WideNode& node = (*tree.nodes)[entry.node];
+            Float4 x1 = Mul4(Sub4(Load4(node.minX), originX), inverseX);
+            Float4 x2 = Mul4(Sub4(Load4(node.maxX), originX), inverseX);
+            Float4 y1 = Mul4(Sub4(Load4(node.minY), originY), inverseY);
+            Float4 y2 = Mul4(Sub4(Load4(node.maxY), originY), inverseY);
+            Float4 z1 = Mul4(Sub4(Load4(node.minZ), originZ), inverseZ);
+            Float4 z2 = Mul4(Sub4(Load4(node.maxZ), originZ), inverseZ);
+            Float4 enter = Max4(Max4(Max4(Min4(x1, x2), Min4(y1, y2)), Min4(z1, z2)), zero);
+            Float4 exit = Min4(Min4(Min4(Max4(x1, x2), Max4(y1, y2)), Max4(z1, z2)), Splat4(closest));
+            uint32_t mask = LessEqual4(enter, exit) & ((1u << node.childCount) - 1);
+            if (mask == 0) {
+                continue;
+            }
+            alignas(16) float distances[4];
+            Store4(distances, enter);
+            // 当たった子を遠い順に並べる (4つまでなので挿入で並べる)
+            uint32_t order[4];
+            uint32_t count = 0;
+            for (uint32_t i = 0; i < node.childCount; ++i) {
+                if ((mask & (1u << i)) == 0) {
+                    continue;
+                }
+                uint32_t k = count++;
+                for (; k > 0 && distances[order[k - 1]] < distances[i]; --k) {
+                    order[k] = order[k - 1];
+                }
+                order[k] = i;
+            }
+            for (uint32_t k = 0; k < count; ++k) {
+                uint32_t i = order[k];
+                uint32_t child = node.children[i];
+                if ((child & kLeafFlag) == 0) {
+                    stack.push_back(Entry{ child, distances[i] });
+                    continue;
+                }
+                uint32_t proxy = child & ~kLeafFlag;
+                float distance = distances[i];
+                if (test != nullptr) {
+                    distance = test(context, proxy, ray, closest);
+                    if (distance < 0.0f || distance > closest) {
+                        continue;
+                    }
+                }
+                if (distance < closest || closestProxy == UINT32_MAX) {
+                    closest = distance;
+                    closestProxy = proxy;
+                }
+            }
+        }
+    }
+    if (closestProxy == UINT32_MAX) {
+        return false;
+    }
+    if (hit != nullptr) {
+        hit->proxy = closestProxy;
+        hit->distance = closest;
+    }
+    return true;
+}
+
+void DynamicBvh::QueryNearest(const Vector3& point, uint32_t count, std::vector<BvhNeighbor>& results) const {
+    assert(!staticDirty_ && !dynamicDirty_ && "call Update before querying");
+    results.clear();
+    if (count == 0) {
+        return;
+    }
+    Float4 pointX = Splat4(point.x);
+    Float4 pointY = Splat4(point.y);
+    Float4 pointZ = Splat4(point.z);
+    Float4 zero = Splat4(0.0f);
+
+    // 近い節点から調べる (節点の番号の上のビットでどちらの木かを表す)
+    struct Entry {
+        float distanceSquared;
+        uint32_t node;
+        bool operator<(const Entry& other) const { return distanceSquared > other.distanceSquared; }
+    };
+    const uint32_t kDynamicFlag = 0x80000000u;
+    std::priority_queue<Entry> queue;
+    if (staticWideRoot_ != UINT32_MAX) {
+        queue.push(Entry{ 0.0f, staticWideRoot_ });
+    }
+    if (dynamicWideRoot_ != UINT32_MAX) {
+        queue.push(Entry{ 0.0f, dynamicWideRoot_ | kDynamicFlag });
+    }
+    // 見つけた中で近い count 個 (一番遠いものが先頭のヒープ)
+    auto farther = [](const BvhNeighbor& a, const BvhNeighbor& b) { return a.distanceSquared < b.distanceSquared; };
+    while (!queue.empty()) {
+        Entry entry = queue.top();
+        queue.pop();
+        if (results.size() == count && entry.distanceSquared >= results.front().distanceSquared) {
+            break;
+        }
+        const std::vector<WideNode>& tree = (entry.node & kDynamicFlag) ? dynamicWide_ : staticWide_;
+        const WideNode& node = tree[entry.node & ~kDynamicFlag];
+        Float4 dx = Max4(Max4(Sub4(Load4(node.minX), pointX), Sub4(pointX, Load4(node.maxX))), zero);
+        Float4 dy = Max4(Max4(Sub4(Load4(node.minY), pointY), Sub4(pointY, Load4(node.maxY))), zero);
+        Float4 dz = Max4(Max4(Sub4(Load4(node.minZ), pointZ), Sub4(pointZ, Load4(node.maxZ))), zero);
+        alignas(16) float distances[4];
+        Store4(distances, Add4(Add4(Mul4(dx, dx), Mul4(dy, dy)), Mul4(dz, dz)));
+        for (uint32_t i = 0; i < node.childCount; ++i) {
+            float distanceSquared = distances[i];
+            if (results.size() == count && distanceSquared >= results.front().distanceSquared) {
+                continue;
+            }
+            uint32_t child = node.children[i];
+            if (child & kLeafFlag) {
+                if (results.size() == count) {
+                    std::pop_heap(results.begin(), results.end(), farther);
+                    results.pop_back();
+                }
+                results.push_back(BvhNeighbor{ child & ~kLeafFlag, distanceSquared });
+                std::push_heap(results.begin(), results.end(), farther);
+            } else {
+                queue.push(Entry{ distanceSquared, child | (entry.node & kDynamicFlag) });
+            }
+        }
+    }
+    std::sort_heap(results.begin(), results.end(), farther);
+}
+
+uint32_t DynamicBvh::AllocateNode() {
+    if (!freeNodes_.empty()) {
+        uint32_t node = freeNodes_.back();
+        freeNodes_.pop_back();
+        nodes_[node] = TreeNode();
+        return node;
+    }
+    nodes_.emplace_back();
+    return static_cast<uint32_t>(nodes_.size() - 1);
+}
+
+void DynamicBvh::FreeNode(uint32_t node) {
+    Invalidate(node);
+    nodes_[node] = TreeNode();
+    freeNodes_.push_back(node);
+}
+
+void DynamicBvh::InsertLeaf(uint32_t leaf) {
+    if (root_ == UINT32_MAX) {
+        root_ = leaf;
+        nodes_[leaf].parent = UINT32_MAX;
+        return;
+    }
+    // 兄弟にする節点を探す (親になる節点の表面積と、祖先が広がる分の合計が小さくなる方へ下る)
+    Aabb leafBounds = nodes_[leaf].bounds;
+    uint32_t sibling = root_;
+    while (nodes_[sibling].proxy == UINT32_MAX) {
+        const TreeNode& node = nodes_[sibling];
+        float area = Area(node.bounds);
+        float combinedArea = Area(Union(node.bounds, leafBounds));
+        // ここを兄弟にする費用と、下に進むときに祖先が広がる分
+        float cost = 2.0f * combinedArea;
+        float inheritance = 2.0f * (combinedArea - area);
+        auto childCost = [&](uint32_t child) {
+            const TreeNode& childNode = nodes_[child];
+            float unionArea = Area(Union(childNode.bounds, leafBounds));
+            return childNode.proxy != UINT32_MAX ? unionArea + inheritance : unionArea - Area(childNode.bounds) + inheritance;
+        };
+        float cost1 = childCost(node.child1);
+        float cost2 = childCost(node.child2);
+        if (cost < cost1 && cost < cost2) {
+            break;
+        }
+        sibling = cost1 < cost2 ? node.child1 : node.child2;
+    }
+
+    // 根だった葉の写しは使わなくなる
+    if (nodes_[sibling].proxy != UINT32_MAX) {
+        Invalidate(sibling);
+    }
+    uint32_t oldParent = nodes_[sibling].parent;
+    uint32_t newParent = AllocateNode();
+    TreeNode& parent = nodes_[newParent];
+    parent.parent = oldParent;
+    parent.bounds = Union(nodes_[sibling].bounds, leafBounds);
+    parent.child1 = sibling;
+    parent.child2 = leaf;
+    nodes_[sibling].parent = newParent;
+    nodes_[leaf].parent = newParent;
+    if (oldParent == UINT32_MAX) {
+        root_ = newParent;
+    } else if (nodes_[oldParent].child1 == sibling) {
+        nodes_[oldParent].child1 = newParent;
+    } else {
+        nodes_[oldParent].child2 = newParent;
+    }
+    Refit(oldParent);
+}
+
+void DynamicBvh::RemoveLeaf(uint32_t leaf) {
+    Invalidate(leaf);
+    if (leaf == root_) {
+        root_ = UINT32_MAX;
+        return;
+    }
+    uint32_t parent = nodes_[leaf].parent;
+    uint32_t grandParent = nodes_[parent].parent;
+    uint32_t sibling = nodes_[parent].child1 == leaf ? nodes_[parent].child2 : nodes_[parent].child1;
+    nodes_[sibling].parent = grandParent;
+    if (grandParent == UINT32_MAX) {
+        root_ = sibling;
+    } else if (nodes_[grandParent].child1 == parent) {
+        nodes_[grandParent].child1 = sibling;
+    } else {
+        nodes_[grandParent].child2 = sibling;
+    }
+    FreeNode(parent);
+    nodes_[leaf].parent = UINT32_MAX;
+    Refit(grandParent);
+}
+
+void DynamicBvh::Refit(uint32_t node) {
+    while (node != UINT32_MAX) {
+        TreeNode& current = nodes_[node];
+        current.bounds = Union(nodes_[current.child1].bounds, nodes_[current.child2].bounds);
+        Invalidate(node);
+        Rotate(node);
+        node = current.parent;
+    }
+}
+
+void DynamicBvh::Invalidate(uint32_t node) {
+    // 祖先は Refit でたどるので、祖先の写しも捨てられる (捨てた写しを参照する写しは残らない)
+    uint32_t& wide = nodes_[node].wide;
+    if (wide != UINT32_MAX) {
+        freeDynamicWide_.push_back(wide);
+        wide = UINT32_MAX;
+    }
+}
+
+void DynamicBvh::Rotate(uint32_t a) {
+    // 子 B, C と孫を入れ替えて、変わる節点の表面積が減るなら入れ替える
+    // B と C の子 C1 を入れ替えると C は B と C2 を囲む (A と他の節点の AABB は変わらない)
+    TreeNode& nodeA = nodes_[a];
+    uint32_t b = nodeA.child1;
+    uint32_t c = nodeA.child2;
+    TreeNode& nodeB = nodes_[b];
+    TreeNode& nodeC = nodes_[c];
+    bool bIsLeaf = nodeB.proxy != UINT32_MAX;
+    bool cIsLeaf = nodeC.proxy != UINT32_MAX;
+    if (bIsLeaf && cIsLeaf) {
+        return;
+    }
+    enum class Rotation { kNone, kBC1, kBC2, kCB1, kCB2 };
+    Rotation best = Rotation::kNone;
+    float bestDelta = 0.0f;
+    if (!cIsLeaf) {
+        float areaC = Area(nodeC.bounds);
+        float delta = Area(Union(nodeB.bounds, nodes_[nodeC.child2].bounds)) - areaC;
+        if (delta < bestDelta) {
+            best = Rotation::kBC1;
+            bestDelta = delta;
+        }
+        delta = Area(Union(nodeB.bounds, nodes_[nodeC.child1].bounds)) - areaC;
+        if (delta < bestDelta) {
+            best = Rotation::kBC2;
+            bestDelta = delta;
+        }
+    }
+    if (!bIsLeaf) {
+        float areaB = Area(nodeB.bounds);
+        float delta = Area(Union(nodeC.bounds, nodes_[nodeB.child2].bounds)) - areaB;
+        if (delta < bestDelta) {
+            best = Rotation::kCB1;
+            bestDelta = delta;
+        }
+        delta = Area(Union(nodeC.bounds, nodes_[nodeB.child1].bounds)) - areaB;
+        if (delta < bestDelta) {
+            best = Rotation::kCB2;
+            bestDelta = delta;
+        }
+    }
+    // outer を inner の子 (grandChild の場所) と入れ替える
+    auto swap = [this, a](uint32_t outer, uint32_t inner, bool first) {
+        TreeNode& innerNode = nodes_[inner];
+        uint32_t grandChild = first ? innerNode.child1 : innerNode.child2;
+        uint32_t other = first ? innerNode.child2 : innerNode.child1;
+        TreeNode& parent = nodes_[a];
+        if (parent.child1 == outer) {
+            parent.child1 = grandChild;
+        } else {
+            parent.child2 = grandChild;
+        }
+        nodes_[grandChild].parent = a;
+        if (first) {
+            innerNode.child1 = outer;
+        } else {
+            innerNode.child2 = outer;
+        }
+        nodes_[outer].parent = inner;
+        innerNode.bounds = Union(nodes_[outer].bounds, nodes_[other].bounds);
+        Invalidate(inner);
+    };
+    switch (best) {
+    case Rotation::kNone:
+        return;
+    case Rotation::kBC1:
+        swap(b, c, true);
+        break;
+    case Rotation::kBC2:
+        swap(b, c, false);
+        break;
+    case Rotation::kCB1:
+        swap(c, b, true);
+        break;
+    case Rotation::kCB2:
+        swap(c, b, false);
+        break;
+    }
+    ++rotationCount_;
+}
+
+void DynamicBvh::BuildStatic() {
+    staticNodes_.clear();
+    staticRoot_ = UINT32_MAX;
+    if (staticCount_ == 0) {
+        return;
+    }
+    // 動かないプロキシの葉を先に作る
+    std::vector<uint32_t> leaves;
+    leaves.reserve(staticCount_);
+    staticNodes_.reserve(size_t(staticCount_) * 2);
+    for (uint32_t id = 0; id < proxies_.size(); ++id) {
+        const Proxy& proxy = proxies_[id];
+        if (proxy.alive && proxy.isStatic) {
+            leaves.push_back(static_cast<uint32_t>(staticNodes_.size()));
+            staticNodes_.emplace_back();
+            staticNodes_.back().proxy = id;
+            staticNodes_.back().bounds = proxy.bounds;
+        }
+    }
+    std::vector<uint32_t> freeNodes;
+    staticRoot_ = BuildTopDown(staticNodes_, freeNodes, leaves);
+}
+
+void DynamicBvh::InsertPending() {
+    std::vector<uint32_t> leaves;
+    for (uint32_t id : pendingProxies_) {
+        // 作ってから破棄したもの・同じ番号で作り直して2回入っているものは pending が落ちている
+        Proxy& proxy = proxies_[id];
+        if (proxy.alive && proxy.pending) {
+            proxy.pending = false;
+            leaves.push_back(proxy.leaf);
+        }
+    }
+    pendingProxies_.clear();
+    if (leaves.empty()) {
+        return;
+    }
+    if (leaves.size() < dynamicLeafCount_) {
+        for (uint32_t leaf : leaves) {
+            InsertLeaf(leaf);
+        }
+        dynamicLeafCount_ += static_cast<uint32_t>(leaves.size());
+        return;
+    }
+
+    // 木にあるもの以上の数を入れるときは (最初の読み込み)、木にある葉も合わせて上から作り直す
+    // 1つずつ挿入すると1回ごとに根から下って祖先を直すので遅く、入れる順によっては木も悪くなる
+    std::vector<uint32_t> stack;
+    if (root_ != UINT32_MAX) {
+        stack.push_back(root_);
+    }
+    while (!stack.empty()) {
+        uint32_t node = stack.back();
+        stack.pop_back();
+        TreeNode& current = nodes_[node];
+        if (current.proxy != UINT32_MAX) {
+            leaves.push_back(node);
+            continue;
+        }
+        stack.push_back(current.child1);
+        stack.push_back(current.child2);
+        current = TreeNode();
+        freeNodes_.push_back(node);
+    }
+    // 写しは全て作り直す
+    dynamicWide_.clear();
+    freeDynamicWide_.clear();
+    for (uint32_t leaf : leaves) {
+        nodes_[leaf].parent = UINT32_MAX;
+        nodes_[leaf].wide = UINT32_MAX;
+    }
+    root_ = BuildTopDown(nodes_, freeNodes_, leaves);
+    dynamicLeafCount_ = static_cast<uint32_t>(leaves.size());
+    stats_.dynamicRebuilt = true;
+}
+
+uint32_t DynamicBvh::BuildTopDown(std::vector<TreeNode>& nodes, std::vector<uint32_t>& freeNodes, std::vector<uint32_t>& leaves) {
+    if (leaves.empty()) {
+        return UINT32_MAX;
+    }
+    // 葉の AABB と中心を並べて持ち、範囲ごとに並べ替える (節点を番号で引くと、葉が多いときに飛び飛びに読むことになって遅い)
+    struct Item {
+        Aabb bounds;
+        Vector3 center;
+        uint32_t node;
+    };
+    std::vector<Item> items(leaves.size());
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        const Aabb& bounds = nodes[leaves[i]].bounds;
+        items[i].bounds = bounds;
+        items[i].center = { (bounds.min.x + bounds.max.x) * 0.5f, (bounds.min.y + bounds.max.y) * 0.5f, (bounds.min.z + bounds.max.z) * 0.5f };
+        items[i].node = leaves[i];
+    }
+    auto allocate = [&nodes, &freeNodes]() {
+        if (!freeNodes.empty()) {
+            uint32_t node = freeNodes.back();
+            freeNodes.pop_back();
+            nodes[node] = TreeNode();
+            return node;
+        }
+        nodes.emplace_back();
+        return static_cast<uint32_t>(nodes.size() - 1);
+    };
+
+    // 範囲の AABB と中心の AABB
+    auto boundsOf = [&items](uint32_t begin, uint32_t end, Aabb& bounds, Aabb& centerBounds) {
+        bounds = kEmptyBounds;
+        centerBounds = kEmptyBounds;
+        for (uint32_t i = begin; i < end; ++i) {
+            bounds = Union(bounds, items[i].bounds);
+            centerBounds = Union(centerBounds, Aabb{ items[i].center, items[i].center });
+        }
+    };
+
+    // 範囲 [begin, end) の葉をまとめた節点を作り、parent の子にする (子の範囲は積んで後で作る)
+    // 範囲の AABB は親で分けたときの区間から求めておく (範囲を読み直さない)
+    struct Task {
+        uint32_t parent;
+        uint32_t begin;
+        uint32_t end;
+        bool first; // parent の child1 にする
+        Aabb bounds;
+        Aabb centerBounds;
+    };
+    uint32_t root = UINT32_MAX;
+    std::vector<Task> tasks;
+    Task rootTask = { UINT32_MAX, 0, static_cast<uint32_t>(leaves.size()), true, kEmptyBounds, kEmptyBounds };
+    boundsOf(rootTask.begin, rootTask.end, rootTask.bounds, rootTask.centerBounds);
+    tasks.push_back(rootTask);
+    while (!tasks.empty()) {
+        Task task = tasks.back();
+        tasks.pop_back();
+        uint32_t node = task.end - task.begin == 1 ? items[task.begin].node : allocate();
+        nodes[node].parent = task.parent;
+        if (task.parent == UINT32_MAX) {
+            root = node;
+        } else if (task.first) {
+            nodes[task.parent].child1 = node;
+        } else {
+            nodes[task.parent].child2 = node;
+        }
+        if (task.end - task.begin == 1) {
+            continue;
+        }
+        nodes[node].bounds = task.bounds;
+        if (task.end - task.begin == 2) {
+            // 葉が2つなら分け方は1つしかない (節点の半分ほどはこれなので、区間に分けずに済ませる)
+            tasks.push_back(Task{ node, task.begin, task.begin + 1, true, kEmptyBounds, kEmptyBounds });
+            tasks.push_back(Task{ node, task.begin + 1, task.end, false, kEmptyBounds, kEmptyBounds });
+            continue;
+        }
+        const Aabb& centerBounds = task.centerBounds;
+
+        // 中心の広がりが一番大きい軸を区間に分け、左右の (表面積 x 数) の合計が一番小さい境目で分ける
+        Vector3 extent = { centerBounds.max.x - centerBounds.min.x, centerBounds.max.y - centerBounds.min.y,
+            centerBounds.max.z - centerBounds.min.z };
+        uint32_t axis = extent.x > extent.y ? (extent.x > extent.z ? 0 : 2) : (extent.y > extent.z ? 1 : 2);
+        float axisMin = Axis(centerBounds.min, axis);
+        float axisExtent = Axis(extent, axis);
+        uint32_t middle = task.begin + (task.end - task.begin) / 2;
+        Task child1 = { node, task.begin, middle, true, kEmptyBounds, kEmptyBounds };
+        Task child2 = { node, middle, task.end, false, kEmptyBounds, kEmptyBounds };
+        bool split = false;
+        if (axisExtent > 0.0f) {
+            Aabb binBounds[kSahBinCount];
+            Aabb binCenterBounds[kSahBinCount];
+            uint32_t binCounts[kSahBinCount] = {};
+            std::fill(binBounds, binBounds + kSahBinCount, kEmptyBounds);
+            std::fill(binCenterBounds, binCenterBounds + kSahBinCount, kEmptyBounds);
+            float scale = float(kSahBinCount) / axisExtent;
+            auto binOf = [&](const Item& item) {
+                uint32_t bin = static_cast<uint32_t>((Axis(item.center, axis) - axisMin) * scale);
+                return bin < kSahBinCount ? bin : kSahBinCount - 1;
+            };
+            for (uint32_t i = task.begin; i < task.end; ++i) {
+                uint32_t bin = binOf(items[i]);
+                ++binCounts[bin];
+                binBounds[bin] = Union(binBounds[bin], items[i].bounds);
+                binCenterBounds[bin] = Union(binCenterBounds[bin], Aabb{ items[i].center, items[i].center });
+            }
+            // 右から累積した費用
+            float rightCosts[kSahBinCount] = {};
+            Aabb right = kEmptyBounds;
+            uint32_t rightCount = 0;
+            for (uint32_t bin = kSahBinCount - 1; bin > 0; --bin) {
+                right = Union(right, binBounds[bin]);
+                rightCount += binCounts[bin];
+                rightCosts[bin] = rightCount > 0 ? Area(right) * float(rightCount) : 0.0f;
+            }
+            Aabb left = kEmptyBounds;
+            uint32_t leftCount = 0;
+            float bestCost = FLT_MAX;
+            uint32_t bestSplit = 0;
+            for (uint32_t split = 1; split < kSahBinCount; ++split) {
+                left = Union(left, binBounds[split - 1]);
+                leftCount += binCounts[split - 1];
+                float cost = (leftCount > 0 ? Area(left) * float(leftCount) : 0.0f) + rightCosts[split];
+                if (leftCount > 0 && leftCount < task.end - task.begin && cost < bestCost) {
+                    bestCost = cost;
+                    bestSplit = split;
+                }
+            }
+            if (bestSplit != 0) {
+                Item* end = std::partition(items.data() + task.begin, items.data() + task.end,
+                    [&](const Item& item) { return binOf(item) < bestSplit; });
+                middle = static_cast<uint32_t>(end - items.data());
+                child1 = { node, task.begin, middle, true, kEmptyBounds, kEmptyBounds };
+                child2 = { node, middle, task.end, false, kEmptyBounds, kEmptyBounds };
+                for (uint32_t bin = 0; bin < kSahBinCount; ++bin) {
+                    Task& child = bin < bestSplit ? child1 : child2;
+                    child.bounds = Union(child.bounds, binBounds[bin]);
+                    child.centerBounds = Union(child.centerBounds, binCenterBounds[bin]);
+                }
+                split = true;
+            }
+        }
+        if (!split) {
+            // 中心が重なっていて分けられないときは数で半分にする
+            boundsOf(child1.begin, child1.end, child1.bounds, child1.centerBounds);
+            boundsOf(child2.begin, child2.end, child2.bounds, child2.centerBounds);
+        }
+        tasks.push_back(child1);
+        tasks.push_back(child2);
+    }
+    return root;
+}
+
+uint32_t DynamicBvh::Collapse(std::vector<TreeNode>& nodes, uint32_t root, std::vector<WideNode>& wideNodes, std::vector<uint32_t>& freeWideNodes) {
+    if (root == UINT32_MAX) {
+        return UINT32_MAX;
+    }
+    if (nodes[root].wide != UINT32_MAX) {
+        return nodes[root].wide;
+    }
+    auto allocate = [&wideNodes, &freeWideNodes]() {
+        if (!freeWideNodes.empty()) {
+            uint32_t index = freeWideNodes.back();
+            freeWideNodes.pop_back();
+            return index;
+        }
+        wideNodes.emplace_back();
+        return static_cast<uint32_t>(wideNodes.size() - 1);
+    };
+    // 2分木の節点から、表面積の大きい内側の節点を子2つに開いて、子を4つまで集める
+    // 写しの残っている子の部分木はそのまま使う
+    std::vector<uint32_t> tasks;
+    nodes[root].wide = allocate();
+    tasks.push_back(root);
+    while (!tasks.empty()) {
+        uint32_t sourceIndex = tasks.back();
+        tasks.pop_back();
+        uint32_t slots[4];
+        uint32_t slotCount = 0;
+        const TreeNode& source = nodes[sourceIndex];
+        if (source.proxy != UINT32_MAX) {
+            slots[slotCount++] = sourceIndex;
+        } else {
+            slots[slotCount++] = source.child1;
+            slots[slotCount++] = source.child2;
+        }
+        while (slotCount < 4) {
+            uint32_t widest = UINT32_MAX;
+            float widestArea = -1.0f;
+            for (uint32_t i = 0; i < slotCount; ++i) {
+                const TreeNode& candidate = nodes[slots[i]];
+                if (candidate.proxy == UINT32_MAX && Area(candidate.bounds) > widestArea) {
+                    widest = i;
+                    widestArea = Area(candidate.bounds);
+                }
+            }
+            if (widest == UINT32_MAX) {
+                break;
+            }
+            // 開いた節点の写しは使わなくなる (残すと、後でまた使ったときに葉の位置が古くなっている)
+            TreeNode& opened = nodes[slots[widest]];
+            if (opened.wide != UINT32_MAX) {
+                freeWideNodes.push_back(opened.wide);
+                opened.wide = UINT32_MAX;
+            }
+            slots[widest] = opened.child1;
+            slots[slotCount++] = opened.child2;
+        }
+
+        uint32_t wideIndex = nodes[sourceIndex].wide;
+        WideNode wide = {};
+        wide.childCount = slotCount;
+        for (uint32_t i = 0; i < 4; ++i) {
+            // 空きは決して重ならない AABB にしておく (ビットでも除くが、計算に NaN が出ないように)
+            Aabb bounds = kEmptyBounds;
+            if (i < slotCount) {
+                TreeNode& child = nodes[slots[i]];
+                if (child.proxy != UINT32_MAX) {
+                    // 葉は余白の無い AABB (問い合わせの結果を正確にする)
+                    Proxy& proxy = proxies_[child.proxy];
+                    bounds = proxy.bounds;
+                    proxy.wideNode = wideIndex;
+                    proxy.wideSlot = i;
+                    wide.children[i] = child.proxy | kLeafFlag;
+                } else {
+                    bounds = child.bounds;
+                    if (child.wide == UINT32_MAX) {
+                        child.wide = allocate();
+                        tasks.push_back(slots[i]);
+                    }
+                    wide.children[i] = child.wide;
+                }
+            } else {
+                wide.children[i] = UINT32_MAX;
+            }
+            wide.minX[i] = bounds.min.x;
+            wide.minY[i] = bounds.min.y;
+            wide.minZ[i] = bounds.min.z;
+            wide.maxX[i] = bounds.max.x;
+            wide.maxY[i] = bounds.max.y;
+            wide.maxZ[i] = bounds.max.z;
+        }
+        wideNodes[wideIndex] = wide;
+    }
+    return nodes[root].wide;
+}
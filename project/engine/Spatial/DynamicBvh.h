@@ -0,0 +1,192 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "MathTypes.h"
+
+// 軸に平行な箱
+struct Aabb {
+    Vector3 min;
+    Vector3 max;
+};
+
+// 光線 (距離は direction の長さを単位にする)
+struct Ray {
+    Vector3 origin;
+    Vector3 direction;
+};
+
+// 視錐台の6つの平面 (x * p.x + y * p.y + z * p.z + p.w >= 0 が内側)
+struct Frustum {
+    Vector4 planes[6];
+};
+
+// ビュー・プロジェクション行列 (行ベクトルに右から掛ける。深度は 0 から 1) の視錐台
+Frustum MakeFrustum(const Matrix4x4& viewProjection);
+
+// 光線が当たったプロキシ
+struct BvhRayHit {
+    uint32_t proxy = UINT32_MAX;
+    float distance = 0.0f;
+};
+
+// 近いプロキシ (距離は点から AABB までの距離の2乗。AABB の中なら 0)
+struct BvhNeighbor {
+    uint32_t proxy = UINT32_MAX;
+    float distanceSquared = 0.0f;
+};
+
+// AABB の BVH (視錐台・光線・重なり・近い順の問い合わせ)
+// 動かないプロキシは Update でまとめて SAH (表面積の見積もり) で作り直した木に入れる
+// 動くプロキシは余白を付けた AABB で2分木に入れ、余白からはみ出したときだけ入れ直す
+// 作ったプロキシは Update でまとめて入れる。木にあるものと同じ数以上なら (最初の読み込み)、動く木を SAH で上から作り直し、少なければ1つずつ挿入する
+// 挿入と削除の後は親の AABB を直しながら、表面積が減るときは孫と入れ替える (回転)
+// 問い合わせは2つの木を、子を4つずつ SoA に並べた節点に写したもの (Update で作る) をたどり、4つの子を SIMD でまとめて調べる
+// 動く木は、変わった節点から根までの写しだけを作り直す (余白の中で動いただけなら葉の AABB を書き換えるだけ)
+// 作成・破棄・移動の後は Update してから問い合わせる。問い合わせは const で、Update していなければ複数のスレッドから呼んでよい
+// プロキシの番号は破棄すると使い回す
+class DynamicBvh {
+public:
+    // 直前の Update の結果
+    struct Stats {
+        uint32_t proxyCount = 0;
+        uint32_t staticProxyCount = 0;
+        uint32_t staticNodeCount = 0;   // 動かない木の節点 (子が4つ) の数
+        uint32_t dynamicNodeCount = 0;  // 動く木の節点 (子が4つ) の数
+        uint32_t reinsertCount = 0;     // 前の Update から余白をはみ出して入れ直した数
+        uint32_t rotationCount = 0;     // 前の Update から回転した数
+        bool staticRebuilt = false;
+        bool dynamicRebuilt = false;    // 動く木をまとめて作り直したか
+    };
+
+public:
+    // margin は動くプロキシの AABB に付ける余白
+    explicit DynamicBvh(float margin = 0.1f);
+
+    // 作る (isStatic なら動かない木に入れる。動かしてもよいが、次の Update で動かない木を全て作り直す)
+    uint32_t CreateProxy(const Aabb& bounds, uint32_t userData, bool isStatic = false);
+    void DestroyProxy(uint32_t proxy);
+    // AABB を変える
+    void MoveProxy(uint32_t proxy, const Aabb& bounds);
+    // 全て破棄する
+    void Clear();
+
+    uint32_t GetUserData(uint32_t proxy) const;
+    const Aabb& GetBounds(uint32_t proxy) const;
+
+    // 動かない木を作り直し、問い合わせ用の節点を作る
+    void Update();
+
+    // bounds と重なるプロキシを results に足す
+    void QueryOverlap(const Aabb& bounds, std::vector<uint32_t>& results) const;
+    // 視錐台と重なる (かもしれない) プロキシを results に足す
+    void QueryFrustum(const Frustum& frustum, std::vector<uint32_t>& results) const;
+    // 光線が maxDistance までで最初に当たる AABB
+    bool RayCast(const Ray& ray, float maxDistance, BvhRayHit* hit) const;
+    // test(proxy, ray, maxDistance) で形との交差を確かめる (当たった距離を返す。外れたら負)
+    template <typename Function>
+    bool RayCast(const Ray& ray, float maxDistance, BvhRayHit* hit, const Function& test) const {
+        return RayCast(ray, maxDistance, hit,
+            [](const void* context, uint32_t proxy, const Ray& r, float distance) {
+                return (*static_cast<const Function*>(context))(proxy, r, distance);
+            },
+            &test);
+    }
+    // point に近い順に count 個 (results は近い順に置き換える)
+    void QueryNearest(const Vector3& point, uint32_t count, std::vector<BvhNeighbor>& results) const;
+
+    uint32_t GetProxyCount() const { return static_cast<uint32_t>(proxies_.size() - freeProxies_.size()); }
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    struct Proxy {
+        Aabb bounds;
+        uint32_t userData = 0;
+        uint32_t leaf = UINT32_MAX; // 動く木の葉
+        uint32_t wideNode = UINT32_MAX; // 問い合わせ用の節点と、その中の位置
+        uint32_t wideSlot = 0;
+        bool isStatic = false;
+        bool pending = false;       // 動く木にまだ入れていない (次の Update で入れる)
+        bool alive = false;
+    };
+
+    // 2分木の節点 (proxy が UINT32_MAX でなければ葉)
+    struct TreeNode {
+        Aabb bounds;
+        uint32_t parent = UINT32_MAX;
+        uint32_t child1 = UINT32_MAX;
+        uint32_t child2 = UINT32_MAX;
+        uint32_t proxy = UINT32_MAX;
+        uint32_t wide = UINT32_MAX; // この節点の部分木を写した問い合わせ用の節点 (葉は根のときだけ)
+    };
+
+    // 問い合わせ用の節点 (4つの子の AABB を軸ごとに並べる。子は kLeafFlag が立っていればプロキシ、でなければ節点)
+    struct alignas(16) WideNode {
+        float minX[4];
+        float minY[4];
+        float minZ[4];
+        float maxX[4];
+        float maxY[4];
+        float maxZ[4];
+        uint32_t children[4];
+        uint32_t childCount;
+    };
+
+    // 問い合わせでたどる木
+    struct WideTree {
+        const std::vector<WideNode>* nodes;
+        uint32_t root;
+    };
+
+    using RayTestFunction = float (*)(const void* context, uint32_t proxy, const Ray& ray, float maxDistance);
+    bool RayCast(const Ray& ray, float maxDistance, BvhRayHit* hit, RayTestFunction test, const void* context) const;
+
+    uint32_t AllocateNode();
+    void FreeNode(uint32_t node);
+    void InsertLeaf(uint32_t leaf);
+    void RemoveLeaf(uint32_t leaf);
+    // node から根まで AABB を直し、回転する
+    void Refit(uint32_t node);
+    void Rotate(uint32_t node);
+    // 部分木の変わった節点の写しを捨てる
+    void Invalidate(uint32_t node);
+    // 動かないプロキシから SAH で2分木を作る
+    void BuildStatic();
+    // 作ったプロキシを動く木に入れる (多ければ動く木を作り直す)
+    void InsertPending();
+    // 葉から SAH で上から2分木を作る。戻り値は根
+    uint32_t BuildTopDown(std::vector<TreeNode>& nodes, std::vector<uint32_t>& freeNodes, std::vector<uint32_t>& leaves);
+    // 2分木を子が4つの節点に写す (写しの無い節点だけ作る)。戻り値は根の写し
+    uint32_t Collapse(std::vector<TreeNode>& nodes, uint32_t root, std::vector<WideNode>& wideNodes, std::vector<uint32_t>& freeWideNodes);
+
+private:
+    static const uint32_t kLeafFlag = 0x80000000u;
+
+    float margin_ = 0.1f;
+    std::vector<Proxy> proxies_;
+    std::vector<uint32_t> freeProxies_;
+    uint32_t staticCount_ = 0;
+
+    // 動く木
+    std::vector<TreeNode> nodes_;
+    std::vector<uint32_t> freeNodes_;
+    uint32_t root_ = UINT32_MAX;
+    uint32_t dynamicLeafCount_ = 0;         // 動く木に入っている葉の数
+    std::vector<uint32_t> pendingProxies_;  // まだ動く木に入れていないプロキシ (破棄したもの・重複も含む)
+    // 動かない木 (Update で作り直す)
+    std::vector<TreeNode> staticNodes_;
+    uint32_t staticRoot_ = UINT32_MAX;
+
+    // 問い合わせ用
+    std::vector<WideNode> staticWide_;
+    std::vector<WideNode> dynamicWide_;
+    std::vector<uint32_t> freeDynamicWide_;
+    uint32_t staticWideRoot_ = UINT32_MAX;
+    uint32_t dynamicWideRoot_ = UINT32_MAX;
+    std::vector<uint32_t> movedProxies_; // 余白の中で動いた (葉の AABB を書き換える)
+    bool staticDirty_ = false;
+    bool dynamicDirty_ = false;
+
+    uint32_t reinsertCount_ = 0;
+    uint32_t rotationCount_ = 0;
+    Stats stats_;
+};
@@ -0,0 +1,78 @@
+#include "BitmapFont.h"
+#include <algorithm>
+#include <cassert>
+
+void BitmapFont::Initialize(const BitmapFontDesc& desc) {
+    assert(desc.columnCount > 0 && desc.firstCharacter <= desc.lastCharacter);
+    desc_ = desc;
+    // 文字の番号からUVを引く表を先に作っておく (文字列を作るときは表を引くだけにする)
+    float uScale = 1.0f / float(desc.textureWidth);
+    float vScale = 1.0f / float(desc.textureHeight);
+    for (uint32_t code = 0; code < 256; ++code) {
+        unsigned char character = static_cast<unsigned char>(code);
+        if (character < static_cast<unsigned char>(desc.firstCharacter) || character > static_cast<unsigned char>(desc.lastCharacter)) {
+            character = '?';
+        }
+        uint32_t index = character - static_cast<unsigned char>(desc.firstCharacter);
+        float left = float((index % desc.columnCount) * desc.glyphWidth);
+        float top = float((index / desc.columnCount) * desc.glyphHeight);
+        Glyph& glyph = glyphs_[code];
+        glyph.uvMin = { left * uScale, top * vScale };
+        glyph.uvMax = { (left + float(desc.glyphWidth)) * uScale, (top + float(desc.glyphHeight)) * vScale };
+        glyph.visible = code != ' ' && code != '\t';
+    }
+}
+
+uint32_t BitmapFont::BuildText(std::string_view text, float scale, std::vector<SpriteVertex>& vertices) const {
+    float width = float(desc_.glyphWidth) * scale;
+    float height = float(desc_.glyphHeight) * scale;
+    size_t start = vertices.size();
+    vertices.resize(start + text.size() * 4);
+    SpriteVertex* out = vertices.data() + start;
+
+    uint32_t quadCount = 0;
+    float x = 0.0f;
+    float y = 0.0f;
+    for (char character : text) {
+        if (character == '\n') {
+            x = 0.0f;
+            y += height;
+            continue;
+        }
+        const Glyph& glyph = glyphs_[static_cast<unsigned char>(character)];
+        if (glyph.visible) {
+            // 左上・右上・左下・右下 (SpriteBatch と同じ並び)
+            SpriteVertex* quad = out + size_t(quadCount) * 4;
+            quad[0] = { { x, y, 0.0f }, { glyph.uvMin.x, glyph.uvMin.y }, 0xFFFFFFFF };
+            quad[1] = { { x + width, y, 0.0f }, { glyph.uvMax.x, glyph.uvMin.y }, 0xFFFFFFFF };
+            quad[2] = { { x, y + height, 0.0f }, { glyph.uvMin.x, glyph.uvMax.y }, 0xFFFFFFFF };
+            quad[3] = { { x + width, y + height, 0.0f }, { glyph.uvMax.x, glyph.uvMax.y }, 0xFFFFFFFF };
+            ++quadCount;
+        }
+        x += width;
+    }
+    vertices.resize(start + size_t(quadCount) * 4);
+    return quadCount;
+}
+
+Vector2 BitmapFont::MeasureText(std::string_view text, float scale) const {
+    uint32_t columns = 0;
+    uint32_t maxColumns = 0;
+    uint32_t lines = text.empty() ? 0 : 1;
+    for (char character : text) {
+        if (character == '\n') {
+            columns = 0;
+            ++lines;
+            continue;
+        }
+        maxColumns = std::max(maxColumns, ++columns);
+    }
+    return { float(maxColumns * desc_.glyphWidth) * scale, float(lines * desc_.glyphHeight) * scale };
+}
+
+TextMesh BitmapFont::BuildTextMesh(std::string_view text, float scale) const {
+    TextMesh mesh;
+    mesh.quadCount = BuildText(text, scale, mesh.vertices);
+    mesh.size = MeasureText(text, scale);
+    return mesh;
+}
@@ -0,0 +1,57 @@
+#pragma once
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "SpriteBatch.h"
+
+// 等幅のビットマップフォント
+// テクスチャに文字が格子状に並んでいるもの (debugfont.png は 9x18 ピクセルの ' '～'~' が横に14文字ずつ)
+// 文字列の四角形を1回の走査で作り、SpriteBatch に渡す (文字の番号からUVを引く表を先に作っておく)
+// D3D12に依存しないので、頂点の生成は単体で計測できる (tools/SpriteBench)
+
+// フォントの格子
+struct BitmapFontDesc {
+    uint32_t textureWidth = 128;
+    uint32_t textureHeight = 128;
+    uint32_t glyphWidth = 9;
+    uint32_t glyphHeight = 18;
+    uint32_t columnCount = 14;   // 1行の文字数
+    char firstCharacter = ' ';   // 左上の文字
+    char lastCharacter = '~';    // これより後ろ・firstCharacter より前の文字は '?' にする
+};
+
+// 作っておいた文字列の四角形 (毎フレーム同じ文字列を出すときに、作り直さずに位置と色だけを変えて出す)
+struct TextMesh {
+    std::vector<SpriteVertex> vertices;
+    uint32_t quadCount = 0;
+    Vector2 size = { 0.0f, 0.0f }; // MeasureText の値
+};
+
+class BitmapFont {
+public:
+    void Initialize(const BitmapFontDesc& desc = {});
+
+    // 文字列の四角形を vertices の後ろに足す (左上が原点、scale 倍。'\n' で改行し、空白は四角形を作らない)
+    // 戻り値は足した四角形の数
+    uint32_t BuildText(std::string_view text, float scale, std::vector<SpriteVertex>& vertices) const;
+
+    // 文字列の大きさ (ピクセル)
+    Vector2 MeasureText(std::string_view text, float scale) const;
+
+    // 変わらない文字列の四角形を作っておく
+    TextMesh BuildTextMesh(std::string_view text, float scale) const;
+
+    const BitmapFontDesc& GetDesc() const { return desc_; }
+
+private:
+    // 文字ごとのUV (左上と右下)
+    struct Glyph {
+        Vector2 uvMin;
+        Vector2 uvMax;
+        bool visible;
+    };
+
+private:
+    BitmapFontDesc desc_;
+    Glyph glyphs_[256] = {};
+};
@@ -0,0 +1,74 @@
+#include "DebugText.h"
+#include <cassert>
+#include "SpriteRenderer.h"
+
+DebugText* DebugText::GetInstance() {
+    static DebugText instance;
+    return &instance;
+}
+
+void DebugText::Initialize(SpriteRenderer* spriteRenderer, const std::string& fontPath) {
+    assert(spriteRenderer != nullptr);
+    spriteRenderer_ = spriteRenderer;
+    texture_ = TextureManager::GetInstance()->Load(fontPath);
+    // debugfont.png は 128x128 に 9x18 の ' '～'~' が14文字ずつ並んでいる
+    font_.Initialize(BitmapFontDesc{});
+}
+
+void DebugText::Finalize() {
+    texture_ = TextureHandle();
+    spriteRenderer_ = nullptr;
+}
+
+TextMesh DebugText::CreateText(std::string_view text, float scale) const {
+    return font_.BuildTextMesh(text, scale);
+}
+
+void DebugText::Print(std::string_view text, float x, float y, float scale, const Vector4& color, uint16_t layer) {
+    // フレームの置き場に直接作る (文字列ごとの確保はしない)
+    std::vector<SpriteVertex>& pool = spriteRenderer_->GetQuadPool();
+    uint32_t firstQuad = static_cast<uint32_t>(pool.size() / 4);
+    uint32_t quadCount = font_.BuildText(text, scale, pool);
+    spriteRenderer_->DrawPooledQuads(firstQuad, quadCount, texture_.GetSrvIndex(), layer, { x, y }, color);
+}
+
+void DebugText::Print(const TextMesh& mesh, float x, float y, const Vector4& color, uint16_t layer) {
+    spriteRenderer_->DrawQuads(mesh.vertices.data(), mesh.quadCount, texture_.GetSrvIndex(), layer, { x, y }, color);
+}
+
+bool DebugText::Print3D(std::string_view text, const Vector3& worldPosition, const Matrix4x4& viewProjection, float screenWidth,
+    float screenHeight, float scale, const Vector4& color, uint16_t layer) {
+    // 画面の外なら四角形を作らない
+    Vector2 topLeft;
+    if (!ProjectLabel(worldPosition, viewProjection, screenWidth, screenHeight, font_.MeasureText(text, scale), topLeft)) {
+        return false;
+    }
+    Print(text, topLeft.x, topLeft.y, scale, color, layer);
+    return true;
+}
+
+bool DebugText::Print3D(const TextMesh& mesh, const Vector3& worldPosition, const Matrix4x4& viewProjection, float screenWidth,
+    float screenHeight, const Vector4& color, uint16_t layer) {
+    Vector2 topLeft;
+    if (!ProjectLabel(worldPosition, viewProjection, screenWidth, screenHeight, mesh.size, topLeft)) {
+        return false;
+    }
+    Print(mesh, topLeft.x, topLeft.y, color, layer);
+    return true;
+}
+
+bool DebugText::ProjectLabel(const Vector3& worldPosition, const Matrix4x4& viewProjection, float screenWidth, float screenHeight,
+    const Vector2& size, Vector2& topLeft) {
+    // クリップ空間に変換する (行ベクトル × 行列)
+    const float(*m)[4] = viewProjection.m;
+    float clipX = worldPosition.x * m[0][0] + worldPosition.y * m[1][0] + worldPosition.z * m[2][0] + m[3][0];
+    float clipY = worldPosition.x * m[0][1] + worldPosition.y * m[1][1] + worldPosition.z * m[2][1] + m[3][1];
+    float clipW = worldPosition.x * m[0][3] + worldPosition.y * m[1][3] + worldPosition.z * m[2][3] + m[3][3];
+    if (clipW <= 0.0f) {
+        return false;
+    }
+    float screenX = (clipX / clipW * 0.5f + 0.5f) * screenWidth;
+    float screenY = (0.5f - clipY / clipW * 0.5f) * screenHeight;
+    topLeft = { screenX - size.x * 0.5f, screenY - size.y * 0.5f };
+    return topLeft.x < screenWidth && topLeft.y < screenHeight && topLeft.x + size.x > 0.0f && topLeft.y + size.y > 0.0f;
+}
@@ -0,0 +1,60 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include "BitmapFont.h"
+#include "MathTypes.h"
+#include "TextureManager.h"
+
+class SpriteRenderer;
+
+// デバッグ表示・HUD用の文字列描画 (debugfont.png)
+// 文字列の四角形をまとめて SpriteRenderer に渡すので、文字ごと・文字列ごとの描画にはならない
+// 毎フレーム変わる文字列はその場で四角形を作り、変わらない文字列は CreateText で作っておいたものを位置と色だけ変えて出す
+class DebugText {
+public:
+    // 他のスプライトより手前に出すためのレイヤー
+    static const uint16_t kDefaultLayer = UINT16_MAX;
+
+public:
+    // シングルトンインスタンスの取得
+    static DebugText* GetInstance();
+
+    // 初期化 (フォントのテクスチャは TextureManager で読む)
+    void Initialize(SpriteRenderer* spriteRenderer, const std::string& fontPath = "Resources/debugfont.png");
+
+    // 終了処理
+    void Finalize();
+
+    // 変わらない文字列の四角形を作っておく (ラベルなど。Print に渡すまで持っておく)
+    TextMesh CreateText(std::string_view text, float scale = 1.0f) const;
+
+    // スクリーン座標 (左上が原点のピクセル) に出す。x, y は文字列の左上
+    void Print(std::string_view text, float x, float y, float scale = 1.0f, const Vector4& color = { 1.0f, 1.0f, 1.0f, 1.0f },
+        uint16_t layer = kDefaultLayer);
+    void Print(const TextMesh& mesh, float x, float y, const Vector4& color = { 1.0f, 1.0f, 1.0f, 1.0f }, uint16_t layer = kDefaultLayer);
+
+    // ワールド座標に出す (文字列の中心をその位置に合わせる。カメラの後ろと画面の外は出さない)
+    // 戻り値は出したか
+    bool Print3D(std::string_view text, const Vector3& worldPosition, const Matrix4x4& viewProjection, float screenWidth,
+        float screenHeight, float scale = 1.0f, const Vector4& color = { 1.0f, 1.0f, 1.0f, 1.0f }, uint16_t layer = kDefaultLayer);
+    bool Print3D(const TextMesh& mesh, const Vector3& worldPosition, const Matrix4x4& viewProjection, float screenWidth,
+        float screenHeight, const Vector4& color = { 1.0f, 1.0f, 1.0f, 1.0f }, uint16_t layer = kDefaultLayer);
+
+    const BitmapFont& GetFont() const { return font_; }
+
+private:
+    DebugText() = default;
+    ~DebugText() = default;
+    DebugText(const DebugText&) = delete;
+    const DebugText& operator=(const DebugText&) = delete;
+
+    // 文字列の中心のスクリーン座標から左上を求める (出さないときは false)
+    static bool ProjectLabel(const Vector3& worldPosition, const Matrix4x4& viewProjection, float screenWidth, float screenHeight,
+        const Vector2& size, Vector2& topLeft);
+
+private:
+    SpriteRenderer* spriteRenderer_ = nullptr;
+    TextureHandle texture_;
+    BitmapFont font_;
+};
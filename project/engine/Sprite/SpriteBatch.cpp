@@ -0,0 +1,241 @@
+#include "SpriteBatch.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__SSE__)
+#include <xmmintrin.h>
+#define SPRITE_BATCH_USE_PREFETCH 1
+#endif
+
+namespace {
+
+const uint32_t kTextureBits = 24;
+const uint32_t kOrderBits = 24;
+const uint64_t kOrderMask = (1ull << kOrderBits) - 1;
+const uint32_t kRunBit = 1u << 31;
+const float kPi = 3.14159265358979f;
+// 何個先の四角形を読み込んでおくか
+const size_t kPrefetchDistance = 16;
+
+// sin と cos を一度に求める (誤差は 1e-6 程度。画面上の位置には十分)
+// [-π/4, π/4] に畳んで多項式で近似する。std::sin と std::cos を別々に呼ぶより速い
+void SinCos(float radian, float& sine, float& cosine) {
+    // 最も近い整数に丸める (2^23 * 1.5 を足して引くと小数部が落ちる。std::nearbyint より速い)
+    float quadrant = (radian * (2.0f / kPi) + 12582912.0f) - 12582912.0f;
+    int32_t quadrantIndex = static_cast<int32_t>(quadrant);
+    float x = radian - quadrant * 1.5703125f;
+    x -= quadrant * 4.83826794896619e-4f;
+    float x2 = x * x;
+    float s = x + x * x2 * (-1.66666657e-1f + x2 * (8.33330120e-3f + x2 * -1.98559923e-4f));
+    float c = 1.0f + x2 * (-0.5f + x2 * (4.16664568e-2f + x2 * (-1.38873163e-3f + x2 * 2.44331571e-5f)));
+    // 象限に合わせて入れ替えと符号の反転をする
+    // 角度がばらばらだと分岐予測が外れるので、分岐ではなく表を引く
+    static const float kSineSigns[4] = { 1.0f, 1.0f, -1.0f, -1.0f };
+    static const float kCosineSigns[4] = { 1.0f, -1.0f, -1.0f, 1.0f };
+    const float values[2] = { s, c };
+    uint32_t swap = quadrantIndex & 1;
+    sine = values[swap] * kSineSigns[quadrantIndex & 3];
+    cosine = values[swap ^ 1] * kCosineSigns[quadrantIndex & 3];
+}
+
+} // namespace
+
+void SpriteBatch::Clear() {
+    quads_.clear();
+    runs_.clear();
+    quadPool_.clear();
+    items_.clear();
+    keys_.clear();
+    sorted_ = true;
+    spriteCount_ = 0;
+}
+
+void SpriteBatch::Add(const Sprite& sprite) {
+    if (!AddKey(sprite.layer, sprite.texture, static_cast<uint32_t>(quads_.size()))) {
+        return;
+    }
+    // スクリーン座標はyが下向きなので、この回転で時計回りになる
+    float c = 1.0f;
+    float s = 0.0f;
+    if (sprite.rotation != 0.0f) {
+        SinCos(sprite.rotation, s, c);
+    }
+    Quad& quad = quads_.emplace_back();
+    quad.axisX = { c * sprite.size.x, s * sprite.size.x };
+    quad.axisY = { -s * sprite.size.y, c * sprite.size.y };
+    // アンカーから左上の頂点へ
+    quad.origin = {
+        sprite.position.x - sprite.anchor.x * quad.axisX.x - sprite.anchor.y * quad.axisY.x,
+        sprite.position.y - sprite.anchor.x * quad.axisX.y - sprite.anchor.y * quad.axisY.y,
+    };
+    quad.uvMin = sprite.uvMin;
+    quad.uvMax = sprite.uvMax;
+    quad.texture = sprite.texture;
+    quad.color = PackColor(sprite.color);
+    ++spriteCount_;
+}
+
+void SpriteBatch::AddQuads(const SpriteVertex* vertices, uint32_t quadCount, uint32_t texture, uint16_t layer, const Vector2& offset,
+    const Vector4& color) {
+    if (quadCount == 0 || !AddKey(layer, texture, static_cast<uint32_t>(runs_.size()) | kRunBit)) {
+        return;
+    }
+    runs_.push_back({ vertices, 0, quadCount, texture, offset, PackColor(color) });
+    spriteCount_ += quadCount;
+}
+
+void SpriteBatch::AddPooledQuads(uint32_t firstQuad, uint32_t quadCount, uint32_t texture, uint16_t layer, const Vector2& offset,
+    const Vector4& color) {
+    assert((size_t(firstQuad) + quadCount) * 4 <= quadPool_.size());
+    if (quadCount == 0 || !AddKey(layer, texture, static_cast<uint32_t>(runs_.size()) | kRunBit)) {
+        return;
+    }
+    runs_.push_back({ nullptr, firstQuad, quadCount, texture, offset, PackColor(color) });
+    spriteCount_ += quadCount;
+}
+
+uint32_t SpriteBatch::Build(SpriteVertex* vertices, uint32_t maxSprites, std::vector<SpriteDrawBatch>& batches) {
+    batches.clear();
+    if (!sorted_) {
+        SortKeys();
+        sorted_ = true;
+    }
+
+    uint32_t written = 0;
+    size_t keyCount = keys_.size();
+    for (size_t i = 0; i < keyCount; ++i) {
+        if (written == maxSprites) {
+            break;
+        }
+        // 並べ替えた後は quads_ を飛び飛びに読むので、少し先のものを読み込んでおく
+#if defined(SPRITE_BATCH_USE_PREFETCH)
+        if (i + kPrefetchDistance < keyCount) {
+            uint32_t ahead = items_[keys_[i + kPrefetchDistance] & kOrderMask];
+            if ((ahead & kRunBit) == 0) {
+                _mm_prefetch(reinterpret_cast<const char*>(&quads_[ahead]), _MM_HINT_T0);
+            }
+        }
+#endif
+        uint32_t item = items_[keys_[i] & kOrderMask];
+        if ((item & kRunBit) == 0) {
+            const Quad& quad = quads_[item];
+            WriteVertices(quad, vertices + size_t(written) * 4);
+            AppendDrawBatch(batches, quad.texture, written, 1);
+            ++written;
+        } else {
+            const QuadRun& run = runs_[item & ~kRunBit];
+            uint32_t quadCount = std::min(run.quadCount, maxSprites - written);
+            const SpriteVertex* source = run.vertices != nullptr ? run.vertices : quadPool_.data() + size_t(run.firstQuad) * 4;
+            WriteQuads(run, source, quadCount, vertices + size_t(written) * 4);
+            AppendDrawBatch(batches, run.texture, written, quadCount);
+            written += quadCount;
+        }
+    }
+    return written;
+}
+
+std::vector<uint16_t> SpriteBatch::MakeIndices() {
+    const uint32_t pattern[6] = { 0, 1, 2, 1, 3, 2 };
+    std::vector<uint16_t> indices(size_t(kMaxSpritesPerDraw) * 6);
+    for (uint32_t i = 0; i < kMaxSpritesPerDraw; ++i) {
+        for (uint32_t j = 0; j < 6; ++j) {
+            indices[size_t(i) * 6 + j] = static_cast<uint16_t>(i * 4 + pattern[j]);
+        }
+    }
+    return indices;
+}
+
+uint32_t SpriteBatch::PackColor(const Vector4& color) {
+    auto toByte = [](float value) { return static_cast<uint32_t>(std::clamp(value, 0.0f, 1.0f) * 255.0f + 0.5f); };
+    return toByte(color.x) | (toByte(color.y) << 8) | (toByte(color.z) << 16) | (toByte(color.w) << 24);
+}
+
+bool SpriteBatch::AddKey(uint16_t layer, uint32_t texture, uint32_t item) {
+    if (items_.size() >= kMaxSprites) {
+        return false;
+    }
+    assert(texture < (1u << kTextureBits));
+    uint64_t order = items_.size();
+    uint64_t key = (uint64_t(layer) << (kTextureBits + kOrderBits)) | (uint64_t(texture) << kOrderBits) | order;
+    // 追加した順は増えていくので、レイヤーとテクスチャが前のもの以上なら並んだまま
+    sorted_ = sorted_ && (keys_.empty() || keys_.back() < key);
+    keys_.push_back(key);
+    items_.push_back(item);
+    return true;
+}
+
+void SpriteBatch::SortKeys() {
+    // 追加した順は既に並んでいるので、レイヤーとテクスチャのバイトだけを下位から安定に基数ソートする
+    // 全てのキーで同じ値のバイト (レイヤーを使っていない、テクスチャが少ない) は飛ばす
+    // バイトごとの数は1回読むだけで全て数えられる (並べ替えても変わらない)
+    const uint32_t kPassCount = (64 - kOrderBits) / 8;
+    size_t count = keys_.size();
+    if (count == 0) {
+        return;
+    }
+    sortBuffer_.resize(count);
+    uint64_t* source = keys_.data();
+    uint64_t* destination = sortBuffer_.data();
+    std::vector<size_t> histograms(size_t(kPassCount) * 256);
+    for (size_t i = 0; i < count; ++i) {
+        uint64_t key = source[i] >> kOrderBits;
+        for (uint32_t pass = 0; pass < kPassCount; ++pass) {
+            ++histograms[size_t(pass) * 256 + ((key >> (pass * 8)) & 0xFF)];
+        }
+    }
+    for (uint32_t pass = 0; pass < kPassCount; ++pass) {
+        uint32_t shift = kOrderBits + pass * 8;
+        size_t* histogram = &histograms[size_t(pass) * 256];
+        if (histogram[(source[0] >> shift) & 0xFF] == count) {
+            continue;
+        }
+        size_t offset = 0;
+        for (uint32_t bucket = 0; bucket < 256; ++bucket) {
+            size_t bucketCount = histogram[bucket];
+            histogram[bucket] = offset;
+            offset += bucketCount;
+        }
+        for (size_t i = 0; i < count; ++i) {
+            destination[histogram[(source[i] >> shift) & 0xFF]++] = source[i];
+        }
+        std::swap(source, destination);
+    }
+    if (source != keys_.data()) {
+        keys_.swap(sortBuffer_);
+    }
+}
+
+void SpriteBatch::WriteVertices(const Quad& quad, SpriteVertex* vertices) {
+    // 左上・右上・左下・右下 (書き込み結合メモリなので、1頂点ずつ全ての要素を順に書く)
+    const float x = quad.origin.x;
+    const float y = quad.origin.y;
+    vertices[0] = { { x, y, 0.0f }, { quad.uvMin.x, quad.uvMin.y }, quad.color };
+    vertices[1] = { { x + quad.axisX.x, y + quad.axisX.y, 0.0f }, { quad.uvMax.x, quad.uvMin.y }, quad.color };
+    vertices[2] = { { x + quad.axisY.x, y + quad.axisY.y, 0.0f }, { quad.uvMin.x, quad.uvMax.y }, quad.color };
+    vertices[3] = { { x + quad.axisX.x + quad.axisY.x, y + quad.axisX.y + quad.axisY.y, 0.0f }, { quad.uvMax.x, quad.uvMax.y }, quad.color };
+}
+
+void SpriteBatch::WriteQuads(const QuadRun& run, const SpriteVertex* source, uint32_t quadCount, SpriteVertex* vertices) {
+    // 平行移動と色の置き換えだけなので、要素ごとに同じ処理が並ぶ (コンパイラがベクトル化しやすい形にしておく)
+    uint32_t vertexCount = quadCount * 4;
+    for (uint32_t i = 0; i < vertexCount; ++i) {
+        SpriteVertex vertex;
+        vertex.position = { source[i].position.x + run.offset.x, source[i].position.y + run.offset.y, source[i].position.z };
+        vertex.texcoord = source[i].texcoord;
+        vertex.color = run.color;
+        vertices[i] = vertex;
+    }
+}
+
+void SpriteBatch::AppendDrawBatch(std::vector<SpriteDrawBatch>& batches, uint32_t texture, uint32_t firstSprite, uint32_t spriteCount) {
+    while (spriteCount > 0) {
+        if (batches.empty() || batches.back().texture != texture || batches.back().spriteCount == kMaxSpritesPerDraw) {
+            batches.push_back({ texture, firstSprite, 0 });
+        }
+        uint32_t count = std::min(spriteCount, kMaxSpritesPerDraw - batches.back().spriteCount);
+        batches.back().spriteCount += count;
+        firstSprite += count;
+        spriteCount -= count;
+    }
+}
@@ -0,0 +1,120 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "MathTypes.h"
+
+// スプライトのバッチ処理
+// 1フレーム分のスプライトを溜めておき、レイヤー→テクスチャの順に並べ替えて、同じテクスチャが続く区間を1回の描画にまとめる
+// 頂点はスプライトごとに4つ (インデックスは全スプライト共通の並び) を、呼び出し側が用意した領域 (アップロードリング) に順に書く
+// 回転などの計算は Add のときに済ませ、Build は並べ替えた順に四隅を足し算で出して書くだけにする
+// レイヤー・テクスチャの順に追加された場合は並べ替えない
+// D3D12に依存しないので、頂点の生成と並べ替えは単体で計測できる (tools/SpriteBench)
+
+// スプライトの頂点 (SpriteVS.hlsl の入力)
+struct SpriteVertex {
+    Vector3 position;
+    Vector2 texcoord;
+    uint32_t color; // RGBA8 (R が下位バイト。DXGI_FORMAT_R8G8B8A8_UNORM)
+};
+
+// スプライト1枚
+struct Sprite {
+    Vector2 position = { 0.0f, 0.0f }; // アンカーの位置 (スクリーン座標、ピクセル)
+    Vector2 size = { 100.0f, 100.0f }; // 大きさ (ピクセル)
+    Vector2 anchor = { 0.0f, 0.0f };   // 位置と回転の中心 (0,0 が左上、1,1 が右下)
+    float rotation = 0.0f;             // 回転 (ラジアン、時計回り)
+    Vector4 color = { 1.0f, 1.0f, 1.0f, 1.0f };
+    Vector2 uvMin = { 0.0f, 0.0f };    // テクスチャの左上
+    Vector2 uvMax = { 1.0f, 1.0f };    // テクスチャの右下
+    uint32_t texture = 0;              // テクスチャ (SRVの番号。同じものが続く区間をまとめる)
+    uint16_t layer = 0;                // 描画順 (小さいほど先に描く。同じレイヤー内は追加した順)
+};
+
+// 1回の描画 (同じテクスチャのスプライトが続く区間)
+struct SpriteDrawBatch {
+    uint32_t texture = 0;
+    uint32_t firstSprite = 0; // 書いた頂点の中での位置 (スプライト単位。頂点は ×4)
+    uint32_t spriteCount = 0;
+};
+
+class SpriteBatch {
+public:
+    // 1回の描画にまとめるスプライトの上限 (16bitのインデックスで頂点を指せる数)
+    static const uint32_t kMaxSpritesPerDraw = 65536 / 4;
+    // 1フレームに追加できる数の上限 (並べ替えのキーに追加した順を24bitで入れるため。AddQuads は1回で1つ)
+    static const uint32_t kMaxSprites = 1u << 24;
+
+public:
+    // 溜めたスプライトを捨てる (フレームの先頭で呼ぶ)
+    void Clear();
+
+    // スプライトを追加する (kMaxSprites を超えた分は捨てる)
+    void Add(const Sprite& sprite);
+
+    // 頂点を作ってある四角形の並びを追加する (文字列など。quadCount × 4 個の頂点)
+    // 並びはまとめて1つのスプライトとして並べ替える。頂点の位置に offset を足し、色は color で置き換える
+    // vertices は Build が終わるまで有効であること
+    void AddQuads(const SpriteVertex* vertices, uint32_t quadCount, uint32_t texture, uint16_t layer, const Vector2& offset,
+        const Vector4& color);
+
+    // このフレームだけ使う四角形の置き場 (Clear で空になる)
+    // 後ろに頂点を足してから、足した位置 (四角形単位) を AddPooledQuads に渡す。途中で伸びてもよい
+    std::vector<SpriteVertex>& GetQuadPool() { return quadPool_; }
+    void AddPooledQuads(uint32_t firstQuad, uint32_t quadCount, uint32_t texture, uint16_t layer, const Vector2& offset,
+        const Vector4& color);
+
+    // 溜めているスプライトの数 (AddQuads の四角形も1つずつ数える)
+    uint32_t GetSpriteCount() const { return spriteCount_; }
+
+    // 並べ替えて頂点を vertices に書き、描画の区間を batches に入れる (batches は先に空にする)
+    // vertices には maxSprites × 4 個分の領域が必要。入りきらない分は書かない
+    // 書き込み結合メモリに直接書けるように、vertices は先頭から順に書くだけで読み返さない
+    // 戻り値は書いたスプライトの数
+    uint32_t Build(SpriteVertex* vertices, uint32_t maxSprites, std::vector<SpriteDrawBatch>& batches);
+
+    // 全ての描画で共通のインデックス (kMaxSpritesPerDraw 枚分。0-1-2, 1-3-2 の順で時計回り)
+    static std::vector<uint16_t> MakeIndices();
+
+    // 色を頂点カラーの形式にする (0～1 の範囲に切り詰める)
+    static uint32_t PackColor(const Vector4& color);
+
+private:
+    // AddQuads で追加した並び
+    struct QuadRun {
+        const SpriteVertex* vertices; // nullptr なら quadPool_ の firstQuad から
+        uint32_t firstQuad;
+        uint32_t quadCount;
+        uint32_t texture;
+        Vector2 offset;
+        uint32_t color;
+    };
+
+    // Add のときに計算しておいた四角形 (左上の頂点と、右・下の辺のベクトル)
+    struct Quad {
+        Vector2 origin;
+        Vector2 axisX;
+        Vector2 axisY;
+        Vector2 uvMin;
+        Vector2 uvMax;
+        uint32_t texture;
+        uint32_t color;
+    };
+
+    // 並べ替えのキー (レイヤー16bit | テクスチャ24bit | 追加した順24bit)
+    bool AddKey(uint16_t layer, uint32_t texture, uint32_t item);
+    void SortKeys();
+    static void WriteVertices(const Quad& quad, SpriteVertex* vertices);
+    static void WriteQuads(const QuadRun& run, const SpriteVertex* source, uint32_t quadCount, SpriteVertex* vertices);
+    // 描画の区間を伸ばす (テクスチャが変わるか、1回で描ける数を超えたら新しくする)
+    static void AppendDrawBatch(std::vector<SpriteDrawBatch>& batches, uint32_t texture, uint32_t firstSprite, uint32_t spriteCount);
+
+private:
+    std::vector<Quad> quads_;
+    std::vector<QuadRun> runs_;
+    std::vector<SpriteVertex> quadPool_;
+    std::vector<uint32_t> items_; // 追加した順の quads_ / runs_ の番号 (runs_ は kRunBit を立てる)
+    std::vector<uint64_t> keys_;
+    std::vector<uint64_t> sortBuffer_;
+    bool sorted_ = true; // キーが追加した時点で並んでいる (並べ替えを飛ばせる)
+    uint32_t spriteCount_ = 0;
+};
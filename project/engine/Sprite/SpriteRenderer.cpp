@@ -0,0 +1,132 @@
+#include "SpriteRenderer.h"
+#include <cassert>
+#include <cstring>
+#include "D3D12Util.h"
+#include "MathUtil.h"
+#include "PipelinePresets.h"
+
+namespace {
+
+const uint64_t kQuadBytes = sizeof(SpriteVertex) * 4;
+
+} // namespace
+
+SpriteRenderer* SpriteRenderer::GetInstance() {
+    static SpriteRenderer instance;
+    return &instance;
+}
+
+void SpriteRenderer::Initialize(ID3D12Device* device, ID3D12DescriptorHeap* srvDescriptorHeap, uint32_t srvDescriptorSize,
+    uint32_t maxSpritesPerFrame) {
+    srvDescriptorHeap_ = srvDescriptorHeap;
+    srvDescriptorSize_ = srvDescriptorSize;
+
+    // GPUが読んでいるフレームの分も含めて確保する (定数バッファの分を少し足す)
+    uint64_t frameSize = kQuadBytes * maxSpritesPerFrame + D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT * 2;
+    ring_.Initialize(device, frameSize * UploadRing::kFrameLatency);
+
+    std::vector<uint16_t> indices = SpriteBatch::MakeIndices();
+    size_t indexBytes = sizeof(uint16_t) * indices.size();
+    indexResource_ = CreateBufferResource(device, indexBytes);
+    uint16_t* indexData = nullptr;
+    indexResource_->Map(0, nullptr, reinterpret_cast<void**>(&indexData));
+    std::memcpy(indexData, indices.data(), indexBytes);
+    indexResource_->Unmap(0, nullptr);
+    indexBufferView_.BufferLocation = indexResource_->GetGPUVirtualAddress();
+    indexBufferView_.SizeInBytes = static_cast<UINT>(indexBytes);
+    indexBufferView_.Format = DXGI_FORMAT_R16_UINT;
+
+    PipelineLibrary* pipelineLibrary = PipelineLibrary::GetInstance();
+    for (int srgbOutput = 0; srgbOutput < 2; ++srgbOutput) {
+        Pipeline& pipeline = pipelines_[srgbOutput];
+        pipeline.handle = pipelineLibrary->Request(MakeSpritePipelineDesc(srgbOutput != 0));
+        pipeline.constantsRootIndex = pipelineLibrary->GetRootParameterIndex(pipeline.handle, "cbuff0");
+        pipeline.textureRootIndex = pipelineLibrary->GetRootParameterIndex(pipeline.handle, "tex");
+        assert(pipeline.handle == PipelineLibrary::kInvalidHandle ||
+               (pipeline.constantsRootIndex != UINT32_MAX && pipeline.textureRootIndex != UINT32_MAX));
+    }
+}
+
+void SpriteRenderer::Finalize() {
+    ring_.Finalize();
+    indexResource_.Reset();
+    batch_.Clear();
+    drawBatches_.clear();
+}
+
+void SpriteRenderer::BeginFrame() {
+    batch_.Clear();
+    ring_.BeginFrame();
+}
+
+void SpriteRenderer::Draw(const Sprite& sprite) {
+    batch_.Add(sprite);
+}
+
+void SpriteRenderer::DrawQuads(const SpriteVertex* vertices, uint32_t quadCount, uint32_t texture, uint16_t layer, const Vector2& offset,
+    const Vector4& color) {
+    batch_.AddQuads(vertices, quadCount, texture, layer, offset, color);
+}
+
+void SpriteRenderer::DrawPooledQuads(uint32_t firstQuad, uint32_t quadCount, uint32_t texture, uint16_t layer, const Vector2& offset,
+    const Vector4& color) {
+    batch_.AddPooledQuads(firstQuad, quadCount, texture, layer, offset, color);
+}
+
+void SpriteRenderer::Render(ID3D12GraphicsCommandList* commandList, float screenWidth, float screenHeight, bool srgbOutput) {
+    stats_ = {};
+    uint32_t spriteCount = batch_.GetSpriteCount();
+    if (spriteCount == 0) {
+        return;
+    }
+    PipelineLibrary* pipelineLibrary = PipelineLibrary::GetInstance();
+    const Pipeline& pipeline = pipelines_[srgbOutput ? 1 : 0];
+    ID3D12PipelineState* pipelineState = pipelineLibrary->GetPipelineState(pipeline.handle);
+    if (pipelineState == nullptr) {
+        return;
+    }
+
+    UploadRing::Allocation constantsAllocation;
+    if (!ring_.Allocate(sizeof(Constants), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, constantsAllocation)) {
+        stats_.droppedCount = spriteCount;
+        return;
+    }
+    Constants constants;
+    constants.color = { 1.0f, 1.0f, 1.0f, 1.0f };
+    constants.mat = MakeOrthographicMatrix(0.0f, 0.0f, screenWidth, screenHeight, 0.0f, 1.0f);
+    std::memcpy(constantsAllocation.cpuAddress, &constants, sizeof(constants));
+
+    // 入りきらなければ空いている分だけ描く
+    uint32_t maxSprites = spriteCount;
+    UploadRing::Allocation vertexAllocation;
+    if (!ring_.Allocate(kQuadBytes * maxSprites, sizeof(float), vertexAllocation)) {
+        uint64_t freeSize = ring_.GetFreeSize();
+        maxSprites = static_cast<uint32_t>(freeSize > sizeof(float) ? (freeSize - sizeof(float)) / kQuadBytes : 0);
+        if (maxSprites == 0 || !ring_.Allocate(kQuadBytes * maxSprites, sizeof(float), vertexAllocation)) {
+            stats_.droppedCount = spriteCount;
+            return;
+        }
+    }
+    uint32_t writtenCount = batch_.Build(static_cast<SpriteVertex*>(vertexAllocation.cpuAddress), maxSprites, drawBatches_);
+
+    D3D12_VERTEX_BUFFER_VIEW vertexBufferView{};
+    vertexBufferView.BufferLocation = vertexAllocation.gpuAddress;
+    vertexBufferView.SizeInBytes = static_cast<UINT>(kQuadBytes * writtenCount);
+    vertexBufferView.StrideInBytes = sizeof(SpriteVertex);
+
+    commandList->SetGraphicsRootSignature(pipelineLibrary->GetRootSignature(pipeline.handle));
+    commandList->SetPipelineState(pipelineState);
+    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    commandList->IASetIndexBuffer(&indexBufferView_);
+    commandList->IASetVertexBuffers(0, 1, &vertexBufferView);
+    commandList->SetGraphicsRootConstantBufferView(pipeline.constantsRootIndex, constantsAllocation.gpuAddress);
+    for (const SpriteDrawBatch& drawBatch : drawBatches_) {
+        commandList->SetGraphicsRootDescriptorTable(
+            pipeline.textureRootIndex, GetGPUDescriptorHandle(srvDescriptorHeap_, srvDescriptorSize_, drawBatch.texture));
+        commandList->DrawIndexedInstanced(drawBatch.spriteCount * 6, 1, 0, static_cast<INT>(drawBatch.firstSprite * 4), 0);
+    }
+
+    stats_.spriteCount = writtenCount;
+    stats_.droppedCount = spriteCount - writtenCount;
+    stats_.drawCount = static_cast<uint32_t>(drawBatches_.size());
+}
@@ -0,0 +1,90 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl.h>
+#include <cstdint>
+#include <vector>
+#include "PipelineLibrary.h"
+#include "SpriteBatch.h"
+#include "UploadRing.h"
+
+// スプライトの描画クラス
+// Draw で溜めたスプライトを Render でまとめて描く (スプライトごとの定数バッファや描画は作らない)
+// 頂点はマップしたままのリングバッファに直接書き、同じテクスチャが続く区間ごとに1回だけ描画する
+class SpriteRenderer {
+public:
+    // 1フレームに描けるスプライト数の初期値
+    static const uint32_t kDefaultMaxSprites = 100000;
+
+    // 直前の Render の結果
+    struct Stats {
+        uint32_t spriteCount = 0;  // 描いたスプライトの数
+        uint32_t droppedCount = 0; // リングに入りきらずに描かなかった数
+        uint32_t drawCount = 0;    // 描画コマンドの数
+    };
+
+public:
+    // シングルトンインスタンスの取得
+    static SpriteRenderer* GetInstance();
+
+    // 初期化 (テクスチャは srvDescriptorHeap のSRVの番号で指定する)
+    void Initialize(ID3D12Device* device, ID3D12DescriptorHeap* srvDescriptorHeap, uint32_t srvDescriptorSize,
+        uint32_t maxSpritesPerFrame = kDefaultMaxSprites);
+
+    // 終了処理
+    void Finalize();
+
+    // フレームの先頭で呼ぶ (溜めたスプライトを捨て、GPUが使い終わったリングの領域を再利用する)
+    void BeginFrame();
+
+    // スプライトを溜める (sprite.texture は TextureHandle::GetSrvIndex の値)
+    void Draw(const Sprite& sprite);
+
+    // 頂点を作ってある四角形の並びを溜める (文字列など。SpriteBatch::AddQuads を参照)
+    void DrawQuads(const SpriteVertex* vertices, uint32_t quadCount, uint32_t texture, uint16_t layer, const Vector2& offset,
+        const Vector4& color);
+
+    // このフレームだけ使う四角形の置き場と、そこに足した四角形を溜める (SpriteBatch::GetQuadPool を参照)
+    std::vector<SpriteVertex>& GetQuadPool() { return batch_.GetQuadPool(); }
+    void DrawPooledQuads(uint32_t firstQuad, uint32_t quadCount, uint32_t texture, uint16_t layer, const Vector2& offset,
+        const Vector4& color);
+
+    // 溜めたスプライトを描く (レンダーターゲットを設定した後に呼ぶ。座標は左上が原点のピクセル)
+    // srgbOutput はsRGBでないレンダーターゲットにガンマをかけて書く
+    void Render(ID3D12GraphicsCommandList* commandList, float screenWidth, float screenHeight, bool srgbOutput = false);
+
+    const Stats& GetStats() const { return stats_; }
+
+private:
+    SpriteRenderer() = default;
+    ~SpriteRenderer() = default;
+    SpriteRenderer(const SpriteRenderer&) = delete;
+    const SpriteRenderer& operator=(const SpriteRenderer&) = delete;
+
+    // Sprite.hlsli の cbuff0
+    struct Constants {
+        Vector4 color;
+        Matrix4x4 mat;
+    };
+
+    // パイプライン1つ分 (ルートパラメータはリフレクションで決まるので名前で引いておく)
+    struct Pipeline {
+        PipelineLibrary::Handle handle = PipelineLibrary::kInvalidHandle;
+        uint32_t constantsRootIndex = 0;
+        uint32_t textureRootIndex = 0;
+    };
+
+private:
+    ID3D12DescriptorHeap* srvDescriptorHeap_ = nullptr;
+    uint32_t srvDescriptorSize_ = 0;
+
+    SpriteBatch batch_;
+    std::vector<SpriteDrawBatch> drawBatches_;
+    UploadRing ring_;
+
+    // 全てのスプライトで共通のインデックス
+    Microsoft::WRL::ComPtr<ID3D12Resource> indexResource_;
+    D3D12_INDEX_BUFFER_VIEW indexBufferView_{};
+
+    Pipeline pipelines_[2]; // [srgbOutput]
+    Stats stats_;
+};
@@ -0,0 +1,106 @@
+#include "Heightmap.h"
+#include <cassert>
+#include <fstream>
+#include <utility>
+
+namespace {
+
+// 格子の位置と段から決まる乱数 (-1～1)
+float Random(uint32_t seed, uint32_t x, uint32_t z) {
+    uint32_t h = seed ^ (x * 0x8DA6B343u) ^ (z * 0xD8163841u);
+    h ^= h >> 15;
+    h *= 0x2C1B3C6Du;
+    h ^= h >> 12;
+    h *= 0x297A2D39u;
+    h ^= h >> 15;
+    return float(h & 0xFFFFFF) / float(0x7FFFFF) - 1.0f;
+}
+
+uint16_t ToSample(float value) {
+    value = value < 0.0f ? 0.0f : (value > 65535.0f ? 65535.0f : value);
+    return static_cast<uint16_t>(value + 0.5f);
+}
+
+} // namespace
+
+void Heightmap::Initialize(uint32_t width, uint32_t height, std::vector<uint16_t> samples) {
+    assert(width > 1 && height > 1 && samples.size() == size_t(width) * height);
+    width_ = width;
+    height_ = height;
+    samples_ = std::move(samples);
+}
+
+bool Heightmap::LoadRaw16(const std::string& filePath, uint32_t width, uint32_t height) {
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if (!file || uint64_t(file.tellg()) != uint64_t(width) * height * sizeof(uint16_t)) {
+        return false;
+    }
+    file.seekg(0);
+    std::vector<uint16_t> samples(size_t(width) * height);
+    // Windows も Linux もリトルエンディアンなのでそのまま読む
+    file.read(reinterpret_cast<char*>(samples.data()), std::streamsize(samples.size() * sizeof(uint16_t)));
+    if (!file) {
+        return false;
+    }
+    Initialize(width, height, std::move(samples));
+    return true;
+}
+
+void Heightmap::GenerateFractal(uint32_t width, uint32_t height, uint32_t seed, float roughness) {
+    assert(width > 1 && height > 1);
+    // 2のべき+1 の正方形で作り、左上を切り出す
+    uint32_t size = 1;
+    while (size + 1 < width || size + 1 < height) {
+        size *= 2;
+    }
+    uint32_t stride = size + 1;
+    std::vector<uint16_t> grid(size_t(stride) * stride);
+    auto at = [&](uint32_t x, uint32_t z) -> uint16_t& { return grid[size_t(z) * stride + x]; };
+
+    at(0, 0) = at(size, 0) = at(0, size) = at(size, size) = 32768;
+    float amplitude = 24000.0f;
+    for (uint32_t step = size; step > 1; step /= 2) {
+        uint32_t half = step / 2;
+        // ダイヤモンド: 正方形の中心を四隅の平均にする
+        for (uint32_t z = half; z < size; z += step) {
+            for (uint32_t x = half; x < size; x += step) {
+                float average = (float(at(x - half, z - half)) + float(at(x + half, z - half)) + float(at(x - half, z + half)) +
+                                    float(at(x + half, z + half))) * 0.25f;
+                at(x, z) = ToSample(average + Random(seed, x, z) * amplitude);
+            }
+        }
+        // スクエア: 辺の中点を上下左右の平均にする (外側は3点)
+        for (uint32_t z = 0; z <= size; z += half) {
+            for (uint32_t x = (z / half) % 2 == 0 ? half : 0; x <= size; x += step) {
+                float sum = 0.0f;
+                float count = 0.0f;
+                if (x >= half) {
+                    sum += float(at(x - half, z));
+                    count += 1.0f;
+                }
+                if (x + half <= size) {
+                    sum += float(at(x + half, z));
+                    count += 1.0f;
+                }
+                if (z >= half) {
+                    sum += float(at(x, z - half));
+                    count += 1.0f;
+                }
+                if (z + half <= size) {
+                    sum += float(at(x, z + half));
+                    count += 1.0f;
+                }
+                at(x, z) = ToSample(sum / count + Random(seed, x, z) * amplitude);
+            }
+        }
+        amplitude *= roughness;
+    }
+
+    std::vector<uint16_t> samples(size_t(width) * height);
+    for (uint32_t z = 0; z < height; ++z) {
+        for (uint32_t x = 0; x < width; ++x) {
+            samples[size_t(z) * width + x] = at(x, z);
+        }
+    }
+    Initialize(width, height, std::move(samples));
+}
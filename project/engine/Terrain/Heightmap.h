@@ -0,0 +1,34 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// 地形の高さの格子 (16bit。0 が最も低く 65535 が最も高い)
+// 8k x 8k でも 128MB に収まるように float にはしない
+class Heightmap {
+public:
+    // 値を直接渡す (samples は width * height 個、行ごとに並べる)
+    void Initialize(uint32_t width, uint32_t height, std::vector<uint16_t> samples);
+
+    // 16bitリトルエンディアンのRAW (.r16 / .raw) を読む。読めなければ false
+    bool LoadRaw16(const std::string& filePath, uint32_t width, uint32_t height);
+
+    // ダイヤモンド・スクエア法で作る (計測・確認用。roughness が大きいほど起伏が細かくなる)
+    void GenerateFractal(uint32_t width, uint32_t height, uint32_t seed, float roughness = 0.55f);
+
+    // 範囲外は端の値を返す
+    uint16_t GetSample(int32_t x, int32_t z) const {
+        x = x < 0 ? 0 : (x >= int32_t(width_) ? int32_t(width_) - 1 : x);
+        z = z < 0 ? 0 : (z >= int32_t(height_) ? int32_t(height_) - 1 : z);
+        return samples_[size_t(z) * width_ + x];
+    }
+
+    uint32_t GetWidth() const { return width_; }
+    uint32_t GetHeight() const { return height_; }
+    const uint16_t* GetData() const { return samples_.data(); }
+
+private:
+    uint32_t width_ = 0;
+    uint32_t height_ = 0;
+    std::vector<uint16_t> samples_;
+};
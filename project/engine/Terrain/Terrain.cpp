@@ -0,0 +1,267 @@
+#include "Terrain.h"
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <utility>
+#include "D3D12Util.h"
+#include "MathUtil.h"
+#include "PipelinePresets.h"
+
+namespace {
+
+// 1フレームに Draw を呼べる回数 (影などで同じフレームに何度か描くとき用)
+const uint32_t kMaxDrawsPerFrame = 8;
+
+} // namespace
+
+Terrain* Terrain::Create(Heightmap heightmap, const TerrainDesc& desc, ID3D12Device* device, uint32_t maxChunks) {
+    Terrain* terrain = new Terrain();
+    terrain->Initialize(std::move(heightmap), desc, device, maxChunks);
+    return terrain;
+}
+
+void Terrain::Initialize(Heightmap heightmap, const TerrainDesc& desc, ID3D12Device* device, uint32_t maxChunks) {
+    assert(maxChunks > 0);
+    heightmap_ = std::move(heightmap);
+    quadTree_.Initialize(&heightmap_, desc);
+
+    uint32_t vertexCount = quadTree_.GetVertexCountPerChunk();
+    size_t vertexBytes = sizeof(TerrainVertex) * vertexCount * maxChunks;
+    vertexResource_ = CreateBufferResource(device, vertexBytes);
+    HRESULT hr = vertexResource_->Map(0, nullptr, reinterpret_cast<void**>(&vertexData_));
+    assert(SUCCEEDED(hr));
+    vertexBufferView_.BufferLocation = vertexResource_->GetGPUVirtualAddress();
+    vertexBufferView_.SizeInBytes = static_cast<UINT>(vertexBytes);
+    vertexBufferView_.StrideInBytes = sizeof(TerrainVertex);
+
+    std::vector<uint16_t> indices = TerrainQuadTree::MakeIndices(desc.chunkResolution);
+    size_t indexBytes = sizeof(uint16_t) * indices.size();
+    indexResource_ = CreateBufferResource(device, indexBytes);
+    uint16_t* indexData = nullptr;
+    indexResource_->Map(0, nullptr, reinterpret_cast<void**>(&indexData));
+    std::memcpy(indexData, indices.data(), indexBytes);
+    indexResource_->Unmap(0, nullptr);
+    indexBufferView_.BufferLocation = indexResource_->GetGPUVirtualAddress();
+    indexBufferView_.SizeInBytes = static_cast<UINT>(indexBytes);
+    indexBufferView_.Format = DXGI_FORMAT_R16_UINT;
+    indexCount_ = static_cast<uint32_t>(indices.size());
+
+    slots_.assign(maxChunks, Slot{});
+    freeSlots_.clear();
+    for (uint32_t slot = maxChunks; slot > 0; --slot) {
+        freeSlots_.push_back(slot - 1);
+    }
+    slotOfKey_.clear();
+    slotOfNode_.clear();
+
+    uint64_t constantsSize =
+        (sizeof(Matrix4x4) + sizeof(ViewProjection) + D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT * 2) * kMaxDrawsPerFrame;
+    ring_.Initialize(device, constantsSize * UploadRing::kFrameLatency);
+
+    PipelineLibrary* pipelineLibrary = PipelineLibrary::GetInstance();
+    pipelineHandle_ = pipelineLibrary->Request(MakeTerrainPipelineDesc());
+    worldRootIndex_ = pipelineLibrary->GetRootParameterIndex(pipelineHandle_, "WorldTransform");
+    viewProjectionRootIndex_ = pipelineLibrary->GetRootParameterIndex(pipelineHandle_, "ViewProjection");
+    textureRootIndex_ = pipelineLibrary->GetRootParameterIndex(pipelineHandle_, "tex");
+    assert(pipelineHandle_ == PipelineLibrary::kInvalidHandle ||
+           (worldRootIndex_ != UINT32_MAX && viewProjectionRootIndex_ != UINT32_MAX && textureRootIndex_ != UINT32_MAX));
+}
+
+uint32_t Terrain::AcquireSlot() {
+    if (!freeSlots_.empty()) {
+        uint32_t slot = freeSlots_.back();
+        freeSlots_.pop_back();
+        return slot;
+    }
+    // 最も長く使われていない枠を使い回す
+    uint32_t oldest = UINT32_MAX;
+    for (uint32_t slot = 0; slot < slots_.size(); ++slot) {
+        const Slot& candidate = slots_[slot];
+        if (candidate.lastUsedFrame + UploadRing::kFrameLatency <= frame_ &&
+            (oldest == UINT32_MAX || candidate.lastUsedFrame < slots_[oldest].lastUsedFrame)) {
+            oldest = slot;
+        }
+    }
+    if (oldest != UINT32_MAX) {
+        uint64_t key = slots_[oldest].key;
+        slotOfKey_.erase(key);
+        auto node = slotOfNode_.find(TerrainChunk::MakeNodeKey(
+            TerrainChunk::GetKeyLevel(key), TerrainChunk::GetKeyX(key), TerrainChunk::GetKeyZ(key)));
+        if (node != slotOfNode_.end() && node->second == oldest) {
+            slotOfNode_.erase(node);
+        }
+    }
+    return oldest;
+}
+
+bool Terrain::AddFallback(const TerrainChunk& chunk) {
+    // 同じノードの前のメッシュ (隣のレベルが違うので辺が少しずれることがあるが、穴よりはよい)
+    auto same = slotOfNode_.find(chunk.GetNodeKey());
+    if (same != slotOfNode_.end()) {
+        slots_[same->second].lastUsedFrame = frame_;
+        drawSlots_.push_back(same->second);
+        return true;
+    }
+
+    // 1つ細かいレベルの子が全て揃っていれば子で描く (近づいて細かくなったものから戻るとき)
+    if (chunk.level > 0) {
+        uint32_t childSlots[4];
+        uint32_t childCount = 0;
+        bool complete = true;
+        for (uint32_t z = chunk.z * 2; z < chunk.z * 2 + 2 && complete; ++z) {
+            for (uint32_t x = chunk.x * 2; x < chunk.x * 2 + 2; ++x) {
+                if (!quadTree_.HasNode(chunk.level - 1, x, z)) {
+                    continue;
+                }
+                auto child = slotOfNode_.find(TerrainChunk::MakeNodeKey(chunk.level - 1, x, z));
+                if (child == slotOfNode_.end()) {
+                    complete = false;
+                    break;
+                }
+                childSlots[childCount++] = child->second;
+            }
+        }
+        if (complete && childCount > 0) {
+            for (uint32_t index = 0; index < childCount; ++index) {
+                slots_[childSlots[index]].lastUsedFrame = frame_;
+                drawSlots_.push_back(childSlots[index]);
+            }
+            return true;
+        }
+    }
+
+    // 親をたどって、作ってあるメッシュで覆う (同じ親で覆うチャンクがいくつあっても1回だけ描く)
+    for (uint32_t level = chunk.level + 1; level < quadTree_.GetLevelCount(); ++level) {
+        uint32_t shift = level - chunk.level;
+        auto parent = slotOfNode_.find(TerrainChunk::MakeNodeKey(level, chunk.x >> shift, chunk.z >> shift));
+        if (parent != slotOfNode_.end()) {
+            slots_[parent->second].lastUsedFrame = frame_;
+            if (std::find(coverSlots_.begin(), coverSlots_.end(), parent->second) == coverSlots_.end()) {
+                coverSlots_.push_back(parent->second);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+void Terrain::Update(const Vector3& cameraPosition, const Matrix4x4& viewProjection) {
+    ++frame_;
+    ring_.BeginFrame();
+    stats_ = {};
+    quadTree_.Select(cameraPosition, viewProjection, chunks_);
+
+    // 頂点があるチャンクはそのまま描く
+    drawSlots_.clear();
+    missingChunks_.clear();
+    for (uint32_t index = 0; index < chunks_.size(); ++index) {
+        auto it = slotOfKey_.find(chunks_[index].GetKey());
+        if (it != slotOfKey_.end()) {
+            slots_[it->second].lastUsedFrame = frame_;
+            drawSlots_.push_back(it->second);
+        } else {
+            missingChunks_.push_back(index);
+        }
+    }
+
+    // 無いものは近い順に作る
+    // 予算を超えたら作ってあるメッシュで代わりに描き、代わりが無いものだけは穴にしないように予算を超えても作る
+    std::sort(missingChunks_.begin(), missingChunks_.end(),
+        [this](uint32_t a, uint32_t b) { return chunks_[a].distance < chunks_[b].distance; });
+    uint32_t budget = frame_ == 1 ? UINT32_MAX : buildsPerFrame;
+    uint32_t vertexCount = quadTree_.GetVertexCountPerChunk();
+    coverSlots_.clear();
+    for (uint32_t index : missingChunks_) {
+        const TerrainChunk& chunk = chunks_[index];
+        bool overBudget = stats_.builtCount >= budget;
+        if (overBudget && AddFallback(chunk)) {
+            ++stats_.fallbackCount;
+            continue;
+        }
+        uint32_t slot = AcquireSlot();
+        if (slot == UINT32_MAX) {
+            if (!overBudget && AddFallback(chunk)) {
+                ++stats_.fallbackCount;
+            }
+            continue;
+        }
+        quadTree_.BuildChunkMesh(chunk, vertexData_ + size_t(slot) * vertexCount);
+        slots_[slot] = { chunk.GetKey(), frame_ };
+        slotOfKey_[chunk.GetKey()] = slot;
+        slotOfNode_[chunk.GetNodeKey()] = slot;
+        drawSlots_.push_back(slot);
+        ++stats_.builtCount;
+    }
+
+    if (!coverSlots_.empty()) {
+        // 親で覆うところに重なる細かいメッシュ (覆う親の中の親も) は描かない
+        auto isCovered = [this](uint32_t slot) {
+            uint64_t key = slots_[slot].key;
+            uint32_t level = TerrainChunk::GetKeyLevel(key);
+            for (uint32_t cover : coverSlots_) {
+                uint64_t coverKey = slots_[cover].key;
+                uint32_t coverLevel = TerrainChunk::GetKeyLevel(coverKey);
+                if (coverLevel <= level) {
+                    continue;
+                }
+                uint32_t shift = coverLevel - level;
+                if ((TerrainChunk::GetKeyX(key) >> shift) == TerrainChunk::GetKeyX(coverKey) &&
+                    (TerrainChunk::GetKeyZ(key) >> shift) == TerrainChunk::GetKeyZ(coverKey)) {
+                    return true;
+                }
+            }
+            return false;
+        };
+        drawSlots_.erase(std::remove_if(drawSlots_.begin(), drawSlots_.end(), isCovered), drawSlots_.end());
+        for (uint32_t cover : coverSlots_) {
+            if (!isCovered(cover)) {
+                drawSlots_.push_back(cover);
+            }
+        }
+    }
+
+    stats_.selectedCount = static_cast<uint32_t>(chunks_.size());
+    stats_.drawnCount = static_cast<uint32_t>(drawSlots_.size());
+    stats_.pendingCount = static_cast<uint32_t>(missingChunks_.size()) - stats_.builtCount;
+}
+
+void Terrain::Draw(ID3D12GraphicsCommandList* commandList, const Matrix4x4& view, const Matrix4x4& projection,
+    D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandle) {
+    if (drawSlots_.empty()) {
+        return;
+    }
+    PipelineLibrary* pipelineLibrary = PipelineLibrary::GetInstance();
+    ID3D12PipelineState* pipelineState = pipelineLibrary->GetPipelineState(pipelineHandle_);
+    if (pipelineState == nullptr) {
+        return;
+    }
+
+    // 頂点はワールド座標で作ってあるので、ワールド行列は単位行列
+    UploadRing::Allocation worldAllocation;
+    UploadRing::Allocation viewProjectionAllocation;
+    if (!ring_.Allocate(sizeof(Matrix4x4), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, worldAllocation) ||
+        !ring_.Allocate(sizeof(ViewProjection), D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT, viewProjectionAllocation)) {
+        return;
+    }
+    Matrix4x4 world = MakeIdentity4x4();
+    std::memcpy(worldAllocation.cpuAddress, &world, sizeof(world));
+    ViewProjection viewProjection;
+    viewProjection.view = view;
+    viewProjection.projection = projection;
+    Matrix4x4 cameraMatrix = Inverse(view);
+    viewProjection.cameraPos = { cameraMatrix.m[3][0], cameraMatrix.m[3][1], cameraMatrix.m[3][2] };
+    std::memcpy(viewProjectionAllocation.cpuAddress, &viewProjection, sizeof(viewProjection));
+
+    commandList->SetGraphicsRootSignature(pipelineLibrary->GetRootSignature(pipelineHandle_));
+    commandList->SetPipelineState(pipelineState);
+    commandList->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    commandList->IASetIndexBuffer(&indexBufferView_);
+    commandList->IASetVertexBuffers(0, 1, &vertexBufferView_);
+    commandList->SetGraphicsRootConstantBufferView(worldRootIndex_, worldAllocation.gpuAddress);
+    commandList->SetGraphicsRootConstantBufferView(viewProjectionRootIndex_, viewProjectionAllocation.gpuAddress);
+    commandList->SetGraphicsRootDescriptorTable(textureRootIndex_, textureSrvHandle);
+    uint32_t vertexCount = quadTree_.GetVertexCountPerChunk();
+    for (uint32_t slot : drawSlots_) {
+        commandList->DrawIndexedInstanced(indexCount_, 1, 0, static_cast<INT>(slot * vertexCount), 0);
+    }
+}
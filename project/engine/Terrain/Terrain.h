@@ -0,0 +1,111 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl.h>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "Heightmap.h"
+#include "PipelineLibrary.h"
+#include "TerrainQuadTree.h"
+#include "UploadRing.h"
+
+// ハイトマップの地形 (Terrain のシェーダー)
+// Update でカメラからチャンクを選び、まだ無いチャンクの頂点を近い順に作る (1フレームに作る数は buildsPerFrame まで)
+// buildsPerFrame を超えたチャンクは、同じノードの前に作ったメッシュ (隣のレベルが違うもの) か、子か親のメッシュで代わりに描いて穴を空けない
+// 代わりに描けるものが無いチャンク (新しく見えたところ) は buildsPerFrame を超えても作る
+// チャンクの頂点はどれも同じ数なので、1つの頂点バッファを同じ大きさの枠に分けて使い、使われていない枠から使い回す
+// インデックスは全てのチャンクで共通で、チャンクごとに BaseVertexLocation だけを変えて描く
+class Terrain {
+public:
+    // 頂点を置いておけるチャンク数の初期値
+    static const uint32_t kDefaultMaxChunks = 512;
+    // 1フレームに頂点を作るチャンク数の初期値
+    static const uint32_t kDefaultBuildsPerFrame = 64;
+
+    // 直前の Update の結果
+    struct Stats {
+        uint32_t selectedCount = 0; // 選んだチャンクの数
+        uint32_t drawnCount = 0;    // 描くメッシュの数 (代わりに描くものを含む)
+        uint32_t builtCount = 0;    // 頂点を作ったチャンクの数 (buildsPerFrame を超えることがある)
+        uint32_t pendingCount = 0;  // 頂点が間に合わず、次のフレーム以降に作るチャンクの数
+        uint32_t fallbackCount = 0; // pendingCount のうち、代わりのメッシュで描いたチャンクの数
+    };
+
+public:
+    // 作成 (ハイトマップは地形が持つ。ハイトマップの (0, 0) がワールドの原点)
+    static Terrain* Create(Heightmap heightmap, const TerrainDesc& desc, ID3D12Device* device, uint32_t maxChunks = kDefaultMaxChunks);
+
+    // 描くチャンクを選び、足りない頂点を作る (描画の前に1フレームに1回呼ぶ)
+    void Update(const Vector3& cameraPosition, const Matrix4x4& viewProjection);
+
+    // Update で選んだチャンクを描く
+    void Draw(ID3D12GraphicsCommandList* commandList, const Matrix4x4& view, const Matrix4x4& projection,
+        D3D12_GPU_DESCRIPTOR_HANDLE textureSrvHandle);
+
+    const Heightmap& GetHeightmap() const { return heightmap_; }
+    const Stats& GetStats() const { return stats_; }
+
+public:
+    // 1フレームに頂点を作るチャンク数 (最初の Update だけは全て作る。代わりに描けるものが無いチャンクはこれを超えても作る)
+    uint32_t buildsPerFrame = kDefaultBuildsPerFrame;
+
+private:
+    Terrain() = default;
+    Terrain(const Terrain&) = delete;
+    const Terrain& operator=(const Terrain&) = delete;
+
+    void Initialize(Heightmap heightmap, const TerrainDesc& desc, ID3D12Device* device, uint32_t maxChunks);
+
+    // 頂点を書ける枠を探す (GPUが読んでいるかもしれない枠は使わない。無ければ UINT32_MAX)
+    uint32_t AcquireSlot();
+
+    // 頂点が間に合わないチャンクの代わりに描くメッシュを探して drawSlots_ に足す (見つからなければ false)
+    bool AddFallback(const TerrainChunk& chunk);
+
+    // Terrain.hlsli の ViewProjection
+    struct ViewProjection {
+        Matrix4x4 view;
+        Matrix4x4 projection;
+        Vector3 cameraPos;
+    };
+
+    // 頂点バッファの枠
+    struct Slot {
+        uint64_t key = 0;
+        uint64_t lastUsedFrame = 0;
+    };
+
+private:
+    Heightmap heightmap_;
+    TerrainQuadTree quadTree_;
+
+    // チャンクの頂点 (アップロードヒープにマップしたまま)
+    Microsoft::WRL::ComPtr<ID3D12Resource> vertexResource_;
+    TerrainVertex* vertexData_ = nullptr;
+    D3D12_VERTEX_BUFFER_VIEW vertexBufferView_{};
+    Microsoft::WRL::ComPtr<ID3D12Resource> indexResource_;
+    D3D12_INDEX_BUFFER_VIEW indexBufferView_{};
+    uint32_t indexCount_ = 0;
+
+    std::vector<Slot> slots_;
+    std::vector<uint32_t> freeSlots_;
+    std::unordered_map<uint64_t, uint32_t> slotOfKey_;
+    std::unordered_map<uint64_t, uint32_t> slotOfNode_; // ノードごとの最後に作った枠
+    uint64_t frame_ = 0;
+
+    // 定数バッファ (描画ごと)
+    UploadRing ring_;
+
+    // Update で選んだもの
+    std::vector<TerrainChunk> chunks_;
+    std::vector<uint32_t> missingChunks_;
+    std::vector<uint32_t> drawSlots_;
+    std::vector<uint32_t> coverSlots_; // 親のメッシュで代わりに描く枠 (その中のチャンクは描かない)
+
+    PipelineLibrary::Handle pipelineHandle_ = PipelineLibrary::kInvalidHandle;
+    uint32_t worldRootIndex_ = 0;
+    uint32_t viewProjectionRootIndex_ = 0;
+    uint32_t textureRootIndex_ = 0;
+
+    Stats stats_;
+};
@@ -0,0 +1,292 @@
+#include "TerrainQuadTree.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+const float kSampleToUnit = 1.0f / 65535.0f;
+
+float Clamp(float value, float min, float max) {
+    return value < min ? min : (value > max ? max : value);
+}
+
+uint32_t DivideRoundUp(uint32_t value, uint32_t divisor) {
+    return (value + divisor - 1) / divisor;
+}
+
+} // namespace
+
+void TerrainQuadTree::Initialize(const Heightmap* heightmap, const TerrainDesc& desc) {
+    assert(heightmap != nullptr && heightmap->GetWidth() > 1 && heightmap->GetHeight() > 1);
+    // 16bitのインデックスに収まり、レベルが上がっても格子が揃うように2のべきにする
+    assert(desc.chunkResolution >= 2 && desc.chunkResolution <= 128 && (desc.chunkResolution & (desc.chunkResolution - 1)) == 0);
+    heightmap_ = heightmap;
+    desc_ = desc;
+
+    // 最も細かいレベルから、ノードが1つになるまで
+    uint32_t width = heightmap->GetWidth();
+    uint32_t height = heightmap->GetHeight();
+    uint32_t resolution = desc.chunkResolution;
+    levels_.clear();
+    Level level0;
+    level0.nodeCountX = DivideRoundUp(width - 1, resolution);
+    level0.nodeCountZ = DivideRoundUp(height - 1, resolution);
+    level0.minHeights.resize(size_t(level0.nodeCountX) * level0.nodeCountZ);
+    level0.maxHeights.resize(level0.minHeights.size());
+    for (uint32_t nodeZ = 0; nodeZ < level0.nodeCountZ; ++nodeZ) {
+        for (uint32_t nodeX = 0; nodeX < level0.nodeCountX; ++nodeX) {
+            // ノードの格子は隣と端を共有するので、端のサンプルも含める
+            uint32_t x0 = nodeX * resolution;
+            uint32_t z0 = nodeZ * resolution;
+            uint32_t x1 = x0 + resolution < width - 1 ? x0 + resolution : width - 1;
+            uint32_t z1 = z0 + resolution < height - 1 ? z0 + resolution : height - 1;
+            uint16_t minHeight = UINT16_MAX;
+            uint16_t maxHeight = 0;
+            for (uint32_t z = z0; z <= z1; ++z) {
+                const uint16_t* row = heightmap->GetData() + size_t(z) * width;
+                for (uint32_t x = x0; x <= x1; ++x) {
+                    minHeight = row[x] < minHeight ? row[x] : minHeight;
+                    maxHeight = row[x] > maxHeight ? row[x] : maxHeight;
+                }
+            }
+            size_t index = size_t(nodeZ) * level0.nodeCountX + nodeX;
+            level0.minHeights[index] = minHeight;
+            level0.maxHeights[index] = maxHeight;
+        }
+    }
+    levels_.push_back(std::move(level0));
+
+    while (levels_.back().nodeCountX > 1 || levels_.back().nodeCountZ > 1) {
+        const Level& child = levels_.back();
+        Level parent;
+        parent.nodeCountX = DivideRoundUp(child.nodeCountX, 2);
+        parent.nodeCountZ = DivideRoundUp(child.nodeCountZ, 2);
+        parent.minHeights.assign(size_t(parent.nodeCountX) * parent.nodeCountZ, UINT16_MAX);
+        parent.maxHeights.assign(parent.minHeights.size(), 0);
+        for (uint32_t z = 0; z < child.nodeCountZ; ++z) {
+            for (uint32_t x = 0; x < child.nodeCountX; ++x) {
+                size_t childIndex = size_t(z) * child.nodeCountX + x;
+                size_t parentIndex = size_t(z / 2) * parent.nodeCountX + x / 2;
+                uint16_t minHeight = child.minHeights[childIndex];
+                uint16_t maxHeight = child.maxHeights[childIndex];
+                parent.minHeights[parentIndex] = minHeight < parent.minHeights[parentIndex] ? minHeight : parent.minHeights[parentIndex];
+                parent.maxHeights[parentIndex] = maxHeight > parent.maxHeights[parentIndex] ? maxHeight : parent.maxHeights[parentIndex];
+            }
+        }
+        levels_.push_back(std::move(parent));
+    }
+    // 隣のレベルは4bitずつキーに入れる
+    assert(levels_.size() <= 16);
+
+    ranges_.resize(levels_.size());
+    for (size_t level = 0; level < levels_.size(); ++level) {
+        ranges_[level] = desc.lodDistance * float(1u << level);
+    }
+    selectedLevels_.assign(size_t(levels_[0].nodeCountX) * levels_[0].nodeCountZ, 0xFF);
+}
+
+void TerrainQuadTree::Select(const Vector3& cameraPosition, const Matrix4x4& viewProjection, std::vector<TerrainChunk>& chunks) {
+    chunks.clear();
+    cameraPosition_ = cameraPosition;
+
+    // 視錐台の平面を行列の列から取り出す (行ベクトル × 行列。深度は 0～1)
+    const float(*m)[4] = viewProjection.m;
+    auto column = [&](int j) { return Plane{ m[0][j], m[1][j], m[2][j], m[3][j] }; };
+    auto add = [](const Plane& a, const Plane& b, float sign) {
+        return Plane{ a.a + b.a * sign, a.b + b.b * sign, a.c + b.c * sign, a.d + b.d * sign };
+    };
+    Plane w = column(3);
+    planes_[0] = add(w, column(0), 1.0f);  // 左
+    planes_[1] = add(w, column(0), -1.0f); // 右
+    planes_[2] = add(w, column(1), 1.0f);  // 下
+    planes_[3] = add(w, column(1), -1.0f); // 上
+    planes_[4] = column(2);                // 手前
+    planes_[5] = add(w, column(2), -1.0f); // 奥
+
+    uint32_t top = static_cast<uint32_t>(levels_.size()) - 1;
+    for (uint32_t z = 0; z < levels_[top].nodeCountZ; ++z) {
+        for (uint32_t x = 0; x < levels_[top].nodeCountX; ++x) {
+            SelectNode(top, x, z, chunks);
+        }
+    }
+
+    // 最も細かい格子に選んだレベルを書き、隣の方が粗い辺を調べる
+    // 粗い隣は自分の辺の全体に接するので、辺の最初の格子だけ見ればよい
+    uint32_t countX = levels_[0].nodeCountX;
+    uint32_t countZ = levels_[0].nodeCountZ;
+    std::fill(selectedLevels_.begin(), selectedLevels_.end(), uint8_t(0xFF));
+    for (const TerrainChunk& chunk : chunks) {
+        uint32_t span = 1u << chunk.level;
+        uint32_t x1 = (chunk.x + 1) * span < countX ? (chunk.x + 1) * span : countX;
+        uint32_t z1 = (chunk.z + 1) * span < countZ ? (chunk.z + 1) * span : countZ;
+        for (uint32_t z = chunk.z * span; z < z1; ++z) {
+            std::fill(selectedLevels_.begin() + size_t(z) * countX + chunk.x * span, selectedLevels_.begin() + size_t(z) * countX + x1,
+                static_cast<uint8_t>(chunk.level));
+        }
+    }
+    for (TerrainChunk& chunk : chunks) {
+        uint32_t span = 1u << chunk.level;
+        uint32_t x0 = chunk.x * span;
+        uint32_t z0 = chunk.z * span;
+        uint8_t neighbors[4] = {
+            x0 > 0 ? selectedLevels_[size_t(z0) * countX + x0 - 1] : uint8_t(0xFF),
+            x0 + span < countX ? selectedLevels_[size_t(z0) * countX + x0 + span] : uint8_t(0xFF),
+            z0 > 0 ? selectedLevels_[size_t(z0 - 1) * countX + x0] : uint8_t(0xFF),
+            z0 + span < countZ ? selectedLevels_[size_t(z0 + span) * countX + x0] : uint8_t(0xFF),
+        };
+        for (int side = 0; side < 4; ++side) {
+            // 選ばれていない (視錐台の外の) 隣は見えないので合わせない
+            bool coarser = neighbors[side] != 0xFF && neighbors[side] > chunk.level;
+            chunk.neighborLevels[side] = coarser ? neighbors[side] : static_cast<uint8_t>(chunk.level);
+        }
+    }
+}
+
+void TerrainQuadTree::SelectNode(uint32_t level, uint32_t x, uint32_t z, std::vector<TerrainChunk>& chunks) {
+    Vector3 min;
+    Vector3 max;
+    GetBounds(level, x, z, min, max);
+    if (!IsVisible(min, max)) {
+        return;
+    }
+    // 1つ細かいレベルの範囲に入っていなければ、このレベルで足りる
+    float distance = DistanceToBox(min, max);
+    if (level == 0 || distance > ranges_[level - 1]) {
+        TerrainChunk chunk;
+        chunk.level = level;
+        chunk.x = x;
+        chunk.z = z;
+        chunk.distance = distance;
+        chunks.push_back(chunk);
+        return;
+    }
+    const Level& child = levels_[level - 1];
+    for (uint32_t childZ = z * 2; childZ < z * 2 + 2 && childZ < child.nodeCountZ; ++childZ) {
+        for (uint32_t childX = x * 2; childX < x * 2 + 2 && childX < child.nodeCountX; ++childX) {
+            SelectNode(level - 1, childX, childZ, chunks);
+        }
+    }
+}
+
+void TerrainQuadTree::GetBounds(uint32_t level, uint32_t x, uint32_t z, Vector3& min, Vector3& max) const {
+    const Level& nodes = levels_[level];
+    size_t index = size_t(z) * nodes.nodeCountX + x;
+    float size = float(GetNodeSize(level));
+    float maxX = float(heightmap_->GetWidth() - 1);
+    float maxZ = float(heightmap_->GetHeight() - 1);
+    float heightScale = desc_.heightScale * kSampleToUnit;
+    min = { float(x) * size * desc_.spacing, float(nodes.minHeights[index]) * heightScale, float(z) * size * desc_.spacing };
+    max = { Clamp(float(x + 1) * size, 0.0f, maxX) * desc_.spacing, float(nodes.maxHeights[index]) * heightScale,
+        Clamp(float(z + 1) * size, 0.0f, maxZ) * desc_.spacing };
+}
+
+bool TerrainQuadTree::IsVisible(const Vector3& min, const Vector3& max) const {
+    // 平面の法線の向きで最も内側の頂点が外なら、箱は全て外
+    for (const Plane& plane : planes_) {
+        float x = plane.a >= 0.0f ? max.x : min.x;
+        float y = plane.b >= 0.0f ? max.y : min.y;
+        float z = plane.c >= 0.0f ? max.z : min.z;
+        if (plane.a * x + plane.b * y + plane.c * z + plane.d < 0.0f) {
+            return false;
+        }
+    }
+    return true;
+}
+
+float TerrainQuadTree::DistanceToBox(const Vector3& min, const Vector3& max) const {
+    float dx = cameraPosition_.x - Clamp(cameraPosition_.x, min.x, max.x);
+    float dy = cameraPosition_.y - Clamp(cameraPosition_.y, min.y, max.y);
+    float dz = cameraPosition_.z - Clamp(cameraPosition_.z, min.z, max.z);
+    return std::sqrt(dx * dx + dy * dy + dz * dz);
+}
+
+float TerrainQuadTree::GetStitchedHeight(int32_t x, int32_t z, const TerrainChunk& chunk, uint32_t i, uint32_t j) const {
+    float heightScale = desc_.heightScale * kSampleToUnit;
+    uint32_t resolution = desc_.chunkResolution;
+    uint32_t coarseLevel = chunk.level;
+    bool alongZ = false;
+    if (i == 0 && chunk.neighborLevels[0] > chunk.level) {
+        coarseLevel = chunk.neighborLevels[0];
+        alongZ = true;
+    } else if (i == resolution && chunk.neighborLevels[1] > chunk.level) {
+        coarseLevel = chunk.neighborLevels[1];
+        alongZ = true;
+    } else if (j == 0 && chunk.neighborLevels[2] > chunk.level) {
+        coarseLevel = chunk.neighborLevels[2];
+    } else if (j == resolution && chunk.neighborLevels[3] > chunk.level) {
+        coarseLevel = chunk.neighborLevels[3];
+    }
+    if (coarseLevel == chunk.level) {
+        return float(heightmap_->GetSample(x, z)) * heightScale;
+    }
+
+    // 粗い隣の辺の、両側の頂点の間を補間する (ハイトマップの外に出る頂点は隣でも端に寄せられている)
+    int32_t coarseStep = 1 << coarseLevel;
+    int32_t last = int32_t(alongZ ? heightmap_->GetHeight() : heightmap_->GetWidth()) - 1;
+    int32_t t = alongZ ? z : x;
+    t = t < last ? t : last;
+    int32_t t0 = t / coarseStep * coarseStep;
+    int32_t t1 = t0 + coarseStep < last ? t0 + coarseStep : last;
+    if (t == t0 || t1 == t0) {
+        return float(alongZ ? heightmap_->GetSample(x, t0) : heightmap_->GetSample(t0, z)) * heightScale;
+    }
+    float h0 = float(alongZ ? heightmap_->GetSample(x, t0) : heightmap_->GetSample(t0, z));
+    float h1 = float(alongZ ? heightmap_->GetSample(x, t1) : heightmap_->GetSample(t1, z));
+    float fraction = float(t - t0) / float(t1 - t0);
+    return (h0 + (h1 - h0) * fraction) * heightScale;
+}
+
+void TerrainQuadTree::BuildChunkMesh(const TerrainChunk& chunk, TerrainVertex* vertices) const {
+    uint32_t resolution = desc_.chunkResolution;
+    int32_t step = 1 << chunk.level;
+    int32_t startX = int32_t(chunk.x * GetNodeSize(chunk.level));
+    int32_t startZ = int32_t(chunk.z * GetNodeSize(chunk.level));
+    int32_t lastX = int32_t(heightmap_->GetWidth()) - 1;
+    int32_t lastZ = int32_t(heightmap_->GetHeight()) - 1;
+    float heightScale = desc_.heightScale * kSampleToUnit;
+    // 法線はこのLODの間隔の差分で求める (遠くのチャンクほど滑らかになる)
+    float normalY = 2.0f * float(step) * desc_.spacing;
+
+    TerrainVertex* out = vertices;
+    for (uint32_t j = 0; j <= resolution; ++j) {
+        int32_t z = startZ + int32_t(j) * step;
+        for (uint32_t i = 0; i <= resolution; ++i) {
+            int32_t x = startX + int32_t(i) * step;
+            // ハイトマップの外は端に寄せる (面積のない三角形になる)
+            float positionX = float(x < lastX ? x : lastX) * desc_.spacing;
+            float positionZ = float(z < lastZ ? z : lastZ) * desc_.spacing;
+            out->position = { positionX, GetStitchedHeight(x, z, chunk, i, j), positionZ };
+
+            float left = float(heightmap_->GetSample(x - step, z));
+            float right = float(heightmap_->GetSample(x + step, z));
+            float back = float(heightmap_->GetSample(x, z - step));
+            float front = float(heightmap_->GetSample(x, z + step));
+            Vector3 normal = { (left - right) * heightScale, normalY, (back - front) * heightScale };
+            float inverseLength = 1.0f / std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+            out->normal = { normal.x * inverseLength, normal.y * inverseLength, normal.z * inverseLength };
+
+            out->texcoord = { float(x) * desc_.texcoordScale, float(z) * desc_.texcoordScale };
+            ++out;
+        }
+    }
+}
+
+std::vector<uint16_t> TerrainQuadTree::MakeIndices(uint32_t chunkResolution) {
+    std::vector<uint16_t> indices;
+    indices.reserve(size_t(chunkResolution) * chunkResolution * 6);
+    uint32_t stride = chunkResolution + 1;
+    for (uint32_t j = 0; j < chunkResolution; ++j) {
+        for (uint32_t i = 0; i < chunkResolution; ++i) {
+            // 上から見て時計回り (+z が奥)
+            uint16_t v00 = static_cast<uint16_t>(j * stride + i);
+            uint16_t v10 = static_cast<uint16_t>(v00 + 1);
+            uint16_t v01 = static_cast<uint16_t>(v00 + stride);
+            uint16_t v11 = static_cast<uint16_t>(v01 + 1);
+            const uint16_t quad[6] = { v00, v01, v10, v10, v01, v11 };
+            indices.insert(indices.end(), quad, quad + 6);
+        }
+    }
+    return indices;
+}
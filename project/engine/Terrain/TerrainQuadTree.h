@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Heightmap.h"
+#include "MathTypes.h"
+
+// 地形の設定
+struct TerrainDesc {
+    float spacing = 1.0f;               // サンプル間の距離 (XZ)
+    float heightScale = 64.0f;          // サンプルが最大値 (65535) のときの高さ
+    float texcoordScale = 1.0f / 32.0f; // サンプル1つ分のUV (テクスチャはラップで繰り返す)
+    uint32_t chunkResolution = 32;      // チャンクの一辺の四角形の数 (2のべき。どのLODでも同じ)
+    float lodDistance = 48.0f;          // 最も細かいLODを使う距離 (LODが1つ粗くなるごとに2倍)
+};
+
+// Terrain.hlsli の頂点
+struct TerrainVertex {
+    Vector3 position;
+    Vector3 normal;
+    Vector2 texcoord;
+};
+
+// 選んだチャンク (四分木のノード)
+struct TerrainChunk {
+    uint32_t level = 0; // 0 が最も細かい
+    uint32_t x = 0;     // そのレベルでのノードの位置
+    uint32_t z = 0;
+    // 隣 (-x, +x, -z, +z) のレベル。隣の方が粗いときだけその値で、それ以外は自分と同じ
+    // 粗い隣に接する辺の頂点は、隣の頂点の間を直線で結んだ高さにしてひびを塞ぐ
+    uint8_t neighborLevels[4] = {};
+    float distance = 0.0f; // カメラからの距離 (ノードの箱まで)
+
+    // メッシュを見分けるキー (隣のレベルが変わると別のメッシュになる)
+    uint64_t GetKey() const {
+        uint64_t stitch = uint64_t(neighborLevels[0]) | (uint64_t(neighborLevels[1]) << 4) | (uint64_t(neighborLevels[2]) << 8) |
+                          (uint64_t(neighborLevels[3]) << 12);
+        return MakeNodeKey(level, x, z) | (stitch << 40);
+    }
+    // ノードを見分けるキー (隣のレベルは含まない)
+    uint64_t GetNodeKey() const { return MakeNodeKey(level, x, z); }
+
+    static uint64_t MakeNodeKey(uint32_t level, uint32_t x, uint32_t z) {
+        return (uint64_t(level) << 60) | (uint64_t(x) << 20) | uint64_t(z);
+    }
+    // キーからノードの位置を取り出す (GetKey と GetNodeKey のどちらでも)
+    static uint32_t GetKeyLevel(uint64_t key) { return static_cast<uint32_t>(key >> 60); }
+    static uint32_t GetKeyX(uint64_t key) { return static_cast<uint32_t>((key >> 20) & 0xFFFFF); }
+    static uint32_t GetKeyZ(uint64_t key) { return static_cast<uint32_t>(key & 0xFFFFF); }
+};
+
+// ハイトマップの四分木 (チャンク単位のLOD)
+// どのレベルのノードも chunkResolution x chunkResolution の同じ格子で、レベルが1つ上がるごとにサンプルの間隔が2倍になる
+// カメラからの距離でノードを選び、隣との差は辺の頂点を合わせて繋ぐ (インデックスは全てのチャンクで共通)
+// GPUに依存しない
+class TerrainQuadTree {
+public:
+    // 四分木を作る (ノードごとの高さの範囲を求める。heightmap は使い終わるまで残しておくこと)
+    void Initialize(const Heightmap* heightmap, const TerrainDesc& desc);
+
+    // 描くチャンクを選ぶ (視錐台の外は選ばない)
+    // cameraPosition と viewProjection は地形の座標系 (ハイトマップの (0, 0) が原点)
+    void Select(const Vector3& cameraPosition, const Matrix4x4& viewProjection, std::vector<TerrainChunk>& chunks);
+
+    // チャンクの頂点を作る (GetVertexCountPerChunk 個)
+    void BuildChunkMesh(const TerrainChunk& chunk, TerrainVertex* vertices) const;
+
+    // ノードの箱
+    void GetBounds(uint32_t level, uint32_t x, uint32_t z, Vector3& min, Vector3& max) const;
+
+    uint32_t GetVertexCountPerChunk() const { return (desc_.chunkResolution + 1) * (desc_.chunkResolution + 1); }
+    uint32_t GetLevelCount() const { return static_cast<uint32_t>(levels_.size()); }
+    // そのノードがあるか (端のノードは子が4つ揃っていないことがある)
+    bool HasNode(uint32_t level, uint32_t x, uint32_t z) const {
+        return level < levels_.size() && x < levels_[level].nodeCountX && z < levels_[level].nodeCountZ;
+    }
+    // ノードの一辺のサンプル数
+    uint32_t GetNodeSize(uint32_t level) const { return desc_.chunkResolution << level; }
+    const TerrainDesc& GetDesc() const { return desc_; }
+
+    // 全てのチャンクで共通のインデックス (三角形リスト)
+    static std::vector<uint16_t> MakeIndices(uint32_t chunkResolution);
+
+private:
+    // レベルごとのノードの高さの範囲
+    struct Level {
+        uint32_t nodeCountX = 0;
+        uint32_t nodeCountZ = 0;
+        std::vector<uint16_t> minHeights;
+        std::vector<uint16_t> maxHeights;
+    };
+
+    // 視錐台の平面 (ax + by + cz + d >= 0 が内側)
+    struct Plane {
+        float a, b, c, d;
+    };
+
+    void SelectNode(uint32_t level, uint32_t x, uint32_t z, std::vector<TerrainChunk>& chunks);
+    bool IsVisible(const Vector3& min, const Vector3& max) const;
+    float DistanceToBox(const Vector3& min, const Vector3& max) const;
+
+    // サンプルの高さ (粗い隣に接する辺は隣の頂点の間を補間する)
+    float GetStitchedHeight(int32_t x, int32_t z, const TerrainChunk& chunk, uint32_t i, uint32_t j) const;
+
+private:
+    const Heightmap* heightmap_ = nullptr;
+    TerrainDesc desc_;
+    std::vector<Level> levels_;
+    std::vector<float> ranges_; // レベルごとの、そのレベルで足りる距離
+
+    // Select の途中の状態
+    Vector3 cameraPosition_{};
+    Plane planes_[6] = {};
+    // 最も細かいノードの格子ごとの、選んだレベル (0xFF は選んでいない)
+    std::vector<uint8_t> selectedLevels_;
+};
@@ -0,0 +1,353 @@
+#include "MipGenerator.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstring>
+#include "JobSystem.h"
+
+#if defined(_M_X64) || defined(__SSE2__)
+#include <emmintrin.h>
+#define MIP_GENERATOR_USE_SSE 1
+#endif
+
+namespace {
+
+// 線形空間の画像 (1画素 = float4)
+struct FloatImage {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<float> texels;
+
+    float* Row(uint32_t y) { return texels.data() + size_t(y) * width * 4; }
+    const float* Row(uint32_t y) const { return texels.data() + size_t(y) * width * 4; }
+};
+
+// カイザーフィルタの片側の半径 (縮小後の画素単位) とタップ数
+constexpr float kKaiserRadius = 3.0f;
+constexpr float kKaiserBeta = 4.0f;
+constexpr int kKaiserTapCount = 12;
+constexpr int kKaiserFirstTap = -5;
+
+// 変換テーブル
+constexpr int kLinearToSrgbTableSize = 4096;
+
+const std::array<float, 256>& GetSrgbToLinearTable() {
+    static const std::array<float, 256> table = [] {
+        std::array<float, 256> t{};
+        for (int i = 0; i < 256; ++i) {
+            float c = i / 255.0f;
+            t[i] = c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+        }
+        return t;
+    }();
+    return table;
+}
+
+const std::array<uint8_t, kLinearToSrgbTableSize>& GetLinearToSrgbTable() {
+    static const std::array<uint8_t, kLinearToSrgbTableSize> table = [] {
+        std::array<uint8_t, kLinearToSrgbTableSize> t{};
+        for (int i = 0; i < kLinearToSrgbTableSize; ++i) {
+            float l = i / float(kLinearToSrgbTableSize - 1);
+            float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+            t[i] = static_cast<uint8_t>(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+        }
+        return t;
+    }();
+    return table;
+}
+
+// 第1種変形ベッセル関数 (級数展開)
+float BesselI0(float x) {
+    float sum = 1.0f;
+    float term = 1.0f;
+    for (int k = 1; k < 20; ++k) {
+        term *= (x / (2.0f * k)) * (x / (2.0f * k));
+        sum += term;
+    }
+    return sum;
+}
+
+// 2分の1縮小用のカイザー窓付きsincの重み (正規化済み)
+const std::array<float, kKaiserTapCount>& GetKaiserWeights() {
+    static const std::array<float, kKaiserTapCount> weights = [] {
+        std::array<float, kKaiserTapCount> w{};
+        const float pi = 3.14159265358979f;
+        float total = 0.0f;
+        for (int i = 0; i < kKaiserTapCount; ++i) {
+            // 出力画素の中心からの距離 (出力画素単位)
+            float d = (kKaiserFirstTap + i - 0.5f) * 0.5f;
+            float sinc = d == 0.0f ? 1.0f : std::sin(pi * d) / (pi * d);
+            float r = d / kKaiserRadius;
+            float window = std::abs(r) >= 1.0f ? 0.0f : BesselI0(kKaiserBeta * std::sqrt(1.0f - r * r)) / BesselI0(kKaiserBeta);
+            w[i] = sinc * window;
+            total += w[i];
+        }
+        for (float& v : w) {
+            v /= total;
+        }
+        return w;
+    }();
+    return weights;
+}
+
+// [0, count) を JobSystem で分けて処理する (minRows は1回に渡す行数の下限)
+// 並列にしないときや JobSystem が無いときは呼んだスレッドで全て処理する
+template <typename Function>
+void ParallelFor(uint32_t count, bool parallel, uint32_t minRows, const Function& function) {
+    JobSystem* jobSystem = JobSystem::GetInstance();
+    if (!parallel || jobSystem->GetWorkerCount() <= 1 || count < minRows * 2) {
+        function(0u, count);
+        return;
+    }
+    jobSystem->ParallelFor(0, count, minRows, function);
+}
+
+// 4チャンネル分の積和 (dst += src * weight)
+inline void MultiplyAdd4(float* dst, const float* src, float weight) {
+#ifdef MIP_GENERATOR_USE_SSE
+    _mm_storeu_ps(dst, _mm_add_ps(_mm_loadu_ps(dst), _mm_mul_ps(_mm_loadu_ps(src), _mm_set1_ps(weight))));
+#else
+    for (int c = 0; c < 4; ++c) {
+        dst[c] += src[c] * weight;
+    }
+#endif
+}
+
+// 4画素の平均
+inline void Average4(float* dst, const float* a, const float* b, const float* c, const float* d) {
+#ifdef MIP_GENERATOR_USE_SSE
+    __m128 sum = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(a), _mm_loadu_ps(b)), _mm_add_ps(_mm_loadu_ps(c), _mm_loadu_ps(d)));
+    _mm_storeu_ps(dst, _mm_mul_ps(sum, _mm_set1_ps(0.25f)));
+#else
+    for (int i = 0; i < 4; ++i) {
+        dst[i] = (a[i] + b[i] + c[i] + d[i]) * 0.25f;
+    }
+#endif
+}
+
+// [0, 1]に収める
+inline void Saturate4(float* texel) {
+#ifdef MIP_GENERATOR_USE_SSE
+    _mm_storeu_ps(texel, _mm_min_ps(_mm_max_ps(_mm_loadu_ps(texel), _mm_setzero_ps()), _mm_set1_ps(1.0f)));
+#else
+    for (int i = 0; i < 4; ++i) {
+        texel[i] = std::clamp(texel[i], 0.0f, 1.0f);
+    }
+#endif
+}
+
+// 2x2平均で縮小
+void DownsampleBox(const FloatImage& src, FloatImage& dst, bool parallel) {
+    ParallelFor(dst.height, parallel, 16, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; ++y) {
+            const float* row0 = src.Row(std::min(y * 2, src.height - 1));
+            const float* row1 = src.Row(std::min(y * 2 + 1, src.height - 1));
+            float* out = dst.Row(y);
+            for (uint32_t x = 0; x < dst.width; ++x) {
+                uint32_t x0 = std::min(x * 2, src.width - 1) * 4;
+                uint32_t x1 = std::min(x * 2 + 1, src.width - 1) * 4;
+                Average4(out + x * 4, row0 + x0, row0 + x1, row1 + x0, row1 + x1);
+            }
+        }
+    });
+}
+
+// カイザーフィルタで縮小 (横→縦の分離フィルタ)
+void DownsampleKaiser(const FloatImage& src, FloatImage& dst, bool parallel) {
+    const std::array<float, kKaiserTapCount>& weights = GetKaiserWeights();
+
+    // 横方向
+    FloatImage temp;
+    temp.width = dst.width;
+    temp.height = src.height;
+    temp.texels.assign(size_t(temp.width) * temp.height * 4, 0.0f);
+    ParallelFor(temp.height, parallel, 16, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; ++y) {
+            const float* in = src.Row(y);
+            float* out = temp.Row(y);
+            for (uint32_t x = 0; x < temp.width; ++x) {
+                if (src.width == 1) {
+                    std::memcpy(out, in, sizeof(float) * 4);
+                    continue;
+                }
+                for (int tap = 0; tap < kKaiserTapCount; ++tap) {
+                    int sx = std::clamp(int(x * 2) + kKaiserFirstTap + tap, 0, int(src.width) - 1);
+                    MultiplyAdd4(out + x * 4, in + sx * 4, weights[tap]);
+                }
+            }
+        }
+    });
+
+    // 縦方向
+    std::fill(dst.texels.begin(), dst.texels.end(), 0.0f);
+    ParallelFor(dst.height, parallel, 16, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; ++y) {
+            float* out = dst.Row(y);
+            for (int tap = 0; tap < kKaiserTapCount; ++tap) {
+                int sy = src.height == 1 ? 0 : std::clamp(int(y * 2) + kKaiserFirstTap + tap, 0, int(src.height) - 1);
+                float weight = src.height == 1 ? (tap == 0 ? 1.0f : 0.0f) : weights[tap];
+                if (weight == 0.0f) {
+                    continue;
+                }
+                const float* in = temp.Row(sy);
+                for (uint32_t x = 0; x < dst.width; ++x) {
+                    MultiplyAdd4(out + x * 4, in + x * 4, weight);
+                }
+            }
+            // 負のローブで範囲外になった値を戻す
+            for (uint32_t x = 0; x < dst.width; ++x) {
+                Saturate4(out + x * 4);
+            }
+        }
+    });
+}
+
+// アルファが閾値を超える画素の割合
+float CalcAlphaCoverage(const FloatImage& image, float alphaCutoff, float scale) {
+    size_t covered = 0;
+    size_t count = size_t(image.width) * image.height;
+    for (size_t i = 0; i < count; ++i) {
+        if (image.texels[i * 4 + 3] * scale > alphaCutoff) {
+            ++covered;
+        }
+    }
+    return float(covered) / float(count);
+}
+
+// 元画像と同じカバレッジになるアルファの倍率を二分探索で求める
+float FindAlphaScale(const FloatImage& image, float alphaCutoff, float targetCoverage) {
+    float low = 0.0f;
+    float high = 4.0f;
+    float bestScale = 1.0f;
+    float bestError = std::abs(CalcAlphaCoverage(image, alphaCutoff, 1.0f) - targetCoverage);
+    for (int i = 0; i < 12; ++i) {
+        float scale = (low + high) * 0.5f;
+        float coverage = CalcAlphaCoverage(image, alphaCutoff, scale);
+        float error = std::abs(coverage - targetCoverage);
+        if (error < bestError) {
+            bestError = error;
+            bestScale = scale;
+        }
+        if (coverage < targetCoverage) {
+            low = scale;
+        } else {
+            high = scale;
+        }
+    }
+    return bestScale;
+}
+
+// RGBA8 → 線形のfloat4
+void ConvertToFloat(const uint8_t* pixels, uint32_t rowPitch, bool srgb, FloatImage& image, bool parallel) {
+    const std::array<float, 256>& toLinear = GetSrgbToLinearTable();
+    ParallelFor(image.height, parallel, 32, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; ++y) {
+            const uint8_t* in = pixels + size_t(y) * rowPitch;
+            float* out = image.Row(y);
+            for (uint32_t x = 0; x < image.width * 4; x += 4) {
+                for (int c = 0; c < 3; ++c) {
+                    out[x + c] = srgb ? toLinear[in[x + c]] : in[x + c] / 255.0f;
+                }
+                out[x + 3] = in[x + 3] / 255.0f;
+            }
+        }
+    });
+}
+
+// 線形のfloat4 → RGBA8
+void ConvertToUnorm(const FloatImage& image, bool srgb, float alphaScale, MipLevel& level, bool parallel) {
+    const std::array<uint8_t, kLinearToSrgbTableSize>& toSrgb = GetLinearToSrgbTable();
+    ParallelFor(image.height, parallel, 32, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t y = begin; y < end; ++y) {
+            const float* in = image.Row(y);
+            uint8_t* out = level.pixels.data() + size_t(y) * level.width * 4;
+            for (uint32_t x = 0; x < image.width * 4; x += 4) {
+                for (int c = 0; c < 3; ++c) {
+                    float v = std::clamp(in[x + c], 0.0f, 1.0f);
+                    out[x + c] = srgb ? toSrgb[int(v * (kLinearToSrgbTableSize - 1) + 0.5f)] : uint8_t(v * 255.0f + 0.5f);
+                }
+                out[x + 3] = uint8_t(std::clamp(in[x + 3] * alphaScale, 0.0f, 1.0f) * 255.0f + 0.5f);
+            }
+        }
+    });
+}
+
+} // namespace
+
+uint32_t CalcMipLevelCount(uint32_t width, uint32_t height) {
+    uint32_t levels = 1;
+    while (width > 1 || height > 1) {
+        width = std::max(1u, width / 2);
+        height = std::max(1u, height / 2);
+        ++levels;
+    }
+    return levels;
+}
+
+std::vector<MipLevel> GenerateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t rowPitch,
+    const MipGenerateSettings& settings) {
+    uint32_t levelCount = CalcMipLevelCount(width, height);
+    std::vector<MipLevel> levels(levelCount);
+
+    // 0段目はそのままコピー
+    levels[0].width = width;
+    levels[0].height = height;
+    levels[0].pixels.resize(size_t(width) * height * 4);
+    for (uint32_t y = 0; y < height; ++y) {
+        std::memcpy(levels[0].pixels.data() + size_t(y) * width * 4, pixels + size_t(y) * rowPitch, size_t(width) * 4);
+    }
+    if (levelCount == 1) {
+        return levels;
+    }
+
+    FloatImage current;
+    current.width = width;
+    current.height = height;
+    current.texels.resize(size_t(width) * height * 4);
+    ConvertToFloat(pixels, rowPitch, settings.srgb, current, settings.parallel);
+
+    float targetCoverage = settings.preserveAlphaCoverage ? CalcAlphaCoverage(current, settings.alphaCutoff, 1.0f) : 0.0f;
+
+    for (uint32_t mip = 1; mip < levelCount; ++mip) {
+        FloatImage next;
+        next.width = std::max(1u, current.width / 2);
+        next.height = std::max(1u, current.height / 2);
+        next.texels.resize(size_t(next.width) * next.height * 4);
+        if (settings.filter == MipFilter::kKaiser) {
+            DownsampleKaiser(current, next, settings.parallel);
+        } else {
+            DownsampleBox(current, next, settings.parallel);
+        }
+
+        // 縮小でアルファテストを通る面積が減らないように、出力するアルファだけを拡大する
+        float alphaScale = settings.preserveAlphaCoverage ? FindAlphaScale(next, settings.alphaCutoff, targetCoverage) : 1.0f;
+
+        MipLevel& level = levels[mip];
+        level.width = next.width;
+        level.height = next.height;
+        level.pixels.resize(size_t(next.width) * next.height * 4);
+        ConvertToUnorm(next, settings.srgb, alphaScale, level, settings.parallel);
+
+        current = std::move(next);
+    }
+    return levels;
+}
+
+bool IsCutoutTexture(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t rowPitch) {
+    size_t transparent = 0;
+    size_t intermediate = 0;
+    for (uint32_t y = 0; y < height; ++y) {
+        const uint8_t* row = pixels + size_t(y) * rowPitch;
+        for (uint32_t x = 0; x < width; ++x) {
+            uint8_t alpha = row[x * 4 + 3];
+            if (alpha < 16) {
+                ++transparent;
+            } else if (alpha < 240) {
+                ++intermediate;
+            }
+        }
+    }
+    size_t count = size_t(width) * height;
+    // 抜けがあり、中間のアルファが5%未満
+    return transparent > 0 && intermediate * 20 < count;
+}
@@ -0,0 +1,39 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+// CPUでのミップマップ生成 (RGBA8)
+// sRGBテクスチャは線形空間に変換してから縮小する。行単位で JobSystem のワーカーに分け、画素はSSEで4チャンネルまとめて処理する
+// Windows/DirectXTexに依存しないので、クッカーと実行時の両方から使える
+
+// 縮小フィルタ
+enum class MipFilter {
+    kBox,    // 2x2平均 (速い)
+    kKaiser, // カイザー窓付きsinc (ぼやけにくい)
+};
+
+// 生成設定
+struct MipGenerateSettings {
+    MipFilter filter = MipFilter::kBox;
+    bool srgb = true;                   // RGBがsRGBで格納されている
+    bool preserveAlphaCoverage = false; // アルファテスト用にカバレッジを保つ
+    float alphaCutoff = 0.5f;           // アルファテストの閾値
+    bool parallel = true;               // JobSystem で行を分ける (初期化されていなければ呼んだスレッドだけで処理する)
+};
+
+// ミップ1段分
+struct MipLevel {
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> pixels; // RGBA8 (行ピッチは width * 4)
+};
+
+// ミップの段数 (1x1まで)
+uint32_t CalcMipLevelCount(uint32_t width, uint32_t height);
+
+// ミップチェーンの生成 (0段目は元画像のコピー)
+std::vector<MipLevel> GenerateMipChain(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t rowPitch,
+    const MipGenerateSettings& settings);
+
+// カットアウト用テクスチャか (アルファがほぼ0か255のみで、抜けている部分がある)
+bool IsCutoutTexture(const uint8_t* pixels, uint32_t width, uint32_t height, uint32_t rowPitch);
@@ -0,0 +1,291 @@
+#include "TextureCooker.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+namespace {
+
+// 経過時間をミリ秒で返す
+double ElapsedMilliseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 法線マップかどうか (ファイル名の末尾で判定)
+bool IsNormalMap(const std::filesystem::path& sourcePath) {
+    std::string stem = sourcePath.stem().string();
+    for (const char* suffix : { "_normal", "_Normal", "_n", "_N" }) {
+        std::string s = suffix;
+        if (stem.size() > s.size() && stem.compare(stem.size() - s.size(), s.size(), s) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+// RGBA8でミップを全て持った場合のサイズ
+uint64_t CalcUncompressedBytes(size_t width, size_t height, size_t mipLevels) {
+    uint64_t bytes = 0;
+    for (size_t mip = 0; mip < mipLevels; ++mip) {
+        bytes += uint64_t(width) * height * 4;
+        width = width > 1 ? width / 2 : 1;
+        height = height > 1 ? height / 2 : 1;
+    }
+    return bytes;
+}
+
+// 目録のキー
+std::string GetManifestKey(const std::filesystem::path& sourcePath) {
+    return sourcePath.lexically_normal().generic_string();
+}
+
+std::filesystem::path GetManifestPath() {
+    return std::filesystem::path(kCookedTextureDirectory) / kCookedTextureManifestName;
+}
+
+} // namespace
+
+uint64_t HashTextureSource(const std::filesystem::path& sourcePath) {
+    std::ifstream file(sourcePath, std::ios::binary);
+    if (!file.is_open()) {
+        return 0;
+    }
+    uint64_t hash = 14695981039346656037ull;
+    auto mix = [&hash](const unsigned char* data, size_t size) {
+        for (size_t i = 0; i < size; ++i) {
+            hash ^= data[i];
+            hash *= 1099511628211ull;
+        }
+    };
+    uint32_t version = kTextureCookVersion;
+    mix(reinterpret_cast<const unsigned char*>(&version), sizeof(version));
+
+    std::vector<char> buffer(64 * 1024);
+    while (file) {
+        file.read(buffer.data(), buffer.size());
+        mix(reinterpret_cast<const unsigned char*>(buffer.data()), static_cast<size_t>(file.gcount()));
+    }
+    return hash;
+}
+
+std::filesystem::path GetCookedTexturePath(const std::filesystem::path& sourcePath, uint64_t contentHash) {
+    char hashText[17] = {};
+    std::snprintf(hashText, sizeof(hashText), "%016llx", static_cast<unsigned long long>(contentHash));
+    std::filesystem::path cookedPath = std::filesystem::path(kCookedTextureDirectory) / sourcePath.relative_path().parent_path();
+    return cookedPath / (sourcePath.stem().string() + "_" + hashText + ".dds");
+}
+
+bool GetTextureSourceStamp(const std::filesystem::path& sourcePath, uint64_t* fileSize, int64_t* writeTime) {
+    std::error_code ec;
+    uint64_t size = std::filesystem::file_size(sourcePath, ec);
+    if (ec) {
+        return false;
+    }
+    std::filesystem::file_time_type time = std::filesystem::last_write_time(sourcePath, ec);
+    if (ec) {
+        return false;
+    }
+    *fileSize = size;
+    *writeTime = static_cast<int64_t>(time.time_since_epoch().count());
+    return true;
+}
+
+TextureManifest LoadTextureManifest() {
+    // 1行に「ハッシュ(16進) サイズ 更新時刻 パス」
+    TextureManifest manifest;
+    std::ifstream file(GetManifestPath());
+    std::string line;
+    while (std::getline(file, line)) {
+        std::istringstream stream(line);
+        TextureManifestEntry entry;
+        std::string path;
+        stream >> std::hex >> entry.contentHash >> std::dec >> entry.fileSize >> entry.writeTime;
+        stream >> std::ws;
+        std::getline(stream, path);
+        if (stream.fail() || path.empty()) {
+            continue;
+        }
+        manifest[path] = entry;
+    }
+    return manifest;
+}
+
+bool SaveTextureManifest(const TextureManifest& manifest) {
+    std::error_code ec;
+    std::filesystem::create_directories(kCookedTextureDirectory, ec);
+    std::ofstream file(GetManifestPath(), std::ios::trunc);
+    if (!file.is_open()) {
+        return false;
+    }
+    for (const auto& [path, entry] : manifest) {
+        file << std::hex << entry.contentHash << std::dec << ' ' << entry.fileSize << ' ' << entry.writeTime << ' ' << path << '\n';
+    }
+    return bool(file);
+}
+
+std::filesystem::path FindCookedTexture(const std::string& filePath) {
+    std::filesystem::path sourcePath(filePath);
+    if (sourcePath.extension() == ".dds") {
+        return sourcePath;
+    }
+    // 目録は最初の1回だけ読む (ストリーマーの複数のワーカーから呼ばれる)
+    static const TextureManifest manifest = LoadTextureManifest();
+
+    uint64_t hash = 0;
+    uint64_t fileSize = 0;
+    int64_t writeTime = 0;
+    auto it = manifest.find(GetManifestKey(sourcePath));
+    if (it != manifest.end() && GetTextureSourceStamp(sourcePath, &fileSize, &writeTime) &&
+        it->second.fileSize == fileSize && it->second.writeTime == writeTime) {
+        hash = it->second.contentHash;
+    } else {
+        // クックの後に触られた (中身は同じかもしれない) か、目録に無い
+        hash = HashTextureSource(sourcePath);
+    }
+    if (hash == 0) {
+        return {};
+    }
+    std::filesystem::path cookedPath = GetCookedTexturePath(sourcePath, hash);
+    std::error_code ec;
+    if (!std::filesystem::exists(cookedPath, ec)) {
+        return {};
+    }
+    return cookedPath;
+}
+
+DXGI_FORMAT SelectCookedTextureFormat(const std::filesystem::path& sourcePath, const DirectX::ScratchImage& image) {
+    const DirectX::TexMetadata& metadata = image.GetMetadata();
+    // ブロック圧縮は4x4単位なので、端数のあるテクスチャはそのまま
+    if (metadata.width % 4 != 0 || metadata.height % 4 != 0) {
+        return metadata.format;
+    }
+    if (IsNormalMap(sourcePath)) {
+        return DXGI_FORMAT_BC5_UNORM;
+    }
+    if (image.IsAlphaAllOpaque()) {
+        return DXGI_FORMAT_BC1_UNORM_SRGB;
+    }
+    return DXGI_FORMAT_BC7_UNORM_SRGB;
+}
+
+HRESULT GenerateTextureMipMaps(const DirectX::ScratchImage& image, MipFilter filter, DirectX::ScratchImage& mipImages, bool parallel) {
+    const DirectX::TexMetadata& metadata = image.GetMetadata();
+    bool srgb = DirectX::IsSRGB(metadata.format);
+    bool rgba8 = metadata.format == DXGI_FORMAT_R8G8B8A8_UNORM || metadata.format == DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+    if (!rgba8 || metadata.dimension != DirectX::TEX_DIMENSION_TEXTURE2D || metadata.arraySize != 1 || metadata.mipLevels != 1) {
+        return DirectX::GenerateMipMaps(image.GetImages(), image.GetImageCount(), metadata,
+            srgb ? DirectX::TEX_FILTER_SRGB : DirectX::TEX_FILTER_DEFAULT, 0, mipImages);
+    }
+
+    const DirectX::Image* source = image.GetImage(0, 0, 0);
+    MipGenerateSettings settings;
+    settings.filter = filter;
+    settings.srgb = srgb;
+    settings.parallel = parallel;
+    settings.preserveAlphaCoverage = IsCutoutTexture(source->pixels, uint32_t(source->width), uint32_t(source->height), uint32_t(source->rowPitch));
+    std::vector<MipLevel> levels = GenerateMipChain(source->pixels, uint32_t(source->width), uint32_t(source->height), uint32_t(source->rowPitch), settings);
+
+    HRESULT hr = mipImages.Initialize2D(metadata.format, metadata.width, metadata.height, 1, levels.size());
+    if (FAILED(hr)) {
+        return hr;
+    }
+    for (size_t mip = 0; mip < levels.size(); ++mip) {
+        const DirectX::Image* destination = mipImages.GetImage(mip, 0, 0);
+        const MipLevel& level = levels[mip];
+        for (uint32_t y = 0; y < level.height; ++y) {
+            std::memcpy(destination->pixels + y * destination->rowPitch, level.pixels.data() + size_t(y) * level.width * 4, size_t(level.width) * 4);
+        }
+    }
+    return S_OK;
+}
+
+HRESULT CookTexture(const std::filesystem::path& sourcePath, const TextureManifestEntry* previous, TextureCookResult& result) {
+    result = {};
+    std::error_code ec;
+    result.sourceFileBytes = std::filesystem::file_size(sourcePath, ec);
+    // 読んでいる間に書き換えられても古い時刻が残るよう、ハッシュより先に時刻を取る
+    if (!GetTextureSourceStamp(sourcePath, &result.manifestEntry.fileSize, &result.manifestEntry.writeTime)) {
+        return E_FAIL;
+    }
+    uint64_t hash = HashTextureSource(sourcePath);
+    if (hash == 0) {
+        return E_FAIL;
+    }
+    result.manifestEntry.contentHash = hash;
+    result.cookedPath = GetCookedTexturePath(sourcePath, hash);
+    result.upToDate = std::filesystem::exists(result.cookedPath, ec);
+
+    // 実行時と同じ読み込み (比較用に毎回計測する)
+    bool normalMap = IsNormalMap(sourcePath);
+    auto start = std::chrono::steady_clock::now();
+    DirectX::ScratchImage image{};
+    HRESULT hr = DirectX::LoadFromWICFile(sourcePath.c_str(),
+        normalMap ? DirectX::WIC_FLAGS_IGNORE_SRGB : DirectX::WIC_FLAGS_FORCE_SRGB, nullptr, image);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    result.decodeMilliseconds = ElapsedMilliseconds(start);
+
+    // DirectXTexのミップ生成 (比較用)
+    start = std::chrono::steady_clock::now();
+    DirectX::ScratchImage directXTexMipImages{};
+    hr = DirectX::GenerateMipMaps(image.GetImages(), image.GetImageCount(), image.GetMetadata(),
+        normalMap ? DirectX::TEX_FILTER_DEFAULT : DirectX::TEX_FILTER_SRGB, 0, directXTexMipImages);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    result.directXTexMipMilliseconds = ElapsedMilliseconds(start);
+
+    // クックではカイザーフィルタを使う
+    start = std::chrono::steady_clock::now();
+    DirectX::ScratchImage mipImages{};
+    hr = GenerateTextureMipMaps(image, MipFilter::kKaiser, mipImages);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    result.mipMilliseconds = ElapsedMilliseconds(start);
+    const DirectX::TexMetadata& mipMetadata = mipImages.GetMetadata();
+    result.uncompressedBytes = CalcUncompressedBytes(mipMetadata.width, mipMetadata.height, mipMetadata.mipLevels);
+
+    if (!result.upToDate) {
+        start = std::chrono::steady_clock::now();
+        DXGI_FORMAT format = SelectCookedTextureFormat(sourcePath, image);
+        DirectX::ScratchImage compressedImages{};
+        const DirectX::ScratchImage* output = &mipImages;
+        if (DirectX::IsCompressed(format)) {
+            hr = DirectX::Compress(mipImages.GetImages(), mipImages.GetImageCount(), mipMetadata, format,
+                DirectX::TEX_COMPRESS_PARALLEL, DirectX::TEX_THRESHOLD_DEFAULT, compressedImages);
+            if (FAILED(hr)) {
+                return hr;
+            }
+            output = &compressedImages;
+        }
+
+        // 目録にある前回のハッシュのファイルを消してから保存する
+        // (名前の先頭で探すと、拡張子だけ違う元ファイル (foo.png と foo.jpg) のものまで消してしまう)
+        std::filesystem::create_directories(result.cookedPath.parent_path(), ec);
+        if (previous != nullptr && previous->contentHash != hash) {
+            std::filesystem::remove(GetCookedTexturePath(sourcePath, previous->contentHash), ec);
+        }
+        hr = DirectX::SaveToDDSFile(output->GetImages(), output->GetImageCount(), output->GetMetadata(),
+            DirectX::DDS_FLAGS_NONE, result.cookedPath.c_str());
+        if (FAILED(hr)) {
+            return hr;
+        }
+        result.cookMilliseconds = ElapsedMilliseconds(start);
+    }
+
+    // 実行時のDDS読み込みを計測
+    start = std::chrono::steady_clock::now();
+    DirectX::ScratchImage cookedImage{};
+    hr = DirectX::LoadFromDDSFile(result.cookedPath.c_str(), DirectX::DDS_FLAGS_NONE, nullptr, cookedImage);
+    if (FAILED(hr)) {
+        return hr;
+    }
+    result.cookedLoadMilliseconds = ElapsedMilliseconds(start);
+    result.format = cookedImage.GetMetadata().format;
+    result.cookedBytes = cookedImage.GetPixelsSize();
+    return S_OK;
+}
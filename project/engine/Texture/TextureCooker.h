@@ -0,0 +1,72 @@
+#pragma once
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <unordered_map>
+#include "externals/DirectXTex/DirectXTex.h"
+#include "MipGenerator.h"
+
+// テクスチャのクック (PNG/JPGなど → ミップ付き・ブロック圧縮済みのDDS)
+// クック済みファイル名には元ファイルの内容ハッシュが入るので、元画像を更新すると自動的に使われなくなる
+// クックの時に元ファイルのハッシュ・サイズ・更新時刻を目録に書いておき、実行時はサイズと更新時刻が同じなら元ファイルを読まずに済ませる
+
+// クック済みDDSの出力先
+inline constexpr const char* kCookedTextureDirectory = "Resources/cooked";
+// クック済みテクスチャの目録 (kCookedTextureDirectory の中)
+inline constexpr const char* kCookedTextureManifestName = "manifest.txt";
+// クックの処理内容を変えたら上げる (全てのキャッシュが無効になる)
+inline constexpr uint32_t kTextureCookVersion = 2;
+
+// 目録の1行 (クックした時の元ファイル)
+struct TextureManifestEntry {
+    uint64_t contentHash = 0;
+    uint64_t fileSize = 0;
+    int64_t writeTime = 0; // last_write_time の値
+};
+
+// 元ファイルのパス (generic_string) → クックした時の元ファイル
+using TextureManifest = std::unordered_map<std::string, TextureManifestEntry>;
+
+// クック結果 (レポート用)
+struct TextureCookResult {
+    std::filesystem::path cookedPath;
+    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+    bool upToDate = false;           // キャッシュが有効だったのでクックしなかった
+    TextureManifestEntry manifestEntry; // 目録に書く内容
+    uint64_t sourceFileBytes = 0;    // 元ファイルのサイズ
+    uint64_t uncompressedBytes = 0;  // 実行時にミップ生成した場合のVRAM使用量 (RGBA8)
+    uint64_t cookedBytes = 0;        // クック済みテクスチャのVRAM使用量
+    double decodeMilliseconds = 0.0;     // WIC読み込みにかかった時間
+    double mipMilliseconds = 0.0;        // ミップ生成にかかった時間 (MipGenerator)
+    double directXTexMipMilliseconds = 0.0; // 比較用: DirectXTexのGenerateMipMapsにかかった時間
+    double cookedLoadMilliseconds = 0.0; // DDS読み込みにかかった時間
+    double cookMilliseconds = 0.0;       // 圧縮と保存にかかった時間
+};
+
+// 元ファイルの内容ハッシュ (FNV-1a, クックのバージョンを含む)
+uint64_t HashTextureSource(const std::filesystem::path& sourcePath);
+
+// クック済みDDSのパス
+std::filesystem::path GetCookedTexturePath(const std::filesystem::path& sourcePath, uint64_t contentHash);
+
+// 元ファイルのサイズと更新時刻 (無ければ false)
+bool GetTextureSourceStamp(const std::filesystem::path& sourcePath, uint64_t* fileSize, int64_t* writeTime);
+
+// 目録の読み書き (無ければ空の目録)
+TextureManifest LoadTextureManifest();
+bool SaveTextureManifest(const TextureManifest& manifest);
+
+// 有効なクック済みDDSを探す (無ければ空のパス)
+// 目録と元ファイルのサイズ・更新時刻が同じなら元ファイルは読まない。違うときだけ内容のハッシュで確かめる
+std::filesystem::path FindCookedTexture(const std::string& filePath);
+
+// 圧縮形式の選択 (法線マップはBC5、アルファ付きはBC7、不透明はBC1、4の倍数でないサイズは無圧縮)
+DXGI_FORMAT SelectCookedTextureFormat(const std::filesystem::path& sourcePath, const DirectX::ScratchImage& image);
+
+// ミップマップ生成 (RGBA8はMipGeneratorで、それ以外の形式はDirectXTexで行う)
+// parallel なら MipGenerator は JobSystem で行を分ける。複数枚を別々のスレッドで読むときは false にする
+HRESULT GenerateTextureMipMaps(const DirectX::ScratchImage& image, MipFilter filter, DirectX::ScratchImage& mipImages, bool parallel = true);
+
+// テクスチャをクックする
+// previous は目録にある前回のクック (あればそのハッシュのDDSを消してから保存する。無ければ nullptr)
+HRESULT CookTexture(const std::filesystem::path& sourcePath, const TextureManifestEntry* previous, TextureCookResult& result);
@@ -0,0 +1,113 @@
+#include "TextureDecoder.h"
+#include <cctype>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+
+namespace {
+
+double ElapsedMilliseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool Fail(std::string* error, const std::string& message) {
+    if (error != nullptr) {
+        *error = message;
+    }
+    return false;
+}
+
+bool IsTgaPath(const std::string& filePath) {
+    std::string extension = std::filesystem::path(filePath).extension().string();
+    for (char& c : extension) {
+        c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    }
+    return extension == ".tga";
+}
+
+} // namespace
+
+bool DecodeTexture(const std::string& filePath, TextureImageDecoder decodeImage, DecodedTexture& texture, std::string* error,
+    TextureDecodeTimings* timings) {
+    texture = {};
+    auto start = std::chrono::steady_clock::now();
+    std::ifstream file(filePath, std::ios::binary | std::ios::ate);
+    if (!file) {
+        return Fail(error, "cannot open " + filePath);
+    }
+    std::vector<uint8_t> data(size_t(file.tellg()));
+    file.seekg(0);
+    file.read(reinterpret_cast<char*>(data.data()), std::streamsize(data.size()));
+    if (!file) {
+        return Fail(error, "cannot read " + filePath);
+    }
+
+    uint32_t width = 0;
+    uint32_t height = 0;
+    std::vector<uint8_t> pixels;
+    if (IsTgaPath(filePath)) {
+        if (!DecodeTga(data.data(), data.size(), width, height, pixels)) {
+            return Fail(error, "unsupported or truncated TGA " + filePath);
+        }
+    } else {
+        if (decodeImage == nullptr) {
+            return Fail(error, "no decoder for " + filePath);
+        }
+        std::string decodeError;
+        if (!decodeImage(data, width, height, pixels, &decodeError)) {
+            return Fail(error, "cannot decode " + filePath + (decodeError.empty() ? "" : ": " + decodeError));
+        }
+    }
+    if (width == 0 || height == 0 || pixels.size() < size_t(width) * height * 4) {
+        return Fail(error, "empty image " + filePath);
+    }
+    if (timings != nullptr) {
+        timings->decodeMilliseconds = ElapsedMilliseconds(start);
+    }
+
+    // ストリーマーのワーカーが1枚ずつ並列に読むので、1枚の中は分けない
+    start = std::chrono::steady_clock::now();
+    MipGenerateSettings settings;
+    settings.filter = MipFilter::kBox;
+    settings.srgb = true;
+    settings.parallel = false;
+    settings.preserveAlphaCoverage = IsCutoutTexture(pixels.data(), width, height, width * 4);
+    texture.mipLevels = GenerateMipChain(pixels.data(), width, height, width * 4, settings);
+    if (timings != nullptr) {
+        timings->mipMilliseconds = ElapsedMilliseconds(start);
+    }
+    if (texture.mipLevels.size() != CalcMipLevelCount(width, height)) {
+        texture = {};
+        return Fail(error, "mip generation failed for " + filePath);
+    }
+    return true;
+}
+
+bool DecodeTga(const uint8_t* data, size_t size, uint32_t& width, uint32_t& height, std::vector<uint8_t>& pixels) {
+    // 無圧縮のトゥルーカラーで 32bit のものだけ
+    if (size < 18 || data[2] != 2 || data[16] != 32) {
+        return false;
+    }
+    size_t offset = 18 + size_t(data[0]); // 画像IDを飛ばす
+    uint32_t imageWidth = data[12] | (uint32_t(data[13]) << 8);
+    uint32_t imageHeight = data[14] | (uint32_t(data[15]) << 8);
+    if (imageWidth == 0 || imageHeight == 0 || size < offset + size_t(imageWidth) * imageHeight * 4) {
+        return false;
+    }
+    // BGRA → RGBA (下から上に並んでいるものは上から下にする)
+    bool topDown = (data[17] & 0x20) != 0;
+    pixels.resize(size_t(imageWidth) * imageHeight * 4);
+    for (uint32_t y = 0; y < imageHeight; ++y) {
+        const uint8_t* in = data + offset + size_t(topDown ? y : imageHeight - 1 - y) * imageWidth * 4;
+        uint8_t* out = pixels.data() + size_t(y) * imageWidth * 4;
+        for (uint32_t x = 0; x < imageWidth * 4; x += 4) {
+            out[x + 0] = in[x + 2];
+            out[x + 1] = in[x + 1];
+            out[x + 2] = in[x + 0];
+            out[x + 3] = in[x + 3];
+        }
+    }
+    width = imageWidth;
+    height = imageHeight;
+    return true;
+}
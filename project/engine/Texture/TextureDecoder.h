@@ -0,0 +1,34 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MipGenerator.h"
+
+// テクスチャのデコード段 (ファイルを読んで RGBA8 にし、ミップチェーンを作る)
+// TextureStreamer のワーカー (LoadTexture 経由) と TextureStreamBench が同じ関数を通る
+// 無圧縮の 32bit TGA はここで読み、それ以外の形式 (PNG など) は渡されたデコーダーで読む (実行時は WIC)
+// Windowsに依存しない (クック済みのDDSはここを通らない)
+
+// デコードした画像
+struct DecodedTexture {
+    std::vector<MipLevel> mipLevels; // 0段目が元画像 (RGBA8。RGB は sRGB)
+};
+
+// 各段にかかった時間 (計測用)
+struct TextureDecodeTimings {
+    double decodeMilliseconds = 0.0; // ファイルの読み込みとデコード
+    double mipMilliseconds = 0.0;    // ミップ生成
+};
+
+// TGA 以外の形式のデコーダー (fileData はファイルの中身。RGBA8 の sRGB にして pixels に書く。失敗したら false と理由)
+using TextureImageDecoder = bool (*)(const std::vector<uint8_t>& fileData, uint32_t& width, uint32_t& height,
+    std::vector<uint8_t>& pixels, std::string* error);
+
+// 1枚をデコードしてミップチェーンを作る (ミップ生成は呼んだスレッドだけで行う)
+// 失敗したら false を返し、error に理由を書く (texture は空のまま)
+bool DecodeTexture(const std::string& filePath, TextureImageDecoder decodeImage, DecodedTexture& texture,
+    std::string* error = nullptr, TextureDecodeTimings* timings = nullptr);
+
+// 無圧縮の 32bit TGA を RGBA8 にする (data はファイルの中身。形式が違うか足りなければ false)
+bool DecodeTga(const uint8_t* data, size_t size, uint32_t& width, uint32_t& height, std::vector<uint8_t>& pixels);
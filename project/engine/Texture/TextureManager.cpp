@@ -0,0 +1,213 @@
+#include "TextureManager.h"
+#include <algorithm>
+#include <cassert>
+#include <cctype>
+#include <filesystem>
+
+// === TextureHandle ===
+
+TextureHandle::TextureHandle(uint32_t id) : id_(id) {
+    TextureManager::GetInstance()->AddRef(id_);
+}
+
+TextureHandle::TextureHandle(const TextureHandle& other) : id_(other.id_) {
+    if (IsValid()) {
+        TextureManager::GetInstance()->AddRef(id_);
+    }
+}
+
+TextureHandle::TextureHandle(TextureHandle&& other) noexcept : id_(other.id_) {
+    other.id_ = kInvalidId;
+}
+
+TextureHandle& TextureHandle::operator=(const TextureHandle& other) {
+    if (this != &other) {
+        if (other.IsValid()) {
+            TextureManager::GetInstance()->AddRef(other.id_);
+        }
+        Reset();
+        id_ = other.id_;
+    }
+    return *this;
+}
+
+TextureHandle& TextureHandle::operator=(TextureHandle&& other) noexcept {
+    if (this != &other) {
+        Reset();
+        id_ = other.id_;
+        other.id_ = kInvalidId;
+    }
+    return *this;
+}
+
+TextureHandle::~TextureHandle() {
+    Reset();
+}
+
+void TextureHandle::Reset() {
+    if (IsValid()) {
+        TextureManager::GetInstance()->Release(id_);
+        id_ = kInvalidId;
+    }
+}
+
+#if defined(_WIN32)
+D3D12_GPU_DESCRIPTOR_HANDLE TextureHandle::GetGPUHandle() const {
+    assert(IsValid());
+    TextureManager* manager = TextureManager::GetInstance();
+    return manager->residency_->GetGPUHandle(manager->entries_[id_].residencyHandle);
+}
+#endif
+
+uint32_t TextureHandle::GetSrvIndex() const {
+    assert(IsValid());
+    TextureManager* manager = TextureManager::GetInstance();
+    return manager->residency_->GetSrvIndex(manager->entries_[id_].residencyHandle);
+}
+
+bool TextureHandle::IsResident() const {
+    assert(IsValid());
+    TextureManager* manager = TextureManager::GetInstance();
+    return manager->residency_->IsResident(manager->entries_[id_].residencyHandle);
+}
+
+// === TextureManager ===
+
+TextureManager* TextureManager::GetInstance() {
+    static TextureManager instance;
+    return &instance;
+}
+
+void TextureManager::Initialize(TextureResidency* residency, uint64_t memoryBudget) {
+    assert(residency != nullptr);
+    residency_ = residency;
+    memoryBudget_ = memoryBudget;
+}
+
+void TextureManager::Finalize() {
+    // 残っているハンドルは無効になる (解放は TextureResidency 側の終了処理で行われる)
+    entries_.clear();
+    ids_.clear();
+    aliases_.clear();
+    lru_.clear();
+    pendingIds_.clear();
+    usedMemory_ = 0;
+    residency_ = nullptr;
+}
+
+std::string TextureManager::NormalizePath(std::string_view filePath) {
+    std::string path(filePath);
+    std::replace(path.begin(), path.end(), '\\', '/');
+    path = std::filesystem::path(path).lexically_normal().generic_string();
+    if (path.rfind("./", 0) == 0) {
+        path.erase(0, 2);
+    }
+    // Windowsのファイルシステムは大文字小文字を区別しない
+    std::transform(path.begin(), path.end(), path.begin(),
+        [](unsigned char c) { return static_cast<char>(std::tolower(c)); });
+    return path;
+}
+
+TextureHandle TextureManager::Load(std::string_view filePath) {
+    assert(residency_ != nullptr);
+
+    // 同じ文字列で呼ばれたことがあれば正規化を省略する
+    auto alias = aliases_.find(filePath);
+    uint32_t id = 0;
+    if (alias != aliases_.end()) {
+        id = alias->second;
+    } else {
+        std::string key = NormalizePath(filePath);
+        auto it = ids_.find(key);
+        if (it != ids_.end()) {
+            id = it->second;
+        } else {
+            id = static_cast<uint32_t>(entries_.size());
+            Entry entry;
+            entry.path = std::string(filePath);
+            entries_.push_back(std::move(entry));
+            ids_.emplace(std::move(key), id);
+        }
+    }
+
+    // 解放済みなら読み込み直す
+    Entry& entry = entries_[id];
+    if (!entry.loaded) {
+        entry.residencyHandle = residency_->Load(entry.path);
+        entry.loaded = true;
+        entry.sizeInBytes = 0;
+        pendingIds_.push_back(id);
+    }
+    // 読み込んでいる間だけ、書き方ごとに数を限って覚えておく
+    if (alias == aliases_.end() && entry.aliases.size() < kMaxAliasesPerEntry) {
+        entry.aliases.emplace_back(filePath);
+        aliases_.emplace(entry.aliases.back(), id);
+    }
+    return TextureHandle(id);
+}
+
+void TextureManager::Update() {
+    residency_->Update();
+
+    // 常駐したテクスチャのサイズを確定させる
+    for (size_t i = 0; i < pendingIds_.size();) {
+        Entry& entry = entries_[pendingIds_[i]];
+        if (entry.loaded && residency_->IsResident(entry.residencyHandle)) {
+            entry.sizeInBytes = residency_->GetSizeInBytes(entry.residencyHandle);
+            usedMemory_ += entry.sizeInBytes;
+            pendingIds_[i] = pendingIds_.back();
+            pendingIds_.pop_back();
+        } else {
+            ++i;
+        }
+    }
+
+    Evict();
+}
+
+void TextureManager::AddRef(uint32_t id) {
+    if (id >= entries_.size()) {
+        return;
+    }
+    Entry& entry = entries_[id];
+    // キャッシュから参照中に戻す
+    if (entry.refCount++ == 0 && entry.inLru) {
+        lru_.erase(entry.lruIterator);
+        entry.inLru = false;
+    }
+}
+
+void TextureManager::Release(uint32_t id) {
+    // Finalize後に破棄されたハンドルは無視する
+    if (id >= entries_.size()) {
+        return;
+    }
+    Entry& entry = entries_[id];
+    assert(entry.refCount > 0);
+    if (--entry.refCount == 0 && entry.loaded) {
+        entry.lruIterator = lru_.insert(lru_.end(), id);
+        entry.inLru = true;
+    }
+}
+
+void TextureManager::Evict() {
+    // 予算を超えている間、参照されていない古いものから解放する (読み込み中のものは飛ばす)
+    auto it = lru_.begin();
+    while (usedMemory_ > memoryBudget_ && it != lru_.end()) {
+        Entry& entry = entries_[*it];
+        if (!residency_->IsResident(entry.residencyHandle)) {
+            ++it;
+            continue;
+        }
+        residency_->Unload(entry.residencyHandle);
+        for (const std::string& path : entry.aliases) {
+            aliases_.erase(path);
+        }
+        entry.aliases.clear();
+        usedMemory_ -= entry.sizeInBytes;
+        entry.sizeInBytes = 0;
+        entry.loaded = false;
+        entry.inLru = false;
+        it = lru_.erase(it);
+    }
+}
@@ -0,0 +1,125 @@
+#pragma once
+#include <cstdint>
+#include <functional>
+#include <list>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "TextureResidency.h"
+
+class TextureManager;
+
+// テクスチャハンドル (参照カウント付き)
+// コピーすると参照が増え、破棄すると減る。参照が0になったテクスチャはメモリ予算を超えるまでキャッシュに残る
+class TextureHandle {
+public:
+    TextureHandle() = default;
+    TextureHandle(const TextureHandle& other);
+    TextureHandle(TextureHandle&& other) noexcept;
+    TextureHandle& operator=(const TextureHandle& other);
+    TextureHandle& operator=(TextureHandle&& other) noexcept;
+    ~TextureHandle();
+
+    // 有効なハンドルか
+    bool IsValid() const { return id_ != kInvalidId; }
+#if defined(_WIN32)
+    // 読み込み完了まではプレースホルダーのSRVを返す
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle() const;
+#endif
+    uint32_t GetSrvIndex() const;
+    bool IsResident() const;
+
+    bool operator==(const TextureHandle& other) const { return id_ == other.id_; }
+
+private:
+    friend class TextureManager;
+    explicit TextureHandle(uint32_t id);
+    void Reset();
+
+    static const uint32_t kInvalidId = UINT32_MAX;
+    uint32_t id_ = kInvalidId;
+};
+
+// テクスチャ管理クラス
+// 正規化したパスでテクスチャを一意にし、同じテクスチャを二重に読み込まない
+// 読み込みと解放は TextureResidency を通して行う (正規化したパスは重複を見つけるキーにだけ使い、読み込みには最初に渡されたパスを使う)
+class TextureManager {
+public:
+    // メモリ予算の初期値
+    static const uint64_t kDefaultMemoryBudget = 512ull * 1024 * 1024;
+
+public:
+    // シングルトンインスタンスの取得
+    static TextureManager* GetInstance();
+
+    // 初期化 (residency で読み込みと解放を行う)
+    void Initialize(TextureResidency* residency, uint64_t memoryBudget = kDefaultMemoryBudget);
+
+    // 終了処理
+    void Finalize();
+
+    // テクスチャの取得 (未読み込みなら読み込みを開始する)
+    TextureHandle Load(std::string_view filePath);
+
+    // 毎フレームの更新 (読み込みの進行と、予算を超えた分の解放)
+    void Update();
+
+    // メモリ予算
+    void SetMemoryBudget(uint64_t memoryBudget) { memoryBudget_ = memoryBudget; }
+    uint64_t GetMemoryBudget() const { return memoryBudget_; }
+    uint64_t GetUsedMemory() const { return usedMemory_; }
+    size_t GetCachedCount() const { return lru_.size(); }
+    size_t GetAliasCount() const { return aliases_.size(); }
+
+    // 重複を見つけるためのパスの正規化 ("./Resources\\A.png" → "resources/a.png")
+    static std::string NormalizePath(std::string_view filePath);
+
+private:
+    TextureManager() = default;
+    ~TextureManager() = default;
+    TextureManager(const TextureManager&) = delete;
+    const TextureManager& operator=(const TextureManager&) = delete;
+
+    friend class TextureHandle;
+    void AddRef(uint32_t id);
+    void Release(uint32_t id);
+    void Evict();
+
+    // string_viewのまま検索できるようにするためのハッシュ
+    struct StringHash {
+        using is_transparent = void;
+        size_t operator()(std::string_view text) const { return std::hash<std::string_view>{}(text); }
+    };
+    using PathMap = std::unordered_map<std::string, uint32_t, StringHash, std::equal_to<>>;
+
+    // 1つのテクスチャに覚えておく呼び出し側のパスの数 (これを超えた書き方は毎回正規化する)
+    static const size_t kMaxAliasesPerEntry = 4;
+
+    // テクスチャ1枚分の情報
+    struct Entry {
+        std::string path; // 最初に渡されたパス (読み込みに使う)
+        TextureResidency::Handle residencyHandle = 0;
+        bool loaded = false;
+        uint32_t refCount = 0;
+        uint64_t sizeInBytes = 0; // 常駐するまでは0
+        bool inLru = false;
+        std::list<uint32_t>::iterator lruIterator;
+        std::vector<std::string> aliases; // aliases_ に入れたパス (解放したら消す)
+    };
+
+private:
+    TextureResidency* residency_ = nullptr;
+    uint64_t memoryBudget_ = kDefaultMemoryBudget;
+    uint64_t usedMemory_ = 0;
+
+    std::vector<Entry> entries_;
+    // 正規化済みパス → ID
+    PathMap ids_;
+    // 呼び出し側が渡したパス → ID (2回目以降は正規化せずに引ける。常駐しているテクスチャの分だけ持つ)
+    PathMap aliases_;
+    // 参照されていないテクスチャ (先頭ほど古い)
+    std::list<uint32_t> lru_;
+    // サイズ確定待ち (読み込み中) のID
+    std::vector<uint32_t> pendingIds_;
+};
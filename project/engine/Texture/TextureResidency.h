@@ -0,0 +1,33 @@
+#pragma once
+#include <cstdint>
+#include <string>
+#if defined(_WIN32)
+#include <d3d12.h>
+#endif
+
+// テクスチャを読み込んでGPUに常駐させる側 (TextureManager はこれを通してだけ読み込みと解放を行う)
+// 実行時は TextureStreamer。確認用のツールでは、すぐに常駐したことにする偽物に差し替える
+class TextureResidency {
+public:
+    // テクスチャハンドル (Loadの戻り値)
+    using Handle = uint32_t;
+
+public:
+    virtual ~TextureResidency() = default;
+
+    // 読み込み要求 (すぐに戻る)
+    virtual Handle Load(const std::string& filePath) = 0;
+    // 常駐しているテクスチャの解放 (ハンドルは再利用される)
+    virtual void Unload(Handle handle) = 0;
+    // 毎フレームの更新 (読み込みを進める)
+    virtual void Update() = 0;
+
+    virtual bool IsResident(Handle handle) const = 0;
+    // 常駐しているテクスチャのメモリ使用量
+    virtual uint64_t GetSizeInBytes(Handle handle) const = 0;
+    virtual uint32_t GetSrvIndex(Handle handle) const = 0;
+#if defined(_WIN32)
+    // 常駐するまではプレースホルダーのSRVを返す
+    virtual D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(Handle handle) const = 0;
+#endif
+};
@@ -0,0 +1,307 @@
+#include "TextureStreamer.h"
+#include "D3D12Util.h"
+#include <algorithm>
+#include <cassert>
+#include <objbase.h>
+#include "Logger.h"
+
+TextureStreamer* TextureStreamer::GetInstance() {
+    static TextureStreamer instance;
+    return &instance;
+}
+
+void TextureStreamer::Initialize(ID3D12Device* device, ID3D12DescriptorHeap* srvDescriptorHeap, uint32_t srvDescriptorSize,
+    uint32_t srvStartIndex, uint32_t srvCount) {
+    assert(device != nullptr);
+    assert(srvDescriptorHeap != nullptr);
+    assert(srvCount > 0);
+    device_ = device;
+    srvDescriptorHeap_ = srvDescriptorHeap;
+    srvDescriptorSize_ = srvDescriptorSize;
+    srvStartIndex_ = srvStartIndex;
+    srvCount_ = srvCount;
+
+    CreateCopyQueue();
+
+    // ワーカースレッドの起動 (メインスレッドとレンダリング分を残す)
+    uint32_t hardwareThreads = std::thread::hardware_concurrency();
+    uint32_t workerCount = std::clamp(hardwareThreads > 2 ? hardwareThreads - 2 : 1u, 1u, 4u);
+    exitRequested_ = false;
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        workers_.emplace_back(&TextureStreamer::WorkerMain, this);
+    }
+
+    // プレースホルダーは最初に読み込んで常駐させておく
+    placeholder_ = Load(kPlaceholderPath);
+    Flush();
+    assert(entries_[placeholder_].state == State::kResident);
+}
+
+void TextureStreamer::Finalize() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        exitRequested_ = true;
+        decodeRequests_.clear();
+    }
+    requestCondition_.notify_all();
+    for (std::thread& worker : workers_) {
+        worker.join();
+    }
+    workers_.clear();
+
+    // 転送中のバッチを待ってから解放する
+    if (!uploadBatches_.empty()) {
+        WaitForFence(uploadBatches_.back().fenceValue);
+    }
+    uploadBatches_.clear();
+    retiredTextures_.clear();
+    freeHandles_.clear();
+    readyImages_.clear();
+    decodedImages_.clear();
+    entries_.clear();
+    pendingCount_ = 0;
+
+    CloseHandle(copyFenceEvent_);
+    copyFenceEvent_ = nullptr;
+    copyFence_.Reset();
+    copyCommandList_.Reset();
+    for (auto& allocator : copyAllocators_) {
+        allocator.Reset();
+    }
+    copyQueue_.Reset();
+}
+
+TextureStreamer::Handle TextureStreamer::Load(const std::string& filePath) {
+    // 解放済みのハンドルがあれば再利用する
+    Handle handle = 0;
+    if (!freeHandles_.empty()) {
+        handle = freeHandles_.back();
+        freeHandles_.pop_back();
+    } else {
+        assert(entries_.size() < srvCount_);
+        handle = static_cast<Handle>(entries_.size());
+        entries_.emplace_back();
+    }
+
+    Entry& entry = entries_[handle];
+    entry = Entry{};
+    entry.filePath = filePath;
+    entry.srvIndex = srvStartIndex_ + handle;
+    ++pendingCount_;
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        decodeRequests_.push_back({ handle, filePath });
+    }
+    requestCondition_.notify_one();
+    return handle;
+}
+
+void TextureStreamer::Unload(Handle handle) {
+    assert(handle < entries_.size());
+    assert(handle != placeholder_);
+    Entry& entry = entries_[handle];
+    // 転送中のものは解放できない (読めなかったものはリソースが無いのでハンドルだけ返す)
+    assert(entry.state == State::kResident || entry.state == State::kFailed);
+    retiredTextures_.push_back({ handle, std::move(entry.resource), frameCount_ + kRetireFrameCount });
+    entry.sizeInBytes = 0;
+    entry.state = State::kFree;
+}
+
+void TextureStreamer::Update() {
+    ++frameCount_;
+    // 実行中のフレームが使い終わったテクスチャを解放し、ハンドルとSRVを再利用できるようにする
+    while (!retiredTextures_.empty() && retiredTextures_.front().releaseFrame <= frameCount_) {
+        freeHandles_.push_back(retiredTextures_.front().handle);
+        retiredTextures_.pop_front();
+    }
+    PumpUploads();
+}
+
+void TextureStreamer::PumpUploads() {
+    // ワーカーからデコード済みの画像を受け取る
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        while (!decodedImages_.empty()) {
+            readyImages_.push_back(std::move(decodedImages_.front()));
+            decodedImages_.pop_front();
+        }
+    }
+
+    // 読めなかったものは転送せず、プレースホルダーのまま終わったことにする
+    for (auto it = readyImages_.begin(); it != readyImages_.end();) {
+        if (!it->failed) {
+            ++it;
+            continue;
+        }
+        LogError(LogCategory::kTexture, "Failed to load texture {} ({})", entries_[it->handle].filePath, it->error);
+        entries_[it->handle].state = State::kFailed;
+        --pendingCount_;
+        it = readyImages_.erase(it);
+    }
+
+    RetireUploads();
+    SubmitUploads();
+}
+
+void TextureStreamer::Flush() {
+    while (pendingCount_ > 0) {
+        PumpUploads();
+        if (pendingCount_ == 0) {
+            break;
+        }
+        if (!uploadBatches_.empty()) {
+            // 転送の完了を待つ
+            WaitForFence(uploadBatches_.front().fenceValue);
+        } else if (readyImages_.empty()) {
+            // デコードの完了を待つ
+            std::unique_lock<std::mutex> lock(mutex_);
+            decodedCondition_.wait(lock, [this] { return !decodedImages_.empty(); });
+        }
+    }
+}
+
+D3D12_GPU_DESCRIPTOR_HANDLE TextureStreamer::GetGPUHandle(Handle handle) const {
+    assert(handle < entries_.size());
+    // 常駐するまではプレースホルダーを返す
+    const Entry& entry = entries_[handle].state == State::kResident ? entries_[handle] : entries_[placeholder_];
+    return GetGPUDescriptorHandle(srvDescriptorHeap_, srvDescriptorSize_, entry.srvIndex);
+}
+
+void TextureStreamer::CreateCopyQueue() {
+    D3D12_COMMAND_QUEUE_DESC commandQueueDesc{};
+    commandQueueDesc.Type = D3D12_COMMAND_LIST_TYPE_COPY;
+    HRESULT hr = device_->CreateCommandQueue(&commandQueueDesc, IID_PPV_ARGS(&copyQueue_));
+    assert(SUCCEEDED(hr));
+
+    for (auto& allocator : copyAllocators_) {
+        hr = device_->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY, IID_PPV_ARGS(&allocator));
+        assert(SUCCEEDED(hr));
+    }
+
+    hr = device_->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, copyAllocators_[0].Get(), nullptr, IID_PPV_ARGS(&copyCommandList_));
+    assert(SUCCEEDED(hr));
+    hr = copyCommandList_->Close();
+    assert(SUCCEEDED(hr));
+
+    hr = device_->CreateFence(copyFenceValue_, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(&copyFence_));
+    assert(SUCCEEDED(hr));
+    copyFenceEvent_ = CreateEvent(NULL, FALSE, FALSE, NULL);
+    assert(copyFenceEvent_ != nullptr);
+}
+
+void TextureStreamer::WorkerMain() {
+    // WICを使うのでスレッドごとにCOMを初期化する
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    assert(SUCCEEDED(hr));
+
+    while (true) {
+        DecodeRequest request;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            requestCondition_.wait(lock, [this] { return exitRequested_ || !decodeRequests_.empty(); });
+            if (exitRequested_) {
+                break;
+            }
+            request = std::move(decodeRequests_.front());
+            decodeRequests_.pop_front();
+        }
+
+        // デコードとミップ生成 (重い処理はロックの外で行う)
+        DecodedImage decoded{ request.handle };
+        decoded.failed = !LoadTexture(request.filePath, decoded.mipImages, &decoded.error);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            decodedImages_.push_back(std::move(decoded));
+        }
+        decodedCondition_.notify_all();
+    }
+
+    CoUninitialize();
+}
+
+void TextureStreamer::SubmitUploads() {
+    if (readyImages_.empty()) {
+        return;
+    }
+
+    // 空いているアロケータが無ければ次のフレームに回す
+    uint32_t allocatorIndex = nextAllocatorIndex_;
+    if (copyFence_->GetCompletedValue() < allocatorFenceValues_[allocatorIndex]) {
+        return;
+    }
+
+    HRESULT hr = copyAllocators_[allocatorIndex]->Reset();
+    assert(SUCCEEDED(hr));
+    hr = copyCommandList_->Reset(copyAllocators_[allocatorIndex].Get(), nullptr);
+    assert(SUCCEEDED(hr));
+
+    UploadBatch batch;
+    batch.allocatorIndex = allocatorIndex;
+    uint64_t uploadBytes = 0;
+    // 1フレームの転送量を制限する (最低1枚は転送する)
+    while (!readyImages_.empty() && (batch.handles.empty() || uploadBytes < kMaxUploadBytesPerFrame)) {
+        DecodedImage& image = readyImages_.front();
+        Entry& entry = entries_[image.handle];
+        entry.metadata = image.mipImages.GetMetadata();
+        // COPY_DESTで作成される。コピーキューで使ったリソースは実行後にCOMMONへ戻り、
+        // 描画キューでSRVとして使う時に暗黙的に昇格するのでバリアは不要
+        entry.resource = CreateTextureResource(device_, entry.metadata);
+        D3D12_RESOURCE_DESC resourceDesc = entry.resource->GetDesc();
+        entry.sizeInBytes = device_->GetResourceAllocationInfo(0, 1, &resourceDesc).SizeInBytes;
+
+        std::vector<D3D12_SUBRESOURCE_DATA> subresources;
+        DirectX::PrepareUpload(device_, image.mipImages.GetImages(), image.mipImages.GetImageCount(), entry.metadata, subresources);
+        uint64_t intermediateSize = GetRequiredIntermediateSize(entry.resource.Get(), 0, static_cast<UINT>(subresources.size()));
+        Microsoft::WRL::ComPtr<ID3D12Resource> intermediate = CreateBufferResource(device_, intermediateSize);
+        UpdateSubresources(copyCommandList_.Get(), entry.resource.Get(), intermediate.Get(), 0, 0, static_cast<UINT>(subresources.size()), subresources.data());
+
+        entry.state = State::kUploading;
+        uploadBytes += intermediateSize;
+        batch.handles.push_back(image.handle);
+        batch.intermediates.push_back(std::move(intermediate));
+        readyImages_.pop_front();
+    }
+
+    hr = copyCommandList_->Close();
+    assert(SUCCEEDED(hr));
+    ID3D12CommandList* commandLists[] = { copyCommandList_.Get() };
+    copyQueue_->ExecuteCommandLists(1, commandLists);
+
+    batch.fenceValue = ++copyFenceValue_;
+    copyQueue_->Signal(copyFence_.Get(), batch.fenceValue);
+    allocatorFenceValues_[allocatorIndex] = batch.fenceValue;
+    nextAllocatorIndex_ = (allocatorIndex + 1) % kCopyAllocatorCount;
+    uploadBatches_.push_back(std::move(batch));
+}
+
+void TextureStreamer::RetireUploads() {
+    uint64_t completedValue = copyFence_->GetCompletedValue();
+    while (!uploadBatches_.empty() && uploadBatches_.front().fenceValue <= completedValue) {
+        // 転送が終わったのでSRVを作成して公開し、中間リソースを解放する
+        for (Handle handle : uploadBatches_.front().handles) {
+            CreateSrv(entries_[handle]);
+            entries_[handle].state = State::kResident;
+            --pendingCount_;
+        }
+        uploadBatches_.pop_front();
+    }
+}
+
+void TextureStreamer::CreateSrv(Entry& entry) {
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc{};
+    srvDesc.Format = entry.metadata.format;
+    srvDesc.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+    srvDesc.Texture2D.MipLevels = UINT(entry.metadata.mipLevels);
+    device_->CreateShaderResourceView(entry.resource.Get(), &srvDesc,
+        GetCPUDescriptorHandle(srvDescriptorHeap_, srvDescriptorSize_, entry.srvIndex));
+}
+
+void TextureStreamer::WaitForFence(uint64_t fenceValue) {
+    if (copyFence_->GetCompletedValue() < fenceValue) {
+        copyFence_->SetEventOnCompletion(fenceValue, copyFenceEvent_);
+        WaitForSingleObject(copyFenceEvent_, INFINITE);
+    }
+}
@@ -0,0 +1,159 @@
+#pragma once
+#include <d3d12.h>
+#include <wrl.h>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "externals/DirectXTex/DirectXTex.h"
+#include "TextureResidency.h"
+
+// テクスチャの非同期読み込みクラス
+// デコードとミップ生成はワーカースレッドで行い、GPUへの転送はコピーキューでまとめて行う
+// 転送が終わるまではプレースホルダー(white1x1.png)のSRVを返す (読めなかったテクスチャもプレースホルダーのままにする)
+class TextureStreamer : public TextureResidency {
+public:
+    // シングルトンインスタンスの取得
+    static TextureStreamer* GetInstance();
+
+    // 初期化 (srvStartIndexからsrvCount個のSRVを使用する)
+    void Initialize(ID3D12Device* device, ID3D12DescriptorHeap* srvDescriptorHeap, uint32_t srvDescriptorSize,
+        uint32_t srvStartIndex, uint32_t srvCount);
+
+    // 終了処理
+    void Finalize();
+
+    // 読み込み要求 (すぐに戻る)
+    Handle Load(const std::string& filePath) override;
+
+    // 常駐しているテクスチャの解放 (ハンドルとSRVは再利用される)
+    // 実行中のフレームが使っているかもしれないので、リソースの解放とハンドルの再利用は kRetireFrameCount フレーム後に行う
+    void Unload(Handle handle) override;
+
+    // 毎フレームの更新 (デコード済みテクスチャの転送と、転送完了したテクスチャの公開、解放待ちのテクスチャの解放)
+    void Update() override;
+
+    // 全ての読み込みと転送が終わるまで待つ (読めなかったものも終わったことにする)
+    void Flush();
+
+    // ゲッター
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(Handle handle) const override;
+    const DirectX::TexMetadata& GetMetadata(Handle handle) const { return entries_[handle].metadata; }
+    bool IsResident(Handle handle) const override { return entries_[handle].state == State::kResident; }
+    // 読み込みに失敗したか (プレースホルダーのまま。Unload で解放してよい)
+    bool IsFailed(Handle handle) const { return entries_[handle].state == State::kFailed; }
+    uint32_t GetSrvIndex(Handle handle) const override { return entries_[handle].srvIndex; }
+    uint64_t GetSizeInBytes(Handle handle) const override { return entries_[handle].sizeInBytes; }
+    size_t GetPendingCount() const { return pendingCount_; }
+
+private:
+    TextureStreamer() = default;
+    ~TextureStreamer() = default;
+    TextureStreamer(const TextureStreamer&) = delete;
+    const TextureStreamer& operator=(const TextureStreamer&) = delete;
+
+    // テクスチャの状態
+    enum class State {
+        kDecoding,  // ワーカーでデコード中
+        kUploading, // コピーキューで転送中
+        kResident,  // 使用可能
+        kFailed,    // 読み込みに失敗した (プレースホルダーのまま)
+        kFree,      // 解放済み (再利用待ち)
+    };
+
+    // テクスチャ1枚分の情報
+    struct Entry {
+        std::string filePath;
+        Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+        DirectX::TexMetadata metadata{};
+        uint32_t srvIndex = 0;
+        uint64_t sizeInBytes = 0;
+        State state = State::kDecoding;
+    };
+
+    // デコード要求
+    struct DecodeRequest {
+        Handle handle;
+        std::string filePath;
+    };
+
+    // デコード済みの画像 (失敗したら failed で、mipImages は空)
+    struct DecodedImage {
+        Handle handle;
+        DirectX::ScratchImage mipImages;
+        bool failed = false;
+        std::string error;
+    };
+
+    // 解放待ちのテクスチャ
+    struct RetiredTexture {
+        Handle handle;
+        Microsoft::WRL::ComPtr<ID3D12Resource> resource;
+        uint64_t releaseFrame = 0;
+    };
+
+    // 転送中のバッチ (フェンスが通過したら中間リソースを解放する)
+    struct UploadBatch {
+        uint64_t fenceValue = 0;
+        uint32_t allocatorIndex = 0;
+        std::vector<Handle> handles;
+        std::vector<Microsoft::WRL::ComPtr<ID3D12Resource>> intermediates;
+    };
+
+    void CreateCopyQueue();
+    void WorkerMain();
+    // デコード済みの画像を受け取って転送し、転送の終わったものを公開する
+    void PumpUploads();
+    void SubmitUploads();
+    void RetireUploads();
+    void CreateSrv(Entry& entry);
+    void WaitForFence(uint64_t fenceValue);
+
+private:
+    // 1フレームで転送するデータ量の目安
+    static const uint64_t kMaxUploadBytesPerFrame = 32ull * 1024 * 1024;
+    // 同時に転送できるバッチ数
+    static const uint32_t kCopyAllocatorCount = 3;
+    // Unload してから解放するまでのフレーム数 (実行中のフレームが使っているかもしれない)
+    static const uint64_t kRetireFrameCount = 3;
+    // プレースホルダーのパス
+    static constexpr const char* kPlaceholderPath = "Resources/white1x1.png";
+
+    ID3D12Device* device_ = nullptr;
+    ID3D12DescriptorHeap* srvDescriptorHeap_ = nullptr;
+    uint32_t srvDescriptorSize_ = 0;
+    uint32_t srvStartIndex_ = 0;
+    uint32_t srvCount_ = 0;
+
+    // コピーキュー
+    Microsoft::WRL::ComPtr<ID3D12CommandQueue> copyQueue_;
+    Microsoft::WRL::ComPtr<ID3D12CommandAllocator> copyAllocators_[kCopyAllocatorCount];
+    uint64_t allocatorFenceValues_[kCopyAllocatorCount] = {};
+    uint32_t nextAllocatorIndex_ = 0;
+    Microsoft::WRL::ComPtr<ID3D12GraphicsCommandList> copyCommandList_;
+    Microsoft::WRL::ComPtr<ID3D12Fence> copyFence_;
+    uint64_t copyFenceValue_ = 0;
+    HANDLE copyFenceEvent_ = nullptr;
+
+    // メインスレッドのみが触るデータ
+    std::vector<Entry> entries_;
+    std::vector<Handle> freeHandles_;
+    std::deque<RetiredTexture> retiredTextures_;
+    uint64_t frameCount_ = 0;
+    std::deque<UploadBatch> uploadBatches_;
+    std::deque<DecodedImage> readyImages_;
+    Handle placeholder_ = 0;
+    size_t pendingCount_ = 0;
+
+    // ワーカースレッドと共有するデータ (mutex_で保護)
+    std::mutex mutex_;
+    std::condition_variable requestCondition_;
+    std::condition_variable decodedCondition_;
+    std::deque<DecodeRequest> decodeRequests_;
+    std::deque<DecodedImage> decodedImages_;
+    bool exitRequested_ = false;
+    std::vector<std::thread> workers_;
+};
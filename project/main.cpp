@@ -2,6 +2,7 @@
 #include <cassert>
 #include <chrono>
 #include <cstdint>
+#include <cstdio>
 #include <filesystem>
 #include <fstream>
 #include <iostream>
@@ -33,8 +34,28 @@
 #include "WinApp.h"
 #include "DirectXCommon.h"
 #include "GraphicsPipeline.h"
+#include "PipelineLibrary.h"
+#include "PipelinePresets.h"
+#include "ShaderBuild.h"
+#include "ShaderPermutation.h"
 #include "D3D12Util.h"
-#include "Model.h"
+#include "EntityWorld.h"
+#include "TransformSystem.h"
+#include "DynamicBvh.h"
+#include "Mesh.h"
+#include "MeshRenderer.h"
+#include "SkyDome.h"
+#include "SpriteRenderer.h"
+#include "DebugText.h"
+#include "DebugDraw.h"
+#include "AudioManager.h"
+#include "Logger.h"
+#include "CpuProfiler.h"
+#include "GpuProfiler.h"
+#include "ProfilerPanel.h"
+#include "JobSystem.h"
+#include "TextureStreamer.h"
+#include "TextureManager.h"
 #include "MathUtil.h"
 #include "DataTypes.h"
 
@@ -63,13 +84,6 @@ static LONG WINAPI ExportDump(EXCEPTION_POINTERS* exception)
 	return EXCEPTION_EXECUTE_HANDLER;
 }
 
-// ログ出力
-void Log(std::ostream& os, const std::string& message)
-{
-	os << message << std::endl;
-	OutputDebugStringA(message.c_str());
-}
-
 // 文字列変換
 std::wstring ConvertString(const std::string& str)
 {
@@ -103,44 +117,320 @@ struct D3DResourceLeakChecker {
 	}
 };
 
+// 回り続けるエンティティ (Y軸まわりの毎秒のラジアン)
+struct Spin {
+	float speed;
+};
+
+// BVH に入れたエンティティのプロキシ
+struct SpatialProxy {
+	uint32_t id = UINT32_MAX;
+};
+
 // ===============================================
 
-int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
+int WINAPI WinMain(HINSTANCE, HINSTANCE, LPSTR commandLine, int)
 {
 	D3DResourceLeakChecker leakChecker;
 
+	// ログ (logs/日時.log とデバッガーの出力へ。書くスレッドは待たされない)
+	Logger* logger = Logger::GetInstance();
+	logger->Initialize(LogSettings());
+	LogInfo(LogCategory::kGeneral, "Start");
+
+	// CPUの区間の計測 (PROFILE_SCOPE。集計はEndFrameで行い、ImGuiのウィンドウに出す)
+	CpuProfiler* profiler = CpuProfiler::GetInstance();
+	profiler->Initialize(ProfileSettings());
+	profiler->SetThreadName("Main");
+
+	// ジョブシステム (メインスレッドがワーカー 0。残りのコアにワーカースレッドを立てる)
+	JobSystem* jobSystem = JobSystem::GetInstance();
+	jobSystem->Initialize();
+	LogInfo(LogCategory::kGeneral, "JobSystem: {} workers", jobSystem->GetWorkerCount());
+
 	WinApp* winApp = WinApp::GetInstance();
 	winApp->Initialize();
 
+	// 画面への出し方 (--present=vsync|tearing|lowlatency --buffers=2 --latency=1 --fps=0 で変えられる)
+	PresentSettings presentSettings;
+	std::string presentError;
+	if (!ParsePresentSettings(commandLine, &presentSettings, &presentError)) {
+		LogWarning(LogCategory::kGraphics, "{}", presentError);
+	}
 	DirectXCommon* dxCommon = DirectXCommon::GetInstance();
-	dxCommon->Initialize(winApp);
+	dxCommon->Initialize(winApp, presentSettings);
 
 	CoInitializeEx(0, COINIT_MULTITHREADED);
 	SetUnhandledExceptionFilter(ExportDump);
 
-	// --- 初期化処理を簡略化 ---
+	// ImGui (フォントのテクスチャはSRVの0番に置く)
+	IMGUI_CHECKVERSION();
+	ImGui::CreateContext();
+	ImGui::StyleColorsDark();
+	ImGui_ImplWin32_Init(winApp->GetHwnd());
+	ImGui_ImplDX12_Init(dxCommon->GetDevice(), dxCommon->GetBackBufferCount(), dxCommon->GetRtvDesc().Format,
+		dxCommon->GetSrvDescriptorHeap(), dxCommon->GetSrvDescriptorHeap()->GetCPUDescriptorHandleForHeapStart(),
+		dxCommon->GetSrvDescriptorHeap()->GetGPUDescriptorHandleForHeapStart());
+	ProfilerPanel profilerPanel;
+
+	// テクスチャの非同期読み込み (SRVの0番はImGui用に空けておく)
+	TextureStreamer* textureStreamer = TextureStreamer::GetInstance();
+	textureStreamer->Initialize(dxCommon->GetDevice(), dxCommon->GetSrvDescriptorHeap(), dxCommon->GetSrvDescriptorSize(),
+		1, DirectXCommon::kMaxSRVCount - 1);
+	TextureManager* textureManager = TextureManager::GetInstance();
+	textureManager->Initialize(textureStreamer);
+
+	// パイプラインはバックグラウンドでコンパイルする (終わるまではGetPipelineStateがフォールバックかnullptrを返す)
+	PipelineLibrary* pipelineLibrary = PipelineLibrary::GetInstance();
+	pipelineLibrary->Initialize(dxCommon->GetDevice());
+	// Resources/shaders の全てのシェーダーを並列にコンパイルしてから、それを使うパイプラインを作る
+	ShaderBuildGraph shaderBuildGraph;
+	shaderBuildGraph.Scan("Resources/shaders");
+	pipelineLibrary->PrecompileShaders(ExpandShaderPermutations(shaderBuildGraph.GetEntryPoints()));
+	RequestPresetPipelines(pipelineLibrary);
+#ifdef _DEBUG
+	// シェーダーを保存したら、それを使うパイプラインだけを作り直して差し替える
+	pipelineLibrary->EnableHotReload(shaderBuildGraph);
+#endif
+
+	// スプライトはフレーム中に溜めておき、描画の最後にテクスチャごとにまとめて描く
+	SpriteRenderer* spriteRenderer = SpriteRenderer::GetInstance();
+	spriteRenderer->Initialize(dxCommon->GetDevice(), dxCommon->GetSrvDescriptorHeap(), dxCommon->GetSrvDescriptorSize());
+	// デバッグ表示の文字列 (スプライトとしてまとめて描く)
+	DebugText* debugText = DebugText::GetInstance();
+	debugText->Initialize(spriteRenderer);
+	// デバッグ表示の線分 (どのスレッドからでも足せる。描画の最後に種類ごとにまとめて描く)
+	DebugDraw* debugDraw = DebugDraw::GetInstance();
+	debugDraw->Initialize(dxCommon->GetDevice());
+
+	// 音声 (ミキサーで混ぜてから XAudio2 に送る。デバイスが無ければ何も鳴らさない出力に切り替わる)
+	AudioManager* audioManager = AudioManager::GetInstance();
+	audioManager->Initialize(CreateXAudio2Output());
+	const WaveFile* fanfare = audioManager->Load("Resources/fanfare.wav");
+	AudioPlayParams bgmParams;
+	bgmParams.priority = 255;
+	audioManager->Play(fanfare, bgmParams);
+	// 効果音 (展開して全ての声で共有する。同時に鳴らすのは4つまで)
+	SoundClip* mokugyo = audioManager->LoadClip("Resources/mokugyo.wav");
+	mokugyo->maxInstances = 4;
+	audioManager->Play(mokugyo);
+
+	// デバッグ表示用のカメラ
+	Matrix4x4 viewMatrix = Inverse(MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, { 0.3f, 0.0f, 0.0f }, { 0.0f, 5.0f, -15.0f }));
+	Matrix4x4 projectionMatrix = MakePerspectiveFovMatrix(0.45f, float(WinApp::kClientWidth) / float(WinApp::kClientHeight), 0.1f, 100.0f);
+
+	// 天球 (不透明なものの後に、最も奥の深度で描く。ファークリップより大きくてもよい)
+	SkyDome* skyDome = SkyDome::Create("Resources/skydome", "SkyDome.obj", dxCommon->GetDevice());
+	TextureHandle skyTexture = textureManager->Load(skyDome->GetTextureFilePath());
+
+	// エンティティ (コンポーネントの組み合わせごとにチャンクへ詰めて置く)
+	EntityWorld world;
+	// 親子関係のある Transform (TransformNode を持つエンティティは階層のワールド行列を使う)
+	TransformHierarchy hierarchy;
+	// メッシュを描くエンティティ (メッシュは共有し、行列とマテリアルはコンポーネントに持つ)
+	MeshRenderSystem* meshRenderSystem = MeshRenderSystem::GetInstance();
+	meshRenderSystem->Initialize(dxCommon->GetDevice());
+	Mesh* cubeMesh = Mesh::Create("Resources/cube", "cube.obj", dxCommon->GetDevice());
+	TextureHandle cubeTexture = textureManager->Load(cubeMesh->GetTextureFilePath());
+	for (int32_t z = 0; z < 5; ++z) {
+		for (int32_t x = 0; x < 5; ++x) {
+			MeshRenderer renderer;
+			renderer.mesh = cubeMesh;
+			renderer.texture = cubeTexture;
+			Transform transform = { { 0.5f, 0.5f, 0.5f }, { 0.0f, 0.0f, 0.0f }, { float(x - 2) * 2.0f, 0.5f, float(z - 2) * 2.0f } };
+			if (x == 2 && z == 2) {
+				// 真ん中は階層の根にして、周りを回る子を付ける
+				TransformNode node = hierarchy.Create(transform);
+				world.Create(node, LocalToWorld{}, cubeMesh->GetBounds(), WorldBounds{}, MakeDefaultMaterial(), std::move(renderer),
+					Spin{ 0.5f + 0.1f * float(x + z) }, SpatialProxy{});
+				MeshRenderer moonRenderer;
+				moonRenderer.mesh = cubeMesh;
+				moonRenderer.texture = cubeTexture;
+				Transform moon = { { 0.4f, 0.4f, 0.4f }, { 0.0f, 0.0f, 0.0f }, { 2.5f, 1.5f, 0.0f } };
+				world.Create(hierarchy.Create(moon, node), LocalToWorld{}, cubeMesh->GetBounds(), WorldBounds{}, MakeDefaultMaterial(),
+					std::move(moonRenderer), SpatialProxy{});
+				continue;
+			}
+			world.Create(transform, LocalToWorld{}, cubeMesh->GetBounds(), WorldBounds{}, MakeDefaultMaterial(), std::move(renderer),
+				Spin{ 0.5f + 0.1f * float(x + z) }, SpatialProxy{});
+		}
+	}
+	// 視錐台や光線で問い合わせる BVH (最初の AABB を計算してからプロキシを作る)
+	DynamicBvh bvh;
+	UpdateTransforms(world, &hierarchy);
+	world.ForEach<const WorldBounds, SpatialProxy>([&bvh](Entity entity, const WorldBounds& bounds, SpatialProxy& proxy) {
+		proxy.id = bvh.CreateProxy(Aabb{ bounds.min, bounds.max }, entity.index);
+	});
+	bvh.Update();
+	std::vector<uint32_t> visibleProxies;
+	// 平行光源
+	DirectionalLight directionalLight = { { 1.0f, 1.0f, 1.0f, 1.0f }, { 0.0f, -1.0f, 0.0f }, 1.0f };
+
+	// --- メインループ ---
 
 	while (!winApp->IsEndRequested()) {
-		winApp->ProcessMessage();
+		profiler->BeginFrame();
+		// 表示の待ち行列が空くまで (と上限のフレームレートまで) 待ってから入力を読む
+		dxCommon->WaitForNextFrame();
+		{
+			PROFILE_SCOPE("ProcessMessage");
+			winApp->ProcessMessage();
+		}
 
-		// --- 更新処理は空 ---
+		// --- 更新処理 ---
+		{
+			PROFILE_SCOPE("Update");
+			ImGui_ImplDX12_NewFrame();
+			ImGui_ImplWin32_NewFrame();
+			ImGui::NewFrame();
+			{
+				PROFILE_SCOPE("TextureManager");
+				// 読み込みが終わったテクスチャの転送と、使われていないテクスチャの解放
+				textureManager->Update();
+			}
+			{
+				PROFILE_SCOPE("PipelineLibrary");
+				// 変更されたシェーダーの作り直しと、作り直したパイプラインの差し替え
+				pipelineLibrary->Update();
+			}
+			// 鳴り終わった声の回収
+			audioManager->Update();
+			// 前のフレームのスプライトを捨て、GPUが使い終わった頂点の領域を再利用する
+			spriteRenderer->BeginFrame();
+			debugDraw->BeginFrame();
+			meshRenderSystem->BeginFrame();
+			skyDome->Update();
+			{
+				PROFILE_SCOPE("Entities");
+				float deltaTime = float(dxCommon->GetFramePacer().GetLastFrameMilliseconds() / 1000.0);
+				world.ForEach<Transform, const Spin>([deltaTime](Transform& transform, const Spin& spin) {
+					transform.rotate.y += spin.speed * deltaTime;
+				});
+				world.ForEach<const TransformNode, const Spin>([&hierarchy, deltaTime](const TransformNode& node, const Spin& spin) {
+					Transform local = hierarchy.GetLocal(node);
+					local.rotate.y += spin.speed * deltaTime;
+					hierarchy.SetLocal(node, local);
+				});
+				// 行列と AABB (チャンクごとに並列。階層は変わった部分木だけ計算し直す)
+				UpdateTransforms(world, &hierarchy);
+				world.ForEach<const WorldBounds, const SpatialProxy>([&bvh](const WorldBounds& bounds, const SpatialProxy& proxy) {
+					bvh.MoveProxy(proxy.id, Aabb{ bounds.min, bounds.max });
+				});
+				bvh.Update();
+			}
+			{
+				PROFILE_SCOPE("SpatialQueries");
+				Matrix4x4 viewProjection = Multiply(viewMatrix, projectionMatrix);
+				visibleProxies.clear();
+				bvh.QueryFrustum(MakeFrustum(viewProjection), visibleProxies);
+				// カメラの正面に光線を飛ばし、最初に当たったものの AABB と、その上にエンティティの番号を出す
+				Matrix4x4 cameraMatrix = Inverse(viewMatrix);
+				Ray ray = { { cameraMatrix.m[3][0], cameraMatrix.m[3][1], cameraMatrix.m[3][2] },
+					{ cameraMatrix.m[2][0], cameraMatrix.m[2][1], cameraMatrix.m[2][2] } };
+				BvhRayHit hit;
+				if (bvh.RayCast(ray, 100.0f, &hit)) {
+					const Aabb& bounds = bvh.GetBounds(hit.proxy);
+					debugDraw->GetList().Aabb(bounds.min, bounds.max, { 1.0f, 1.0f, 0.0f, 1.0f });
+					Vector3 labelPosition = { (bounds.min.x + bounds.max.x) * 0.5f, bounds.max.y + 0.3f, (bounds.min.z + bounds.max.z) * 0.5f };
+					debugText->Print3D("entity " + std::to_string(bvh.GetUserData(hit.proxy)), labelPosition, viewProjection,
+						float(WinApp::kClientWidth), float(WinApp::kClientHeight), 1.0f, { 1.0f, 1.0f, 0.0f, 1.0f });
+				}
+				ImGui::Begin("Spatial");
+				ImGui::Text("visible %u / %u", static_cast<uint32_t>(visibleProxies.size()), bvh.GetProxyCount());
+				ImGui::End();
+			}
+			// 画面左上にフレーム時間を出す (ImGui を閉じていても見える)
+			{
+				char hud[64];
+				std::snprintf(hud, sizeof(hud), "%.2fms  visible %u", dxCommon->GetFramePacer().GetLastFrameMilliseconds(),
+					static_cast<uint32_t>(visibleProxies.size()));
+				debugText->Print(hud, 8.0f, 8.0f);
+			}
+			// 原点の目安
+			debugDraw->GetList().Grid({ 0.0f, 0.0f, 0.0f }, 20.0f, 20, { 0.5f, 0.5f, 0.5f, 1.0f });
+			// 計測結果 (前のフレームまでの集計)
+			profilerPanel.Draw(profiler);
+			ImGui::Render();
+		}
 
 		// --- 描画処理 ---
-		// 描画前処理（画面クリアなど）
-		dxCommon->PreDraw();
+		{
+			PROFILE_SCOPE("Draw");
+			// 描画前処理（画面クリアなど）
+			dxCommon->PreDraw();
 
-		// ここに描画コマンドを記述しない
+			// 奥から順に描く: メッシュ → 天球 → デバッグ表示の線分 → スプライト (デバッグ表示の文字列を含む) → ImGui
 
-		// 描画後処理（コマンド実行と画面表示）
-		dxCommon->PostDraw();
+			// エンティティのメッシュ
+			{
+				PROFILE_SCOPE("MeshRenderSystem");
+				GPU_PROFILE_SCOPE(dxCommon->GetCommandList(), "Meshes");
+				meshRenderSystem->Render(dxCommon->GetCommandList(), world, Multiply(viewMatrix, projectionMatrix), directionalLight);
+			}
+
+			// 天球 (不透明なものを全て描いた後。何かが描かれた画素は深度テストで弾かれる)
+			{
+				GPU_PROFILE_SCOPE(dxCommon->GetCommandList(), "SkyDome");
+				skyDome->Draw(dxCommon->GetCommandList(), viewMatrix, projectionMatrix, skyTexture.GetGPUHandle());
+			}
+
+			// 溜めたデバッグ表示の線分
+			{
+				GPU_PROFILE_SCOPE(dxCommon->GetCommandList(), "DebugDraw");
+				debugDraw->Render(dxCommon->GetCommandList(), viewMatrix, projectionMatrix, float(WinApp::kClientWidth), float(WinApp::kClientHeight));
+			}
+
+			// 溜めたスプライト (前景なので最後に描く)
+			{
+				PROFILE_SCOPE("SpriteRenderer");
+				GPU_PROFILE_SCOPE(dxCommon->GetCommandList(), "Sprites");
+				spriteRenderer->Render(dxCommon->GetCommandList(), float(WinApp::kClientWidth), float(WinApp::kClientHeight));
+			}
+
+			// ImGui (一番手前)
+			{
+				GPU_PROFILE_SCOPE(dxCommon->GetCommandList(), "ImGui");
+				ImGui_ImplDX12_RenderDrawData(ImGui::GetDrawData(), dxCommon->GetCommandList());
+			}
+
+			// 描画後処理（コマンド実行と画面表示）
+			dxCommon->PostDraw();
+		}
+		profiler->EndFrame();
 	}
 
 	// --- 終了処理 ---
+	// 実行中のフレームが使っているリソースを解放する前に、GPUが終えるのを待つ
+	dxCommon->WaitForGPU();
+	audioManager->Finalize();
+	skyTexture = TextureHandle();
+	delete skyDome;
+	// コンポーネントのテクスチャを TextureManager より先に手放す
+	world.Clear();
+	hierarchy.Clear();
+	bvh.Clear();
+	cubeTexture = TextureHandle();
+	delete cubeMesh;
+	meshRenderSystem->Finalize();
+	debugDraw->Finalize();
+	debugText->Finalize();
+	spriteRenderer->Finalize();
+	pipelineLibrary->Finalize();
+	textureManager->Finalize();
+	textureStreamer->Finalize();
+	ImGui_ImplDX12_Shutdown();
+	ImGui_ImplWin32_Shutdown();
+	ImGui::DestroyContext();
 	dxCommon->Finalize();
 
 	CoUninitialize();
 
 	winApp->Finalize();
 
+	jobSystem->Finalize();
+	profiler->Finalize();
+	LogInfo(LogCategory::kGeneral, "Exit");
+	logger->Finalize();
+
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,140 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AudioMixer.h"
+#include "AudioOutput.h"
+#include "WaveFile.h"
+
+// ソフトウェアミキサーの計測と確認
+// 同梱のWAVを開き (チャンクの読み飛ばしと形式の確認)、変換なしの再生と2倍速の再生が元の音と一致することを確かめる
+// その後、指定の数の声をばらばらのピッチとパンでループ再生し、1ブロックを作る時間と実時間に対する速さを出す
+// 最後に NullAudioOutput のスレッドから鳴らし、出力を差し替えても同じに動くことを確かめる
+// 使い方: AudioMixBench.exe [声の数] [作る音の秒数] [Resourcesのディレクトリ] (省略時は 256 10 Resources)
+//
+// Windowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -pthread -Iengine/Audio -o AudioMixBench tools/AudioMixBench/main.cpp engine/Audio/WaveFile.cpp
+//       engine/Audio/AudioStream.cpp engine/Audio/AudioMixer.cpp engine/Audio/AudioOutput.cpp
+
+namespace {
+
+const uint32_t kBlockFrames = 480;
+
+double ToMilliseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+uint32_t ReadArgument(int argc, char* argv[], int index, uint32_t defaultValue) {
+    if (index < argc) {
+        return static_cast<uint32_t>(std::strtoul(argv[index], nullptr, 10));
+    }
+    return defaultValue;
+}
+
+// 1つの声だけを鳴らし、元の音を frameStep フレームおきに拾って gain をかけたものとの差の最大を返す
+float MeasureSingleVoice(const WaveFile& wave, uint32_t sampleRate, float pitch, uint32_t frameStep) {
+    AudioMixer mixer;
+    mixer.Initialize(sampleRate, 4);
+    AudioPlayParams params;
+    params.pitch = pitch;
+    AudioMixer::VoiceId voice = mixer.Play(&wave, params);
+
+    std::vector<float> expected(size_t(wave.GetFrameCount()) * 2);
+    wave.DecodeStereo(0, static_cast<uint32_t>(wave.GetFrameCount()), expected.data());
+    const float gain = std::cos(3.14159265358979f * 0.25f);
+
+    std::vector<float> block(kBlockFrames * 2);
+    uint64_t frame = 0;
+    float maxError = 0.0f;
+    while (mixer.IsPlaying(voice)) {
+        mixer.Mix(block.data(), kBlockFrames);
+        for (uint32_t i = 0; i < kBlockFrames; ++i, ++frame) {
+            uint64_t source = frame * frameStep;
+            // 最後のフレームは補間の相手が無いので鳴らさない
+            if (source + 1 >= wave.GetFrameCount()) {
+                break;
+            }
+            for (uint32_t channel = 0; channel < 2; ++channel) {
+                float error = std::fabs(block[i * 2 + channel] - expected[source * 2 + channel] * gain);
+                maxError = error > maxError ? error : maxError;
+            }
+        }
+    }
+    return maxError;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t voiceCount = ReadArgument(argc, argv, 1, 256);
+    uint32_t seconds = ReadArgument(argc, argv, 2, 10);
+    std::string resourceDirectory = argc > 3 ? argv[3] : "Resources";
+    if (voiceCount == 0 || voiceCount > 0xFFFF || seconds == 0) {
+        std::printf("usage: AudioMixBench [voices] [seconds] [resource directory]\n");
+        return 1;
+    }
+
+    const char* fileNames[] = { "fanfare.wav", "mokugyo.wav" };
+    WaveFile waves[2];
+    for (uint32_t i = 0; i < 2; ++i) {
+        std::string error;
+        std::string filePath = resourceDirectory + "/" + fileNames[i];
+        if (!waves[i].Open(filePath, &error)) {
+            std::printf("%s: %s\n", filePath.c_str(), error.c_str());
+            return 1;
+        }
+        const WaveFormat& format = waves[i].GetFormat();
+        std::printf("%-12s %u ch, %u Hz, %u bit %s, %llu frames (%.2fs)\n", fileNames[i], format.channelCount, format.sampleRate,
+            format.bitsPerSample, format.sampleType == WaveSampleType::kFloat ? "float" : "int",
+            static_cast<unsigned long long>(waves[i].GetFrameCount()), waves[i].GetDuration());
+    }
+
+    // 変換なし (mokugyo は48kHz) と、サンプルレートそのままの2倍速 (fanfare は44.1kHz)
+    float copyError = MeasureSingleVoice(waves[1], waves[1].GetFormat().sampleRate, 1.0f, 1);
+    float pitchError = MeasureSingleVoice(waves[0], waves[0].GetFormat().sampleRate, 2.0f, 2);
+    std::printf("check:      copy error %.7f, pitch x2 error %.7f\n", copyError, pitchError);
+    bool passed = copyError < 1e-5f && pitchError < 1e-5f;
+
+    // たくさんの声を同時に鳴らす
+    AudioMixer mixer;
+    mixer.Initialize(AudioMixer::kDefaultSampleRate, voiceCount);
+    std::mt19937 random(12345);
+    std::uniform_real_distribution<float> pitchDistribution(0.5f, 2.0f);
+    std::uniform_real_distribution<float> panDistribution(-1.0f, 1.0f);
+    for (uint32_t i = 0; i < voiceCount; ++i) {
+        AudioPlayParams params;
+        params.volume = 1.0f / float(voiceCount);
+        params.pan = panDistribution(random);
+        params.pitch = pitchDistribution(random);
+        params.loop = true;
+        mixer.Play(&waves[i % 2], params);
+    }
+    uint32_t blockCount = seconds * AudioMixer::kDefaultSampleRate / kBlockFrames;
+    std::vector<float> block(kBlockFrames * 2);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < blockCount; ++i) {
+        mixer.Mix(block.data(), kBlockFrames);
+    }
+    double milliseconds = ToMilliseconds(std::chrono::steady_clock::now() - start);
+    double blockMilliseconds = 1000.0 * kBlockFrames / AudioMixer::kDefaultSampleRate;
+    double speed = double(seconds) * 1000.0 / milliseconds;
+    std::printf("mix:        %u voices, %.3fms/block of %.1fms (%.1fx realtime, %.0f voices per core at realtime)\n", voiceCount,
+        milliseconds / blockCount, blockMilliseconds, speed, speed * voiceCount);
+
+    // 出力を通して鳴らす (実時間を待たずに回す)
+    NullAudioOutput output(false);
+    output.Start(AudioMixer::kDefaultSampleRate, kBlockFrames, [&mixer](float* samples, uint32_t frameCount) {
+        mixer.Mix(samples, frameCount);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(500));
+    output.Stop();
+    std::printf("output:     %s, %llu frames in 0.5s, peak %.3f\n", output.GetName(),
+        static_cast<unsigned long long>(output.GetRenderedFrames()), output.GetPeak());
+    passed = passed && output.GetRenderedFrames() > 0 && output.GetPeak() > 0.0f;
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,440 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "DynamicBvh.h"
+#include "MathUtil.h"
+
+// DynamicBvh の確認と計測
+// 1万から最大の数まで10倍ずつ、ばらまいた箱を動かない木と動く木 (どちらも最初の Update で SAH でまとめて作る) に入れ、
+// 重なり・視錐台・光線・近い8個の問い合わせの時間を、全ての箱を1つずつ調べる書き方と比べる (結果が全て一致することも確かめる)
+// 動く木は毎フレーム 0.1% の箱を足したとき (1つずつ挿入する) と、10% の箱を少し動かしたときの MoveProxy と Update の時間も測る
+// 最後に作成・破棄・移動 (動かないものも) を混ぜて繰り返し、問い合わせの結果が全て調べたときと一致することを確かめる
+// 使い方: BvhBench.exe [最大の数] (省略時は 1000000)
+//
+// Windowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -Iengine/Spatial -Iengine/Math -o BvhBench tools/BvhBench/main.cpp engine/Spatial/DynamicBvh.cpp engine/Math/MathUtil.cpp
+
+namespace {
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 比べる相手 (生きている箱を全て調べる。判定の式は DynamicBvh と同じ順で計算する)
+struct BruteForce {
+    std::vector<Aabb> bounds;
+    std::vector<uint8_t> alive;
+
+    void Overlap(const Aabb& query, std::vector<uint32_t>& results) const {
+        for (uint32_t i = 0; i < bounds.size(); ++i) {
+            const Aabb& b = bounds[i];
+            if (alive[i] && b.min.x <= query.max.x && query.min.x <= b.max.x && b.min.y <= query.max.y && query.min.y <= b.max.y &&
+                b.min.z <= query.max.z && query.min.z <= b.max.z) {
+                results.push_back(i);
+            }
+        }
+    }
+
+    void Frustum(const ::Frustum& frustum, std::vector<uint32_t>& results) const {
+        for (uint32_t i = 0; i < bounds.size(); ++i) {
+            const Aabb& b = bounds[i];
+            bool visible = alive[i] != 0;
+            for (uint32_t p = 0; p < 6 && visible; ++p) {
+                const Vector4& plane = frustum.planes[p];
+                float x = plane.x > 0.0f ? b.max.x : b.min.x;
+                float y = plane.y > 0.0f ? b.max.y : b.min.y;
+                float z = plane.z > 0.0f ? b.max.z : b.min.z;
+                visible = 0.0f <= plane.x * x + plane.y * y + plane.z * z + plane.w;
+            }
+            if (visible) {
+                results.push_back(i);
+            }
+        }
+    }
+
+    bool RayCast(const Ray& ray, float maxDistance, BvhRayHit* hit) const {
+        auto inverse = [](float value) {
+            return std::fabs(value) < 1.0e-20f ? (value < 0.0f ? -1.0e30f : 1.0e30f) : 1.0f / value;
+        };
+        float inverseX = inverse(ray.direction.x);
+        float inverseY = inverse(ray.direction.y);
+        float inverseZ = inverse(ray.direction.z);
+        bool found = false;
+        for (uint32_t i = 0; i < bounds.size(); ++i) {
+            if (!alive[i]) {
+                continue;
+            }
+            const Aabb& b = bounds[i];
+            float x1 = (b.min.x - ray.origin.x) * inverseX;
+            float x2 = (b.max.x - ray.origin.x) * inverseX;
+            float y1 = (b.min.y - ray.origin.y) * inverseY;
+            float y2 = (b.max.y - ray.origin.y) * inverseY;
+            float z1 = (b.min.z - ray.origin.z) * inverseZ;
+            float z2 = (b.max.z - ray.origin.z) * inverseZ;
+            float enter = std::max(std::max(std::max(std::min(x1, x2), std::min(y1, y2)), std::min(z1, z2)), 0.0f);
+            float exit = std::min(std::min(std::min(std::max(x1, x2), std::max(y1, y2)), std::max(z1, z2)), maxDistance);
+            if (enter <= exit && (!found || enter < hit->distance)) {
+                found = true;
+                hit->proxy = i;
+                hit->distance = enter;
+            }
+        }
+        return found;
+    }
+
+    float DistanceSquared(uint32_t i, const Vector3& point) const {
+        const Aabb& b = bounds[i];
+        float dx = std::max(std::max(b.min.x - point.x, point.x - b.max.x), 0.0f);
+        float dy = std::max(std::max(b.min.y - point.y, point.y - b.max.y), 0.0f);
+        float dz = std::max(std::max(b.min.z - point.z, point.z - b.max.z), 0.0f);
+        return dx * dx + dy * dy + dz * dz;
+    }
+
+    void Nearest(const Vector3& point, uint32_t count, std::vector<float>& distances) const {
+        distances.clear();
+        for (uint32_t i = 0; i < bounds.size(); ++i) {
+            if (!alive[i]) {
+                continue;
+            }
+            distances.push_back(DistanceSquared(i, point));
+        }
+        count = std::min(count, static_cast<uint32_t>(distances.size()));
+        std::partial_sort(distances.begin(), distances.begin() + count, distances.end());
+        distances.resize(count);
+    }
+};
+
+// 問い合わせ
+struct Queries {
+    std::vector<Aabb> boxes;
+    std::vector<Frustum> frustums;
+    std::vector<Ray> rays;
+    std::vector<Vector3> points;
+};
+
+Aabb RandomBox(std::mt19937& random, float worldSize, float minSize, float maxSize) {
+    std::uniform_real_distribution<float> position(0.0f, worldSize);
+    std::uniform_real_distribution<float> size(minSize, maxSize);
+    Vector3 min = { position(random), position(random), position(random) };
+    return { min, { min.x + size(random), min.y + size(random), min.z + size(random) } };
+}
+
+Queries MakeQueries(std::mt19937& random, float worldSize, uint32_t count) {
+    std::uniform_real_distribution<float> position(0.0f, worldSize);
+    std::uniform_real_distribution<float> angle(-3.14f, 3.14f);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    Queries queries;
+    for (uint32_t i = 0; i < count; ++i) {
+        queries.boxes.push_back(RandomBox(random, worldSize, 4.0f, 12.0f));
+        Vector3 origin = { position(random), position(random), position(random) };
+        Vector3 direction = { normal(random), normal(random), normal(random) };
+        float length = std::sqrt(direction.x * direction.x + direction.y * direction.y + direction.z * direction.z);
+        queries.rays.push_back(Ray{ origin, { direction.x / length, direction.y / length, direction.z / length } });
+        queries.points.push_back({ position(random), position(random), position(random) });
+        // 視錐台は数を減らす (全て調べる書き方が重い)
+        if (i % 10 == 0) {
+            Matrix4x4 view = Inverse(MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, { angle(random) * 0.5f, angle(random), 0.0f }, origin));
+            Matrix4x4 projection = MakePerspectiveFovMatrix(0.8f, 16.0f / 9.0f, 0.1f, worldSize * 0.25f);
+            queries.frustums.push_back(MakeFrustum(Multiply(view, projection)));
+        }
+    }
+    return queries;
+}
+
+// 問い合わせ1回あたりの時間 (ナノ秒) と、結果が全て調べたときと一致したか
+struct QueryTimes {
+    double overlap = 0.0;
+    double frustum = 0.0;
+    double ray = 0.0;
+    double nearest = 0.0;
+    uint64_t results = 0;
+    bool matched = true;
+};
+
+const uint32_t kNeighborCount = 8;
+volatile float rayDistanceSink = 0.0f;
+
+QueryTimes MeasureBvh(const DynamicBvh& bvh, const Queries& queries, const BruteForce* reference, uint32_t checkCount) {
+    QueryTimes times;
+    std::vector<uint32_t> results;
+    std::vector<uint32_t> expected;
+    auto start = std::chrono::steady_clock::now();
+    for (const Aabb& box : queries.boxes) {
+        results.clear();
+        bvh.QueryOverlap(box, results);
+        times.results += results.size();
+    }
+    times.overlap = Seconds(start) * 1.0e9 / queries.boxes.size();
+    start = std::chrono::steady_clock::now();
+    for (const Frustum& frustum : queries.frustums) {
+        results.clear();
+        bvh.QueryFrustum(frustum, results);
+        times.results += results.size();
+    }
+    times.frustum = Seconds(start) * 1.0e9 / queries.frustums.size();
+    start = std::chrono::steady_clock::now();
+    for (const Ray& ray : queries.rays) {
+        BvhRayHit hit;
+        times.results += bvh.RayCast(ray, 1.0e6f, &hit) ? 1 : 0;
+    }
+    times.ray = Seconds(start) * 1.0e9 / queries.rays.size();
+    std::vector<BvhNeighbor> neighbors;
+    start = std::chrono::steady_clock::now();
+    for (const Vector3& point : queries.points) {
+        bvh.QueryNearest(point, kNeighborCount, neighbors);
+        times.results += neighbors.size();
+    }
+    times.nearest = Seconds(start) * 1.0e9 / queries.points.size();
+
+    if (reference == nullptr) {
+        return times;
+    }
+    // 先頭の checkCount 個を全て調べた結果と比べる
+    for (uint32_t i = 0; i < checkCount && i < queries.boxes.size(); ++i) {
+        results.clear();
+        expected.clear();
+        bvh.QueryOverlap(queries.boxes[i], results);
+        reference->Overlap(queries.boxes[i], expected);
+        std::sort(results.begin(), results.end());
+        times.matched = times.matched && results == expected;
+
+        BvhRayHit hit;
+        BvhRayHit expectedHit;
+        bool found = bvh.RayCast(queries.rays[i], 1.0e6f, &hit);
+        bool expectedFound = reference->RayCast(queries.rays[i], 1.0e6f, &expectedHit);
+        times.matched = times.matched && found == expectedFound && (!found || hit.distance == expectedHit.distance);
+
+        std::vector<float> expectedDistances;
+        bvh.QueryNearest(queries.points[i], kNeighborCount, neighbors);
+        reference->Nearest(queries.points[i], kNeighborCount, expectedDistances);
+        times.matched = times.matched && neighbors.size() == expectedDistances.size();
+        for (uint32_t k = 0; k < neighbors.size() && k < expectedDistances.size(); ++k) {
+            times.matched = times.matched && neighbors[k].distanceSquared == expectedDistances[k] &&
+                reference->alive[neighbors[k].proxy] && reference->DistanceSquared(neighbors[k].proxy, queries.points[i]) == expectedDistances[k];
+        }
+    }
+    for (uint32_t i = 0; i < checkCount / 10 && i < queries.frustums.size(); ++i) {
+        results.clear();
+        expected.clear();
+        bvh.QueryFrustum(queries.frustums[i], results);
+        reference->Frustum(queries.frustums[i], expected);
+        std::sort(results.begin(), results.end());
+        times.matched = times.matched && results == expected;
+    }
+    return times;
+}
+
+QueryTimes MeasureBruteForce(const BruteForce& bruteForce, const Queries& queries, uint32_t count) {
+    QueryTimes times;
+    std::vector<uint32_t> results;
+    uint32_t frustumCount = std::max(1u, count / 10);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; ++i) {
+        results.clear();
+        bruteForce.Overlap(queries.boxes[i], results);
+        times.results += results.size();
+    }
+    times.overlap = Seconds(start) * 1.0e9 / count;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < frustumCount; ++i) {
+        results.clear();
+        bruteForce.Frustum(queries.frustums[i], results);
+        times.results += results.size();
+    }
+    times.frustum = Seconds(start) * 1.0e9 / frustumCount;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; ++i) {
+        BvhRayHit hit;
+        times.results += bruteForce.RayCast(queries.rays[i], 1.0e6f, &hit) ? 1 : 0;
+        // 時刻を読む前に計算し終えるように、結果を外に書く
+        rayDistanceSink = hit.distance;
+    }
+    times.ray = Seconds(start) * 1.0e9 / count;
+    std::vector<float> distances;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; ++i) {
+        bruteForce.Nearest(queries.points[i], kNeighborCount, distances);
+        times.results += distances.size();
+    }
+    times.nearest = Seconds(start) * 1.0e9 / count;
+    return times;
+}
+
+void PrintTimes(const char* name, const QueryTimes& times) {
+    std::printf("  %-8s overlap %9.0fns  frustum %11.0fns  ray %9.0fns  nearest%u %9.0fns%s\n", name, times.overlap, times.frustum,
+        times.ray, kNeighborCount, times.nearest, times.matched ? "" : "  MISMATCH");
+}
+
+bool Measure(uint32_t objectCount) {
+    std::mt19937 random(objectCount);
+    // 数が変わっても密度が同じになるように広さを決める
+    float worldSize = std::cbrt(float(objectCount)) * 4.0f;
+    BruteForce bruteForce;
+    for (uint32_t i = 0; i < objectCount; ++i) {
+        bruteForce.bounds.push_back(RandomBox(random, worldSize, 0.5f, 2.0f));
+        bruteForce.alive.push_back(1);
+    }
+    Queries queries = MakeQueries(random, worldSize, 1000);
+    std::printf("%u objects\n", objectCount);
+
+    // 動かない木 (SAH)
+    DynamicBvh staticBvh;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < objectCount; ++i) {
+        staticBvh.CreateProxy(bruteForce.bounds[i], i, true);
+    }
+    staticBvh.Update();
+    double staticBuild = Seconds(start);
+    // 動く木 (最初はまとめて作る。余白は1フレームに動く量より大きくする)
+    DynamicBvh dynamicBvh(0.5f);
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < objectCount; ++i) {
+        dynamicBvh.CreateProxy(bruteForce.bounds[i], i);
+    }
+    dynamicBvh.Update();
+    double dynamicBuild = Seconds(start);
+    std::printf("  build    static %.1fms, dynamic %.1fms%s, %u / %u nodes, %u rotations\n", staticBuild * 1000.0, dynamicBuild * 1000.0,
+        dynamicBvh.GetStats().dynamicRebuilt ? " (bulk SAH)" : "", staticBvh.GetStats().staticNodeCount, dynamicBvh.GetStats().dynamicNodeCount,
+        dynamicBvh.GetStats().rotationCount);
+
+    const uint32_t checkCount = 100;
+    QueryTimes staticTimes = MeasureBvh(staticBvh, queries, &bruteForce, checkCount);
+    QueryTimes dynamicTimes = MeasureBvh(dynamicBvh, queries, &bruteForce, checkCount);
+    // 全て調べる書き方は 1億回の箱の判定ほどに抑える
+    uint32_t bruteCount = std::max(10u, std::min(1000u, uint32_t(100000000ull / objectCount)));
+    QueryTimes bruteTimes = MeasureBruteForce(bruteForce, queries, bruteCount);
+    PrintTimes("static", staticTimes);
+    PrintTimes("dynamic", dynamicTimes);
+    PrintTimes("brute", bruteTimes);
+    std::printf("  speedup  overlap x%.0f, frustum x%.0f, ray x%.0f, nearest x%.0f (static)\n", bruteTimes.overlap / staticTimes.overlap,
+        bruteTimes.frustum / staticTimes.frustum, bruteTimes.ray / staticTimes.ray, bruteTimes.nearest / staticTimes.nearest);
+
+    // 毎フレーム 0.1% を足す (木にあるものより少ないので、作り直さずに1つずつ挿入する)
+    const uint32_t frameCount = 10;
+    uint32_t addCount = std::max(1u, objectCount / 1000);
+    double insertSeconds = 0.0;
+    bool rebuilt = false;
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+        std::vector<Aabb> added;
+        for (uint32_t i = 0; i < addCount; ++i) {
+            added.push_back(RandomBox(random, worldSize, 0.5f, 2.0f));
+        }
+        start = std::chrono::steady_clock::now();
+        for (const Aabb& box : added) {
+            dynamicBvh.CreateProxy(box, static_cast<uint32_t>(bruteForce.bounds.size()));
+            bruteForce.bounds.push_back(box);
+            bruteForce.alive.push_back(1);
+        }
+        dynamicBvh.Update();
+        insertSeconds += Seconds(start);
+        rebuilt = rebuilt || dynamicBvh.GetStats().dynamicRebuilt;
+    }
+    std::printf("  insert   0.1%%: CreateProxy and Update %.2fms per frame (%.0fns each)%s\n", insertSeconds * 1000.0 / frameCount,
+        insertSeconds * 1.0e9 / (double(frameCount) * addCount), rebuilt ? ", rebuilt" : "");
+
+    // 10% を少し動かす
+    std::uniform_real_distribution<float> step(-0.2f, 0.2f);
+    std::vector<uint32_t> moving;
+    for (uint32_t i = 0; i < objectCount; i += 10) {
+        moving.push_back(i);
+    }
+    double moveSeconds = 0.0;
+    double updateSeconds = 0.0;
+    uint32_t reinserts = 0;
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+        for (uint32_t i : moving) {
+            Aabb& b = bruteForce.bounds[i];
+            Vector3 offset = { step(random), step(random), step(random) };
+            b = { { b.min.x + offset.x, b.min.y + offset.y, b.min.z + offset.z }, { b.max.x + offset.x, b.max.y + offset.y, b.max.z + offset.z } };
+        }
+        start = std::chrono::steady_clock::now();
+        for (uint32_t i : moving) {
+            dynamicBvh.MoveProxy(i, bruteForce.bounds[i]);
+        }
+        moveSeconds += Seconds(start);
+        start = std::chrono::steady_clock::now();
+        dynamicBvh.Update();
+        updateSeconds += Seconds(start);
+        reinserts += dynamicBvh.GetStats().reinsertCount;
+    }
+    QueryTimes movedTimes = MeasureBvh(dynamicBvh, queries, &bruteForce, checkCount);
+    std::printf("  move     10%%: MoveProxy %.2fms (%.0fns each, %.1f%% reinserted), Update %.2fms per frame\n", moveSeconds * 1000.0 / frameCount,
+        moveSeconds * 1.0e9 / (double(frameCount) * moving.size()), 100.0 * reinserts / (double(frameCount) * moving.size()),
+        updateSeconds * 1000.0 / frameCount);
+    PrintTimes("moved", movedTimes);
+    return staticTimes.matched && dynamicTimes.matched && movedTimes.matched && !rebuilt;
+}
+
+// 作成・破棄・移動を混ぜて、毎回の問い合わせを全て調べた結果と比べる
+bool CheckRandomOperations(uint32_t roundCount) {
+    std::mt19937 random(3);
+    const float worldSize = 40.0f;
+    DynamicBvh bvh(0.25f);
+    BruteForce bruteForce;
+    bool matched = true;
+    uint32_t operations = 0;
+    for (uint32_t round = 0; round < roundCount && matched; ++round) {
+        uint32_t count = 1 + random() % 64;
+        for (uint32_t o = 0; o < count; ++o, ++operations) {
+            uint32_t operation = random() % 8;
+            uint32_t size = static_cast<uint32_t>(bruteForce.bounds.size());
+            uint32_t target = size > 0 ? random() % size : 0;
+            if (size == 0 || operation < 3) {
+                Aabb box = RandomBox(random, worldSize, 0.1f, 3.0f);
+                uint32_t proxy = bvh.CreateProxy(box, 0, random() % 4 == 0);
+                if (proxy >= bruteForce.bounds.size()) {
+                    bruteForce.bounds.resize(proxy + 1);
+                    bruteForce.alive.resize(proxy + 1, 0);
+                }
+                bruteForce.bounds[proxy] = box;
+                bruteForce.alive[proxy] = 1;
+            } else if (!bruteForce.alive[target]) {
+                continue;
+            } else if (operation < 5) {
+                bvh.DestroyProxy(target);
+                bruteForce.alive[target] = 0;
+            } else {
+                // 少し動かすか、遠くへ飛ばす
+                Aabb box = bruteForce.bounds[target];
+                if (operation < 7) {
+                    float dx = float(int(random() % 21) - 10) * 0.05f;
+                    box = { { box.min.x + dx, box.min.y, box.min.z - dx }, { box.max.x + dx, box.max.y, box.max.z - dx } };
+                } else {
+                    box = RandomBox(random, worldSize, 0.1f, 3.0f);
+                }
+                bvh.MoveProxy(target, box);
+                bruteForce.bounds[target] = box;
+            }
+        }
+        bvh.Update();
+        Queries queries = MakeQueries(random, worldSize, 10);
+        QueryTimes times = MeasureBvh(bvh, queries, &bruteForce, 10);
+        matched = times.matched;
+        uint32_t alive = 0;
+        for (uint8_t flag : bruteForce.alive) {
+            alive += flag;
+        }
+        matched = matched && bvh.GetProxyCount() == alive;
+    }
+    std::printf("check:    %u rounds, %u operations, %u proxies (%u static) -> %s\n", roundCount, operations, bvh.GetProxyCount(),
+        bvh.GetStats().staticProxyCount, matched ? "ok" : "FAILED");
+    return matched;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t maxCount = argc > 1 ? uint32_t(std::atoi(argv[1])) : 1000000;
+
+    bool passed = CheckRandomOperations(1000);
+    for (uint32_t count = 10000; count <= maxCount; count *= 10) {
+        passed = Measure(count) && passed;
+    }
+    std::printf("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,117 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "DebugDrawList.h"
+
+// デバッグ表示の線分を足す速さの計測
+// スレッド数を 1 から指定の数まで増やしながら、各スレッドが同時に線分を足す速さと、まとめて書き出す時間を出す
+// GPUは使わない (頂点はただの配列に書く)
+// スレッドはフレームごとに立て直すので、置き場がスレッド数より増えないことも確かめる
+// 使い方: DebugDrawBench.exe [最大スレッド数] [1スレッドが1フレームに足す線分の数] [フレーム数] (省略時は 8 100000 50)
+//
+// DXCやWindowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -pthread -Iengine/Math -Iengine/DebugDraw -o DebugDrawBench tools/DebugDrawBench/main.cpp
+//       engine/DebugDraw/DebugDrawList.cpp engine/Math/MathUtil.cpp
+
+namespace {
+
+double ToMilliseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+uint32_t ReadArgument(int argc, char* argv[], int index, uint32_t defaultValue) {
+    if (index < argc) {
+        return static_cast<uint32_t>(std::strtoul(argv[index], nullptr, 10));
+    }
+    return defaultValue;
+}
+
+// 1スレッド分の線分を足す (深度テストありと常に手前を交互に。たまに残す線分を混ぜる)
+void AppendLines(DebugDrawList& list, uint32_t threadIndex, uint32_t lineCount) {
+    DebugDrawOptions options;
+    DebugDrawOptions overlay;
+    overlay.depthTest = false;
+    DebugDrawOptions persistent;
+    persistent.frames = 4;
+    for (uint32_t i = 0; i < lineCount; ++i) {
+        float x = float(i % 1000);
+        float z = float(threadIndex * 100 + i / 1000);
+        const DebugDrawOptions& selected = (i % 1024 == 0) ? persistent : ((i & 1) ? overlay : options);
+        list.Line({ x, 0.0f, z }, { x, 1.0f, z }, { 0.0f, 1.0f, 0.0f, 1.0f }, selected);
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t maxThreads = ReadArgument(argc, argv, 1, 8);
+    uint32_t lineCount = ReadArgument(argc, argv, 2, 100000);
+    uint32_t frameCount = ReadArgument(argc, argv, 3, 50);
+    if (maxThreads == 0 || lineCount == 0 || frameCount == 0) {
+        std::printf("usage: DebugDrawBench [max threads] [lines per thread] [frames]\n");
+        return 1;
+    }
+    std::printf("lines per thread: %u, frames: %u, hardware threads: %u\n", lineCount, frameCount, std::thread::hardware_concurrency());
+
+    bool ok = true;
+    std::vector<DebugVertex> vertices;
+    for (uint32_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        DebugDrawList list;
+        double appendMilliseconds = 0.0;
+        double writeMilliseconds = 0.0;
+        uint32_t writtenCount = 0;
+        for (uint32_t frame = 0; frame < frameCount; ++frame) {
+            // ワーカーを立てる時間は含めないよう、全員がそろってから足し始める
+            std::atomic<uint32_t> ready{ 0 };
+            std::atomic<bool> go{ false };
+            std::vector<std::thread> threads;
+            for (uint32_t t = 0; t < threadCount; ++t) {
+                threads.emplace_back([&, t] {
+                    ready.fetch_add(1);
+                    while (!go.load(std::memory_order_acquire)) {
+                        std::this_thread::yield();
+                    }
+                    AppendLines(list, t, lineCount);
+                });
+            }
+            while (ready.load() < threadCount) {
+                std::this_thread::yield();
+            }
+            auto start = std::chrono::steady_clock::now();
+            go.store(true, std::memory_order_release);
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+            auto appended = std::chrono::steady_clock::now();
+
+            list.Collect();
+            writtenCount = 0;
+            for (uint32_t category = 0; category < DebugDrawList::kCategoryCount; ++category) {
+                DebugDrawCategory drawCategory = static_cast<DebugDrawCategory>(category);
+                uint32_t count = list.GetVertexCount(drawCategory);
+                if (vertices.size() < writtenCount + size_t(count)) {
+                    vertices.resize(writtenCount + size_t(count));
+                }
+                writtenCount += list.Write(drawCategory, vertices.data() + writtenCount, count);
+            }
+            list.EndFrame();
+            auto written = std::chrono::steady_clock::now();
+            appendMilliseconds += ToMilliseconds(appended - start);
+            writeMilliseconds += ToMilliseconds(written - appended);
+        }
+        // 最後のフレームは、このフレームの線分に加えて、直前の4フレームで残した線分が出る
+        uint32_t persistentLines = (lineCount + 1023) / 1024 * threadCount;
+        uint32_t expected = (lineCount * threadCount - persistentLines + persistentLines * (frameCount < 4 ? frameCount : 4)) * 2;
+        uint32_t bufferCount = list.GetThreadBufferCount();
+        ok = ok && writtenCount == expected && bufferCount <= threadCount;
+        double lines = double(lineCount) * threadCount;
+        std::printf("threads: %2u  append: %8.3fms/frame (%6.1f Mlines/s)  collect+write: %8.3fms/frame  vertices: %u%s  buffers: %u%s\n",
+            threadCount, appendMilliseconds / frameCount, lines / (appendMilliseconds / frameCount) / 1000.0,
+            writeMilliseconds / frameCount, writtenCount, writtenCount == expected ? "" : " (mismatch)", bufferCount,
+            bufferCount <= threadCount ? "" : " (leaked)");
+    }
+    return ok ? 0 : 1;
+}
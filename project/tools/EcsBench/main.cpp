@@ -0,0 +1,280 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+#include "EntityWorld.h"
+#include "JobSystem.h"
+#include "MathUtil.h"
+#include "TransformSystem.h"
+
+// EntityWorld の確認と計測
+// まず作成・破棄・足す・外すを混ぜて繰り返し、別に持っている正解と全てのコンポーネントの値が合うこと、
+// 破棄が必要な型 (文字列を持つもの) が作った数だけ破棄されることを確かめる
+// 次に 100万のエンティティで、作成・ForEach での更新・UpdateTransforms (ワーカー1つと全てのワーカー)・コンポーネントを足す/外す・破棄と作り直しの時間を測る
+// 比べるために、前の Model と同じく1つずつ new したオブジェクトをポインタの配列でたどる書き方も測る (確保の順とたどる順はばらばら)
+// 使い方: EcsBench.exe [エンティティの数] [ワーカーの数] (省略時は 1000000 と コア数)
+//
+// Windowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -pthread -Iengine/ECS -Iengine/Job -Iengine/Math -o EcsBench tools/EcsBench/main.cpp engine/ECS/ComponentType.cpp engine/ECS/EntityWorld.cpp engine/ECS/TransformSystem.cpp engine/ECS/TransformHierarchy.cpp engine/Job/JobSystem.cpp engine/Math/MathUtil.cpp
+
+namespace {
+
+struct Velocity {
+    Vector3 value;
+};
+
+// 足したり外したりする目印
+struct Selected {};
+
+// 破棄が必要なコンポーネント (作った数と破棄した数を数える)
+std::atomic<int64_t> liveNames = 0;
+struct Name {
+    std::string text;
+    Name() { liveNames.fetch_add(1, std::memory_order_relaxed); }
+    explicit Name(std::string value) : text(std::move(value)) { liveNames.fetch_add(1, std::memory_order_relaxed); }
+    Name(const Name& other) : text(other.text) { liveNames.fetch_add(1, std::memory_order_relaxed); }
+    Name(Name&& other) noexcept : text(std::move(other.text)) { liveNames.fetch_add(1, std::memory_order_relaxed); }
+    Name& operator=(const Name&) = default;
+    Name& operator=(Name&&) noexcept = default;
+    ~Name() { liveNames.fetch_sub(1, std::memory_order_relaxed); }
+};
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// ランダムに作成・破棄・足す・外すを繰り返し、正解と比べる
+bool CheckRandomOperations(uint32_t operationCount) {
+    struct Expected {
+        Entity entity;
+        bool hasVelocity = false;
+        bool hasName = false;
+        bool hasSelected = false;
+        float value = 0.0f;
+    };
+    bool passed = true;
+    {
+        EntityWorld world;
+        std::vector<Expected> alive;
+        std::mt19937 random(7);
+        std::vector<Entity> destroyed;
+        for (uint32_t i = 0; i < operationCount; ++i) {
+            uint32_t operation = random() % 7;
+            if (operation == 0 || operation == 6 || alive.size() < 16) {
+                Expected expected;
+                expected.value = float(i);
+                if (random() % 2 == 0) {
+                    expected.entity = world.Create(Transform{ { 1.0f, 1.0f, 1.0f }, {}, { expected.value, 0.0f, 0.0f } });
+                } else {
+                    expected.entity = world.Create(Transform{ { 1.0f, 1.0f, 1.0f }, {}, { expected.value, 0.0f, 0.0f } },
+                        Name(std::to_string(i)), Velocity{ { expected.value, 0.0f, 0.0f } });
+                    expected.hasName = true;
+                    expected.hasVelocity = true;
+                }
+                alive.push_back(expected);
+                continue;
+            }
+            Expected& target = alive[random() % alive.size()];
+            switch (operation) {
+            case 1:
+                world.Add(target.entity, Velocity{ { target.value, 0.0f, 0.0f } });
+                target.hasVelocity = true;
+                break;
+            case 2:
+                world.Remove<Velocity>(target.entity);
+                target.hasVelocity = false;
+                break;
+            case 3:
+                world.Add(target.entity, Name(std::to_string(uint32_t(target.value))));
+                target.hasName = true;
+                break;
+            case 4:
+                if (target.hasSelected) {
+                    world.Remove<Selected>(target.entity);
+                } else {
+                    world.Add<Selected>(target.entity);
+                }
+                target.hasSelected = !target.hasSelected;
+                break;
+            default:
+                world.Destroy(target.entity);
+                destroyed.push_back(target.entity);
+                target = alive.back();
+                alive.pop_back();
+                break;
+            }
+        }
+        for (const Expected& expected : alive) {
+            const Transform* transform = world.Get<Transform>(expected.entity);
+            const Velocity* velocity = world.Get<Velocity>(expected.entity);
+            const Name* name = world.Get<Name>(expected.entity);
+            passed = passed && transform != nullptr && transform->translate.x == expected.value;
+            passed = passed && (velocity != nullptr) == expected.hasVelocity && (!velocity || velocity->value.x == expected.value);
+            passed = passed && (name != nullptr) == expected.hasName && (!name || name->text == std::to_string(uint32_t(expected.value)));
+            passed = passed && world.Has<Selected>(expected.entity) == expected.hasSelected;
+        }
+        for (Entity entity : destroyed) {
+            passed = passed && !world.IsAlive(entity) && world.Get<Transform>(entity) == nullptr;
+        }
+        // ForEach と数が合う
+        uint32_t velocityCount = 0;
+        uint32_t expectedVelocityCount = 0;
+        for (const Expected& expected : alive) {
+            expectedVelocityCount += expected.hasVelocity && !expected.hasSelected ? 1 : 0;
+        }
+        world.ForEach<const Velocity>(EntityQuery().Without<Selected>(), [&](Entity entity, const Velocity& velocity) {
+            const Transform* transform = world.Get<Transform>(entity);
+            passed = passed && transform != nullptr && transform->translate.x == velocity.value.x;
+            ++velocityCount;
+        });
+        passed = passed && velocityCount == expectedVelocityCount && world.GetEntityCount() == alive.size();
+        passed = passed && world.Count<Transform>() == alive.size();
+        EntityWorld::Stats stats = world.GetStats();
+        std::printf("check:      %u operations, %u alive, %u archetypes, %u chunks\n", operationCount, stats.entityCount,
+            stats.archetypeCount, stats.chunkCount);
+    }
+    passed = passed && liveNames.load() == 0;
+    std::printf("check:      %s (live names after destruction: %lld)\n", passed ? "ok" : "FAILED",
+        static_cast<long long>(liveNames.load()));
+    return passed;
+}
+
+// 前の Model と同じく1つずつ new したオブジェクト (GPU のリソースの分の大きさも持たせる)
+struct HeapObject {
+    Transform transform;
+    Velocity velocity;
+    Matrix4x4 world;
+    LocalBounds localBounds;
+    WorldBounds worldBounds;
+    std::byte resources[160];
+};
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t entityCount = argc > 1 ? uint32_t(std::atoi(argv[1])) : 1000000;
+    uint32_t workerCount = argc > 2 ? uint32_t(std::atoi(argv[2])) : 0;
+
+    JobSystem* jobSystem = JobSystem::GetInstance();
+    jobSystem->Initialize(workerCount > 0 ? workerCount - 1 : 0);
+    bool passed = CheckRandomOperations(200000);
+
+    EntityWorld world;
+    std::vector<Entity> entities(entityCount);
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < entityCount; ++i) {
+        float x = float(i % 1000);
+        float z = float(i / 1000);
+        entities[i] = world.Create(Transform{ { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f }, { x, 0.0f, z } }, Velocity{ { 0.0f, 1.0f, 0.0f } },
+            LocalToWorld{}, LocalBounds{ { -0.5f, -0.5f, -0.5f }, { 0.5f, 0.5f, 0.5f } }, WorldBounds{});
+    }
+    double createSeconds = Seconds(start);
+    EntityWorld::Stats stats = world.GetStats();
+    std::printf("create:     %u entities in %.1fms (%.1fns each), %u chunks\n", entityCount, createSeconds * 1000.0,
+        createSeconds * 1.0e9 / entityCount, stats.chunkCount);
+
+    // 位置を速度で進める
+    const float deltaTime = 1.0f / 60.0f;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < 10; ++frame) {
+        world.ForEach<Transform, const Velocity>([deltaTime](Transform& transform, const Velocity& velocity) {
+            transform.translate.x += velocity.value.x * deltaTime;
+            transform.translate.y += velocity.value.y * deltaTime;
+            transform.translate.z += velocity.value.z * deltaTime;
+        });
+    }
+    double forEachSeconds = Seconds(start) / 10.0;
+
+    // 1つずつ new したオブジェクト (他の確保と混ぜて、たどる順もばらばらにする)
+    std::vector<HeapObject*> objects(entityCount);
+    std::vector<std::unique_ptr<std::byte[]>> noise;
+    std::mt19937 random(1);
+    for (uint32_t i = 0; i < entityCount; ++i) {
+        objects[i] = new HeapObject();
+        objects[i]->velocity.value = { 0.0f, 1.0f, 0.0f };
+        noise.push_back(std::make_unique<std::byte[]>(16 + random() % 256));
+    }
+    noise.clear();
+    std::shuffle(objects.begin(), objects.end(), random);
+    start = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < 10; ++frame) {
+        for (HeapObject* object : objects) {
+            object->transform.translate.x += object->velocity.value.x * deltaTime;
+            object->transform.translate.y += object->velocity.value.y * deltaTime;
+            object->transform.translate.z += object->velocity.value.z * deltaTime;
+        }
+    }
+    double heapSeconds = Seconds(start) / 10.0;
+    for (HeapObject* object : objects) {
+        delete object;
+    }
+    std::printf("update:     ForEach %.2fms (%.2fns each), heap objects %.2fms (x%.1f slower)\n", forEachSeconds * 1000.0,
+        forEachSeconds * 1.0e9 / entityCount, heapSeconds * 1000.0, heapSeconds / forEachSeconds);
+
+    // 行列と AABB (ワーカー1つと、全てのワーカー)
+    uint32_t workers = jobSystem->GetWorkerCount();
+    jobSystem->Finalize();
+    jobSystem->Initialize(0);
+    start = std::chrono::steady_clock::now();
+    UpdateTransforms(world);
+    double serialSeconds = Seconds(start);
+    jobSystem->Finalize();
+    jobSystem->Initialize(workers - 1);
+    start = std::chrono::steady_clock::now();
+    UpdateTransforms(world);
+    double parallelSeconds = Seconds(start);
+    std::printf("transforms: 1 worker %.2fms, %u workers %.2fms (x%.2f)\n", serialSeconds * 1000.0, workers, parallelSeconds * 1000.0,
+        serialSeconds / parallelSeconds);
+    {
+        const WorldBounds* bounds = world.Get<WorldBounds>(entities[entityCount - 1]);
+        const Transform* transform = world.Get<Transform>(entities[entityCount - 1]);
+        passed = passed && bounds != nullptr && std::fabs(bounds->min.y - (transform->translate.y - 0.5f)) < 1.0e-4f;
+    }
+
+    // 目印を足して外す (アーキタイプの間を移る)
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < entityCount; ++i) {
+        world.Add<Selected>(entities[i]);
+    }
+    double addSeconds = Seconds(start);
+    uint32_t selectedCount = world.Count<Selected>();
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < entityCount; ++i) {
+        world.Remove<Selected>(entities[i]);
+    }
+    double removeSeconds = Seconds(start);
+    std::printf("structure:  add %.1fns, remove %.1fns per entity\n", addSeconds * 1.0e9 / entityCount, removeSeconds * 1.0e9 / entityCount);
+    passed = passed && selectedCount == entityCount && world.Count<Selected>() == 0;
+
+    // 半分をばらばらの順に破棄して作り直す
+    std::vector<uint32_t> order(entityCount);
+    for (uint32_t i = 0; i < entityCount; ++i) {
+        order[i] = i;
+    }
+    std::shuffle(order.begin(), order.end(), random);
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < entityCount / 2; ++i) {
+        world.Destroy(entities[order[i]]);
+    }
+    double destroySeconds = Seconds(start);
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < entityCount / 2; ++i) {
+        entities[order[i]] = world.Create(Transform{ { 1.0f, 1.0f, 1.0f }, {}, {} }, Velocity{}, LocalToWorld{}, LocalBounds{}, WorldBounds{});
+    }
+    double recreateSeconds = Seconds(start);
+    stats = world.GetStats();
+    std::printf("churn:      destroy %.1fns, create %.1fns per entity (%u chunks, %u free)\n", destroySeconds * 1.0e9 / (entityCount / 2),
+        recreateSeconds * 1.0e9 / (entityCount / 2), stats.chunkCount, stats.freeChunkCount);
+    passed = passed && world.GetEntityCount() == entityCount && world.Count<Transform, Velocity>() == entityCount;
+
+    jobSystem->Finalize();
+    std::printf("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
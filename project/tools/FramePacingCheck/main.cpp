@@ -0,0 +1,150 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "FramePacer.h"
+
+// FramePacer の確認 (シミュレーションの時計で回すので実時間はかからない)
+// 上限のフレームレートで処理の時間がばらつくとき、間隔が上限の間隔に揃い、ずれが溜まらないこと
+// 1フレーム分以上遅れた後に、取り戻そうとして短いフレームが続かないこと
+// 制限しないときは処理の時間がそのまま間隔になること、中央値と99%の値が分布と合うこと、コマンドラインの解釈を確かめる
+// 使い方: FramePacingCheck.exe [フレーム数] (省略時は 20000)
+//
+// Windowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 "-Iengine/Basic functions" -o FramePacingCheck tools/FramePacingCheck/main.cpp "engine/Basic functions/FramePacer.cpp"
+
+namespace {
+
+// シミュレーションの時計 (待つと時刻が進む。OS の寝過ごしをまねて少し遅れて起きる)
+class SimulatedFrameClock : public FrameClock {
+public:
+    explicit SimulatedFrameClock(int64_t maxOversleep) : maxOversleep_(maxOversleep), random_(12345) {}
+
+    int64_t Now() override { return time_; }
+    void SleepUntil(int64_t time) override {
+        if (time > time_) {
+            time_ = time + (maxOversleep_ > 0 ? std::uniform_int_distribution<int64_t>(0, maxOversleep_)(random_) : 0);
+        }
+    }
+
+    // フレームの処理をしたことにする
+    void Advance(int64_t nanoseconds) { time_ += nanoseconds; }
+
+private:
+    int64_t time_ = 1000000000;
+    int64_t maxOversleep_ = 0;
+    std::mt19937 random_;
+};
+
+const int64_t kMillisecond = 1000000;
+
+bool Check(bool condition, const char* message) {
+    if (!condition) {
+        std::printf("FAILED: %s\n", message);
+    }
+    return condition;
+}
+
+void Print(const char* label, const FrameTimeStats& stats) {
+    std::printf("%-11s %llu frames, avg %.3fms, p50 %.3fms, p99 %.3fms, min %.3fms, max %.3fms\n", label,
+        static_cast<unsigned long long>(stats.frameCount), stats.averageMilliseconds, stats.p50Milliseconds, stats.p99Milliseconds,
+        stats.minMilliseconds, stats.maxMilliseconds);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t frameCount = argc > 1 ? uint32_t(std::atoi(argv[1])) : 20000;
+    bool passed = true;
+    std::mt19937 random(6789);
+
+    // 144fps の上限、処理は 2～5ms、起きるのは最大 0.3ms 遅れる
+    {
+        SimulatedFrameClock clock(300000);
+        FramePacer pacer;
+        pacer.Initialize(&clock, 144.0);
+        std::uniform_int_distribution<int64_t> work(2 * kMillisecond, 5 * kMillisecond);
+        int64_t start = clock.Now();
+        for (uint32_t i = 0; i < frameCount; ++i) {
+            pacer.BeginFrame();
+            clock.Advance(work(random));
+        }
+        FrameTimeStats stats = pacer.GetStats();
+        Print("capped:", stats);
+        // 予定は前の予定から数えるので、寝過ごしがあっても平均は上限の間隔になる
+        double interval = 1000.0 / 144.0;
+        double elapsed = double(clock.Now() - start) / 1e6;
+        passed = Check(std::abs(stats.averageMilliseconds - interval) < 0.01, "average interval must match the limit") && passed;
+        passed = Check(std::abs(elapsed / frameCount - interval) < 0.01, "no drift over the session") && passed;
+        passed = Check(stats.p99Milliseconds < interval + 0.35 && stats.minMilliseconds > interval - 0.35, "intervals stay near the limit") &&
+            passed;
+    }
+
+    // 60fps の上限で、ときどき 40ms かかるフレーム (取り戻そうとして間隔の短いフレームが続かない)
+    {
+        SimulatedFrameClock clock(0);
+        FramePacer pacer;
+        pacer.Initialize(&clock, 60.0);
+        uint32_t shortFrames = 0;
+        for (uint32_t i = 0; i < frameCount; ++i) {
+            pacer.BeginFrame();
+            if (i > 0 && pacer.GetLastFrameMilliseconds() < 1000.0 / 60.0 - 0.001) {
+                ++shortFrames;
+            }
+            clock.Advance(i % 100 == 50 ? 40 * kMillisecond : 4 * kMillisecond);
+        }
+        FrameTimeStats stats = pacer.GetStats();
+        Print("hitches:", stats);
+        std::printf("            %u frames shorter than the limit\n", shortFrames);
+        passed = Check(shortFrames == 0, "a hitch must not be followed by a burst of short frames") && passed;
+        passed = Check(std::abs(stats.maxMilliseconds - 40.0) < 0.001, "the hitch is the longest frame") && passed;
+    }
+
+    // 制限しない (処理の時間がそのまま間隔になる。分布は 1～10ms の一様なので中央値は 5.5ms、99%は 9.9ms)
+    {
+        SimulatedFrameClock clock(1 * kMillisecond);
+        FramePacer pacer;
+        pacer.Initialize(&clock, 0.0);
+        for (uint32_t i = 0; i < frameCount; ++i) {
+            pacer.BeginFrame();
+            clock.Advance(kMillisecond + int64_t(i % 1000) * 9 * kMillisecond / 1000);
+        }
+        pacer.BeginFrame();
+        FrameTimeStats stats = pacer.GetStats();
+        Print("uncapped:", stats);
+        passed = Check(stats.frameCount == frameCount, "every frame is counted") && passed;
+        passed = Check(std::abs(stats.p50Milliseconds - 5.5) < 0.02 && std::abs(stats.p99Milliseconds - 9.91) < 0.02, "percentiles") && passed;
+        passed = Check(std::abs(stats.minMilliseconds - 1.0) < 0.001 && std::abs(stats.maxMilliseconds - 9.991) < 0.001, "min and max") &&
+            passed;
+
+        // 上限を付けると予定を付け直す (制限しなかったときのフレームは集計から外す)
+        pacer.SetTargetFrameRate(100.0);
+        pacer.BeginFrame();
+        clock.Advance(3 * kMillisecond);
+        pacer.ResetStats();
+        for (uint32_t i = 0; i < 100; ++i) {
+            pacer.BeginFrame();
+            clock.Advance(3 * kMillisecond);
+        }
+        FrameTimeStats limited = pacer.GetStats();
+        passed = Check(std::abs(limited.averageMilliseconds - 10.0) < 0.02, "switching to a limit") && passed;
+    }
+
+    // コマンドライン
+    {
+        PresentSettings settings;
+        std::string error;
+        bool parsed = ParsePresentSettings("--present=tearing --buffers=3 --fps=240 other --latency=2", &settings, &error);
+        passed = Check(parsed && settings.mode == PresentMode::kTearing && settings.backBufferCount == 3 &&
+            settings.targetFrameRate == 240.0 && settings.maxFrameLatency == 2, "parse settings") && passed;
+        passed = Check(!ParsePresentSettings("--present=fast", &settings, &error) && !error.empty(), "reject an unknown mode") && passed;
+        passed = Check(!ParsePresentSettings("--buffers=8", &settings, &error), "reject too many buffers") && passed;
+        passed = Check(ParsePresentSettings("", &settings, &error), "empty command line") && passed;
+    }
+
+    std::printf("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
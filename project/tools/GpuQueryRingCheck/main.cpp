@@ -0,0 +1,196 @@
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <vector>
+#include "GpuQueryRing.h"
+
+// GpuQueryRing の確認 (GPU を使わない)
+// 数フレーム遅れて終わる GPU をまねて、クエリの割り当て・フェンスで終わったフレームの取り出し・ティックから CPU の時刻への変換を回す
+// GPU に出ている間の枠が他のフレームに使われないこと、遅れが枠の数を超えたフレームを記録しないこと、
+// 区間の上限・壊れたタイムスタンプ・大きなティックの値を正しく扱うことを確かめる
+// 使い方: GpuQueryRingCheck.exe [フレーム数] (省略時は 1000)
+//
+// Windowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -Iengine/Profiler -o GpuQueryRingCheck tools/GpuQueryRingCheck/main.cpp engine/Profiler/GpuQueryRing.cpp
+
+namespace {
+
+const char* const kScopeNames[] = { "Frame", "Clear", "Draw", "Sprites" };
+
+// まねる GPU (解決したクエリはフェンスが進んだときに読めるようになる)
+struct FakeGpu {
+    std::vector<uint64_t> heap;     // クエリのヒープ
+    std::vector<uint64_t> readback; // 読み戻し用のバッファ
+    std::vector<int32_t> owner;     // クエリを使っているフレーム (-1 なら空き)
+    struct Submission {
+        uint64_t fenceValue;
+        GpuQueryRange range;
+        int32_t frame;
+    };
+    std::deque<Submission> inFlight;
+    uint64_t completedFenceValue = 0;
+    uint64_t ticks = 1000;
+
+    // フェンスを1つ進める (そのフレームのクエリを読み戻し用のバッファに写す)
+    void Complete() {
+        const Submission& submission = inFlight.front();
+        for (uint32_t i = 0; i < submission.range.queryCount; ++i) {
+            uint32_t query = submission.range.firstQuery + i;
+            readback[query] = heap[query];
+            owner[query] = -1;
+        }
+        completedFenceValue = submission.fenceValue;
+        inFlight.pop_front();
+    }
+};
+
+bool Check(bool condition, const char* message) {
+    if (!condition) {
+        std::printf("FAILED: %s\n", message);
+    }
+    return condition;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t frameCount = argc > 1 ? uint32_t(std::atoi(argv[1])) : 1000;
+    bool passed = true;
+
+    // 10MHz の GPU。ティック 1000 が CPU の 5,000,000ns
+    GpuClockCalibration calibration;
+    calibration.gpuTicks = 1000;
+    calibration.cpuNanoseconds = 5000000;
+    calibration.gpuFrequency = 10000000;
+
+    const uint32_t kRingFrames = 3;
+    const uint32_t kMaxScopes = 4;
+    GpuQueryRing ring;
+    ring.Initialize(kRingFrames, kMaxScopes);
+    FakeGpu gpu;
+    gpu.heap.assign(ring.GetQueryCount(), 0);
+    gpu.readback.assign(ring.GetQueryCount(), 0);
+    gpu.owner.assign(ring.GetQueryCount(), -1);
+
+    uint64_t fenceValue = 0;
+    uint64_t recordedFrames = 0;
+    uint64_t collectedFrames = 0;
+    uint64_t collectedEvents = 0;
+    bool overlap = false;
+    bool timesMatch = true;
+    std::vector<ProfileEvent> events;
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+        // GPU の遅れは 0～4 フレームで揺らす (枠は3つなので、遅れが大きいと記録しないフレームが出る)
+        uint32_t lag = (frame / 50) % 5;
+        while (gpu.inFlight.size() > lag) {
+            gpu.Complete();
+        }
+
+        // 終わったフレームを読む
+        GpuQueryRange range;
+        while (ring.GetCompletedFrame(gpu.completedFenceValue, &range)) {
+            events.clear();
+            ring.ReleaseFrame(gpu.readback.data() + range.firstQuery, calibration, events);
+            ++collectedFrames;
+            collectedEvents += events.size();
+            // 区間はそれぞれ 10 ティック (1000ns) で、入れ子の深さは Frame が 0、他が 1
+            for (const ProfileEvent& event : events) {
+                bool isFrame = std::string(event.name) == "Frame";
+                timesMatch = timesMatch && event.depth == (isFrame ? 0u : 1u) &&
+                    event.end - event.start == (isFrame ? 1000 * (1 + 2 * 3) : 1000);
+            }
+        }
+
+        // 記録する (区間の上限は4つなので、5つ目は捨てられる)
+        if (!ring.BeginFrame()) {
+            continue;
+        }
+        ++recordedFrames;
+        uint32_t query = 0;
+        auto write = [&](uint32_t index) {
+            overlap = overlap || gpu.owner[index] != -1;
+            gpu.owner[index] = int32_t(frame);
+            gpu.ticks += 10;
+            gpu.heap[index] = gpu.ticks;
+        };
+        int32_t frameScope = ring.BeginScope(kScopeNames[0], &query);
+        write(query);
+        for (int i = 1; i < 5; ++i) {
+            int32_t scope = ring.BeginScope(kScopeNames[i % 4], &query);
+            if (scope < 0) {
+                continue;
+            }
+            write(query);
+            ring.EndScope(scope, &query);
+            write(query);
+        }
+        ring.EndScope(frameScope, &query);
+        write(query);
+        ++fenceValue;
+        if (ring.EndFrame(fenceValue, &range)) {
+            gpu.inFlight.push_back({ fenceValue, range, int32_t(frame) });
+        }
+        // 同じフェンスの値で書いたクエリは、GPU に出ている間は他のフレームに使われない
+        for (const FakeGpu::Submission& submission : gpu.inFlight) {
+            for (uint32_t i = 0; i < submission.range.queryCount; ++i) {
+                overlap = overlap || gpu.owner[submission.range.firstQuery + i] != submission.frame;
+            }
+        }
+    }
+    while (!gpu.inFlight.empty()) {
+        gpu.Complete();
+    }
+    GpuQueryRange range;
+    while (ring.GetCompletedFrame(gpu.completedFenceValue, &range)) {
+        events.clear();
+        ring.ReleaseFrame(gpu.readback.data() + range.firstQuery, calibration, events);
+        ++collectedFrames;
+        collectedEvents += events.size();
+    }
+
+    std::printf("frames:     %u, recorded %llu, skipped %llu, collected %llu\n", frameCount,
+        static_cast<unsigned long long>(recordedFrames), static_cast<unsigned long long>(ring.GetSkippedFrameCount()),
+        static_cast<unsigned long long>(collectedFrames));
+    std::printf("scopes:     %llu events, %llu dropped (over the limit), %llu invalid\n", static_cast<unsigned long long>(collectedEvents),
+        static_cast<unsigned long long>(ring.GetDroppedScopeCount()), static_cast<unsigned long long>(ring.GetInvalidScopeCount()));
+    passed = Check(!overlap, "queries of a frame in flight were reused") && passed;
+    passed = Check(timesMatch, "scope durations or depths are wrong") && passed;
+    passed = Check(recordedFrames == collectedFrames, "every recorded frame must be collected once") && passed;
+    passed = Check(recordedFrames + ring.GetSkippedFrameCount() == frameCount, "frames are either recorded or skipped") && passed;
+    passed = Check(ring.GetSkippedFrameCount() > 0, "a lag of more than the ring size must skip frames") && passed;
+    passed = Check(collectedEvents == recordedFrames * 4 && ring.GetDroppedScopeCount() == recordedFrames, "4 scopes per frame") && passed;
+
+    // 変換 (ティックの差だけを変換するので、大きな値でも溢れない。対応を取った時刻より前も扱える)
+    GpuClockCalibration large;
+    large.gpuTicks = (1ull << 62) + 123;
+    large.cpuNanoseconds = 1000000000000;
+    large.gpuFrequency = 24000000;
+    passed = Check(GpuQueryRing::ToCpuNanoseconds(large.gpuTicks + 24000000 * 3 + 12, large) == large.cpuNanoseconds + 3000000500,
+        "conversion after calibration") && passed;
+    passed = Check(GpuQueryRing::ToCpuNanoseconds(large.gpuTicks - 24, large) == large.cpuNanoseconds - 1000,
+        "conversion before calibration") && passed;
+    passed = Check(GpuQueryRing::ToCpuNanoseconds(1000 + 15, calibration) == 5001500, "conversion at 10MHz") && passed;
+
+    // 壊れたタイムスタンプ (0 や、終わりが始まりより前) は捨てる
+    GpuQueryRing broken;
+    broken.Initialize(1, 2);
+    uint32_t queries[4] = {};
+    broken.BeginFrame();
+    int32_t first = broken.BeginScope("A", &queries[0]);
+    broken.EndScope(first, &queries[1]);
+    int32_t second = broken.BeginScope("B", &queries[2]);
+    broken.EndScope(second, &queries[3]);
+    broken.EndFrame(1, &range);
+    passed = Check(!broken.BeginFrame() && broken.GetSkippedFrameCount() == 1, "the only slot is in flight") && passed;
+    passed = Check(!broken.GetCompletedFrame(0, &range) && broken.GetCompletedFrame(1, &range), "completion follows the fence") && passed;
+    const uint64_t timestamps[4] = { 0, 100, 200, 150 };
+    events.clear();
+    broken.ReleaseFrame(timestamps, calibration, events);
+    passed = Check(events.empty() && broken.GetInvalidScopeCount() == 2, "invalid timestamps are dropped") && passed;
+    passed = Check(broken.BeginFrame(), "the slot is free after release") && passed;
+
+    std::printf("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
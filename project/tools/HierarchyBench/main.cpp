@@ -0,0 +1,322 @@
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include "JobSystem.h"
+#include "MathUtil.h"
+#include "TransformHierarchy.h"
+
+// TransformHierarchy の確認と計測
+// まず親の付け替え・破棄・作成・SetLocal を混ぜて繰り返し、ポインタでつないだ木を再帰で計算した結果と全てのワールド行列が一致することを確かめる
+// 次に広い階層 (1000 の根に 99 の子)・深い階層 (1000 の鎖が 100)・ばらばらな階層のそれぞれで、
+// 全てのノードを変えたときと 1% だけ変えたときの Update (ワーカー1つと全てのワーカー) の時間を測る
+// 比べるために、1つずつ new したノードを子のポインタでたどり、変えたノードの部分木を再帰で計算する書き方も測る
+// 使い方: HierarchyBench.exe [ノードの数] [ワーカーの数] (省略時は 100000 と コア数)
+//
+// Windowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -pthread -Iengine/ECS -Iengine/Job -Iengine/Math -o HierarchyBench tools/HierarchyBench/main.cpp engine/ECS/TransformHierarchy.cpp engine/Job/JobSystem.cpp engine/Math/MathUtil.cpp
+
+namespace {
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 比べる相手 (ノードごとに new し、子をポインタで持つ)
+struct NaiveNode {
+    Transform local;
+    Matrix4x4 world;
+    NaiveNode* parent = nullptr;
+    std::vector<NaiveNode*> children;
+};
+
+void ComputeNaive(NaiveNode* node) {
+    Matrix4x4 local = MakeAffineMatrix(node->local.scale, node->local.rotate, node->local.translate);
+    node->world = node->parent != nullptr ? Multiply(local, node->parent->world) : local;
+    for (NaiveNode* child : node->children) {
+        ComputeNaive(child);
+    }
+}
+
+void DetachNaive(NaiveNode* node) {
+    if (node->parent != nullptr) {
+        std::vector<NaiveNode*>& siblings = node->parent->children;
+        siblings.erase(std::find(siblings.begin(), siblings.end(), node));
+        node->parent = nullptr;
+    }
+}
+
+Transform RandomTransform(std::mt19937& random) {
+    std::uniform_real_distribution<float> distribution(-1.0f, 1.0f);
+    Transform transform;
+    transform.scale = { 1.0f + distribution(random) * 0.1f, 1.0f + distribution(random) * 0.1f, 1.0f + distribution(random) * 0.1f };
+    transform.rotate = { distribution(random), distribution(random), distribution(random) };
+    transform.translate = { distribution(random), distribution(random), distribution(random) };
+    return transform;
+}
+
+bool SameMatrix(const Matrix4x4& a, const Matrix4x4& b) {
+    return std::memcmp(&a, &b, sizeof(Matrix4x4)) == 0;
+}
+
+// 作成・破棄・付け替え・SetLocal を混ぜて、毎回全てのワールド行列を比べる
+bool CheckRandomOperations(uint32_t roundCount) {
+    std::mt19937 random(7);
+    TransformHierarchy hierarchy;
+    std::vector<TransformNode> nodes;
+    std::vector<std::unique_ptr<NaiveNode>> naives;
+    uint32_t mismatches = 0;
+    uint32_t staleAlive = 0;
+    std::vector<TransformNode> destroyed;
+
+    auto indexOf = [&](TransformNode node) {
+        return static_cast<size_t>(std::find(nodes.begin(), nodes.end(), node) - nodes.begin());
+    };
+    auto create = [&](int32_t parent) {
+        Transform local = RandomTransform(random);
+        nodes.push_back(hierarchy.Create(local, parent >= 0 ? nodes[parent] : TransformNode()));
+        auto naive = std::make_unique<NaiveNode>();
+        naive->local = local;
+        if (parent >= 0) {
+            naive->parent = naives[parent].get();
+            naive->parent->children.push_back(naive.get());
+        }
+        naives.push_back(std::move(naive));
+    };
+
+    for (uint32_t round = 0; round < roundCount; ++round) {
+        uint32_t operationCount = 1 + random() % 32;
+        for (uint32_t o = 0; o < operationCount; ++o) {
+            uint32_t operation = random() % 10;
+            uint32_t count = static_cast<uint32_t>(nodes.size());
+            if (count < 8 || operation < 3) {
+                create(count > 0 && random() % 8 != 0 ? int32_t(random() % count) : -1);
+            } else if (operation < 6) {
+                uint32_t i = random() % count;
+                Transform local = RandomTransform(random);
+                hierarchy.SetLocal(nodes[i], local);
+                naives[i]->local = local;
+            } else if (operation < 8) {
+                // 自分の子孫でない親に付け替える (たまに根にする)
+                uint32_t i = random() % count;
+                int32_t parent = random() % 6 != 0 ? int32_t(random() % count) : -1;
+                bool cycle = false;
+                for (NaiveNode* ancestor = parent >= 0 ? naives[parent].get() : nullptr; ancestor != nullptr; ancestor = ancestor->parent) {
+                    cycle = cycle || ancestor == naives[i].get();
+                }
+                if (cycle) {
+                    continue;
+                }
+                hierarchy.SetParent(nodes[i], parent >= 0 ? nodes[parent] : TransformNode());
+                DetachNaive(naives[i].get());
+                if (parent >= 0) {
+                    naives[i]->parent = naives[parent].get();
+                    naives[parent]->children.push_back(naives[i].get());
+                }
+            } else if (operation < 9 && random() % 2 == 0) {
+                // 子孫ごと破棄する
+                uint32_t i = random() % count;
+                std::vector<NaiveNode*> subtree = { naives[i].get() };
+                for (size_t s = 0; s < subtree.size(); ++s) {
+                    subtree.insert(subtree.end(), subtree[s]->children.begin(), subtree[s]->children.end());
+                }
+                hierarchy.Destroy(nodes[i]);
+                DetachNaive(naives[i].get());
+                for (NaiveNode* naive : subtree) {
+                    size_t index = 0;
+                    while (naives[index].get() != naive) {
+                        ++index;
+                    }
+                    destroyed.push_back(nodes[index]);
+                    nodes.erase(nodes.begin() + index);
+                    naives.erase(naives.begin() + index);
+                }
+            } else if (operation == 9) {
+                // 親を確かめる
+                uint32_t i = random() % count;
+                TransformNode parent = hierarchy.GetParent(nodes[i]);
+                size_t expected = naives[i]->parent != nullptr ? static_cast<size_t>(std::find_if(naives.begin(), naives.end(), [&](const auto& n) {
+                    return n.get() == naives[i]->parent;
+                }) - naives.begin()) : nodes.size();
+                mismatches += (parent.IsValid() ? indexOf(parent) : nodes.size()) != expected ? 1 : 0;
+            }
+        }
+        hierarchy.Update();
+        for (const auto& naive : naives) {
+            if (naive->parent == nullptr) {
+                ComputeNaive(naive.get());
+            }
+        }
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            mismatches += SameMatrix(hierarchy.GetWorldMatrix(nodes[i]), naives[i]->world) ? 0 : 1;
+        }
+        for (TransformNode node : destroyed) {
+            staleAlive += hierarchy.IsAlive(node) ? 1 : 0;
+        }
+        destroyed.clear();
+        mismatches += hierarchy.GetNodeCount() != nodes.size() ? 1 : 0;
+    }
+    bool passed = mismatches == 0 && staleAlive == 0;
+    std::printf("check:      %u rounds, %u nodes alive, %u mismatches, %u stale handles alive -> %s\n", roundCount, hierarchy.GetNodeCount(),
+        mismatches, staleAlive, passed ? "ok" : "FAILED");
+    return passed;
+}
+
+// 計測する階層の形 (ノード i の親の番号。-1 なら根)
+std::vector<int32_t> MakeShape(const char* shape, uint32_t nodeCount, std::mt19937& random) {
+    std::vector<int32_t> parents(nodeCount, -1);
+    if (std::strcmp(shape, "wide") == 0) {
+        // 100 ごとに根が1つ、残りはその子
+        for (uint32_t i = 0; i < nodeCount; ++i) {
+            parents[i] = i % 100 == 0 ? -1 : int32_t(i - i % 100);
+        }
+    } else if (std::strcmp(shape, "deep") == 0) {
+        // 長さ 1000 の鎖
+        for (uint32_t i = 0; i < nodeCount; ++i) {
+            parents[i] = i % 1000 == 0 ? -1 : int32_t(i - 1);
+        }
+    } else {
+        // 前のノードのどれかを親にする (根は 0.1%)
+        for (uint32_t i = 1; i < nodeCount; ++i) {
+            parents[i] = random() % 1000 == 0 ? -1 : int32_t(random() % i);
+        }
+    }
+    return parents;
+}
+
+struct Timing {
+    double full = 0.0;   // 全てのノードを変えたとき
+    double sparse = 0.0; // 1% だけ変えたとき
+};
+
+bool Measure(const char* shape, uint32_t nodeCount, uint32_t workers) {
+    std::mt19937 random(11);
+    std::vector<int32_t> parents = MakeShape(shape, nodeCount, random);
+    std::vector<Transform> locals(nodeCount);
+    for (Transform& local : locals) {
+        local = RandomTransform(random);
+    }
+    // 1% のノード (毎回同じものを変える)
+    std::vector<uint32_t> sparse(nodeCount / 100);
+    for (uint32_t& index : sparse) {
+        index = random() % nodeCount;
+    }
+
+    // 階層 (一部を付け替えて戻し、最初の Update で並べ直させる)
+    TransformHierarchy hierarchy;
+    std::vector<TransformNode> nodes(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        nodes[i] = hierarchy.Create(locals[i], parents[i] >= 0 ? nodes[parents[i]] : TransformNode());
+    }
+    for (uint32_t i = 0; i < nodeCount; i += 97) {
+        if (parents[i] >= 0) {
+            hierarchy.SetParent(nodes[i], TransformNode());
+            hierarchy.SetParent(nodes[i], nodes[parents[i]]);
+        }
+    }
+    hierarchy.Update();
+
+    // 比べる相手 (確保の順はばらばら)
+    std::vector<uint32_t> allocationOrder(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        allocationOrder[i] = i;
+    }
+    std::shuffle(allocationOrder.begin(), allocationOrder.end(), random);
+    std::vector<std::unique_ptr<NaiveNode>> naives(nodeCount);
+    for (uint32_t i : allocationOrder) {
+        naives[i] = std::make_unique<NaiveNode>();
+        naives[i]->local = locals[i];
+    }
+    std::vector<NaiveNode*> naiveRoots;
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        if (parents[i] >= 0) {
+            naives[i]->parent = naives[parents[i]].get();
+            naives[parents[i]]->children.push_back(naives[i].get());
+        } else {
+            naiveRoots.push_back(naives[i].get());
+        }
+    }
+
+    JobSystem* jobSystem = JobSystem::GetInstance();
+    Timing hierarchyTimes[2];
+    const uint32_t repeat = 10;
+    // 1% だけ変えたときは短いので、回数を増やして揺れを抑える
+    const uint32_t sparseRepeat = 100;
+    for (uint32_t pass = 0; pass < 2; ++pass) {
+        jobSystem->Initialize(pass == 0 ? 0 : workers - 1);
+        auto start = std::chrono::steady_clock::now();
+        for (uint32_t r = 0; r < repeat; ++r) {
+            for (uint32_t i = 0; i < nodeCount; ++i) {
+                locals[i].rotate.y += 0.01f;
+                hierarchy.SetLocal(nodes[i], locals[i]);
+            }
+            hierarchy.Update();
+        }
+        hierarchyTimes[pass].full = Seconds(start) / repeat;
+        start = std::chrono::steady_clock::now();
+        for (uint32_t r = 0; r < sparseRepeat; ++r) {
+            for (uint32_t i : sparse) {
+                locals[i].rotate.y += 0.01f;
+                hierarchy.SetLocal(nodes[i], locals[i]);
+            }
+            hierarchy.Update();
+        }
+        hierarchyTimes[pass].sparse = Seconds(start) / sparseRepeat;
+        jobSystem->Finalize();
+    }
+    TransformHierarchy::Stats stats = hierarchy.GetStats();
+
+    Timing naiveTime;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < repeat * 2; ++r) {
+        for (uint32_t i = 0; i < nodeCount; ++i) {
+            naives[i]->local = locals[i];
+        }
+        for (NaiveNode* root : naiveRoots) {
+            ComputeNaive(root);
+        }
+    }
+    naiveTime.full = Seconds(start) / (repeat * 2);
+    start = std::chrono::steady_clock::now();
+    for (uint32_t r = 0; r < repeat * 2; ++r) {
+        for (uint32_t i : sparse) {
+            naives[i]->local = locals[i];
+            ComputeNaive(naives[i].get());
+        }
+    }
+    naiveTime.sparse = Seconds(start) / (repeat * 2);
+
+    uint32_t mismatches = 0;
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        mismatches += SameMatrix(hierarchy.GetWorldMatrix(nodes[i]), naives[i]->world) ? 0 : 1;
+    }
+    std::printf("%-6s full:   hierarchy %.2fms (%u workers %.2fms), pointers %.2fms\n", shape, hierarchyTimes[0].full * 1000.0, workers,
+        hierarchyTimes[1].full * 1000.0, naiveTime.full * 1000.0);
+    std::printf("%-6s sparse: hierarchy %.3fms (%u workers %.3fms), pointers %.3fms, %u subtrees %u nodes recomputed\n", shape,
+        hierarchyTimes[0].sparse * 1000.0, workers, hierarchyTimes[1].sparse * 1000.0, naiveTime.sparse * 1000.0, stats.dirtyRootCount,
+        stats.recomputedCount);
+    if (mismatches != 0) {
+        std::printf("%-6s %u world matrices differ\n", shape, mismatches);
+    }
+    return mismatches == 0;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t nodeCount = argc > 1 ? uint32_t(std::atoi(argv[1])) : 100000;
+    uint32_t workers = argc > 2 ? uint32_t(std::atoi(argv[2])) : std::max(1u, std::thread::hardware_concurrency());
+
+    bool passed = CheckRandomOperations(2000);
+    for (const char* shape : { "wide", "deep", "random" }) {
+        passed = Measure(shape, nodeCount, workers) && passed;
+    }
+    std::printf("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
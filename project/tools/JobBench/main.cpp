@@ -0,0 +1,137 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <thread>
+#include <vector>
+#include "JobSystem.h"
+
+// JobSystem の計測
+//   spawn:    メインスレッドが空のジョブを入れて Wait するまでの1ジョブあたりの時間 (プールからの確保・キュー・数え上げの分)
+//   steal:    メインスレッドが入れたジョブを他のワーカーが盗んで処理するときの1ジョブあたりの時間
+//   fib:      ジョブの中で子を入れて Wait する再帰 (細かいジョブを大量に入れたときの分割と待ちの分)
+//   parallel: 計算だけの ParallelFor の時間と、ワーカー1つのときに比べた速さ
+// ワーカーの数は 1, 2, 4, ... と最大の数で測る (最大の数は省略時はハードウェアのスレッド数)
+// ハードウェアのスレッド数より多いワーカーは時間を分け合うだけで速くならないので、oversubscribed と出して速さの比は出さない
+// 使い方: JobBench.exe [最大のワーカー数] [ParallelFor の要素数] (省略時は ハードウェアのスレッド数 4000000)
+//
+// Windowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -pthread -Iengine/Job -o JobBench tools/JobBench/main.cpp engine/Job/JobSystem.cpp
+
+namespace {
+
+double Seconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// 空のジョブを count 個入れて待つ (1ジョブあたりのナノ秒)
+double MeasureSpawn(JobSystem* jobSystem, uint32_t count) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < 16; ++round) {
+        JobCounter counter;
+        for (uint32_t i = 0; i < count / 16; ++i) {
+            jobSystem->Run([] {}, &counter);
+        }
+        jobSystem->Wait(&counter);
+    }
+    return Seconds(start) * 1.0e9 / count;
+}
+
+// 少し仕事のあるジョブを入れ、メインスレッドは入れるだけにして他のワーカーに盗ませる
+double MeasureSteal(JobSystem* jobSystem, uint32_t count, uint64_t* stolen) {
+    jobSystem->ResetStats();
+    std::atomic<uint32_t> sink = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < 16; ++round) {
+        JobCounter counter;
+        for (uint32_t i = 0; i < count / 16; ++i) {
+            jobSystem->Run([&sink, i] {
+                uint32_t value = i;
+                for (uint32_t k = 0; k < 64; ++k) {
+                    value = value * 1664525u + 1013904223u;
+                }
+                sink.fetch_add(value & 1, std::memory_order_relaxed);
+            }, &counter);
+        }
+        jobSystem->Wait(&counter);
+    }
+    double seconds = Seconds(start);
+    *stolen = jobSystem->GetStats().stolenCount;
+    return seconds * 1.0e9 / count;
+}
+
+uint64_t Fibonacci(JobSystem* jobSystem, uint32_t n) {
+    if (n < 2) {
+        return n;
+    }
+    uint64_t left = 0;
+    JobCounter counter;
+    jobSystem->Run([jobSystem, &left, n] { left = Fibonacci(jobSystem, n - 1); }, &counter);
+    uint64_t right = Fibonacci(jobSystem, n - 2);
+    jobSystem->Wait(&counter);
+    return left + right;
+}
+
+// 要素ごとに少し計算する ParallelFor (秒)
+double MeasureParallelFor(JobSystem* jobSystem, std::vector<float>& values) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t round = 0; round < 4; ++round) {
+        jobSystem->ParallelFor(0, static_cast<uint32_t>(values.size()), [&values, round](uint32_t begin, uint32_t end) {
+            for (uint32_t i = begin; i < end; ++i) {
+                float x = float(i) * 0.001f + float(round);
+                values[i] = std::sin(x) * std::cos(x * 0.5f) + std::sqrt(x + 1.0f);
+            }
+        });
+    }
+    return Seconds(start);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    // hardware_concurrency は分からないと 0 を返す
+    uint32_t hardwareThreads = std::max(std::thread::hardware_concurrency(), 1u);
+    uint32_t maxWorkers = argc > 1 ? uint32_t(std::atoi(argv[1])) : hardwareThreads;
+    uint32_t elementCount = argc > 2 ? uint32_t(std::atoi(argv[2])) : 4000000;
+
+    std::printf("hardware threads: %u\n", hardwareThreads);
+    JobSystem* jobSystem = JobSystem::GetInstance();
+    std::vector<float> values(elementCount);
+    double baseline = 0.0;
+    // 1, 2, 4, ... と、2のべきでなければ最大の数
+    std::vector<uint32_t> workerCounts;
+    for (uint32_t workers = 1; workers <= maxWorkers; workers *= 2) {
+        workerCounts.push_back(workers);
+    }
+    if (workerCounts.empty() || workerCounts.back() != maxWorkers) {
+        workerCounts.push_back(std::max(maxWorkers, 1u));
+    }
+    for (uint32_t workers : workerCounts) {
+        jobSystem->Initialize(workers - 1);
+        // ワーカーが動き出して眠るまで待ってから測る
+        MeasureSpawn(jobSystem, 4096);
+
+        double spawn = MeasureSpawn(jobSystem, 1 << 18);
+        uint64_t stolen = 0;
+        double steal = MeasureSteal(jobSystem, 1 << 16, &stolen);
+        auto start = std::chrono::steady_clock::now();
+        uint64_t fib = Fibonacci(jobSystem, 25);
+        double fibSeconds = Seconds(start);
+        double parallel = MeasureParallelFor(jobSystem, values);
+        if (workers == 1) {
+            baseline = parallel;
+        }
+        std::printf("%2u workers: spawn %.1fns/job, steal %.1fns/job (%llu stolen), fib(25)=%llu %.1fms, parallel %.1fms",
+            workers, spawn, steal, static_cast<unsigned long long>(stolen), static_cast<unsigned long long>(fib), fibSeconds * 1000.0,
+            parallel * 1000.0);
+        if (workers > hardwareThreads) {
+            std::printf(" (oversubscribed: %u threads)\n", hardwareThreads);
+        } else {
+            std::printf(" (x%.2f)\n", baseline / parallel);
+        }
+        jobSystem->Finalize();
+    }
+    return 0;
+}
@@ -0,0 +1,265 @@
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+#include <random>
+#include <thread>
+#include <vector>
+#include "JobSystem.h"
+
+// JobSystem の負荷試験 (ThreadSanitizer / AddressSanitizer を付けて回す)
+// ワーカーの数を変えながら、次のことを繰り返し確かめる
+//   ・入れたジョブがちょうど1回ずつ動くこと (キューが溢れてその場で処理する場合とプールが尽きて new する場合を含む)
+//   ・ランダムな DAG を RunAfter (継続) で組み、依存先が全て終わってから動くこと (節点の一部はジョブの中で子を Wait する)
+//   ・入れ子の ParallelFor が全ての要素をちょうど1回ずつ処理すること
+//   ・ワーカー以外のスレッドから Run と Wait をしても (ParallelFor と同時に) 取りこぼさないこと
+//   ・Wait から戻った直後に数え上げを破棄しても、終わったジョブが触れないこと
+// 使い方: JobStress.exe [繰り返す回数] [最大のワーカー数] (省略時は 20 8)
+//
+// Windowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O1 -g -pthread -fsanitize=thread -Iengine/Job -o JobStress tools/JobStress/main.cpp engine/Job/JobSystem.cpp
+
+namespace {
+
+bool Report(const char* name, bool passed) {
+    if (!passed) {
+        std::printf("  %s FAILED\n", name);
+    }
+    return passed;
+}
+
+// たくさんのジョブ (再帰的に増えるものを含む) がちょうど1回ずつ動く
+bool CheckExactlyOnce(JobSystem* jobSystem, uint32_t count) {
+    std::unique_ptr<std::atomic<uint32_t>[]> hits = std::make_unique<std::atomic<uint32_t>[]>(count);
+    JobCounter counter;
+    for (uint32_t i = 0; i < count; ++i) {
+        jobSystem->Run([&hits, i] { hits[i].fetch_add(1, std::memory_order_relaxed); }, &counter);
+    }
+    // ジョブの中から入れたジョブ
+    std::unique_ptr<std::atomic<uint32_t>[]> nestedHits = std::make_unique<std::atomic<uint32_t>[]>(count);
+    JobCounter nested;
+    for (uint32_t i = 0; i < count; i += 64) {
+        jobSystem->Run([jobSystem, &nestedHits, &nested, i, count] {
+            for (uint32_t j = i; j < i + 64 && j < count; ++j) {
+                jobSystem->Run([&nestedHits, j] { nestedHits[j].fetch_add(1, std::memory_order_relaxed); }, &nested);
+            }
+        }, &nested);
+    }
+    jobSystem->Wait(&counter);
+    jobSystem->Wait(&nested);
+    bool passed = true;
+    for (uint32_t i = 0; i < count; ++i) {
+        passed = passed && hits[i].load() == 1 && nestedHits[i].load() == 1;
+    }
+    return passed;
+}
+
+// ランダムな DAG (依存先は自分より前の節点)
+bool CheckGraph(JobSystem* jobSystem, uint32_t nodeCount, uint32_t seed) {
+    struct Node {
+        std::vector<uint32_t> dependencies;
+        JobCounter done;
+        JobCounter ready; // 依存先が全て終わったら 0
+        std::atomic<bool> finished = false;
+        uint32_t value = 0; // 依存先の value の合計 + 1 (ジョブの外からは終わった後にしか読まない)
+    };
+    std::mt19937 random(seed);
+    std::vector<std::unique_ptr<Node>> nodes;
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        nodes.push_back(std::make_unique<Node>());
+        uint32_t dependencyCount = i == 0 ? 0 : random() % 4;
+        for (uint32_t d = 0; d < dependencyCount; ++d) {
+            nodes[i]->dependencies.push_back(random() % i);
+        }
+    }
+    std::atomic<uint32_t> violations = 0;
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        Node* node = nodes[i].get();
+        auto body = [jobSystem, node, &nodes, &violations, i] {
+            uint32_t value = 1;
+            for (uint32_t dependency : node->dependencies) {
+                Node* other = nodes[dependency].get();
+                if (!other->finished.load(std::memory_order_acquire)) {
+                    violations.fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                value += other->value;
+            }
+            if (i % 3 == 0) {
+                // ジョブの中で子のジョブを入れて Wait する (待つ間は他のジョブを処理する)
+                std::atomic<uint32_t> children = 0;
+                JobCounter counter;
+                for (uint32_t c = 0; c < 4; ++c) {
+                    jobSystem->Run([&children] { children.fetch_add(1, std::memory_order_relaxed); }, &counter);
+                }
+                jobSystem->Wait(&counter);
+                value += children.load(std::memory_order_relaxed) - 4;
+            }
+            node->value = value;
+            node->finished.store(true, std::memory_order_release);
+        };
+        // 依存先ごとに空の継続で ready を数え、ready が 0 になったら本体を動かす
+        for (uint32_t dependency : node->dependencies) {
+            jobSystem->RunAfter(&nodes[dependency]->done, [] {}, &node->ready);
+        }
+        jobSystem->RunAfter(&node->ready, body, &node->done);
+    }
+    bool passed = true;
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        jobSystem->Wait(&nodes[i]->done);
+        jobSystem->Wait(&nodes[i]->ready);
+    }
+    // 値を一から計算して比べる
+    std::vector<uint32_t> expected(nodeCount);
+    for (uint32_t i = 0; i < nodeCount; ++i) {
+        expected[i] = 1;
+        for (uint32_t dependency : nodes[i]->dependencies) {
+            expected[i] += expected[dependency];
+        }
+        passed = passed && nodes[i]->finished.load() && nodes[i]->value == expected[i];
+    }
+    return passed && violations.load() == 0;
+}
+
+// 入れ子の ParallelFor
+bool CheckParallelFor(JobSystem* jobSystem, uint32_t outer, uint32_t inner) {
+    std::vector<std::atomic<uint32_t>> hits(size_t(outer) * inner);
+    std::atomic<uint64_t> calls = 0;
+    jobSystem->ParallelFor(0, outer, 1, [&](uint32_t begin, uint32_t end) {
+        for (uint32_t i = begin; i < end; ++i) {
+            jobSystem->ParallelFor(0, inner, [&, i](uint32_t innerBegin, uint32_t innerEnd) {
+                calls.fetch_add(1, std::memory_order_relaxed);
+                for (uint32_t j = innerBegin; j < innerEnd; ++j) {
+                    hits[size_t(i) * inner + j].fetch_add(1, std::memory_order_relaxed);
+                }
+            });
+        }
+    });
+    bool passed = true;
+    for (std::atomic<uint32_t>& hit : hits) {
+        passed = passed && hit.load() == 1;
+    }
+    // 粒度の下限を守る (最後の1つ以外は minGrain 以上)
+    std::atomic<uint32_t> small = 0;
+    jobSystem->ParallelFor(0, 10000, 100, [&](uint32_t begin, uint32_t end) {
+        if (end - begin < 100 && end != 10000) {
+            small.fetch_add(1, std::memory_order_relaxed);
+        }
+    });
+    return passed && calls.load() > 0 && small.load() == 0;
+}
+
+// ワーカー以外のスレッドから Run と Wait をする (メインスレッドの ParallelFor と同時に)
+bool CheckExternalThreads(JobSystem* jobSystem, uint32_t threadCount, uint32_t jobsPerThread) {
+    std::atomic<uint64_t> sum = 0;
+    std::atomic<uint32_t> externalIndexErrors = 0;
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            if (JobSystem::GetWorkerIndex() != -1) {
+                externalIndexErrors.fetch_add(1);
+            }
+            for (uint32_t round = 0; round < 4; ++round) {
+                JobCounter counter;
+                for (uint32_t i = 0; i < jobsPerThread; ++i) {
+                    jobSystem->Run([&sum, t] { sum.fetch_add(t + 1, std::memory_order_relaxed); }, &counter);
+                }
+                jobSystem->Wait(&counter);
+            }
+            // ワーカー以外からの ParallelFor
+            jobSystem->ParallelFor(0, jobsPerThread, [&sum](uint32_t begin, uint32_t end) {
+                sum.fetch_add(end - begin, std::memory_order_relaxed);
+            });
+        });
+    }
+    std::atomic<uint64_t> mainSum = 0;
+    for (uint32_t round = 0; round < 8; ++round) {
+        jobSystem->ParallelFor(0, 4096, [&mainSum](uint32_t begin, uint32_t end) {
+            mainSum.fetch_add(end - begin, std::memory_order_relaxed);
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    uint64_t expected = 0;
+    for (uint32_t t = 0; t < threadCount; ++t) {
+        expected += uint64_t(t + 1) * jobsPerThread * 4 + jobsPerThread;
+    }
+    return sum.load() == expected && mainSum.load() == 8 * 4096 && externalIndexErrors.load() == 0;
+}
+
+// Wait から戻ったらすぐ数え上げを破棄する (終わったジョブが後から触れると AddressSanitizer で分かる)
+bool CheckCounterLifetime(JobSystem* jobSystem, uint32_t rounds) {
+    std::atomic<uint32_t> sum = 0;
+    for (uint32_t round = 0; round < rounds; ++round) {
+        std::unique_ptr<JobCounter> counter = std::make_unique<JobCounter>();
+        uint32_t count = 1 + round % 7;
+        for (uint32_t i = 0; i < count; ++i) {
+            jobSystem->Run([&sum] { sum.fetch_add(1, std::memory_order_relaxed); }, counter.get());
+        }
+        jobSystem->Wait(counter.get());
+        counter.reset();
+    }
+    uint32_t expected = 0;
+    for (uint32_t round = 0; round < rounds; ++round) {
+        expected += 1 + round % 7;
+    }
+    return sum.load() == expected;
+}
+
+// 再帰 (ジョブの中で子を入れて Wait する)
+uint64_t Fibonacci(JobSystem* jobSystem, uint32_t n) {
+    if (n < 12) {
+        uint64_t a = 0;
+        uint64_t b = 1;
+        for (uint32_t i = 0; i < n; ++i) {
+            uint64_t next = a + b;
+            a = b;
+            b = next;
+        }
+        return a;
+    }
+    uint64_t left = 0;
+    JobCounter counter;
+    jobSystem->Run([jobSystem, &left, n] { left = Fibonacci(jobSystem, n - 1); }, &counter);
+    uint64_t right = Fibonacci(jobSystem, n - 2);
+    jobSystem->Wait(&counter);
+    return left + right;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t iterations = argc > 1 ? uint32_t(std::atoi(argv[1])) : 20;
+    uint32_t maxWorkers = argc > 2 ? uint32_t(std::atoi(argv[2])) : 8;
+
+    JobSystem* jobSystem = JobSystem::GetInstance();
+    bool passed = true;
+    for (uint32_t workers = 1; workers <= maxWorkers; workers *= 2) {
+        jobSystem->Initialize(workers - 1);
+        jobSystem->ResetStats();
+        bool workerPassed = true;
+        for (uint32_t iteration = 0; iteration < iterations; ++iteration) {
+            // プール (4096) とキュー (4096) を超える数を入れる
+            workerPassed = Report("exactly once", CheckExactlyOnce(jobSystem, 10000)) && workerPassed;
+            workerPassed = Report("graph", CheckGraph(jobSystem, 2000, 1000 * workers + iteration)) && workerPassed;
+            workerPassed = Report("parallel for", CheckParallelFor(jobSystem, 64, 500)) && workerPassed;
+            // ワーカースレッドが無いと、メインスレッドが join で止まっている間に誰も処理しない
+            if (workers > 1) {
+                workerPassed = Report("external threads", CheckExternalThreads(jobSystem, 3, 500)) && workerPassed;
+            }
+            workerPassed = Report("counter lifetime", CheckCounterLifetime(jobSystem, 200)) && workerPassed;
+            workerPassed = Report("fibonacci", Fibonacci(jobSystem, 24) == 46368) && workerPassed;
+        }
+        JobSystem::Stats stats = jobSystem->GetStats();
+        std::printf("%2u workers: %s (executed %llu, stolen %llu, heap %llu, inline %llu, sleep %llu)\n", workers,
+            workerPassed ? "ok" : "FAILED", static_cast<unsigned long long>(stats.executedCount),
+            static_cast<unsigned long long>(stats.stolenCount), static_cast<unsigned long long>(stats.heapJobCount),
+            static_cast<unsigned long long>(stats.inlineCount), static_cast<unsigned long long>(stats.sleepCount));
+        jobSystem->Finalize();
+        passed = passed && workerPassed;
+    }
+    std::printf("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
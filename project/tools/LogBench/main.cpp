@@ -0,0 +1,218 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Logger.h"
+
+// ロガーの計測と確認
+// まず書式 ("{}" "{:08x}" "{:.2f}" など) が期待どおりの文字列になることを確かめる
+// 次に 1, 2, 4, ... 最大のスレッド数で同時にログを書き、1回の呼び出しにかかる時間 (中央値・99%・平均) を出す
+// 比べるために、前の Log() と同じく呼んだスレッドで整形してロックを取り、1行ごとにフラッシュする書き方も測る
+// 最後にファイルを読み、書き出した行と捨てた数の合計が書いた数になり、スレッドごとの順番が崩れていないことを確かめる
+// 使い方: LogBench.exe [スレッドあたりの数] [最大のスレッド数] [ログのディレクトリ] (省略時は 200000 8 logs)
+//
+// Windowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -pthread -Iengine/Log -o LogBench tools/LogBench/main.cpp engine/Log/Logger.cpp engine/Log/LogFormat.cpp
+
+namespace {
+
+enum class Sample : uint8_t {
+    kFirst,
+    kSecond,
+};
+
+bool CheckFormat(const std::string& expected, const char* format, const std::vector<LogValue>& values) {
+    std::string text;
+    FormatLog(text, format, values.data(), values.size());
+    if (text != expected) {
+        std::printf("format:     \"%s\" -> \"%s\" (expected \"%s\")\n", format, text.c_str(), expected.c_str());
+        return false;
+    }
+    return true;
+}
+
+template <typename... Args>
+std::string Format(const char* format, const Args&... args) {
+    // 保存して読み直すところまで通す
+    std::vector<std::byte> bytes((size_t(0) + ... + LogDetail::ArgCodec<LogDetail::ArgType<Args>>::Size(args)) + 1);
+    std::byte* cursor = bytes.data();
+    ((cursor = LogDetail::ArgCodec<LogDetail::ArgType<Args>>::Write(cursor, args)), ...);
+    (void)cursor;
+    std::string text;
+    LogDetail::Decode<LogDetail::ArgType<Args>...>(text, format, bytes.data());
+    return text;
+}
+
+bool CheckFormats() {
+    struct Case {
+        std::string expected;
+        std::string actual;
+    };
+    std::string name = "pipeline";
+    const wchar_t* wide = L"Shader/あ\U0001F600.hlsl";
+    const Case cases[] = {
+        { "plain", Format("plain") },
+        { "1 -2 3", Format("{} {} {}", 1, -2, 3u) },
+        { "x=0x0000002a", Format("x=0x{:08x}", 42u) },
+        { "1.50ms", Format("{:.2f}ms", 1.5) },
+        { "[  7] [7  ]", Format("[{:3}] [{:<3}]", 7, 7) },
+        { "true c pipeline!", Format("{} {} {}!", true, 'c', name) },
+        { "Shader/\xE3\x81\x82\xF0\x9F\x98\x80.hlsl", Format("{}", wide) },
+        { "{} 1 {", Format("{{}} {} {", 1) },
+        { "enum 1", Format("enum {}", Sample::kSecond) },
+        { "missing {}", Format("missing {}") },
+    };
+    bool passed = true;
+    for (const Case& test : cases) {
+        if (test.actual != test.expected) {
+            std::printf("format:     \"%s\" (expected \"%s\")\n", test.actual.c_str(), test.expected.c_str());
+            passed = false;
+        }
+    }
+    LogValue value;
+    value.type = LogValue::Type::kFloat;
+    value.floatingPoint = 0.25;
+    passed = CheckFormat("0.25", "{}", { value }) && passed;
+    std::printf("format:     %zu cases %s\n", sizeof(cases) / sizeof(cases[0]) + 1, passed ? "ok" : "FAILED");
+    return passed;
+}
+
+// 1回の呼び出しの時間 (時刻を読む時間を含む。スレッドがコアより多いと待たされた分も入る)
+struct Latency {
+    double median = 0.0;
+    double p99 = 0.0;
+    double mean = 0.0;
+};
+
+// threadCount のスレッドで countPerThread 回ずつ log を呼び、1回の時間を測る
+template <typename LogFunction>
+Latency Measure(uint32_t threadCount, uint32_t countPerThread, LogFunction log) {
+    std::vector<std::vector<uint32_t>> samples(threadCount);
+    std::atomic<uint32_t> ready = 0;
+    std::vector<std::thread> threads;
+    for (uint32_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&, t] {
+            std::vector<uint32_t>& times = samples[t];
+            times.reserve(countPerThread);
+            // 全てのスレッドが揃ってから始める
+            ready.fetch_add(1);
+            while (ready.load() < threadCount) {
+                std::this_thread::yield();
+            }
+            for (uint32_t i = 0; i < countPerThread; ++i) {
+                auto start = std::chrono::steady_clock::now();
+                log(t, i);
+                auto end = std::chrono::steady_clock::now();
+                times.push_back(uint32_t(std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count()));
+            }
+        });
+    }
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    std::vector<uint32_t> all;
+    double total = 0.0;
+    for (uint32_t t = 0; t < threadCount; ++t) {
+        all.insert(all.end(), samples[t].begin(), samples[t].end());
+    }
+    for (uint32_t time : all) {
+        total += time;
+    }
+    std::sort(all.begin(), all.end());
+    Latency latency;
+    latency.median = all[all.size() / 2];
+    latency.p99 = all[std::min(all.size() - 1, all.size() * 99 / 100)];
+    latency.mean = total / double(all.size());
+    return latency;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t countPerThread = argc > 1 ? uint32_t(std::atoi(argv[1])) : 200000;
+    uint32_t maxThreads = argc > 2 ? uint32_t(std::atoi(argv[2])) : 8;
+    std::string directory = argc > 3 ? argv[3] : "logs";
+
+    bool passed = CheckFormats();
+
+    // 非同期のロガー
+    Logger* logger = Logger::GetInstance();
+    LogSettings settings;
+    settings.directory = directory;
+    settings.threadBufferSize = 4 * 1024 * 1024;
+    settings.flushIntervalMilliseconds = 1;
+    logger->Initialize(settings);
+    Latency empty = Measure(1, countPerThread, [](uint32_t, uint32_t) {});
+    std::printf("clock:      median %.0fns, mean %.1fns per call (time to read the clock twice)\n", empty.median, empty.mean);
+    uint64_t logged = 0;
+    for (uint32_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        Latency latency = Measure(threadCount, countPerThread, [threadCount](uint32_t thread, uint32_t index) {
+            LogInfo(LogCategory::kGeneral, "run {} thread {} message {} value {:.3f} {}", threadCount, thread, index, index * 0.5, "text");
+        });
+        logged += uint64_t(threadCount) * countPerThread;
+        std::printf("async:      %u threads, median %.0fns, p99 %.0fns, mean %.1fns per call\n", threadCount, latency.median,
+            latency.p99, latency.mean);
+    }
+    // 無効にした重要度は引数も見ずに戻る
+    logger->SetLevel(LogCategory::kGeneral, LogLevel::kWarning);
+    Latency filtered = Measure(1, countPerThread, [](uint32_t thread, uint32_t index) {
+        LogDebug(LogCategory::kGeneral, "filtered {} {}", thread, index);
+    });
+    std::printf("filtered:   median %.0fns, mean %.1fns per call\n", filtered.median, filtered.mean);
+    std::string filePath = logger->GetFilePath();
+    logger->Finalize();
+    Logger::Stats stats = logger->GetStats();
+    std::printf("written:    %llu lines, %llu dropped, %.1f MB -> %s\n", static_cast<unsigned long long>(stats.writtenCount),
+        static_cast<unsigned long long>(stats.droppedCount), double(stats.writtenBytes) / (1024.0 * 1024.0), filePath.c_str());
+    passed = passed && stats.writtenCount + stats.droppedCount == logged;
+
+    // 前の書き方 (呼んだスレッドで整形し、ロックを取ってフラッシュする)
+    {
+        std::ofstream stream(directory + "/LogBench_sync.log");
+        std::mutex mutex;
+        for (uint32_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+            Latency latency = Measure(threadCount, countPerThread / 10, [&](uint32_t thread, uint32_t index) {
+                char text[128];
+                std::snprintf(text, sizeof(text), "run %u thread %u message %u value %.3f %s", threadCount, thread, index, index * 0.5, "text");
+                std::lock_guard<std::mutex> lock(mutex);
+                stream << text << std::endl;
+            });
+            std::printf("sync:       %u threads, median %.0fns, p99 %.0fns, mean %.1fns per call\n", threadCount, latency.median,
+                latency.p99, latency.mean);
+        }
+    }
+
+    // 書き出した行を確かめる (スレッドごとの番号が増える順に並び、途中で捨てた分だけ飛ぶ)
+    std::ifstream file(filePath);
+    std::string line;
+    uint64_t lineCount = 0;
+    uint64_t outOfOrder = 0;
+    std::vector<std::vector<int64_t>> lastIndex(64, std::vector<int64_t>(maxThreads, -1));
+    while (std::getline(file, line)) {
+        size_t runPosition = line.find("run ");
+        size_t threadPosition = line.find(" thread ");
+        size_t indexPosition = line.find(" message ");
+        if (runPosition == std::string::npos || threadPosition == std::string::npos || indexPosition == std::string::npos) {
+            continue;
+        }
+        unsigned long run = std::strtoul(line.c_str() + runPosition + 4, nullptr, 10);
+        unsigned long thread = std::strtoul(line.c_str() + threadPosition + 8, nullptr, 10);
+        unsigned long index = std::strtoul(line.c_str() + indexPosition + 9, nullptr, 10);
+        ++lineCount;
+        int64_t& last = lastIndex[run % 64][thread % maxThreads];
+        outOfOrder += int64_t(index) <= last ? 1 : 0;
+        last = index;
+    }
+    std::printf("check:      %llu lines read, %llu out of order\n", static_cast<unsigned long long>(lineCount),
+        static_cast<unsigned long long>(outOfOrder));
+    passed = passed && lineCount == stats.writtenCount && outOfOrder == 0;
+    std::printf("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
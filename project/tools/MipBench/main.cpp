@@ -0,0 +1,238 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+#include "JobSystem.h"
+#include "MipGenerator.h"
+#if defined(_WIN32)
+#include "externals/DirectXTex/DirectXTex.h"
+#endif
+
+// MipGenerator の計測
+//   reference: DirectXTex の GenerateMipMaps (TEX_FILTER_BOX | TEX_FILTER_SRGB) と同じ計算 (画素ごとに sRGB を変換して2x2平均) を素直に書いたもの
+//   serial:    MipGenerator を1スレッドで
+//   jobs:      MipGenerator を JobSystem で (ワーカーの数は省略時はコア数。コア数より多くしても速くはならない)
+// 2x2平均の結果が reference と1段階以内で一致すること、JobSystem で分けても1スレッドと同じ結果になることを確かめる
+// Windows では DirectXTex の GenerateMipMaps そのものも測り、結果を比べる
+// 使い方: MipBench.exe [幅] [繰り返し] [ワーカーの数] (省略時は 2048 8 コア数)
+//
+// Windows以外では DirectXTex を使わない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -pthread -Iengine/Texture -Iengine/Job -o MipBench tools/MipBench/main.cpp engine/Texture/MipGenerator.cpp engine/Job/JobSystem.cpp
+
+namespace {
+
+double Milliseconds(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// なめらかな模様に雑音を足した RGBA8 の画像 (cutout なら円の外のアルファを 0 にする)
+std::vector<uint8_t> MakeImage(uint32_t size, bool cutout) {
+    std::vector<uint8_t> pixels(size_t(size) * size * 4);
+    uint32_t random = 12345;
+    for (uint32_t y = 0; y < size; ++y) {
+        for (uint32_t x = 0; x < size; ++x) {
+            random = random * 1664525u + 1013904223u;
+            uint8_t* p = &pixels[(size_t(y) * size + x) * 4];
+            float u = float(x) / size;
+            float v = float(y) / size;
+            p[0] = uint8_t(std::clamp(127.5f + 120.0f * std::sin(u * 40.0f) + float(random >> 29), 0.0f, 255.0f));
+            p[1] = uint8_t(std::clamp(255.0f * v, 0.0f, 255.0f));
+            p[2] = uint8_t((random >> 24) & 0xFF);
+            float dx = u - 0.5f;
+            float dy = v - 0.5f;
+            p[3] = cutout ? (dx * dx + dy * dy < 0.16f ? 255 : 0) : uint8_t(255 - (x + y) % 64);
+        }
+    }
+    return pixels;
+}
+
+float SrgbToLinear(uint8_t value) {
+    float c = value / 255.0f;
+    return c <= 0.04045f ? c / 12.92f : std::pow((c + 0.055f) / 1.055f, 2.4f);
+}
+
+uint8_t LinearToSrgb(float value) {
+    float l = std::clamp(value, 0.0f, 1.0f);
+    float c = l <= 0.0031308f ? l * 12.92f : 1.055f * std::pow(l, 1.0f / 2.4f) - 0.055f;
+    return uint8_t(std::clamp(c * 255.0f + 0.5f, 0.0f, 255.0f));
+}
+
+// 比べる相手: 段ごとに前の段を線形に戻して2x2平均 (1スレッド)
+std::vector<MipLevel> GenerateReference(const std::vector<uint8_t>& pixels, uint32_t size) {
+    std::vector<MipLevel> levels(CalcMipLevelCount(size, size));
+    levels[0].width = size;
+    levels[0].height = size;
+    levels[0].pixels = pixels;
+    for (size_t mip = 1; mip < levels.size(); ++mip) {
+        const MipLevel& src = levels[mip - 1];
+        MipLevel& dst = levels[mip];
+        dst.width = std::max(1u, src.width / 2);
+        dst.height = std::max(1u, src.height / 2);
+        dst.pixels.resize(size_t(dst.width) * dst.height * 4);
+        for (uint32_t y = 0; y < dst.height; ++y) {
+            for (uint32_t x = 0; x < dst.width; ++x) {
+                const uint8_t* texels[4] = {
+                    &src.pixels[(size_t(y * 2) * src.width + x * 2) * 4],
+                    &src.pixels[(size_t(y * 2) * src.width + x * 2 + 1) * 4],
+                    &src.pixels[(size_t(y * 2 + 1) * src.width + x * 2) * 4],
+                    &src.pixels[(size_t(y * 2 + 1) * src.width + x * 2 + 1) * 4],
+                };
+                uint8_t* out = &dst.pixels[(size_t(y) * dst.width + x) * 4];
+                for (int c = 0; c < 3; ++c) {
+                    float sum = 0.0f;
+                    for (const uint8_t* texel : texels) {
+                        sum += SrgbToLinear(texel[c]);
+                    }
+                    out[c] = LinearToSrgb(sum * 0.25f);
+                }
+                float alpha = 0.0f;
+                for (const uint8_t* texel : texels) {
+                    alpha += texel[3] / 255.0f;
+                }
+                out[3] = uint8_t(alpha * 0.25f * 255.0f + 0.5f);
+            }
+        }
+    }
+    return levels;
+}
+
+// 全ての段の画素の差の最大
+int MaxDifference(const std::vector<MipLevel>& a, const std::vector<MipLevel>& b) {
+    if (a.size() != b.size()) {
+        return 256;
+    }
+    int maxDifference = 0;
+    for (size_t mip = 0; mip < a.size(); ++mip) {
+        if (a[mip].pixels.size() != b[mip].pixels.size()) {
+            return 256;
+        }
+        for (size_t i = 0; i < a[mip].pixels.size(); ++i) {
+            maxDifference = std::max(maxDifference, std::abs(int(a[mip].pixels[i]) - int(b[mip].pixels[i])));
+        }
+    }
+    return maxDifference;
+}
+
+bool SameLevels(const std::vector<MipLevel>& a, const std::vector<MipLevel>& b) {
+    if (a.size() != b.size()) {
+        return false;
+    }
+    for (size_t mip = 0; mip < a.size(); ++mip) {
+        if (a[mip].pixels != b[mip].pixels) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 繰り返して一番速かった時間 (ミリ秒)
+template <typename Function>
+double MeasureBest(uint32_t repeat, const Function& function) {
+    double best = 1.0e30;
+    for (uint32_t i = 0; i < repeat; ++i) {
+        auto start = std::chrono::steady_clock::now();
+        function();
+        best = std::min(best, Milliseconds(start));
+    }
+    return best;
+}
+
+#if defined(_WIN32)
+// DirectXTex の GenerateMipMaps (結果は MipLevel に写す)
+std::vector<MipLevel> GenerateDirectXTex(const std::vector<uint8_t>& pixels, uint32_t size) {
+    DirectX::Image image{};
+    image.width = size;
+    image.height = size;
+    image.format = DXGI_FORMAT_R8G8B8A8_UNORM_SRGB;
+    image.rowPitch = size_t(size) * 4;
+    image.slicePitch = image.rowPitch * size;
+    image.pixels = const_cast<uint8_t*>(pixels.data());
+    DirectX::ScratchImage mipImages;
+    HRESULT hr = DirectX::GenerateMipMaps(image, DirectX::TEX_FILTER_BOX | DirectX::TEX_FILTER_SRGB, 0, mipImages);
+    std::vector<MipLevel> levels;
+    if (FAILED(hr)) {
+        return levels;
+    }
+    levels.resize(mipImages.GetMetadata().mipLevels);
+    for (size_t mip = 0; mip < levels.size(); ++mip) {
+        const DirectX::Image* source = mipImages.GetImage(mip, 0, 0);
+        levels[mip].width = uint32_t(source->width);
+        levels[mip].height = uint32_t(source->height);
+        levels[mip].pixels.resize(source->width * source->height * 4);
+        for (size_t y = 0; y < source->height; ++y) {
+            std::memcpy(&levels[mip].pixels[y * source->width * 4], source->pixels + y * source->rowPitch, source->width * 4);
+        }
+    }
+    return levels;
+}
+#endif
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t size = argc > 1 ? uint32_t(std::atoi(argv[1])) : 2048;
+    uint32_t repeat = argc > 2 ? uint32_t(std::atoi(argv[2])) : 8;
+    uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    uint32_t workers = argc > 3 ? std::max(1u, uint32_t(std::atoi(argv[3]))) : hardwareThreads;
+    std::printf("image: %ux%u, hardware threads: %u, workers: %u%s\n", size, size, hardwareThreads, workers,
+        workers > hardwareThreads ? " (more than hardware threads, jobs timing is not a speedup)" : "");
+
+    bool passed = true;
+    JobSystem* jobSystem = JobSystem::GetInstance();
+    for (bool cutout : { false, true }) {
+        std::vector<uint8_t> pixels = MakeImage(size, cutout);
+        MipGenerateSettings settings;
+        settings.preserveAlphaCoverage = cutout;
+
+        std::vector<MipLevel> reference;
+        double referenceTime = MeasureBest(repeat, [&] { reference = GenerateReference(pixels, size); });
+
+        for (MipFilter filter : { MipFilter::kBox, MipFilter::kKaiser }) {
+            settings.filter = filter;
+            const char* name = filter == MipFilter::kBox ? "box" : "kaiser";
+
+            // JobSystem を初期化していなければ呼んだスレッドだけで処理する
+            std::vector<MipLevel> serial;
+            double serialTime = MeasureBest(repeat, [&] { serial = GenerateMipChain(pixels.data(), size, size, size * 4, settings); });
+
+            jobSystem->Initialize(workers - 1);
+            std::vector<MipLevel> jobs;
+            double jobsTime = MeasureBest(repeat, [&] { jobs = GenerateMipChain(pixels.data(), size, size, size * 4, settings); });
+            uint32_t workerCount = jobSystem->GetWorkerCount();
+            jobSystem->Finalize();
+
+            std::printf("%-6s %-6s: reference %7.2fms, serial %7.2fms (x%.2f), jobs %7.2fms (x%.2f, %u workers)\n",
+                cutout ? "cutout" : "opaque", name, referenceTime, serialTime, referenceTime / serialTime,
+                jobsTime, referenceTime / jobsTime, workerCount);
+
+            bool deterministic = SameLevels(serial, jobs);
+            std::printf("check: %s %s jobs match serial: %s\n", cutout ? "cutout" : "opaque", name, deterministic ? "yes" : "NO");
+            passed = passed && deterministic;
+            // アルファのカバレッジを保つとアルファは変わるので、2x2平均の不透明な画像だけ比べる
+            if (filter == MipFilter::kBox && !cutout) {
+                int difference = MaxDifference(serial, reference);
+                std::printf("check: box matches reference within 1: %s (max difference %d)\n", difference <= 1 ? "yes" : "NO", difference);
+                passed = passed && difference <= 1;
+            }
+        }
+
+#if defined(_WIN32)
+        std::vector<MipLevel> directXTex;
+        double directXTexTime = MeasureBest(repeat, [&] { directXTex = GenerateDirectXTex(pixels, size); });
+        std::printf("%-6s DirectXTex %7.2fms\n", cutout ? "cutout" : "opaque", directXTexTime);
+        if (!cutout) {
+            int difference = MaxDifference(directXTex, reference);
+            std::printf("check: DirectXTex matches reference within 1: %s (max difference %d)\n", difference <= 1 ? "yes" : "NO", difference);
+            passed = passed && difference <= 1;
+        }
+#endif
+    }
+
+    std::printf("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
@@ -0,0 +1,181 @@
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <thread>
+#include <vector>
+#include "PipelineDesc.h"
+
+// PipelineDesc のキーと PipelineRegistry の確認 (D3D12 を使わない)
+//   hash:     同じ記述なら同じキー、どの項目を変えても別のキーになる。ルートパラメータの名前はキーに含めない
+//   equal:    キーが一致したときの比較 (IsSamePipelineDesc) が、ハッシュに含める項目を全て見ている
+//   dedup:    同じ記述の登録は同じIDになり、マクロ定義だけ違うものは別のIDになる
+//   fallback: コンパイル待ちのあいだは指定したフォールバック、無ければ同じシェーダーの別のパーミュテーションを使う
+//             シェーダーやステートが違うものは、互換 (同じルートシグネチャ・入力レイアウト・出力先) でも使わない
+//   status:   ワーカースレッドから状態を設定しても、コンパイル待ちの数が合う
+// 使い方: PipelineRegistryCheck.exe
+//
+// DXCやWindowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -pthread -I"engine/Pipeline state" -o PipelineRegistryCheck tools/PipelineRegistryCheck/main.cpp
+//       "engine/Pipeline state/PipelineDesc.cpp"
+
+namespace {
+
+bool g_passed = true;
+
+void Check(bool condition, const char* name) {
+    std::printf("check: %s: %s\n", name, condition ? "yes" : "NO");
+    g_passed = g_passed && condition;
+}
+
+// 3Dオブジェクト用の記述
+PipelineDesc MakeDesc() {
+    PipelineDesc desc;
+    desc.vertexShader = L"Resources/shaders/Object3d.VS.hlsl";
+    desc.pixelShader = L"Resources/shaders/Object3d.PS.hlsl";
+    desc.rootParameters = {
+        { RootParameterType::kCBV, ShaderVisibility::kVertex, 0, 0, "gTransformationMatrix" },
+        { RootParameterType::kSRVTable, ShaderVisibility::kPixel, 0, 0, "gTexture" },
+        { RootParameterType::kConstants, ShaderVisibility::kPixel, 1, 4, "gMaterial" },
+    };
+    desc.inputLayout = { { "POSITION", 0, 2 }, { "TEXCOORD", 0, 16 } };
+    desc.blendMode = BlendMode::kAlpha;
+    desc.rtvFormats = { 29 };
+    desc.dsvFormat = 45;
+    return desc;
+}
+
+void CheckHash() {
+    PipelineDesc base = MakeDesc();
+    uint64_t key = HashPipelineDesc(base);
+    Check(key == HashPipelineDesc(MakeDesc()), "hash: same desc gives the same key");
+
+    // 1項目ずつ変えた記述
+    std::vector<std::function<void(PipelineDesc&)>> edits = {
+        [](PipelineDesc& d) { d.vertexShader = L"Resources/shaders/Sprite.VS.hlsl"; },
+        [](PipelineDesc& d) { d.pixelShader.clear(); },
+        [](PipelineDesc& d) { d.pixelProfile = L"ps_6_6"; },
+        [](PipelineDesc& d) { d.vertexDefines = { L"SKINNED" }; },
+        [](PipelineDesc& d) { d.pixelDefines = { L"ALPHA_TEST=1" }; },
+        [](PipelineDesc& d) { d.rootParameters[1].shaderRegister = 1; },
+        [](PipelineDesc& d) { d.rootParameters[2].constantCount = 8; },
+        [](PipelineDesc& d) { d.linearWrapSampler = false; },
+        [](PipelineDesc& d) { d.inputLayout[1].format = 41; },
+        [](PipelineDesc& d) { d.blendMode = BlendMode::kAdd; },
+        [](PipelineDesc& d) { d.cullMode = CullMode::kNone; },
+        [](PipelineDesc& d) { d.wireframe = true; },
+        [](PipelineDesc& d) { d.depthMode = DepthMode::kReadOnly; },
+        [](PipelineDesc& d) { d.reversedZ = true; },
+        [](PipelineDesc& d) { d.topologyType = TopologyType::kLine; },
+        [](PipelineDesc& d) { d.rtvFormats.push_back(10); },
+        [](PipelineDesc& d) { d.dsvFormat = 0; },
+    };
+    bool allKeysDiffer = true;
+    bool allDescsDiffer = true;
+    for (const auto& edit : edits) {
+        PipelineDesc desc = MakeDesc();
+        edit(desc);
+        allKeysDiffer = allKeysDiffer && HashPipelineDesc(desc) != key;
+        allDescsDiffer = allDescsDiffer && !IsSamePipelineDesc(desc, base);
+    }
+    Check(allKeysDiffer, "hash: every field changes the key");
+    Check(allDescsDiffer, "equal: every field is compared");
+
+    PipelineDesc renamed = MakeDesc();
+    renamed.rootParameters[0].name = "gWorld";
+    Check(HashPipelineDesc(renamed) == key && IsSamePipelineDesc(renamed, base), "hash: root parameter names are not part of the key");
+
+    PipelineDesc permutation = MakeDesc();
+    permutation.pixelDefines = { L"ALPHA_TEST=1" };
+    Check(HashPipelinePermutation(permutation) == HashPipelinePermutation(base) && IsPipelinePermutationOf(permutation, base),
+        "hash: permutations share the permutation key");
+    PipelineDesc otherShader = MakeDesc();
+    otherShader.pixelShader = L"Resources/shaders/Unlit.PS.hlsl";
+    Check(HashPipelineCompatibility(otherShader) == HashPipelineCompatibility(base) &&
+        HashPipelinePermutation(otherShader) != HashPipelinePermutation(base) && !IsPipelinePermutationOf(otherShader, base),
+        "hash: another pixel shader is compatible but not a permutation");
+}
+
+void CheckRegistry() {
+    PipelineRegistry registry;
+    bool added = false;
+    PipelineDesc base = MakeDesc();
+    uint32_t baseId = registry.Register(base, &added);
+    Check(added, "dedup: first register adds");
+    PipelineDesc renamed = MakeDesc();
+    renamed.rootParameters[0].name = "gWorld";
+    uint32_t sameId = registry.Register(renamed, &added);
+    Check(sameId == baseId && !added && registry.GetCount() == 1, "dedup: same desc returns the same id");
+
+    PipelineDesc permutation = MakeDesc();
+    permutation.pixelDefines = { L"ALPHA_TEST=1" };
+    uint32_t permutationId = registry.Register(permutation, &added);
+    PipelineDesc otherShader = MakeDesc();
+    otherShader.pixelShader = L"Resources/shaders/Unlit.PS.hlsl";
+    uint32_t otherShaderId = registry.Register(otherShader, &added);
+    PipelineDesc otherState = MakeDesc();
+    otherState.blendMode = BlendMode::kAdd;
+    uint32_t otherStateId = registry.Register(otherState, &added);
+    Check(permutationId != baseId && otherShaderId != baseId && otherStateId != baseId && registry.GetCount() == 4,
+        "dedup: different descs get their own ids");
+    Check(IsSamePipelineDesc(registry.GetDesc(permutationId), permutation) && registry.GetKey(permutationId) == HashPipelineDesc(permutation),
+        "dedup: stored desc and key");
+
+    Check(registry.Resolve(baseId) == PipelineRegistry::kInvalidId, "fallback: nothing ready resolves to invalid");
+
+    // 互換だが別のシェーダー・別のステートのものは自動では使わない
+    registry.SetStatus(otherShaderId, PipelineStatus::kReady);
+    registry.SetStatus(otherStateId, PipelineStatus::kReady);
+    Check(registry.Resolve(baseId) == PipelineRegistry::kInvalidId, "fallback: compatible but different shader or state is not used");
+
+    // 同じシェーダーの別のパーミュテーションは使う
+    registry.SetStatus(permutationId, PipelineStatus::kReady);
+    Check(registry.Resolve(baseId) == permutationId, "fallback: ready permutation is used");
+
+    // 明示的なフォールバックが優先される (互換であれば別のシェーダーでもよい)
+    registry.SetFallback(baseId, otherShaderId);
+    Check(registry.Resolve(baseId) == otherShaderId, "fallback: explicit fallback comes first");
+
+    registry.SetStatus(baseId, PipelineStatus::kReady);
+    Check(registry.Resolve(baseId) == baseId, "fallback: ready pipeline resolves to itself");
+
+    registry.SetStatus(permutationId, PipelineStatus::kFailed);
+    registry.SetStatus(baseId, PipelineStatus::kFailed);
+    registry.SetFallback(baseId, PipelineRegistry::kInvalidId);
+    Check(registry.Resolve(baseId) == PipelineRegistry::kInvalidId, "fallback: failed pipelines are not used");
+}
+
+void CheckStatus() {
+    PipelineRegistry registry;
+    std::vector<uint32_t> ids;
+    for (uint32_t i = 0; i < 64; ++i) {
+        PipelineDesc desc = MakeDesc();
+        desc.pixelDefines = { L"VARIANT=" + std::to_wstring(i) };
+        ids.push_back(registry.Register(desc));
+    }
+    Check(registry.GetPendingCount() == 64, "status: all registered pipelines are pending");
+    std::vector<std::thread> workers;
+    for (uint32_t w = 0; w < 4; ++w) {
+        workers.emplace_back([&, w] {
+            for (size_t i = w; i < ids.size(); i += 4) {
+                registry.SetStatus(ids[i], i % 8 == 0 ? PipelineStatus::kFailed : PipelineStatus::kReady);
+            }
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+    Check(registry.GetPendingCount() == 0, "status: no pending after the workers finish");
+    registry.Clear();
+    Check(registry.GetCount() == 0 && registry.Register(MakeDesc()) == 0, "status: clear restarts the ids");
+}
+
+} // namespace
+
+int main() {
+    CheckHash();
+    CheckRegistry();
+    CheckStatus();
+    std::printf("%s\n", g_passed ? "passed" : "FAILED");
+    return g_passed ? 0 : 1;
+}
@@ -0,0 +1,254 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "CpuProfiler.h"
+
+// プロファイラーの計測と確認
+// まず PROFILE_SCOPE 1つにかかる時間を、何も置かないループ・実行中に無効にしたとき・有効なとき・複数のスレッドで同時に記録するときで比べる
+// 次に決まった時間だけ回して待つ区間を入れ子にして数フレーム回し、集計した時間・回数・木の形が合っていることを確かめる
+// 最後に数フレームを Chrome のトレースに書き出し、区間の数と JSON の形を確かめる
+// 使い方: ProfilerBench.exe [計測する区間の数] [最大のスレッド数] [トレースのパス] (省略時は 2000000 4 ProfilerBench_trace.json)
+//
+// Windowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -pthread -Iengine/Profiler -o ProfilerBench tools/ProfilerBench/main.cpp engine/Profiler/CpuProfiler.cpp
+
+namespace {
+
+// 1フレームに記録する区間の数 (スレッドのバッファに収まる数)
+const uint32_t kScopesPerFrame = 8192;
+
+// 最適化で消されないように、ループの中で触る値
+std::atomic<uint32_t> sink = 0;
+
+double ToMilliseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+// 決まった時間だけ回して待つ (sleep は精度が足りない)
+void Spin(double milliseconds) {
+    auto end = std::chrono::steady_clock::now() + std::chrono::duration<double, std::milli>(milliseconds);
+    while (std::chrono::steady_clock::now() < end) {
+    }
+}
+
+// count 回のループで、1回あたりの時間 (ナノ秒)。区間はフレームごとに EndFrame で読む
+template <typename Body>
+double MeasureLoop(CpuProfiler* profiler, uint32_t count, Body body) {
+    auto start = std::chrono::steady_clock::now();
+    for (uint32_t done = 0; done < count;) {
+        uint32_t batch = std::min(kScopesPerFrame, count - done);
+        for (uint32_t i = 0; i < batch; ++i) {
+            body(i);
+        }
+        done += batch;
+        profiler->EndFrame();
+    }
+    return ToMilliseconds(std::chrono::steady_clock::now() - start) * 1e6 / count;
+}
+
+void EmptyBody(uint32_t i) {
+    sink.fetch_add(i, std::memory_order_relaxed);
+}
+
+void ScopeBody(uint32_t i) {
+    PROFILE_SCOPE("Scope");
+    sink.fetch_add(i, std::memory_order_relaxed);
+}
+
+const ProfileNode* FindNode(const CpuProfiler* profiler, const char* name) {
+    for (const ProfileNode& node : profiler->GetNodes()) {
+        if (std::string(node.name) == name) {
+            return &node;
+        }
+    }
+    return nullptr;
+}
+
+bool Near(double actual, double expected, double tolerance) {
+    return std::abs(actual - expected) <= tolerance;
+}
+
+size_t CountOccurrences(const std::string& text, const std::string& pattern) {
+    size_t count = 0;
+    for (size_t position = text.find(pattern); position != std::string::npos; position = text.find(pattern, position + 1)) {
+        ++count;
+    }
+    return count;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t scopeCount = argc > 1 ? uint32_t(std::atoi(argv[1])) : 2000000;
+    uint32_t maxThreads = argc > 2 ? uint32_t(std::atoi(argv[2])) : 4;
+    std::string tracePath = argc > 3 ? argv[3] : "ProfilerBench_trace.json";
+    bool passed = true;
+
+    CpuProfiler* profiler = CpuProfiler::GetInstance();
+    ProfileSettings settings;
+    settings.threadEventCapacity = kScopesPerFrame * 2;
+    settings.aggregateFrames = 4;
+    profiler->Initialize(settings);
+    profiler->SetThreadName("Main");
+
+    // 1つの区間の時間
+    double baseline = MeasureLoop(profiler, scopeCount, EmptyBody);
+    profiler->SetEnabled(false);
+    double disabled = MeasureLoop(profiler, scopeCount, ScopeBody);
+    profiler->SetEnabled(true);
+    double enabled = MeasureLoop(profiler, scopeCount, ScopeBody);
+    std::printf("baseline:   %.2fns per iteration (no scope)\n", baseline);
+    std::printf("disabled:   %.2fns per scope (+%.2fns)\n", disabled, disabled - baseline);
+    std::printf("enabled:    %.2fns per scope (+%.2fns, two clock reads)\n", enabled, enabled - baseline);
+    std::printf("dropped:    %llu\n", static_cast<unsigned long long>(profiler->GetDroppedCount()));
+    passed = passed && profiler->GetDroppedCount() == 0;
+
+    // 複数のスレッドで同時に記録する (メインスレッドはフレームを回して読み続ける)
+    for (uint32_t threadCount = 1; threadCount <= maxThreads; threadCount *= 2) {
+        std::atomic<uint32_t> finished = 0;
+        std::vector<double> perScope(threadCount);
+        std::vector<std::thread> threads;
+        uint32_t countPerThread = scopeCount / threadCount;
+        uint64_t droppedBefore = profiler->GetDroppedCount();
+        for (uint32_t t = 0; t < threadCount; ++t) {
+            threads.emplace_back([&, t] {
+                profiler->SetThreadName("Worker");
+                auto start = std::chrono::steady_clock::now();
+                for (uint32_t i = 0; i < countPerThread; ++i) {
+                    ScopeBody(i);
+                }
+                perScope[t] = ToMilliseconds(std::chrono::steady_clock::now() - start) * 1e6 / countPerThread;
+                finished.fetch_add(1);
+            });
+        }
+        while (finished.load() < threadCount) {
+            profiler->EndFrame();
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+        for (std::thread& thread : threads) {
+            thread.join();
+        }
+        profiler->EndFrame();
+        double total = 0.0;
+        for (double time : perScope) {
+            total += time;
+        }
+        // スレッドより速く読めないと溢れる (コアが少ないと起きる)
+        std::printf("threads:    %u threads, %.2fns per scope, %llu dropped\n", threadCount, total / threadCount,
+            static_cast<unsigned long long>(profiler->GetDroppedCount() - droppedBefore));
+    }
+
+    // 集計の確かめ (Outer の中に 1ms の Inner が2回、Outer の後に 0.5ms の Tail)
+    profiler->Initialize(settings);
+    profiler->SetThreadName("Main");
+    const uint32_t kFrames = 8;
+    auto accuracyStart = std::chrono::steady_clock::now();
+    for (uint32_t frame = 0; frame < kFrames; ++frame) {
+        profiler->BeginFrame();
+        {
+            PROFILE_SCOPE("Outer");
+            for (int i = 0; i < 2; ++i) {
+                PROFILE_SCOPE("Inner");
+                Spin(1.0);
+            }
+        }
+        {
+            PROFILE_SCOPE("Tail");
+            Spin(0.5);
+        }
+        profiler->EndFrame();
+    }
+    double wallPerFrame = ToMilliseconds(std::chrono::steady_clock::now() - accuracyStart) / kFrames;
+    const ProfileNode* outer = FindNode(profiler, "Outer");
+    const ProfileNode* inner = FindNode(profiler, "Inner");
+    const ProfileNode* tail = FindNode(profiler, "Tail");
+    const ProfileFrameStats& frameStats = profiler->GetFrameStats();
+    bool accurate = outer != nullptr && inner != nullptr && tail != nullptr && profiler->GetNodes().size() == 3;
+    if (accurate) {
+        std::printf("aggregate:  Outer %.3f/%.3f/%.3fms, Inner %.3fms x%.1f, Tail %.3fms, frame %.3fms (wall %.3fms)\n",
+            outer->minMilliseconds, outer->averageMilliseconds, outer->maxMilliseconds, inner->averageMilliseconds,
+            inner->callsPerFrame, tail->averageMilliseconds, frameStats.averageMilliseconds, wallPerFrame);
+        // 回して待つので短くはならない。長くなるのは割り込まれた分 (1コアで他が動くと起きる)
+        accurate = inner->parent == outer - profiler->GetNodes().data() && outer->parent == -1 && tail->parent == -1 &&
+            inner->callsPerFrame == 2.0 && outer->callsPerFrame == 1.0 && inner->minMilliseconds >= 2.0 &&
+            Near(inner->averageMilliseconds, 2.0, 0.2) && Near(tail->averageMilliseconds, 0.5, 0.1) &&
+            outer->averageMilliseconds >= inner->averageMilliseconds && Near(outer->averageMilliseconds, inner->averageMilliseconds, 0.1) &&
+            frameStats.averageMilliseconds >= outer->averageMilliseconds + tail->averageMilliseconds &&
+            Near(frameStats.averageMilliseconds, wallPerFrame, 0.1);
+    }
+    std::printf("aggregate:  %s\n", accurate ? "ok" : "FAILED");
+    passed = passed && accurate;
+
+    // トレースの書き出し (メインと2つのスレッドで3フレーム)
+    const uint32_t kCaptureFrames = 3;
+    const uint32_t kWorkerScopes = 5;
+    profiler->RequestCapture(kCaptureFrames);
+    for (uint32_t frame = 0; frame < kCaptureFrames; ++frame) {
+        profiler->BeginFrame();
+        {
+            PROFILE_SCOPE("Frame \"quoted\"\\path");
+            std::vector<std::thread> threads;
+            for (int t = 0; t < 2; ++t) {
+                threads.emplace_back([] {
+                    CpuProfiler::GetInstance()->SetThreadName("TraceWorker");
+                    for (uint32_t i = 0; i < kWorkerScopes; ++i) {
+                        PROFILE_SCOPE("Job");
+                        Spin(0.05);
+                    }
+                });
+            }
+            for (std::thread& thread : threads) {
+                thread.join();
+            }
+        }
+        profiler->EndFrame();
+    }
+    bool traced = profiler->IsCaptureReady();
+    std::string error;
+    traced = traced && profiler->WriteChromeTrace(tracePath, &error);
+    std::ifstream file(tracePath);
+    std::stringstream stream;
+    stream << file.rdbuf();
+    std::string json = stream.str();
+    size_t completeEvents = CountOccurrences(json, "\"ph\":\"X\"");
+    // フレーム + メインの区間 + スレッドごとの区間
+    size_t expectedEvents = kCaptureFrames * (1 + 1 + 2 * kWorkerScopes);
+    int depth = 0;
+    bool inString = false;
+    bool balanced = true;
+    for (size_t i = 0; i < json.size(); ++i) {
+        char c = json[i];
+        if (inString) {
+            if (c == '\\') {
+                ++i;
+            } else if (c == '"') {
+                inString = false;
+            }
+        } else if (c == '"') {
+            inString = true;
+        } else if (c == '{' || c == '[') {
+            ++depth;
+        } else if (c == '}' || c == ']') {
+            balanced = balanced && --depth >= 0;
+        }
+    }
+    balanced = balanced && depth == 0 && !inString;
+    std::printf("trace:      %zu complete events (expected %zu), %zu bytes, %s -> %s\n", completeEvents, expectedEvents, json.size(),
+        balanced ? "balanced" : "BROKEN", error.empty() ? tracePath.c_str() : error.c_str());
+    traced = traced && completeEvents == expectedEvents && balanced && json.find("\"TraceWorker\"") != std::string::npos &&
+        json.find("Frame \\\"quoted\\\"\\\\path") != std::string::npos;
+    passed = passed && traced;
+
+    profiler->Finalize();
+    std::printf("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
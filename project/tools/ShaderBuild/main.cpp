@@ -0,0 +1,219 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "ShaderBuild.h"
+#include "ShaderCache.h"
+#include "ShaderPermutation.h"
+#ifdef _WIN32
+#include "ShaderCompiler.h"
+#endif
+
+// シェーダーの一括ビルド
+// Resources/shaders の全てのエントリポイントをDebug/Release両方の引数でコンパイルし、キャッシュ(Resources/cooked/shaders)に入れる
+// パーミュテーションを持つシェーダーは全ての組み合わせをコンパイルし、組み合わせの数と合計サイズを出す
+// 使い方: ShaderBuild.exe [--debug | --release] [シェーダーのディレクトリ] (省略時は両方の構成・Resources/shaders)
+// プロジェクトのディレクトリ (Resources がある場所) で実行する
+//
+// Windowsではdxcompiler.dllを直接使い、それ以外ではPATHにある dxc コマンドを呼ぶ
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -pthread -I"engine/Pipeline state" -o ShaderBuild tools/ShaderBuild/main.cpp
+//       "engine/Pipeline state/ShaderBuild.cpp" "engine/Pipeline state/ShaderCache.cpp"
+//       "engine/Pipeline state/ShaderPermutation.cpp"
+
+namespace {
+
+// 1つ分のビルド結果
+struct BuildReport {
+    bool succeeded = false;
+    bool cacheHit = false;
+    double milliseconds = 0.0;
+    size_t size = 0; // DXILのバイト数
+    std::string errors;
+};
+
+std::string ToNarrow(const std::wstring& text) {
+    return std::filesystem::path(text).string();
+}
+
+#ifdef _WIN32
+
+// スレッドごとにDXCのインスタンスを持つ
+class Builder {
+public:
+    void Build(const ShaderEntryPoint& entryPoint, bool debug, BuildReport& report) {
+        ShaderCompileResult result;
+        report.succeeded = compiler_.Compile(entryPoint.filePath, entryPoint.profile, entryPoint.entryPoint, result, debug,
+            entryPoint.defines);
+        report.cacheHit = result.cacheHit;
+        report.size = result.blob != nullptr ? result.blob->GetBufferSize() : 0;
+        report.milliseconds = result.milliseconds;
+        report.errors = result.errors;
+    }
+
+private:
+    ShaderCompiler compiler_;
+};
+
+#else
+
+// dxc --version の出力 (キャッシュのキーに含める。最初に呼んだときに1回だけ取る)
+const std::string& GetDxcCommandVersion() {
+    static const std::string version = [] {
+        std::filesystem::path versionPath = std::filesystem::temp_directory_path() / "ShaderBuild_dxc_version.txt";
+        std::string command = "dxc --version > \"" + versionPath.string() + "\" 2>&1";
+        std::string text = "unknown";
+        if (std::system(command.c_str()) == 0) {
+            std::ifstream file(versionPath);
+            text.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+        }
+        std::error_code ec;
+        std::filesystem::remove(versionPath, ec);
+        return text;
+    }();
+    return version;
+}
+
+// dxc コマンドでコンパイルする (プロセスごとに別のコンパイラになる)
+class Builder {
+public:
+    void Build(const ShaderEntryPoint& entryPoint, bool debug, BuildReport& report) {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::wstring> options = MakeShaderCompileOptions(entryPoint.profile, entryPoint.entryPoint, debug,
+            entryPoint.defines);
+        uint64_t sourceHash = HashShaderSource(entryPoint.filePath);
+        if (sourceHash == 0) {
+            report.errors = "Failed to read shader source";
+            return;
+        }
+        std::filesystem::path cachePath = GetShaderCachePath(entryPoint.filePath, entryPoint.profile,
+            MakeShaderCacheKey(sourceHash, entryPoint.profile, entryPoint.entryPoint, options, GetDxcCommandVersion()));
+        std::vector<uint8_t> blob;
+        if (LoadShaderCache(cachePath, blob)) {
+            report.succeeded = true;
+            report.cacheHit = true;
+            report.size = blob.size();
+            report.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+            return;
+        }
+
+        std::filesystem::path outputPath = cachePath;
+        outputPath += ".out";
+        std::filesystem::path errorPath = cachePath;
+        errorPath += ".err";
+        std::error_code ec;
+        std::filesystem::create_directories(cachePath.parent_path(), ec);
+
+        std::string command = "dxc";
+        for (const std::wstring& option : options) {
+            command += " " + ToNarrow(option);
+        }
+        command += " -Fo \"" + outputPath.string() + "\" \"" + ToNarrow(entryPoint.filePath) + "\" 2> \"" + errorPath.string() + "\"";
+        int exitCode = std::system(command.c_str());
+
+        std::ifstream errorFile(errorPath);
+        report.errors.assign(std::istreambuf_iterator<char>(errorFile), std::istreambuf_iterator<char>());
+        errorFile.close();
+        std::filesystem::remove(errorPath, ec);
+
+        std::ifstream outputFile(outputPath, std::ios::binary);
+        blob.assign(std::istreambuf_iterator<char>(outputFile), std::istreambuf_iterator<char>());
+        outputFile.close();
+        std::filesystem::remove(outputPath, ec);
+        if (exitCode != 0 || blob.empty()) {
+            return;
+        }
+        report.succeeded = SaveShaderCache(cachePath, blob.data(), blob.size());
+        report.size = blob.size();
+        report.milliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    }
+};
+
+#endif
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::filesystem::path directory = "Resources/shaders";
+    std::vector<bool> configurations = { true, false };
+    for (int i = 1; i < argc; ++i) {
+        std::string argument = argv[i];
+        if (argument == "--debug") {
+            configurations = { true };
+        } else if (argument == "--release") {
+            configurations = { false };
+        } else {
+            directory = argument;
+        }
+    }
+
+    ShaderBuildGraph graph;
+    graph.Scan(directory);
+    std::vector<ShaderEntryPoint> entryPoints = ExpandShaderPermutations(graph.GetEntryPoints());
+
+    // (エントリポイント, 構成) の組を全て並列にビルドする
+    struct Item {
+        size_t entryPointIndex;
+        bool debug;
+    };
+    std::vector<Item> items;
+    for (bool debug : configurations) {
+        for (size_t i = 0; i < entryPoints.size(); ++i) {
+            items.push_back({ i, debug });
+        }
+    }
+    std::vector<BuildReport> reports(items.size());
+
+    auto start = std::chrono::steady_clock::now();
+    RunShaderBuild(items.size(), 0, [&] {
+        auto builder = std::make_shared<Builder>();
+        return [&, builder](size_t index) {
+            builder->Build(entryPoints[items[index].entryPointIndex], items[index].debug, reports[index]);
+        };
+    });
+    double totalMilliseconds = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    std::printf("%-72s %-8s %10s %10s\n", "shader", "config", "size", "time");
+    int failedCount = 0;
+    double sumMilliseconds = 0.0;
+    for (size_t i = 0; i < items.size(); ++i) {
+        const ShaderEntryPoint& entryPoint = entryPoints[items[i].entryPointIndex];
+        const BuildReport& report = reports[i];
+        std::printf("%-72s %-8s ", ToNarrow(GetShaderEntryPointName(entryPoint)).c_str(), items[i].debug ? "debug" : "release");
+        if (!report.succeeded) {
+            std::printf("%10s\n%s\n", "FAILED", report.errors.c_str());
+            ++failedCount;
+            continue;
+        }
+        std::printf("%10zu %8.2fms%s\n", report.size, report.milliseconds, report.cacheHit ? " (cached)" : "");
+        sumMilliseconds += report.milliseconds;
+    }
+
+    // パーミュテーションごとの集計 (組み合わせの数と、構成ごとの合計サイズ)
+    for (const ShaderPermutationSet& set : GetShaderPermutationSets()) {
+        for (bool debug : configurations) {
+            size_t permutationCount = 0;
+            size_t totalSize = 0;
+            for (size_t i = 0; i < items.size(); ++i) {
+                const ShaderEntryPoint& entryPoint = entryPoints[items[i].entryPointIndex];
+                if (items[i].debug != debug || std::filesystem::path(entryPoint.filePath).filename().wstring() != set.fileName) {
+                    continue;
+                }
+                ++permutationCount;
+                totalSize += reports[i].size;
+            }
+            if (permutationCount == 0) {
+                continue;
+            }
+            std::printf("permutations: %s (%s): %zu variants of %zu, %zu bytes\n", ToNarrow(set.fileName).c_str(),
+                debug ? "debug" : "release", permutationCount, EnumerateShaderPermutations(set).size(), totalSize);
+        }
+    }
+    std::printf("total: %zu shaders, %.2fms wall (%.2fms summed), %d failed\n",
+        items.size(), totalMilliseconds, sumMilliseconds, failedCount);
+    return failedCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,92 @@
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "ShaderCache.h"
+
+// シェーダーキャッシュのキーの確認
+// 一時ディレクトリに main.hlsl → common/lighting.hlsli → brdf.hlsli と入れ子にインクルードするソースと、関係の無い unrelated.hlsli を書き、
+//   入れ子の奥の hlsli を書き換えるとキーが変わり、元に戻すと元のキーに戻る
+//   関係の無いファイルを書き換えてもキーは変わらない
+//   コンパイラの版・コンパイル引数が違えば別のキーになる
+//   キャッシュの保存と読み込みで同じ中身が返り、DXILコンテナでないキャッシュは読まない
+// ことを確かめる
+// 使い方: ShaderCacheCheck.exe
+//
+// DXCやWindowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -I"engine/Pipeline state" -o ShaderCacheCheck tools/ShaderCacheCheck/main.cpp "engine/Pipeline state/ShaderCache.cpp"
+
+namespace {
+
+bool g_passed = true;
+
+void Check(bool condition, const char* name) {
+    std::printf("check: %s: %s\n", name, condition ? "yes" : "NO");
+    g_passed = g_passed && condition;
+}
+
+void WriteText(const std::filesystem::path& path, const std::string& text) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream file(path, std::ios::binary);
+    file << text;
+}
+
+// 今のソースでのキー
+uint64_t MakeKey(const std::filesystem::path& source, const std::string& compilerVersion, bool debug = false) {
+    std::vector<std::wstring> options = MakeShaderCompileOptions(L"ps_6_0", L"main", debug);
+    return MakeShaderCacheKey(HashShaderSource(source), L"ps_6_0", L"main", options, compilerVersion);
+}
+
+} // namespace
+
+int main() {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "ShaderCacheCheck";
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+
+    const std::string brdf = "float3 Brdf(float3 n, float3 l) { return saturate(dot(n, l)); }\n";
+    std::filesystem::path source = directory / "main.hlsl";
+    std::filesystem::path nested = directory / "common" / "brdf.hlsli";
+    std::filesystem::path unrelated = directory / "unrelated.hlsli";
+    WriteText(source, "#include \"common/lighting.hlsli\"\nfloat4 main() : SV_TARGET { return Lighting(); }\n");
+    WriteText(directory / "common" / "lighting.hlsli",
+        "#pragma once\n#include \"brdf.hlsli\"\nfloat4 Lighting() { return float4(Brdf(float3(0, 1, 0), float3(0, 1, 0)), 1); }\n");
+    WriteText(nested, brdf);
+    WriteText(unrelated, "float Unused() { return 0; }\n");
+
+    const std::string version = "dxcompiler 1.8.2502 (abc123) dxil 1.8";
+    std::vector<std::filesystem::path> dependencies;
+    HashShaderSource(source, &dependencies);
+    Check(dependencies.size() == 3, "dependencies: source and both nested includes");
+
+    uint64_t key = MakeKey(source, version);
+    Check(key == MakeKey(source, version), "same sources give the same key");
+
+    WriteText(nested, "float3 Brdf(float3 n, float3 l) { return saturate(dot(n, l)) * 0.5; }\n");
+    Check(MakeKey(source, version) != key, "editing a nested include changes the key");
+    WriteText(nested, brdf);
+    Check(MakeKey(source, version) == key, "restoring the nested include restores the key");
+
+    WriteText(unrelated, "float Unused() { return 1; }\n");
+    Check(MakeKey(source, version) == key, "editing an unrelated file keeps the key");
+
+    Check(MakeKey(source, "dxcompiler 1.8.2505 (def456) dxil 1.8") != key, "another compiler version changes the key");
+    Check(MakeKey(source, "dxcompiler 1.8.2502 (abc123) dxil 1.7") != key, "another validator version changes the key");
+    Check(MakeKey(source, version, true) != key, "debug arguments change the key");
+
+    // 保存と読み込み
+    std::filesystem::path cachePath = directory / "cache" / "main_ps_6_0.dxil";
+    std::vector<uint8_t> blob = { 'D', 'X', 'B', 'C', 1, 2, 3, 4, 5, 6, 7, 8 };
+    std::filesystem::create_directories(cachePath.parent_path());
+    std::vector<uint8_t> loaded;
+    Check(SaveShaderCache(cachePath, blob.data(), blob.size()) && LoadShaderCache(cachePath, loaded) && loaded == blob,
+        "cache round trip");
+    WriteText(cachePath, "DX");
+    Check(!LoadShaderCache(cachePath, loaded) && loaded.empty(), "broken cache is rejected");
+
+    std::filesystem::remove_all(directory, ec);
+    std::printf("%s\n", g_passed ? "passed" : "FAILED");
+    return g_passed ? 0 : 1;
+}
@@ -0,0 +1,344 @@
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include "DataTypes.h"
+#include "ShaderBuild.h"
+#include "ShaderCache.h"
+#include "ShaderPermutation.h"
+#include "ShaderReflection.h"
+#ifdef _WIN32
+#include "ShaderCompiler.h"
+#endif
+
+// シェーダーのレイアウトの確認
+// C++の構造体(DataTypes.h)のメンバーのオフセットと大きさが、DXCでコンパイルしたシェーダーのリフレクションと一致するかを調べる
+// あわせて Resources/shaders の全てのエントリポイント (パーミュテーションは組み合わせごと) のバインドと、頂点・ピクセルの組から作られるルートシグネチャを出す
+// パーミュテーションを持つシェーダーは、ゲームと同じく全ての組み合わせを合わせたものでルートシグネチャと構造体を調べる
+// 一致しない・コンパイルできないものがあれば 1 を返すので、ビルドステップに入れて使う
+// 使い方: ShaderLayoutCheck.exe [シェーダーのディレクトリ] (省略時は Resources/shaders)
+// プロジェクトのディレクトリ (Resources がある場所) で実行する
+//
+// Windowsではdxcompiler.dllでコンパイルしてリフレクションし (結果はシェーダーキャッシュに入るので、続けて起動するゲームはキャッシュから読む)、
+// それ以外ではPATHにある dxc コマンドの逆アセンブル (-Fc) からリフレクションする
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -I. -I"engine/Pipeline state" -o ShaderLayoutCheck tools/ShaderLayoutCheck/main.cpp
+//       "engine/Pipeline state/ShaderBuild.cpp" "engine/Pipeline state/ShaderCache.cpp"
+//       "engine/Pipeline state/ShaderPermutation.cpp" "engine/Pipeline state/ShaderReflection.cpp"
+
+namespace {
+
+// C++のメンバー
+struct CppField {
+    const char* name;
+    size_t offset;
+    size_t size;
+};
+
+// C++の構造体と、対応するHLSLの構造体
+struct CppStruct {
+    const char* name;
+    size_t size;
+    std::vector<CppField> fields;
+    const char* shaderFile; // HLSLの構造体を宣言している(インクルードしている)シェーダー
+};
+
+#define LAYOUT_FIELD(type, member) { #member, offsetof(type, member), sizeof(type::member) }
+
+const std::vector<CppStruct>& GetCppStructs() {
+    static const std::vector<CppStruct> kStructs = {
+        {
+            "Material",
+            sizeof(Material),
+            {
+                LAYOUT_FIELD(Material, color),
+                LAYOUT_FIELD(Material, enableLighting),
+                LAYOUT_FIELD(Material, alphaReference),
+                LAYOUT_FIELD(Material, padding),
+                LAYOUT_FIELD(Material, uvTransform),
+            },
+            "Object3d.PS.hlsl",
+        },
+        {
+            "TransformationMatrix",
+            sizeof(TransformationMatrix),
+            {
+                LAYOUT_FIELD(TransformationMatrix, WVP),
+                LAYOUT_FIELD(TransformationMatrix, World),
+            },
+            "Object3d.VS.hlsl",
+        },
+        {
+            "DirectionalLight",
+            sizeof(DirectionalLight),
+            {
+                LAYOUT_FIELD(DirectionalLight, color),
+                LAYOUT_FIELD(DirectionalLight, direction),
+                LAYOUT_FIELD(DirectionalLight, intensity),
+            },
+            "Object3d.PS.hlsl",
+        },
+    };
+    return kStructs;
+}
+
+#undef LAYOUT_FIELD
+
+// HLSLに無いメンバーは詰め物だけ許す
+bool IsPadding(const std::string& name) {
+    return name.rfind("padding", 0) == 0;
+}
+
+// C++の構造体とHLSLの構造体を比べる (食い違いを出して、一致すれば true)
+bool CheckStruct(const CppStruct& cppStruct, const ShaderStructLayout& layout) {
+    bool matched = true;
+    for (const ShaderConstantField& field : layout.fields) {
+        const CppField* found = nullptr;
+        for (const CppField& cppField : cppStruct.fields) {
+            if (field.name == cppField.name) {
+                found = &cppField;
+                break;
+            }
+        }
+        if (found == nullptr) {
+            std::printf("  %s.%s: missing in C++ (hlsl offset %u)\n", cppStruct.name, field.name.c_str(), field.offset);
+            matched = false;
+        } else if (found->offset != field.offset || found->size != field.size) {
+            std::printf("  %s.%s: C++ offset %zu size %zu, hlsl offset %u size %u\n", cppStruct.name, field.name.c_str(),
+                found->offset, found->size, field.offset, field.size);
+            matched = false;
+        }
+    }
+    for (const CppField& cppField : cppStruct.fields) {
+        bool inShader = false;
+        for (const ShaderConstantField& field : layout.fields) {
+            inShader = inShader || field.name == cppField.name;
+        }
+        if (!inShader && !IsPadding(cppField.name)) {
+            std::printf("  %s.%s: missing in hlsl\n", cppStruct.name, cppField.name);
+            matched = false;
+        }
+    }
+    // 定数バッファに置くので、HLSLの大きさより小さいとバッファの外を読む
+    if (cppStruct.size < layout.size) {
+        std::printf("  %s: C++ size %zu is smaller than hlsl size %u\n", cppStruct.name, cppStruct.size, layout.size);
+        matched = false;
+    }
+    return matched;
+}
+
+const char* ToString(ShaderBinding::Type type) {
+    switch (type) {
+    case ShaderBinding::Type::kConstantBuffer:
+        return "cbuffer";
+    case ShaderBinding::Type::kTexture:
+        return "texture";
+    case ShaderBinding::Type::kSampler:
+        return "sampler";
+    }
+    return "?";
+}
+
+const char* ToString(RootParameterType type) {
+    switch (type) {
+    case RootParameterType::kCBV:
+        return "CBV";
+    case RootParameterType::kSRVTable:
+        return "SRV table";
+    case RootParameterType::kConstants:
+        return "constants";
+    }
+    return "?";
+}
+
+const char* ToString(ShaderVisibility visibility) {
+    switch (visibility) {
+    case ShaderVisibility::kAll:
+        return "all";
+    case ShaderVisibility::kVertex:
+        return "vertex";
+    case ShaderVisibility::kPixel:
+        return "pixel";
+    }
+    return "?";
+}
+
+// 頂点シェーダーと組になるピクセルシェーダー (XxxVS.hlsl → XxxPS.hlsl, Xxx.VS.hlsl → Xxx.PS.hlsl)
+std::filesystem::path FindPixelShader(const std::filesystem::path& vertexShader) {
+    std::string fileName = vertexShader.filename().string();
+    size_t position = fileName.rfind("VS.hlsl");
+    if (position == std::string::npos) {
+        return {};
+    }
+    std::filesystem::path pixelShader = vertexShader.parent_path() / (fileName.substr(0, position) + "PS.hlsl");
+    return std::filesystem::exists(pixelShader) ? pixelShader : std::filesystem::path();
+}
+
+std::string ToNarrow(const std::wstring& text) {
+    return std::filesystem::path(text).string();
+}
+
+#ifdef _WIN32
+
+// DXCのインスタンスでコンパイルしてリフレクションする
+class Reflector {
+public:
+    bool Reflect(const std::wstring& filePath, const std::wstring& profile, const std::vector<std::wstring>& defines,
+        ShaderReflection& reflection, std::string* error) {
+        return ReflectShader(compiler_, filePath, profile, defines, reflection, error);
+    }
+
+private:
+    ShaderCompiler compiler_;
+};
+
+#else
+
+// dxc コマンドでコンパイルし、逆アセンブルからリフレクションする (引数は描画に使うものと同じ)
+class Reflector {
+public:
+    bool Reflect(const std::wstring& filePath, const std::wstring& profile, const std::vector<std::wstring>& defines,
+        ShaderReflection& reflection, std::string* error) {
+        std::filesystem::path outputPath = std::filesystem::temp_directory_path() / "ShaderLayoutCheck.dxil.txt";
+        std::filesystem::path errorPath = std::filesystem::temp_directory_path() / "ShaderLayoutCheck.err.txt";
+        std::string command = "dxc";
+        for (const std::wstring& option : MakeShaderCompileOptions(profile, L"main", kShaderDebugBuild, defines)) {
+            command += " " + ToNarrow(option);
+        }
+        command += " -Fc \"" + outputPath.string() + "\" \"" + ToNarrow(filePath) + "\" 2> \"" + errorPath.string() + "\"";
+        int exitCode = std::system(command.c_str());
+
+        std::ifstream errorFile(errorPath);
+        std::string errors((std::istreambuf_iterator<char>(errorFile)), std::istreambuf_iterator<char>());
+        errorFile.close();
+        std::ifstream outputFile(outputPath);
+        std::string disassembly((std::istreambuf_iterator<char>(outputFile)), std::istreambuf_iterator<char>());
+        outputFile.close();
+        std::error_code ec;
+        std::filesystem::remove(errorPath, ec);
+        std::filesystem::remove(outputPath, ec);
+
+        std::string name = std::filesystem::path(filePath).generic_string();
+        if (exitCode != 0 || disassembly.empty()) {
+            reflection = {};
+            if (error) {
+                *error = name + ": " + (errors.empty() ? "dxc failed (is dxc in PATH?)" : errors);
+            }
+            return false;
+        }
+        if (!ReflectShaderDisassembly(disassembly, reflection, error)) {
+            if (error) {
+                *error = name + ": " + *error;
+            }
+            return false;
+        }
+        return true;
+    }
+};
+
+#endif
+
+// ファイル名からプロファイルを決めてリフレクションする (パーミュテーションを持つものは全ての組み合わせを合わせる)
+bool Reflect(Reflector& reflector, const std::filesystem::path& path, ShaderReflection& reflection, std::string* error = nullptr) {
+    std::wstring filePath = path.generic_wstring();
+    std::wstring profile = GetShaderProfileFromFileName(path);
+    return ReflectShaderPermutations(filePath, {},
+        [&](const std::vector<std::wstring>& defines, ShaderReflection& result, std::string* message) {
+            return reflector.Reflect(filePath, profile, defines, result, message);
+        },
+        reflection, error);
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    std::filesystem::path directory = argc > 1 ? argv[1] : "Resources/shaders";
+    int failed = 0;
+    Reflector reflector;
+
+    // エントリポイントごとのバインド
+    ShaderBuildGraph graph;
+    graph.Scan(directory);
+    for (const ShaderEntryPoint& entryPoint : ExpandShaderPermutations(graph.GetEntryPoints())) {
+        std::string name = ToNarrow(GetShaderEntryPointName(entryPoint));
+        ShaderReflection reflection;
+        std::string error;
+        if (!reflector.Reflect(entryPoint.filePath, entryPoint.profile, entryPoint.defines, reflection, &error)) {
+            std::printf("%s: FAILED\n  %s\n", name.c_str(), error.c_str());
+            ++failed;
+            continue;
+        }
+        std::printf("%s\n", name.c_str());
+        for (const ShaderBinding& binding : reflection.bindings) {
+            std::printf("  %-8s %-24s register %u space %u", ToString(binding.type), binding.name.c_str(), binding.shaderRegister,
+                binding.space);
+            if (binding.type == ShaderBinding::Type::kConstantBuffer) {
+                std::printf(" %u bytes", binding.layout.size);
+            }
+            std::printf("\n");
+        }
+    }
+
+    // 頂点・ピクセルの組から作られるルートシグネチャ
+    for (const ShaderEntryPoint& entryPoint : graph.GetEntryPoints()) {
+        if (entryPoint.profile.rfind(L"vs_", 0) != 0) {
+            continue;
+        }
+        std::filesystem::path vertexPath = entryPoint.filePath;
+        std::filesystem::path pixelPath = FindPixelShader(vertexPath);
+        ShaderReflection vertex;
+        ShaderReflection pixel;
+        if (!Reflect(reflector, vertexPath, vertex) || (!pixelPath.empty() && !Reflect(reflector, pixelPath, pixel))) {
+            continue; // 上で報告済み
+        }
+        std::vector<RootParameter> rootParameters;
+        bool useSampler = false;
+        std::string error;
+        std::printf("root signature: %s + %s\n", vertexPath.filename().string().c_str(),
+            pixelPath.empty() ? "(none)" : pixelPath.filename().string().c_str());
+        if (!MakeRootParameters(vertex, pixelPath.empty() ? nullptr : &pixel, rootParameters, &useSampler, &error)) {
+            std::printf("  FAILED: %s\n", error.c_str());
+            ++failed;
+            continue;
+        }
+        for (size_t i = 0; i < rootParameters.size(); ++i) {
+            const RootParameter& parameter = rootParameters[i];
+            std::printf("  [%zu] %-9s %-6s register %u", i, ToString(parameter.type), ToString(parameter.visibility),
+                parameter.shaderRegister);
+            if (parameter.type == RootParameterType::kConstants) {
+                std::printf(" (%u dwords)", parameter.constantCount);
+            }
+            std::printf(" %s\n", parameter.name.c_str());
+        }
+        std::printf("  sampler: %s\n", useSampler ? "linear wrap (s0)" : "none");
+    }
+
+    // C++の構造体との照合
+    for (const CppStruct& cppStruct : GetCppStructs()) {
+        std::filesystem::path path = directory / cppStruct.shaderFile;
+        ShaderReflection reflection;
+        std::string error;
+        const ShaderStructLayout* layout = nullptr;
+        if (Reflect(reflector, path, reflection, &error)) {
+            layout = reflection.FindStruct(cppStruct.name);
+        }
+        if (layout == nullptr) {
+            std::printf("layout %s: FAILED (not found in %s) %s\n", cppStruct.name, path.generic_string().c_str(), error.c_str());
+            ++failed;
+            continue;
+        }
+        bool matched = CheckStruct(cppStruct, *layout);
+        std::printf("layout %s: %s (C++ %zu bytes, hlsl %u bytes)\n", cppStruct.name, matched ? "ok" : "MISMATCH", cppStruct.size,
+            layout->size);
+        if (!matched) {
+            ++failed;
+        }
+    }
+
+    std::printf("total: %d failed\n", failed);
+    return failed == 0 ? 0 : 1;
+}
@@ -0,0 +1,141 @@
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <thread>
+#include <vector>
+#include "ShaderBuild.h"
+#include "ShaderWatcher.h"
+
+// ShaderWatcher の確認 (本物のファイルの変更で試す)
+// 一時ディレクトリに Lit.VS.hlsl (common/Lighting.hlsli をインクルード) と Unlit.PS.hlsl を書き、次の変更を連続して (バースト) 行う
+//   write:  インクルードしている hlsli に何度か書き込む
+//   rename: 一時ファイルに書いてから置き換える (保存時にこうするエディタがある)
+//   touch:  更新日時だけを変える
+// バーストごとに、影響するエントリポイントだけがちょうど1回返り、それが最後の変更から 200ms 以内であること、
+// その後は何も返らないことを確かめる
+// Linux では inotify、Windows では FindFirstChangeNotification と、更新日時のポーリングの両方で試す
+// 使い方: ShaderWatcherCheck.exe
+//
+// DXCに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -pthread -I"engine/Pipeline state" -o ShaderWatcherCheck tools/ShaderWatcherCheck/main.cpp
+//       "engine/Pipeline state/ShaderWatcher.cpp" "engine/Pipeline state/ShaderBuild.cpp" "engine/Pipeline state/ShaderCache.cpp"
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+// 変更が落ち着くまでの待ち時間と、返るまでの上限
+const std::chrono::milliseconds kDebounce{ 50 };
+const std::chrono::milliseconds kLatencyLimit{ 200 };
+// バーストの中の変更の間隔 (待ち時間より短くする)
+const std::chrono::milliseconds kBurstInterval{ 10 };
+
+bool g_passed = true;
+
+void Check(bool condition, const std::string& name) {
+    std::printf("check: %s: %s\n", name.c_str(), condition ? "yes" : "NO");
+    g_passed = g_passed && condition;
+}
+
+void WriteText(const std::filesystem::path& path, const std::string& text) {
+    std::filesystem::create_directories(path.parent_path());
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    file << text;
+}
+
+// Poll を回して、返ったエントリポイントと、最後の変更から返るまでの時間を集める
+struct PollResult {
+    std::vector<std::vector<size_t>> events;
+    double latencyMilliseconds = 0.0;
+};
+
+PollResult PollFor(ShaderWatcher& watcher, Clock::time_point lastChange, std::chrono::milliseconds duration) {
+    PollResult result;
+    Clock::time_point end = Clock::now() + duration;
+    while (Clock::now() < end) {
+        std::vector<size_t> entryPoints = watcher.Poll();
+        if (!entryPoints.empty()) {
+            if (result.events.empty()) {
+                result.latencyMilliseconds = std::chrono::duration<double, std::milli>(Clock::now() - lastChange).count();
+            }
+            result.events.push_back(entryPoints);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+    return result;
+}
+
+// 1回のバーストの結果を確かめる
+void CheckBurst(ShaderWatcher& watcher, const char* mode, const char* name, Clock::time_point lastChange, size_t expected) {
+    // 上限まで待ってから、さらに待ち時間の倍だけ余計に返らないことを見る
+    PollResult result = PollFor(watcher, lastChange, kLatencyLimit + kDebounce * 2);
+    bool once = result.events.size() == 1 && result.events[0] == std::vector<size_t>{ expected };
+    std::printf("%s %s: %zu events, latency %.1fms\n", mode, name, result.events.size(), result.latencyMilliseconds);
+    Check(once, std::string(mode) + " " + name + ": one event for the affected entry point");
+    Check(once && result.latencyMilliseconds <= double(kLatencyLimit.count()),
+        std::string(mode) + " " + name + ": within " + std::to_string(kLatencyLimit.count()) + "ms of the last change");
+}
+
+void Run(const std::filesystem::path& directory, bool polling) {
+    std::error_code ec;
+    std::filesystem::remove_all(directory, ec);
+    std::filesystem::path include = directory / "common" / "Lighting.hlsli";
+    std::filesystem::path lit = directory / "Lit.VS.hlsl";
+    std::filesystem::path unlit = directory / "Unlit.PS.hlsl";
+    WriteText(include, "float3 Lighting() { return 1; }\n");
+    WriteText(lit, "#include \"common/Lighting.hlsli\"\nfloat4 main() : SV_POSITION { return float4(Lighting(), 1); }\n");
+    WriteText(unlit, "float4 main() : SV_TARGET { return 1; }\n");
+
+    ShaderBuildGraph graph;
+    graph.Scan(directory);
+    // 名前順なので Lit が 0、Unlit が 1
+    Check(graph.GetEntryPoints().size() == 2, "graph: two entry points");
+    if (graph.GetEntryPoints().size() != 2) {
+        return;
+    }
+    ShaderWatcher watcher;
+    watcher.Initialize(&graph, kDebounce, polling);
+    const char* mode = watcher.IsPolling() ? "polling" : "notify";
+    Check(watcher.IsPolling() == polling, std::string(mode) + ": requested watch mode");
+    Check(PollFor(watcher, Clock::now(), kDebounce * 2).events.empty(), std::string(mode) + ": nothing before any change");
+
+    // write: 保存を何度か繰り返す
+    for (int i = 0; i < 5; ++i) {
+        WriteText(include, "float3 Lighting() { return " + std::to_string(i) + "; }\n");
+        std::this_thread::sleep_for(kBurstInterval);
+    }
+    CheckBurst(watcher, mode, "write", Clock::now(), 0);
+
+    // rename: 一時ファイルに書いて置き換える
+    std::filesystem::path temporary = directory / "Unlit.PS.hlsl.tmp";
+    for (int i = 0; i < 3; ++i) {
+        WriteText(temporary, "float4 main() : SV_TARGET { return " + std::to_string(i) + "; }\n");
+        std::filesystem::rename(temporary, unlit, ec);
+        std::this_thread::sleep_for(kBurstInterval);
+    }
+    CheckBurst(watcher, mode, "rename", Clock::now(), 1);
+
+    // touch: 更新日時だけを変える
+    std::filesystem::file_time_type writeTime = std::filesystem::last_write_time(lit, ec);
+    for (int i = 1; i <= 3; ++i) {
+        std::filesystem::last_write_time(lit, writeTime + std::chrono::seconds(i), ec);
+        std::this_thread::sleep_for(kBurstInterval);
+    }
+    CheckBurst(watcher, mode, "touch", Clock::now(), 0);
+
+    watcher.Finalize();
+    std::filesystem::remove_all(directory, ec);
+}
+
+} // namespace
+
+int main() {
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "ShaderWatcherCheck";
+    Run(directory, false);
+    Run(directory, true);
+    std::printf("%s\n", g_passed ? "passed" : "FAILED");
+    return g_passed ? 0 : 1;
+}
@@ -0,0 +1,187 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "BitmapFont.h"
+#include "SpriteBatch.h"
+
+// スプライトのバッチ処理の計測
+// 1フレーム分のスプライトを追加し、並べ替えと頂点の生成を行うまでの時間を、何フレームか繰り返して出す
+//   random: テクスチャとレイヤーがばらばらの順に追加する (並べ替えが要る)
+//   sorted: レイヤー・テクスチャの順に追加する (並べ替えを飛ばす)
+// 頂点の位置は std::sin / std::cos で求めたものと比べ、結果が正しいかだけで成否を決める
+// (時間は出すだけ。共有のマシンでは揺れるので、時間で失敗にはしない)
+// あわせて、文字列のラベル (スプライト数の1/20個) を毎フレーム作る場合と、作っておいたものを出す場合を比べる
+// GPUは使わない (頂点はただの配列に書く)
+// 使い方: SpriteBench.exe [スプライト数] [テクスチャ数] [レイヤー数] [フレーム数]
+//         (省略時は 100000 16 4 100)
+//
+// DXCやWindowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -Iengine/Math -Iengine/Sprite -o SpriteBench tools/SpriteBench/main.cpp engine/Sprite/SpriteBatch.cpp
+//       engine/Sprite/BitmapFont.cpp
+
+namespace {
+
+double ToMilliseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+uint32_t ReadArgument(int argc, char* argv[], int index, uint32_t defaultValue) {
+    if (index < argc) {
+        return static_cast<uint32_t>(std::strtoul(argv[index], nullptr, 10));
+    }
+    return defaultValue;
+}
+
+bool g_passed = true;
+
+void Check(bool condition, const char* name) {
+    std::printf("check: %s: %s\n", name, condition ? "yes" : "NO");
+    g_passed = g_passed && condition;
+}
+
+struct BatchResult {
+    double addMilliseconds = 0.0;
+    double buildMilliseconds = 0.0;
+    uint32_t writtenCount = 0;
+    size_t drawCount = 0;
+};
+
+// 毎フレーム全てのスプライトを追加して頂点を書く
+BatchResult MeasureBatch(SpriteBatch& batch, const std::vector<Sprite>& sprites, uint32_t frameCount, std::vector<SpriteVertex>& vertices) {
+    std::vector<SpriteDrawBatch> drawBatches;
+    BatchResult result;
+    uint32_t spriteCount = static_cast<uint32_t>(sprites.size());
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+        auto start = std::chrono::steady_clock::now();
+        batch.Clear();
+        for (const Sprite& sprite : sprites) {
+            batch.Add(sprite);
+        }
+        auto added = std::chrono::steady_clock::now();
+        result.writtenCount = batch.Build(vertices.data(), spriteCount, drawBatches);
+        auto built = std::chrono::steady_clock::now();
+        result.addMilliseconds += ToMilliseconds(added - start);
+        result.buildMilliseconds += ToMilliseconds(built - added);
+    }
+    result.addMilliseconds /= frameCount;
+    result.buildMilliseconds /= frameCount;
+    result.drawCount = drawBatches.size();
+    return result;
+}
+
+// 追加した順に並んでいるスプライトの頂点と、std::sin / std::cos で求めた四隅との差の最大 (ピクセル)
+double MaxPositionError(const std::vector<Sprite>& sprites, const std::vector<SpriteVertex>& vertices) {
+    double maxError = 0.0;
+    for (size_t i = 0; i < sprites.size(); ++i) {
+        const Sprite& sprite = sprites[i];
+        double c = std::cos(double(sprite.rotation));
+        double s = std::sin(double(sprite.rotation));
+        for (uint32_t corner = 0; corner < 4; ++corner) {
+            double localX = (double(corner & 1) - sprite.anchor.x) * sprite.size.x;
+            double localY = (double(corner >> 1) - sprite.anchor.y) * sprite.size.y;
+            double x = sprite.position.x + c * localX - s * localY;
+            double y = sprite.position.y + s * localX + c * localY;
+            const Vector3& position = vertices[i * 4 + corner].position;
+            maxError = std::max({ maxError, std::abs(position.x - x), std::abs(position.y - y) });
+        }
+    }
+    return maxError;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t spriteCount = ReadArgument(argc, argv, 1, 100000);
+    uint32_t textureCount = ReadArgument(argc, argv, 2, 16);
+    uint32_t layerCount = ReadArgument(argc, argv, 3, 4);
+    uint32_t frameCount = ReadArgument(argc, argv, 4, 100);
+    if (spriteCount == 0 || textureCount == 0 || layerCount == 0 || frameCount == 0) {
+        std::printf("usage: SpriteBench [sprites] [textures] [layers] [frames]\n");
+        return 1;
+    }
+
+    // テクスチャとレイヤーがばらばらの順に追加される、並べ替えの効果が最も出る場合
+    std::mt19937 random(12345);
+    std::uniform_real_distribution<float> position(0.0f, 1280.0f);
+    std::uniform_real_distribution<float> size(8.0f, 64.0f);
+    std::uniform_real_distribution<float> angle(-6.2831853f, 6.2831853f);
+    std::vector<Sprite> sprites(spriteCount);
+    for (Sprite& sprite : sprites) {
+        sprite.position = { position(random), position(random) * 0.5625f };
+        sprite.size = { size(random), size(random) };
+        sprite.anchor = { 0.5f, 0.5f };
+        sprite.rotation = angle(random);
+        sprite.color = { 1.0f, 0.5f, 0.25f, 1.0f };
+        sprite.texture = random() % textureCount;
+        sprite.layer = static_cast<uint16_t>(random() % layerCount);
+    }
+    // 同じスプライトを、描く順に並べておいたもの
+    std::vector<Sprite> sortedSprites = sprites;
+    std::stable_sort(sortedSprites.begin(), sortedSprites.end(),
+        [](const Sprite& a, const Sprite& b) { return a.layer != b.layer ? a.layer < b.layer : a.texture < b.texture; });
+
+    SpriteBatch batch;
+    std::vector<SpriteVertex> vertices(size_t(spriteCount) * 4);
+    std::printf("sprites: %u, textures: %u, layers: %u, frames: %u\n", spriteCount, textureCount, layerCount, frameCount);
+    BatchResult results[2];
+    const char* names[2] = { "random", "sorted" };
+    for (int i = 0; i < 2; ++i) {
+        results[i] = MeasureBatch(batch, i == 0 ? sprites : sortedSprites, frameCount, vertices);
+        std::printf("%s: add %8.3fms/frame, build %8.3fms/frame (sort + vertices), %.1fns per sprite, %zu draws\n", names[i],
+            results[i].addMilliseconds, results[i].buildMilliseconds,
+            (results[i].addMilliseconds + results[i].buildMilliseconds) * 1.0e6 / spriteCount, results[i].drawCount);
+    }
+    std::printf("vertex bytes: %zu per frame\n", size_t(spriteCount) * 4 * sizeof(SpriteVertex));
+    // 最後に計測したのは sorted なので、頂点は sortedSprites と同じ順に並んでいる
+    double positionError = MaxPositionError(sortedSprites, vertices);
+    std::printf("max position error: %.6fpx\n", positionError);
+    Check(results[0].writtenCount == spriteCount && results[1].writtenCount == spriteCount, "all sprites written");
+    Check(results[0].drawCount == results[1].drawCount, "same draws for both orders");
+    Check(positionError < 0.01, "positions match std::sin / std::cos within 0.01px");
+
+    // ワールド座標のデバッグ表示のような、短い文字列をたくさん出す場合
+    uint32_t labelCount = std::max(1u, spriteCount / 20);
+    std::vector<std::string> labels(labelCount);
+    std::vector<Vector2> labelPositions(labelCount);
+    for (uint32_t i = 0; i < labelCount; ++i) {
+        labels[i] = "entity " + std::to_string(i) + " hp:" + std::to_string(random() % 100);
+        labelPositions[i] = { position(random), position(random) * 0.5625f };
+    }
+    BitmapFont font;
+    font.Initialize();
+    std::vector<TextMesh> meshes;
+    std::vector<SpriteDrawBatch> drawBatches;
+    for (const std::string& label : labels) {
+        meshes.push_back(font.BuildTextMesh(label, 1.0f));
+    }
+    uint32_t glyphCount = 0;
+    double labelMilliseconds[2] = {};
+    for (int prebuilt = 0; prebuilt < 2; ++prebuilt) {
+        for (uint32_t frame = 0; frame < frameCount; ++frame) {
+            auto start = std::chrono::steady_clock::now();
+            batch.Clear();
+            for (uint32_t i = 0; i < labelCount; ++i) {
+                if (prebuilt) {
+                    batch.AddQuads(meshes[i].vertices.data(), meshes[i].quadCount, 0, 0xFFFF, labelPositions[i], { 1.0f, 1.0f, 1.0f, 1.0f });
+                } else {
+                    uint32_t firstQuad = static_cast<uint32_t>(batch.GetQuadPool().size() / 4);
+                    uint32_t quadCount = font.BuildText(labels[i], 1.0f, batch.GetQuadPool());
+                    batch.AddPooledQuads(firstQuad, quadCount, 0, 0xFFFF, labelPositions[i], { 1.0f, 1.0f, 1.0f, 1.0f });
+                }
+            }
+            glyphCount = batch.Build(vertices.data(), spriteCount, drawBatches);
+            labelMilliseconds[prebuilt] += ToMilliseconds(std::chrono::steady_clock::now() - start);
+        }
+    }
+    std::printf("labels: %u (%u glyphs, %zu draws)\n", labelCount, glyphCount, drawBatches.size());
+    std::printf("  built every frame: %8.3fms/frame\n", labelMilliseconds[0] / frameCount);
+    std::printf("  prebuilt:          %8.3fms/frame\n", labelMilliseconds[1] / frameCount);
+    std::printf("%s\n", g_passed ? "passed" : "FAILED");
+    return g_passed ? 0 : 1;
+}
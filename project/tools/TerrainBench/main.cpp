@@ -0,0 +1,194 @@
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+#include "Heightmap.h"
+#include "MathUtil.h"
+#include "TerrainQuadTree.h"
+
+// 地形のLODの計測と確認
+// ハイトマップを作り、四分木を作る時間・カメラを動かしながらチャンクを選ぶ時間・チャンクの頂点を作る時間を出す
+// あわせて、選んだチャンクの隣り合う辺で頂点の高さが食い違っていない (ひびがない) ことを確かめる
+// GPUは使わない
+// 使い方: TerrainBench.exe [ハイトマップの一辺] [フレーム数] [チャンクの一辺の四角形数] (省略時は 8193 200 32)
+//
+// DXCやWindowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -Iengine/Math -Iengine/Terrain -o TerrainBench tools/TerrainBench/main.cpp engine/Terrain/Heightmap.cpp
+//       engine/Terrain/TerrainQuadTree.cpp engine/Math/MathUtil.cpp
+
+namespace {
+
+double ToMilliseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+uint32_t ReadArgument(int argc, char* argv[], int index, uint32_t defaultValue) {
+    if (index < argc) {
+        return static_cast<uint32_t>(std::strtoul(argv[index], nullptr, 10));
+    }
+    return defaultValue;
+}
+
+// 選んだチャンクの辺の頂点が、隣のチャンクの辺の上にあるかを調べ、食い違いの最大を返す
+float MeasureCracks(const TerrainQuadTree& quadTree, const Heightmap& heightmap, const std::vector<TerrainChunk>& chunks) {
+    const TerrainDesc& desc = quadTree.GetDesc();
+    uint32_t resolution = desc.chunkResolution;
+    uint32_t stride = resolution + 1;
+    uint32_t countX = (heightmap.GetWidth() - 2) / resolution + 1;
+    uint32_t countZ = (heightmap.GetHeight() - 2) / resolution + 1;
+
+    // 最も細かい格子ごとの、それを覆うチャンク
+    std::vector<int32_t> owners(size_t(countX) * countZ, -1);
+    std::vector<std::vector<TerrainVertex>> meshes(chunks.size());
+    for (size_t index = 0; index < chunks.size(); ++index) {
+        const TerrainChunk& chunk = chunks[index];
+        meshes[index].resize(quadTree.GetVertexCountPerChunk());
+        quadTree.BuildChunkMesh(chunk, meshes[index].data());
+        uint32_t span = 1u << chunk.level;
+        for (uint32_t z = chunk.z * span; z < (chunk.z + 1) * span && z < countZ; ++z) {
+            for (uint32_t x = chunk.x * span; x < (chunk.x + 1) * span && x < countX; ++x) {
+                owners[size_t(z) * countX + x] = int32_t(index);
+            }
+        }
+    }
+
+    // 辺の頂点 (along の位置) の高さを、隣の辺の頂点を結んだ折れ線で求める
+    auto heightOnEdge = [&](const std::vector<TerrainVertex>& mesh, bool vertical, uint32_t fixed, float along) {
+        float previousAlong = 0.0f;
+        float previousHeight = 0.0f;
+        for (uint32_t k = 0; k <= resolution; ++k) {
+            const TerrainVertex& vertex = vertical ? mesh[size_t(k) * stride + fixed] : mesh[size_t(fixed) * stride + k];
+            float position = vertical ? vertex.position.z : vertex.position.x;
+            if (k > 0 && along <= position + 1e-4f) {
+                float fraction = position > previousAlong ? (along - previousAlong) / (position - previousAlong) : 0.0f;
+                return previousHeight + (vertex.position.y - previousHeight) * fraction;
+            }
+            previousAlong = position;
+            previousHeight = vertex.position.y;
+        }
+        return previousHeight;
+    };
+
+    float maxError = 0.0f;
+    for (size_t index = 0; index < chunks.size(); ++index) {
+        const TerrainChunk& chunk = chunks[index];
+        int32_t span = 1 << chunk.level;
+        // -x, +x, -z, +z の辺の頂点を、辺の向こうのチャンクの反対側の辺と比べる
+        for (int side = 0; side < 4; ++side) {
+            bool vertical = side < 2;
+            bool positive = side % 2 == 1;
+            uint32_t fixed = positive ? resolution : 0;
+            uint32_t neighborFixed = positive ? 0 : resolution;
+            int32_t across = positive ? (int32_t(vertical ? chunk.x : chunk.z) + 1) * span : int32_t(vertical ? chunk.x : chunk.z) * span - 1;
+            if (across < 0 || uint32_t(across) >= (vertical ? countX : countZ)) {
+                continue;
+            }
+            for (uint32_t k = 0; k <= resolution; ++k) {
+                const TerrainVertex& vertex =
+                    vertical ? meshes[index][size_t(k) * stride + fixed] : meshes[index][size_t(fixed) * stride + k];
+                float along = vertical ? vertex.position.z : vertex.position.x;
+                // 頂点が格子の境目にあるときは両側の格子を見る
+                uint32_t alongCell = static_cast<uint32_t>(along / desc.spacing) / resolution;
+                uint32_t alongCount = vertical ? countZ : countX;
+                for (uint32_t cell = alongCell > 0 ? alongCell - 1 : 0; cell <= alongCell && cell < alongCount; ++cell) {
+                    uint32_t x = vertical ? uint32_t(across) : cell;
+                    uint32_t z = vertical ? cell : uint32_t(across);
+                    int32_t owner = owners[size_t(z) * countX + x];
+                    if (owner < 0) {
+                        continue;
+                    }
+                    // 隣の辺の上にない頂点 (角で斜めに接しているだけのとき) は比べない
+                    const std::vector<TerrainVertex>& neighborMesh = meshes[owner];
+                    const TerrainVertex& first = vertical ? neighborMesh[neighborFixed] : neighborMesh[size_t(neighborFixed) * stride];
+                    const TerrainVertex& last = vertical ? neighborMesh[size_t(resolution) * stride + neighborFixed]
+                                                         : neighborMesh[size_t(neighborFixed) * stride + resolution];
+                    float begin = vertical ? first.position.z : first.position.x;
+                    float end = vertical ? last.position.z : last.position.x;
+                    float line = vertical ? first.position.x : first.position.z;
+                    float own = vertical ? vertex.position.x : vertex.position.z;
+                    if (along < begin - 1e-4f || along > end + 1e-4f || std::fabs(line - own) > 1e-4f) {
+                        continue;
+                    }
+                    float error = std::fabs(heightOnEdge(neighborMesh, vertical, neighborFixed, along) - vertex.position.y);
+                    maxError = error > maxError ? error : maxError;
+                }
+            }
+        }
+    }
+    return maxError;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t size = ReadArgument(argc, argv, 1, 8193);
+    uint32_t frameCount = ReadArgument(argc, argv, 2, 200);
+    uint32_t resolution = ReadArgument(argc, argv, 3, 32);
+    if (size < 2 || frameCount == 0 || resolution < 2 || resolution > 128 || (resolution & (resolution - 1)) != 0) {
+        std::printf("usage: TerrainBench [heightmap size] [frames] [chunk resolution (power of 2, <= 128)]\n");
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    Heightmap heightmap;
+    heightmap.GenerateFractal(size, size, 12345);
+    auto generated = std::chrono::steady_clock::now();
+
+    TerrainDesc desc;
+    desc.spacing = 1.0f;
+    desc.heightScale = 256.0f;
+    desc.chunkResolution = resolution;
+    TerrainQuadTree quadTree;
+    quadTree.Initialize(&heightmap, desc);
+    auto initialized = std::chrono::steady_clock::now();
+
+    std::printf("heightmap: %ux%u (%zu MB), chunk: %ux%u, levels: %u\n", size, size,
+        size_t(size) * size * sizeof(uint16_t) / (1024 * 1024), resolution, resolution, quadTree.GetLevelCount());
+    std::printf("generate:   %8.1fms\n", ToMilliseconds(generated - start));
+    std::printf("quadtree:   %8.1fms (min/max heights)\n", ToMilliseconds(initialized - generated));
+
+    // 地形の上を斜めに横切りながら、低く飛んで周りを見回す
+    Matrix4x4 projection = MakePerspectiveFovMatrix(0.9f, 16.0f / 9.0f, 0.1f, 20000.0f);
+    float extent = float(size - 1) * desc.spacing;
+    std::vector<TerrainChunk> chunks;
+    std::vector<TerrainVertex> vertices(quadTree.GetVertexCountPerChunk());
+    double selectMilliseconds = 0.0;
+    double buildMilliseconds = 0.0;
+    size_t totalChunks = 0;
+    size_t maxChunks = 0;
+    float maxError = 0.0f;
+    for (uint32_t frame = 0; frame < frameCount; ++frame) {
+        float t = float(frame) / float(frameCount);
+        Vector3 rotate = { 0.35f, t * 12.0f, 0.0f };
+        Vector3 position = { extent * (0.1f + 0.8f * t), desc.heightScale * 1.2f, extent * (0.2f + 0.6f * t) };
+        Matrix4x4 view = Inverse(MakeAffineMatrix({ 1.0f, 1.0f, 1.0f }, rotate, position));
+        Matrix4x4 viewProjection = Multiply(view, projection);
+
+        auto selectStart = std::chrono::steady_clock::now();
+        quadTree.Select(position, viewProjection, chunks);
+        auto selected = std::chrono::steady_clock::now();
+        for (const TerrainChunk& chunk : chunks) {
+            quadTree.BuildChunkMesh(chunk, vertices.data());
+        }
+        auto built = std::chrono::steady_clock::now();
+        selectMilliseconds += ToMilliseconds(selected - selectStart);
+        buildMilliseconds += ToMilliseconds(built - selected);
+        totalChunks += chunks.size();
+        maxChunks = chunks.size() > maxChunks ? chunks.size() : maxChunks;
+
+        // ひびの確認は重いので何フレームかおきに
+        if (frame % 20 == 0) {
+            float error = MeasureCracks(quadTree, heightmap, chunks);
+            maxError = error > maxError ? error : maxError;
+        }
+    }
+    double averageChunks = double(totalChunks) / frameCount;
+    std::printf("select:     %8.3fms/frame (%.0f chunks/frame, max %zu, %.0f triangles/frame)\n", selectMilliseconds / frameCount,
+        averageChunks, maxChunks, averageChunks * resolution * resolution * 2);
+    std::printf("build all:  %8.3fms/frame (%.2fus/chunk, %zu bytes/chunk)\n", buildMilliseconds / frameCount,
+        buildMilliseconds * 1000.0 / double(totalChunks), vertices.size() * sizeof(TerrainVertex));
+    std::printf("crack:      %8.5f (max height difference on shared edges)\n", maxError);
+    return maxError < 1e-3f ? 0 : 1;
+}
@@ -0,0 +1,133 @@
+#include <cstdio>
+#include <filesystem>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <Windows.h>
+#include <objbase.h>
+#include "JobSystem.h"
+#include "TextureCooker.h"
+
+// テクスチャクッカー
+// 使い方: TextureCooker.exe [ファイルまたはディレクトリ ...] (省略時は Resources)
+// プロジェクトのディレクトリ (Resources がある場所) で実行する
+
+namespace {
+
+// クック対象の拡張子か
+bool IsCookTarget(const std::filesystem::path& path) {
+    std::string extension = path.extension().string();
+    for (char& c : extension) {
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    return extension == ".png" || extension == ".jpg" || extension == ".jpeg" || extension == ".bmp";
+}
+
+// 対象ファイルを集める (クック済みディレクトリは除く)
+void CollectSources(const std::filesystem::path& path, std::vector<std::filesystem::path>& sources) {
+    const std::filesystem::path cookedDirectory(kCookedTextureDirectory);
+    if (std::filesystem::is_regular_file(path)) {
+        sources.push_back(path);
+        return;
+    }
+    for (const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+        if (!entry.is_regular_file() || !IsCookTarget(entry.path())) {
+            continue;
+        }
+        std::string relative = entry.path().lexically_normal().generic_string();
+        if (relative.rfind(cookedDirectory.generic_string(), 0) == 0) {
+            continue;
+        }
+        sources.push_back(entry.path().lexically_normal());
+    }
+}
+
+// 形式名
+const char* GetFormatName(DXGI_FORMAT format) {
+    switch (format) {
+    case DXGI_FORMAT_BC1_UNORM_SRGB: return "BC1_SRGB";
+    case DXGI_FORMAT_BC5_UNORM: return "BC5";
+    case DXGI_FORMAT_BC7_UNORM_SRGB: return "BC7_SRGB";
+    case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB: return "RGBA8_SRGB";
+    case DXGI_FORMAT_R8G8B8A8_UNORM: return "RGBA8";
+    default: return "other";
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    HRESULT hr = CoInitializeEx(nullptr, COINIT_MULTITHREADED);
+    if (FAILED(hr)) {
+        return 1;
+    }
+    // ミップ生成を並列にする
+    JobSystem::GetInstance()->Initialize();
+
+    std::vector<std::filesystem::path> sources;
+    if (argc <= 1) {
+        CollectSources("Resources", sources);
+    }
+    for (int i = 1; i < argc; ++i) {
+        CollectSources(argv[i], sources);
+    }
+
+    // 実行時に元ファイルを読まずにクック済みDDSを選べるよう、目録を更新する (消えた元ファイルの行とそのDDSは除く)
+    TextureManifest manifest = LoadTextureManifest();
+    for (auto it = manifest.begin(); it != manifest.end();) {
+        std::error_code ec;
+        if (std::filesystem::exists(it->first, ec)) {
+            ++it;
+            continue;
+        }
+        std::filesystem::remove(GetCookedTexturePath(it->first, it->second.contentHash), ec);
+        it = manifest.erase(it);
+    }
+
+    std::printf("%-40s %-10s %10s %10s %7s %10s %10s %10s %10s %10s\n",
+        "texture", "format", "VRAM(raw)", "VRAM(dds)", "saved", "decode", "mip", "mip(dxtex)", "load(dds)", "cook");
+
+    int failedCount = 0;
+    uint64_t totalUncompressed = 0;
+    uint64_t totalCooked = 0;
+    double totalSourceLoad = 0.0;
+    double totalMip = 0.0;
+    double totalDirectXTexMip = 0.0;
+    double totalCookedLoad = 0.0;
+    for (const std::filesystem::path& source : sources) {
+        TextureCookResult result;
+        auto previous = manifest.find(source.lexically_normal().generic_string());
+        hr = CookTexture(source, previous != manifest.end() ? &previous->second : nullptr, result);
+        if (FAILED(hr)) {
+            std::printf("%-40s FAILED (hr=0x%08lx)\n", source.generic_string().c_str(), static_cast<unsigned long>(hr));
+            ++failedCount;
+            continue;
+        }
+        manifest[source.lexically_normal().generic_string()] = result.manifestEntry;
+        double saved = result.uncompressedBytes > 0 ? 100.0 * (1.0 - double(result.cookedBytes) / double(result.uncompressedBytes)) : 0.0;
+        std::printf("%-40s %-10s %9lluK %9lluK %6.1f%% %8.2fms %8.2fms %8.2fms %8.2fms %10s\n",
+            source.generic_string().c_str(), GetFormatName(result.format),
+            static_cast<unsigned long long>(result.uncompressedBytes / 1024), static_cast<unsigned long long>(result.cookedBytes / 1024),
+            saved, result.decodeMilliseconds, result.mipMilliseconds, result.directXTexMipMilliseconds, result.cookedLoadMilliseconds,
+            result.upToDate ? "cached" : (std::to_string(static_cast<int>(result.cookMilliseconds)) + "ms").c_str());
+        totalUncompressed += result.uncompressedBytes;
+        totalCooked += result.cookedBytes;
+        totalSourceLoad += result.decodeMilliseconds + result.mipMilliseconds;
+        totalMip += result.mipMilliseconds;
+        totalDirectXTexMip += result.directXTexMipMilliseconds;
+        totalCookedLoad += result.cookedLoadMilliseconds;
+    }
+
+    if (!SaveTextureManifest(manifest)) {
+        std::printf("failed to write %s/%s\n", kCookedTextureDirectory, kCookedTextureManifestName);
+        ++failedCount;
+    }
+
+    std::printf("total: VRAM %lluK -> %lluK, load %.2fms -> %.2fms, mip %.2fms (DirectXTex %.2fms), %d failed\n",
+        static_cast<unsigned long long>(totalUncompressed / 1024), static_cast<unsigned long long>(totalCooked / 1024),
+        totalSourceLoad, totalCookedLoad, totalMip, totalDirectXTexMip, failedCount);
+
+    JobSystem::GetInstance()->Finalize();
+    CoUninitialize();
+    return failedCount == 0 ? 0 : 1;
+}
@@ -0,0 +1,243 @@
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+#include "TextureManager.h"
+#include "TextureResidency.h"
+
+// TextureManager の確認と計測
+// GPU の代わりに、Load から決まった回数 Update すると常駐したことにする偽物の TextureResidency を使う
+//   dedup:    書き方の違う同じパスが1つのテクスチャになり、読み込みには最初に渡したパスがそのまま使われる
+//   refcount: コピー・ムーブ・代入・自己代入で参照の数が合い、参照されている間は予算を超えても解放されない
+//   lru:      参照が無くなった順 (古いもの) から、予算に収まるまでだけ解放される。読み込み中のものは解放しない
+//   alias:    覚えておく書き方の数は限られ、解放したテクスチャの分は消える
+//   lookup:   覚えている書き方・覚えていない書き方での Load と、ハンドルのコピーの1回あたりの時間
+// 使い方: TextureManagerCheck.exe [計測の回数] (省略時は 1000000)
+//
+// DXCやWindowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -Iengine/Texture -o TextureManagerCheck tools/TextureManagerCheck/main.cpp engine/Texture/TextureManager.cpp
+
+namespace {
+
+// 偽物の TextureResidency (テクスチャの大きさはパスの長さ MB にする)
+class FakeResidency : public TextureResidency {
+public:
+    struct Texture {
+        std::string path;
+        uint32_t updatesUntilResident = 0;
+        bool alive = false;
+    };
+
+    Handle Load(const std::string& filePath) override {
+        loadedPaths.push_back(filePath);
+        Handle handle = static_cast<Handle>(textures.size());
+        textures.push_back({ filePath, loadLatency, true });
+        return handle;
+    }
+    void Unload(Handle handle) override {
+        Texture& texture = textures[handle];
+        if (!texture.alive || texture.updatesUntilResident != 0) {
+            ++invalidUnloadCount;
+        }
+        texture.alive = false;
+        unloadedPaths.push_back(texture.path);
+    }
+    void Update() override {
+        for (Texture& texture : textures) {
+            if (texture.updatesUntilResident > 0) {
+                --texture.updatesUntilResident;
+            }
+        }
+    }
+    bool IsResident(Handle handle) const override { return textures[handle].alive && textures[handle].updatesUntilResident == 0; }
+    uint64_t GetSizeInBytes(Handle handle) const override { return uint64_t(textures[handle].path.size()) << 20; }
+    uint32_t GetSrvIndex(Handle handle) const override { return handle; }
+#if defined(_WIN32)
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGPUHandle(Handle handle) const override { return { handle }; }
+#endif
+
+    uint32_t loadLatency = 0;
+    std::vector<Texture> textures;
+    std::vector<std::string> loadedPaths;
+    std::vector<std::string> unloadedPaths;
+    uint32_t invalidUnloadCount = 0;
+};
+
+bool g_passed = true;
+
+void Check(bool condition, const char* name) {
+    std::printf("check: %s: %s\n", name, condition ? "yes" : "NO");
+    g_passed = g_passed && condition;
+}
+
+double NanosecondsPerCall(std::chrono::steady_clock::time_point start, uint32_t count) {
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / count;
+}
+
+void CheckDedup() {
+    FakeResidency residency;
+    TextureManager* manager = TextureManager::GetInstance();
+    manager->Initialize(&residency);
+    {
+        TextureHandle a = manager->Load("Resources/Textures/Grass.PNG");
+        TextureHandle b = manager->Load("./resources\\textures/../textures/grass.png");
+        TextureHandle c = manager->Load("Resources/Textures/Stone.png");
+        Check(a == b && !(a == c), "dedup: differently written paths share one texture");
+        Check(residency.loadedPaths.size() == 2 && residency.loadedPaths[0] == "Resources/Textures/Grass.PNG",
+            "dedup: the first path is loaded as written (case kept)");
+    }
+    manager->Finalize();
+}
+
+void CheckRefCount() {
+    FakeResidency residency;
+    TextureManager* manager = TextureManager::GetInstance();
+    // 1枚でも予算を超える
+    manager->Initialize(&residency, 1);
+    {
+        TextureHandle a = manager->Load("Resources/refcount_texture.png");
+        TextureHandle copy = a;
+        TextureHandle assigned;
+        assigned = copy;
+        assigned = assigned;
+        TextureHandle moved = std::move(copy);
+        TextureHandle moveAssigned;
+        moveAssigned = std::move(moved);
+        Check(!copy.IsValid() && !moved.IsValid(), "refcount: moved-from handles are empty");
+        manager->Update();
+        Check(manager->GetCachedCount() == 0 && residency.unloadedPaths.empty(), "refcount: referenced texture over budget is kept");
+        a = TextureHandle();
+        assigned = TextureHandle();
+        manager->Update();
+        Check(residency.unloadedPaths.empty(), "refcount: kept while the last handle lives");
+        moveAssigned = TextureHandle();
+        manager->Update();
+        Check(residency.unloadedPaths.size() == 1 && manager->GetUsedMemory() == 0, "refcount: released after the last handle");
+        // 解放した後にもう一度読むと読み込み直す
+        TextureHandle again = manager->Load("Resources/refcount_texture.png");
+        Check(residency.loadedPaths.size() == 2, "refcount: evicted texture is loaded again");
+    }
+    Check(residency.invalidUnloadCount == 0, "refcount: no unload of a missing or loading texture");
+    manager->Finalize();
+}
+
+void CheckLruOrder() {
+    FakeResidency residency;
+    residency.loadLatency = 2;
+    TextureManager* manager = TextureManager::GetInstance();
+    const char* paths[] = { "Resources/lru_a.png", "Resources/lru_b.png", "Resources/lru_c.png", "Resources/lru_d.png", "Resources/lru_e.png" };
+    // 1枚 19MB。3枚分までの予算
+    manager->Initialize(&residency, 3 * (uint64_t(19) << 20));
+    {
+        std::vector<TextureHandle> handles;
+        for (const char* path : paths) {
+            handles.push_back(manager->Load(path));
+        }
+        // 読み込み中は大きさが分からないので解放しない
+        handles.clear();
+        manager->Update();
+        Check(residency.unloadedPaths.empty(), "lru: loading textures are not evicted");
+        manager->Update();
+        manager->Update();
+        // 参照が無くなった順は a, b, c, d, e。予算に収まるまで a, b だけを解放する
+        Check(residency.unloadedPaths.size() == 2 && residency.unloadedPaths[0] == paths[0] && residency.unloadedPaths[1] == paths[1],
+            "lru: oldest released textures are evicted first, only down to the budget");
+
+        // c を使い直すと一番新しくなる。f を足すと d が先に解放される
+        TextureHandle c = manager->Load(paths[2]);
+        c = TextureHandle();
+        TextureHandle f = manager->Load("Resources/lru_f.png");
+        manager->Update();
+        manager->Update();
+        manager->Update();
+        Check(residency.unloadedPaths.size() == 3 && residency.unloadedPaths[2] == paths[3], "lru: reused texture moves to the back");
+        Check(manager->GetUsedMemory() <= manager->GetMemoryBudget(), "lru: used memory within budget");
+    }
+    Check(residency.invalidUnloadCount == 0, "lru: no unload of a missing or loading texture");
+    manager->Finalize();
+}
+
+void CheckAliases() {
+    FakeResidency residency;
+    TextureManager* manager = TextureManager::GetInstance();
+    manager->Initialize(&residency, 0);
+    {
+        TextureHandle handle = manager->Load("Resources/alias.png");
+        std::string path = "Resources/alias.png";
+        for (int i = 0; i < 100; ++i) {
+            path = "./" + path;
+            TextureHandle other = manager->Load(path);
+        }
+        Check(residency.loadedPaths.size() == 1, "alias: one texture for all spellings");
+        Check(manager->GetAliasCount() <= 4, "alias: remembered spellings are bounded");
+    }
+    manager->Update();
+    Check(manager->GetAliasCount() == 0, "alias: spellings are dropped with the evicted texture");
+    manager->Finalize();
+}
+
+void MeasureLookup(uint32_t count) {
+    FakeResidency residency;
+    TextureManager* manager = TextureManager::GetInstance();
+    manager->Initialize(&residency);
+    std::vector<TextureHandle> handles;
+    std::vector<std::string> paths;
+    for (uint32_t i = 0; i < 256; ++i) {
+        paths.push_back("Resources/textures/texture" + std::to_string(i) + ".png");
+        handles.push_back(manager->Load(paths.back()));
+    }
+    manager->Update();
+
+    auto start = std::chrono::steady_clock::now();
+    uint32_t sink = 0;
+    for (uint32_t i = 0; i < count; ++i) {
+        TextureHandle handle = manager->Load(paths[i & 255]);
+        sink += handle.GetSrvIndex();
+    }
+    double cached = NanosecondsPerCall(start, count);
+
+    // 覚えていない書き方 (覚えられる数を別の書き方で使い切っておくので、毎回正規化する)
+    std::vector<std::string> spellings;
+    for (const std::string& path : paths) {
+        spellings.push_back("./" + path);
+    }
+    for (const std::string& spelling : spellings) {
+        manager->Load("./" + spelling);
+        manager->Load("././" + spelling);
+        manager->Load("./././" + spelling);
+        manager->Load("././././" + spelling);
+    }
+    uint32_t normalizeCount = count / 10;
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < normalizeCount; ++i) {
+        TextureHandle handle = manager->Load(spellings[i & 255]);
+        sink += handle.GetSrvIndex();
+    }
+    double normalized = NanosecondsPerCall(start, normalizeCount);
+
+    start = std::chrono::steady_clock::now();
+    for (uint32_t i = 0; i < count; ++i) {
+        TextureHandle copy = handles[i & 255];
+        sink += copy.GetSrvIndex();
+    }
+    double copy = NanosecondsPerCall(start, count);
+
+    std::printf("lookup: cached path %.1fns, normalized path %.1fns, handle copy %.1fns per call (sink %u)\n", cached, normalized, copy, sink & 1);
+    handles.clear();
+    manager->Finalize();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t count = argc > 1 ? static_cast<uint32_t>(std::strtoul(argv[1], nullptr, 10)) : 1000000;
+    CheckDedup();
+    CheckRefCount();
+    CheckLruOrder();
+    CheckAliases();
+    MeasureLookup(count > 0 ? count : 1);
+    std::printf("%s\n", g_passed ? "passed" : "FAILED");
+    return g_passed ? 0 : 1;
+}
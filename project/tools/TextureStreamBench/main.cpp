@@ -0,0 +1,209 @@
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "MipGenerator.h"
+#include "TextureDecoder.h"
+
+// テクスチャストリーマーのワーカーで行う処理 (デコードとミップ生成) の計測
+// TextureStreamer と同じく、ワーカースレッドが要求のキューから1枚ずつ取り、DecodeTexture (実行時と同じ関数) でデコードとミップ生成を行う
+// ワーカーの数を 1, 2, 4, ... と変え、1秒あたりの枚数と元画像の MB、1枚あたりの読み込み・デコード・ミップ生成の時間を出す
+// 実行時の PNG は WIC で読むが Windows 以外には無いので、ここでは一時ディレクトリに書いた無圧縮の TGA (BGRA) を読む
+// (デコードの時間はファイルの読み込みと並べ替えだけになる。PNG の展開の分は含まない)
+// 壊れたファイルと無いファイルは失敗として返り、空の画像にならないことも確かめる
+// 使い方: TextureStreamBench.exe [枚数] [最大のワーカー数] (省略時は 64 8)
+//
+// DXCやWindowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -pthread -Iengine/Texture -Iengine/Job -o TextureStreamBench tools/TextureStreamBench/main.cpp
+//       engine/Texture/TextureDecoder.cpp engine/Texture/MipGenerator.cpp engine/Job/JobSystem.cpp
+
+namespace {
+
+using Clock = std::chrono::steady_clock;
+
+double ToMilliseconds(Clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+uint32_t ReadArgument(int argc, char* argv[], int index, uint32_t defaultValue) {
+    if (index < argc) {
+        return static_cast<uint32_t>(std::strtoul(argv[index], nullptr, 10));
+    }
+    return defaultValue;
+}
+
+// 無圧縮の 32bit TGA を書く (左上が原点)
+bool WriteTga(const std::filesystem::path& path, uint32_t width, uint32_t height, uint32_t seed) {
+    std::vector<uint8_t> data(18 + size_t(width) * height * 4);
+    data[2] = 2; // 無圧縮のトゥルーカラー
+    data[12] = uint8_t(width & 0xFF);
+    data[13] = uint8_t(width >> 8);
+    data[14] = uint8_t(height & 0xFF);
+    data[15] = uint8_t(height >> 8);
+    data[16] = 32;
+    data[17] = 0x28; // アルファ8bit・上から下
+    uint32_t random = seed * 2654435761u + 1;
+    uint8_t* pixels = data.data() + 18;
+    for (uint32_t y = 0; y < height; ++y) {
+        for (uint32_t x = 0; x < width; ++x) {
+            random = random * 1664525u + 1013904223u;
+            uint8_t* p = pixels + (size_t(y) * width + x) * 4;
+            p[0] = uint8_t(x * 255 / width);
+            p[1] = uint8_t(y * 255 / height);
+            p[2] = uint8_t(random >> 24);
+            p[3] = 255;
+        }
+    }
+    std::ofstream file(path, std::ios::binary);
+    file.write(reinterpret_cast<const char*>(data.data()), std::streamsize(data.size()));
+    return bool(file);
+}
+
+// 1回分の結果
+struct RunResult {
+    double wallMilliseconds = 0.0;
+    double decodeMilliseconds = 0.0; // 1枚あたり
+    double mipMilliseconds = 0.0;    // 1枚あたり
+    uint32_t failedCount = 0;
+};
+
+// workerCount 個のワーカーで全てのファイルを処理する (TextureStreamer::WorkerMain と同じ形)
+RunResult Run(const std::vector<std::filesystem::path>& files, uint32_t workerCount) {
+    std::mutex mutex;
+    std::deque<size_t> requests;
+    for (size_t i = 0; i < files.size(); ++i) {
+        requests.push_back(i);
+    }
+    Clock::duration decodeTotal{};
+    Clock::duration mipTotal{};
+    uint32_t failedCount = 0;
+
+    auto start = Clock::now();
+    std::vector<std::thread> workers;
+    for (uint32_t i = 0; i < workerCount; ++i) {
+        workers.emplace_back([&] {
+            Clock::duration decode{};
+            Clock::duration mip{};
+            uint32_t failed = 0;
+            while (true) {
+                size_t index = 0;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    if (requests.empty()) {
+                        break;
+                    }
+                    index = requests.front();
+                    requests.pop_front();
+                }
+                DecodedTexture texture;
+                TextureDecodeTimings timings;
+                bool decoded = DecodeTexture(files[index].string(), nullptr, texture, nullptr, &timings);
+                decode += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(timings.decodeMilliseconds));
+                mip += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double, std::milli>(timings.mipMilliseconds));
+                if (!decoded || texture.mipLevels.back().pixels.size() != 4) {
+                    ++failed;
+                }
+            }
+            std::lock_guard<std::mutex> lock(mutex);
+            decodeTotal += decode;
+            mipTotal += mip;
+            failedCount += failed;
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    RunResult result;
+    result.wallMilliseconds = ToMilliseconds(Clock::now() - start);
+    result.decodeMilliseconds = ToMilliseconds(decodeTotal) / double(files.size());
+    result.mipMilliseconds = ToMilliseconds(mipTotal) / double(files.size());
+    result.failedCount = failedCount;
+    return result;
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t textureCount = ReadArgument(argc, argv, 1, 64);
+    uint32_t maxWorkers = ReadArgument(argc, argv, 2, 8);
+    if (textureCount == 0 || maxWorkers == 0) {
+        std::printf("usage: TextureStreamBench [textures] [max workers]\n");
+        return 1;
+    }
+    uint32_t hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    // 1024, 512, 256 の正方形を順に混ぜる
+    std::filesystem::path directory = std::filesystem::temp_directory_path() / "TextureStreamBench";
+    std::error_code ec;
+    std::filesystem::create_directories(directory, ec);
+    std::vector<std::filesystem::path> files;
+    uint64_t sourceBytes = 0;
+    for (uint32_t i = 0; i < textureCount; ++i) {
+        uint32_t size = 1024u >> (i % 3);
+        std::filesystem::path path = directory / ("texture" + std::to_string(i) + ".tga");
+        if (!WriteTga(path, size, size, i)) {
+            std::printf("failed to write %s\n", path.string().c_str());
+            return 1;
+        }
+        files.push_back(path);
+        sourceBytes += uint64_t(size) * size * 4;
+    }
+    std::printf("%u textures, %.1fMB of pixels, hardware threads: %u\n", textureCount, sourceBytes / (1024.0 * 1024.0), hardwareThreads);
+
+    // ファイルをキャッシュに載せる
+    Run(files, 1);
+
+    bool passed = true;
+    double baseline = 0.0;
+    for (uint32_t workers = 1; workers <= maxWorkers; workers *= 2) {
+        RunResult result = Run(files, workers);
+        if (workers == 1) {
+            baseline = result.wallMilliseconds;
+        }
+        double seconds = result.wallMilliseconds / 1000.0;
+        std::printf("%2u workers: %8.1fms, %7.1f textures/s, %7.1fMB/s, decode %.2fms + mip %.2fms per texture, x%.2f%s\n",
+            workers, result.wallMilliseconds, textureCount / seconds, sourceBytes / (1024.0 * 1024.0) / seconds,
+            result.decodeMilliseconds, result.mipMilliseconds, baseline / result.wallMilliseconds,
+            workers > hardwareThreads ? " (more workers than hardware threads)" : "");
+        if (result.failedCount != 0) {
+            std::printf("check: %u textures failed\n", result.failedCount);
+            passed = false;
+        }
+    }
+
+    // 壊れたファイル (途中で切れた TGA)・無いファイル・デコーダーの無い形式は失敗して、理由が返り、画像は空のまま
+    std::filesystem::path truncated = directory / "truncated.tga";
+    std::filesystem::copy_file(files[0], truncated, std::filesystem::copy_options::overwrite_existing, ec);
+    std::filesystem::resize_file(truncated, 1024, ec);
+    files.push_back(truncated);
+    std::filesystem::path undecodable = directory / "undecodable.png";
+    std::filesystem::copy_file(files[0], undecodable, std::filesystem::copy_options::overwrite_existing, ec);
+    files.push_back(undecodable);
+    const std::filesystem::path brokenFiles[] = { truncated, directory / "missing.tga", undecodable };
+    for (const std::filesystem::path& path : brokenFiles) {
+        DecodedTexture texture;
+        std::string error;
+        bool decoded = DecodeTexture(path.string(), nullptr, texture, &error);
+        bool rejected = !decoded && texture.mipLevels.empty() && !error.empty();
+        std::printf("check: %s is rejected: %s (%s)\n", path.filename().string().c_str(), rejected ? "yes" : "NO", error.c_str());
+        passed = passed && rejected;
+    }
+
+    for (const std::filesystem::path& path : files) {
+        std::filesystem::remove(path, ec);
+    }
+    std::filesystem::remove(directory, ec);
+
+    std::printf("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}
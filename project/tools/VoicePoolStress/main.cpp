@@ -0,0 +1,217 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+#include "AudioOutput.h"
+#include "SoundClip.h"
+#include "VoicePool.h"
+#include "WaveFile.h"
+
+// ボイスプールの負荷試験
+// NullAudioOutput のスレッド (実時間) で鳴らしながら、ゲームのスレッドから1秒に何千回も効果音を鳴らす
+// 優先度と距離はばらばらにして、声を奪う・鳴らさないの判断と、キューの受け渡しを同時に動かす
+// 鳴らした数・奪った数・鳴らさなかった数・キューから溢れた数、Play から反映までのレイテンシ、1ブロックを作る時間を出す
+// 範囲内の音を鳴らさなかった数が上限 (1/4) 以下で、優先度の高い音 (kHighPriority 以上) は全て鳴り、
+// 最初に鳴らした kMaxPriority の長い音 (BGMの代わり) が最後まで奪われないことを確かめる
+// 最後に全ての音が鳴り終わるまで待ち、使われたままの声が残らないことを確かめる
+// Update を呼ばずに終わった声のキューを溢れさせても、使われたままの声が残らないことも確かめる
+// 使い方: VoicePoolStress.exe [1秒に鳴らす数] [秒数] [声の数] [Resourcesのディレクトリ] (省略時は 5000 5 64 Resources)
+//
+// Windowsに依存しない
+// Linuxでのビルド例:
+//   g++ -std=c++20 -O2 -pthread -Iengine/Audio -o VoicePoolStress tools/VoicePoolStress/main.cpp engine/Audio/WaveFile.cpp
+//       engine/Audio/SoundClip.cpp engine/Audio/AudioStream.cpp engine/Audio/AudioMixer.cpp engine/Audio/AudioOutput.cpp
+//       engine/Audio/VoicePool.cpp
+
+namespace {
+
+const uint32_t kBlockFrames = 480;
+// これ以上の優先度の音は鳴らさないことがあってはいけない
+const uint8_t kHighPriority = 192;
+// 範囲内の音を鳴らさなかった数の上限 (鳴らそうとした数に対する割合)
+const double kMaxRejectRatio = 0.25;
+
+double ToMilliseconds(std::chrono::steady_clock::duration duration) {
+    return std::chrono::duration<double, std::milli>(duration).count();
+}
+
+} // namespace
+
+int main(int argc, char* argv[]) {
+    uint32_t triggersPerSecond = argc > 1 ? uint32_t(std::atoi(argv[1])) : 5000;
+    uint32_t seconds = argc > 2 ? uint32_t(std::atoi(argv[2])) : 5;
+    uint32_t voiceCount = argc > 3 ? uint32_t(std::atoi(argv[3])) : 64;
+    std::string resources = argc > 4 ? argv[4] : "Resources";
+
+    // 効果音は展開して共有する (ファイルは展開したら閉じてよい)
+    const char* names[] = { "mokugyo.wav", "fanfare.wav" };
+    SoundClip clips[2];
+    for (uint32_t i = 0; i < 2; ++i) {
+        WaveFile wave;
+        std::string error;
+        if (!wave.Open(resources + "/" + names[i], &error)) {
+            std::printf("failed to open %s: %s\n", names[i], error.c_str());
+            return 1;
+        }
+        clips[i].Load(wave);
+        std::printf("clip:       %s, %llu frames, %u Hz, %.1f KB\n", names[i], static_cast<unsigned long long>(clips[i].GetFrameCount()),
+            clips[i].GetSampleRate(), double(clips[i].GetMemorySize()) / 1024.0);
+    }
+    clips[0].maxInstances = voiceCount / 4;
+
+    VoicePool pool;
+    VoicePool::Settings settings;
+    settings.maxVoices = voiceCount;
+    pool.Initialize(settings);
+
+    // 出力のスレッドで1ブロックを作る時間を測る
+    std::atomic<uint64_t> renderNanoseconds = 0;
+    std::atomic<uint64_t> maxRenderNanoseconds = 0;
+    std::atomic<uint64_t> renderCount = 0;
+    NullAudioOutput output;
+    output.Start(settings.sampleRate, kBlockFrames, [&](float* samples, uint32_t frameCount) {
+        auto start = std::chrono::steady_clock::now();
+        pool.Render(samples, frameCount);
+        uint64_t elapsed = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+        renderNanoseconds.fetch_add(elapsed, std::memory_order_relaxed);
+        renderCount.fetch_add(1, std::memory_order_relaxed);
+        if (elapsed > maxRenderNanoseconds.load(std::memory_order_relaxed)) {
+            maxRenderNanoseconds.store(elapsed, std::memory_order_relaxed);
+        }
+    });
+
+    // BGMの代わりに長い音を最も高い優先度で鳴らしておく (試験の間ずっと奪われないはず)
+    AudioPlayParams bgmParams;
+    bgmParams.priority = VoicePool::kMaxPriority;
+    bgmParams.volume = 0.1f;
+    VoicePool::VoiceId bgm = pool.Play(&clips[1], bgmParams);
+    double bgmSeconds = double(clips[1].GetFrameCount()) / double(clips[1].GetSampleRate());
+    bool bgmKept = true;
+
+    // ゲームのスレッド: 1msごとに Update し、その間に鳴らすべき数を鳴らす
+    std::mt19937 random(12345);
+    std::uniform_int_distribution<uint32_t> priorityDistribution(0, 255);
+    std::uniform_real_distribution<float> distanceDistribution(0.0f, settings.maxDistance * 1.2f);
+    std::uniform_real_distribution<float> unitDistribution(0.0f, 1.0f);
+    std::vector<VoicePool::VoiceId> recentVoices;
+    uint64_t triggerCount = 0;
+    uint64_t invalidCount = 0;
+    uint64_t audibleCount = 0;
+    uint64_t highPriorityRejectCount = 0;
+    auto start = std::chrono::steady_clock::now();
+    auto tick = start;
+    while (true) {
+        double elapsed = ToMilliseconds(std::chrono::steady_clock::now() - start) / 1000.0;
+        if (elapsed >= double(seconds)) {
+            break;
+        }
+        pool.Update();
+        // 鳴り終わるより少し前までは鳴っているはず
+        if (elapsed < bgmSeconds - 0.5) {
+            bgmKept = bgmKept && pool.IsPlaying(bgm);
+        }
+        uint64_t target = uint64_t(elapsed * triggersPerSecond);
+        for (; triggerCount < target; ++triggerCount) {
+            AudioPlayParams params;
+            params.volume = 0.5f + 0.5f * unitDistribution(random);
+            params.pan = unitDistribution(random) * 2.0f - 1.0f;
+            params.pitch = 0.75f + 0.5f * unitDistribution(random);
+            params.priority = uint8_t(priorityDistribution(random));
+            params.distance = distanceDistribution(random);
+            // ほとんどは短い効果音。たまに長い音を鳴らす
+            VoicePool::VoiceId voice = pool.Play(&clips[triggerCount % 16 == 0 ? 1 : 0], params);
+            bool audible = params.distance <= settings.maxDistance;
+            audibleCount += audible ? 1 : 0;
+            if (voice == AudioMixer::kInvalidVoiceId) {
+                ++invalidCount;
+                highPriorityRejectCount += audible && params.priority >= kHighPriority ? 1 : 0;
+                continue;
+            }
+            recentVoices.push_back(voice);
+        }
+        // 鳴らした声の一部を途中で止めたり、音量を変えたりする (終わった声や奪われた声への操作も混ぜる)
+        for (size_t i = 0; i < recentVoices.size(); ++i) {
+            float action = unitDistribution(random);
+            if (action < 0.05f) {
+                pool.Stop(recentVoices[i]);
+            } else if (action < 0.1f) {
+                pool.SetVolume(recentVoices[i], unitDistribution(random));
+            }
+        }
+        recentVoices.clear();
+        tick += std::chrono::milliseconds(1);
+        std::this_thread::sleep_until(tick);
+    }
+    double firedSeconds = ToMilliseconds(std::chrono::steady_clock::now() - start) / 1000.0;
+
+    // 全て鳴り終わるまで待つ (最も長い音の長さと、余裕を少し)
+    double longest = double(clips[1].GetFrameCount()) / double(clips[1].GetSampleRate()) / 0.75;
+    auto drainEnd = std::chrono::steady_clock::now() + std::chrono::milliseconds(int64_t(longest * 1000.0) + 500);
+    while (pool.GetActiveVoiceCount() > 0 && std::chrono::steady_clock::now() < drainEnd) {
+        pool.Update();
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    output.Stop();
+    pool.Update();
+
+    const VoicePool::Stats& stats = pool.GetStats();
+    std::printf("triggers:   %llu in %.2fs (%.0f/s), %u voices\n", static_cast<unsigned long long>(triggerCount), firedSeconds,
+        double(triggerCount) / firedSeconds, voiceCount);
+    std::printf("voices:     played %llu, stolen %llu, rejected %llu (%.1f%% of %llu in range, %llu with priority >= %u), "
+        "culled %llu, dropped commands %llu\n",
+        static_cast<unsigned long long>(stats.playCount), static_cast<unsigned long long>(stats.stealCount),
+        static_cast<unsigned long long>(stats.rejectCount), 100.0 * double(stats.rejectCount) / double(std::max<uint64_t>(audibleCount, 1)),
+        static_cast<unsigned long long>(audibleCount), static_cast<unsigned long long>(highPriorityRejectCount), kHighPriority,
+        static_cast<unsigned long long>(stats.culledCount), static_cast<unsigned long long>(stats.droppedCount));
+    std::printf("bgm:        %s\n", bgmKept ? "kept" : "STOLEN");
+    std::printf("latency:    %llu plays, p50 %.0fus, p99 %.0fus, max %.0fus (block %.1fms)\n",
+        static_cast<unsigned long long>(pool.GetLatencyCount()), pool.GetLatencyPercentile(0.5), pool.GetLatencyPercentile(0.99),
+        pool.GetMaxLatency(), 1000.0 * kBlockFrames / settings.sampleRate);
+    uint64_t blocks = renderCount.load();
+    std::printf("render:     %llu blocks, avg %.3fms, max %.3fms, peak %.3f\n", static_cast<unsigned long long>(blocks),
+        blocks > 0 ? double(renderNanoseconds.load()) / double(blocks) / 1e6 : 0.0, double(maxRenderNanoseconds.load()) / 1e6,
+        output.GetPeak());
+    std::printf("drain:      %u voices left active\n", pool.GetActiveVoiceCount());
+
+    // Update を呼ばずに鳴らし続け、終わった声のキューを溢れさせても、後の Update で全て回収できる
+    // (出力は止めてあるので、Render はここから直接呼ぶ)
+    VoicePool smallPool;
+    VoicePool::Settings smallSettings;
+    smallSettings.maxVoices = 2;
+    smallSettings.commandCapacity = 4;
+    smallPool.Initialize(smallSettings);
+    std::vector<float> block(size_t(kBlockFrames) * 2);
+    uint64_t clipBlocks = clips[0].GetFrameCount() / kBlockFrames + 2;
+    for (uint32_t round = 0; round < 8; ++round) {
+        for (uint32_t i = 0; i < smallSettings.maxVoices; ++i) {
+            smallPool.Play(&clips[0]);
+        }
+        for (uint64_t i = 0; i < clipBlocks; ++i) {
+            smallPool.Render(block.data(), kBlockFrames);
+        }
+    }
+    for (uint32_t i = 0; i < 4; ++i) {
+        smallPool.Update();
+        smallPool.Render(block.data(), kBlockFrames);
+    }
+    uint32_t overflowLeft = smallPool.GetActiveVoiceCount();
+    smallPool.Finalize();
+    std::printf("overflow:   %u voices left active\n", overflowLeft);
+
+    // 鳴らしたものは全て出力のスレッドに届き、鳴らさなかったものと合わせて鳴らそうとした数になる
+    bool passed = pool.GetActiveVoiceCount() == 0 && overflowLeft == 0;
+    passed = passed && stats.playCount == pool.GetLatencyCount();
+    passed = passed && stats.playCount + invalidCount == triggerCount + 1;
+    passed = passed && stats.stealCount > 0 && blocks > 0;
+    // 声が足りないときは弱い声から奪い、優先度の高い音と最も高い優先度の音は鳴らし続ける
+    passed = passed && double(stats.rejectCount) <= kMaxRejectRatio * double(audibleCount);
+    passed = passed && highPriorityRejectCount == 0 && bgmKept;
+    pool.Finalize();
+    std::printf("%s\n", passed ? "passed" : "FAILED");
+    return passed ? 0 : 1;
+}